@@ -147,6 +147,15 @@ typedef struct
 
 typedef uint8_t iowa_status_t;
 
+typedef struct
+{
+    uint32_t capacity;        // number of items in the pools
+    uint32_t inUseCount;      // number of items of the pools currently in use
+    uint32_t poolAllocCount;  // allocations served by the pools
+    uint32_t heapAllocCount;  // allocations served by iowa_system_malloc() because a pool was exhausted
+    uint32_t heapFreeCount;   // objects released with iowa_system_free()
+} iowa_memory_pool_stats_t;
+
 #define IOWA_COAP_NO_ERROR                        0x00
 #define IOWA_COAP_201_CREATED                     0x41
 #define IOWA_COAP_202_DELETED                     0x42
@@ -306,6 +315,25 @@ iowa_status_t iowa_step(iowa_context_t contextP,
 // - contextP: returned by iowa_init().
 void iowa_stop(iowa_context_t contextP);
 
+// Retrieve the allocation counters of the memory pools.
+// Only available when IOWA_MEMORY_POOL_SUPPORT is defined.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - statsP: OUT. the counters.
+iowa_status_t iowa_memory_pool_get_stats(iowa_context_t contextP,
+                                         iowa_memory_pool_stats_t *statsP);
+
+// Set the size of the buffer receiving the UDP datagrams of an IOWA context.
+// Larger datagrams are truncated. The default size is IOWA_BUFFER_SIZE.
+// Only available when IOWA_UDP_SUPPORT is defined.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - size: the maximum size of a received datagram in bytes.
+iowa_status_t iowa_receive_buffer_set_size(iowa_context_t contextP,
+                                           size_t size);
+
 // Perform all stack pending operations before the device pause for some time.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
@@ -70,6 +70,14 @@ extern "C" {
 #define IOWA_COAP_SETTING_MAX_RETRANSMIT  2    // uint8_t
 #define IOWA_COAP_SETTING_URI_LENGTH      3    // size_t
 #define IOWA_COAP_SETTING_URI             4    // char *
+#define IOWA_COAP_SETTING_ACK_TIMEOUT_MS  5    // uint32_t, only with IOWA_TIME_MS_SUPPORT
+#define IOWA_COAP_SETTING_RTO_MS          6    // uint32_t, read-only, only with IOWA_TIME_MS_SUPPORT
+#define IOWA_COAP_SETTING_SRTT_MS         7    // uint32_t, read-only, only with IOWA_TIME_MS_SUPPORT
+#define IOWA_COAP_SETTING_RTTVAR_MS       8    // uint32_t, read-only, only with IOWA_TIME_MS_SUPPORT
+#define IOWA_COAP_SETTING_ACK_CACHE_COUNT 9    // uint16_t, maximum number of cached replies, at most 32768
+#define IOWA_COAP_SETTING_ACK_CACHE_MEMORY 10  // size_t, read-only, bytes used by the reply cache
+#define IOWA_COAP_SETTING_PING_INTERVAL   11   // uint32_t, seconds of inactivity before a TCP peer is pinged, 0 to disable
+#define IOWA_COAP_SETTING_FRAME_SIZE      12   // uint8_t, largest application payload of a LoRaWAN peer at the current data rate, from 11 to 242
 
 /**************************************************************
  * Types
@@ -57,6 +57,12 @@ void iowa_system_free(void * pointer);
 // Else, the origin(Epoch, system boot, etc...) does not matter as this function is used only to determine the elapsed time since the last call to it.
 int32_t iowa_system_gettime(void);
 
+#ifdef IOWA_TIME_MS_SUPPORT
+// This function returns the number of milliseconds elapsed since an arbitrary origin or a negative value in case of error.
+// The returned value must be monotonic. This function is used by IOWA instead of iowa_system_gettime() to schedule its internal operations.
+int64_t iowa_system_gettime_ms(void);
+#endif
+
 // This function starts a reboot of the system.
 void iowa_system_reboot(void *userData);
 
@@ -120,6 +126,28 @@ int iowa_system_connection_send(void * connP,
                                 size_t length,
                                 void * userData);
 
+// A buffer used by iowa_system_connection_sendv() and iowa_system_connection_recvv().
+typedef struct
+{
+    uint8_t *data;
+    size_t   length;
+} iowa_connection_segment_t;
+
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+// This function sends the concatenation of several segments as a single datagram on a connection.
+// It can be mapped directly to sendmsg() or writev().
+// Used when IOWA_CONNECTION_SENDV_SUPPORT is defined.
+// Returned value: the number of bytes sent or a negative number in case of error.
+// Parameters:
+// - connP: the connection as returned by iowa_system_connection_open().
+// - segmentArray, segmentCount: the segments to send in order.
+// - userData: the iowa_init() parameter.
+int iowa_system_connection_sendv(void * connP,
+                                 iowa_connection_segment_t * segmentArray,
+                                 size_t segmentCount,
+                                 void * userData);
+#endif
+
 // This function reads data from a connection in a non-blocking way.
 // Returned value: the number of bytes read or a negative number in case of error.
 // Parameters:
@@ -132,6 +160,23 @@ int iowa_system_connection_recv(void * connP,
                                 size_t length,
                                 void * userData);
 
+#ifdef IOWA_CONNECTION_RECVV_SUPPORT
+// This function reads several datagrams from a connection in a non-blocking way.
+// It can be mapped directly to recvmmsg().
+// Used instead of iowa_system_connection_recv() for UDP connections when IOWA_CONNECTION_RECVV_SUPPORT is defined.
+// Returned value: the number of datagrams read or a negative number in case of error.
+// Parameters:
+// - connP: the connection as returned by iowa_system_connection_open().
+// - segmentArray: to store the datagrams, one per segment. On input, the length of a segment is the size of its buffer.
+//                 On output, it is the length of the datagram.
+// - segmentCount: the maximum number of datagrams to read.
+// - userData: the iowa_init() parameter.
+int iowa_system_connection_recvv(void * connP,
+                                 iowa_connection_segment_t * segmentArray,
+                                 size_t segmentCount,
+                                 void * userData);
+#endif
+
 // This function returns an unique identifier for the peer of a connection (e.g. IP address, LoRaWAN DevEUI, SMS MSISDN).
 // Returned value: the length of the identifier or 0 in case of error.
 // Parameters:
@@ -149,13 +194,46 @@ size_t iowa_system_connection_get_peer_identifier(void * connP,
 // Parameters:
 // - connArray: an array of connections as returned by iowa_system_connection_open().
 // - connCount: The size of the array
-// - timeout: the time to wait for data in seconds.
+// - timeout: the time to wait for data in seconds, or in milliseconds when IOWA_TIME_MS_SUPPORT is defined.
 // - userData: the iowa_init() parameter.
 int iowa_system_connection_select(void ** connArray,
                                   size_t connCount,
                                   int32_t timeout,
                                   void * userData);
 
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+// This function registers a connection to be monitored by iowa_system_connection_wait().
+// Used instead of iowa_system_connection_select() when IOWA_CONNECTION_WAIT_SUPPORT is defined.
+// Returned value: 0 in case of success or a negative number in case of error.
+// Parameters:
+// - connP: the connection as returned by iowa_system_connection_open().
+// - handle: an opaque handle to return in iowa_system_connection_wait() when data are available on the connection.
+// - userData: the iowa_init() parameter.
+int iowa_system_connection_register(void * connP,
+                                    void * handle,
+                                    void * userData);
+
+// This function stops the monitoring of a connection. It is called before iowa_system_connection_close().
+// Returned value: none.
+// Parameters:
+// - connP: the connection as returned by iowa_system_connection_open().
+// - userData: the iowa_init() parameter.
+void iowa_system_connection_unregister(void * connP,
+                                       void * userData);
+
+// This functions waits for incoming data on the registered connections during the specified time.
+// Returned value: the number of handles stored in handleArray, 0 if the time elapsed or a negative number in case of error.
+// Parameters:
+// - handleArray: to store the handles of the connections with available data.
+// - handleCount: the size of handleArray.
+// - timeout: the time to wait for data in seconds, or in milliseconds when IOWA_TIME_MS_SUPPORT is defined.
+// - userData: the iowa_init() parameter.
+int iowa_system_connection_wait(void ** handleArray,
+                                size_t handleCount,
+                                int32_t timeout,
+                                void * userData);
+#endif
+
 // This functions closes a connection.
 // Returned value: none.
 // Parameters:
@@ -171,7 +249,7 @@ void iowa_system_connection_close(void * connP,
 * To be implemented by the user if the define IOWA_THREAD_SUPPORT is used.
 */
 
-// This functions interrupts any on-going iowa_system_connection_select().
+// This functions interrupts any on-going iowa_system_connection_select() or iowa_system_connection_wait().
 // Returned value: none.
 // Parameters:
 // - userData: the iowa_init() parameter.
@@ -189,6 +267,33 @@ void iowa_system_mutex_lock(void * userData);
 // - userData: the iowa_init() parameter.
 void iowa_system_mutex_unlock(void * userData);
 
+// This function creates a mutex used by IOWA to protect one of its internal subsystems.
+// Returned value: the created mutex or NULL in case of error.
+// Parameters:
+// - userData: the iowa_init() parameter.
+void * iowa_system_mutex_create(void * userData);
+
+// This function deletes a mutex created by iowa_system_mutex_create().
+// Returned value: none.
+// Parameters:
+// - mutexP: the mutex as returned by iowa_system_mutex_create().
+// - userData: the iowa_init() parameter.
+void iowa_system_mutex_delete(void * mutexP, void * userData);
+
+// This function locks a mutex created by iowa_system_mutex_create().
+// Returned value: none.
+// Parameters:
+// - mutexP: the mutex as returned by iowa_system_mutex_create().
+// - userData: the iowa_init() parameter.
+void iowa_system_mutex_acquire(void * mutexP, void * userData);
+
+// This function releases a mutex created by iowa_system_mutex_create().
+// Returned value: none.
+// Parameters:
+// - mutexP: the mutex as returned by iowa_system_mutex_create().
+// - userData: the iowa_init() parameter.
+void iowa_system_mutex_release(void * mutexP, void * userData);
+
 /*************************************
 * Storage Queue Abstraction Interface
 *
@@ -312,6 +417,7 @@ size_t iowa_system_retrieve_context(uint8_t **bufferP,
 */
 
 // This function returns a random vector of the specified size.
+// It must also be implemented if IOWA_WEBSOCKET_SUPPORT is defined, to draw the WebSocket masking keys.
 // Returned value: 0 if the vector has been generated, else if an error occurred.
 // Parameters:
 // - randomBuffer: the generated buffer.
@@ -22,3 +22,1684 @@
 
 #include "iowa_prv_coap_internals.h"
 #include <stdbool.h>
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Get the SZX field matching a block size.
+// Returned value: the SZX or COAP_BLOCK_SZX_RESERVED if the size is not a valid block size.
+// Parameters:
+// - size: the block size.
+static uint8_t prv_sizeToSzx(uint16_t size)
+{
+    uint8_t szx;
+
+    for (szx = 0; szx < COAP_BLOCK_SZX_RESERVED; szx++)
+    {
+        if ((COAP_BLOCK_MIN_SIZE << szx) == size)
+        {
+            break;
+        }
+    }
+
+    return szx;
+}
+
+// Get the option carrying the block information of a message.
+// Returned value: the option or NULL if the message is not part of a block-wise transfer.
+// Parameters:
+// - messageP: the CoAP message.
+static iowa_coap_option_t *prv_findBlockOption(iowa_coap_message_t *messageP)
+{
+    iowa_coap_option_t *optionP;
+
+    // Requests carry their own blocks in Block1 and responses in Block2.
+    // Fall back on the other option for a request asking for a block of the response or a response acknowledging a block of the request.
+    if (COAP_IS_REQUEST(messageP->code))
+    {
+        optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_1);
+        if (optionP == NULL)
+        {
+            optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_2);
+        }
+    }
+    else
+    {
+        optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_2);
+        if (optionP == NULL)
+        {
+            optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_1);
+        }
+    }
+
+    return optionP;
+}
+
+#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+// Set the value of an integer option of a message, adding the option if needed.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - messageP: the CoAP message.
+// - number: the option number.
+// - value: the option value.
+static uint8_t prv_setIntegerOption(iowa_context_t contextP,
+                                    iowa_coap_message_t *messageP,
+                                    uint16_t number,
+                                    uint32_t value)
+{
+    iowa_coap_option_t *optionP;
+
+    optionP = iowa_coap_message_find_option(messageP, number);
+    if (optionP == NULL)
+    {
+        optionP = iowa_coap_option_new(contextP, number);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (optionP == NULL)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP option.");
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+        iowa_coap_message_add_option(messageP, optionP);
+    }
+
+    optionP->value.asInteger = value;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Get the maximum length of a message exchanged with a peer.
+// Returned value: the maximum length of a message.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the CoAP peer.
+static size_t prv_getMessageMaxSize(iowa_context_t contextP,
+                                    iowa_coap_peer_t *peerP)
+{
+#if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
+    if (peerP->base.type == IOWA_CONN_STREAM
+        || peerP->base.type == IOWA_CONN_WEBSOCKET)
+    {
+        uint32_t maxMessageSize;
+
+        // The message must fit in the receive buffers of both sides
+        maxMessageSize = ((coap_peer_stream_t *)peerP)->maxMessageSize;
+
+        return maxMessageSize < IOWA_COAP_STREAM_MAX_MESSAGE_SIZE ? maxMessageSize : IOWA_COAP_STREAM_MAX_MESSAGE_SIZE;
+    }
+#endif
+
+#ifdef IOWA_LORAWAN_SUPPORT
+    if (peerP->base.type == IOWA_CONN_LORAWAN)
+    {
+        // The compressed message must fit in a single LoRaWAN frame at the current data rate
+        return ((coap_peer_datagram_t *)peerP)->schcFrameSize;
+    }
+#endif
+
+#if !defined(IOWA_TCP_SUPPORT) && !defined(IOWA_WEBSOCKET_SUPPORT) && !defined(IOWA_LORAWAN_SUPPORT)
+    (void)peerP;
+#endif
+
+#ifdef IOWA_UDP_SUPPORT
+    return contextP->coapContextP->recvDatagramMaxSize;
+#elif defined(IOWA_BUFFER_SIZE)
+    (void)contextP;
+    return IOWA_BUFFER_SIZE;
+#else
+    // Only stream peers are supported
+    (void)contextP;
+    return IOWA_COAP_STREAM_MAX_MESSAGE_SIZE;
+#endif
+}
+
+// Check if BERT blocks can be exchanged with a peer.
+// Returned value: true if both sides indicated the Block-Wise-Transfer option in their CSM.
+// Parameters:
+// - peerP: the CoAP peer.
+static bool prv_isBertPeer(iowa_coap_peer_t *peerP)
+{
+#if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
+    if (peerP->base.type == IOWA_CONN_STREAM
+        || peerP->base.type == IOWA_CONN_WEBSOCKET)
+    {
+        return ((coap_peer_stream_t *)peerP)->bert;
+    }
+#else
+    (void)peerP;
+#endif
+
+    return false;
+}
+
+// Encode the information of a BERT block.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - number: the number of the first block of 1024 bytes.
+// - more: true if there are more blocks coming.
+// - valueP: OUT. the encoded block value.
+static uint8_t prv_encodeBertInfo(uint32_t number,
+                                  bool more,
+                                  uint32_t *valueP)
+{
+    if (number > 0x000FFFFF)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_COAP, "Invalid block number: %u.", number);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    *valueP = (number << 4) | (more ? 0x08 : 0x00) | COAP_BLOCK_SZX_BERT;
+
+    return IOWA_COAP_NO_ERROR;
+}
+#endif
+
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+static void prv_blockCallback(iowa_coap_peer_t *fromPeer, uint8_t code, iowa_coap_message_t *messageP, void *userData, iowa_context_t contextP);
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+static void prv_qBlockCallback(iowa_coap_peer_t *fromPeer, uint8_t code, iowa_coap_message_t *messageP, void *userData, iowa_context_t contextP);
+#endif
+
+// Send the block of a transfer starting at its current offset.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the CoAP peer.
+// - transferP: the block transfer.
+static uint8_t prv_blockSend(iowa_context_t contextP,
+                             iowa_coap_peer_t *peerP,
+                             block_transfer_t *transferP)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t result;
+    size_t size;
+    bool more;
+
+    if (transferP->szx == COAP_BLOCK_SZX_BERT)
+    {
+        size = transferP->bertSize;
+        more = transferP->offset + size < transferP->payloadLength;
+
+        result = prv_encodeBertInfo((uint32_t)(transferP->offset / COAP_BLOCK_MAX_SIZE), more, &transferP->blockOption.value.asInteger);
+    }
+    else
+    {
+        size = (size_t)COAP_BLOCK_MIN_SIZE << transferP->szx;
+        more = transferP->offset + size < transferP->payloadLength;
+
+        result = coapEncodeBlockInfo((uint32_t)(transferP->offset / size), more, (uint16_t)size, &transferP->blockOption.value.asInteger);
+    }
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Sending block of %u bytes at offset %u.", size, transferP->offset);
+
+    transferP->message.id = COAP_RESERVED_MID;
+    transferP->message.payload.data = transferP->payload + transferP->offset;
+    transferP->message.payload.length = more ? size : transferP->payloadLength - transferP->offset;
+
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    if (transferP->qBlock == true)
+    {
+        return peerSend(contextP, peerP, &transferP->message, prv_qBlockCallback, transferP);
+    }
+#endif
+
+    return peerSend(contextP, peerP, &transferP->message, prv_blockCallback, transferP);
+}
+
+// Called with the response to a block. Send the next block or forward the response to the upper layer.
+static void prv_blockCallback(iowa_coap_peer_t *fromPeer,
+                              uint8_t code,
+                              iowa_coap_message_t *messageP,
+                              void *userData,
+                              iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    block_transfer_t *transferP;
+    iowa_coap_option_t *optionP;
+    uint32_t number;
+    bool more;
+    uint16_t size;
+    bool bert;
+    size_t currentSize;
+    size_t unitSize;
+
+    transferP = (block_transfer_t *)userData;
+    if (transferP->szx == COAP_BLOCK_SZX_BERT)
+    {
+        // BERT blocks are numbered in blocks of 1024 bytes
+        currentSize = transferP->bertSize;
+        unitSize = COAP_BLOCK_MAX_SIZE;
+    }
+    else
+    {
+        currentSize = (size_t)COAP_BLOCK_MIN_SIZE << transferP->szx;
+        unitSize = currentSize;
+    }
+
+    optionP = NULL;
+    if (messageP != NULL)
+    {
+        optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_1);
+    }
+
+    if (optionP != NULL
+        && coapBlockDecodePeerInfo(fromPeer, optionP->value.asInteger, &number, &more, &size, &bert) == IOWA_COAP_NO_ERROR)
+    {
+        bool sendNext;
+
+        sendNext = false;
+        if (code == IOWA_COAP_231_CONTINUE
+            && number == transferP->offset / unitSize
+            && transferP->offset + currentSize < transferP->payloadLength)
+        {
+            // The offset stays aligned as the block size can only decrease
+            transferP->offset += currentSize;
+            sendNext = true;
+        }
+        else if (code == IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE
+                 && transferP->offset == 0
+                 && size < currentSize)
+        {
+            // Restart the transfer with the block size preferred by the peer
+            sendNext = true;
+        }
+
+        if (sendNext == true)
+        {
+            uint8_t result;
+
+            if (bert == false
+                && (size < unitSize
+                    || transferP->szx == COAP_BLOCK_SZX_BERT))
+            {
+                IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Peer asks for blocks of %u bytes.", size);
+                transferP->szx = prv_sizeToSzx(size);
+            }
+
+            result = coapPeerGenerateToken(fromPeer, &transferP->message.tokenLength, transferP->message.token);
+            if (result == IOWA_COAP_NO_ERROR)
+            {
+                result = prv_blockSend(contextP, fromPeer, transferP);
+            }
+            if (result == IOWA_COAP_NO_ERROR)
+            {
+                return;
+            }
+
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Failed to send the next block: %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+            code = result;
+            messageP = NULL;
+        }
+    }
+
+    if (transferP->resultCallback != NULL)
+    {
+        transferP->resultCallback(fromPeer, code, messageP, transferP->userData, contextP);
+    }
+    iowa_system_free(transferP);
+}
+
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+// Get the number of blocks of a transfer.
+// Returned value: the number of blocks.
+// Parameters:
+// - transferP: the block transfer.
+static uint32_t prv_qBlockCount(block_transfer_t *transferP)
+{
+    size_t size;
+
+    size = (size_t)COAP_BLOCK_MIN_SIZE << transferP->szx;
+
+    return (uint32_t)((transferP->payloadLength + size - 1) / size);
+}
+
+// Read an unsigned integer from a CBOR Sequence.
+// Returned value: true in case of success, false if the buffer does not start with an unsigned integer.
+// Parameters:
+// - bufferP: the CBOR Sequence.
+// - bufferLength: the length in bytes of bufferP.
+// - indexP: IN/OUT. the position of the integer in bufferP, updated to the position of the next item.
+// - valueP: OUT. the integer.
+static bool prv_cborReadUnsigned(const uint8_t *bufferP,
+                                 size_t bufferLength,
+                                 size_t *indexP,
+                                 uint32_t *valueP)
+{
+    uint8_t info;
+    size_t length;
+    size_t i;
+
+    if (*indexP >= bufferLength
+        || (bufferP[*indexP] >> 5) != 0)
+    {
+        return false;
+    }
+
+    info = bufferP[*indexP] & 0x1F;
+    *indexP += 1;
+
+    if (info < 24)
+    {
+        *valueP = info;
+        return true;
+    }
+
+    switch (info)
+    {
+    case 24:
+        length = 1;
+        break;
+    case 25:
+        length = 2;
+        break;
+    case 26:
+        length = 4;
+        break;
+    default:
+        // Block numbers are at most 20 bits long
+        return false;
+    }
+
+    if (*indexP + length > bufferLength)
+    {
+        return false;
+    }
+
+    *valueP = 0;
+    for (i = 0; i < length; i++)
+    {
+        *valueP = (*valueP << 8) | bufferP[*indexP + i];
+    }
+    *indexP += length;
+
+    return true;
+}
+
+// Write an unsigned integer in a CBOR Sequence.
+// Returned value: the length in bytes of the encoded integer.
+// Parameters:
+// - value: the integer.
+// - bufferP: OUT. the buffer to write the integer to. It must be at least 5 bytes long.
+static size_t prv_cborWriteUnsigned(uint32_t value,
+                                    uint8_t *bufferP)
+{
+    size_t length;
+    size_t i;
+
+    if (value < 24)
+    {
+        bufferP[0] = (uint8_t)value;
+        return 1;
+    }
+
+    if (value <= UINT8_MAX)
+    {
+        bufferP[0] = 24;
+        length = 1;
+    }
+    else if (value <= UINT16_MAX)
+    {
+        bufferP[0] = 25;
+        length = 2;
+    }
+    else
+    {
+        bufferP[0] = 26;
+        length = 4;
+    }
+
+    for (i = 0; i < length; i++)
+    {
+        bufferP[length - i] = (uint8_t)(value >> (8 * i));
+    }
+
+    return length + 1;
+}
+
+// Send a block of a Q-Block1 transfer in a non-confirmable message.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the CoAP peer.
+// - transferP: the block transfer.
+// - number: the number of the block.
+// - waitResponse: true to record an exchange for the response to this block.
+static uint8_t prv_qBlockSendNumber(iowa_context_t contextP,
+                                    iowa_coap_peer_t *peerP,
+                                    block_transfer_t *transferP,
+                                    uint32_t number,
+                                    bool waitResponse)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t result;
+    size_t size;
+    size_t offset;
+    bool more;
+
+    size = (size_t)COAP_BLOCK_MIN_SIZE << transferP->szx;
+    offset = (size_t)number * size;
+    more = offset + size < transferP->payloadLength;
+
+    result = coapEncodeBlockInfo(number, more, (uint16_t)size, &transferP->blockOption.value.asInteger);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    // Each block has its own token
+    result = coapPeerGenerateToken(peerP, &transferP->message.tokenLength, transferP->message.token);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Sending Q-Block %u of %u bytes at offset %u.", number, size, offset);
+
+    transferP->message.type = IOWA_COAP_TYPE_NON_CONFIRMABLE;
+    transferP->message.id = COAP_RESERVED_MID;
+    transferP->message.payload.data = transferP->payload + offset;
+    transferP->message.payload.length = more ? size : transferP->payloadLength - offset;
+
+    if (waitResponse == false)
+    {
+        return peerSend(contextP, peerP, &transferP->message, NULL, NULL);
+    }
+
+    result = peerSend(contextP, peerP, &transferP->message, prv_qBlockCallback, transferP);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        transferP->lastNumber = number;
+        transferP->lastTokenLength = transferP->message.tokenLength;
+        memcpy(transferP->lastToken, transferP->message.token, transferP->message.tokenLength);
+    }
+
+    return result;
+}
+
+static void prv_qBlockTimerCallback(iowa_context_t contextP,
+                                    void *userData)
+{
+    // WARNING: This function is called in a critical section
+    block_transfer_t *transferP;
+    size_t size;
+    size_t offset;
+    uint8_t result;
+
+    transferP = (block_transfer_t *)userData;
+    transferP->timerP = NULL;
+
+    if (transferP->retryCount >= COAP_QBLOCK_MAX_RETRANSMIT)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "No response from peer %p to the Q-Block1 transfer.", transferP->peerP);
+
+        peerCancelExchange(transferP->peerP, transferP->lastTokenLength, transferP->lastToken);
+        result = IOWA_COAP_504_GATEWAY_TIMEOUT;
+    }
+    else
+    {
+        transferP->retryCount++;
+
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Retransmitting Q-Block %u (attempt %u).", transferP->lastNumber, transferP->retryCount);
+
+        // The retransmission keeps the token of the pending exchange
+        size = (size_t)COAP_BLOCK_MIN_SIZE << transferP->szx;
+        offset = (size_t)transferP->lastNumber * size;
+
+        result = coapEncodeBlockInfo(transferP->lastNumber, offset + size < transferP->payloadLength, (uint16_t)size, &transferP->blockOption.value.asInteger);
+        if (result == IOWA_COAP_NO_ERROR)
+        {
+            transferP->message.tokenLength = transferP->lastTokenLength;
+            memcpy(transferP->message.token, transferP->lastToken, transferP->lastTokenLength);
+            transferP->message.id = COAP_RESERVED_MID;
+            transferP->message.payload.data = transferP->payload + offset;
+            transferP->message.payload.length = offset + size < transferP->payloadLength ? size : transferP->payloadLength - offset;
+
+            result = peerSend(contextP, transferP->peerP, &transferP->message, NULL, NULL);
+        }
+        if (result == IOWA_COAP_NO_ERROR)
+        {
+            transferP->timerP = coreTimerNew(contextP, COAP_QBLOCK_NON_TIMEOUT << transferP->retryCount, prv_qBlockTimerCallback, transferP);
+            if (transferP->timerP != NULL)
+            {
+                return;
+            }
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+
+        peerCancelExchange(transferP->peerP, transferP->lastTokenLength, transferP->lastToken);
+    }
+
+    if (transferP->resultCallback != NULL)
+    {
+        transferP->resultCallback(transferP->peerP, result, NULL, transferP->userData, contextP);
+    }
+    iowa_system_free(transferP);
+}
+
+// Arm the timer waiting for the response to the last block sent.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - transferP: the block transfer.
+static uint8_t prv_qBlockWait(iowa_context_t contextP,
+                              block_transfer_t *transferP)
+{
+    // WARNING: This function is called in a critical section
+    if (transferP->timerP == NULL)
+    {
+        transferP->timerP = coreTimerNew(contextP, COAP_QBLOCK_NON_TIMEOUT, prv_qBlockTimerCallback, transferP);
+        if (transferP->timerP == NULL)
+        {
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    return coreTimerReset(contextP, transferP->timerP, COAP_QBLOCK_NON_TIMEOUT);
+}
+
+// Send the next set of blocks of a Q-Block1 transfer. Only the last block of the set expects a response.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the CoAP peer.
+// - transferP: the block transfer.
+static uint8_t prv_qBlockSendSet(iowa_context_t contextP,
+                                 iowa_coap_peer_t *peerP,
+                                 block_transfer_t *transferP)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t result;
+    uint32_t count;
+    uint32_t lastNumber;
+
+    count = prv_qBlockCount(transferP);
+    lastNumber = transferP->nextNumber + IOWA_COAP_QBLOCK_MAX_PAYLOADS - 1;
+    if (lastNumber >= count)
+    {
+        lastNumber = count - 1;
+    }
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Sending Q-Blocks %u to %u of %u.", transferP->nextNumber, lastNumber, count);
+
+    result = IOWA_COAP_NO_ERROR;
+    while (result == IOWA_COAP_NO_ERROR
+           && transferP->nextNumber <= lastNumber)
+    {
+        result = prv_qBlockSendNumber(contextP, peerP, transferP, transferP->nextNumber, transferP->nextNumber == lastNumber);
+        transferP->nextNumber++;
+    }
+
+    transferP->missingCount = 0;
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = prv_qBlockWait(contextP, transferP);
+    }
+
+    return result;
+}
+
+// Send again the blocks listed as missing by the peer.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the CoAP peer.
+// - transferP: the block transfer.
+// - messageP: the 4.08 response carrying the CBOR Sequence of the missing block numbers.
+static uint8_t prv_qBlockSendMissing(iowa_context_t contextP,
+                                     iowa_coap_peer_t *peerP,
+                                     block_transfer_t *transferP,
+                                     iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t result;
+    size_t index;
+    uint32_t number;
+    uint32_t pendingNumber;
+    bool hasPending;
+
+    if (transferP->missingCount >= COAP_QBLOCK_MAX_RETRANSMIT)
+    {
+        return IOWA_COAP_408_REQUEST_ENTITY_INCOMPLETE;
+    }
+    transferP->missingCount++;
+
+    // The last listed block waits for the response
+    result = IOWA_COAP_NO_ERROR;
+    hasPending = false;
+    pendingNumber = 0;
+    index = 0;
+    while (result == IOWA_COAP_NO_ERROR
+           && prv_cborReadUnsigned(messageP->payload.data, messageP->payload.length, &index, &number) == true)
+    {
+        if (number >= transferP->nextNumber)
+        {
+            // Not sent yet
+            continue;
+        }
+
+        if (hasPending == true)
+        {
+            result = prv_qBlockSendNumber(contextP, peerP, transferP, pendingNumber, false);
+        }
+        pendingNumber = number;
+        hasPending = true;
+    }
+
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+    if (hasPending == false)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "The peer does not list any missing block.");
+        return IOWA_COAP_408_REQUEST_ENTITY_INCOMPLETE;
+    }
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Peer misses Q-Blocks, the last one being %u.", pendingNumber);
+
+    result = prv_qBlockSendNumber(contextP, peerP, transferP, pendingNumber, true);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = prv_qBlockWait(contextP, transferP);
+    }
+
+    return result;
+}
+
+// Fall back to Block1 after the peer rejected the Q-Block1 option.
+// Returned value: none.
+// Parameters:
+// - transferP: the block transfer.
+static void prv_qBlockDisable(block_transfer_t *transferP)
+{
+    iowa_coap_option_t *optionP;
+
+    transferP->qBlock = false;
+
+    // Remove the Q-Block1 and Request-Tag options and add the Block1 option at its place
+    while (transferP->message.optionList == &transferP->blockOption
+           || transferP->message.optionList == &transferP->tagOption)
+    {
+        transferP->message.optionList = transferP->message.optionList->next;
+    }
+    for (optionP = transferP->message.optionList; optionP != NULL; optionP = optionP->next)
+    {
+        while (optionP->next == &transferP->blockOption
+               || optionP->next == &transferP->tagOption)
+        {
+            optionP->next = optionP->next->next;
+        }
+    }
+
+    transferP->blockOption.number = IOWA_COAP_OPTION_BLOCK_1;
+    transferP->blockOption.next = NULL;
+    iowa_coap_message_add_option(&transferP->message, &transferP->blockOption);
+}
+
+// Called with the response to the last block of a Q-Block1 set. Send the next set, the missing blocks or forward the response to the upper layer.
+static void prv_qBlockCallback(iowa_coap_peer_t *fromPeer,
+                               uint8_t code,
+                               iowa_coap_message_t *messageP,
+                               void *userData,
+                               iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    block_transfer_t *transferP;
+    iowa_coap_option_t *optionP;
+    uint32_t number;
+    bool more;
+    uint16_t size;
+    uint8_t result;
+
+    transferP = (block_transfer_t *)userData;
+
+    if (transferP->timerP != NULL)
+    {
+        coreTimerDelete(contextP, transferP->timerP);
+        transferP->timerP = NULL;
+    }
+    transferP->retryCount = 0;
+
+    if (messageP != NULL)
+    {
+        result = IOWA_COAP_NO_ERROR;
+
+        if (transferP->nextNumber == 0)
+        {
+            // Response to the first block, sent in a confirmable message to detect the support of Q-Block1
+            switch (code)
+            {
+            case IOWA_COAP_402_BAD_OPTION:
+                IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Peer %p does not support Q-Block1. Falling back to Block1.", fromPeer);
+
+                fromPeer->base.qBlockUnsupported = true;
+                prv_qBlockDisable(transferP);
+                result = coapPeerGenerateToken(fromPeer, &transferP->message.tokenLength, transferP->message.token);
+                if (result == IOWA_COAP_NO_ERROR)
+                {
+                    result = prv_blockSend(contextP, fromPeer, transferP);
+                }
+                break;
+
+            case IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE:
+                optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_Q_BLOCK_1);
+                if (optionP == NULL
+                    || coapDecodeBlockInfo(optionP->value.asInteger, &number, &more, &size) != IOWA_COAP_NO_ERROR
+                    || size >= (uint16_t)(COAP_BLOCK_MIN_SIZE << transferP->szx))
+                {
+                    goto forward;
+                }
+
+                // Restart the transfer with the block size preferred by the peer
+                IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Peer asks for blocks of %u bytes.", size);
+                transferP->szx = prv_sizeToSzx(size);
+                result = coapPeerGenerateToken(fromPeer, &transferP->message.tokenLength, transferP->message.token);
+                if (result == IOWA_COAP_NO_ERROR)
+                {
+                    result = prv_blockSend(contextP, fromPeer, transferP);
+                }
+                break;
+
+            case IOWA_COAP_231_CONTINUE:
+                transferP->nextNumber = 1;
+                result = prv_qBlockSendSet(contextP, fromPeer, transferP);
+                break;
+
+            default:
+                goto forward;
+            }
+        }
+        else if (code == IOWA_COAP_231_CONTINUE
+                 && transferP->nextNumber < prv_qBlockCount(transferP))
+        {
+            result = prv_qBlockSendSet(contextP, fromPeer, transferP);
+        }
+        else if (code == IOWA_COAP_408_REQUEST_ENTITY_INCOMPLETE)
+        {
+            result = prv_qBlockSendMissing(contextP, fromPeer, transferP, messageP);
+            if (result == IOWA_COAP_408_REQUEST_ENTITY_INCOMPLETE)
+            {
+                goto forward;
+            }
+        }
+        else
+        {
+            goto forward;
+        }
+
+        if (result == IOWA_COAP_NO_ERROR)
+        {
+            return;
+        }
+
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Failed to send the next blocks: %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+        if (transferP->timerP != NULL)
+        {
+            coreTimerDelete(contextP, transferP->timerP);
+            transferP->timerP = NULL;
+        }
+        peerCancelExchange(fromPeer, transferP->lastTokenLength, transferP->lastToken);
+        code = result;
+        messageP = NULL;
+    }
+
+forward:
+    if (transferP->resultCallback != NULL)
+    {
+        transferP->resultCallback(fromPeer, code, messageP, transferP->userData, contextP);
+    }
+    iowa_system_free(transferP);
+}
+#endif // IOWA_COAP_QBLOCK_SUPPORT
+#endif // IOWA_COAP_BLOCK_SUPPORT
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+uint8_t coapDecodeBlockInfo(uint32_t value,
+                            uint32_t *numberP,
+                            bool *moreP,
+                            uint16_t *sizeP)
+{
+    uint8_t szx;
+
+    szx = (uint8_t)(value & 0x07);
+    if (szx == COAP_BLOCK_SZX_RESERVED
+        || value > 0x00FFFFFF)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Invalid block option value: 0x%X.", value);
+        return IOWA_COAP_402_BAD_OPTION;
+    }
+
+    *numberP = value >> 4;
+    *moreP = (value & 0x08) != 0;
+    *sizeP = (uint16_t)(COAP_BLOCK_MIN_SIZE << szx);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+uint8_t coapEncodeBlockInfo(uint32_t number,
+                            bool more,
+                            uint16_t size,
+                            uint32_t *valueP)
+{
+    uint8_t szx;
+
+    szx = prv_sizeToSzx(size);
+    if (szx == COAP_BLOCK_SZX_RESERVED)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_COAP, "Invalid block size: %u.", size);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+    if (number > 0x000FFFFF)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_COAP, "Invalid block number: %u.", number);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    *valueP = (number << 4) | (more ? 0x08 : 0x00) | szx;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+uint16_t coapBlockGetSize(iowa_context_t contextP,
+                          iowa_coap_peer_t *peerP)
+{
+    uint16_t size;
+    size_t maxSize;
+    size_t overhead;
+
+    overhead = COAP_BLOCK_DATAGRAM_OVERHEAD;
+#ifdef IOWA_LORAWAN_SUPPORT
+    if (peerP->base.type == IOWA_CONN_LORAWAN)
+    {
+        // The header and the options are compressed by the SCHC rules
+        overhead = COAP_LORAWAN_BLOCK_OVERHEAD;
+    }
+#endif
+
+    // The block and the other parts of the message must fit in the receive buffer
+    maxSize = prv_getMessageMaxSize(contextP, peerP);
+    size = COAP_BLOCK_MAX_SIZE;
+    while (size > COAP_BLOCK_MIN_SIZE
+           && (size_t)size + overhead > maxSize)
+    {
+        size >>= 1;
+    }
+
+    return size;
+}
+
+size_t coapBlockGetBertSize(iowa_context_t contextP,
+                            iowa_coap_peer_t *peerP)
+{
+    size_t maxSize;
+
+    if (prv_isBertPeer(peerP) == false)
+    {
+        return 0;
+    }
+
+    maxSize = prv_getMessageMaxSize(contextP, peerP);
+    if (maxSize < 2 * COAP_BLOCK_MAX_SIZE + COAP_BLOCK_DATAGRAM_OVERHEAD)
+    {
+        // A BERT block would carry a single block of 1024 bytes
+        return 0;
+    }
+
+    return ((maxSize - COAP_BLOCK_DATAGRAM_OVERHEAD) / COAP_BLOCK_MAX_SIZE) * COAP_BLOCK_MAX_SIZE;
+}
+
+uint8_t coapBlockDecodePeerInfo(iowa_coap_peer_t *peerP,
+                                uint32_t value,
+                                uint32_t *numberP,
+                                bool *moreP,
+                                uint16_t *sizeP,
+                                bool *bertP)
+{
+    if ((value & 0x07) == COAP_BLOCK_SZX_BERT
+        && value <= 0x00FFFFFF
+        && prv_isBertPeer(peerP) == true)
+    {
+        *numberP = value >> 4;
+        *moreP = (value & 0x08) != 0;
+        *sizeP = COAP_BLOCK_MAX_SIZE;
+        *bertP = true;
+
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    *bertP = false;
+
+    return coapDecodeBlockInfo(value, numberP, moreP, sizeP);
+}
+
+uint8_t coapBlockSetOption(iowa_context_t contextP,
+                           iowa_coap_message_t *messageP,
+                           uint16_t optionNumber,
+                           uint32_t number,
+                           bool more,
+                           uint16_t size)
+{
+    uint8_t result;
+    uint32_t value;
+
+    result = coapEncodeBlockInfo(number, more, size, &value);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    return prv_setIntegerOption(contextP, messageP, optionNumber, value);
+}
+
+uint8_t coapBlockSetBertOption(iowa_context_t contextP,
+                               iowa_coap_message_t *messageP,
+                               uint16_t optionNumber,
+                               uint32_t number,
+                               bool more)
+{
+    uint8_t result;
+    uint32_t value;
+
+    result = prv_encodeBertInfo(number, more, &value);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    return prv_setIntegerOption(contextP, messageP, optionNumber, value);
+}
+
+uint8_t coapBlockPrepareResponse(iowa_context_t contextP,
+                                 iowa_coap_peer_t *peerP,
+                                 iowa_coap_message_t *requestP,
+                                 iowa_coap_message_t *responseP)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t result;
+    iowa_coap_option_t *optionP;
+    uint32_t number;
+    bool more;
+    bool bert;
+    uint16_t size;
+    uint16_t maxSize;
+    size_t bertSize;
+    size_t blockLength;
+    size_t offset;
+    size_t totalLength;
+
+    if (iowa_coap_message_find_option(responseP, IOWA_COAP_OPTION_BLOCK_2) != NULL)
+    {
+        // Already cut by the upper layer
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    maxSize = coapBlockGetSize(contextP, peerP);
+    bertSize = coapBlockGetBertSize(contextP, peerP);
+    number = 0;
+    size = maxSize;
+    bert = false;
+
+    optionP = NULL;
+    if (requestP != NULL)
+    {
+        optionP = iowa_coap_message_find_option(requestP, IOWA_COAP_OPTION_BLOCK_2);
+    }
+    if (optionP != NULL)
+    {
+        result = coapBlockDecodePeerInfo(peerP, optionP->value.asInteger, &number, &more, &size, &bert);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            return result;
+        }
+        if (bertSize == 0)
+        {
+            // The BERT block would be a block of 1024 bytes
+            bert = false;
+        }
+        if (bert == false
+            && size > maxSize)
+        {
+            // RFC 7959 Section 2.4: a smaller block size can be used, keeping the same offset
+            number = number * (size / maxSize);
+            size = maxSize;
+        }
+    }
+    else if (responseP->payload.length <= maxSize
+             || responseP->payload.length <= bertSize)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+    else
+    {
+        bert = bertSize != 0;
+    }
+
+    if (bert == true)
+    {
+        size = COAP_BLOCK_MAX_SIZE;
+        blockLength = bertSize;
+    }
+    else
+    {
+        blockLength = size;
+    }
+
+    totalLength = responseP->payload.length;
+    offset = (size_t)number * size;
+    if (number != 0
+        && offset >= totalLength)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Requested block %u is beyond the %u bytes of content.", number, totalLength);
+        return IOWA_COAP_402_BAD_OPTION;
+    }
+
+    more = offset + blockLength < totalLength;
+    responseP->payload.length = more ? blockLength : totalLength - offset;
+    if (offset != 0)
+    {
+        memmove(responseP->payload.data, responseP->payload.data + offset, responseP->payload.length);
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Sending block %u of %u bytes out of %u bytes.", number, responseP->payload.length, totalLength);
+
+    if (bert == true)
+    {
+        result = coapBlockSetBertOption(contextP, responseP, IOWA_COAP_OPTION_BLOCK_2, number, more);
+    }
+    else
+    {
+        result = coapBlockSetOption(contextP, responseP, IOWA_COAP_OPTION_BLOCK_2, number, more, size);
+    }
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = prv_setIntegerOption(contextP, responseP, IOWA_COAP_OPTION_SIZE_2, (uint32_t)totalLength);
+    }
+
+    return result;
+}
+
+uint8_t blockSend413Reply(iowa_context_t contextP,
+                          iowa_coap_peer_t *peerP,
+                          iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t result;
+    iowa_coap_message_t *responseP;
+
+    responseP = iowa_coap_message_prepare_response(contextP, messageP, IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (responseP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create response packet.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    // RFC 7959 Section 2.9.3: indicate the block size to use
+    result = coapBlockSetOption(contextP, responseP, IOWA_COAP_OPTION_BLOCK_1, 0, false, coapBlockGetSize(contextP, peerP));
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = peerSend(contextP, peerP, responseP, NULL, NULL);
+    }
+
+    iowa_coap_message_free(responseP);
+
+    return result;
+}
+#endif // defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+uint8_t blockPush(iowa_context_t contextP,
+                  iowa_coap_peer_t *peerP,
+                  iowa_coap_message_t *messageP,
+                  coap_message_callback_t resultCallback,
+                  void *userData)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t result;
+    block_transfer_t *transferP;
+    iowa_coap_option_t *optionP;
+    iowa_coap_option_t *optionArray;
+    size_t optionCount;
+    size_t dataLength;
+    size_t allocLength;
+    uint8_t *dataP;
+    size_t i;
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    uint8_t tagLength;
+#endif
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Sending a request of %u bytes by blocks to peer %p.", messageP->payload.length, peerP);
+
+    // The options and the payload are copied as the caller frees the request when this function returns
+    optionCount = 0;
+    dataLength = messageP->payload.length;
+    for (optionP = messageP->optionList; optionP != NULL; optionP = optionP->next)
+    {
+        optionCount++;
+        if (iowa_coap_option_is_integer(optionP) == false)
+        {
+            dataLength += optionP->length;
+        }
+    }
+
+    allocLength = sizeof(block_transfer_t) + optionCount * sizeof(iowa_coap_option_t) + dataLength;
+    transferP = (block_transfer_t *)iowa_system_malloc(allocLength);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (transferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(allocLength);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(transferP, 0, sizeof(block_transfer_t));
+
+    optionArray = (iowa_coap_option_t *)(transferP + 1);
+    dataP = (uint8_t *)(optionArray + optionCount);
+
+    transferP->message.type = messageP->type;
+    transferP->message.code = messageP->code;
+    transferP->message.tokenLength = messageP->tokenLength;
+    memcpy(transferP->message.token, messageP->token, messageP->tokenLength);
+
+    // The options of the request are already sorted
+    for (optionP = messageP->optionList, i = 0; optionP != NULL; optionP = optionP->next, i++)
+    {
+        optionArray[i] = *optionP;
+        optionArray[i].next = (i + 1 < optionCount) ? optionArray + i + 1 : NULL;
+        if (iowa_coap_option_is_integer(optionP) == false
+            && optionP->length != 0)
+        {
+            memcpy(dataP, optionP->value.asBuffer, optionP->length);
+            optionArray[i].value.asBuffer = dataP;
+            dataP += optionP->length;
+        }
+    }
+    if (optionCount != 0)
+    {
+        transferP->message.optionList = optionArray;
+    }
+
+    transferP->sizeOption.number = IOWA_COAP_OPTION_SIZE_1;
+    transferP->sizeOption.value.asInteger = (uint32_t)messageP->payload.length;
+    iowa_coap_message_add_option(&transferP->message, &transferP->sizeOption);
+
+    memcpy(dataP, messageP->payload.data, messageP->payload.length);
+    transferP->payload = dataP;
+    transferP->payloadLength = messageP->payload.length;
+
+    transferP->blockOption.number = IOWA_COAP_OPTION_BLOCK_1;
+    transferP->bertSize = coapBlockGetBertSize(contextP, peerP);
+    if (transferP->bertSize != 0)
+    {
+        transferP->szx = COAP_BLOCK_SZX_BERT;
+    }
+    else
+    {
+        transferP->szx = prv_sizeToSzx(coapBlockGetSize(contextP, peerP));
+    }
+    transferP->resultCallback = resultCallback;
+    transferP->userData = userData;
+
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    // Blocks are never lost on stream transports
+    if (peerP->base.qBlockUnsupported == false
+        && peerP->base.type != IOWA_CONN_STREAM
+        && peerP->base.type != IOWA_CONN_WEBSOCKET)
+    {
+        // The first block is confirmable: a peer not supporting Q-Block1 rejects it with a 4.02 code
+        transferP->qBlock = true;
+        transferP->peerP = peerP;
+        transferP->blockOption.number = IOWA_COAP_OPTION_Q_BLOCK_1;
+
+        // The Request-Tag identifies the body as each block has its own token
+        transferP->tagOption.number = IOWA_COAP_OPTION_REQUEST_TAG;
+        transferP->tagOption.value.asBuffer = transferP->tag;
+        result = coapPeerGenerateToken(peerP, &tagLength, transferP->tag);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            iowa_system_free(transferP);
+            return result;
+        }
+        transferP->tagOption.length = tagLength;
+    }
+#endif
+
+    iowa_coap_message_add_option(&transferP->message, &transferP->blockOption);
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    if (transferP->qBlock == true)
+    {
+        iowa_coap_message_add_option(&transferP->message, &transferP->tagOption);
+    }
+#endif
+
+    // The first block keeps the token of the request
+    result = prv_blockSend(contextP, peerP, transferP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        iowa_system_free(transferP);
+    }
+
+    return result;
+}
+
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+uint8_t coapQBlock1Receive(iowa_coap_peer_t *peerP,
+                           iowa_coap_message_t *requestP,
+                           uint32_t number,
+                           bool more,
+                           bool *nextP)
+{
+    // WARNING: This function is called in a critical section
+    coap_qblock_receive_t *stateP;
+    iowa_coap_option_t *tagP;
+    const uint8_t *tag;
+    uint8_t tagLength;
+    bool repeated;
+
+    stateP = &peerP->base.qBlock1;
+
+    tag = NULL;
+    tagLength = 0;
+    tagP = iowa_coap_message_find_option(requestP, IOWA_COAP_OPTION_REQUEST_TAG);
+    if (tagP != NULL)
+    {
+        if (tagP->length > COAP_MSG_TOKEN_MAX_LEN)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Request-Tag of %u bytes is too long.", tagP->length);
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+        tag = tagP->value.asBuffer;
+        tagLength = (uint8_t)tagP->length;
+    }
+
+    if (stateP->active == false
+        || stateP->tagLength != tagLength
+        || (tagLength != 0
+            && memcmp(stateP->tag, tag, tagLength) != 0)
+        || (number == 0
+            && stateP->ended == true
+            && stateP->nextNumber >= stateP->highNumber))
+    {
+        // A new body, its blocks are expected from the first one
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Receiving a new body in Q-Block1 blocks from peer %p.", peerP);
+
+        memset(stateP, 0, sizeof(coap_qblock_receive_t));
+        stateP->active = true;
+        stateP->tagLength = tagLength;
+        if (tagLength != 0)
+        {
+            memcpy(stateP->tag, tag, tagLength);
+        }
+    }
+
+    // The sender retransmits the block waiting for a response, either the highest one or one already handled
+    repeated = number < stateP->nextNumber || number + 1 == stateP->highNumber;
+    if (number >= stateP->highNumber)
+    {
+        stateP->highNumber = number + 1;
+    }
+    if (more == false)
+    {
+        stateP->ended = true;
+    }
+
+    stateP->respond = requestP->type == IOWA_COAP_TYPE_CONFIRMABLE
+                      || repeated == true
+                      || more == false
+                      || number >= stateP->setStart + IOWA_COAP_QBLOCK_MAX_PAYLOADS - 1;
+
+    *nextP = false;
+    if (stateP->error == IOWA_COAP_NO_ERROR
+        && number == stateP->nextNumber)
+    {
+        stateP->nextNumber++;
+        *nextP = true;
+    }
+    else if (number > stateP->nextNumber)
+    {
+        IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Dropping Q-Block %u while waiting for block %u.", number, stateP->nextNumber);
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+uint8_t coapQBlock1PrepareResponse(iowa_context_t contextP,
+                                   iowa_coap_peer_t *peerP,
+                                   iowa_coap_message_t *requestP,
+                                   uint8_t result,
+                                   iowa_coap_message_t *responseP)
+{
+    // WARNING: This function is called in a critical section
+    coap_qblock_receive_t *stateP;
+    iowa_coap_option_t *optionP;
+    uint32_t number;
+    bool more;
+    uint16_t size;
+
+    stateP = &peerP->base.qBlock1;
+
+    if (result != IOWA_COAP_231_CONTINUE
+        && result != IOWA_COAP_204_CHANGED)
+    {
+        // The body can not be completed anymore
+        stateP->error = result;
+        return result;
+    }
+    if (stateP->respond == false)
+    {
+        return IOWA_COAP_CODE_EMPTY;
+    }
+
+    optionP = iowa_coap_message_find_option(requestP, IOWA_COAP_OPTION_Q_BLOCK_1);
+    if (optionP == NULL
+        || coapDecodeBlockInfo(optionP->value.asInteger, &number, &more, &size) != IOWA_COAP_NO_ERROR)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+    stateP->setStart = number + 1;
+
+    if (stateP->error != IOWA_COAP_NO_ERROR)
+    {
+        return stateP->error;
+    }
+
+    if (stateP->nextNumber < stateP->highNumber)
+    {
+        uint8_t *bufferP;
+        size_t bufferLength;
+        size_t length;
+        uint32_t missing;
+
+        // RFC 9177 Section 5: list the missing blocks in a CBOR Sequence fitting in a block
+        bufferLength = coapBlockGetSize(contextP, peerP);
+        bufferP = (uint8_t *)iowa_system_malloc(bufferLength);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (bufferP == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(bufferLength);
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+        length = 0;
+        for (missing = stateP->nextNumber; missing < stateP->highNumber && length + 5 <= bufferLength; missing++)
+        {
+            length += prv_cborWriteUnsigned(missing, bufferP + length);
+        }
+
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Missing Q-Blocks %u to %u.", stateP->nextNumber, missing - 1);
+
+        coreBufferSet(&(responseP->payload), bufferP, length);
+        if (prv_setIntegerOption(contextP, responseP, IOWA_COAP_OPTION_CONTENT_FORMAT, COAP_CONTENT_FORMAT_MISSING_BLOCKS) != IOWA_COAP_NO_ERROR)
+        {
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+
+        return IOWA_COAP_408_REQUEST_ENTITY_INCOMPLETE;
+    }
+
+    if (stateP->ended == false)
+    {
+        result = IOWA_COAP_231_CONTINUE;
+        more = true;
+    }
+    else
+    {
+        more = false;
+    }
+
+    if (coapBlockSetOption(contextP, responseP, IOWA_COAP_OPTION_Q_BLOCK_1, number, more, size) != IOWA_COAP_NO_ERROR)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return result;
+}
+
+uint8_t coapQBlock2SendResponse(iowa_context_t contextP,
+                                iowa_coap_peer_t *peerP,
+                                iowa_coap_message_t *requestP,
+                                iowa_coap_message_t *responseP)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t result;
+    iowa_coap_option_t *optionP;
+    iowa_coap_message_t *blockP;
+    iowa_buffer_t payload;
+    uint32_t number;
+    uint32_t count;
+    uint32_t i;
+    bool more;
+    bool hasMore;
+    uint16_t size;
+    uint16_t maxSize;
+    size_t offset;
+    size_t totalLength;
+
+    payload = responseP->payload;
+    totalLength = payload.length;
+    maxSize = coapBlockGetSize(contextP, peerP);
+
+    optionP = iowa_coap_message_find_option(requestP, IOWA_COAP_OPTION_Q_BLOCK_2);
+    result = coapDecodeBlockInfo(optionP->value.asInteger, &number, &more, &size);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        goto error;
+    }
+    // The M bit of the request asks for the rest of the set
+    count = more ? IOWA_COAP_QBLOCK_MAX_PAYLOADS : 1;
+
+    optionP = iowa_coap_message_find_option(responseP, IOWA_COAP_OPTION_Q_BLOCK_2);
+    if (optionP != NULL)
+    {
+        // Already cut by the upper layer, the payload starts with the block of the option
+        result = coapDecodeBlockInfo(optionP->value.asInteger, &number, &hasMore, &size);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            goto error;
+        }
+        offset = 0;
+    }
+    else
+    {
+        if (size > maxSize)
+        {
+            // RFC 7959 Section 2.4: a smaller block size can be used, keeping the same offset
+            number = number * (size / maxSize);
+            size = maxSize;
+        }
+        offset = (size_t)number * size;
+        if (number != 0
+            && offset >= totalLength)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Requested block %u is beyond the %u bytes of content.", number, totalLength);
+            result = IOWA_COAP_402_BAD_OPTION;
+            goto error;
+        }
+        hasMore = false;
+
+        result = prv_setIntegerOption(contextP, responseP, IOWA_COAP_OPTION_SIZE_2, (uint32_t)totalLength);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            goto error;
+        }
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Sending up to %u Q-Blocks from block %u.", count, number);
+
+    // The other blocks of the set have the same token and options
+    blockP = NULL;
+    if (count > 1
+        && offset + size < totalLength)
+    {
+        blockP = iowa_coap_message_new(contextP, IOWA_COAP_TYPE_NON_CONFIRMABLE, responseP->code, responseP->tokenLength, responseP->token);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (blockP == NULL)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP message.");
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            goto error;
+        }
+#endif
+        for (optionP = responseP->optionList; optionP != NULL && result == IOWA_COAP_NO_ERROR; optionP = optionP->next)
+        {
+            if (optionP->number == IOWA_COAP_OPTION_CONTENT_FORMAT
+                || optionP->number == IOWA_COAP_OPTION_SIZE_2)
+            {
+                result = prv_setIntegerOption(contextP, blockP, optionP->number, optionP->value.asInteger);
+            }
+        }
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            iowa_coap_message_free(blockP);
+            goto error;
+        }
+    }
+
+    for (i = 0; i < count && (i == 0 || offset < totalLength); i++)
+    {
+        iowa_coap_message_t *messageP;
+        uint8_t sendResult;
+        size_t length;
+
+        messageP = i == 0 ? responseP : blockP;
+
+        length = totalLength - offset;
+        more = hasMore;
+        if (length > size)
+        {
+            length = size;
+            more = true;
+        }
+
+        sendResult = coapBlockSetOption(contextP, messageP, IOWA_COAP_OPTION_Q_BLOCK_2, number + i, more, size);
+        if (sendResult == IOWA_COAP_NO_ERROR)
+        {
+            messageP->payload.memory = NULL;
+            messageP->payload.data = payload.data + offset;
+            messageP->payload.length = length;
+            sendResult = coapSend(contextP, peerP, messageP, NULL, NULL);
+        }
+        if (i == 0)
+        {
+            result = sendResult;
+        }
+        else if (sendResult != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Failed to send Q-Block %u: %u.%02u.", number + i, (sendResult & 0xFF) >> 5, (sendResult & 0x1F));
+            break;
+        }
+
+        offset += length;
+    }
+
+    if (blockP != NULL)
+    {
+        blockP->payload = IOWA_BUFFER_EMPTY;
+        iowa_coap_message_free(blockP);
+    }
+    responseP->payload = payload;
+
+    return result;
+
+error:
+    // Send the error instead of the content
+    responseP->code = result;
+    responseP->payload = IOWA_BUFFER_EMPTY;
+    result = coapSend(contextP, peerP, responseP, NULL, NULL);
+    responseP->payload = payload;
+
+    return result;
+}
+#endif // IOWA_COAP_QBLOCK_SUPPORT
+#endif // IOWA_COAP_BLOCK_SUPPORT
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t iowa_coap_message_get_block_info(iowa_coap_message_t *messageP,
+                                               uint32_t *numberP,
+                                               bool *moreP,
+                                               uint16_t *sizeP)
+{
+    iowa_coap_option_t *optionP;
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (messageP == NULL
+        || numberP == NULL
+        || moreP == NULL
+        || sizeP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Invalid parameters.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    optionP = prv_findBlockOption(messageP);
+    if (optionP == NULL)
+    {
+        return IOWA_COAP_404_NOT_FOUND;
+    }
+
+    return coapDecodeBlockInfo(optionP->value.asInteger, numberP, moreP, sizeP);
+}
+
+iowa_status_t iowa_coap_message_get_content_total_size(iowa_coap_message_t *messageP,
+                                                       size_t *totalSizeP)
+{
+    iowa_coap_option_t *optionP;
+    uint32_t number;
+    bool more;
+    uint16_t size;
+    iowa_status_t result;
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (messageP == NULL
+        || totalSizeP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Invalid parameters.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    optionP = iowa_coap_message_find_option(messageP, COAP_IS_REQUEST(messageP->code) ? IOWA_COAP_OPTION_SIZE_1 : IOWA_COAP_OPTION_SIZE_2);
+    if (optionP != NULL)
+    {
+        *totalSizeP = optionP->value.asInteger;
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    optionP = prv_findBlockOption(messageP);
+    if (optionP == NULL)
+    {
+        *totalSizeP = messageP->payload.length;
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    result = coapDecodeBlockInfo(optionP->value.asInteger, &number, &more, &size);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+    if (more == true)
+    {
+        // The total size is not known before the last block
+        return IOWA_COAP_404_NOT_FOUND;
+    }
+
+    *totalSizeP = (size_t)number * size + messageP->payload.length;
+
+    return IOWA_COAP_NO_ERROR;
+}
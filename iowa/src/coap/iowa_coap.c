@@ -29,6 +29,121 @@
                          ((S) == IOWA_CONN_WEBSOCKET ? "WebSocket" : \
                          "Unknown")))))
 
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+
+#define PRV_STEP_HEAP_INITIAL_CAPACITY 4
+
+#define PRV_HEAP_PARENT(I) (((I) - 1) / 2)
+#define PRV_HEAP_LEFT(I)   (2 * (I) + 1)
+
+static void prv_stepHeapSet(coap_context_t coapContextP,
+                            size_t index,
+                            coap_peer_datagram_t *peerP)
+{
+    coapContextP->stepHeap[index] = peerP;
+    peerP->stepIndex = index;
+}
+
+// Move a peer toward the root of the heap until its parent is stepped before it.
+static void prv_stepHeapSiftUp(coap_context_t coapContextP,
+                               size_t index)
+{
+    coap_peer_datagram_t *peerP;
+
+    peerP = coapContextP->stepHeap[index];
+    while (index > 0
+           && coapContextP->stepHeap[PRV_HEAP_PARENT(index)]->stepTime > peerP->stepTime)
+    {
+        prv_stepHeapSet(coapContextP, index, coapContextP->stepHeap[PRV_HEAP_PARENT(index)]);
+        index = PRV_HEAP_PARENT(index);
+    }
+    prv_stepHeapSet(coapContextP, index, peerP);
+}
+
+// Move a peer toward the leaves of the heap until its children are stepped after it.
+static void prv_stepHeapSiftDown(coap_context_t coapContextP,
+                                 size_t index)
+{
+    coap_peer_datagram_t *peerP;
+
+    peerP = coapContextP->stepHeap[index];
+    while (PRV_HEAP_LEFT(index) < coapContextP->stepCount)
+    {
+        size_t childIndex;
+
+        childIndex = PRV_HEAP_LEFT(index);
+        if (childIndex + 1 < coapContextP->stepCount
+            && coapContextP->stepHeap[childIndex + 1]->stepTime < coapContextP->stepHeap[childIndex]->stepTime)
+        {
+            childIndex++;
+        }
+        if (coapContextP->stepHeap[childIndex]->stepTime >= peerP->stepTime)
+        {
+            break;
+        }
+        prv_stepHeapSet(coapContextP, index, coapContextP->stepHeap[childIndex]);
+        index = childIndex;
+    }
+    prv_stepHeapSet(coapContextP, index, peerP);
+}
+
+static bool prv_stepHeapInsert(coap_context_t coapContextP,
+                               coap_peer_datagram_t *peerP)
+{
+    if (coapContextP->stepCount == coapContextP->stepCapacity)
+    {
+        coap_peer_datagram_t **newArray;
+        size_t newCapacity;
+
+        newCapacity = (coapContextP->stepCapacity == 0) ? PRV_STEP_HEAP_INITIAL_CAPACITY : coapContextP->stepCapacity * 2;
+        newArray = (coap_peer_datagram_t **)iowa_system_malloc(newCapacity * sizeof(coap_peer_datagram_t *));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (newArray == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(newCapacity * sizeof(coap_peer_datagram_t *));
+            return false;
+        }
+#endif
+        if (coapContextP->stepCount > 0)
+        {
+            memcpy(newArray, coapContextP->stepHeap, coapContextP->stepCount * sizeof(coap_peer_datagram_t *));
+        }
+        iowa_system_free(coapContextP->stepHeap);
+        coapContextP->stepHeap = newArray;
+        coapContextP->stepCapacity = newCapacity;
+    }
+
+    coapContextP->stepHeap[coapContextP->stepCount] = peerP;
+    coapContextP->stepCount++;
+    prv_stepHeapSiftUp(coapContextP, coapContextP->stepCount - 1);
+
+    return true;
+}
+
+static void prv_stepHeapRemove(coap_context_t coapContextP,
+                               coap_peer_datagram_t *peerP)
+{
+    size_t index;
+
+    index = peerP->stepIndex;
+    peerP->stepIndex = COAP_STEP_INDEX_NONE;
+    coapContextP->stepCount--;
+    if (index != coapContextP->stepCount)
+    {
+        prv_stepHeapSet(coapContextP, index, coapContextP->stepHeap[coapContextP->stepCount]);
+        if (index > 0
+            && coapContextP->stepHeap[PRV_HEAP_PARENT(index)]->stepTime > coapContextP->stepHeap[index]->stepTime)
+        {
+            prv_stepHeapSiftUp(coapContextP, index);
+        }
+        else
+        {
+            prv_stepHeapSiftDown(coapContextP, index);
+        }
+    }
+}
+#endif
+
 uint8_t coapInit(iowa_context_t contextP)
 {
     IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering.");
@@ -43,6 +158,9 @@ uint8_t coapInit(iowa_context_t contextP)
 #endif
 
     memset(contextP->coapContextP, 0, sizeof(struct _coap_context_t));
+#ifdef IOWA_UDP_SUPPORT
+    contextP->coapContextP->recvDatagramMaxSize = IOWA_BUFFER_SIZE;
+#endif
 
     IOWA_LOG_TRACE(IOWA_PART_COAP, "CoAP init done.");
 
@@ -69,6 +187,12 @@ void coapClose(iowa_context_t contextP)
         peerP = nextPeerP;
     }
 
+#ifdef IOWA_UDP_SUPPORT
+    iowa_system_free(contextP->coapContextP->recvBuffer);
+#endif
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+    iowa_system_free(contextP->coapContextP->stepHeap);
+#endif
     iowa_system_free(contextP->coapContextP);
     contextP->coapContextP = NULL;
 
@@ -77,51 +201,133 @@ void coapClose(iowa_context_t contextP)
 
 uint8_t coapStep(iowa_context_t contextP)
 {
-    iowa_coap_peer_t *peerP;
+    // WARNING: This function is called in a critical section
     uint8_t result;
 
-    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Entering currentTime: %u, timeoutP: %u.", contextP->currentTime, contextP->timeout);
+#if !defined(IOWA_UDP_SUPPORT) && !defined(IOWA_LORAWAN_SUPPORT) && !defined(IOWA_SMS_SUPPORT)
+    (void)contextP;
+#endif
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Entering currentTime: %lld, timeoutP: %d.", (long long)contextP->currentTime, contextP->timeout);
 
     result = IOWA_COAP_NO_ERROR;
 
-    peerP = contextP->coapContextP->peerList;
-    while (peerP != NULL
-           && result == IOWA_COAP_NO_ERROR)
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
     {
-        iowa_coap_peer_t *peerNextP;
+        coap_context_t coapContextP;
+        size_t count;
 
-        IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Peer %p.", peerP);
+        coapContextP = contextP->coapContextP;
 
-        // Save the next peer since the step function can delete the current peer.
-        peerNextP = peerP->base.next;
-        switch (peerP->base.type)
+        // A peer rescheduled at the current time is stepped at most once more, bounding the loop
+        count = coapContextP->stepCount;
+        while (count > 0
+               && coapContextP->stepCount > 0
+               && coapContextP->stepHeap[0]->stepTime <= contextP->currentTime
+               && result == IOWA_COAP_NO_ERROR)
         {
+            coap_peer_datagram_t *peerP;
+            int32_t timeout;
+
+            peerP = coapContextP->stepHeap[0];
+            prv_stepHeapRemove(coapContextP, peerP);
+            count--;
+
+            IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Peer %p.", peerP);
+
+            timeout = INT32_MAX;
+
+            // The step functions can delete the peer
+            coapContextP->stepPeerP = peerP;
+            switch (peerP->base.type)
+            {
 #ifdef IOWA_UDP_SUPPORT
-        case IOWA_CONN_DATAGRAM:
-            result = transactionStep(contextP, (coap_peer_datagram_t *)peerP, contextP->currentTime, &(contextP->timeout));
-            break;
+            case IOWA_CONN_DATAGRAM:
+                udpSendQueueFlush(contextP, peerP, contextP->currentTime, &timeout);
+                result = transactionStep(contextP, peerP, contextP->currentTime, &timeout);
+                break;
 #endif
 
-#if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
-        case IOWA_CONN_STREAM:
-        case IOWA_CONN_WEBSOCKET:
-            result = IOWA_COAP_NO_ERROR;
-            break;
+#ifdef IOWA_LORAWAN_SUPPORT
+            case IOWA_CONN_LORAWAN:
+                result = transactionStep(contextP, peerP, contextP->currentTime, &timeout);
+                break;
 #endif
 
-        default:
-            IOWA_LOG_ARG_ERROR(IOWA_PART_COAP, "Unsupported connection type: %d.", peerP->base.type);
-            result = IOWA_COAP_501_NOT_IMPLEMENTED;
+            default:
+                IOWA_LOG_ARG_ERROR(IOWA_PART_COAP, "Unsupported connection type: %d.", peerP->base.type);
+                result = IOWA_COAP_501_NOT_IMPLEMENTED;
+            }
+
+            if (coapContextP->stepPeerP != NULL
+                && timeout != INT32_MAX)
+            {
+                coapPeerSchedule(contextP, peerP, contextP->currentTime + timeout);
+            }
+            coapContextP->stepPeerP = NULL;
         }
 
-        peerP = peerNextP;
+        if (coapContextP->stepCount > 0)
+        {
+            int32_t delay;
+
+            if (coapContextP->stepHeap[0]->stepTime <= contextP->currentTime)
+            {
+                delay = 0;
+            }
+            else
+            {
+                delay = coreTimeToDelay(coapContextP->stepHeap[0]->stepTime - contextP->currentTime);
+            }
+            if (delay < contextP->timeout)
+            {
+                contextP->timeout = delay;
+            }
+        }
     }
+#endif
 
     IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Exiting with final timeout: %u.", contextP->timeout);
 
     return result;
 }
 
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+void coapPeerSchedule(iowa_context_t contextP,
+                      coap_peer_datagram_t *peerP,
+                      iowa_time_t stepTime)
+{
+    // WARNING: This function is called in a critical section
+    if (peerP->stepIndex == COAP_STEP_INDEX_NONE)
+    {
+        peerP->stepTime = stepTime;
+        if (prv_stepHeapInsert(contextP->coapContextP, peerP) == false)
+        {
+            IOWA_LOG_ARG_ERROR(IOWA_PART_COAP, "Failed to schedule peer %p.", peerP);
+        }
+    }
+    else if (stepTime < peerP->stepTime)
+    {
+        peerP->stepTime = stepTime;
+        prv_stepHeapSiftUp(contextP->coapContextP, peerP->stepIndex);
+    }
+}
+
+void coapPeerUnschedule(iowa_context_t contextP,
+                        coap_peer_datagram_t *peerP)
+{
+    // WARNING: This function is called in a critical section
+    if (peerP->stepIndex != COAP_STEP_INDEX_NONE)
+    {
+        prv_stepHeapRemove(contextP->coapContextP, peerP);
+    }
+    if (contextP->coapContextP->stepPeerP == peerP)
+    {
+        contextP->coapContextP->stepPeerP = NULL;
+    }
+}
+#endif
+
 uint8_t coapSend(iowa_context_t contextP,
                  iowa_coap_peer_t *peerP,
                  iowa_coap_message_t *messageP,
@@ -130,16 +336,41 @@ uint8_t coapSend(iowa_context_t contextP,
 {
     // WARNING: This function is called in a critical section
     uint8_t result;
+    iowa_security_state_t state;
 
     IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering.");
 
-    if (coapPeerGetConnectionState(peerP) != SECURITY_STATE_CONNECTED)
+    state = coapPeerGetConnectionState(peerP);
+    if (state != SECURITY_STATE_CONNECTED)
     {
-        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Peer %p is not connected.", peerP);
+#ifdef IOWA_UDP_SUPPORT
+        // Datagram peers queue the message until the connection is established
+        if (peerP->base.type != IOWA_CONN_DATAGRAM
+            || (state != SECURITY_STATE_INIT_HANDSHAKE
+                && state != SECURITY_STATE_HANDSHAKING
+                && state != SECURITY_STATE_HANDSHAKE_DONE))
+#endif
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Peer %p is not connected.", peerP);
 
-        return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+            return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+        }
     }
 
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+    // Messages have no type on stream transports
+    if (COAP_IS_REQUEST(messageP->code)
+        && (messageP->type == IOWA_COAP_TYPE_CONFIRMABLE
+            || peerP->base.type == IOWA_CONN_STREAM
+            || peerP->base.type == IOWA_CONN_WEBSOCKET)
+        && messageP->payload.length > coapBlockGetSize(contextP, peerP)
+        && messageP->payload.length > coapBlockGetBertSize(contextP, peerP)
+        && iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_1) == NULL)
+    {
+        result = blockPush(contextP, peerP, messageP, resultCallback, userData);
+    }
+    else
+#endif
     {
         result = peerSend(contextP, peerP, messageP, resultCallback, userData);
     }
@@ -227,7 +458,8 @@ iowa_coap_option_t * iowa_coap_message_find_option(iowa_coap_message_t *messageP
     return NULL;
 }
 
-iowa_coap_message_t * iowa_coap_message_new(uint8_t type,
+iowa_coap_message_t * iowa_coap_message_new(iowa_context_t contextP,
+                                            uint8_t type,
                                             uint8_t code,
                                             uint8_t tokenLength,
                                             uint8_t *token)
@@ -251,7 +483,7 @@ iowa_coap_message_t * iowa_coap_message_new(uint8_t type,
     }
 #endif
 
-    messageP = (iowa_coap_message_t *)iowa_system_malloc(sizeof(iowa_coap_message_t));
+    messageP = (iowa_coap_message_t *)CORE_POOL_ALLOC(contextP, CORE_POOL_MESSAGE, sizeof(iowa_coap_message_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     if (messageP == NULL)
     {
@@ -285,14 +517,19 @@ void iowa_coap_message_free(iowa_coap_message_t *messageP)
 {
     if (messageP != NULL)
     {
+#if IOWA_COAP_INLINE_OPTION_COUNT > 0
+        option_freeList(messageP->optionList, messageP->optionArray, IOWA_COAP_INLINE_OPTION_COUNT);
+#else
         iowa_coap_option_free(messageP->optionList);
+#endif
 
         IOWA_UTILS_LIST_FREE(messageP->userBufferList, prv_freeBufferList);
-        iowa_system_free(messageP);
+        CORE_POOL_FREE(messageP);
     }
 }
 
-iowa_coap_message_t * iowa_coap_message_prepare_response(iowa_coap_message_t *messageP,
+iowa_coap_message_t * iowa_coap_message_prepare_response(iowa_context_t contextP,
+                                                         iowa_coap_message_t *messageP,
                                                          uint8_t code)
 {
     iowa_coap_message_t *responseP;
@@ -300,7 +537,7 @@ iowa_coap_message_t * iowa_coap_message_prepare_response(iowa_coap_message_t *me
     switch (messageP->type)
     {
     case IOWA_COAP_TYPE_CONFIRMABLE:
-        responseP = iowa_coap_message_new(IOWA_COAP_TYPE_ACKNOWLEDGEMENT, code, messageP->tokenLength, messageP->token);
+        responseP = iowa_coap_message_new(contextP, IOWA_COAP_TYPE_ACKNOWLEDGEMENT, code, messageP->tokenLength, messageP->token);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (responseP == NULL)
         {
@@ -312,7 +549,7 @@ iowa_coap_message_t * iowa_coap_message_prepare_response(iowa_coap_message_t *me
         break;
 
     case IOWA_COAP_TYPE_NON_CONFIRMABLE:
-        responseP = iowa_coap_message_new(IOWA_COAP_TYPE_NON_CONFIRMABLE, code, messageP->tokenLength, messageP->token);
+        responseP = iowa_coap_message_new(contextP, IOWA_COAP_TYPE_NON_CONFIRMABLE, code, messageP->tokenLength, messageP->token);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (responseP == NULL)
         {
@@ -390,7 +627,7 @@ void coapSendResponse(iowa_context_t contextP,
         return;
     }
 
-    responseP = iowa_coap_message_prepare_response(messageP, code);
+    responseP = iowa_coap_message_prepare_response(contextP, messageP, code);
 
     if (responseP != NULL)
     {
@@ -410,6 +647,95 @@ void coapSendResponse(iowa_context_t contextP,
 * APIs
 */
 
+#ifdef IOWA_UDP_SUPPORT
+iowa_status_t iowa_receive_buffer_set_size(iowa_context_t contextP,
+                                           size_t size)
+{
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "size: %u.", size);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (size < COAP_DATAGRAM_MIN_BUFFER_SIZE)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_COAP, "Buffer size %u is less than %u.", size, COAP_DATAGRAM_MIN_BUFFER_SIZE);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    CRIT_SECTION_ENTER(contextP);
+    // The buffer is reallocated on the next reception since a reception may be ongoing
+    contextP->coapContextP->recvDatagramMaxSize = size;
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+#endif
+
+iowa_status_t iowa_coap_peer_configuration_set(iowa_context_t contextP,
+                                               iowa_coap_peer_t *peerP,
+                                               iowa_coap_setting_id_t settingId,
+                                               void *argP)
+{
+    iowa_status_t result;
+
+#ifndef IOWA_THREAD_SUPPORT
+    (void)contextP;
+#endif
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "peerP: %p, settingId: %u, argP: %p.", peerP, settingId, argP);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (peerP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Peer is nil.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+    if (argP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Setting value is nil.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    CRIT_SECTION_ENTER(contextP);
+    result = coapPeerConfiguration(peerP, true, settingId, argP);
+    CRIT_SECTION_LEAVE(contextP);
+
+    return result;
+}
+
+iowa_status_t iowa_coap_peer_configuration_get(iowa_context_t contextP,
+                                               iowa_coap_peer_t *peerP,
+                                               iowa_coap_setting_id_t settingId,
+                                               void *argP)
+{
+    iowa_status_t result;
+
+#ifndef IOWA_THREAD_SUPPORT
+    (void)contextP;
+#endif
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "peerP: %p, settingId: %u, argP: %p.", peerP, settingId, argP);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (peerP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Peer is nil.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+    if (argP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Setting value is nil.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    CRIT_SECTION_ENTER(contextP);
+    result = coapPeerConfiguration(peerP, false, settingId, argP);
+    CRIT_SECTION_LEAVE(contextP);
+
+    return result;
+}
+
 iowa_status_t iowa_coap_uri_parse(const char *uri,
                                   iowa_connection_type_t *typeP,
                                   char **hostnameP,
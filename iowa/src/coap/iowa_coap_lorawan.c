@@ -23,3 +23,187 @@
 #include "iowa_prv_coap_internals.h"
 #include <stdbool.h>
 
+#ifdef IOWA_LORAWAN_SUPPORT
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+static uint8_t prv_getSendResult(int nbSent,
+                                 size_t length)
+{
+    if (nbSent < 0)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Communication error: %d.", nbSent);
+        return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+    }
+
+    if ((size_t)nbSent < length)
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Need to send in blocks, %u bytes to send but connection layer returned %d.", length, nbSent);
+        return IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Decompress and handle a received LoRaWAN frame.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer the frame was received from.
+// - buffer, bufferLength: the frame.
+static void prv_handleFrame(iowa_context_t contextP,
+                            coap_peer_datagram_t *peerP,
+                            uint8_t *buffer,
+                            size_t bufferLength)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_message_t *messageP;
+    uint8_t result;
+
+    result = schcDecompress(contextP, peerP, buffer, bufferLength, &messageP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Message decompression failed with error %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+        // ignore message
+        return;
+    }
+
+#if !defined(IOWA_COAP_BLOCK_SUPPORT) && !defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+    if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_1) != NULL)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Received message containing Block 1 option but IOWA_COAP_BLOCK_MINIMAL_SUPPORT is not defined.");
+
+        coapSendResponse(contextP, (iowa_coap_peer_t *)peerP, messageP, IOWA_COAP_402_BAD_OPTION);
+        iowa_coap_message_free(messageP);
+        return;
+    }
+    else if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_2) != NULL)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Received message containing Block 2 option but IOWA_COAP_BLOCK_MINIMAL_SUPPORT is not defined.");
+
+        iowa_coap_message_free(messageP);
+        return;
+    }
+#endif
+
+    transactionHandleMessage(contextP, peerP, messageP, false, 0);
+
+    iowa_coap_message_free(messageP);
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+uint8_t messageSendLoRaWAN(iowa_context_t contextP,
+                           iowa_coap_peer_t *peerBaseP,
+                           iowa_coap_message_t *messageP,
+                           coap_message_callback_t resultCallback,
+                           void *userData)
+{
+    // WARNING: This function is called in a critical section
+    coap_peer_datagram_t *peerP;
+    size_t bufferLength;
+    uint8_t *buffer;
+    uint8_t result;
+    bool queued;
+
+    IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering");
+
+    peerP = (coap_peer_datagram_t *)peerBaseP;
+
+    bufferLength = schcCompress(peerP, messageP, &buffer);
+    if (bufferLength == 0)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Exit on error: compression failed.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+    if (bufferLength > peerP->schcFrameSize)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Compressed message of %u bytes does not fit in a LoRaWAN frame of %u bytes.", bufferLength, peerP->schcFrameSize);
+        iowa_system_free(buffer);
+        return IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+    }
+
+    // Confirmable messages exceeding NSTART are sent when an outstanding transaction completes
+    queued = messageP->type == IOWA_COAP_TYPE_CONFIRMABLE
+             && transactionCanStart(peerP) == false;
+    if (queued == true)
+    {
+        result = IOWA_COAP_NO_ERROR;
+    }
+    else
+    {
+        result = prv_getSendResult(peerSendBuffer(contextP, peerBaseP, buffer, bufferLength), bufferLength);
+    }
+
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = transactionNew(contextP, peerP, messageP->type, messageP->id, buffer, bufferLength, queued, resultCallback, userData);
+        if (result == IOWA_COAP_201_CREATED)
+        {
+            buffer = NULL;
+            result = IOWA_COAP_NO_ERROR;
+        }
+    }
+
+    iowa_system_free(buffer);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Exiting with result %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+
+    return result;
+}
+
+void lorawanSecurityEventCb(iowa_security_session_t securityS,
+                            iowa_security_event_t event,
+                            void *userData,
+                            iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+
+    coap_peer_datagram_t *peerP;
+
+    (void)securityS;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "PeerP: %p, event: %s.", userData, STR_SECURITY_EVENT(event));
+
+    peerP = (coap_peer_datagram_t *)userData;
+
+    switch (event)
+    {
+    case SECURITY_EVENT_CONNECTED:
+        // Propagate the signal to the upper layer
+        PEER_CALL_EVENT_CALLBACK(contextP, peerP, COAP_EVENT_CONNECTED);
+        break;
+
+    case SECURITY_EVENT_DISCONNECTED:
+        // Propagate the signal to the upper layer
+        PEER_CALL_EVENT_CALLBACK(contextP, peerP, COAP_EVENT_DISCONNECTED);
+        break;
+
+    case SECURITY_EVENT_DATA_AVAILABLE:
+    {
+        // One more byte to detect the frames longer than the largest LoRaWAN payload
+        uint8_t buffer[COAP_LORAWAN_MAX_FRAME_SIZE + 1];
+        int dataLength;
+
+        dataLength = peerRecvBuffer(contextP, (iowa_coap_peer_t *)peerP, buffer, sizeof(buffer));
+        if (dataLength > COAP_LORAWAN_MAX_FRAME_SIZE)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Dropping a frame of more than %u bytes.", COAP_LORAWAN_MAX_FRAME_SIZE);
+        }
+        else if (dataLength > 0)
+        {
+            prv_handleFrame(contextP, peerP, buffer, (size_t)dataLength);
+        }
+    }
+    break;
+
+    default:
+        // Should not happen
+        break;
+    }
+}
+
+#endif // IOWA_LORAWAN_SUPPORT
@@ -0,0 +1,1284 @@
+/**********************************************
+*
+*  _________ _________ ___________ _________
+* |         |         |   |   |   |         |
+* |_________|         |   |   |   |    _    |
+* |         |    |    |   |   |   |         |
+* |         |    |    |           |         |
+* |         |    |    |           |    |    |
+* |         |         |           |    |    |
+* |_________|_________|___________|____|____|
+*
+* Copyright (c) 2016-2020 IoTerop.
+* All rights reserved.
+*
+* This program and the accompanying materials
+* are made available under the terms of
+* IoTerop’s IOWA License (LICENSE.TXT) which
+* accompany this distribution.
+*
+*
+**********************************************/
+
+/*************************************************************************************
+* Static Context Header Compression of CoAP messages (RFC 8724 and RFC 8824).
+*
+* A compressed packet is made of the RuleID on one byte, the residues of the fields
+* packed on bits, the payload and padding bits up to the next byte. RuleID 0 carries
+* the uncompressed CoAP message.
+*
+* The rules are static, split in uplink (device to network) and downlink rules, and
+* match exactly the fields and options of a message, in the order of the option numbers.
+* The Object ID of the first Uri-Path segment is sent as its index in the list of
+* the Objects registered by the device, as set by coapPeerApplyObjectList().
+*
+* The short Message IDs and the short tokens generated on LoRaWAN peers are sent
+* on 4 bits, so that a notification fits in the 11 bytes of the smallest data rates.
+* The other Message IDs generated on LoRaWAN peers are sent on 8 bits, and the ones
+* generated by the Server on 16 bits.
+*************************************************************************************/
+
+#include "iowa_prv_coap_internals.h"
+#include <stdbool.h>
+
+#ifdef IOWA_LORAWAN_SUPPORT
+
+#define PRV_RULE_ID_NO_COMPRESSION 0
+
+#define PRV_DIRECTION_UP   0 // from the device to the network
+#define PRV_DIRECTION_DOWN 1 // from the network to the device
+
+// Field identifiers of the CoAP header. The options are identified by their number.
+#define PRV_FID_TYPE  (uint16_t)0xFF01
+#define PRV_FID_CODE  (uint16_t)0xFF02
+#define PRV_FID_MID   (uint16_t)0xFF03
+#define PRV_FID_TOKEN (uint16_t)0xFF04
+
+// Matching operator and Compression/Decompression Action of a field.
+#define PRV_ACTION_EQUAL   0 // MO equal, CDA not-sent
+#define PRV_ACTION_VALUE   1 // MO ignore, CDA value-sent
+#define PRV_ACTION_LSB     2 // MO MSB, CDA LSB
+#define PRV_ACTION_MAPPING 3 // MO match-mapping, CDA mapping-sent
+#define PRV_ACTION_OBJECT  4 // Uri-Path segment holding an Object ID, sent as its index in the Object list of the peer
+#define PRV_ACTION_ID      5 // Uri-Path segment holding an Instance or Resource ID, sent on 4 or 16 bits
+#define PRV_ACTION_TOKEN   6 // MO MSB, CDA LSB for the short tokens, value-sent for the others
+#define PRV_ACTION_MID     7 // MO MSB, CDA LSB for the short Message IDs, value-sent on 8 or 16 bits for the others
+
+// Variable-length residues start with their length in bytes on 4 bits, extended by 8 bits when 15.
+#define PRV_LENGTH_BITS      4
+#define PRV_LENGTH_EXTENDED  15
+#define PRV_LENGTH_MAX       255
+
+// Instance and Resource IDs below 16 are sent on 4 bits after a 0 bit, others on 16 bits after a 1 bit.
+#define PRV_ID_SHORT_BITS 4
+#define PRV_ID_LONG_BITS  16
+#define PRV_ID_MAX_LENGTH 5 // strlen("65535")
+
+// Short tokens are sent on 4 bits after a 0 bit, others with their length after a 1 bit.
+#define PRV_TOKEN_LSB_BITS 4 // matches COAP_LORAWAN_TOKEN_MASK
+
+// Short Message IDs are sent on 4 bits after a 0 bit, others on 8 bits after 10, or on 16 bits after 11.
+#define PRV_MID_LSB_BITS  4  // matches COAP_LORAWAN_SHORT_MID_MAX
+#define PRV_MID_BYTE_BITS 8  // matches COAP_LORAWAN_LONG_MID_MAX
+#define PRV_MID_FULL_BITS 16
+
+typedef struct
+{
+    const uint32_t *valueArray;
+    uint8_t         count;
+} prv_mapping_t;
+
+typedef struct
+{
+    uint16_t             fid;
+    uint8_t              action;
+    uint8_t              length;   // PRV_ACTION_VALUE: size in bits of a fixed-length value or 0. PRV_ACTION_LSB: size in bits of the residue.
+    uint32_t             tv;       // target value of integer fields
+    const char          *tvString; // target value of the other fields
+    const prv_mapping_t *mappingP;
+} prv_field_t;
+
+typedef struct
+{
+    uint8_t            ruleId;
+    uint8_t            direction;
+    uint8_t            fieldCount;
+    const prv_field_t *fieldArray;
+} prv_rule_t;
+
+typedef struct
+{
+    bool           isInteger;
+    uint32_t       integer;
+    const uint8_t *data;
+    size_t         length;
+} prv_value_t;
+
+typedef struct
+{
+    uint8_t *buffer;     // nil to only count the bits
+    size_t   bitOffset;
+} prv_bit_writer_t;
+
+typedef struct
+{
+    const uint8_t *buffer;
+    size_t         bitLength;
+    size_t         bitOffset;
+} prv_bit_reader_t;
+
+/*************************************************************************************
+** Static context
+*************************************************************************************/
+
+static const uint32_t prv_requestCodeArray[] =
+{
+    IOWA_COAP_CODE_GET,
+    IOWA_COAP_CODE_POST,
+    IOWA_COAP_CODE_PUT,
+    IOWA_COAP_CODE_DELETE,
+    IOWA_COAP_CODE_FETCH,
+    IOWA_COAP_CODE_PATCH,
+    IOWA_COAP_CODE_IPATCH
+};
+
+static const uint32_t prv_responseCodeArray[] =
+{
+    IOWA_COAP_CODE_EMPTY,
+    IOWA_COAP_201_CREATED,
+    IOWA_COAP_202_DELETED,
+    IOWA_COAP_203_VALID,
+    IOWA_COAP_204_CHANGED,
+    IOWA_COAP_205_CONTENT,
+    IOWA_COAP_231_CONTINUE,
+    IOWA_COAP_400_BAD_REQUEST,
+    IOWA_COAP_401_UNAUTHORIZED,
+    IOWA_COAP_402_BAD_OPTION,
+    IOWA_COAP_404_NOT_FOUND,
+    IOWA_COAP_405_METHOD_NOT_ALLOWED,
+    IOWA_COAP_406_NOT_ACCEPTABLE,
+    IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE,
+    IOWA_COAP_500_INTERNAL_SERVER_ERROR,
+    IOWA_COAP_503_SERVICE_UNAVAILABLE
+};
+
+static const uint32_t prv_formatArray[] =
+{
+    IOWA_CONTENT_FORMAT_TLV,
+    IOWA_CONTENT_FORMAT_LWM2M_CBOR,
+    IOWA_CONTENT_FORMAT_SENML_CBOR,
+    IOWA_CONTENT_FORMAT_SENML_JSON,
+    IOWA_CONTENT_FORMAT_JSON,
+    IOWA_CONTENT_FORMAT_OPAQUE,
+    IOWA_CONTENT_FORMAT_TEXT,
+    IOWA_CONTENT_FORMAT_CORE_LINK
+};
+
+static const prv_mapping_t prv_requestCodeMapping = { prv_requestCodeArray, sizeof(prv_requestCodeArray) / sizeof(uint32_t) };
+static const prv_mapping_t prv_responseCodeMapping = { prv_responseCodeArray, sizeof(prv_responseCodeArray) / sizeof(uint32_t) };
+static const prv_mapping_t prv_formatMapping = { prv_formatArray, sizeof(prv_formatArray) / sizeof(uint32_t) };
+
+#define PRV_FIELD_EQUAL(F, S)   { (F), PRV_ACTION_EQUAL, 0, 0, (S), NULL }
+#define PRV_FIELD_VALUE(F, L)   { (F), PRV_ACTION_VALUE, (L), 0, NULL, NULL }
+#define PRV_FIELD_LSB(F, L, TV) { (F), PRV_ACTION_LSB, (L), (TV), NULL, NULL }
+#define PRV_FIELD_MAPPING(F, M) { (F), PRV_ACTION_MAPPING, 0, 0, NULL, &(M) }
+#define PRV_FIELD_OBJECT        { IOWA_COAP_OPTION_URI_PATH, PRV_ACTION_OBJECT, 0, 0, NULL, NULL }
+#define PRV_FIELD_ID            { IOWA_COAP_OPTION_URI_PATH, PRV_ACTION_ID, 0, 0, NULL, NULL }
+#define PRV_FIELD_TOKEN         { PRV_FID_TOKEN, PRV_ACTION_TOKEN, 0, 0, NULL, NULL }
+#define PRV_FIELD_MID           { PRV_FID_MID, PRV_ACTION_MID, 0, 0, NULL, NULL }
+
+#define PRV_HEADER(M) PRV_FIELD_VALUE(PRV_FID_TYPE, 2),   \
+                      PRV_FIELD_MAPPING(PRV_FID_CODE, M), \
+                      PRV_FIELD_MID,                      \
+                      PRV_FIELD_TOKEN
+
+#define PRV_REQUEST  PRV_HEADER(prv_requestCodeMapping)
+#define PRV_RESPONSE PRV_HEADER(prv_responseCodeMapping)
+
+#define PRV_OBSERVE     PRV_FIELD_VALUE(IOWA_COAP_OPTION_OBSERVE, 0)
+#define PRV_FORMAT      PRV_FIELD_MAPPING(IOWA_COAP_OPTION_CONTENT_FORMAT, prv_formatMapping)
+#define PRV_ACCEPT      PRV_FIELD_MAPPING(IOWA_COAP_OPTION_ACCEPT, prv_formatMapping)
+#define PRV_QUERY       PRV_FIELD_VALUE(IOWA_COAP_OPTION_URI_QUERY, 0)
+#define PRV_BLOCK_1     PRV_FIELD_VALUE(IOWA_COAP_OPTION_BLOCK_1, 0)
+#define PRV_BLOCK_2     PRV_FIELD_VALUE(IOWA_COAP_OPTION_BLOCK_2, 0)
+#define PRV_SIZE_2      PRV_FIELD_VALUE(IOWA_COAP_OPTION_SIZE_2, 0)
+#define PRV_RD          PRV_FIELD_EQUAL(IOWA_COAP_OPTION_URI_PATH, "rd")
+#define PRV_LOCATION    PRV_FIELD_VALUE(IOWA_COAP_OPTION_URI_PATH, 0)
+#define PRV_OBJECT      PRV_FIELD_OBJECT
+#define PRV_INSTANCE    PRV_FIELD_ID
+#define PRV_RESOURCE    PRV_FIELD_ID
+
+// Uplink: notifications, responses and registration requests
+static const prv_field_t prv_notificationFields[] = { PRV_RESPONSE, PRV_OBSERVE, PRV_FORMAT };
+static const prv_field_t prv_contentFields[] = { PRV_RESPONSE, PRV_FORMAT };
+static const prv_field_t prv_responseFields[] = { PRV_RESPONSE };
+static const prv_field_t prv_contentBlockFields[] = { PRV_RESPONSE, PRV_FORMAT, PRV_BLOCK_2 };
+static const prv_field_t prv_contentBlockSizeFields[] = { PRV_RESPONSE, PRV_FORMAT, PRV_BLOCK_2, PRV_SIZE_2 };
+static const prv_field_t prv_updateFields[] = { PRV_REQUEST, PRV_RD, PRV_LOCATION };
+static const prv_field_t prv_updateObjectsFields[] = { PRV_REQUEST, PRV_RD, PRV_LOCATION, PRV_FORMAT };
+static const prv_field_t prv_updateQueryFields[] = { PRV_REQUEST, PRV_RD, PRV_LOCATION, PRV_QUERY };
+static const prv_field_t prv_registerFields[] = { PRV_REQUEST, PRV_RD, PRV_FORMAT, PRV_QUERY, PRV_QUERY, PRV_QUERY, PRV_QUERY };
+static const prv_field_t prv_registerShortFields[] = { PRV_REQUEST, PRV_RD, PRV_FORMAT, PRV_QUERY, PRV_QUERY, PRV_QUERY };
+static const prv_field_t prv_registerBlockFields[] = { PRV_REQUEST, PRV_RD, PRV_FORMAT, PRV_QUERY, PRV_QUERY, PRV_QUERY, PRV_QUERY, PRV_BLOCK_1 };
+static const prv_field_t prv_sendFields[] = { PRV_REQUEST, PRV_FIELD_EQUAL(IOWA_COAP_OPTION_URI_PATH, "dp"), PRV_FORMAT };
+
+// Downlink: responses to the device requests and LwM2M operations
+static const prv_field_t prv_registeredFields[] = { PRV_RESPONSE, PRV_FIELD_EQUAL(IOWA_COAP_OPTION_LOCATION_PATH, "rd"), PRV_FIELD_VALUE(IOWA_COAP_OPTION_LOCATION_PATH, 0) };
+static const prv_field_t prv_continueFields[] = { PRV_RESPONSE, PRV_BLOCK_1 };
+static const prv_field_t prv_resourceFields[] = { PRV_REQUEST, PRV_OBJECT, PRV_INSTANCE, PRV_RESOURCE };
+static const prv_field_t prv_instanceFields[] = { PRV_REQUEST, PRV_OBJECT, PRV_INSTANCE };
+static const prv_field_t prv_objectFields[] = { PRV_REQUEST, PRV_OBJECT };
+static const prv_field_t prv_observeResourceFields[] = { PRV_REQUEST, PRV_OBSERVE, PRV_OBJECT, PRV_INSTANCE, PRV_RESOURCE };
+static const prv_field_t prv_observeInstanceFields[] = { PRV_REQUEST, PRV_OBSERVE, PRV_OBJECT, PRV_INSTANCE };
+static const prv_field_t prv_observeObjectFields[] = { PRV_REQUEST, PRV_OBSERVE, PRV_OBJECT };
+static const prv_field_t prv_writeResourceFields[] = { PRV_REQUEST, PRV_OBJECT, PRV_INSTANCE, PRV_RESOURCE, PRV_FORMAT };
+static const prv_field_t prv_writeInstanceFields[] = { PRV_REQUEST, PRV_OBJECT, PRV_INSTANCE, PRV_FORMAT };
+static const prv_field_t prv_createFields[] = { PRV_REQUEST, PRV_OBJECT, PRV_FORMAT };
+static const prv_field_t prv_readResourceFields[] = { PRV_REQUEST, PRV_OBJECT, PRV_INSTANCE, PRV_RESOURCE, PRV_ACCEPT };
+static const prv_field_t prv_readInstanceFields[] = { PRV_REQUEST, PRV_OBJECT, PRV_INSTANCE, PRV_ACCEPT };
+static const prv_field_t prv_readObjectFields[] = { PRV_REQUEST, PRV_OBJECT, PRV_ACCEPT };
+static const prv_field_t prv_observeReadResourceFields[] = { PRV_REQUEST, PRV_OBSERVE, PRV_OBJECT, PRV_INSTANCE, PRV_RESOURCE, PRV_ACCEPT };
+static const prv_field_t prv_observeReadInstanceFields[] = { PRV_REQUEST, PRV_OBSERVE, PRV_OBJECT, PRV_INSTANCE, PRV_ACCEPT };
+static const prv_field_t prv_attributesFields[] = { PRV_REQUEST, PRV_OBJECT, PRV_INSTANCE, PRV_RESOURCE, PRV_QUERY };
+static const prv_field_t prv_readBlockFields[] = { PRV_REQUEST, PRV_OBJECT, PRV_INSTANCE, PRV_RESOURCE, PRV_BLOCK_2 };
+static const prv_field_t prv_readInstanceBlockFields[] = { PRV_REQUEST, PRV_OBJECT, PRV_INSTANCE, PRV_BLOCK_2 };
+static const prv_field_t prv_writeBlockFields[] = { PRV_REQUEST, PRV_OBJECT, PRV_INSTANCE, PRV_RESOURCE, PRV_FORMAT, PRV_BLOCK_1 };
+
+#define PRV_RULE(ID, D, F) { (ID), (D), sizeof(F) / sizeof(prv_field_t), (F) }
+
+// Ordered by decreasing frequency of use
+static const prv_rule_t prv_ruleArray[] =
+{
+    PRV_RULE(1, PRV_DIRECTION_UP, prv_notificationFields),
+    PRV_RULE(2, PRV_DIRECTION_UP, prv_contentFields),
+    PRV_RULE(3, PRV_DIRECTION_UP, prv_responseFields),
+    PRV_RULE(4, PRV_DIRECTION_UP, prv_contentBlockFields),
+    PRV_RULE(32, PRV_DIRECTION_UP, prv_contentBlockSizeFields),
+    PRV_RULE(5, PRV_DIRECTION_UP, prv_updateFields),
+    PRV_RULE(6, PRV_DIRECTION_UP, prv_updateObjectsFields),
+    PRV_RULE(7, PRV_DIRECTION_UP, prv_updateQueryFields),
+    PRV_RULE(8, PRV_DIRECTION_UP, prv_registerFields),
+    PRV_RULE(9, PRV_DIRECTION_UP, prv_registerShortFields),
+    PRV_RULE(10, PRV_DIRECTION_UP, prv_registerBlockFields),
+    PRV_RULE(11, PRV_DIRECTION_UP, prv_sendFields),
+
+    PRV_RULE(12, PRV_DIRECTION_DOWN, prv_responseFields),
+    PRV_RULE(13, PRV_DIRECTION_DOWN, prv_registeredFields),
+    PRV_RULE(14, PRV_DIRECTION_DOWN, prv_continueFields),
+    PRV_RULE(15, PRV_DIRECTION_DOWN, prv_resourceFields),
+    PRV_RULE(16, PRV_DIRECTION_DOWN, prv_instanceFields),
+    PRV_RULE(17, PRV_DIRECTION_DOWN, prv_objectFields),
+    PRV_RULE(18, PRV_DIRECTION_DOWN, prv_observeResourceFields),
+    PRV_RULE(19, PRV_DIRECTION_DOWN, prv_observeInstanceFields),
+    PRV_RULE(20, PRV_DIRECTION_DOWN, prv_observeObjectFields),
+    PRV_RULE(21, PRV_DIRECTION_DOWN, prv_writeResourceFields),
+    PRV_RULE(22, PRV_DIRECTION_DOWN, prv_writeInstanceFields),
+    PRV_RULE(23, PRV_DIRECTION_DOWN, prv_createFields),
+    PRV_RULE(24, PRV_DIRECTION_DOWN, prv_readResourceFields),
+    PRV_RULE(25, PRV_DIRECTION_DOWN, prv_readInstanceFields),
+    PRV_RULE(26, PRV_DIRECTION_DOWN, prv_readObjectFields),
+    PRV_RULE(27, PRV_DIRECTION_DOWN, prv_observeReadResourceFields),
+    PRV_RULE(28, PRV_DIRECTION_DOWN, prv_observeReadInstanceFields),
+    PRV_RULE(29, PRV_DIRECTION_DOWN, prv_attributesFields),
+    PRV_RULE(30, PRV_DIRECTION_DOWN, prv_readBlockFields),
+    PRV_RULE(33, PRV_DIRECTION_DOWN, prv_readInstanceBlockFields),
+    PRV_RULE(31, PRV_DIRECTION_DOWN, prv_writeBlockFields)
+};
+
+#define PRV_RULE_COUNT (sizeof(prv_ruleArray) / sizeof(prv_rule_t))
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Get the number of bits needed to send an index.
+// Returned value: the number of bits.
+// Parameters:
+// - count: the number of possible values of the index.
+static uint8_t prv_getIndexLength(size_t count)
+{
+    uint8_t length;
+
+    length = 0;
+    while (((size_t)1 << length) < count)
+    {
+        length++;
+    }
+
+    return length;
+}
+
+static void prv_writeBits(prv_bit_writer_t *writerP,
+                          uint32_t value,
+                          uint8_t bitCount)
+{
+    while (bitCount > 0)
+    {
+        bitCount--;
+        if (writerP->buffer != NULL
+            && ((value >> bitCount) & 0x01) != 0)
+        {
+            writerP->buffer[writerP->bitOffset >> 3] |= (uint8_t)(0x80 >> (writerP->bitOffset & 0x07));
+        }
+        writerP->bitOffset++;
+    }
+}
+
+static void prv_writeBytes(prv_bit_writer_t *writerP,
+                           const uint8_t *data,
+                           size_t length)
+{
+    if (writerP->buffer != NULL
+        && length != 0)
+    {
+        size_t index;
+        uint8_t shift;
+
+        index = writerP->bitOffset >> 3;
+        shift = (uint8_t)(writerP->bitOffset & 0x07);
+
+        if (shift == 0)
+        {
+            memcpy(writerP->buffer + index, data, length);
+        }
+        else
+        {
+            size_t i;
+
+            // The buffer was zeroed and its size covers the last shifted bits
+            for (i = 0; i < length; i++)
+            {
+                writerP->buffer[index + i] |= (uint8_t)(data[i] >> shift);
+                writerP->buffer[index + i + 1] = (uint8_t)(data[i] << (8 - shift));
+            }
+        }
+    }
+
+    writerP->bitOffset += 8 * length;
+}
+
+static bool prv_readBits(prv_bit_reader_t *readerP,
+                         uint8_t bitCount,
+                         uint32_t *valueP)
+{
+    if (readerP->bitLength - readerP->bitOffset < bitCount)
+    {
+        return false;
+    }
+
+    *valueP = 0;
+    while (bitCount > 0)
+    {
+        *valueP = (*valueP << 1) | ((readerP->buffer[readerP->bitOffset >> 3] >> (7 - (readerP->bitOffset & 0x07))) & 0x01);
+        readerP->bitOffset++;
+        bitCount--;
+    }
+
+    return true;
+}
+
+static bool prv_readBytes(prv_bit_reader_t *readerP,
+                          uint8_t *data,
+                          size_t length)
+{
+    size_t index;
+    uint8_t shift;
+
+    if ((readerP->bitLength - readerP->bitOffset) / 8 < length)
+    {
+        return false;
+    }
+
+    index = readerP->bitOffset >> 3;
+    shift = (uint8_t)(readerP->bitOffset & 0x07);
+
+    if (shift == 0)
+    {
+        memcpy(data, readerP->buffer + index, length);
+    }
+    else
+    {
+        size_t i;
+
+        for (i = 0; i < length; i++)
+        {
+            data[i] = (uint8_t)((readerP->buffer[index + i] << shift) | (readerP->buffer[index + i + 1] >> (8 - shift)));
+        }
+    }
+
+    readerP->bitOffset += 8 * length;
+
+    return true;
+}
+
+static bool prv_writeVariable(prv_bit_writer_t *writerP,
+                              const uint8_t *data,
+                              size_t length)
+{
+    if (length > PRV_LENGTH_MAX)
+    {
+        return false;
+    }
+
+    if (length < PRV_LENGTH_EXTENDED)
+    {
+        prv_writeBits(writerP, (uint32_t)length, PRV_LENGTH_BITS);
+    }
+    else
+    {
+        prv_writeBits(writerP, PRV_LENGTH_EXTENDED, PRV_LENGTH_BITS);
+        prv_writeBits(writerP, (uint32_t)length, 8);
+    }
+    prv_writeBytes(writerP, data, length);
+
+    return true;
+}
+
+static bool prv_readLength(prv_bit_reader_t *readerP,
+                           size_t *lengthP)
+{
+    uint32_t value;
+
+    if (prv_readBits(readerP, PRV_LENGTH_BITS, &value) == false)
+    {
+        return false;
+    }
+    if (value == PRV_LENGTH_EXTENDED)
+    {
+        if (prv_readBits(readerP, 8, &value) == false)
+        {
+            return false;
+        }
+    }
+    *lengthP = (size_t)value;
+
+    return true;
+}
+
+// Parse an LwM2M ID from a Uri-Path segment.
+// Returned value: true if the segment is the shortest decimal representation of a 16-bit integer.
+// Parameters:
+// - valueP: the segment.
+// - idP: OUT. the ID.
+static bool prv_parseId(const prv_value_t *valueP,
+                        uint16_t *idP)
+{
+    size_t i;
+    uint32_t id;
+
+    if (valueP->length == 0
+        || valueP->length > PRV_ID_MAX_LENGTH
+        || (valueP->length > 1 && valueP->data[0] == '0'))
+    {
+        return false;
+    }
+
+    id = 0;
+    for (i = 0; i < valueP->length; i++)
+    {
+        if (valueP->data[i] < '0'
+            || valueP->data[i] > '9')
+        {
+            return false;
+        }
+        id = id * 10 + (uint32_t)(valueP->data[i] - '0');
+    }
+    if (id > UINT16_MAX)
+    {
+        return false;
+    }
+
+    *idP = (uint16_t)id;
+
+    return true;
+}
+
+// Write an LwM2M ID as a Uri-Path segment.
+// Returned value: the length of the segment.
+// Parameters:
+// - id: the ID.
+// - data: to store the segment. At least PRV_ID_MAX_LENGTH bytes long.
+static size_t prv_writeId(uint16_t id,
+                          uint8_t *data)
+{
+    size_t length;
+    size_t i;
+    uint16_t value;
+
+    length = 0;
+    value = id;
+    do
+    {
+        length++;
+        value /= 10;
+    } while (value != 0);
+
+    for (i = length; i > 0; i--)
+    {
+        data[i - 1] = (uint8_t)('0' + id % 10);
+        id /= 10;
+    }
+
+    return length;
+}
+
+static bool prv_findObject(coap_peer_datagram_t *peerP,
+                           uint16_t objectId,
+                           uint16_t *indexP)
+{
+    size_t low;
+    size_t high;
+
+    low = 0;
+    high = peerP->schcObjectCount;
+    while (low < high)
+    {
+        size_t middle;
+
+        middle = (low + high) / 2;
+        if (peerP->schcObjectArray[middle] == objectId)
+        {
+            *indexP = (uint16_t)middle;
+            return true;
+        }
+        if (peerP->schcObjectArray[middle] < objectId)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return false;
+}
+
+// Get the value of a field of a message.
+// Returned value: false if the message does not have this field.
+// Parameters:
+// - messageP: the CoAP message.
+// - fid: the field identifier.
+// - optionPP: IN/OUT. the next option of the message to match.
+// - valueP: OUT. the value of the field.
+static bool prv_getValue(iowa_coap_message_t *messageP,
+                         uint16_t fid,
+                         iowa_coap_option_t **optionPP,
+                         prv_value_t *valueP)
+{
+    memset(valueP, 0, sizeof(prv_value_t));
+
+    switch (fid)
+    {
+    case PRV_FID_TYPE:
+        valueP->isInteger = true;
+        valueP->integer = messageP->type;
+        break;
+
+    case PRV_FID_CODE:
+        valueP->isInteger = true;
+        valueP->integer = messageP->code;
+        break;
+
+    case PRV_FID_MID:
+        valueP->isInteger = true;
+        valueP->integer = messageP->id;
+        break;
+
+    case PRV_FID_TOKEN:
+        valueP->data = messageP->token;
+        valueP->length = messageP->tokenLength;
+        break;
+
+    default:
+        if (*optionPP == NULL
+            || (*optionPP)->number != fid)
+        {
+            return false;
+        }
+        if (iowa_coap_option_is_integer(*optionPP) == true)
+        {
+            valueP->isInteger = true;
+            valueP->integer = (*optionPP)->value.asInteger;
+        }
+        else
+        {
+            valueP->data = (*optionPP)->value.asBuffer;
+            valueP->length = (*optionPP)->length;
+        }
+        *optionPP = (*optionPP)->next;
+    }
+
+    return true;
+}
+
+static bool prv_compressField(coap_peer_datagram_t *peerP,
+                              const prv_field_t *fieldP,
+                              const prv_value_t *valueP,
+                              prv_bit_writer_t *writerP)
+{
+    switch (fieldP->action)
+    {
+    case PRV_ACTION_EQUAL:
+        if (valueP->isInteger == true)
+        {
+            return valueP->integer == fieldP->tv;
+        }
+        return valueP->length == strlen(fieldP->tvString)
+               && 0 == memcmp(valueP->data, fieldP->tvString, valueP->length);
+
+    case PRV_ACTION_VALUE:
+        if (fieldP->length != 0)
+        {
+            if ((valueP->integer >> fieldP->length) != 0)
+            {
+                return false;
+            }
+            prv_writeBits(writerP, valueP->integer, fieldP->length);
+        }
+        else if (valueP->isInteger == true)
+        {
+            uint8_t data[4];
+            size_t length;
+            uint32_t value;
+
+            // Integers are sent on the minimal number of bytes, as in CoAP options
+            length = 0;
+            for (value = valueP->integer; value != 0; value >>= 8)
+            {
+                length++;
+            }
+            for (value = 0; value < length; value++)
+            {
+                data[value] = (uint8_t)(valueP->integer >> (8 * (length - 1 - value)));
+            }
+            return prv_writeVariable(writerP, data, length);
+        }
+        else
+        {
+            return prv_writeVariable(writerP, valueP->data, valueP->length);
+        }
+        break;
+
+    case PRV_ACTION_LSB:
+        if ((valueP->integer >> fieldP->length) != (fieldP->tv >> fieldP->length))
+        {
+            return false;
+        }
+        prv_writeBits(writerP, valueP->integer, fieldP->length);
+        break;
+
+    case PRV_ACTION_MAPPING:
+    {
+        uint8_t index;
+
+        for (index = 0; index < fieldP->mappingP->count; index++)
+        {
+            if (fieldP->mappingP->valueArray[index] == valueP->integer)
+            {
+                prv_writeBits(writerP, index, prv_getIndexLength(fieldP->mappingP->count));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    case PRV_ACTION_OBJECT:
+    {
+        uint16_t id;
+        uint16_t index;
+
+        if (prv_parseId(valueP, &id) == false
+            || prv_findObject(peerP, id, &index) == false)
+        {
+            return false;
+        }
+        prv_writeBits(writerP, index, prv_getIndexLength(peerP->schcObjectCount));
+        break;
+    }
+
+    case PRV_ACTION_ID:
+    {
+        uint16_t id;
+
+        if (prv_parseId(valueP, &id) == false)
+        {
+            return false;
+        }
+        if (id < (1 << PRV_ID_SHORT_BITS))
+        {
+            prv_writeBits(writerP, 0, 1);
+            prv_writeBits(writerP, id, PRV_ID_SHORT_BITS);
+        }
+        else
+        {
+            prv_writeBits(writerP, 1, 1);
+            prv_writeBits(writerP, id, PRV_ID_LONG_BITS);
+        }
+        break;
+    }
+
+    case PRV_ACTION_MID:
+        if (valueP->integer <= COAP_LORAWAN_SHORT_MID_MAX)
+        {
+            prv_writeBits(writerP, 0, 1);
+            prv_writeBits(writerP, valueP->integer, PRV_MID_LSB_BITS);
+        }
+        else if (valueP->integer <= COAP_LORAWAN_LONG_MID_MAX)
+        {
+            prv_writeBits(writerP, 2, 2);
+            prv_writeBits(writerP, valueP->integer, PRV_MID_BYTE_BITS);
+        }
+        else
+        {
+            prv_writeBits(writerP, 3, 2);
+            prv_writeBits(writerP, valueP->integer, PRV_MID_FULL_BITS);
+        }
+        break;
+
+    case PRV_ACTION_TOKEN:
+        if (valueP->length == COAP_LORAWAN_TOKEN_LEN
+            && (valueP->data[0] >> PRV_TOKEN_LSB_BITS) == 0)
+        {
+            prv_writeBits(writerP, 0, 1);
+            prv_writeBits(writerP, valueP->data[0], PRV_TOKEN_LSB_BITS);
+        }
+        else
+        {
+            prv_writeBits(writerP, 1, 1);
+            return prv_writeVariable(writerP, valueP->data, valueP->length);
+        }
+        break;
+
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+// Apply a rule to a message.
+// Returned value: true if the rule matches the message.
+// Parameters:
+// - peerP: the peer the message is sent to.
+// - ruleP: the rule.
+// - messageP: the CoAP message.
+// - writerP: to write the RuleID, the residues and the payload.
+static bool prv_compressRule(coap_peer_datagram_t *peerP,
+                             const prv_rule_t *ruleP,
+                             iowa_coap_message_t *messageP,
+                             prv_bit_writer_t *writerP)
+{
+    iowa_coap_option_t *optionP;
+    uint8_t i;
+
+    prv_writeBits(writerP, ruleP->ruleId, 8);
+
+    optionP = messageP->optionList;
+    for (i = 0; i < ruleP->fieldCount; i++)
+    {
+        prv_value_t value;
+
+        if (prv_getValue(messageP, ruleP->fieldArray[i].fid, &optionP, &value) == false
+            || prv_compressField(peerP, ruleP->fieldArray + i, &value, writerP) == false)
+        {
+            return false;
+        }
+    }
+    if (optionP != NULL)
+    {
+        // The message has more options than the rule
+        return false;
+    }
+
+    prv_writeBytes(writerP, messageP->payload.data, messageP->payload.length);
+
+    return true;
+}
+
+static size_t prv_compressNone(iowa_coap_message_t *messageP,
+                               uint8_t **bufferP)
+{
+    uint8_t *datagram;
+    size_t length;
+
+    length = coapMessageSerializeDatagram(messageP, &datagram);
+    if (length == 0)
+    {
+        return 0;
+    }
+
+    *bufferP = (uint8_t *)iowa_system_malloc(length + 1);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(length + 1);
+        iowa_system_free(datagram);
+        return 0;
+    }
+#endif
+    (*bufferP)[0] = PRV_RULE_ID_NO_COMPRESSION;
+    memcpy(*bufferP + 1, datagram, length);
+    iowa_system_free(datagram);
+
+    return length + 1;
+}
+
+// Allocate memory released with the message.
+// Returned value: the memory or NULL in case of error.
+// Parameters:
+// - messageP: the CoAP message.
+// - length: the size of the memory.
+static uint8_t *prv_messageAllocate(iowa_coap_message_t *messageP,
+                                    size_t length)
+{
+    iowa_linked_buffer_t *bufferP;
+
+    bufferP = (iowa_linked_buffer_t *)iowa_system_malloc(sizeof(iowa_linked_buffer_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(iowa_linked_buffer_t));
+        return NULL;
+    }
+#endif
+    bufferP->data = (uint8_t *)iowa_system_malloc(length);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (bufferP->data == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(length);
+        iowa_system_free(bufferP);
+        return NULL;
+    }
+#endif
+    bufferP->length = length;
+    bufferP->next = NULL;
+
+    messageP->userBufferList = (iowa_linked_buffer_t *)IOWA_UTILS_LIST_ADD(messageP->userBufferList, bufferP);
+
+    return bufferP->data;
+}
+
+// Rebuild a field of a message from its residue.
+// Returned value: true in case of success, false if the packet is malformed.
+// Parameters:
+// - peerP: the peer the packet was received from.
+// - fieldP: the field descriptor.
+// - isInteger: the kind of value of the field.
+// - readerP: to read the residue.
+// - valueP: OUT. the value of the field.
+// - dataPP: IN/OUT. where to store the field data, moved after it.
+static bool prv_decompressField(coap_peer_datagram_t *peerP,
+                                const prv_field_t *fieldP,
+                                bool isInteger,
+                                prv_bit_reader_t *readerP,
+                                prv_value_t *valueP,
+                                uint8_t **dataPP)
+{
+    uint32_t residue;
+    uint8_t bitCount;
+
+    memset(valueP, 0, sizeof(prv_value_t));
+    valueP->isInteger = isInteger;
+
+    switch (fieldP->action)
+    {
+    case PRV_ACTION_EQUAL:
+        if (isInteger == true)
+        {
+            valueP->integer = fieldP->tv;
+        }
+        else
+        {
+            valueP->data = (const uint8_t *)fieldP->tvString;
+            valueP->length = strlen(fieldP->tvString);
+        }
+        break;
+
+    case PRV_ACTION_VALUE:
+        if (fieldP->length != 0)
+        {
+            return prv_readBits(readerP, fieldP->length, &(valueP->integer));
+        }
+        if (prv_readLength(readerP, &(valueP->length)) == false)
+        {
+            return false;
+        }
+        if (isInteger == true)
+        {
+            size_t i;
+
+            if (valueP->length > 4)
+            {
+                return false;
+            }
+            for (i = 0; i < valueP->length; i++)
+            {
+                if (prv_readBits(readerP, 8, &residue) == false)
+                {
+                    return false;
+                }
+                valueP->integer = (valueP->integer << 8) | residue;
+            }
+            valueP->length = 0;
+        }
+        else
+        {
+            if (prv_readBytes(readerP, *dataPP, valueP->length) == false)
+            {
+                return false;
+            }
+            valueP->data = *dataPP;
+            *dataPP += valueP->length;
+        }
+        break;
+
+    case PRV_ACTION_LSB:
+        if (prv_readBits(readerP, fieldP->length, &residue) == false)
+        {
+            return false;
+        }
+        valueP->integer = ((fieldP->tv >> fieldP->length) << fieldP->length) | residue;
+        break;
+
+    case PRV_ACTION_MAPPING:
+        if (prv_readBits(readerP, prv_getIndexLength(fieldP->mappingP->count), &residue) == false
+            || residue >= fieldP->mappingP->count)
+        {
+            return false;
+        }
+        valueP->integer = fieldP->mappingP->valueArray[residue];
+        break;
+
+    case PRV_ACTION_OBJECT:
+        if (peerP->schcObjectCount == 0
+            || prv_readBits(readerP, prv_getIndexLength(peerP->schcObjectCount), &residue) == false
+            || residue >= peerP->schcObjectCount)
+        {
+            return false;
+        }
+        valueP->data = *dataPP;
+        valueP->length = prv_writeId(peerP->schcObjectArray[residue], *dataPP);
+        *dataPP += valueP->length;
+        break;
+
+    case PRV_ACTION_ID:
+        if (prv_readBits(readerP, 1, &residue) == false
+            || prv_readBits(readerP, residue == 0 ? PRV_ID_SHORT_BITS : PRV_ID_LONG_BITS, &residue) == false)
+        {
+            return false;
+        }
+        valueP->data = *dataPP;
+        valueP->length = prv_writeId((uint16_t)residue, *dataPP);
+        *dataPP += valueP->length;
+        break;
+
+    case PRV_ACTION_MID:
+        if (prv_readBits(readerP, 1, &residue) == false)
+        {
+            return false;
+        }
+        if (residue == 0)
+        {
+            bitCount = PRV_MID_LSB_BITS;
+        }
+        else
+        {
+            if (prv_readBits(readerP, 1, &residue) == false)
+            {
+                return false;
+            }
+            bitCount = residue == 0 ? PRV_MID_BYTE_BITS : PRV_MID_FULL_BITS;
+        }
+        if (prv_readBits(readerP, bitCount, &residue) == false)
+        {
+            return false;
+        }
+        valueP->integer = residue;
+        break;
+
+    case PRV_ACTION_TOKEN:
+        if (prv_readBits(readerP, 1, &residue) == false)
+        {
+            return false;
+        }
+        if (residue == 0)
+        {
+            if (prv_readBits(readerP, PRV_TOKEN_LSB_BITS, &residue) == false)
+            {
+                return false;
+            }
+            (*dataPP)[0] = (uint8_t)residue;
+            valueP->length = COAP_LORAWAN_TOKEN_LEN;
+        }
+        else if (prv_readLength(readerP, &(valueP->length)) == false
+                 || prv_readBytes(readerP, *dataPP, valueP->length) == false)
+        {
+            return false;
+        }
+        valueP->data = *dataPP;
+        *dataPP += valueP->length;
+        break;
+
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+static uint8_t prv_decompressRule(iowa_context_t contextP,
+                                  coap_peer_datagram_t *peerP,
+                                  const prv_rule_t *ruleP,
+                                  prv_bit_reader_t *readerP,
+                                  iowa_coap_message_t *messageP)
+{
+    uint8_t *data;
+    iowa_coap_option_t *lastP;
+    size_t optionCount;
+    size_t payloadLength;
+    uint8_t i;
+
+    // Variable-length values and the payload fit in the packet length, LwM2M IDs add a few bytes
+    data = prv_messageAllocate(messageP, readerP->bitLength / 8 + (size_t)ruleP->fieldCount * PRV_ID_MAX_LENGTH);
+    if (data == NULL)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    lastP = NULL;
+    optionCount = 0;
+    for (i = 0; i < ruleP->fieldCount; i++)
+    {
+        const prv_field_t *fieldP;
+        iowa_coap_option_t *optionP;
+        prv_value_t value;
+
+        fieldP = ruleP->fieldArray + i;
+
+        switch (fieldP->fid)
+        {
+        case PRV_FID_TYPE:
+        case PRV_FID_CODE:
+        case PRV_FID_MID:
+            optionP = NULL;
+            if (prv_decompressField(peerP, fieldP, true, readerP, &value, &data) == false)
+            {
+                return IOWA_COAP_400_BAD_REQUEST;
+            }
+            if (fieldP->fid == PRV_FID_TYPE)
+            {
+                messageP->type = (uint8_t)value.integer;
+            }
+            else if (fieldP->fid == PRV_FID_CODE)
+            {
+                messageP->code = (uint8_t)value.integer;
+            }
+            else
+            {
+                messageP->id = (uint16_t)value.integer;
+            }
+            break;
+
+        case PRV_FID_TOKEN:
+            optionP = NULL;
+            if (prv_decompressField(peerP, fieldP, false, readerP, &value, &data) == false
+                || value.length > COAP_MSG_TOKEN_MAX_LEN)
+            {
+                return IOWA_COAP_400_BAD_REQUEST;
+            }
+            messageP->tokenLength = (uint8_t)value.length;
+            memcpy(messageP->token, value.data, value.length);
+            break;
+
+        default:
+#if IOWA_COAP_INLINE_OPTION_COUNT > 0
+            if (optionCount < IOWA_COAP_INLINE_OPTION_COUNT)
+            {
+                optionP = messageP->optionArray + optionCount;
+                memset(optionP, 0, sizeof(iowa_coap_option_t));
+                optionP->number = fieldP->fid;
+            }
+            else
+#endif
+            {
+                optionP = iowa_coap_option_new(contextP, fieldP->fid);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+                if (optionP == NULL)
+                {
+                    IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP option.");
+                    return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+                }
+#endif
+            }
+
+            // The rule lists the options in ascending order
+            if (lastP == NULL)
+            {
+                messageP->optionList = optionP;
+            }
+            else
+            {
+                lastP->next = optionP;
+            }
+            lastP = optionP;
+            optionCount++;
+
+            if (prv_decompressField(peerP, fieldP, iowa_coap_option_is_integer(optionP), readerP, &value, &data) == false)
+            {
+                return IOWA_COAP_400_BAD_REQUEST;
+            }
+            if (value.isInteger == true)
+            {
+                optionP->value.asInteger = value.integer;
+            }
+            else
+            {
+                optionP->value.asBuffer = (uint8_t *)value.data;
+                optionP->length = (uint16_t)value.length;
+            }
+        }
+    }
+
+    // The remaining bits are the payload and less than a byte of padding
+    payloadLength = (readerP->bitLength - readerP->bitOffset) / 8;
+    if (payloadLength != 0)
+    {
+        if ((readerP->bitOffset & 0x07) == 0)
+        {
+            messageP->payload.data = (uint8_t *)readerP->buffer + (readerP->bitOffset >> 3);
+        }
+        else
+        {
+            (void)prv_readBytes(readerP, data, payloadLength);
+            messageP->payload.data = data;
+        }
+        messageP->payload.length = payloadLength;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+size_t schcCompress(coap_peer_datagram_t *peerP,
+                    iowa_coap_message_t *messageP,
+                    uint8_t **bufferP)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t direction;
+    size_t i;
+
+    direction = peerP->schcIsDevice == true ? PRV_DIRECTION_UP : PRV_DIRECTION_DOWN;
+
+    for (i = 0; i < PRV_RULE_COUNT; i++)
+    {
+        prv_bit_writer_t writer;
+        size_t length;
+
+        if (prv_ruleArray[i].direction != direction)
+        {
+            continue;
+        }
+
+        // First pass to match the rule and to compute the compressed length
+        writer.buffer = NULL;
+        writer.bitOffset = 0;
+        if (prv_compressRule(peerP, prv_ruleArray + i, messageP, &writer) == false)
+        {
+            continue;
+        }
+
+        length = (writer.bitOffset + 7) / 8;
+        writer.buffer = (uint8_t *)iowa_system_malloc(length);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (writer.buffer == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(length);
+            return 0;
+        }
+#endif
+        memset(writer.buffer, 0, length);
+        writer.bitOffset = 0;
+        (void)prv_compressRule(peerP, prv_ruleArray + i, messageP, &writer);
+
+        IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Compressed with rule %u to %u bytes.", prv_ruleArray[i].ruleId, length);
+
+        *bufferP = writer.buffer;
+        return length;
+    }
+
+    IOWA_LOG_TRACE(IOWA_PART_COAP, "No rule matches, sending the message uncompressed.");
+
+    return prv_compressNone(messageP, bufferP);
+}
+
+uint8_t schcDecompress(iowa_context_t contextP,
+                       coap_peer_datagram_t *peerP,
+                       uint8_t *buffer,
+                       size_t bufferLength,
+                       iowa_coap_message_t **messageP)
+{
+    // WARNING: This function is called in a critical section
+    prv_bit_reader_t reader;
+    uint8_t direction;
+    uint8_t result;
+    size_t i;
+
+    *messageP = NULL;
+
+    if (bufferLength == 0)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Received an empty SCHC packet.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    if (buffer[0] == PRV_RULE_ID_NO_COMPRESSION)
+    {
+        return messageDatagramParse(contextP, buffer + 1, bufferLength - 1, messageP);
+    }
+
+    direction = peerP->schcIsDevice == true ? PRV_DIRECTION_DOWN : PRV_DIRECTION_UP;
+
+    for (i = 0; i < PRV_RULE_COUNT; i++)
+    {
+        if (prv_ruleArray[i].ruleId == buffer[0]
+            && prv_ruleArray[i].direction == direction)
+        {
+            break;
+        }
+    }
+    if (i == PRV_RULE_COUNT)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Unknown SCHC rule %u.", buffer[0]);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    *messageP = (iowa_coap_message_t *)CORE_POOL_ALLOC(contextP, CORE_POOL_MESSAGE, sizeof(iowa_coap_message_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*messageP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(iowa_coap_message_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(*messageP, 0, sizeof(iowa_coap_message_t));
+
+    reader.buffer = buffer;
+    reader.bitLength = 8 * bufferLength;
+    reader.bitOffset = 8;
+
+    result = prv_decompressRule(contextP, peerP, prv_ruleArray + i, &reader, *messageP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Malformed SCHC packet with rule %u.", buffer[0]);
+        iowa_coap_message_free(*messageP);
+        *messageP = NULL;
+    }
+
+    return result;
+}
+
+#endif // IOWA_LORAWAN_SUPPORT
@@ -22,3 +22,1245 @@
 
 #include "iowa_prv_coap_internals.h"
 #include <stdbool.h>
+
+#if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
+
+// Signaling codes (RFC 8323 Section 5)
+#define PRV_SIGNAL_CSM     (uint8_t)0xE1 // 7.01
+#define PRV_SIGNAL_PING    (uint8_t)0xE2 // 7.02
+#define PRV_SIGNAL_PONG    (uint8_t)0xE3 // 7.03
+#define PRV_SIGNAL_RELEASE (uint8_t)0xE4 // 7.04
+#define PRV_SIGNAL_ABORT   (uint8_t)0xE5 // 7.05
+
+// Signaling options, their numbers depend on the signaling code
+#define PRV_OPTION_MAX_MESSAGE_SIZE    (uint16_t)2 // in CSM, integer value
+#define PRV_OPTION_BLOCK_WISE_TRANSFER (uint16_t)4 // in CSM, empty
+#define PRV_OPTION_BAD_CSM_OPTION      (uint16_t)2 // in Abort, integer value
+
+#define PRV_OPTION_IS_CRITICAL(N) (((N) & 0x01) != 0)
+
+#define PRV_TOKEN_LENGTH_MASK 0x0FU
+
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+// Size of the stack buffer holding the header, token and options of a message sent in segments
+#define PRV_HEADER_BUFFER_SIZE 64
+#endif
+
+#ifdef IOWA_WEBSOCKET_SUPPORT
+// The receive buffer also holds the header of the frame carrying the message
+#define PRV_RECV_BUFFER_SIZE (IOWA_COAP_STREAM_MAX_MESSAGE_SIZE + COAP_WS_FRAME_MAX_HEADER_LENGTH)
+// Header and longest token of a message carried by a frame
+#define PRV_WS_MESSAGE_MAX_HEADER_LENGTH (2 + COAP_MSG_TOKEN_MAX_LEN)
+#else
+#define PRV_RECV_BUFFER_SIZE IOWA_COAP_STREAM_MAX_MESSAGE_SIZE
+#endif
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Encode an integer value of a signaling option.
+// Returned value: the length of the encoded value.
+// Parameters:
+// - value: the value to encode.
+// - buffer: to store the value. Its length must be at least 4 bytes.
+static uint8_t prv_encodeUint(uint32_t value,
+                              uint8_t *buffer)
+{
+    uint8_t length;
+    uint8_t i;
+
+    length = 0;
+    while (length < sizeof(uint32_t)
+           && (value >> (8 * length)) != 0)
+    {
+        length++;
+    }
+
+    for (i = 0; i < length; i++)
+    {
+        buffer[i] = (uint8_t)((value >> (8 * (length - 1 - i))) & 0xFF);
+    }
+
+    return length;
+}
+
+// Decode an integer value of a signaling option.
+// Returned value: true in case of success, false if the value is too long.
+// Parameters:
+// - optionP: the option, decoded as opaque.
+// - valueP: OUT. the value.
+static bool prv_decodeUint(iowa_coap_option_t *optionP,
+                           uint32_t *valueP)
+{
+    uint16_t i;
+
+    if (optionP->length > sizeof(uint32_t))
+    {
+        return false;
+    }
+
+    *valueP = 0;
+    for (i = 0; i < optionP->length; i++)
+    {
+        *valueP = (*valueP << 8) | optionP->value.asBuffer[i];
+    }
+
+    return true;
+}
+
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+// Send a message as its header and its payload segments.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - header, headerLength: the serialized header, token, options and payload marker.
+// - messageP: the message.
+static uint8_t prv_sendSegments(iowa_context_t contextP,
+                                coap_peer_stream_t *peerP,
+                                uint8_t *header,
+                                size_t headerLength,
+                                iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_connection_segment_t segmentArray[2];
+    size_t segmentCount;
+    size_t sentLength;
+    int nbSent;
+
+    segmentArray[0].data = header;
+    segmentArray[0].length = headerLength;
+    segmentCount = 1;
+    if (messageP->payload.length != 0)
+    {
+        segmentArray[1].data = messageP->payload.data;
+        segmentArray[1].length = messageP->payload.length;
+        segmentCount = 2;
+    }
+
+    nbSent = peerSendSegments(contextP, (iowa_coap_peer_t *)peerP, segmentArray, segmentCount);
+    if (nbSent <= 0)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Communication error: %d.", nbSent);
+        return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+    }
+    sentLength = (size_t)nbSent;
+
+    // Send the rest if the connection accepted only a part of the message
+    if (sentLength < headerLength)
+    {
+        uint8_t result;
+
+        result = tcpSendBuffer(contextP, peerP, header + sentLength, headerLength - sentLength);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            return result;
+        }
+        sentLength = headerLength;
+    }
+
+    return tcpSendBuffer(contextP, peerP, messageP->payload.data + (sentLength - headerLength), messageP->payload.length - (sentLength - headerLength));
+}
+#endif // IOWA_CONNECTION_SENDV_SUPPORT
+
+// Send a signaling message.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - code: the signaling code.
+// - tokenLength, token: the token of the message.
+// - optionP: the option of the message. This can be nil.
+static uint8_t prv_sendSignal(iowa_context_t contextP,
+                              coap_peer_stream_t *peerP,
+                              uint8_t code,
+                              uint8_t tokenLength,
+                              const uint8_t *token,
+                              iowa_coap_option_t *optionP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_message_t message;
+
+    memset(&message, 0, sizeof(iowa_coap_message_t));
+    message.code = code;
+    message.tokenLength = tokenLength;
+    if (tokenLength > 0)
+    {
+        memcpy(message.token, token, tokenLength);
+    }
+    message.optionList = optionP;
+
+    COAP_LOG_MESSAGE("Sending", peerP->base.type, &message);
+
+    return messageSendTCP(contextP, (iowa_coap_peer_t *)peerP, &message);
+}
+
+// Close the connection with the peer.
+// The peer can be deleted when this function returns.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+static void prv_close(iowa_context_t contextP,
+                      coap_peer_stream_t *peerP)
+{
+    // WARNING: This function is called in a critical section
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Closing the connection with peer %p.", peerP);
+
+    tcpPeerClear(contextP, peerP);
+    coapPeerDisconnect(contextP, (iowa_coap_peer_t *)peerP);
+}
+
+// Abort the connection with the peer after a protocol error.
+// The peer can be deleted when this function returns.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - badOption: the unsupported option of the CSM of the peer, 0 if none.
+static void prv_abort(iowa_context_t contextP,
+                      coap_peer_stream_t *peerP,
+                      uint16_t badOption)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_option_t option;
+    uint8_t value[sizeof(uint32_t)];
+
+    IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Aborting the connection with peer %p.", peerP);
+
+#ifdef IOWA_WEBSOCKET_SUPPORT
+    if (peerP->base.type == IOWA_CONN_WEBSOCKET
+        && peerP->wsOpen == false)
+    {
+        // No message can be sent before the opening handshake
+        prv_close(contextP, peerP);
+        return;
+    }
+#endif
+
+    if (badOption != 0)
+    {
+        memset(&option, 0, sizeof(iowa_coap_option_t));
+        option.number = PRV_OPTION_BAD_CSM_OPTION;
+        option.length = prv_encodeUint(badOption, value);
+        option.value.asBuffer = value;
+
+        (void)prv_sendSignal(contextP, peerP, PRV_SIGNAL_ABORT, 0, NULL, &option);
+    }
+    else
+    {
+        (void)prv_sendSignal(contextP, peerP, PRV_SIGNAL_ABORT, 0, NULL, NULL);
+    }
+
+#ifdef IOWA_WEBSOCKET_SUPPORT
+    if (peerP->base.type == IOWA_CONN_WEBSOCKET)
+    {
+        uint8_t status[2];
+
+        status[0] = (uint8_t)(COAP_WS_CLOSE_PROTOCOL_ERROR >> 8);
+        status[1] = (uint8_t)(COAP_WS_CLOSE_PROTOCOL_ERROR & 0xFF);
+        (void)websocketSendControl(contextP, peerP, COAP_WS_OPCODE_CLOSE, status, sizeof(status));
+    }
+#endif
+
+    prv_close(contextP, peerP);
+}
+
+static void prv_timerCallback(iowa_context_t contextP,
+                              void *userData);
+
+// Arm the timer of the peer.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - delay: the delay in seconds.
+static uint8_t prv_timerSet(iowa_context_t contextP,
+                            coap_peer_stream_t *peerP,
+                            int32_t delay)
+{
+    // WARNING: This function is called in a critical section
+    peerP->received = false;
+
+    if (peerP->timerP != NULL)
+    {
+        return coreTimerReset(contextP, peerP->timerP, delay);
+    }
+
+    peerP->timerP = coreTimerNew(contextP, delay, prv_timerCallback, peerP);
+    if (peerP->timerP == NULL)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Arm the keepalive timer of the peer if it is enabled and not armed yet.
+// The timer is not reset on each received message: the callback checks if a message was received meanwhile.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+static void prv_keepaliveStart(iowa_context_t contextP,
+                               coap_peer_stream_t *peerP)
+{
+    // WARNING: This function is called in a critical section
+    if (peerP->state == COAP_STREAM_STATE_OK
+        && peerP->timerP == NULL
+        && peerP->pingInterval != 0)
+    {
+        (void)prv_timerSet(contextP, peerP, peerP->pingInterval > CORE_TIME_MAX_DELAY_SECONDS ? CORE_TIME_MAX_DELAY_SECONDS : (int32_t)peerP->pingInterval);
+    }
+}
+
+static void prv_timerCallback(iowa_context_t contextP,
+                              void *userData)
+{
+    // WARNING: This function is called in a critical section
+    coap_peer_stream_t *peerP;
+
+    peerP = (coap_peer_stream_t *)userData;
+
+    // The timer is freed when this function returns
+    peerP->timerP = NULL;
+
+    if (peerP->state != COAP_STREAM_STATE_OK)
+    {
+#ifdef IOWA_WEBSOCKET_SUPPORT
+        if (peerP->base.type == IOWA_CONN_WEBSOCKET
+            && peerP->wsOpen == false)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "No WebSocket opening handshake with peer %p.", peerP);
+        }
+        else
+#endif
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "No CSM received from peer %p.", peerP);
+        }
+        prv_abort(contextP, peerP, 0);
+        return;
+    }
+
+    if (peerP->received == true)
+    {
+        prv_keepaliveStart(contextP, peerP);
+        return;
+    }
+
+    if (peerP->pingSent == true)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "No response to the Ping sent to peer %p.", peerP);
+        prv_close(contextP, peerP);
+        return;
+    }
+
+    // The connection was idle for the ping interval
+    if (prv_sendSignal(contextP, peerP, PRV_SIGNAL_PING, 0, NULL, NULL) != IOWA_COAP_NO_ERROR
+        || prv_timerSet(contextP, peerP, COAP_TCP_MAX_TRANSMIT_WAIT) != IOWA_COAP_NO_ERROR)
+    {
+        prv_close(contextP, peerP);
+        return;
+    }
+    peerP->pingSent = true;
+}
+
+// Handle a received CSM.
+// The peer can be deleted when this function returns.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - messageP: the CSM.
+static void prv_handleCsm(iowa_context_t contextP,
+                          coap_peer_stream_t *peerP,
+                          iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_option_t *optionP;
+
+    for (optionP = messageP->optionList; optionP != NULL; optionP = optionP->next)
+    {
+        switch (optionP->number)
+        {
+        case PRV_OPTION_MAX_MESSAGE_SIZE:
+            if (prv_decodeUint(optionP, &peerP->maxMessageSize) == false)
+            {
+                prv_abort(contextP, peerP, optionP->number);
+                return;
+            }
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Peer %p Max-Message-Size is %u.", peerP, peerP->maxMessageSize);
+            break;
+
+        case PRV_OPTION_BLOCK_WISE_TRANSFER:
+#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+            // Our CSM indicates it too
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Peer %p supports BERT.", peerP);
+            peerP->bert = true;
+#endif
+            break;
+
+        default:
+            if (PRV_OPTION_IS_CRITICAL(optionP->number))
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Unknown critical CSM option %u.", optionP->number);
+                prv_abort(contextP, peerP, optionP->number);
+                return;
+            }
+            break;
+        }
+    }
+
+    switch (peerP->state)
+    {
+    case COAP_STREAM_STATE_OK:
+        // The peer updated its capabilities
+        return;
+
+    case COAP_STREAM_STATE_CSM_WAIT:
+        // The peer sent its CSM first
+        if (peerConnectTCP(contextP, peerP) != IOWA_COAP_NO_ERROR)
+        {
+            prv_close(contextP, peerP);
+            return;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "CSM exchange with peer %p done.", peerP);
+
+    peerP->state = COAP_STREAM_STATE_OK;
+    coreTimerDelete(contextP, peerP->timerP);
+    peerP->timerP = NULL;
+    prv_keepaliveStart(contextP, peerP);
+
+    // Propagate the signal to the upper layer
+    PEER_CALL_EVENT_CALLBACK(contextP, peerP, COAP_EVENT_CONNECTED);
+}
+
+// Handle a received message and free it.
+// The peer can be deleted or disconnected when this function returns.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer the message was received from.
+// - messageP: the message.
+// - truncated: true if the message was too large for the receive buffer. Only its header and token were decoded.
+static void prv_handleMessage(iowa_context_t contextP,
+                              coap_peer_stream_t *peerP,
+                              iowa_coap_message_t *messageP,
+                              bool truncated)
+{
+    // WARNING: This function is called in a critical section
+    if (peerP->state != COAP_STREAM_STATE_OK
+        && messageP->code != PRV_SIGNAL_CSM)
+    {
+        // The CSM must be the first message sent on the connection
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Peer %p did not start with a CSM.", peerP);
+        prv_abort(contextP, peerP, 0);
+    }
+    else if (COAP_IS_SIGNALING(messageP->code))
+    {
+        COAP_LOG_MESSAGE("Handling", peerP->base.type, messageP);
+
+        if (truncated == true)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Signaling message of peer %p is too large.", peerP);
+            prv_abort(contextP, peerP, 0);
+        }
+        else
+        {
+            switch (messageP->code)
+            {
+            case PRV_SIGNAL_CSM:
+                prv_handleCsm(contextP, peerP, messageP);
+                break;
+
+            case PRV_SIGNAL_PING:
+                (void)prv_sendSignal(contextP, peerP, PRV_SIGNAL_PONG, messageP->tokenLength, messageP->token, NULL);
+                break;
+
+            case PRV_SIGNAL_PONG:
+                // Any received message shows that the connection is alive
+                break;
+
+            case PRV_SIGNAL_RELEASE:
+            case PRV_SIGNAL_ABORT:
+                IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Peer %p is closing the connection.", peerP);
+                prv_close(contextP, peerP);
+                break;
+
+            default:
+                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Ignoring unknown signaling code %u.%02u.", messageP->code >> 5, messageP->code & 0x1F);
+                break;
+            }
+        }
+    }
+    else if (messageP->code == IOWA_COAP_CODE_EMPTY)
+    {
+        // Empty messages can be used as keepalives and are ignored
+    }
+#if !defined(IOWA_COAP_BLOCK_SUPPORT) && !defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+    else if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_1) != NULL)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Received message containing Block 1 option but IOWA_COAP_BLOCK_MINIMAL_SUPPORT is not defined.");
+
+        coapSendResponse(contextP, (iowa_coap_peer_t *)peerP, messageP, IOWA_COAP_402_BAD_OPTION);
+    }
+    else if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_2) != NULL)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Received message containing Block 2 option but IOWA_COAP_BLOCK_MINIMAL_SUPPORT is not defined.");
+    }
+#endif
+    else
+    {
+        peerHandleMessage(contextP, (iowa_coap_peer_t *)peerP, messageP, truncated, messageP->payload.length);
+    }
+
+    iowa_coap_message_free(messageP);
+}
+
+// Handle a received message and check that the peer can still receive.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer the message was received from.
+// - messageP: the message. It is freed by this function.
+// - truncated: true if the message was too large for the receive buffer.
+// Returned value: false if the peer was deleted or disconnected, true otherwise.
+static bool prv_handleReceived(iowa_context_t contextP,
+                               coap_peer_stream_t *peerP,
+                               iowa_coap_message_t *messageP,
+                               bool truncated)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t *buffer;
+
+    buffer = peerP->recvBuffer;
+
+    prv_handleMessage(contextP, peerP, messageP, truncated);
+
+    // Handling a message can delete or disconnect the peer, coapPeerDelete() then resets recvPeerP
+    if (contextP->coapContextP->recvPeerP == NULL
+        || peerP->recvBuffer != buffer)
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Peer %p deleted or disconnected, dropping the received bytes.", peerP);
+        return false;
+    }
+
+    return true;
+}
+
+// Skip the received bytes of a message too large for the receive buffer.
+// Parameters:
+// - peerP: the peer.
+// - indexP: IN/OUT. the position in the receive buffer.
+static void prv_discard(coap_peer_stream_t *peerP,
+                        size_t *indexP)
+{
+    size_t available;
+
+    available = peerP->recvLength - *indexP;
+    if (peerP->discardLength >= available)
+    {
+        peerP->discardLength -= available;
+        *indexP = peerP->recvLength;
+    }
+    else
+    {
+        *indexP += peerP->discardLength;
+        peerP->discardLength = 0;
+    }
+}
+
+// Handle the complete messages in the receive buffer.
+// The messages are decoded in place.
+// The peer can be deleted when this function returns.
+// Returned value: false if the peer was deleted or disconnected, true otherwise.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - indexP: OUT. the number of handled bytes.
+static bool prv_receiveMessages(iowa_context_t contextP,
+                                coap_peer_stream_t *peerP,
+                                size_t *indexP)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t *buffer;
+    size_t index;
+
+    buffer = peerP->recvBuffer;
+
+    index = 0;
+    while (index < peerP->recvLength)
+    {
+        iowa_coap_message_t *messageP;
+        size_t available;
+        size_t headerLength;
+        size_t bodyLength;
+        bool truncated;
+        uint8_t result;
+
+        if (peerP->discardLength != 0)
+        {
+            prv_discard(peerP, &index);
+            continue;
+        }
+
+        available = peerP->recvLength - index;
+
+        headerLength = (size_t)messageStreamParseLengthField(buffer[index]) + (buffer[index] & PRV_TOKEN_LENGTH_MASK);
+        if (available < headerLength)
+        {
+            break;
+        }
+
+        result = messageStreamParseHeader(contextP, buffer + index, headerLength, &messageP, &bodyLength);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            // The boundaries of the next messages are lost
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Message header parsing failed with error %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+            prv_abort(contextP, peerP, 0);
+            return false;
+        }
+
+        if (bodyLength > IOWA_COAP_STREAM_MAX_MESSAGE_SIZE - headerLength)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Received a message of %u bytes while the receive buffer is %u bytes. Payload is dropped.", headerLength + bodyLength, IOWA_COAP_STREAM_MAX_MESSAGE_SIZE);
+
+            index += headerLength;
+            peerP->discardLength = bodyLength;
+            truncated = true;
+        }
+        else if (available < headerLength + bodyLength)
+        {
+            // Wait for the rest of the message
+            iowa_coap_message_free(messageP);
+            break;
+        }
+        else
+        {
+            result = messageStreamParseBody(contextP, buffer + index + headerLength, bodyLength, messageP);
+            index += headerLength + bodyLength;
+            if (result != IOWA_COAP_NO_ERROR)
+            {
+                // The next messages are still delimited, only this one is ignored
+                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Message parsing failed with error %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+                iowa_coap_message_free(messageP);
+                continue;
+            }
+            truncated = false;
+        }
+
+        if (prv_handleReceived(contextP, peerP, messageP, truncated) == false)
+        {
+            return false;
+        }
+    }
+
+    *indexP = index;
+
+    return true;
+}
+
+#ifdef IOWA_WEBSOCKET_SUPPORT
+// Close the WebSocket connection with the peer after a framing error.
+// The peer can be deleted when this function returns.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - statusCode: the status code sent in the Close frame.
+static void prv_fail(iowa_context_t contextP,
+                     coap_peer_stream_t *peerP,
+                     uint16_t statusCode)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t status[2];
+
+    IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Closing the WebSocket connection with peer %p with status %u.", peerP, statusCode);
+
+    status[0] = (uint8_t)(statusCode >> 8);
+    status[1] = (uint8_t)(statusCode & 0xFF);
+    (void)websocketSendControl(contextP, peerP, COAP_WS_OPCODE_CLOSE, status, sizeof(status));
+
+    prv_close(contextP, peerP);
+}
+
+// Decode the message carried by a binary frame.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - payload, length: the unmasked payload of the frame.
+// - truncated: true if the payload is only the start of a too large message. Only its header and token are decoded.
+// - messageP: OUT. the message.
+static uint8_t prv_parseFrameMessage(iowa_context_t contextP,
+                                     uint8_t *payload,
+                                     size_t length,
+                                     bool truncated,
+                                     iowa_coap_message_t **messageP)
+{
+    size_t headerLength;
+    size_t bodyLength;
+    uint8_t result;
+
+    *messageP = NULL;
+
+    if (length == 0)
+    {
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    headerLength = (size_t)messageStreamParseLengthField(payload[0]) + (payload[0] & PRV_TOKEN_LENGTH_MASK);
+    if (headerLength > length)
+    {
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    result = messageStreamParseHeader(contextP, payload, headerLength, messageP, &bodyLength);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    // The length of the message is given by the frame (RFC 8323 Section 4.2)
+    if (bodyLength != 0)
+    {
+        result = IOWA_COAP_400_BAD_REQUEST;
+    }
+    else if (truncated == false)
+    {
+        result = messageStreamParseBody(contextP, payload + headerLength, length - headerLength, *messageP);
+    }
+
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        iowa_coap_message_free(*messageP);
+        *messageP = NULL;
+    }
+
+    return result;
+}
+
+// Handle the opening handshake and the complete frames in the receive buffer.
+// The frames are unmasked and their messages decoded in place.
+// The peer can be deleted when this function returns.
+// Returned value: false if the peer was deleted or disconnected, true otherwise.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - indexP: OUT. the number of handled bytes.
+static bool prv_receiveFrames(iowa_context_t contextP,
+                              coap_peer_stream_t *peerP,
+                              size_t *indexP)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t *buffer;
+    size_t index;
+
+    buffer = peerP->recvBuffer;
+
+    index = 0;
+    while (index < peerP->recvLength)
+    {
+        iowa_coap_message_t *messageP;
+        coap_ws_frame_t frame;
+        size_t available;
+        size_t headerLength;
+        uint8_t *payload;
+        uint8_t result;
+
+        available = peerP->recvLength - index;
+
+        if (peerP->wsOpen == false)
+        {
+            result = websocketHandleHandshake(contextP, peerP, buffer + index, available, &headerLength);
+            if (result != IOWA_COAP_NO_ERROR)
+            {
+                prv_close(contextP, peerP);
+                return false;
+            }
+            if (headerLength == 0)
+            {
+                if (available == PRV_RECV_BUFFER_SIZE)
+                {
+                    IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Opening handshake of peer %p is larger than the receive buffer.", peerP);
+                    prv_close(contextP, peerP);
+                    return false;
+                }
+                break;
+            }
+            index += headerLength;
+
+            peerP->wsOpen = true;
+            if (peerConnectTCP(contextP, peerP) != IOWA_COAP_NO_ERROR)
+            {
+                prv_close(contextP, peerP);
+                return false;
+            }
+            continue;
+        }
+
+        if (peerP->discardLength != 0)
+        {
+            prv_discard(peerP, &index);
+            continue;
+        }
+
+        result = websocketParseFrameHeader(peerP, buffer + index, available, &frame, &headerLength);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            prv_fail(contextP, peerP, COAP_WS_CLOSE_PROTOCOL_ERROR);
+            return false;
+        }
+        if (headerLength == 0)
+        {
+            break;
+        }
+        payload = buffer + index + headerLength;
+
+        if (frame.length > PRV_RECV_BUFFER_SIZE - headerLength)
+        {
+            // Only a message can be larger than the receive buffer
+            if (frame.opcode != COAP_WS_OPCODE_BINARY
+                || frame.isFinal == false)
+            {
+                prv_fail(contextP, peerP, COAP_WS_CLOSE_MESSAGE_TOO_BIG);
+                return false;
+            }
+            if (available < headerLength + PRV_WS_MESSAGE_MAX_HEADER_LENGTH)
+            {
+                break;
+            }
+
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Received a message of %u bytes while the receive buffer is %u bytes. Payload is dropped.", (size_t)frame.length, IOWA_COAP_STREAM_MAX_MESSAGE_SIZE);
+
+            // Only the start of the payload is unmasked, the rest is skipped
+            websocketUnmask(&frame, payload, available - headerLength);
+            result = prv_parseFrameMessage(contextP, payload, available - headerLength, true, &messageP);
+            peerP->discardLength = (size_t)(headerLength + frame.length - available);
+            index = peerP->recvLength;
+            if (result != IOWA_COAP_NO_ERROR)
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Message header parsing failed with error %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+                continue;
+            }
+
+            if (prv_handleReceived(contextP, peerP, messageP, true) == false)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        if (available < headerLength + frame.length)
+        {
+            // Wait for the rest of the frame
+            break;
+        }
+        index += headerLength + (size_t)frame.length;
+
+        // No copy is made, the payload is unmasked in the receive buffer
+        websocketUnmask(&frame, payload, (size_t)frame.length);
+
+        switch (frame.opcode)
+        {
+        case COAP_WS_OPCODE_BINARY:
+            if (frame.isFinal == false)
+            {
+                // RFC 8323 Section 4.2: a message is carried by a single unfragmented frame
+                prv_fail(contextP, peerP, COAP_WS_CLOSE_UNSUPPORTED_DATA);
+                return false;
+            }
+
+            result = prv_parseFrameMessage(contextP, payload, (size_t)frame.length, false, &messageP);
+            if (result != IOWA_COAP_NO_ERROR)
+            {
+                // The next messages are still delimited, only this one is ignored
+                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Message parsing failed with error %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+                break;
+            }
+
+            if (prv_handleReceived(contextP, peerP, messageP, false) == false)
+            {
+                return false;
+            }
+            break;
+
+        case COAP_WS_OPCODE_PING:
+            (void)websocketSendControl(contextP, peerP, COAP_WS_OPCODE_PONG, payload, (size_t)frame.length);
+            break;
+
+        case COAP_WS_OPCODE_PONG:
+            // Any received frame shows that the connection is alive
+            break;
+
+        case COAP_WS_OPCODE_CLOSE:
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Peer %p is closing the WebSocket connection.", peerP);
+
+            // Echo the status code of the peer
+            (void)websocketSendControl(contextP, peerP, COAP_WS_OPCODE_CLOSE, payload, frame.length >= 2 ? 2 : 0);
+            prv_close(contextP, peerP);
+            return false;
+
+        default:
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Unsupported frame opcode %u from peer %p.", frame.opcode, peerP);
+            prv_fail(contextP, peerP, COAP_WS_CLOSE_UNSUPPORTED_DATA);
+            return false;
+        }
+    }
+
+    *indexP = index;
+
+    return true;
+}
+#endif // IOWA_WEBSOCKET_SUPPORT
+
+// Read the available bytes and handle the complete messages.
+// The messages are decoded in place: the received bytes are copied only to move an incomplete message
+// at the start of the receive buffer.
+// The peer can be deleted when this function returns.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+static void prv_receive(iowa_context_t contextP,
+                        coap_peer_stream_t *peerP)
+{
+    // WARNING: This function is called in a critical section
+    int dataLength;
+    size_t index;
+    bool isAlive;
+
+    if (peerP->recvBuffer == NULL)
+    {
+        peerP->recvBuffer = (uint8_t *)iowa_system_malloc(PRV_RECV_BUFFER_SIZE);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (peerP->recvBuffer == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(PRV_RECV_BUFFER_SIZE);
+            prv_close(contextP, peerP);
+            return;
+        }
+#endif
+        peerP->recvLength = 0;
+    }
+
+    // The buffer never holds a complete message here so there is always room left
+    dataLength = peerRecvBuffer(contextP, (iowa_coap_peer_t *)peerP, peerP->recvBuffer + peerP->recvLength, PRV_RECV_BUFFER_SIZE - peerP->recvLength);
+    if (dataLength <= 0)
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Connection with peer %p closed (%d).", peerP, dataLength);
+        prv_close(contextP, peerP);
+        return;
+    }
+    peerP->recvLength += (size_t)dataLength;
+    peerP->received = true;
+    peerP->pingSent = false;
+
+    index = 0;
+    contextP->coapContextP->recvPeerP = (iowa_coap_peer_t *)peerP;
+    switch (peerP->base.type)
+    {
+#ifdef IOWA_WEBSOCKET_SUPPORT
+    case IOWA_CONN_WEBSOCKET:
+        isAlive = prv_receiveFrames(contextP, peerP, &index);
+        break;
+#endif
+
+    default:
+        isAlive = prv_receiveMessages(contextP, peerP, &index);
+        break;
+    }
+    contextP->coapContextP->recvPeerP = NULL;
+    if (isAlive == false)
+    {
+        return;
+    }
+
+    // Move the incomplete message at the start of the buffer
+    if (index != 0)
+    {
+        peerP->recvLength -= index;
+        memmove(peerP->recvBuffer, peerP->recvBuffer + index, peerP->recvLength);
+    }
+
+    prv_keepaliveStart(contextP, peerP);
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+uint8_t tcpSendBuffer(iowa_context_t contextP,
+                      coap_peer_stream_t *peerP,
+                      uint8_t *buffer,
+                      size_t length)
+{
+    // WARNING: This function is called in a critical section
+    while (length > 0)
+    {
+        int nbSent;
+
+        nbSent = peerSendBuffer(contextP, (iowa_coap_peer_t *)peerP, buffer, length);
+        if (nbSent <= 0)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Communication error: %d.", nbSent);
+            return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+        }
+
+        // A stream connection can accept only a part of the buffer
+        buffer += nbSent;
+        length -= (size_t)nbSent;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+uint8_t messageSendTCP(iowa_context_t contextP,
+                       iowa_coap_peer_t *peerBaseP,
+                       iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+    coap_peer_stream_t *peerP;
+    bool withLength;
+    size_t headroom;
+    size_t frameHeaderLength;
+    size_t bufferLength;
+    uint8_t *buffer;
+    uint8_t result;
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+    uint8_t header[COAP_WS_FRAME_MAX_HEADER_LENGTH + PRV_HEADER_BUFFER_SIZE];
+    size_t headerLength;
+#endif
+
+    IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering");
+
+    peerP = (coap_peer_stream_t *)peerBaseP;
+
+    // The length of the messages is given by the WebSocket framing
+    withLength = (peerP->base.type == IOWA_CONN_STREAM);
+
+    // Room left in front of the message for the header of the frame carrying it
+    headroom = 0;
+#ifdef IOWA_WEBSOCKET_SUPPORT
+    if (peerP->base.type == IOWA_CONN_WEBSOCKET)
+    {
+        headroom = COAP_WS_FRAME_MAX_HEADER_LENGTH;
+    }
+#endif
+
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+#ifdef IOWA_WEBSOCKET_SUPPORT
+    // The frames sent by a client are masked: the payload is then copied in the serialized message
+    if (headroom == 0
+        || peerP->wsHost == NULL)
+#endif
+    {
+        headerLength = coapMessageSerializeStreamHeader(messageP, withLength, header + headroom, PRV_HEADER_BUFFER_SIZE);
+    }
+#ifdef IOWA_WEBSOCKET_SUPPORT
+    else
+    {
+        headerLength = 0;
+    }
+#endif
+    if (headerLength != 0)
+    {
+        if (headerLength + messageP->payload.length > peerP->maxMessageSize)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Message of %u bytes exceeds the Max-Message-Size of the peer (%u).", headerLength + messageP->payload.length, peerP->maxMessageSize);
+            return IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+        }
+
+        frameHeaderLength = 0;
+#ifdef IOWA_WEBSOCKET_SUPPORT
+        if (headroom != 0)
+        {
+            frameHeaderLength = websocketFrame(contextP, peerP, COAP_WS_OPCODE_BINARY, header + headroom, headerLength, headerLength + messageP->payload.length);
+            if (frameHeaderLength == 0)
+            {
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+        }
+#endif
+
+        result = prv_sendSegments(contextP, peerP, header + headroom - frameHeaderLength, frameHeaderLength + headerLength, messageP);
+        if (result == IOWA_COAP_NO_ERROR)
+        {
+            prv_keepaliveStart(contextP, peerP);
+        }
+
+        IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Exiting with result %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+
+        return result;
+    }
+    // Too many options to fit in the header buffer
+#endif
+
+    bufferLength = coapMessageSerializeStream(messageP, withLength, headroom, &buffer);
+    if (bufferLength == 0)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Exit on error: serialization failed.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+    bufferLength -= headroom;
+
+    if (bufferLength > peerP->maxMessageSize)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Message of %u bytes exceeds the Max-Message-Size of the peer (%u).", bufferLength, peerP->maxMessageSize);
+        result = IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+    }
+    else
+    {
+        frameHeaderLength = 0;
+#ifdef IOWA_WEBSOCKET_SUPPORT
+        if (headroom != 0)
+        {
+            // The frame header is written in the headroom and the message masked in place
+            frameHeaderLength = websocketFrame(contextP, peerP, COAP_WS_OPCODE_BINARY, buffer + headroom, bufferLength, bufferLength);
+        }
+        if (headroom != 0
+            && frameHeaderLength == 0)
+        {
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+        else
+#endif
+        {
+            result = tcpSendBuffer(contextP, peerP, buffer + headroom - frameHeaderLength, frameHeaderLength + bufferLength);
+            if (result == IOWA_COAP_NO_ERROR)
+            {
+                prv_keepaliveStart(contextP, peerP);
+            }
+        }
+    }
+
+    iowa_system_free(buffer);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Exiting with result %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+
+    return result;
+}
+
+uint8_t peerConnectTCP(iowa_context_t contextP,
+                       coap_peer_stream_t *peerP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_option_t option;
+    uint8_t value[sizeof(uint32_t)];
+    uint8_t result;
+#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+    iowa_coap_option_t blockOption;
+#endif
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Sending the CSM to peer %p.", peerP);
+
+    memset(&option, 0, sizeof(iowa_coap_option_t));
+    option.number = PRV_OPTION_MAX_MESSAGE_SIZE;
+    option.length = prv_encodeUint(IOWA_COAP_STREAM_MAX_MESSAGE_SIZE, value);
+    option.value.asBuffer = value;
+
+#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+    // BERT blocks can be received
+    memset(&blockOption, 0, sizeof(iowa_coap_option_t));
+    blockOption.number = PRV_OPTION_BLOCK_WISE_TRANSFER;
+    option.next = &blockOption;
+#endif
+
+    result = prv_sendSignal(contextP, peerP, PRV_SIGNAL_CSM, 0, NULL, &option);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    peerP->state = COAP_STREAM_STATE_CSM_SENT;
+
+    // The connection is aborted if the peer does not send its CSM
+    return prv_timerSet(contextP, peerP, COAP_TCP_MAX_TRANSMIT_WAIT);
+}
+
+void tcpPeerClear(iowa_context_t contextP,
+                  coap_peer_stream_t *peerP)
+{
+    // WARNING: This function is called in a critical section
+    if (peerP->timerP != NULL)
+    {
+        coreTimerDelete(contextP, peerP->timerP);
+        peerP->timerP = NULL;
+    }
+
+    iowa_system_free(peerP->recvBuffer);
+    peerP->recvBuffer = NULL;
+    peerP->recvLength = 0;
+    peerP->discardLength = 0;
+
+    peerP->state = COAP_STREAM_STATE_CSM_WAIT;
+    peerP->maxMessageSize = COAP_TCP_DEFAULT_MAX_MESSAGE_SIZE;
+    peerP->received = false;
+    peerP->pingSent = false;
+    peerP->bert = false;
+#ifdef IOWA_WEBSOCKET_SUPPORT
+    peerP->wsOpen = false;
+#endif
+}
+
+void tcpSecurityEventCb(iowa_security_session_t securityS,
+                        iowa_security_event_t event,
+                        void *userData,
+                        iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+
+    coap_peer_stream_t *peerP;
+
+    (void)securityS;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "PeerP: %p, event: %s.", userData, STR_SECURITY_EVENT(event));
+
+    peerP = (coap_peer_stream_t *)userData;
+
+    switch (event)
+    {
+    case SECURITY_EVENT_CONNECTED:
+#ifdef IOWA_WEBSOCKET_SUPPORT
+        if (peerP->base.type == IOWA_CONN_WEBSOCKET)
+        {
+            // The CSM is sent once the opening handshake is done
+            if (websocketOpen(contextP, peerP) != IOWA_COAP_NO_ERROR
+                || prv_timerSet(contextP, peerP, COAP_TCP_MAX_TRANSMIT_WAIT) != IOWA_COAP_NO_ERROR)
+            {
+                prv_close(contextP, peerP);
+            }
+            break;
+        }
+#endif
+
+        // The upper layer is signaled once the CSMs are exchanged
+        if (peerConnectTCP(contextP, peerP) != IOWA_COAP_NO_ERROR)
+        {
+            prv_close(contextP, peerP);
+        }
+        break;
+
+    case SECURITY_EVENT_DISCONNECTED:
+        tcpPeerClear(contextP, peerP);
+
+        // The responses cannot be received on another connection. coapPeerDelete() fails the exchanges of a deleted peer.
+        if (peerP->base.type != IOWA_CONN_UNDEFINED
+            && peerFailExchanges(contextP, (iowa_coap_peer_t *)peerP, IOWA_COAP_503_SERVICE_UNAVAILABLE) == false)
+        {
+            break;
+        }
+
+        // Propagate the signal to the upper layer
+        PEER_CALL_EVENT_CALLBACK(contextP, peerP, COAP_EVENT_DISCONNECTED);
+        break;
+
+    case SECURITY_EVENT_DATA_AVAILABLE:
+        prv_receive(contextP, peerP);
+        break;
+
+    default:
+        // Should not happen
+        break;
+    }
+}
+
+#endif // defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
@@ -25,6 +25,388 @@
 
 #ifdef IOWA_UDP_SUPPORT
 
+// Delay between two datagrams once the burst is exhausted, in internal time unit
+#define PRV_SEND_INTERVAL ((CORE_TIME_FROM_SECONDS(1) + IOWA_COAP_SEND_RATE - 1) / IOWA_COAP_SEND_RATE)
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+static coap_send_class_t prv_getSendClass(iowa_coap_message_t *messageP)
+{
+    if (messageP->type == IOWA_COAP_TYPE_ACKNOWLEDGEMENT
+        || messageP->type == IOWA_COAP_TYPE_RESET)
+    {
+        return COAP_SEND_CLASS_RESPONSE;
+    }
+
+    if (COAP_IS_REQUEST(messageP->code))
+    {
+        return COAP_SEND_CLASS_REQUEST;
+    }
+
+    return COAP_SEND_CLASS_NOTIFICATION;
+}
+
+// Add the tokens accumulated since the last refill.
+// Parameters:
+// - peerP: the peer.
+// - currentTime: the current time.
+static void prv_refillTokens(coap_peer_datagram_t *peerP,
+                             iowa_time_t currentTime)
+{
+    iowa_time_t elapsed;
+    iowa_time_t count;
+
+    elapsed = currentTime - peerP->sendTime;
+    if (elapsed >= CORE_TIME_FROM_SECONDS(IOWA_COAP_SEND_BURST))
+    {
+        // The burst is refilled anyway, and this avoids an overflow after a long idle period
+        peerP->sendTokens = IOWA_COAP_SEND_BURST;
+        peerP->sendTime = currentTime;
+        return;
+    }
+
+    count = (elapsed * IOWA_COAP_SEND_RATE) / CORE_TIME_FROM_SECONDS(1);
+    if (count <= 0)
+    {
+        return;
+    }
+
+    if (count >= IOWA_COAP_SEND_BURST - peerP->sendTokens)
+    {
+        peerP->sendTokens = IOWA_COAP_SEND_BURST;
+        peerP->sendTime = currentTime;
+    }
+    else
+    {
+        peerP->sendTokens = (uint8_t)(peerP->sendTokens + count);
+        peerP->sendTime += (count * CORE_TIME_FROM_SECONDS(1)) / IOWA_COAP_SEND_RATE;
+    }
+}
+
+// Convert the result of a transmission to a status.
+// Returned value: IOWA_COAP_NO_ERROR if the whole datagram was sent or an error status.
+// Parameters:
+// - nbSent: the value returned by the connection layer.
+// - length: the length of the datagram.
+static uint8_t prv_getSendResult(int nbSent,
+                                 size_t length)
+{
+    if (nbSent < 0)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Communication error: %d.", nbSent);
+        return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+    }
+
+    if ((size_t)nbSent < length)
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Need to send in blocks, %u bytes to send but connection layer returned %d.", length, nbSent);
+        return IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+
+// Size of the stack buffer holding the header, token and options of a message sent in segments
+#define PRV_HEADER_BUFFER_SIZE 64
+
+// Check if the serialized message must outlive its transmission.
+// Returned value: true if the message is retransmitted or cached, false otherwise.
+// Parameters:
+// - peerP: the peer.
+// - messageP: the message.
+static bool prv_isCopyNeeded(coap_peer_datagram_t *peerP,
+                             iowa_coap_message_t *messageP)
+{
+    switch (messageP->type)
+    {
+    case IOWA_COAP_TYPE_CONFIRMABLE:
+        return true;
+
+    case IOWA_COAP_TYPE_ACKNOWLEDGEMENT:
+    case IOWA_COAP_TYPE_RESET:
+        // Replies are cached to answer duplicate requests
+        return peerP->ackTimeout != 0;
+
+    default:
+        return false;
+    }
+}
+
+// Send a message with its payload as a separate segment.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - messageP: the message.
+static uint8_t prv_sendSegments(iowa_context_t contextP,
+                                coap_peer_datagram_t *peerP,
+                                iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t header[PRV_HEADER_BUFFER_SIZE];
+    iowa_connection_segment_t segmentArray[2];
+    size_t segmentCount;
+    uint8_t *buffer;
+    size_t bufferLength;
+    uint8_t result;
+
+    segmentArray[0].length = coapMessageSerializeDatagramHeader(messageP, header, PRV_HEADER_BUFFER_SIZE);
+    if (segmentArray[0].length != 0)
+    {
+        segmentArray[0].data = header;
+        segmentCount = 1;
+        if (messageP->payload.length != 0)
+        {
+            segmentArray[1].data = messageP->payload.data;
+            segmentArray[1].length = messageP->payload.length;
+            segmentCount = 2;
+        }
+
+        return prv_getSendResult(peerSendSegments(contextP, (iowa_coap_peer_t *)peerP, segmentArray, segmentCount),
+                                 segmentArray[0].length + messageP->payload.length);
+    }
+
+    // Too many options to fit in the header buffer
+    bufferLength = coapMessageSerializeDatagram(messageP, &buffer);
+    if (bufferLength == 0)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Exit on error: serialization failed.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    result = prv_getSendResult(peerSendBuffer(contextP, (iowa_coap_peer_t *)peerP, buffer, bufferLength), bufferLength);
+
+    iowa_system_free(buffer);
+
+    return result;
+}
+#endif // IOWA_CONNECTION_SENDV_SUPPORT
+
+// Get the receive buffer of the context, allocating it if needed.
+// Only the thread running iowa_step() calls this function, so the buffer is never reallocated during a reception.
+// Returned value: the buffer or NULL in case of memory allocation failure.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - lengthP: OUT. the size of a datagram buffer. With IOWA_CONNECTION_RECVV_SUPPORT, the returned buffer holds
+//            IOWA_CONNECTION_RECVV_COUNT of them.
+static uint8_t * prv_getReceiveBuffer(iowa_context_t contextP,
+                                      size_t *lengthP)
+{
+    // WARNING: This function is called in a critical section
+    coap_context_t coapContextP;
+
+    coapContextP = contextP->coapContextP;
+
+    if (coapContextP->recvBuffer == NULL
+        || coapContextP->recvBufferLength != coapContextP->recvDatagramMaxSize)
+    {
+        size_t size;
+
+        iowa_system_free(coapContextP->recvBuffer);
+        coapContextP->recvBufferLength = 0;
+
+        size = coapContextP->recvDatagramMaxSize;
+#ifdef IOWA_CONNECTION_RECVV_SUPPORT
+        size *= IOWA_CONNECTION_RECVV_COUNT;
+#endif
+        coapContextP->recvBuffer = (uint8_t *)iowa_system_malloc(size);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (coapContextP->recvBuffer == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(size);
+            return NULL;
+        }
+#endif
+        coapContextP->recvBufferLength = coapContextP->recvDatagramMaxSize;
+    }
+
+    *lengthP = coapContextP->recvBufferLength;
+
+    return coapContextP->recvBuffer;
+}
+
+// Parse and handle a received datagram.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer the datagram was received from.
+// - buffer, bufferLength: the datagram.
+// - maxLength: the size of the receive buffer. Longer datagrams were truncated.
+static void prv_handleDatagram(iowa_context_t contextP,
+                               coap_peer_datagram_t *peerP,
+                               uint8_t *buffer,
+                               size_t bufferLength,
+                               size_t maxLength)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_message_t *messageP;
+    uint8_t result;
+    size_t maxPayloadSize;
+    bool truncated;
+
+    maxPayloadSize = 0;
+
+    result = messageDatagramParse(contextP, buffer, bufferLength, &messageP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Message parsing failed with error %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+        // ignore message
+        return;
+    }
+
+    if (bufferLength >= maxLength)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Received a message of %u bytes while the receive buffer is %u bytes. Payload was truncated.", bufferLength, maxLength);
+
+        maxPayloadSize = messageP->payload.length;
+        truncated = true;
+    }
+    else
+    {
+        truncated = false;
+    }
+
+#if !defined(IOWA_COAP_BLOCK_SUPPORT) && !defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+    if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_1) != NULL)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Received message containing Block 1 option but IOWA_COAP_BLOCK_MINIMAL_SUPPORT is not defined.");
+
+        coapSendResponse(contextP, (iowa_coap_peer_t *)peerP, messageP, IOWA_COAP_402_BAD_OPTION);
+        iowa_coap_message_free(messageP);
+        return;
+    }
+    else if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_2) != NULL) //Server cannot respond to a Block message from the Client when Block is not supported.
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Received message containing Block 2 option but IOWA_COAP_BLOCK_MINIMAL_SUPPORT is not defined.");
+
+        iowa_coap_message_free(messageP);
+        return;
+    }
+#endif
+
+    transactionHandleMessage(contextP, peerP, messageP, truncated, maxPayloadSize);
+
+    iowa_coap_message_free(messageP);
+}
+
+static void prv_sendItemFree(coap_send_item_t *itemP)
+{
+    iowa_system_free(itemP->buffer);
+    iowa_system_free(itemP);
+}
+
+// Add a serialized message to the outbound queue of the peer.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - peerP: the peer.
+// - messageP: the message.
+// - buffer: the serialized message. It is owned by the queue in case of success.
+// - bufferLength: the length of buffer.
+// - resultCallback, userData: as given to messageSendUDP().
+static uint8_t prv_sendQueueAdd(coap_peer_datagram_t *peerP,
+                                iowa_coap_message_t *messageP,
+                                uint8_t *buffer,
+                                size_t bufferLength,
+                                coap_message_callback_t resultCallback,
+                                void *userData)
+{
+    coap_send_item_t *itemP;
+    coap_send_item_t *parentP;
+    coap_send_item_t *evictedParentP;
+    coap_send_item_t *evictedP;
+    coap_send_class_t sendClass;
+    size_t count;
+
+    sendClass = prv_getSendClass(messageP);
+
+    count = 0;
+    parentP = NULL;
+    evictedParentP = NULL;
+    evictedP = NULL;
+    for (itemP = peerP->sendQueue; itemP != NULL; itemP = itemP->next)
+    {
+        // Messages without callback and of a lower class can be dropped to make room
+        if (itemP->sendClass > sendClass
+            && itemP->callback == NULL)
+        {
+            evictedP = itemP;
+            evictedParentP = parentP;
+        }
+        count++;
+        parentP = itemP;
+    }
+
+    if (count >= IOWA_COAP_SEND_QUEUE_SIZE)
+    {
+        if (evictedP == NULL)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Send queue of peer %p is full.", peerP);
+            return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+        }
+
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Send queue of peer %p is full. Dropping message %u.", peerP, evictedP->mID);
+        if (evictedParentP == NULL)
+        {
+            peerP->sendQueue = evictedP->next;
+        }
+        else
+        {
+            evictedParentP->next = evictedP->next;
+        }
+        prv_sendItemFree(evictedP);
+    }
+
+    itemP = (coap_send_item_t *)iowa_system_malloc(sizeof(coap_send_item_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (itemP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(coap_send_item_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    itemP->sendClass = sendClass;
+    itemP->type = messageP->type;
+    itemP->mID = messageP->id;
+    itemP->buffer_len = bufferLength;
+    itemP->buffer = buffer;
+    itemP->callback = resultCallback;
+    itemP->userData = userData;
+
+    // Insert after the messages of the same or a higher class
+    parentP = NULL;
+    if (peerP->sendQueue != NULL
+        && peerP->sendQueue->sendClass <= sendClass)
+    {
+        parentP = peerP->sendQueue;
+        while (parentP->next != NULL
+               && parentP->next->sendClass <= sendClass)
+        {
+            parentP = parentP->next;
+        }
+    }
+    if (parentP == NULL)
+    {
+        itemP->next = peerP->sendQueue;
+        peerP->sendQueue = itemP;
+    }
+    else
+    {
+        itemP->next = parentP->next;
+        parentP->next = itemP;
+    }
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Queued message %u of class %d for peer %p.", itemP->mID, sendClass, peerP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
 uint8_t messageSendUDP(iowa_context_t contextP,
                        iowa_coap_peer_t *peerBaseP,
                        iowa_coap_message_t *messageP,
@@ -36,52 +418,210 @@ uint8_t messageSendUDP(iowa_context_t contextP,
     size_t bufferLength;
     uint8_t *buffer;
     uint8_t result;
-    int nbSent;
+    iowa_time_t curTime;
+    bool isPaced;
 
     IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering");
 
     peerP = (coap_peer_datagram_t *)peerBaseP;
 
-    bufferLength = coapMessageSerializeDatagram(messageP, &buffer);
-    if (bufferLength == 0)
+    curTime = coreTimeGet();
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (curTime < 0)
     {
-        IOWA_LOG_ERROR(IOWA_PART_COAP, "Exit on error: serialization failed.");
+        IOWA_LOG_ERROR_GETTIME(curTime);
         return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
     }
+#endif
 
-    nbSent = peerSendBuffer(contextP, (iowa_coap_peer_t *)peerP, buffer, bufferLength);
-    if (nbSent < 0)
+    prv_refillTokens(peerP, curTime);
+
+    // Acknowledgements and resets answer a received message and are not paced
+    isPaced = prv_getSendClass(messageP) != COAP_SEND_CLASS_RESPONSE;
+
+    // Queue the message while the peer is connecting, or when older messages are waiting or the burst is exhausted
+    if ((isPaced == true
+         && (peerP->sendQueue != NULL
+             || peerP->sendTokens == 0))
+        || coapPeerGetConnectionState(peerBaseP) != SECURITY_STATE_CONNECTED)
     {
-        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Communication error: %d.", nbSent);
-        result = IOWA_COAP_503_SERVICE_UNAVAILABLE;
+        bufferLength = coapMessageSerializeDatagram(messageP, &buffer);
+        if (bufferLength == 0)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_COAP, "Exit on error: serialization failed.");
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+
+        result = prv_sendQueueAdd(peerP, messageP, buffer, bufferLength, resultCallback, userData);
+        if (result == IOWA_COAP_NO_ERROR)
+        {
+            if (coapPeerGetConnectionState(peerBaseP) == SECURITY_STATE_CONNECTED)
+            {
+                coapPeerSchedule(contextP, peerP, curTime + PRV_SEND_INTERVAL);
+                if (contextP->timeout > PRV_SEND_INTERVAL)
+                {
+                    contextP->timeout = PRV_SEND_INTERVAL;
+                    CRIT_SECTION_LEAVE(contextP);
+                    INTERRUPT_SELECT(contextP);
+                    CRIT_SECTION_ENTER(contextP);
+                }
+            }
+        }
+        else
+        {
+            iowa_system_free(buffer);
+        }
     }
-    else if ((size_t)nbSent < bufferLength)
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+    else if (prv_isCopyNeeded(peerP, messageP) == false)
     {
-        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Need to send in blocks, %u bytes to send but connection layer returned %d.", bufferLength, nbSent);
-        result = IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+        if (isPaced == true)
+        {
+            peerP->sendTokens--;
+        }
+
+        result = prv_sendSegments(contextP, peerP, messageP);
     }
+#endif
     else
     {
-        result = IOWA_COAP_NO_ERROR;
-    }
+        bool queued;
 
-    if (result == IOWA_COAP_NO_ERROR)
-    {
-        result = transactionNew(contextP, peerP, messageP, buffer, bufferLength, resultCallback, userData);
-        if (result == IOWA_COAP_201_CREATED)
+        if (isPaced == true)
+        {
+            peerP->sendTokens--;
+        }
+
+        bufferLength = coapMessageSerializeDatagram(messageP, &buffer);
+        if (bufferLength == 0)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_COAP, "Exit on error: serialization failed.");
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+
+        // Confirmable messages exceeding NSTART are sent when an outstanding transaction completes
+        queued = messageP->type == IOWA_COAP_TYPE_CONFIRMABLE
+                 && transactionCanStart(peerP) == false;
+        if (queued == true)
         {
-            buffer = NULL;
             result = IOWA_COAP_NO_ERROR;
         }
-    }
+        else
+        {
+            result = prv_getSendResult(peerSendBuffer(contextP, (iowa_coap_peer_t *)peerP, buffer, bufferLength), bufferLength);
+        }
 
-    iowa_system_free(buffer);
+        if (result == IOWA_COAP_NO_ERROR)
+        {
+            result = transactionNew(contextP, peerP, messageP->type, messageP->id, buffer, bufferLength, queued, resultCallback, userData);
+            if (result == IOWA_COAP_201_CREATED)
+            {
+                buffer = NULL;
+                result = IOWA_COAP_NO_ERROR;
+            }
+        }
+
+        iowa_system_free(buffer);
+    }
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Exiting with result %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
 
     return result;
 }
 
+void udpSendQueueFlush(iowa_context_t contextP,
+                       coap_peer_datagram_t *peerP,
+                       iowa_time_t currentTime,
+                       int32_t *timeoutP)
+{
+    // WARNING: This function is called in a critical section
+    if (peerP->sendQueue == NULL
+        || coapPeerGetConnectionState((iowa_coap_peer_t *)peerP) != SECURITY_STATE_CONNECTED)
+    {
+        return;
+    }
+
+    prv_refillTokens(peerP, currentTime);
+
+    // The acknowledgements and resets are first in the queue and are not paced
+    while (peerP->sendQueue != NULL
+           && (peerP->sendTokens > 0
+               || peerP->sendQueue->sendClass == COAP_SEND_CLASS_RESPONSE))
+    {
+        coap_send_item_t *itemP;
+        bool queued;
+
+        itemP = peerP->sendQueue;
+        peerP->sendQueue = itemP->next;
+        if (itemP->sendClass != COAP_SEND_CLASS_RESPONSE)
+        {
+            peerP->sendTokens--;
+        }
+
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Sending queued message %u to peer %p.", itemP->mID, peerP);
+
+        // A failed transmission is handled as a lost datagram: confirmable messages are retransmitted
+        queued = itemP->type == IOWA_COAP_TYPE_CONFIRMABLE
+                 && transactionCanStart(peerP) == false;
+        if (queued == false)
+        {
+            (void)peerSendBuffer(contextP, (iowa_coap_peer_t *)peerP, itemP->buffer, itemP->buffer_len);
+        }
+
+        if (transactionNew(contextP, peerP, itemP->type, itemP->mID, itemP->buffer, itemP->buffer_len, queued, itemP->callback, itemP->userData) == IOWA_COAP_201_CREATED)
+        {
+            itemP->buffer = NULL;
+        }
+        prv_sendItemFree(itemP);
+    }
+
+    if (peerP->sendQueue != NULL)
+    {
+        coapPeerSchedule(contextP, peerP, currentTime + PRV_SEND_INTERVAL);
+        if (*timeoutP > PRV_SEND_INTERVAL)
+        {
+            *timeoutP = PRV_SEND_INTERVAL;
+        }
+    }
+}
+
+bool udpSendQueueHasReply(coap_peer_datagram_t *peerP,
+                          uint16_t mID)
+{
+    // WARNING: This function is called in a critical section
+    coap_send_item_t *itemP;
+
+    // The acknowledgements and resets are first in the queue
+    for (itemP = peerP->sendQueue; itemP != NULL && itemP->sendClass == COAP_SEND_CLASS_RESPONSE; itemP = itemP->next)
+    {
+        if (itemP->mID == mID)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void udpSendQueueClear(iowa_context_t contextP,
+                       coap_peer_datagram_t *peerP)
+{
+    // WARNING: This function is called in a critical section
+    while (peerP->sendQueue != NULL)
+    {
+        coap_send_item_t *itemP;
+
+        itemP = peerP->sendQueue;
+        peerP->sendQueue = itemP->next;
+
+        if (itemP->callback != NULL)
+        {
+            itemP->callback((iowa_coap_peer_t *)peerP, IOWA_COAP_503_SERVICE_UNAVAILABLE, NULL, itemP->userData, contextP);
+        }
+        prv_sendItemFree(itemP);
+    }
+}
+
 void udpSecurityEventCb(iowa_security_session_t securityS,
                         iowa_security_event_t event,
                         void *userData,
@@ -100,7 +640,8 @@ void udpSecurityEventCb(iowa_security_session_t securityS,
     switch (event)
     {
     case SECURITY_EVENT_CONNECTED:
-        // TODO: (in case of security) send any buffered message
+        // Send the messages buffered while connecting
+        udpSendQueueFlush(contextP, peerP, contextP->currentTime, &(contextP->timeout));
         // Propagate the signal to the upper layer
         PEER_CALL_EVENT_CALLBACK(contextP, peerP, COAP_EVENT_CONNECTED);
         break;
@@ -112,60 +653,50 @@ void udpSecurityEventCb(iowa_security_session_t securityS,
 
     case SECURITY_EVENT_DATA_AVAILABLE:
     {
-        static uint8_t buffer[IOWA_BUFFER_SIZE];
-        int bufferLength;
+        uint8_t *buffer;
+        size_t bufferLength;
+#ifdef IOWA_CONNECTION_RECVV_SUPPORT
+        iowa_connection_segment_t segmentArray[IOWA_CONNECTION_RECVV_COUNT];
+        int count;
+        int i;
+#else
+        int dataLength;
+#endif
 
-        bufferLength = peerRecvBuffer(contextP, (iowa_coap_peer_t *)peerP, buffer, IOWA_BUFFER_SIZE);
-        if (bufferLength > 0)
+        buffer = prv_getReceiveBuffer(contextP, &bufferLength);
+        if (buffer == NULL)
         {
-            iowa_coap_message_t *messageP;
-            uint8_t result;
-            size_t maxPayloadSize;
-            bool truncated;
-
-            maxPayloadSize = 0;
-
-            result = messageDatagramParse(buffer, (size_t)bufferLength, &messageP);
-            if (result != IOWA_COAP_NO_ERROR)
-            {
-                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Message parsing failed with error %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
-                // ignore message
-                return;
-            }
-
-            if (bufferLength >= IOWA_BUFFER_SIZE)
-            {
-                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Received a message of %u bytes while IOWA_BUFFER_SIZE is %u. Payload was truncated.", bufferLength, IOWA_BUFFER_SIZE);
+            break;
+        }
 
-                maxPayloadSize = messageP->payload.length;
-                truncated = true;
-            }
-            else
-            {
-                truncated = false;
-            }
+#ifdef IOWA_CONNECTION_RECVV_SUPPORT
+        for (i = 0; i < IOWA_CONNECTION_RECVV_COUNT; i++)
+        {
+            segmentArray[i].data = buffer + i * bufferLength;
+            segmentArray[i].length = bufferLength;
+        }
 
-            if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_1) != NULL)
-            {
-                IOWA_LOG_WARNING(IOWA_PART_COAP, "Received message containing Block 1 option but IOWA_COAP_BLOCK_MINIMAL_SUPPORT is not defined.");
+        count = peerRecvSegments(contextP, (iowa_coap_peer_t *)peerP, segmentArray, IOWA_CONNECTION_RECVV_COUNT);
 
-                coapSendResponse(contextP, (iowa_coap_peer_t *)peerP, messageP, IOWA_COAP_402_BAD_OPTION);
-                iowa_coap_message_free(messageP);
-                return;
-            }
-            else if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_2) != NULL) //Server cannot respond to a Block message from the Client when Block is not supported.
+        // Handling a message can delete the peer, coapPeerDelete() then resets recvPeerP
+        contextP->coapContextP->recvPeerP = (iowa_coap_peer_t *)peerP;
+        for (i = 0; i < count; i++)
+        {
+            if (contextP->coapContextP->recvPeerP == NULL)
             {
-                IOWA_LOG_WARNING(IOWA_PART_COAP, "Received message containing Block 2 option but IOWA_COAP_BLOCK_MINIMAL_SUPPORT is not defined.");
-
-                iowa_coap_message_free(messageP);
-                return;
+                IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Peer deleted, dropping %d received datagrams.", count - i);
+                break;
             }
-
-            transactionHandleMessage(contextP, peerP, messageP, truncated, maxPayloadSize);
-
-            iowa_coap_message_free(messageP);
-            return;
+            prv_handleDatagram(contextP, peerP, segmentArray[i].data, segmentArray[i].length, bufferLength);
+        }
+        contextP->coapContextP->recvPeerP = NULL;
+#else
+        dataLength = peerRecvBuffer(contextP, (iowa_coap_peer_t *)peerP, buffer, bufferLength);
+        if (dataLength > 0)
+        {
+            prv_handleDatagram(contextP, peerP, buffer, (size_t)dataLength, bufferLength);
         }
+#endif
     }
     break;
 
@@ -0,0 +1,896 @@
+/**********************************************
+*
+*  _________ _________ ___________ _________
+* |         |         |   |   |   |         |
+* |_________|         |   |   |   |    _    |
+* |         |    |    |   |   |   |         |
+* |         |    |    |           |         |
+* |         |    |    |           |    |    |
+* |         |         |           |    |    |
+* |_________|_________|___________|____|____|
+*
+* Copyright (c) 2016-2020 IoTerop.
+* All rights reserved.
+*
+* This program and the accompanying materials
+* are made available under the terms of
+* IoTerop’s IOWA License (LICENSE.TXT) which
+* accompany this distribution.
+*
+*
+**********************************************/
+
+#include "iowa_prv_coap_internals.h"
+
+#ifdef IOWA_WEBSOCKET_SUPPORT
+
+// Frame header (RFC 6455 Section 5.2)
+#define PRV_FRAME_FIN             0x80U
+#define PRV_FRAME_RSV_MASK        0x70U
+#define PRV_FRAME_OPCODE_MASK     0x0FU
+#define PRV_FRAME_MASK            0x80U
+#define PRV_FRAME_LENGTH_MASK     0x7FU
+#define PRV_FRAME_LENGTH_16       126
+#define PRV_FRAME_LENGTH_64       127
+#define PRV_FRAME_MASK_KEY_LENGTH 4
+#define PRV_FRAME_CONTROL_MASK    0x08U
+
+#define PRV_CONTROL_MAX_PAYLOAD 125
+
+// Opening handshake (RFC 6455 Section 4)
+#define PRV_NONCE_LENGTH 16
+#define PRV_KEY_LENGTH   24 // Base64 encoded nonce
+#define PRV_SHA1_LENGTH  20
+#define PRV_GUID         "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define PRV_GUID_LENGTH  (sizeof(PRV_GUID) - 1)
+
+#define PRV_HTTP_CRLF           "\r\n"
+#define PRV_HTTP_END            "\r\n\r\n"
+#define PRV_HTTP_VERSION        "HTTP/1.1"
+#define PRV_HTTP_STATUS_SWITCH  "101"
+#define PRV_HTTP_METHOD_GET     "GET"
+
+#define PRV_HTTP_REQUEST_START "GET " COAP_WS_PATH " " PRV_HTTP_VERSION "\r\n" \
+                               "Host: "
+#define PRV_HTTP_REQUEST_MIDDLE "\r\n" \
+                                "Upgrade: websocket\r\n" \
+                                "Connection: Upgrade\r\n" \
+                                "Sec-WebSocket-Version: 13\r\n" \
+                                "Sec-WebSocket-Protocol: coap\r\n" \
+                                "Sec-WebSocket-Key: "
+
+#define PRV_HTTP_RESPONSE_START PRV_HTTP_VERSION " 101 Switching Protocols\r\n" \
+                                "Upgrade: websocket\r\n" \
+                                "Connection: Upgrade\r\n" \
+                                "Sec-WebSocket-Protocol: coap\r\n" \
+                                "Sec-WebSocket-Accept: "
+
+#define PRV_HTTP_BAD_REQUEST PRV_HTTP_VERSION " 400 Bad Request\r\n" \
+                             "Connection: close\r\n" \
+                             "Content-Length: 0\r\n" \
+                             "Sec-WebSocket-Version: 13\r\n" \
+                             "\r\n"
+
+#define PRV_HEADER_UPGRADE    "Upgrade"
+#define PRV_HEADER_CONNECTION "Connection"
+#define PRV_HEADER_VERSION    "Sec-WebSocket-Version"
+#define PRV_HEADER_PROTOCOL   "Sec-WebSocket-Protocol"
+#define PRV_HEADER_KEY        "Sec-WebSocket-Key"
+#define PRV_HEADER_ACCEPT     "Sec-WebSocket-Accept"
+
+#define PRV_VALUE_UPGRADE    "websocket"
+#define PRV_VALUE_CONNECTION "upgrade"
+#define PRV_VALUE_VERSION    "13"
+#define PRV_VALUE_PROTOCOL   "coap"
+
+#define PRV_STR_LENGTH(S) (sizeof(S) - 1)
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Draw random bytes for the handshake nonce or a masking key (RFC 6455 Section 10.3).
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - bufferP: OUT. the random bytes.
+// - length: the number of bytes to draw.
+static uint8_t prv_random(iowa_context_t contextP,
+                          uint8_t *bufferP,
+                          size_t length)
+{
+    // WARNING: This function is called in a critical section
+    int result;
+
+    CRIT_SECTION_LEAVE(contextP);
+    result = iowa_system_random_vector_generator(bufferP, length, contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+
+    if (0 != result)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "iowa_system_random_vector_generator() failed.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+static uint32_t prv_rotateLeft(uint32_t value,
+                               uint8_t count)
+{
+    return (value << count) | (value >> (32 - count));
+}
+
+// Process a 64-byte block of a SHA-1 computation (FIPS 180-4).
+// Parameters:
+// - state: IN/OUT. the intermediate digest.
+// - block: the block.
+static void prv_sha1Block(uint32_t state[5],
+                          const uint8_t *block)
+{
+    uint32_t w[16];
+    uint32_t a, b, c, d, e;
+    uint8_t i;
+
+    for (i = 0; i < 16; i++)
+    {
+        w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16) | ((uint32_t)block[4 * i + 2] << 8) | (uint32_t)block[4 * i + 3];
+    }
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+
+    for (i = 0; i < 80; i++)
+    {
+        uint32_t f;
+        uint32_t temp;
+
+        if (i >= 16)
+        {
+            // The message schedule is kept in a circular buffer
+            w[i & 0x0F] = prv_rotateLeft(w[(i + 13) & 0x0F] ^ w[(i + 8) & 0x0F] ^ w[(i + 2) & 0x0F] ^ w[i & 0x0F], 1);
+        }
+
+        if (i < 20)
+        {
+            f = ((b & c) | (~b & d)) + 0x5A827999;
+        }
+        else if (i < 40)
+        {
+            f = (b ^ c ^ d) + 0x6ED9EBA1;
+        }
+        else if (i < 60)
+        {
+            f = ((b & c) | (b & d) | (c & d)) + 0x8F1BBCDC;
+        }
+        else
+        {
+            f = (b ^ c ^ d) + 0xCA62C1D6;
+        }
+
+        temp = prv_rotateLeft(a, 5) + f + e + w[i & 0x0F];
+        e = d;
+        d = c;
+        c = prv_rotateLeft(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+// Compute the SHA-1 digest of a buffer.
+// SHA-1 is only used to check the opening handshake, as required by RFC 6455.
+// Parameters:
+// - buffer, length: the data to digest.
+// - digest: OUT. the digest.
+static void prv_sha1(const uint8_t *buffer,
+                     size_t length,
+                     uint8_t digest[PRV_SHA1_LENGTH])
+{
+    uint32_t state[5];
+    uint8_t block[64];
+    size_t index;
+    size_t remaining;
+    uint64_t bitLength;
+    uint8_t i;
+
+    state[0] = 0x67452301;
+    state[1] = 0xEFCDAB89;
+    state[2] = 0x98BADCFE;
+    state[3] = 0x10325476;
+    state[4] = 0xC3D2E1F0;
+
+    index = 0;
+    while (length - index >= sizeof(block))
+    {
+        prv_sha1Block(state, buffer + index);
+        index += sizeof(block);
+    }
+
+    // Padding: a 1 bit, zeros and the length in bits
+    remaining = length - index;
+    memset(block, 0, sizeof(block));
+    memcpy(block, buffer + index, remaining);
+    block[remaining] = 0x80;
+    if (remaining >= sizeof(block) - 8)
+    {
+        prv_sha1Block(state, block);
+        memset(block, 0, sizeof(block));
+    }
+    bitLength = (uint64_t)length * 8;
+    for (i = 0; i < 8; i++)
+    {
+        block[sizeof(block) - 1 - i] = (uint8_t)(bitLength >> (8 * i));
+    }
+    prv_sha1Block(state, block);
+
+    for (i = 0; i < PRV_SHA1_LENGTH; i++)
+    {
+        digest[i] = (uint8_t)(state[i / 4] >> (24 - 8 * (i % 4)));
+    }
+}
+
+// Compute the Sec-WebSocket-Accept value matching a Sec-WebSocket-Key value.
+// Parameters:
+// - key, keyLength: the Sec-WebSocket-Key value.
+// - accept: OUT. the Sec-WebSocket-Accept value.
+static void prv_computeAccept(const uint8_t *key,
+                              size_t keyLength,
+                              uint8_t accept[COAP_WS_ACCEPT_LENGTH])
+{
+    uint8_t buffer[PRV_KEY_LENGTH + PRV_GUID_LENGTH];
+    uint8_t digest[PRV_SHA1_LENGTH];
+    size_t acceptLength;
+
+    memcpy(buffer, key, keyLength);
+    memcpy(buffer + keyLength, PRV_GUID, PRV_GUID_LENGTH);
+    prv_sha1(buffer, keyLength + PRV_GUID_LENGTH, digest);
+
+    utils_b64Encode(digest, PRV_SHA1_LENGTH, accept, &acceptLength, BASE64_MODE_CLASSIC);
+}
+
+static uint8_t prv_toLower(uint8_t c)
+{
+    if (c >= 'A' && c <= 'Z')
+    {
+        return (uint8_t)(c - 'A' + 'a');
+    }
+
+    return c;
+}
+
+// Compare a buffer with a string, ignoring the case of ASCII letters.
+// Returned value: true if they are equal.
+// Parameters:
+// - buffer, length: the buffer.
+// - str: the nil-terminated string.
+static bool prv_equalsIgnoreCase(const uint8_t *buffer,
+                                 size_t length,
+                                 const char *str)
+{
+    size_t i;
+
+    if (length != strlen(str))
+    {
+        return false;
+    }
+
+    for (i = 0; i < length; i++)
+    {
+        if (prv_toLower(buffer[i]) != prv_toLower((uint8_t)str[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Check if a comma-separated header field value contains a token, ignoring case.
+// Returned value: true if the token is in the list.
+// Parameters:
+// - value, length: the header field value.
+// - token: the token.
+static bool prv_hasToken(const uint8_t *value,
+                         size_t length,
+                         const char *token)
+{
+    size_t start;
+
+    start = 0;
+    while (start < length)
+    {
+        size_t end;
+        size_t last;
+
+        while (start < length
+               && (value[start] == ' ' || value[start] == '\t'))
+        {
+            start++;
+        }
+        end = start;
+        while (end < length
+               && value[end] != ',')
+        {
+            end++;
+        }
+        last = end;
+        while (last > start
+               && (value[last - 1] == ' ' || value[last - 1] == '\t'))
+        {
+            last--;
+        }
+
+        if (prv_equalsIgnoreCase(value + start, last - start, token) == true)
+        {
+            return true;
+        }
+
+        start = end + 1;
+    }
+
+    return false;
+}
+
+// Find a header field of an HTTP message.
+// Returned value: true if the field is present.
+// Parameters:
+// - buffer, length: the HTTP message, up to the empty line ending its header.
+// - name: the name of the header field.
+// - valueP: OUT. the start of the value, without the surrounding whitespaces.
+// - valueLengthP: OUT. the length of the value.
+static bool prv_findHeader(const uint8_t *buffer,
+                           size_t length,
+                           const char *name,
+                           const uint8_t **valueP,
+                           size_t *valueLengthP)
+{
+    size_t nameLength;
+    size_t index;
+
+    nameLength = strlen(name);
+
+    // Skip the start line
+    index = 0;
+    while (index + 1 < length
+           && (buffer[index] != '\r' || buffer[index + 1] != '\n'))
+    {
+        index++;
+    }
+    index += PRV_STR_LENGTH(PRV_HTTP_CRLF);
+
+    while (index < length)
+    {
+        size_t lineEnd;
+
+        lineEnd = index;
+        while (lineEnd + 1 < length
+               && (buffer[lineEnd] != '\r' || buffer[lineEnd + 1] != '\n'))
+        {
+            lineEnd++;
+        }
+        if (lineEnd + 1 >= length
+            || lineEnd == index)
+        {
+            // End of the header
+            break;
+        }
+
+        if (lineEnd - index > nameLength
+            && buffer[index + nameLength] == ':'
+            && prv_equalsIgnoreCase(buffer + index, nameLength, name) == true)
+        {
+            size_t start;
+
+            start = index + nameLength + 1;
+            while (start < lineEnd
+                   && (buffer[start] == ' ' || buffer[start] == '\t'))
+            {
+                start++;
+            }
+            while (lineEnd > start
+                   && (buffer[lineEnd - 1] == ' ' || buffer[lineEnd - 1] == '\t'))
+            {
+                lineEnd--;
+            }
+
+            *valueP = buffer + start;
+            *valueLengthP = lineEnd - start;
+            return true;
+        }
+
+        index = lineEnd + PRV_STR_LENGTH(PRV_HTTP_CRLF);
+    }
+
+    return false;
+}
+
+// Check that a header field of an HTTP message contains a token.
+// Returned value: true if the field is present and contains the token.
+// Parameters:
+// - buffer, length: the HTTP message, up to the empty line ending its header.
+// - name: the name of the header field.
+// - token: the expected token.
+static bool prv_checkHeader(const uint8_t *buffer,
+                            size_t length,
+                            const char *name,
+                            const char *token)
+{
+    const uint8_t *value;
+    size_t valueLength;
+
+    if (prv_findHeader(buffer, length, name, &value, &valueLength) == false
+        || prv_hasToken(value, valueLength, token) == false)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Header field \"%s\" of the opening handshake is missing or does not contain \"%s\".", name, token);
+        return false;
+    }
+
+    return true;
+}
+
+// Find the end of the header of an HTTP message.
+// Returned value: the length of the header including the final empty line, 0 if it is incomplete.
+// Parameters:
+// - buffer, length: the received bytes.
+static size_t prv_findHeaderEnd(const uint8_t *buffer,
+                                size_t length)
+{
+    size_t index;
+
+    for (index = 0; index + PRV_STR_LENGTH(PRV_HTTP_END) <= length; index++)
+    {
+        if (memcmp(buffer + index, PRV_HTTP_END, PRV_STR_LENGTH(PRV_HTTP_END)) == 0)
+        {
+            return index + PRV_STR_LENGTH(PRV_HTTP_END);
+        }
+    }
+
+    return 0;
+}
+
+// Check the response of the peer to our upgrade request.
+// Returned value: IOWA_COAP_NO_ERROR if the response accepts the upgrade or an error status.
+// Parameters:
+// - peerP: the peer.
+// - buffer, length: the response, up to the empty line ending its header.
+static uint8_t prv_checkResponse(coap_peer_stream_t *peerP,
+                                 const uint8_t *buffer,
+                                 size_t length)
+{
+    const uint8_t *value;
+    size_t valueLength;
+
+    // Status line: HTTP-version SP status-code SP reason-phrase
+    if (length < PRV_STR_LENGTH(PRV_HTTP_VERSION " " PRV_HTTP_STATUS_SWITCH)
+        || memcmp(buffer, PRV_HTTP_VERSION, PRV_STR_LENGTH(PRV_HTTP_VERSION)) != 0
+        || memcmp(buffer + PRV_STR_LENGTH(PRV_HTTP_VERSION " "), PRV_HTTP_STATUS_SWITCH, PRV_STR_LENGTH(PRV_HTTP_STATUS_SWITCH)) != 0)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Peer %p refused the WebSocket upgrade.", peerP);
+        return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+    }
+
+    if (prv_checkHeader(buffer, length, PRV_HEADER_UPGRADE, PRV_VALUE_UPGRADE) == false
+        || prv_checkHeader(buffer, length, PRV_HEADER_CONNECTION, PRV_VALUE_CONNECTION) == false
+        || prv_checkHeader(buffer, length, PRV_HEADER_PROTOCOL, PRV_VALUE_PROTOCOL) == false)
+    {
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    if (prv_findHeader(buffer, length, PRV_HEADER_ACCEPT, &value, &valueLength) == false
+        || valueLength != COAP_WS_ACCEPT_LENGTH
+        || memcmp(value, peerP->wsAccept, COAP_WS_ACCEPT_LENGTH) != 0)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Wrong Sec-WebSocket-Accept value from peer %p.", peerP);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Check the upgrade request of the peer and send the response.
+// Returned value: IOWA_COAP_NO_ERROR if the upgrade is accepted or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - buffer, length: the request, up to the empty line ending its header.
+static uint8_t prv_handleRequest(iowa_context_t contextP,
+                                 coap_peer_stream_t *peerP,
+                                 const uint8_t *buffer,
+                                 size_t length)
+{
+    uint8_t response[PRV_STR_LENGTH(PRV_HTTP_RESPONSE_START) + COAP_WS_ACCEPT_LENGTH + PRV_STR_LENGTH(PRV_HTTP_END)];
+    const uint8_t *key;
+    size_t keyLength;
+    size_t index;
+
+    // Request line: GET SP request-target SP HTTP-version
+    if (length < PRV_STR_LENGTH(PRV_HTTP_METHOD_GET " " COAP_WS_PATH " ")
+        || memcmp(buffer, PRV_HTTP_METHOD_GET " ", PRV_STR_LENGTH(PRV_HTTP_METHOD_GET " ")) != 0
+        || memcmp(buffer + PRV_STR_LENGTH(PRV_HTTP_METHOD_GET " "), COAP_WS_PATH " ", PRV_STR_LENGTH(COAP_WS_PATH " ")) != 0)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Peer %p did not request an upgrade of \"%s\".", peerP, COAP_WS_PATH);
+        goto bad_request;
+    }
+
+    if (prv_checkHeader(buffer, length, PRV_HEADER_UPGRADE, PRV_VALUE_UPGRADE) == false
+        || prv_checkHeader(buffer, length, PRV_HEADER_CONNECTION, PRV_VALUE_CONNECTION) == false
+        || prv_checkHeader(buffer, length, PRV_HEADER_VERSION, PRV_VALUE_VERSION) == false
+        || prv_checkHeader(buffer, length, PRV_HEADER_PROTOCOL, PRV_VALUE_PROTOCOL) == false)
+    {
+        goto bad_request;
+    }
+
+    if (prv_findHeader(buffer, length, PRV_HEADER_KEY, &key, &keyLength) == false
+        || keyLength != PRV_KEY_LENGTH)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Invalid Sec-WebSocket-Key from peer %p.", peerP);
+        goto bad_request;
+    }
+
+    index = PRV_STR_LENGTH(PRV_HTTP_RESPONSE_START);
+    memcpy(response, PRV_HTTP_RESPONSE_START, index);
+    prv_computeAccept(key, keyLength, response + index);
+    index += COAP_WS_ACCEPT_LENGTH;
+    memcpy(response + index, PRV_HTTP_END, PRV_STR_LENGTH(PRV_HTTP_END));
+    index += PRV_STR_LENGTH(PRV_HTTP_END);
+
+    return tcpSendBuffer(contextP, peerP, response, index);
+
+bad_request:
+    (void)tcpSendBuffer(contextP, peerP, (uint8_t *)PRV_HTTP_BAD_REQUEST, PRV_STR_LENGTH(PRV_HTTP_BAD_REQUEST));
+    return IOWA_COAP_400_BAD_REQUEST;
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+uint8_t websocketPeerInit(coap_peer_stream_t *peerP,
+                          const char *uri)
+{
+    // WARNING: This function is called in a critical section
+    const char *hostP;
+    size_t length;
+
+    // The Host header field is the authority of the URI
+    hostP = strstr(uri, "://");
+    if (hostP == NULL)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "No authority in URI \"%s\".", uri);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+    hostP += PRV_STR_LENGTH("://");
+    length = 0;
+    while (hostP[length] != 0
+           && hostP[length] != '/'
+           && hostP[length] != '?')
+    {
+        length++;
+    }
+
+    peerP->wsHost = utilsBufferToString((const uint8_t *)hostP, length);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (peerP->wsHost == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(length + 1);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+uint8_t websocketOpen(iowa_context_t contextP,
+                      coap_peer_stream_t *peerP)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t nonce[PRV_NONCE_LENGTH];
+    uint8_t key[PRV_KEY_LENGTH];
+    size_t keyLength;
+    size_t hostLength;
+    size_t length;
+    size_t index;
+    uint8_t *buffer;
+    uint8_t result;
+
+    if (peerP->wsHost == NULL)
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Waiting for the upgrade request of peer %p.", peerP);
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    // Without random nonces and masking keys, the connection is not opened
+    result = prv_random(contextP, nonce, PRV_NONCE_LENGTH);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+    utils_b64Encode(nonce, PRV_NONCE_LENGTH, key, &keyLength, BASE64_MODE_CLASSIC);
+    prv_computeAccept(key, keyLength, peerP->wsAccept);
+
+    hostLength = strlen(peerP->wsHost);
+    length = PRV_STR_LENGTH(PRV_HTTP_REQUEST_START) + hostLength + PRV_STR_LENGTH(PRV_HTTP_REQUEST_MIDDLE) + keyLength + PRV_STR_LENGTH(PRV_HTTP_END);
+
+    buffer = (uint8_t *)iowa_system_malloc(length);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (buffer == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(length);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    index = 0;
+    memcpy(buffer + index, PRV_HTTP_REQUEST_START, PRV_STR_LENGTH(PRV_HTTP_REQUEST_START));
+    index += PRV_STR_LENGTH(PRV_HTTP_REQUEST_START);
+    memcpy(buffer + index, peerP->wsHost, hostLength);
+    index += hostLength;
+    memcpy(buffer + index, PRV_HTTP_REQUEST_MIDDLE, PRV_STR_LENGTH(PRV_HTTP_REQUEST_MIDDLE));
+    index += PRV_STR_LENGTH(PRV_HTTP_REQUEST_MIDDLE);
+    memcpy(buffer + index, key, keyLength);
+    index += keyLength;
+    memcpy(buffer + index, PRV_HTTP_END, PRV_STR_LENGTH(PRV_HTTP_END));
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Sending the WebSocket upgrade request to peer %p.", peerP);
+
+    result = tcpSendBuffer(contextP, peerP, buffer, length);
+
+    iowa_system_free(buffer);
+
+    return result;
+}
+
+uint8_t websocketHandleHandshake(iowa_context_t contextP,
+                                 coap_peer_stream_t *peerP,
+                                 uint8_t *buffer,
+                                 size_t length,
+                                 size_t *handshakeLengthP)
+{
+    // WARNING: This function is called in a critical section
+    size_t headerLength;
+    uint8_t result;
+
+    *handshakeLengthP = 0;
+
+    headerLength = prv_findHeaderEnd(buffer, length);
+    if (headerLength == 0)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    if (peerP->wsHost != NULL)
+    {
+        result = prv_checkResponse(peerP, buffer, headerLength);
+    }
+    else
+    {
+        result = prv_handleRequest(contextP, peerP, buffer, headerLength);
+    }
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "WebSocket opening handshake with peer %p done.", peerP);
+
+    *handshakeLengthP = headerLength;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+uint8_t websocketParseFrameHeader(coap_peer_stream_t *peerP,
+                                  uint8_t *buffer,
+                                  size_t length,
+                                  coap_ws_frame_t *frameP,
+                                  size_t *headerLengthP)
+{
+    size_t headerLength;
+    uint8_t lengthField;
+    uint8_t i;
+
+    *headerLengthP = 0;
+
+    if (length < 2)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    if ((buffer[0] & PRV_FRAME_RSV_MASK) != 0)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Frame from peer %p uses reserved bits.", peerP);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+    frameP->isFinal = (buffer[0] & PRV_FRAME_FIN) != 0;
+    frameP->opcode = buffer[0] & PRV_FRAME_OPCODE_MASK;
+    frameP->isMasked = (buffer[1] & PRV_FRAME_MASK) != 0;
+
+    // Only the frames sent by the peer which opened the connection are masked
+    if (frameP->isMasked != (peerP->wsHost == NULL))
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Frame from peer %p is wrongly %s.", peerP, frameP->isMasked ? "masked" : "unmasked");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    lengthField = buffer[1] & PRV_FRAME_LENGTH_MASK;
+    headerLength = 2;
+    switch (lengthField)
+    {
+    case PRV_FRAME_LENGTH_16:
+        headerLength += 2;
+        break;
+
+    case PRV_FRAME_LENGTH_64:
+        headerLength += 8;
+        break;
+
+    default:
+        break;
+    }
+    if (frameP->isMasked == true)
+    {
+        headerLength += PRV_FRAME_MASK_KEY_LENGTH;
+    }
+    if (length < headerLength)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    switch (lengthField)
+    {
+    case PRV_FRAME_LENGTH_16:
+        frameP->length = ((uint64_t)buffer[2] << 8) | (uint64_t)buffer[3];
+        break;
+
+    case PRV_FRAME_LENGTH_64:
+        frameP->length = 0;
+        for (i = 0; i < 8; i++)
+        {
+            frameP->length = (frameP->length << 8) | (uint64_t)buffer[2 + i];
+        }
+        if ((frameP->length >> 63) != 0)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Frame length from peer %p is invalid.", peerP);
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+        break;
+
+    default:
+        frameP->length = lengthField;
+        break;
+    }
+
+    if ((frameP->opcode & PRV_FRAME_CONTROL_MASK) != 0
+        && (frameP->isFinal == false
+            || frameP->length > PRV_CONTROL_MAX_PAYLOAD))
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Control frame from peer %p is fragmented or too long.", peerP);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    if (frameP->isMasked == true)
+    {
+        memcpy(frameP->maskKey, buffer + headerLength - PRV_FRAME_MASK_KEY_LENGTH, PRV_FRAME_MASK_KEY_LENGTH);
+    }
+
+    *headerLengthP = headerLength;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+void websocketUnmask(coap_ws_frame_t *frameP,
+                     uint8_t *payload,
+                     size_t length)
+{
+    size_t i;
+
+    if (frameP->isMasked == false)
+    {
+        return;
+    }
+
+    for (i = 0; i < length; i++)
+    {
+        payload[i] ^= frameP->maskKey[i & 0x03];
+    }
+}
+
+size_t websocketFrame(iowa_context_t contextP,
+                      coap_peer_stream_t *peerP,
+                      uint8_t opcode,
+                      uint8_t *payload,
+                      size_t length,
+                      size_t frameLength)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t header[COAP_WS_FRAME_MAX_HEADER_LENGTH];
+    size_t headerLength;
+    bool isMasked;
+    uint8_t i;
+
+    isMasked = (peerP->wsHost != NULL);
+
+    header[0] = (uint8_t)(PRV_FRAME_FIN | opcode);
+    if (frameLength < PRV_FRAME_LENGTH_16)
+    {
+        header[1] = (uint8_t)frameLength;
+        headerLength = 2;
+    }
+    else if (frameLength <= UINT16_MAX)
+    {
+        header[1] = PRV_FRAME_LENGTH_16;
+        header[2] = (uint8_t)(frameLength >> 8);
+        header[3] = (uint8_t)frameLength;
+        headerLength = 4;
+    }
+    else
+    {
+        header[1] = PRV_FRAME_LENGTH_64;
+        for (i = 0; i < 8; i++)
+        {
+            header[9 - i] = (uint8_t)((uint64_t)frameLength >> (8 * i));
+        }
+        headerLength = 10;
+    }
+
+    if (isMasked == true)
+    {
+        size_t j;
+
+        header[1] |= PRV_FRAME_MASK;
+        if (prv_random(contextP, header + headerLength, PRV_FRAME_MASK_KEY_LENGTH) != IOWA_COAP_NO_ERROR)
+        {
+            return 0;
+        }
+
+        // The payload is masked in place, no copy is made
+        for (j = 0; j < length; j++)
+        {
+            payload[j] ^= header[headerLength + (j & 0x03)];
+        }
+
+        headerLength += PRV_FRAME_MASK_KEY_LENGTH;
+    }
+
+    memcpy(payload - headerLength, header, headerLength);
+
+    return headerLength;
+}
+
+uint8_t websocketSendControl(iowa_context_t contextP,
+                             coap_peer_stream_t *peerP,
+                             uint8_t opcode,
+                             const uint8_t *payload,
+                             size_t length)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t buffer[COAP_WS_FRAME_MAX_HEADER_LENGTH + PRV_CONTROL_MAX_PAYLOAD];
+    size_t headerLength;
+
+    if (length > PRV_CONTROL_MAX_PAYLOAD)
+    {
+        length = PRV_CONTROL_MAX_PAYLOAD;
+    }
+    if (length > 0)
+    {
+        memcpy(buffer + COAP_WS_FRAME_MAX_HEADER_LENGTH, payload, length);
+    }
+
+    headerLength = websocketFrame(contextP, peerP, opcode, buffer + COAP_WS_FRAME_MAX_HEADER_LENGTH, length, length);
+    if (headerLength == 0)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return tcpSendBuffer(contextP, peerP, buffer + COAP_WS_FRAME_MAX_HEADER_LENGTH - headerLength, headerLength + length);
+}
+
+#endif // IOWA_WEBSOCKET_SUPPORT
@@ -47,23 +47,26 @@
 #define PRV_STREAM_MSG_LENGTH_EXTEND_2   0x0E
 #define PRV_STREAM_MSG_LENGTH_EXTEND_3   0x0F
 
-size_t coapMessageSerializeDatagram(iowa_coap_message_t *messageP,
-                                    uint8_t **bufferP)
+// Compute the length of a serialized datagram CoAP message without its payload.
+// Returned value: the length of the header, token, options and payload marker or 0 in case of error.
+// Parameters:
+// - messageP: the CoAP message.
+static size_t prv_getDatagramHeaderLength(iowa_coap_message_t *messageP)
 {
-    size_t bufferLength;
-    uint8_t *buffer;
-    size_t index;
+    size_t length;
     iowa_coap_option_t *optionP;
     uint16_t prevNumber;
 
-    IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering");
+    if (messageP->tokenLength > COAP_MSG_TOKEN_MAX_LEN)
+    {
+        messageP->tokenLength = 0;
+    }
 
-    // Compute serialized length
-    bufferLength = PRV_DATAGRAM_MSG_HEADER_LENGTH + (size_t)messageP->tokenLength + messageP->payload.length;
+    length = PRV_DATAGRAM_MSG_HEADER_LENGTH + (size_t)messageP->tokenLength;
 
     if (messageP->payload.length != 0)
     {
-        bufferLength += 1;
+        length += 1;
     }
 
     prevNumber = 0;
@@ -74,22 +77,22 @@ size_t coapMessageSerializeDatagram(iowa_coap_message_t *messageP,
             IOWA_LOG_WARNING(IOWA_PART_COAP, "Exit on error: options are not in order.");
             return 0;
         }
-        bufferLength += option_getSerializedLength(optionP, iowa_coap_option_is_integer);
+        length += option_getSerializedLength(optionP, iowa_coap_option_is_integer);
         prevNumber = optionP->number;
     }
 
-    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Estimated length: %u", bufferLength);
+    return length;
+}
 
-    // Allocate buffer for serialized packet
-    buffer = (uint8_t *)iowa_system_malloc(bufferLength);
-#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-    if (buffer == NULL)
-    {
-        IOWA_LOG_ERROR_MALLOC(bufferLength);
-        return 0;
-    }
-#endif
-    memset(buffer, 0, bufferLength);
+// Write the header, token, options and payload marker of a datagram CoAP message.
+// Returned value: the number of bytes written.
+// Parameters:
+// - messageP: the CoAP message.
+// - buffer: to store the serialized header. Its length must be at least prv_getDatagramHeaderLength().
+static size_t prv_serializeDatagramHeader(iowa_coap_message_t *messageP,
+                                          uint8_t *buffer)
+{
+    size_t index;
 
     // Set CoAP header
     buffer[0] = (uint8_t)(PRV_DATAGRAM_MSG_HEADER_VERSION + (messageP->type << PRV_DATAGRAM_MSG_HEADER_TYPE_SHIFT) + messageP->tokenLength);
@@ -98,24 +101,225 @@ size_t coapMessageSerializeDatagram(iowa_coap_message_t *messageP,
     buffer[3] = (uint8_t)(messageP->id & 0xFF);
 
     // Add token if any
-    if (messageP->tokenLength > 0 && messageP->tokenLength <= COAP_MSG_TOKEN_MAX_LEN)
+    if (messageP->tokenLength > 0)
     {
         memcpy(buffer + PRV_DATAGRAM_MSG_TOKEN_OFFSET, messageP->token, messageP->tokenLength);
     }
-    else
+
+    index = (size_t)(PRV_DATAGRAM_MSG_TOKEN_OFFSET + messageP->tokenLength);
+
+    index += option_serialize(messageP->optionList, buffer + index, iowa_coap_option_is_integer);
+
+    if (messageP->payload.length != 0)
+    {
+        buffer[index] = PRV_MSG_PAYLOAD_MARKER;
+        index++;
+    }
+
+    return index;
+}
+
+// Parse the options and the payload of a CoAP message. The payload is not copied.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - buffer: the serialized options, payload marker and payload.
+// - bufferLength: the length of buffer.
+// - messageP: the message to fill.
+static uint8_t prv_parseBody(iowa_context_t contextP,
+                             uint8_t *buffer,
+                             size_t bufferLength,
+                             iowa_coap_message_t *messageP)
+{
+    uint8_t result;
+    size_t index;
+
+#if IOWA_COAP_INLINE_OPTION_COUNT > 0
+    result = option_parse(contextP, buffer, bufferLength, messageP->optionArray, IOWA_COAP_INLINE_OPTION_COUNT, &(messageP->optionList), &index, iowa_coap_option_is_integer);
+#else
+    result = option_parse(contextP, buffer, bufferLength, NULL, 0, &(messageP->optionList), &index, iowa_coap_option_is_integer);
+#endif
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Parsing of the options failed.");
+        return result;
+    }
+
+    if (index < bufferLength)
+    {
+        if (buffer[index] == PRV_MSG_PAYLOAD_MARKER)
+        {
+            index += 1;
+            messageP->payload.length = bufferLength - index;
+            messageP->payload.data = buffer + index;
+        }
+        else
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Expected payload marker not found at %u.", index);
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
+// Compute the maximum length of a serialized stream CoAP message without its payload.
+// Returned value: the maximum length of the header, token, options and payload marker or 0 in case of error.
+// Parameters:
+// - messageP: the CoAP message.
+static size_t prv_getStreamHeaderLength(iowa_coap_message_t *messageP)
+{
+    size_t length;
+    iowa_coap_option_t *optionP;
+    uint16_t prevNumber;
+
+    if (messageP->tokenLength > COAP_MSG_TOKEN_MAX_LEN)
     {
         messageP->tokenLength = 0;
     }
 
-    index = (size_t)(PRV_DATAGRAM_MSG_TOKEN_OFFSET + messageP->tokenLength);
+    length = PRV_STREAM_MSG_MAX_HEADER_LENGTH + (size_t)messageP->tokenLength;
 
-    index += option_serialize(messageP->optionList, buffer + index, iowa_coap_option_is_integer);
+    if (messageP->payload.length != 0)
+    {
+        length += 1;
+    }
+
+    prevNumber = 0;
+    for (optionP = messageP->optionList; optionP != NULL; optionP = optionP->next)
+    {
+        if (optionP->number < prevNumber)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_COAP, "Exit on error: options are not in order.");
+            return 0;
+        }
+        length += option_getSerializedLength(optionP, iowa_coap_option_is_integer);
+        prevNumber = optionP->number;
+    }
+
+    return length;
+}
+
+// Write the header, token, options and payload marker of a stream CoAP message.
+// The options are first written after the longest possible header, then moved back once the length
+// of the message, which depends on their exact size, is known.
+// Returned value: the number of bytes written.
+// Parameters:
+// - messageP: the CoAP message.
+// - withLength: false if the length is given by the transport framing (WebSockets). The Len field is then zero.
+// - buffer: to store the serialized header. Its length must be at least prv_getStreamHeaderLength().
+static size_t prv_serializeStreamHeader(iowa_coap_message_t *messageP,
+                                        bool withLength,
+                                        uint8_t *buffer)
+{
+    size_t optionsLength;
+    size_t bodyLength;
+    size_t index;
+    uint8_t lenField;
+
+    optionsLength = option_serialize(messageP->optionList, buffer + PRV_STREAM_MSG_MAX_HEADER_LENGTH + messageP->tokenLength, iowa_coap_option_is_integer);
+
+    bodyLength = optionsLength;
+    if (messageP->payload.length != 0)
+    {
+        bodyLength += 1 + messageP->payload.length;
+    }
+
+    index = 1;
+    if (withLength == false)
+    {
+        lenField = 0;
+    }
+    else if (bodyLength < PRV_STREAM_MSG_LENGTH_LIMIT_1)
+    {
+        lenField = (uint8_t)bodyLength;
+    }
+    else if (bodyLength < PRV_STREAM_MSG_LENGTH_LIMIT_2)
+    {
+        lenField = PRV_STREAM_MSG_LENGTH_EXTEND_1;
+        buffer[index] = (uint8_t)(bodyLength - PRV_STREAM_MSG_LENGTH_LIMIT_1);
+        index += 1;
+    }
+    else if (bodyLength < PRV_STREAM_MSG_LENGTH_LIMIT_3)
+    {
+        lenField = PRV_STREAM_MSG_LENGTH_EXTEND_2;
+        bodyLength -= PRV_STREAM_MSG_LENGTH_LIMIT_2;
+        buffer[index] = (uint8_t)((bodyLength >> 8) & 0xFF);
+        buffer[index + 1] = (uint8_t)(bodyLength & 0xFF);
+        index += 2;
+    }
+    else
+    {
+        lenField = PRV_STREAM_MSG_LENGTH_EXTEND_3;
+        bodyLength -= PRV_STREAM_MSG_LENGTH_LIMIT_3;
+        buffer[index] = (uint8_t)((bodyLength >> 24) & 0xFF);
+        buffer[index + 1] = (uint8_t)((bodyLength >> 16) & 0xFF);
+        buffer[index + 2] = (uint8_t)((bodyLength >> 8) & 0xFF);
+        buffer[index + 3] = (uint8_t)(bodyLength & 0xFF);
+        index += 4;
+    }
+
+    buffer[0] = (uint8_t)((lenField << PRV_STREAM_MSG_HEADER_LEN_SHIFT) + messageP->tokenLength);
+    buffer[index] = messageP->code;
+    index += 1;
+
+    if (messageP->tokenLength > 0)
+    {
+        memcpy(buffer + index, messageP->token, messageP->tokenLength);
+        index += messageP->tokenLength;
+    }
+
+    if (index < PRV_STREAM_MSG_MAX_HEADER_LENGTH + (size_t)messageP->tokenLength)
+    {
+        memmove(buffer + index, buffer + PRV_STREAM_MSG_MAX_HEADER_LENGTH + messageP->tokenLength, optionsLength);
+    }
+    index += optionsLength;
 
-    // Add payload if any
     if (messageP->payload.length != 0)
     {
         buffer[index] = PRV_MSG_PAYLOAD_MARKER;
         index++;
+    }
+
+    return index;
+}
+#endif // defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
+
+size_t coapMessageSerializeDatagram(iowa_coap_message_t *messageP,
+                                    uint8_t **bufferP)
+{
+    size_t bufferLength;
+    uint8_t *buffer;
+    size_t index;
+
+    IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering");
+
+    // Compute serialized length
+    bufferLength = prv_getDatagramHeaderLength(messageP);
+    if (bufferLength == 0)
+    {
+        return 0;
+    }
+    bufferLength += messageP->payload.length;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Estimated length: %u", bufferLength);
+
+    // Allocate buffer for serialized packet
+    buffer = (uint8_t *)iowa_system_malloc(bufferLength);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (buffer == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(bufferLength);
+        return 0;
+    }
+#endif
+
+    index = prv_serializeDatagramHeader(messageP, buffer);
+
+    // Add payload if any
+    if (messageP->payload.length != 0)
+    {
         memcpy(buffer + index, messageP->payload.data, messageP->payload.length);
         index += messageP->payload.length;
     }
@@ -127,7 +331,27 @@ size_t coapMessageSerializeDatagram(iowa_coap_message_t *messageP,
     return index;
 }
 
-size_t messageDatagramParseHeader(uint8_t *buffer,
+size_t coapMessageSerializeDatagramHeader(iowa_coap_message_t *messageP,
+                                          uint8_t *buffer,
+                                          size_t bufferLength)
+{
+    size_t length;
+
+    IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering");
+
+    length = prv_getDatagramHeaderLength(messageP);
+    if (length == 0
+        || length > bufferLength)
+    {
+        IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Header of %u bytes does not fit in %u bytes.", length, bufferLength);
+        return 0;
+    }
+
+    return prv_serializeDatagramHeader(messageP, buffer);
+}
+
+size_t messageDatagramParseHeader(iowa_context_t contextP,
+                                  uint8_t *buffer,
                                   size_t bufferLength,
                                   iowa_coap_message_t **messageP)
 {
@@ -159,7 +383,7 @@ size_t messageDatagramParseHeader(uint8_t *buffer,
         return 0;
     }
 
-    *messageP = (iowa_coap_message_t *)iowa_system_malloc(sizeof(iowa_coap_message_t));
+    *messageP = (iowa_coap_message_t *)CORE_POOL_ALLOC(contextP, CORE_POOL_MESSAGE, sizeof(iowa_coap_message_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     if (*messageP == NULL)
     {
@@ -181,48 +405,199 @@ size_t messageDatagramParseHeader(uint8_t *buffer,
     return (size_t)(tokenLen + PRV_DATAGRAM_MSG_HEADER_LENGTH);
 }
 
-uint8_t messageDatagramParse(uint8_t *buffer,
+uint8_t messageDatagramParse(iowa_context_t contextP,
+                             uint8_t *buffer,
                              size_t bufferLength,
                              iowa_coap_message_t **messageP)
 {
     size_t index;
     uint8_t result;
-    size_t optLen;
 
-    index = messageDatagramParseHeader(buffer, bufferLength, messageP);
+    index = messageDatagramParseHeader(contextP, buffer, bufferLength, messageP);
     if (index == 0)
     {
         IOWA_LOG_INFO(IOWA_PART_COAP, "CoAP Header parsing failed.");
         return IOWA_COAP_400_BAD_REQUEST;
     }
 
-    result = option_parse(buffer + index, bufferLength - index, &((*messageP)->optionList), &optLen, iowa_coap_option_is_integer);
+    result = prv_parseBody(contextP, buffer + index, bufferLength - index, *messageP);
     if (result != IOWA_COAP_NO_ERROR)
     {
-        IOWA_LOG_WARNING(IOWA_PART_COAP, "Parsing of the options failed.");
         iowa_coap_message_free(*messageP);
         *messageP = NULL;
-        return result;
     }
 
-    index += optLen;
+    return result;
+}
 
-    if (index < bufferLength)
+#if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
+size_t coapMessageSerializeStream(iowa_coap_message_t *messageP,
+                                  bool withLength,
+                                  size_t headroom,
+                                  uint8_t **bufferP)
+{
+    size_t bufferLength;
+    uint8_t *buffer;
+    size_t index;
+
+    IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering");
+
+    // Compute the maximum serialized length
+    bufferLength = prv_getStreamHeaderLength(messageP);
+    if (bufferLength == 0)
     {
-        if (buffer[index] == PRV_MSG_PAYLOAD_MARKER)
-        {
-            index += 1;
-            (*messageP)->payload.length = bufferLength - index;
-            (*messageP)->payload.data = buffer + index;
-        }
-        else
+        return 0;
+    }
+    bufferLength += headroom + messageP->payload.length;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Estimated length: %u", bufferLength);
+
+    buffer = (uint8_t *)iowa_system_malloc(bufferLength);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (buffer == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(bufferLength);
+        return 0;
+    }
+#endif
+
+    index = headroom + prv_serializeStreamHeader(messageP, withLength, buffer + headroom);
+
+    if (messageP->payload.length != 0)
+    {
+        memcpy(buffer + index, messageP->payload.data, messageP->payload.length);
+        index += messageP->payload.length;
+    }
+
+    *bufferP = buffer;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Serialized message is %u bytes.", index);
+
+    return index;
+}
+
+size_t coapMessageSerializeStreamHeader(iowa_coap_message_t *messageP,
+                                        bool withLength,
+                                        uint8_t *buffer,
+                                        size_t bufferLength)
+{
+    size_t length;
+
+    IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering");
+
+    length = prv_getStreamHeaderLength(messageP);
+    if (length == 0
+        || length > bufferLength)
+    {
+        IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Header of %u bytes does not fit in %u bytes.", length, bufferLength);
+        return 0;
+    }
+
+    return prv_serializeStreamHeader(messageP, withLength, buffer);
+}
+
+uint8_t messageStreamParseLengthField(uint8_t lenField)
+{
+    switch ((lenField & PRV_STREAM_MSG_HEADER_LEN_MASK) >> PRV_STREAM_MSG_HEADER_LEN_SHIFT)
+    {
+    case PRV_STREAM_MSG_LENGTH_EXTEND_1:
+        return PRV_STREAM_MSG_MIN_HEADER_LENGTH + 1;
+
+    case PRV_STREAM_MSG_LENGTH_EXTEND_2:
+        return PRV_STREAM_MSG_MIN_HEADER_LENGTH + 2;
+
+    case PRV_STREAM_MSG_LENGTH_EXTEND_3:
+        return PRV_STREAM_MSG_MAX_HEADER_LENGTH;
+
+    default:
+        return PRV_STREAM_MSG_MIN_HEADER_LENGTH;
+    }
+}
+
+uint8_t messageStreamParseHeader(iowa_context_t contextP,
+                                 uint8_t *buffer,
+                                 size_t bufferLength,
+                                 iowa_coap_message_t **messageP,
+                                 size_t *lengthP)
+{
+    uint8_t headerLength;
+    uint8_t tokenLen;
+    size_t length;
+
+    *messageP = NULL;
+
+    if (bufferLength < PRV_STREAM_MSG_MIN_HEADER_LENGTH)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Buffer length is only %u.", bufferLength);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    tokenLen = (buffer[0] & PRV_STREAM_MSG_HEADER_TOKEN_MASK);
+    if (tokenLen > COAP_MSG_TOKEN_MAX_LEN)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Token length is too big: %u.", tokenLen);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    headerLength = messageStreamParseLengthField(buffer[0]);
+    if ((size_t)(headerLength + tokenLen) > bufferLength)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Buffer is too short (%u bytes) for the declared header and token lengths (%u, %u).", bufferLength, headerLength, tokenLen);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    length = (buffer[0] & PRV_STREAM_MSG_HEADER_LEN_MASK) >> PRV_STREAM_MSG_HEADER_LEN_SHIFT;
+    switch (length)
+    {
+    case PRV_STREAM_MSG_LENGTH_EXTEND_1:
+        length = PRV_STREAM_MSG_LENGTH_LIMIT_1 + (size_t)buffer[1];
+        break;
+
+    case PRV_STREAM_MSG_LENGTH_EXTEND_2:
+        length = PRV_STREAM_MSG_LENGTH_LIMIT_2 + (((size_t)buffer[1] << 8) | (size_t)buffer[2]);
+        break;
+
+    case PRV_STREAM_MSG_LENGTH_EXTEND_3:
+        length = ((uint32_t)buffer[1] << 24) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 8) | (uint32_t)buffer[4];
+        if (length > UINT32_MAX - PRV_STREAM_MSG_LENGTH_LIMIT_3)
         {
-            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Expected payload marker not found at %u.", bufferLength, index);
-            iowa_coap_message_free(*messageP);
-            *messageP = NULL;
-            return IOWA_COAP_400_BAD_REQUEST;
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Message length is too big: %u.", length);
+            return IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
         }
+        length += PRV_STREAM_MSG_LENGTH_LIMIT_3;
+        break;
+
+    default:
+        break;
     }
 
+    *messageP = (iowa_coap_message_t *)CORE_POOL_ALLOC(contextP, CORE_POOL_MESSAGE, sizeof(iowa_coap_message_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*messageP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(iowa_coap_message_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(*messageP, 0, sizeof(iowa_coap_message_t));
+
+    (*messageP)->code = buffer[headerLength - 1];
+    if (tokenLen > 0)
+    {
+        (*messageP)->tokenLength = tokenLen;
+        memcpy((*messageP)->token, buffer + headerLength, tokenLen);
+    }
+
+    *lengthP = length;
+
     return IOWA_COAP_NO_ERROR;
 }
+
+uint8_t messageStreamParseBody(iowa_context_t contextP,
+                               uint8_t *buffer,
+                               size_t bufferLength,
+                               iowa_coap_message_t *messageP)
+{
+    return prv_parseBody(contextP, buffer, bufferLength, messageP);
+}
+#endif // defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
@@ -30,9 +30,11 @@ bool iowa_coap_option_is_integer(const iowa_coap_option_t *optionP)
     case IOWA_COAP_OPTION_CONTENT_FORMAT:
     case IOWA_COAP_OPTION_MAX_AGE:
     case IOWA_COAP_OPTION_ACCEPT:
+    case IOWA_COAP_OPTION_Q_BLOCK_1:
     case IOWA_COAP_OPTION_BLOCK_2:
     case IOWA_COAP_OPTION_BLOCK_1:
     case IOWA_COAP_OPTION_SIZE_2:
+    case IOWA_COAP_OPTION_Q_BLOCK_2:
     case IOWA_COAP_OPTION_SIZE_1:
     case IOWA_COAP_OPTION_NO_RESPONSE:
         return true;
@@ -186,7 +188,11 @@ size_t option_serialize(iowa_coap_option_t *optionList,
                 optBuffer[0] |= (uint8_t)valueLen;
             }
 
-            memcpy(optBuffer + hdrLen, optionP->value.asBuffer, optionP->length);
+            if (optionP->length != 0)
+            {
+                // Empty options can have no buffer
+                memcpy(optBuffer + hdrLen, optionP->value.asBuffer, optionP->length);
+            }
             valueLen = optionP->length;
         }
 
@@ -197,17 +203,24 @@ size_t option_serialize(iowa_coap_option_t *optionList,
     return index;
 }
 
-uint8_t option_parse(uint8_t *buffer,
+// The options are first decoded in optionArray, then allocated once optionArray is full.
+// Buffer values point to buffer which must remain valid as long as the options are used.
+uint8_t option_parse(iowa_context_t contextP,
+                     uint8_t *buffer,
                      size_t bufferLength,
+                     iowa_coap_option_t *optionArray,
+                     size_t optionArrayLength,
                      iowa_coap_option_t **optionListP,
                      size_t *lengthP,
                      coap_option_callback_t isIntegerCallback)
 {
     uint8_t result;
     size_t index;
+    size_t optionCount;
     iowa_coap_option_t *currOptionP;
 
     index = 0;
+    optionCount = 0;
     currOptionP = NULL;
 
     while (index < bufferLength
@@ -215,6 +228,7 @@ uint8_t option_parse(uint8_t *buffer,
     {
         uint16_t delta;
         uint16_t length;
+        iowa_coap_option_t *newOptionP;
 
         delta = ((uint8_t)(buffer[index] & PRV_OPT_DELTA_MASK)) >> PRV_OPT_DELTA_SHIFT;
         length = buffer[index] & PRV_OPT_LENGTH_MASK;
@@ -285,30 +299,38 @@ uint8_t option_parse(uint8_t *buffer,
 
         if (currOptionP != NULL)
         {
-            currOptionP->next = iowa_coap_option_new((uint16_t)(currOptionP->number + delta));
-#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-            if (currOptionP->next == NULL)
-            {
-                IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP option.");
-                result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
-                goto exit_on_error;
-            }
-#endif
-            currOptionP = currOptionP->next;
+            delta = (uint16_t)(currOptionP->number + delta);
+        }
+
+        if (optionCount < optionArrayLength)
+        {
+            newOptionP = optionArray + optionCount;
+            memset(newOptionP, 0, sizeof(iowa_coap_option_t));
+            newOptionP->number = delta;
         }
         else
         {
-            *optionListP = iowa_coap_option_new(delta);
+            newOptionP = iowa_coap_option_new(contextP, delta);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-            if (*optionListP == NULL)
+            if (newOptionP == NULL)
             {
                 IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP option.");
                 result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
                 goto exit_on_error;
             }
 #endif
-            currOptionP = *optionListP;
         }
+        optionCount++;
+
+        if (currOptionP != NULL)
+        {
+            currOptionP->next = newOptionP;
+        }
+        else
+        {
+            *optionListP = newOptionP;
+        }
+        currOptionP = newOptionP;
 
         if (length > 0)
         {
@@ -341,17 +363,18 @@ uint8_t option_parse(uint8_t *buffer,
     return IOWA_COAP_NO_ERROR;
 
 exit_on_error:
-    iowa_coap_option_free(*optionListP);
+    option_freeList(*optionListP, optionArray, optionArrayLength);
     *optionListP = NULL;
 
     return result;
 }
 
-iowa_coap_option_t * iowa_coap_option_new(uint16_t number)
+iowa_coap_option_t * iowa_coap_option_new(iowa_context_t contextP,
+                                          uint16_t number)
 {
     iowa_coap_option_t *optionP;
 
-    optionP = (iowa_coap_option_t *)iowa_system_malloc(sizeof(iowa_coap_option_t));
+    optionP = (iowa_coap_option_t *)CORE_POOL_ALLOC(contextP, CORE_POOL_OPTION, sizeof(iowa_coap_option_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     if (optionP == NULL)
     {
@@ -365,12 +388,37 @@ iowa_coap_option_t * iowa_coap_option_new(uint16_t number)
     return optionP;
 }
 
+static void prv_freeOption(iowa_coap_option_t *optionP)
+{
+    CORE_POOL_FREE(optionP);
+}
+
 void iowa_coap_option_free(iowa_coap_option_t *optionP)
 {
-    IOWA_UTILS_LIST_FREE(optionP, iowa_system_free);
+    IOWA_UTILS_LIST_FREE(optionP, prv_freeOption);
+}
+
+void option_freeList(iowa_coap_option_t *optionList,
+                     iowa_coap_option_t *optionArray,
+                     size_t optionArrayLength)
+{
+    while (optionList != NULL)
+    {
+        iowa_coap_option_t *nextP;
+
+        nextP = optionList->next;
+        if (optionArrayLength == 0
+            || optionList < optionArray
+            || optionList >= optionArray + optionArrayLength)
+        {
+            prv_freeOption(optionList);
+        }
+        optionList = nextP;
+    }
 }
 
-iowa_coap_option_t * iowa_coap_path_to_option(uint16_t number,
+iowa_coap_option_t * iowa_coap_path_to_option(iowa_context_t contextP,
+                                              uint16_t number,
                                               const char *path,
                                               char delimiter)
 {
@@ -378,7 +426,7 @@ iowa_coap_option_t * iowa_coap_path_to_option(uint16_t number,
     iowa_coap_option_t *currentP;
     size_t i;
 
-    optionP = iowa_coap_option_new(number);
+    optionP = iowa_coap_option_new(contextP, number);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     if (optionP == NULL)
     {
@@ -415,7 +463,7 @@ iowa_coap_option_t * iowa_coap_path_to_option(uint16_t number,
         i = end;
         if (path[i] != 0)
         {
-            currentP->next = iowa_coap_option_new(number);
+            currentP->next = iowa_coap_option_new(contextP, number);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (currentP->next == NULL)
             {
@@ -27,12 +27,317 @@
 ** Private functions
 *************************************************************************************/
 
-#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
-static bool prv_exchangeFindCallback(void *nodeP,
-                                     void *criteriaP)
+// Hash a token with FNV-1a.
+// Returned value: the hash of the token.
+// Parameters:
+// - tokenLength: the length in bytes of the token.
+// - token: the token.
+static uint32_t prv_tokenHash(uint8_t tokenLength,
+                              const uint8_t *token)
+{
+    uint32_t hash;
+    uint8_t i;
+
+    hash = 2166136261u;
+    for (i = 0; i < tokenLength; i++)
+    {
+        hash ^= token[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+// Find the exchange matching a token.
+// Returned value: the index of the slot holding the exchange or exchangeTableSize if not found.
+// Parameters:
+// - peerP: the CoAP peer.
+// - tokenLength: the length in bytes of the token.
+// - token: the token.
+static size_t prv_exchangeFind(iowa_coap_peer_t *peerP,
+                               uint8_t tokenLength,
+                               const uint8_t *token)
+{
+    // WARNING: This function is called in a critical section
+    size_t mask;
+    size_t index;
+
+    if (peerP->base.exchangeCount == 0)
+    {
+        return peerP->base.exchangeTableSize;
+    }
+
+    mask = peerP->base.exchangeTableSize - 1;
+    index = prv_tokenHash(tokenLength, token) & mask;
+    while (peerP->base.exchangeTable[index] != NULL)
+    {
+        if (peerP->base.exchangeTable[index]->tokenLength == tokenLength
+            && 0 == memcmp(peerP->base.exchangeTable[index]->token, token, tokenLength))
+        {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+
+    return peerP->base.exchangeTableSize;
+}
+
+// Insert an exchange in the table. The table must have a free slot.
+// Returned value: none.
+// Parameters:
+// - exchangeTable: the table.
+// - exchangeTableSize: the number of slots of the table.
+// - exchangeP: the exchange to insert.
+static void prv_exchangeInsert(coap_exchange_t **exchangeTable,
+                               size_t exchangeTableSize,
+                               coap_exchange_t *exchangeP)
+{
+    // WARNING: This function is called in a critical section
+    size_t index;
+
+    index = prv_tokenHash(exchangeP->tokenLength, exchangeP->token) & (exchangeTableSize - 1);
+    while (exchangeTable[index] != NULL)
+    {
+        index = (index + 1) & (exchangeTableSize - 1);
+    }
+    exchangeTable[index] = exchangeP;
+}
+
+// Grow the exchange table so that one more exchange can be added while keeping the load factor under one half.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - peerP: the CoAP peer.
+static uint8_t prv_exchangeReserve(iowa_coap_peer_t *peerP)
+{
+    // WARNING: This function is called in a critical section
+    coap_exchange_t **newTable;
+    size_t newSize;
+    size_t i;
+
+    if ((peerP->base.exchangeCount + 1) * 2 <= peerP->base.exchangeTableSize)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    if (peerP->base.exchangeTableSize == 0)
+    {
+        newSize = COAP_EXCHANGE_TABLE_MIN_SIZE;
+    }
+    else
+    {
+        newSize = peerP->base.exchangeTableSize * 2;
+    }
+
+    newTable = (coap_exchange_t **)iowa_system_malloc(newSize * sizeof(coap_exchange_t *));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (newTable == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(newSize * sizeof(coap_exchange_t *));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(newTable, 0, newSize * sizeof(coap_exchange_t *));
+
+    for (i = 0; i < peerP->base.exchangeTableSize; i++)
+    {
+        if (peerP->base.exchangeTable[i] != NULL)
+        {
+            prv_exchangeInsert(newTable, newSize, peerP->base.exchangeTable[i]);
+        }
+    }
+
+    iowa_system_free(peerP->base.exchangeTable);
+    peerP->base.exchangeTable = newTable;
+    peerP->base.exchangeTableSize = newSize;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Remove an exchange from the table, shifting back the following entries of its probe sequence.
+// Returned value: the removed exchange.
+// Parameters:
+// - peerP: the CoAP peer.
+// - index: the slot holding the exchange.
+static coap_exchange_t *prv_exchangeRemove(iowa_coap_peer_t *peerP,
+                                           size_t index)
+{
+    // WARNING: This function is called in a critical section
+    coap_exchange_t *exchangeP;
+    size_t mask;
+    size_t next;
+
+    exchangeP = peerP->base.exchangeTable[index];
+    peerP->base.exchangeTable[index] = NULL;
+    peerP->base.exchangeCount--;
+
+    mask = peerP->base.exchangeTableSize - 1;
+    next = (index + 1) & mask;
+    while (peerP->base.exchangeTable[next] != NULL)
+    {
+        size_t home;
+
+        home = prv_tokenHash(peerP->base.exchangeTable[next]->tokenLength, peerP->base.exchangeTable[next]->token) & mask;
+
+        // Move the entry to the hole if the hole lies between its home slot and its current slot
+        if (((next - home) & mask) >= ((next - index) & mask))
+        {
+            peerP->base.exchangeTable[index] = peerP->base.exchangeTable[next];
+            peerP->base.exchangeTable[next] = NULL;
+            index = next;
+        }
+        next = (next + 1) & mask;
+    }
+
+    return exchangeP;
+}
+
+#if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
+static bool prv_peerFindCallback(void *nodeP,
+                                 void *criteriaP)
 {
     return nodeP == criteriaP;
 }
+#endif
+
+// Mix the bits of a 32-bit value. This is a bijection.
+// Returned value: the mixed value.
+// Parameters:
+// - value: the value to mix.
+static uint32_t prv_tokenMix(uint32_t value)
+{
+    value ^= value >> 16;
+    value *= 0x85EBCA6Bu;
+    value ^= value >> 13;
+    value *= 0xC2B2AE35u;
+    value ^= value >> 16;
+
+    return value;
+}
+
+// Seed the token generator of a new peer.
+// Returned value: none.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the CoAP peer.
+static void prv_tokenGeneratorInit(iowa_context_t contextP,
+                                   iowa_coap_peer_t *peerP)
+{
+    // WARNING: This function is called in a critical section
+#if IOWA_SECURITY_LAYER != IOWA_SECURITY_LAYER_NONE
+    int result;
+
+    CRIT_SECTION_LEAVE(contextP);
+    result = iowa_system_random_vector_generator((uint8_t *)&(peerP->base.tokenSalt),
+                                                 sizeof(peerP->base.tokenSalt),
+                                                 contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+
+    if (0 != result)
+#else
+    (void)contextP;
+#endif
+    {
+        IOWA_LOG_INFO(IOWA_PART_COAP, "iowa_system_random_vector_generator() failed or is not implemented. Deriving the token salt from the peer and the time.");
+
+        peerP->base.tokenSalt = (uint32_t)(uintptr_t)peerP ^ (uint32_t)coreTimeGet();
+    }
+    peerP->base.tokenCounter = 0;
+}
+
+#ifdef IOWA_LORAWAN_SUPPORT
+// Assign the next Message ID of a LoRaWAN peer.
+// The SCHC rules send the Message IDs up to COAP_LORAWAN_SHORT_MID_MAX on 4 bits. As there are only 15 of them,
+// one is not used again before EXCHANGE_LIFETIME (RFC 7252 Section 4.5). Meanwhile, a Message ID sent on 8 bits is used.
+// The duty cycle of LoRaWAN does not allow to send the 240 of them in an EXCHANGE_LIFETIME.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - messageP: the message to send.
+static void prv_setLorawanMessageId(iowa_context_t contextP,
+                                    coap_peer_datagram_t *peerP,
+                                    iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+    if (contextP->currentTime >= peerP->schcShortMIDTime[peerP->schcShortMID])
+    {
+        messageP->id = peerP->schcShortMID;
+        peerP->schcShortMIDTime[peerP->schcShortMID] = contextP->currentTime + CORE_TIME_FROM_SECONDS(coapPeerGetExchangeLifetime((iowa_coap_peer_t *)peerP));
+
+        // The short Message IDs are used in turn, so the next one is the least recently used
+        peerP->schcShortMID = (uint16_t)(COAP_FIRST_MID + peerP->schcShortMID % COAP_LORAWAN_SHORT_MID_MAX);
+    }
+    else
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Short Message ID %u was used less than EXCHANGE_LIFETIME ago. Using %u.", peerP->schcShortMID, peerP->nextMID);
+
+        messageP->id = peerP->nextMID;
+        peerP->nextMID++;
+        if (peerP->nextMID > COAP_LORAWAN_LONG_MID_MAX)
+        {
+            peerP->nextMID = COAP_LORAWAN_SHORT_MID_MAX + 1;
+        }
+    }
+}
+
+// Set the first Message IDs of a LoRaWAN peer from the random first Message ID.
+// Parameters:
+// - peerP: the peer.
+static void prv_initLorawanMessageId(coap_peer_datagram_t *peerP)
+{
+    peerP->schcShortMID = (uint16_t)(COAP_FIRST_MID + peerP->nextMID % COAP_LORAWAN_SHORT_MID_MAX);
+    peerP->nextMID = (uint16_t)(COAP_LORAWAN_SHORT_MID_MAX + 1 + peerP->nextMID % (COAP_LORAWAN_LONG_MID_MAX - COAP_LORAWAN_SHORT_MID_MAX));
+}
+#endif
+
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+// Assign the next Message ID of a datagram peer to a confirmable or non-confirmable message.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - messageP: the message to send.
+static void prv_setMessageId(iowa_context_t contextP,
+                             iowa_coap_peer_t *peerP,
+                             iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+    coap_peer_datagram_t *datagramPeerP;
+
+    switch (peerP->base.type)
+    {
+    case IOWA_CONN_DATAGRAM:
+    case IOWA_CONN_LORAWAN:
+    case IOWA_CONN_SMS:
+        break;
+
+    default:
+        return;
+    }
+
+    if (messageP->type != IOWA_COAP_TYPE_CONFIRMABLE
+        && messageP->type != IOWA_COAP_TYPE_NON_CONFIRMABLE)
+    {
+        return;
+    }
+
+    datagramPeerP = (coap_peer_datagram_t *)peerP;
+
+#ifdef IOWA_LORAWAN_SUPPORT
+    if (peerP->base.type == IOWA_CONN_LORAWAN)
+    {
+        prv_setLorawanMessageId(contextP, datagramPeerP, messageP);
+        return;
+    }
+#else
+    (void)contextP;
+#endif
+
+    messageP->id = datagramPeerP->nextMID;
+    datagramPeerP->nextMID++;
+    if (datagramPeerP->nextMID == COAP_RESERVED_MID)
+    {
+        datagramPeerP->nextMID++;
+    }
+}
 
 static void prv_datagramSendResult(iowa_coap_peer_t *fromPeer,
                                    uint8_t code,
@@ -44,18 +349,26 @@ static void prv_datagramSendResult(iowa_coap_peer_t *fromPeer,
 
     if (messageP == NULL)
     {
-        coap_exchange_t *exchangeP;
-        coap_exchange_t *exchangeFoundP;
-
-        exchangeP = (coap_exchange_t *)userData;
-        exchangeFoundP = NULL;
+        size_t index;
+        uint16_t mID;
 
-        fromPeer->base.exchangeList = (coap_exchange_t *)IOWA_UTILS_LIST_FIND_AND_REMOVE(fromPeer->base.exchangeList, prv_exchangeFindCallback, exchangeP, &exchangeFoundP);
-        if (exchangeFoundP != NULL)
+        // This path is only taken when the transmission failed. The exchange may already be released if a
+        // separate response was received, and its memory reused by another exchange: match on the Message ID.
+        mID = (uint16_t)(uintptr_t)userData;
+        for (index = 0; index < fromPeer->base.exchangeTableSize; index++)
         {
-            IOWA_LOG_TRACE(IOWA_PART_COAP, "Forward reply to the upper layer.");
-            exchangeFoundP->callback(fromPeer, code, messageP, exchangeFoundP->userData, contextP);
-            iowa_system_free(exchangeFoundP);
+            if (fromPeer->base.exchangeTable[index] != NULL
+                && fromPeer->base.exchangeTable[index]->mID == mID)
+            {
+                coap_exchange_t *exchangeP;
+
+                exchangeP = prv_exchangeRemove(fromPeer, index);
+
+                IOWA_LOG_TRACE(IOWA_PART_COAP, "Forward reply to the upper layer.");
+                exchangeP->callback(fromPeer, code, messageP, exchangeP->userData, contextP);
+                CORE_POOL_FREE(exchangeP);
+                break;
+            }
         }
     }
 }
@@ -78,29 +391,6 @@ static uint8_t prv_send(iowa_context_t contextP,
     IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering.");
 
 
-#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
-    switch (peerP->base.type)
-    {
-    case IOWA_CONN_DATAGRAM:
-    case IOWA_CONN_LORAWAN:
-    case IOWA_CONN_SMS:
-        if (messageP->type == IOWA_COAP_TYPE_CONFIRMABLE
-            || messageP->type == IOWA_COAP_TYPE_NON_CONFIRMABLE)
-        {
-            messageP->id = ((coap_peer_datagram_t *)peerP)->nextMID;
-            ((coap_peer_datagram_t *)peerP)->nextMID++;
-            if (((coap_peer_datagram_t *)peerP)->nextMID == COAP_RESERVED_MID)
-            {
-                ((coap_peer_datagram_t *)peerP)->nextMID++;
-            }
-        }
-        break;
-
-    default:
-        break;
-    }
-#endif
-
     COAP_LOG_MESSAGE("Sending", peerP->base.type, messageP);
 
     switch (peerP->base.type)
@@ -111,6 +401,12 @@ static uint8_t prv_send(iowa_context_t contextP,
         break;
 #endif // IOWA_UDP_SUPPORT
 
+#ifdef IOWA_LORAWAN_SUPPORT
+    case IOWA_CONN_LORAWAN:
+        result = messageSendLoRaWAN(contextP, peerP, messageP, resultCallback, userData);
+        break;
+#endif
+
 #if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
     case IOWA_CONN_STREAM:
     case IOWA_CONN_WEBSOCKET:
@@ -147,9 +443,35 @@ static iowa_coap_peer_t *peer_new(iowa_connection_type_t type)
     }
 #endif
         memset(peerP, 0, sizeof(coap_peer_datagram_t));
-        ((coap_peer_datagram_t *)peerP)->ackTimeout = COAP_UDP_ACK_REAL_TIMEOUT;
+        ((coap_peer_datagram_t *)peerP)->ackTimeout = (int32_t)CORE_TIME_FROM_SECONDS(COAP_UDP_ACK_TIMEOUT);
         ((coap_peer_datagram_t *)peerP)->maxRetransmit = COAP_UDP_MAX_RETRANSMIT;
-        ((coap_peer_datagram_t *)peerP)->transmitWait = COAP_COMPUTE_MAX_TRANSMIT_WAIT(COAP_UDP_ACK_REAL_TIMEOUT, COAP_UDP_MAX_RETRANSMIT);
+        ((coap_peer_datagram_t *)peerP)->transmitWait = (int32_t)COAP_COMPUTE_MAX_TRANSMIT_WAIT(CORE_TIME_FROM_SECONDS(COAP_UDP_ACK_TIMEOUT), COAP_UDP_MAX_RETRANSMIT);
+        transactionResetRto((coap_peer_datagram_t *)peerP);
+        ((coap_peer_datagram_t *)peerP)->ackCache.capacity = IOWA_COAP_ACK_CACHE_COUNT;
+        ((coap_peer_datagram_t *)peerP)->stepIndex = COAP_STEP_INDEX_NONE;
+        break;
+#endif
+
+#ifdef IOWA_LORAWAN_SUPPORT
+    case IOWA_CONN_LORAWAN:
+        peerP = (iowa_coap_peer_t *)iowa_system_malloc(sizeof(coap_peer_datagram_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (peerP == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(sizeof(coap_peer_datagram_t));
+            return NULL;
+        }
+#endif
+        memset(peerP, 0, sizeof(coap_peer_datagram_t));
+        // No retransmission: the acknowledgement is awaited during MAX_TRANSMIT_WAIT
+        ((coap_peer_datagram_t *)peerP)->ackTimeout = (int32_t)CORE_TIME_FROM_SECONDS(COAP_LORAWAN_MAX_TRANSMIT_WAIT);
+        ((coap_peer_datagram_t *)peerP)->maxRetransmit = COAP_LORAWAN_MAX_RETRANSMIT;
+        ((coap_peer_datagram_t *)peerP)->transmitWait = (int32_t)CORE_TIME_FROM_SECONDS(COAP_LORAWAN_MAX_TRANSMIT_WAIT);
+        transactionResetRto((coap_peer_datagram_t *)peerP);
+        ((coap_peer_datagram_t *)peerP)->ackCache.capacity = IOWA_COAP_ACK_CACHE_COUNT;
+        ((coap_peer_datagram_t *)peerP)->stepIndex = COAP_STEP_INDEX_NONE;
+        // Until the application reports the current data rate with IOWA_COAP_SETTING_FRAME_SIZE
+        ((coap_peer_datagram_t *)peerP)->schcFrameSize = COAP_LORAWAN_MAX_FRAME_SIZE;
         break;
 #endif
 
@@ -165,6 +487,8 @@ static iowa_coap_peer_t *peer_new(iowa_connection_type_t type)
         }
 #endif
         memset(peerP, 0, sizeof(coap_peer_stream_t));
+        ((coap_peer_stream_t *)peerP)->maxMessageSize = COAP_TCP_DEFAULT_MAX_MESSAGE_SIZE;
+        ((coap_peer_stream_t *)peerP)->pingInterval = IOWA_COAP_STREAM_PING_INTERVAL;
         break;
 #endif
 
@@ -186,17 +510,20 @@ static void peer_free(iowa_context_t contextP,
 
     switch (peerP->base.type)
     {
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
     case IOWA_CONN_DATAGRAM:
     case IOWA_CONN_LORAWAN:
     case IOWA_CONN_SMS:
         IOWA_UTILS_LIST_FREE(((coap_peer_datagram_t *)peerP)->transactionList, transactionFree);
-        IOWA_UTILS_LIST_FREE(((coap_peer_datagram_t *)peerP)->ackList, acknowledgeFree);
+        acknowledgeCacheClear((coap_peer_datagram_t *)peerP);
         break;
+#endif
 
     default:
         break;
     }
 
+    iowa_system_free(peerP->base.exchangeTable);
     iowa_system_free(peerP);
 }
 
@@ -211,23 +538,76 @@ static iowa_status_t prv_datagramConfig(coap_peer_datagram_t *peerP,
     case IOWA_COAP_SETTING_ACK_TIMEOUT:
         if (set == true)
         {
-            peerP->ackTimeout = *((uint8_t *)argP);
-            peerP->transmitWait = COAP_COMPUTE_MAX_TRANSMIT_WAIT(peerP->ackTimeout, peerP->maxRetransmit);
-            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC7252 peer %p new ACK_TIMEOUT: %u, new TRANSMIT_WAIT: %u.", peerP, peerP->ackTimeout, peerP->transmitWait);
+            peerP->ackTimeout = (int32_t)CORE_TIME_FROM_SECONDS(*((uint8_t *)argP));
+            peerP->transmitWait = (int32_t)COAP_COMPUTE_MAX_TRANSMIT_WAIT(peerP->ackTimeout, peerP->maxRetransmit);
+            transactionResetRto(peerP);
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC7252 peer %p new ACK_TIMEOUT: %d, new TRANSMIT_WAIT: %d.", peerP, peerP->ackTimeout, peerP->transmitWait);
         }
         else
         {
-            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC7252 peer %p ACK_TIMEOUT is %u.", peerP, peerP->ackTimeout);
-            *((uint8_t *)argP) = peerP->ackTimeout;
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC7252 peer %p ACK_TIMEOUT is %d.", peerP, peerP->ackTimeout);
+            *((uint8_t *)argP) = (uint8_t)CORE_TIME_TO_SECONDS_CEIL(peerP->ackTimeout);
         }
         break;
 
+#ifdef IOWA_TIME_MS_SUPPORT
+    case IOWA_COAP_SETTING_ACK_TIMEOUT_MS:
+        if (set == true)
+        {
+            if (*((uint32_t *)argP) > CORE_TIME_FROM_SECONDS(UINT8_MAX))
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "ACK_TIMEOUT of %ums is too large.", *((uint32_t *)argP));
+                return IOWA_COAP_400_BAD_REQUEST;
+            }
+            peerP->ackTimeout = (int32_t)(*((uint32_t *)argP));
+            peerP->transmitWait = (int32_t)COAP_COMPUTE_MAX_TRANSMIT_WAIT(peerP->ackTimeout, peerP->maxRetransmit);
+            transactionResetRto(peerP);
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC7252 peer %p new ACK_TIMEOUT: %dms, new TRANSMIT_WAIT: %dms.", peerP, peerP->ackTimeout, peerP->transmitWait);
+        }
+        else
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC7252 peer %p ACK_TIMEOUT is %dms.", peerP, peerP->ackTimeout);
+            *((uint32_t *)argP) = (uint32_t)peerP->ackTimeout;
+        }
+        break;
+
+    case IOWA_COAP_SETTING_RTO_MS:
+        if (set == true)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_COAP, "RTO is estimated from the round-trip times and cannot be set.");
+            return IOWA_COAP_405_METHOD_NOT_ALLOWED;
+        }
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "CoAP peer %p RTO is %dms.", peerP, peerP->rto);
+        *((uint32_t *)argP) = (uint32_t)peerP->rto;
+        break;
+
+    case IOWA_COAP_SETTING_SRTT_MS:
+        if (set == true)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_COAP, "SRTT is measured and cannot be set.");
+            return IOWA_COAP_405_METHOD_NOT_ALLOWED;
+        }
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "CoAP peer %p SRTT is %dms.", peerP, peerP->strongRtt.srtt);
+        *((uint32_t *)argP) = (uint32_t)peerP->strongRtt.srtt;
+        break;
+
+    case IOWA_COAP_SETTING_RTTVAR_MS:
+        if (set == true)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_COAP, "RTTVAR is measured and cannot be set.");
+            return IOWA_COAP_405_METHOD_NOT_ALLOWED;
+        }
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "CoAP peer %p RTTVAR is %dms.", peerP, peerP->strongRtt.rttvar);
+        *((uint32_t *)argP) = (uint32_t)peerP->strongRtt.rttvar;
+        break;
+#endif
+
     case IOWA_COAP_SETTING_MAX_RETRANSMIT:
         if (set == true)
         {
             peerP->maxRetransmit = *((uint8_t *)argP);
-            peerP->transmitWait = COAP_COMPUTE_MAX_TRANSMIT_WAIT(peerP->ackTimeout, peerP->maxRetransmit);
-            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC7252 peer %p new MAX_RETRANSMIT: %u, new TRANSMIT_WAIT: %u.", peerP, peerP->maxRetransmit, peerP->transmitWait);
+            peerP->transmitWait = (int32_t)COAP_COMPUTE_MAX_TRANSMIT_WAIT(peerP->ackTimeout, peerP->maxRetransmit);
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC7252 peer %p new MAX_RETRANSMIT: %u, new TRANSMIT_WAIT: %d.", peerP, peerP->maxRetransmit, peerP->transmitWait);
         }
         else
         {
@@ -236,6 +616,67 @@ static iowa_status_t prv_datagramConfig(coap_peer_datagram_t *peerP,
         }
         break;
 
+    case IOWA_COAP_SETTING_ACK_CACHE_COUNT:
+        if (set == true)
+        {
+            if (*((uint16_t *)argP) > 32768)
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Reply cache of %u entries is too large.", *((uint16_t *)argP));
+                return IOWA_COAP_400_BAD_REQUEST;
+            }
+            // The cached replies are dropped, the cache is allocated again with the next reply
+            acknowledgeCacheClear(peerP);
+            peerP->ackCache.capacity = *((uint16_t *)argP);
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "CoAP peer %p new reply cache size: %u.", peerP, peerP->ackCache.capacity);
+        }
+        else
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "CoAP peer %p reply cache size is %u.", peerP, peerP->ackCache.capacity);
+            *((uint16_t *)argP) = peerP->ackCache.capacity;
+        }
+        break;
+
+    case IOWA_COAP_SETTING_ACK_CACHE_MEMORY:
+        if (set == true)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_COAP, "Reply cache memory is measured and cannot be set.");
+            return IOWA_COAP_405_METHOD_NOT_ALLOWED;
+        }
+        *((size_t *)argP) = peerP->ackCache.memorySize;
+        if (peerP->ackCache.ring != NULL)
+        {
+            *((size_t *)argP) += peerP->ackCache.capacity * sizeof(coap_ack_t) + peerP->ackCache.bucketCount * sizeof(coap_ack_t *);
+        }
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "CoAP peer %p reply cache uses %u bytes.", peerP, *((size_t *)argP));
+        break;
+
+#ifdef IOWA_LORAWAN_SUPPORT
+    case IOWA_COAP_SETTING_FRAME_SIZE:
+        if (peerP->base.type != IOWA_CONN_LORAWAN)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_COAP, "Frame size only applies to LoRaWAN peers.");
+            return IOWA_COAP_405_METHOD_NOT_ALLOWED;
+        }
+        if (set == true)
+        {
+            if (*((uint8_t *)argP) < COAP_LORAWAN_MIN_FRAME_SIZE
+                || *((uint8_t *)argP) > COAP_LORAWAN_MAX_FRAME_SIZE)
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "LoRaWAN frame size of %u bytes is out of range.", *((uint8_t *)argP));
+                return IOWA_COAP_400_BAD_REQUEST;
+            }
+            // Follows the data rate: the next messages and blocks are sized to fit
+            peerP->schcFrameSize = *((uint8_t *)argP);
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "LoRaWAN peer %p new frame size: %u bytes.", peerP, peerP->schcFrameSize);
+        }
+        else
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "LoRaWAN peer %p frame size is %u bytes.", peerP, peerP->schcFrameSize);
+            *((uint8_t *)argP) = peerP->schcFrameSize;
+        }
+        break;
+#endif
+
         default:
             IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Unknown setting: %u.", settingId);
             return IOWA_COAP_405_METHOD_NOT_ALLOWED;
@@ -253,6 +694,20 @@ static iowa_status_t prv_streamConfig(coap_peer_stream_t *peerP,
 {
     switch (settingId)
     {
+    case IOWA_COAP_SETTING_PING_INTERVAL:
+        if (set == true)
+        {
+            // Applied from the next message exchanged with the peer
+            peerP->pingInterval = *((uint32_t *)argP);
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC8323 peer %p new ping interval: %u.", peerP, peerP->pingInterval);
+        }
+        else
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC8323 peer %p ping interval is %u.", peerP, peerP->pingInterval);
+            *((uint32_t *)argP) = peerP->pingInterval;
+        }
+        break;
+
     default:
         IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Unknown setting: %u.", settingId);
         return IOWA_COAP_405_METHOD_NOT_ALLOWED;
@@ -323,6 +778,12 @@ iowa_coap_peer_t *coapPeerCreate(iowa_context_t contextP,
         break;
 #endif
 
+#ifdef IOWA_LORAWAN_SUPPORT
+    case IOWA_CONN_LORAWAN:
+        securityEventCallback = lorawanSecurityEventCb;
+        break;
+#endif
+
 #if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
     case IOWA_CONN_STREAM:
     case IOWA_CONN_WEBSOCKET:
@@ -338,11 +799,16 @@ iowa_coap_peer_t *coapPeerCreate(iowa_context_t contextP,
 
     securitySetEventCallback(contextP, securityS, securityEventCallback, (void *)peerP);
 
+    prv_tokenGeneratorInit(contextP, peerP);
+
     switch (peerP->base.type)
     {
 #if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
 #ifdef IOWA_UDP_SUPPORT
     case IOWA_CONN_DATAGRAM:
+#endif
+#ifdef IOWA_LORAWAN_SUPPORT
+    case IOWA_CONN_LORAWAN:
 #endif
     {
 #if IOWA_SECURITY_LAYER != IOWA_SECURITY_LAYER_NONE
@@ -361,10 +827,29 @@ iowa_coap_peer_t *coapPeerCreate(iowa_context_t contextP,
 
             ((coap_peer_datagram_t *)peerP)->nextMID = COAP_FIRST_MID;
         }
+#ifdef IOWA_LORAWAN_SUPPORT
+        if (peerP->base.type == IOWA_CONN_LORAWAN)
+        {
+            prv_initLorawanMessageId((coap_peer_datagram_t *)peerP);
+            ((coap_peer_datagram_t *)peerP)->schcIsDevice = true;
+        }
+#endif
         break;
     }
 #endif // defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
 
+#ifdef IOWA_WEBSOCKET_SUPPORT
+    case IOWA_CONN_WEBSOCKET:
+        if (websocketPeerInit((coap_peer_stream_t *)peerP, uri) != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_COAP, "Cannot initialize the WebSocket peer.");
+
+            peer_free(contextP, peerP);
+            return NULL;
+        }
+        break;
+#endif
+
     default:
         break;
     }
@@ -419,6 +904,12 @@ uint8_t coapPeerNew(iowa_context_t contextP,
         break;
 #endif
 
+#ifdef IOWA_LORAWAN_SUPPORT
+    case IOWA_CONN_LORAWAN:
+        securityEventCallback = lorawanSecurityEventCb;
+        break;
+#endif
+
 #if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
     case IOWA_CONN_STREAM:
     case IOWA_CONN_WEBSOCKET:
@@ -434,11 +925,16 @@ uint8_t coapPeerNew(iowa_context_t contextP,
 
     securitySetEventCallback(contextP, securityS, securityEventCallback, (void *)*peerP);
 
+    prv_tokenGeneratorInit(contextP, *peerP);
+
     switch ((*peerP)->base.type)
     {
 #if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
 #ifdef IOWA_UDP_SUPPORT
     case IOWA_CONN_DATAGRAM:
+#endif
+#ifdef IOWA_LORAWAN_SUPPORT
+    case IOWA_CONN_LORAWAN:
 #endif
     {
 #if IOWA_SECURITY_LAYER != IOWA_SECURITY_LAYER_NONE
@@ -457,6 +953,12 @@ uint8_t coapPeerNew(iowa_context_t contextP,
 
             ((coap_peer_datagram_t *)(*peerP))->nextMID = COAP_FIRST_MID;
         }
+#ifdef IOWA_LORAWAN_SUPPORT
+        if ((*peerP)->base.type == IOWA_CONN_LORAWAN)
+        {
+            prv_initLorawanMessageId((coap_peer_datagram_t *)(*peerP));
+        }
+#endif
         break;
     }
 #endif // defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
@@ -494,26 +996,44 @@ void coapPeerDelete(iowa_context_t contextP,
         coapPeerDisconnect(contextP, peerP);
 
         contextP->coapContextP->peerList = (iowa_coap_peer_t *)IOWA_UTILS_LIST_REMOVE(contextP->coapContextP->peerList, peerP);
-
-        while (peerP->base.exchangeList != NULL)
+#if (defined(IOWA_UDP_SUPPORT) && defined(IOWA_CONNECTION_RECVV_SUPPORT)) || defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
+        if (contextP->coapContextP->recvPeerP == peerP)
         {
-            coap_exchange_t *exchangeP;
+            contextP->coapContextP->recvPeerP = NULL;
+        }
+#endif
 
-            exchangeP = peerP->base.exchangeList;
-            peerP->base.exchangeList = exchangeP->next;
+        while (peerP->base.exchangeCount != 0)
+        {
+            size_t index;
 
-            if (exchangeP->callback != NULL)
+            for (index = 0; index < peerP->base.exchangeTableSize; index++)
             {
-                exchangeP->callback(peerP, IOWA_COAP_503_SERVICE_UNAVAILABLE, NULL, exchangeP->userData, contextP);
+                // Removing an exchange may shift another one into this slot
+                while (peerP->base.exchangeTable[index] != NULL)
+                {
+                    coap_exchange_t *exchangeP;
+
+                    exchangeP = prv_exchangeRemove(peerP, index);
+
+                    if (exchangeP->callback != NULL)
+                    {
+                        exchangeP->callback(peerP, IOWA_COAP_503_SERVICE_UNAVAILABLE, NULL, exchangeP->userData, contextP);
+                    }
+                    CORE_POOL_FREE(exchangeP);
+                }
             }
-            iowa_system_free(exchangeP);
         }
 
         switch (savedType)
         {
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
         case IOWA_CONN_DATAGRAM:
         case IOWA_CONN_LORAWAN:
         case IOWA_CONN_SMS:
+#ifdef IOWA_UDP_SUPPORT
+            udpSendQueueClear(contextP, (coap_peer_datagram_t *)peerP);
+#endif
             while (((coap_peer_datagram_t *)peerP)->transactionList != NULL)
             {
                 coap_transaction_t *transacP;
@@ -527,8 +1047,24 @@ void coapPeerDelete(iowa_context_t contextP,
                 }
                 transactionFree(transacP);
             }
-            IOWA_UTILS_LIST_FREE(((coap_peer_datagram_t *)peerP)->ackList, acknowledgeFree);
+            acknowledgeCacheClear((coap_peer_datagram_t *)peerP);
+            coapPeerUnschedule(contextP, (coap_peer_datagram_t *)peerP);
+#ifdef IOWA_LORAWAN_SUPPORT
+            iowa_system_free(((coap_peer_datagram_t *)peerP)->schcObjectArray);
+            iowa_system_free(((coap_peer_datagram_t *)peerP)->schcPendingObjectArray);
+#endif
+            break;
+#endif
+
+#if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
+        case IOWA_CONN_STREAM:
+        case IOWA_CONN_WEBSOCKET:
+            tcpPeerClear(contextP, (coap_peer_stream_t *)peerP);
+#ifdef IOWA_WEBSOCKET_SUPPORT
+            iowa_system_free(((coap_peer_stream_t *)peerP)->wsHost);
+#endif
             break;
+#endif
 
         default:
             break;
@@ -604,6 +1140,12 @@ iowa_status_t coapPeerConfiguration(iowa_coap_peer_t *peerP,
             break;
 #endif
 
+#ifdef IOWA_LORAWAN_SUPPORT
+        case IOWA_CONN_LORAWAN:
+            result = prv_datagramConfig((coap_peer_datagram_t *)peerP, set, settingId, argP);
+            break;
+#endif
+
 #if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
         case IOWA_CONN_STREAM:
         case IOWA_CONN_WEBSOCKET:
@@ -678,6 +1220,56 @@ iowa_connection_type_t coapPeerGetConnectionType(iowa_coap_peer_t *peerP)
     return peerP->base.type;
 }
 
+#ifdef IOWA_LORAWAN_SUPPORT
+void coapPeerPrepareObjectList(iowa_coap_peer_t *peerP,
+                               uint16_t *idArray,
+                               uint16_t count)
+{
+    // WARNING: This function is called in a critical section
+    coap_peer_datagram_t *datagramPeerP;
+
+    if (peerP->base.type != IOWA_CONN_LORAWAN)
+    {
+        iowa_system_free(idArray);
+        return;
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Peer %p will compress %u Object IDs.", peerP, count);
+
+    datagramPeerP = (coap_peer_datagram_t *)peerP;
+    iowa_system_free(datagramPeerP->schcPendingObjectArray);
+    datagramPeerP->schcPendingObjectArray = idArray;
+    datagramPeerP->schcPendingObjectCount = count;
+}
+
+void coapPeerApplyObjectList(iowa_coap_peer_t *peerP)
+{
+    // WARNING: This function is called in a critical section
+    coap_peer_datagram_t *datagramPeerP;
+
+    if (peerP->base.type != IOWA_CONN_LORAWAN)
+    {
+        return;
+    }
+
+    datagramPeerP = (coap_peer_datagram_t *)peerP;
+    if (datagramPeerP->schcPendingObjectArray == NULL
+        && datagramPeerP->schcPendingObjectCount == 0)
+    {
+        // Nothing was prepared since the last acknowledgement
+        return;
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Peer %p compresses %u Object IDs.", peerP, datagramPeerP->schcPendingObjectCount);
+
+    iowa_system_free(datagramPeerP->schcObjectArray);
+    datagramPeerP->schcObjectArray = datagramPeerP->schcPendingObjectArray;
+    datagramPeerP->schcObjectCount = datagramPeerP->schcPendingObjectCount;
+    datagramPeerP->schcPendingObjectArray = NULL;
+    datagramPeerP->schcPendingObjectCount = 0;
+}
+#endif
+
 uint8_t peerSend(iowa_context_t contextP,
                  iowa_coap_peer_t *peerP,
                  iowa_coap_message_t *messageP,
@@ -695,11 +1287,22 @@ uint8_t peerSend(iowa_context_t contextP,
     intermediateCallback = resultCallback;
     intermediateUserdata = userData;
 
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+    prv_setMessageId(contextP, peerP, messageP);
+#endif
+
     if (resultCallback != NULL
         && COAP_IS_REQUEST(messageP->code))
     {
 
-        exchangeP = (coap_exchange_t *)iowa_system_malloc(sizeof(coap_exchange_t));
+        // Make room in the table before sending so that the exchange can always be recorded afterwards
+        result = prv_exchangeReserve(peerP);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            return result;
+        }
+
+        exchangeP = (coap_exchange_t *)CORE_POOL_ALLOC(contextP, CORE_POOL_EXCHANGE, sizeof(coap_exchange_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (exchangeP == NULL)
         {
@@ -711,6 +1314,7 @@ uint8_t peerSend(iowa_context_t contextP,
 
         exchangeP->tokenLength = messageP->tokenLength;
         memcpy(exchangeP->token, messageP->token, messageP->tokenLength);
+        exchangeP->mID = COAP_RESERVED_MID;
         exchangeP->callback = resultCallback;
         exchangeP->userData = userData;
     }
@@ -729,8 +1333,9 @@ uint8_t peerSend(iowa_context_t contextP,
             && messageP->type == IOWA_COAP_TYPE_CONFIRMABLE)
         {
             // We need to intercept the result from the transport for separate response or reliable transport
+            exchangeP->mID = messageP->id;
             intermediateCallback = prv_datagramSendResult;
-            intermediateUserdata = exchangeP;
+            intermediateUserdata = (void *)(uintptr_t)messageP->id;
         }
         break;
 
@@ -746,13 +1351,14 @@ uint8_t peerSend(iowa_context_t contextP,
         if (exchangeP != NULL)
         {
             // Send was successful, enqueue the exchange
-            peerP->base.exchangeList = (coap_exchange_t *)IOWA_UTILS_LIST_ADD(peerP->base.exchangeList, exchangeP);
+            prv_exchangeInsert(peerP->base.exchangeTable, peerP->base.exchangeTableSize, exchangeP);
+            peerP->base.exchangeCount++;
         }
     }
     else
     {
         // an error occurred, free the exchange
-        iowa_system_free(exchangeP);
+        CORE_POOL_FREE(exchangeP);
     }
 
     if (!COAP_IS_REQUEST(messageP->code)
@@ -760,7 +1366,7 @@ uint8_t peerSend(iowa_context_t contextP,
     {
         iowa_coap_message_t *errorReplyP;
 
-        errorReplyP = iowa_coap_message_new(messageP->type, IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE, messageP->tokenLength, messageP->token);
+        errorReplyP = iowa_coap_message_new(contextP, messageP->type, IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE, messageP->tokenLength, messageP->token);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (errorReplyP == NULL)
         {
@@ -770,6 +1376,9 @@ uint8_t peerSend(iowa_context_t contextP,
 #endif
 
         errorReplyP->id = messageP->id;
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+        prv_setMessageId(contextP, peerP, errorReplyP);
+#endif
 
         (void)prv_send(contextP, peerP, errorReplyP, NULL, NULL);
         iowa_coap_message_free(errorReplyP);
@@ -780,6 +1389,74 @@ uint8_t peerSend(iowa_context_t contextP,
     return result;
 }
 
+void peerCancelExchange(iowa_coap_peer_t *peerP,
+                        uint8_t tokenLength,
+                        const uint8_t *token)
+{
+    // WARNING: This function is called in a critical section
+    size_t index;
+
+    index = prv_exchangeFind(peerP, tokenLength, token);
+    if (index != peerP->base.exchangeTableSize)
+    {
+        IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Cancelling the exchange of peer %p.", peerP);
+
+        // The callback is not called
+        CORE_POOL_FREE(prv_exchangeRemove(peerP, index));
+    }
+}
+
+#if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
+bool peerFailExchanges(iowa_context_t contextP,
+                       iowa_coap_peer_t *peerP,
+                       uint8_t code)
+{
+    // WARNING: This function is called in a critical section
+    size_t count;
+    size_t index;
+
+    // Exchanges started by the callbacks are kept
+    count = peerP->base.exchangeCount;
+    index = 0;
+    while (count > 0
+           && peerP->base.exchangeCount > 0)
+    {
+        coap_exchange_t *exchangeP;
+
+        // Removing an exchange may shift an entry of a wrapping probe sequence before the index
+        if (index >= peerP->base.exchangeTableSize)
+        {
+            index = 0;
+        }
+
+        // Removing an exchange may shift another one into this slot
+        if (peerP->base.exchangeTable[index] == NULL)
+        {
+            index++;
+            continue;
+        }
+
+        exchangeP = prv_exchangeRemove(peerP, index);
+        count--;
+
+        if (exchangeP->callback != NULL)
+        {
+            exchangeP->callback(peerP, code, NULL, exchangeP->userData, contextP);
+        }
+        CORE_POOL_FREE(exchangeP);
+
+        // The callback can delete the peer
+        if (IOWA_UTILS_LIST_FIND(contextP->coapContextP->peerList, prv_peerFindCallback, peerP) == NULL)
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Peer %p deleted by an exchange callback.", peerP);
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
+
 int peerSendBuffer(iowa_context_t contextP,
                    iowa_coap_peer_t *peerP,
                    uint8_t *buffer,
@@ -789,6 +1466,17 @@ int peerSendBuffer(iowa_context_t contextP,
     return securitySend(contextP, peerP->base.securityS, buffer, bufferLength);
 }
 
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+int peerSendSegments(iowa_context_t contextP,
+                     iowa_coap_peer_t *peerP,
+                     iowa_connection_segment_t *segmentArray,
+                     size_t segmentCount)
+{
+    // WARNING: This function is called in a critical section
+    return securitySendv(contextP, peerP->base.securityS, segmentArray, segmentCount);
+}
+#endif
+
 int peerRecvBuffer(iowa_context_t contextP,
                    iowa_coap_peer_t *peerP,
                    uint8_t *buffer,
@@ -797,14 +1485,29 @@ int peerRecvBuffer(iowa_context_t contextP,
     return securityRecv(contextP, peerP->base.securityS, buffer, bufferLength);
 }
 
+#ifdef IOWA_CONNECTION_RECVV_SUPPORT
+int peerRecvSegments(iowa_context_t contextP,
+                     iowa_coap_peer_t *peerP,
+                     iowa_connection_segment_t *segmentArray,
+                     size_t segmentCount)
+{
+    // WARNING: This function is called in a critical section
+    return securityRecvv(contextP, peerP->base.securityS, segmentArray, segmentCount);
+}
+#endif
+
 int32_t coapPeerGetMaxTxWait(iowa_coap_peer_t *peerP)
 {
-    // peerP->transmitWait is contained inside a uint16_t. And thus, by definition, UINT16_MAX (65535) can be stored inside a int32_t
     switch (peerP->base.type)
     {
 #ifdef IOWA_UDP_SUPPORT
     case IOWA_CONN_DATAGRAM:
-        return ((coap_peer_datagram_t *)peerP)->transmitWait;
+        return CORE_TIME_TO_SECONDS_CEIL(((coap_peer_datagram_t *)peerP)->transmitWait);
+#endif
+
+#ifdef IOWA_LORAWAN_SUPPORT
+    case IOWA_CONN_LORAWAN:
+        return CORE_TIME_TO_SECONDS_CEIL(((coap_peer_datagram_t *)peerP)->transmitWait);
 #endif
 
 #if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
@@ -828,7 +1531,14 @@ int32_t coapPeerGetExchangeLifetime(iowa_coap_peer_t *peerP)
     {
 #ifdef IOWA_UDP_SUPPORT
     case IOWA_CONN_DATAGRAM:
-        exchangeLifetime = COAP_COMPUTE_MAX_TRANSMIT_SPAN(((coap_peer_datagram_t *)peerP)->ackTimeout, ((coap_peer_datagram_t *)peerP)->maxRetransmit);
+        exchangeLifetime = CORE_TIME_TO_SECONDS_CEIL((int32_t)COAP_COMPUTE_MAX_TRANSMIT_SPAN(((coap_peer_datagram_t *)peerP)->ackTimeout, ((coap_peer_datagram_t *)peerP)->maxRetransmit));
+        break;
+#endif
+
+#ifdef IOWA_LORAWAN_SUPPORT
+    case IOWA_CONN_LORAWAN:
+        // Without retransmission, the exchange lasts as long as the wait for its acknowledgement
+        exchangeLifetime = CORE_TIME_TO_SECONDS_CEIL(((coap_peer_datagram_t *)peerP)->transmitWait);
         break;
 #endif
 
@@ -862,6 +1572,10 @@ void peerHandleMessage(iowa_context_t contextP,
     // WARNING: This function is called in a critical section
     uint8_t code;
 
+#if (IOWA_LOG_LEVEL < IOWA_LOG_LEVEL_INFO)
+    (void)maxPayloadSize;
+#endif
+
     IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "peerP: %p, truncated: %s, maxPayloadSize: %u.", peerP, truncated ? "true" : "false", maxPayloadSize);
     COAP_LOG_MESSAGE("Handling", peerP->base.type, messageP);
 
@@ -887,42 +1601,23 @@ void peerHandleMessage(iowa_context_t contextP,
 #endif
     if (!COAP_IS_REQUEST(messageP->code))
     {
-        coap_exchange_t *exchangeP;
-        coap_exchange_t *parentP;
+        size_t index;
 
         IOWA_LOG_INFO(IOWA_PART_COAP, "Looking for matching exchange.");
 
-        exchangeP = peerP->base.exchangeList;
-        parentP = NULL;
-        while (exchangeP != NULL)
-        {
-            if (exchangeP->tokenLength == messageP->tokenLength
-                && 0 == memcmp(exchangeP->token, messageP->token, exchangeP->tokenLength))
-            {
-                break;
-            }
-            else
-            {
-                parentP = exchangeP;
-                exchangeP = exchangeP->next;
-            }
-        }
-        if (exchangeP != NULL)
+        index = prv_exchangeFind(peerP, messageP->tokenLength, messageP->token);
+        if (index != peerP->base.exchangeTableSize)
         {
+            coap_exchange_t *exchangeP;
+
+            exchangeP = prv_exchangeRemove(peerP, index);
+
             IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Matching exchange found (%p).", (void *)exchangeP);
 
-            if (parentP != NULL)
-            {
-                parentP->next = exchangeP->next;
-            }
-            else
-            {
-                peerP->base.exchangeList = exchangeP->next;
-            }
             {
                 exchangeP->callback(peerP, code, messageP, exchangeP->userData, contextP);
             }
-            iowa_system_free(exchangeP);
+            CORE_POOL_FREE(exchangeP);
 
             IOWA_LOG_INFO(IOWA_PART_COAP, "Exiting.");
 
@@ -932,9 +1627,12 @@ void peerHandleMessage(iowa_context_t contextP,
     else if (truncated == true)
     {
         // This is a request too big for our MTU
+#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+        (void)blockSend413Reply(contextP, peerP, messageP);
+#else
         iowa_coap_message_t *responseP;
 
-        responseP = iowa_coap_message_prepare_response(messageP, IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE);
+        responseP = iowa_coap_message_prepare_response(contextP, messageP, IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (responseP == NULL)
         {
@@ -946,6 +1644,7 @@ void peerHandleMessage(iowa_context_t contextP,
         (void)peerSend(contextP, peerP, responseP, NULL, NULL);
 
         iowa_coap_message_free(responseP);
+#endif
         goto exit;
     }
 
@@ -973,62 +1672,49 @@ uint8_t coapPeerGenerateToken(iowa_coap_peer_t *peerP,
                               uint8_t *lengthP,
                               uint8_t *tokenP)
 {
-    size_t i;
-    int32_t curTime;
-    uint8_t newToken[COAP_MSG_TOKEN_MAX_LEN];
-    coap_exchange_t *exchangeP;
-
-    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Entering peerP: %p, exchangeList: %p", peerP, peerP->base.exchangeList);
-
-    // initialize the token length.
-    *lengthP = 1;
-
-    // generate some number
-    curTime = iowa_system_gettime();
-    curTime = (curTime * (size_t)peerP) + curTime;
-    memcpy(newToken, &curTime, 4);
+    // WARNING: This function is called in a critical section
+    uint32_t value;
 
-    curTime = (curTime * (size_t)tokenP) + curTime;
-    memcpy(newToken + 4, &curTime, 4);
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Entering peerP: %p, exchangeCount: %u", peerP, peerP->base.exchangeCount);
 
-    // check it is not already in use
-    i = 0;
-    exchangeP = peerP->base.exchangeList;
-    while (exchangeP != NULL)
+#ifdef IOWA_LORAWAN_SUPPORT
+    if (peerP->base.type == IOWA_CONN_LORAWAN)
     {
-        if (*lengthP == exchangeP->tokenLength
-            && 0 == memcmp(newToken, exchangeP->token, *lengthP))
+        uint8_t i;
+
+        // Short tokens are sent on their least significant bits by the SCHC rules
+        *lengthP = COAP_LORAWAN_TOKEN_LEN;
+        for (i = 0; i <= COAP_LORAWAN_TOKEN_MASK; i++)
         {
-            uint8_t temp;
+            tokenP[0] = (uint8_t)((peerP->base.tokenSalt + peerP->base.tokenCounter) & COAP_LORAWAN_TOKEN_MASK);
+            peerP->base.tokenCounter++;
 
-            // change the token
-            i++;
-            if (i > (1 << ((uint8_t)(*lengthP * 8))))
+            if (prv_exchangeFind(peerP, *lengthP, tokenP) == peerP->base.exchangeTableSize)
             {
-                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "No more token possibilities with length of %d bytes.", *lengthP);
+                IOWA_LOG_TRACE(IOWA_PART_COAP, "Exiting");
 
-                (*lengthP)++;
-                if (*lengthP > COAP_MSG_TOKEN_MAX_LEN)
-                {
-                    IOWA_LOG_ERROR(IOWA_PART_COAP, "No more token possibilities.");
-                    return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
-                }
+                return IOWA_COAP_NO_ERROR;
             }
-
-            temp = newToken[*lengthP - 1];
-            newToken[*lengthP - 1] = newToken[i % COAP_MSG_TOKEN_MAX_LEN] + 1;
-            newToken[i % COAP_MSG_TOKEN_MAX_LEN] = temp;
-
-            // retest
-            exchangeP = peerP->base.exchangeList;
-        }
-        else
-        {
-          exchangeP = exchangeP->next;
         }
+
+        IOWA_LOG_INFO(IOWA_PART_COAP, "All the short tokens are in use.");
     }
+#endif
+
+    *lengthP = COAP_GENERATED_TOKEN_LEN;
 
-    memcpy(tokenP, newToken, *lengthP);
+    // The mix being a bijection, the tokens only repeat after 2^32 generations.
+    // An exchange still pending after a wrap-around of the counter is skipped.
+    do
+    {
+        value = prv_tokenMix(peerP->base.tokenCounter ^ peerP->base.tokenSalt);
+        peerP->base.tokenCounter++;
+
+        tokenP[0] = (uint8_t)(value >> 24);
+        tokenP[1] = (uint8_t)(value >> 16);
+        tokenP[2] = (uint8_t)(value >> 8);
+        tokenP[3] = (uint8_t)value;
+    } while (prv_exchangeFind(peerP, *lengthP, tokenP) != peerP->base.exchangeTableSize);
 
     IOWA_LOG_TRACE(IOWA_PART_COAP, "Exiting");
 
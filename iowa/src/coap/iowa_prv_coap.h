@@ -74,14 +74,17 @@ extern "C" {
 #define IOWA_COAP_OPTION_MAX_AGE        (uint16_t)14   // integer value
 #define IOWA_COAP_OPTION_URI_QUERY      (uint16_t)15
 #define IOWA_COAP_OPTION_ACCEPT         (uint16_t)17   // integer value
+#define IOWA_COAP_OPTION_Q_BLOCK_1      (uint16_t)19   // integer value
 #define IOWA_COAP_OPTION_LOCATION_QUERY (uint16_t)20
 #define IOWA_COAP_OPTION_BLOCK_2        (uint16_t)23   // integer value
 #define IOWA_COAP_OPTION_BLOCK_1        (uint16_t)27   // integer value
 #define IOWA_COAP_OPTION_SIZE_2         (uint16_t)28   // integer value
+#define IOWA_COAP_OPTION_Q_BLOCK_2      (uint16_t)31   // integer value
 #define IOWA_COAP_OPTION_PROXY_URI      (uint16_t)35
 #define IOWA_COAP_OPTION_PROXY_SCHEME   (uint16_t)39
 #define IOWA_COAP_OPTION_SIZE_1         (uint16_t)60   // integer value
 #define IOWA_COAP_OPTION_NO_RESPONSE    (uint16_t)258  // integer value
+#define IOWA_COAP_OPTION_REQUEST_TAG    (uint16_t)292
 
 #define IOWA_COAP_OBSERVE_REQUEST_NEW     0  // coap option's value for new observation
 #define IOWA_COAP_OBSERVE_REQUEST_CANCEL  1  // coap option's value for cancellation
@@ -124,7 +127,6 @@ typedef struct _coap_transaction_t coap_transaction_t;
 typedef struct _coap_ack_t coap_ack_t;
 typedef struct _coap_exchange_t coap_exchange_t;
 typedef struct _block_transfer_t block_transfer_t;
-typedef struct _block_payload_t block_payload_t;
 typedef struct _oscore_peer_context_t oscore_peer_context_t;
 
 typedef struct
@@ -156,6 +158,10 @@ typedef struct _iowa_coap_option_t
     } value;
 } iowa_coap_option_t;
 
+#ifndef IOWA_COAP_INLINE_OPTION_COUNT
+#define IOWA_COAP_INLINE_OPTION_COUNT 8
+#endif
+
 struct _iowa_coap_message_t
 {
     uint8_t               type;
@@ -166,6 +172,9 @@ struct _iowa_coap_message_t
     iowa_coap_option_t   *optionList;
     iowa_buffer_t         payload;
     iowa_linked_buffer_t *userBufferList;  // user-provided buffers that will be freed by iowa_coap_message_free().
+#if IOWA_COAP_INLINE_OPTION_COUNT > 0
+    iowa_coap_option_t    optionArray[IOWA_COAP_INLINE_OPTION_COUNT]; // first options of a received message, part of optionList.
+#endif
 };
 
 // The callback called when a CoAP request or a CoAP response is received,
@@ -195,15 +204,44 @@ typedef void(*coap_event_callback_t)(iowa_coap_peer_t *fromPeer,
 // optionP: the option to test.
 typedef bool(*coap_option_callback_t) (const iowa_coap_option_t *optionP);
 
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+#ifndef IOWA_COAP_QBLOCK_MAX_PAYLOADS
+#define IOWA_COAP_QBLOCK_MAX_PAYLOADS 10 // blocks sent without waiting for a response
+#endif
+
+// A request received in Q-Block1 blocks.
+// The blocks are handled in sequence, the ones received out of order are reported missing.
+typedef struct
+{
+    uint8_t  tag[COAP_MSG_TOKEN_MAX_LEN]; // Request-Tag shared by the blocks
+    uint8_t  tagLength;
+    bool     active;
+    bool     ended;      // the last block of the body was received
+    bool     respond;    // the block being handled expects a response
+    uint8_t  error;      // code of a failed block, ending the body
+    uint32_t nextNumber; // next block to handle
+    uint32_t highNumber; // one more than the highest block number received
+    uint32_t setStart;   // first block of the current set
+} coap_qblock_receive_t;
+#endif
+
 typedef struct _coap_peer_base_t
 {
     struct _iowa_coap_peer_t *next;
     iowa_connection_type_t    type;
     coap_message_callback_t   requestCallback;
     coap_event_callback_t     eventCallback;
-    coap_exchange_t          *exchangeList;
+    coap_exchange_t         **exchangeTable;     // open-addressed, indexed by token
+    size_t                    exchangeTableSize; // power of two
+    size_t                    exchangeCount;
+    uint32_t                  tokenCounter;
+    uint32_t                  tokenSalt;
     void                     *userData;
     iowa_security_session_t   securityS;
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    bool                      qBlockUnsupported; // the peer rejected the Q-Block1 option
+    coap_qblock_receive_t     qBlock1;           // request being received from the peer
+#endif
 } coap_peer_base_t;
 
 struct _iowa_coap_peer_t
@@ -214,7 +252,8 @@ struct _iowa_coap_peer_t
 // Implemented in iowa_option.c
 size_t option_getSerializedLength(iowa_coap_option_t * optionP, coap_option_callback_t isIntegerCallback);
 size_t option_serialize(iowa_coap_option_t * optionList, uint8_t * buffer, coap_option_callback_t isIntegerCallback);
-uint8_t option_parse(uint8_t * buffer, size_t bufferLength, iowa_coap_option_t * *optionListP, size_t * lengthP, coap_option_callback_t isIntegerCallback);
+uint8_t option_parse(iowa_context_t contextP, uint8_t * buffer, size_t bufferLength, iowa_coap_option_t * optionArray, size_t optionArrayLength, iowa_coap_option_t * *optionListP, size_t * lengthP, coap_option_callback_t isIntegerCallback);
+void option_freeList(iowa_coap_option_t * optionList, iowa_coap_option_t * optionArray, size_t optionArrayLength);
 
 /************************************************
 * APIs
@@ -341,6 +380,24 @@ iowa_security_session_t coapPeerGetSecuritySession(iowa_coap_peer_t *peerP);
 // - peerP: a CoAP peer.
 iowa_connection_type_t coapPeerGetConnectionType(iowa_coap_peer_t *peerP);
 
+#ifdef IOWA_LORAWAN_SUPPORT
+// Prepare the Object IDs used by the SCHC compression of the URIs exchanged with a LoRaWAN peer.
+// The current list is kept until coapPeerApplyObjectList() is called, as the LoRaWAN Network may still send
+// messages compressed with it.
+// Returned value: None.
+// Parameters:
+// - peerP: a CoAP peer.
+// - idArray: the sorted Object IDs allocated with iowa_system_malloc(). The peer takes ownership of it. Can be nil.
+// - count: the number of elements in idArray.
+void coapPeerPrepareObjectList(iowa_coap_peer_t *peerP, uint16_t *idArray, uint16_t count);
+
+// Use the Object IDs prepared with coapPeerPrepareObjectList(), once the peer acknowledged them.
+// Returned value: None.
+// Parameters:
+// - peerP: a CoAP peer.
+void coapPeerApplyObjectList(iowa_coap_peer_t *peerP);
+#endif
+
 // Send a CoAP message to a peer.
 // Returned value: '0' in case of success or an error code in the form of a CoAP code.
 // Parameters:
@@ -373,7 +430,7 @@ int32_t coapPeerGetExchangeLifetime(iowa_coap_peer_t *peerP);
 // Parameters:
 // - peerP: the CoAP peer to send the message to.
 // - lengthP: OUT. the length in bytes of 'tokenP'.
-// - tokenP: OUT. the generated token.
+// - tokenP: OUT. the generated token. Must be COAP_MSG_TOKEN_MAX_LEN bytes long.
 uint8_t coapPeerGenerateToken(iowa_coap_peer_t *peerP,
                               uint8_t *lengthP,
                               uint8_t *tokenP);
@@ -425,15 +482,42 @@ iowa_status_t coapRequestAll(iowa_context_t contextP,
 size_t coapMessageSerializeDatagram(iowa_coap_message_t *messageP,
                                     uint8_t **bufferP);
 
+// Serialize the header, token, options and payload marker of a CoAP message for datagram transports.
+// The payload is not copied and must be sent after the returned bytes.
+// Returned value: the length of the serialized header or 0 if it does not fit in the buffer.
+// Parameters:
+// - messageP: the CoAP message to serialize.
+// - buffer: to store the serialized header.
+// - bufferLength: the size of buffer.
+size_t coapMessageSerializeDatagramHeader(iowa_coap_message_t *messageP,
+                                          uint8_t *buffer,
+                                          size_t bufferLength);
+
 // Serialize a CoAP message for stream stransports (e.g. TCP).
-// Returned value: the length of the serialized buffer.
+// Returned value: the length of the serialized buffer, including the headroom.
 // Parameters:
 // - messageP: the CoAP message to serialize.
+// - withLength: false if the transport frames the messages itself (WebSockets).
+// - headroom: the number of bytes left at the start of the buffer for the transport framing.
 // - bufferP: OUT. the serialized buffer.
 size_t coapMessageSerializeStream(iowa_coap_message_t *messageP,
                                   bool withLength,
+                                  size_t headroom,
                                   uint8_t **bufferP);
 
+// Serialize the header, token, options and payload marker of a CoAP message for stream transports.
+// The payload is not copied and must be sent after the returned bytes.
+// Returned value: the length of the serialized header or 0 if it does not fit in the buffer.
+// Parameters:
+// - messageP: the CoAP message to serialize.
+// - withLength: false if the transport frames the messages itself (WebSockets).
+// - buffer: to store the serialized header.
+// - bufferLength: the size of buffer.
+size_t coapMessageSerializeStreamHeader(iowa_coap_message_t *messageP,
+                                        bool withLength,
+                                        uint8_t *buffer,
+                                        size_t bufferLength);
+
 // Request the next block.
 // Returned value: '0' in case of success or an error code in the form of a CoAP code.
 // Parameters:
@@ -463,6 +547,7 @@ uint8_t coapDecodeBlockInfo(uint32_t value,
                             uint16_t *sizeP);
 
 // Encode block information.
+// Returned value: '0' in case of success or an error code in the form of a CoAP code.
 // Parameters:
 // - number: the block number.
 // - more: true if there are more blocks coming.
@@ -473,6 +558,132 @@ uint8_t coapEncodeBlockInfo(uint32_t number,
                             uint16_t size,
                             uint32_t *valueP);
 
+// Get the size of the blocks exchanged with a peer: the largest one fitting in the receive buffer
+// and, for stream peers, in the Max-Message-Size of the peer.
+// Returned value: the size of the blocks, from 16 to 1024 bytes.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the CoAP peer.
+uint16_t coapBlockGetSize(iowa_context_t contextP,
+                          iowa_coap_peer_t *peerP);
+
+// Get the payload length of the BERT blocks exchanged with a stream peer.
+// Returned value: a multiple of 1024 bytes, or 0 if BERT blocks are not used with this peer.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the CoAP peer.
+size_t coapBlockGetBertSize(iowa_context_t contextP,
+                            iowa_coap_peer_t *peerP);
+
+// Decode the block information received from a peer, BERT blocks included.
+// Returned value: '0' in case of success or an error code in the form of a CoAP code.
+// Parameters:
+// - peerP: the CoAP peer the block information was received from.
+// - value: the block value to decode.
+// - numberP: OUT. the block number, counted in blocks of 1024 bytes for BERT blocks.
+// - moreP: OUT. true if there are more blocks coming.
+// - sizeP: OUT. the size of the block, 1024 for BERT blocks.
+// - bertP: OUT. true if the block is a BERT block, carrying a multiple of 1024 bytes.
+uint8_t coapBlockDecodePeerInfo(iowa_coap_peer_t *peerP,
+                                uint32_t value,
+                                uint32_t *numberP,
+                                bool *moreP,
+                                uint16_t *sizeP,
+                                bool *bertP);
+
+// Set the Block1 or Block2 option of a message, adding it if needed.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - messageP: the CoAP message.
+// - optionNumber: IOWA_COAP_OPTION_BLOCK_1 or IOWA_COAP_OPTION_BLOCK_2.
+// - number: the block number.
+// - more: true if there are more blocks coming.
+// - size: the size of the block.
+uint8_t coapBlockSetOption(iowa_context_t contextP,
+                           iowa_coap_message_t *messageP,
+                           uint16_t optionNumber,
+                           uint32_t number,
+                           bool more,
+                           uint16_t size);
+
+// Set the Block1 or Block2 option of a message to a BERT block, adding it if needed.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - messageP: the CoAP message.
+// - optionNumber: IOWA_COAP_OPTION_BLOCK_1 or IOWA_COAP_OPTION_BLOCK_2.
+// - number: the number of the first block of 1024 bytes.
+// - more: true if there are more blocks coming.
+uint8_t coapBlockSetBertOption(iowa_context_t contextP,
+                               iowa_coap_message_t *messageP,
+                               uint16_t optionNumber,
+                               uint32_t number,
+                               bool more);
+
+// Keep in the payload of a response only the block asked by the Block2 option of the request.
+// Without Block2 option in the request, the first block is kept if the payload does not fit in a single one.
+// The block is moved at the start of the payload buffer and the Block2 and Size2 options are added.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the CoAP peer the response is sent to.
+// - requestP: the request. This can be nil for notifications.
+// - responseP: the response.
+uint8_t coapBlockPrepareResponse(iowa_context_t contextP,
+                                 iowa_coap_peer_t *peerP,
+                                 iowa_coap_message_t *requestP,
+                                 iowa_coap_message_t *responseP);
+
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+// Record a block of a request received in Q-Block1 blocks.
+// A block with another Request-Tag starts a new body.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - peerP: the CoAP peer the request was received from.
+// - requestP: the request.
+// - number: the block number.
+// - more: true if there are more blocks coming.
+// - nextP: OUT. true if the block is the next one of the body and must be handled.
+uint8_t coapQBlock1Receive(iowa_coap_peer_t *peerP,
+                           iowa_coap_message_t *requestP,
+                           uint32_t number,
+                           bool more,
+                           bool *nextP);
+
+// Prepare the response to a block recorded by coapQBlock1Receive().
+// Only the confirmable blocks, the last block of a set or of the body and the retransmitted blocks get a response:
+// 2.31 to continue, 4.08 listing the missing blocks, or the result of the last block.
+// Returned value: the code of the response or IOWA_COAP_CODE_EMPTY if no response is expected.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the CoAP peer the request was received from.
+// - requestP: the request.
+// - result: IOWA_COAP_231_CONTINUE or IOWA_COAP_204_CHANGED if the block was handled, an error status otherwise.
+// - responseP: the response.
+uint8_t coapQBlock1PrepareResponse(iowa_context_t contextP,
+                                   iowa_coap_peer_t *peerP,
+                                   iowa_coap_message_t *requestP,
+                                   uint8_t result,
+                                   iowa_coap_message_t *responseP);
+
+// Send the response to a request carrying a Q-Block2 option.
+// The block asked is sent in the response. When the M bit of the request is set, the following blocks of the set
+// are sent in non-confirmable messages with the same token.
+// The payload of the response is either the whole content or, if the response already carries a Q-Block2 option,
+// the blocks starting with the one of this option.
+// Returned value: the result of the sending of the response.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the CoAP peer the response is sent to.
+// - requestP: the request.
+// - responseP: the response. Its payload is left unchanged.
+uint8_t coapQBlock2SendResponse(iowa_context_t contextP,
+                                iowa_coap_peer_t *peerP,
+                                iowa_coap_message_t *requestP,
+                                iowa_coap_message_t *responseP);
+#endif
+
 // Add an user buffer to the CoAP message.
 // Parameters:
 // - messageP: the message to add the buffer too. Not tested for validity.
@@ -487,8 +698,10 @@ void coapMessageAddUserBuffer(iowa_coap_message_t *messageP,
 // Create a CoAP option.
 // Returned value: If created, the option else NULL.
 // Parameters:
+// - contextP: returned by iowa_init().
 // - number: the CoAP option number.
-iowa_coap_option_t *iowa_coap_option_new(uint16_t number);
+iowa_coap_option_t *iowa_coap_option_new(iowa_context_t contextP,
+                                         uint16_t number);
 
 // Free a CoAP option.
 // Returned value: none.
@@ -498,10 +711,12 @@ void iowa_coap_option_free(iowa_coap_option_t *optionP);
 
 // Create CoAP options for each segment of a path.
 // Returned value: If created, the options else NULL.
+// - contextP: returned by iowa_init().
 // - number: the CoAP option number.
 // - path: the path. Must be valid until the option is freed.
 // - delimiter: the delimiter used to obtain the segments.
-iowa_coap_option_t *iowa_coap_path_to_option(uint16_t number,
+iowa_coap_option_t *iowa_coap_path_to_option(iowa_context_t contextP,
+                                             uint16_t number,
                                              const char *path,
                                              char delimiter);
 
@@ -526,11 +741,13 @@ bool iowa_coap_option_is_integer(const iowa_coap_option_t *optionP);
 // Create a CoAP message.
 // Returned value: If created, the message else NULL.
 // Parameters:
+// - contextP: returned by iowa_init().
 // - type: the CoAP message type. Unused for stream transports.
 // - code: the CoAP message code.
 // - tokenLength: length in bytes of 'token'.
 // - token: the CoAP message token.
-iowa_coap_message_t *iowa_coap_message_new(uint8_t type,
+iowa_coap_message_t *iowa_coap_message_new(iowa_context_t contextP,
+                                           uint8_t type,
                                            uint8_t code,
                                            uint8_t tokenLength,
                                            uint8_t *token);
@@ -544,9 +761,11 @@ void iowa_coap_message_free(iowa_coap_message_t *messageP);
 // Prepare a CoAP response message from a received CoAP message.
 // Returned value: If created, the response message else NULL.
 // Parameters:
+// - contextP: returned by iowa_init().
 // - messageP: the received CoAP message.
 // - code: the CoAP response message code.
-iowa_coap_message_t *iowa_coap_message_prepare_response(iowa_coap_message_t *messageP,
+iowa_coap_message_t *iowa_coap_message_prepare_response(iowa_context_t contextP,
+                                                        iowa_coap_message_t *messageP,
                                                         uint8_t code);
 
 // Add a CoAP option to a CoAP message.
@@ -67,6 +67,17 @@ extern "C" {
 #define COAP_FIRST_MID 1
 
 #define COAP_BLOCK_OPTION_MAX_LENGTH 4
+#define COAP_BLOCK_MIN_SIZE          16
+#define COAP_BLOCK_MAX_SIZE          1024
+#define COAP_BLOCK_SZX_RESERVED      7
+#define COAP_BLOCK_SZX_BERT          7 // RFC 8323 Section 6: blocks of several times 1024 bytes on stream transports
+#define COAP_BLOCK_DATAGRAM_OVERHEAD 64 // header, token and options sent along a block
+
+#define COAP_DATAGRAM_MIN_BUFFER_SIZE 12 // header and longest token
+
+#define COAP_GENERATED_TOKEN_LEN   4
+
+#define COAP_EXCHANGE_TABLE_MIN_SIZE 8 // must be a power of two
 
 #define COAP_DEFAULT_NSTART        1
 
@@ -78,12 +89,37 @@ extern "C" {
 #define COAP_SMS_ACK_REAL_TIMEOUT  15 // COAP_ACK_TIMEOUT * COAP_ACK_RANDOM_FACTOR
 #define COAP_SMS_MAX_RETRANSMIT    4
 
-#define COAP_LORAWAN_ACK_REAL_TIMEOUT  0 // Disable transaction retransmission
-#define COAP_LORAWAN_MAX_RETRANSMIT    0
-#define COAP_LORAWAN_NSTART            1
-#define COAP_LORAWAN_MAX_TRANSMIT_WAIT 120
-
-#define COAP_TCP_MAX_TRANSMIT_WAIT 20
+#define COAP_LORAWAN_ACK_REAL_TIMEOUT   0    // Disable transaction retransmission
+#define COAP_LORAWAN_MAX_RETRANSMIT     0
+#define COAP_LORAWAN_NSTART             1
+#define COAP_LORAWAN_MAX_TRANSMIT_WAIT  120
+#define COAP_LORAWAN_MIN_FRAME_SIZE     11   // smallest application payload of LoRaWAN regional parameters (DR0 of US915)
+#define COAP_LORAWAN_MAX_FRAME_SIZE     242  // largest application payload of LoRaWAN regional parameters
+#define COAP_LORAWAN_BLOCK_OVERHEAD     12   // compressed header, token and options sent along a block
+#define COAP_LORAWAN_SHORT_MID_MAX      0x0F // Message IDs sent on 4 bits by the SCHC rules
+#define COAP_LORAWAN_LONG_MID_MAX       0xFF // Message IDs sent on 8 bits by the SCHC rules, the others are sent on 16 bits
+#define COAP_LORAWAN_TOKEN_LEN          1    // length of the generated tokens
+#define COAP_LORAWAN_TOKEN_MASK         0x0F // generated tokens are kept in the range compressed by the SCHC rules
+
+#define COAP_TCP_MAX_TRANSMIT_WAIT       20
+#define COAP_TCP_DEFAULT_MAX_MESSAGE_SIZE 1152 // assumed until the CSM of the peer is received
+
+// WebSocket framing (RFC 6455) as used by RFC 8323 Section 4
+#define COAP_WS_FRAME_MAX_HEADER_LENGTH 14 // flags and opcode, 64-bit length and masking key
+#define COAP_WS_ACCEPT_LENGTH           28 // Base64 encoded SHA-1 digest
+#define COAP_WS_PATH                    "/.well-known/coap"
+
+#define COAP_WS_OPCODE_CONTINUATION (uint8_t)0x00
+#define COAP_WS_OPCODE_TEXT         (uint8_t)0x01
+#define COAP_WS_OPCODE_BINARY       (uint8_t)0x02
+#define COAP_WS_OPCODE_CLOSE        (uint8_t)0x08
+#define COAP_WS_OPCODE_PING         (uint8_t)0x09
+#define COAP_WS_OPCODE_PONG         (uint8_t)0x0A
+
+#define COAP_WS_CLOSE_NORMAL           (uint16_t)1000
+#define COAP_WS_CLOSE_PROTOCOL_ERROR   (uint16_t)1002
+#define COAP_WS_CLOSE_UNSUPPORTED_DATA (uint16_t)1003
+#define COAP_WS_CLOSE_MESSAGE_TOO_BIG  (uint16_t)1009
 
 #define COAP_ACK_RANDOM_FACTOR  1.5
 #define COAP_MAX_LATENCY        100
@@ -92,6 +128,61 @@ extern "C" {
 #define COAP_COMPUTE_MAX_TRANSMIT_WAIT(T, R) (uint32_t)((((T) * ((1 << ((R) + 1)) - 1) * COAP_ACK_RANDOM_FACTOR))) // 93 seconds
 #define COAP_COMPUTE_MAX_TRANSMIT_SPAN(T, R) (uint32_t)((((T) * ((1 << (R)) - 1) * COAP_ACK_RANDOM_FACTOR)))       // 45 seconds
 
+// Outbound queue of the datagram peers
+#ifndef IOWA_COAP_SEND_QUEUE_SIZE
+#define IOWA_COAP_SEND_QUEUE_SIZE 16
+#endif
+#ifndef IOWA_COAP_SEND_BURST
+#define IOWA_COAP_SEND_BURST 8
+#endif
+#ifndef IOWA_COAP_SEND_RATE
+#define IOWA_COAP_SEND_RATE 20    // datagrams per second once the burst is exhausted
+#endif
+#if IOWA_COAP_SEND_BURST < 1 || IOWA_COAP_SEND_BURST > 255
+#error "IOWA_COAP_SEND_BURST must be between 1 and 255."
+#endif
+#if IOWA_COAP_SEND_RATE < 1
+#error "IOWA_COAP_SEND_RATE must be greater than zero."
+#endif
+
+// Stream transports (RFC 8323)
+#if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
+#ifndef IOWA_COAP_STREAM_MAX_MESSAGE_SIZE
+#define IOWA_COAP_STREAM_MAX_MESSAGE_SIZE COAP_TCP_DEFAULT_MAX_MESSAGE_SIZE // receive buffer of a stream peer, advertised in the CSM
+#endif
+#if IOWA_COAP_STREAM_MAX_MESSAGE_SIZE < 64
+#error "IOWA_COAP_STREAM_MAX_MESSAGE_SIZE must be at least 64."
+#endif
+#ifndef IOWA_COAP_STREAM_PING_INTERVAL
+#define IOWA_COAP_STREAM_PING_INTERVAL 0 // seconds of inactivity before sending a Ping, 0 to disable
+#endif
+#endif
+
+// Q-Block transfers (RFC 9177)
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+#if IOWA_COAP_QBLOCK_MAX_PAYLOADS < 1 || IOWA_COAP_QBLOCK_MAX_PAYLOADS > IOWA_COAP_SEND_QUEUE_SIZE
+#error "IOWA_COAP_QBLOCK_MAX_PAYLOADS must be between 1 and IOWA_COAP_SEND_QUEUE_SIZE."
+#endif
+#define COAP_QBLOCK_NON_TIMEOUT      2 // seconds
+#define COAP_QBLOCK_MAX_RETRANSMIT   4
+#define COAP_CONTENT_FORMAT_MISSING_BLOCKS 272 // application/missing-blocks+cbor-seq
+#endif
+
+// Duplicate detection cache of the datagram peers
+#ifndef IOWA_COAP_ACK_CACHE_COUNT
+#define IOWA_COAP_ACK_CACHE_COUNT 16
+#endif
+#if IOWA_COAP_ACK_CACHE_COUNT > 32768
+#error "IOWA_COAP_ACK_CACHE_COUNT must not exceed 32768."
+#endif
+
+// Congestion control based on draft-ietf-core-cocoa
+#define COAP_COCOA_WEAK_MAX_RETRANSMIT 2      // RTT measures of transactions retransmitted more are discarded
+#define COAP_COCOA_STRONG_K            4
+#define COAP_COCOA_WEAK_K              1
+#define COAP_COCOA_RTO_MIN             200    // in internal time unit, only with IOWA_TIME_MS_SUPPORT
+#define COAP_COCOA_RTO_MAX             60000  // in internal time unit, only with IOWA_TIME_MS_SUPPORT
+
 /************************************************
  * Macros
  */
@@ -156,15 +247,18 @@ extern "C" {
                                ((S) == IOWA_COAP_OPTION_MAX_AGE ? "Max Age" :               \
                                ((S) == IOWA_COAP_OPTION_URI_QUERY ? "URI Query" :           \
                                ((S) == IOWA_COAP_OPTION_ACCEPT ? "Accept" :                 \
+                               ((S) == IOWA_COAP_OPTION_Q_BLOCK_1 ? "Q-Block 1" :           \
                                ((S) == IOWA_COAP_OPTION_LOCATION_QUERY ? "Location Query" : \
                                ((S) == IOWA_COAP_OPTION_BLOCK_2 ? "Block 2" :               \
                                ((S) == IOWA_COAP_OPTION_BLOCK_1 ? "Block 1" :               \
                                ((S) == IOWA_COAP_OPTION_SIZE_2 ? "Size 2" :                 \
+                               ((S) == IOWA_COAP_OPTION_Q_BLOCK_2 ? "Q-Block 2" :           \
                                ((S) == IOWA_COAP_OPTION_PROXY_URI ? "Proxy URI" :           \
                                ((S) == IOWA_COAP_OPTION_PROXY_SCHEME ? "Proxy Scheme" :     \
                                ((S) == IOWA_COAP_OPTION_SIZE_1 ? "Size 1" :                 \
                                ((S) == IOWA_COAP_OPTION_NO_RESPONSE ? "No Response" :       \
-                               "Unknown")))))))))))))))))))))
+                               ((S) == IOWA_COAP_OPTION_REQUEST_TAG ? "Request Tag" :       \
+                               "Unknown"))))))))))))))))))))))))
 
 
 #define PEER_CALL_EVENT_CALLBACK(C, P, E)                                               \
@@ -189,77 +283,188 @@ struct _coap_transaction_t
     struct _coap_transaction_t *next;
     uint16_t                    mID;
     uint8_t                     retrans_counter;
-    int32_t                     retrans_time;
+    bool                        queued;       // waiting for less than NSTART outstanding transactions
+    iowa_time_t                 retrans_time;
+    iowa_time_t                 first_time;   // time of the first transmission
+    int32_t                     timeout;      // current retransmission timeout, in internal time unit
     size_t                      buffer_len;
     uint8_t                    *buffer;
     coap_message_callback_t     callback;
     void                       *userData;
 };
 
+// Classes of the queued outbound messages, by decreasing priority.
+typedef enum
+{
+    COAP_SEND_CLASS_RESPONSE = 0,  // acknowledgements and resets
+    COAP_SEND_CLASS_REQUEST,       // registration, update, deregistration...
+    COAP_SEND_CLASS_NOTIFICATION   // notifications and separate responses
+} coap_send_class_t;
+
+typedef struct _coap_send_item_t
+{
+    struct _coap_send_item_t *next;
+    coap_send_class_t         sendClass;
+    uint8_t                   type;
+    uint16_t                  mID;
+    size_t                    buffer_len;
+    uint8_t                  *buffer;
+    coap_message_callback_t   callback;
+    void                     *userData;
+} coap_send_item_t;
+
 struct _coap_ack_t
 {
-    struct _coap_ack_t *next;
+    struct _coap_ack_t *next;  // in the same bucket of the index
     uint16_t            mID;
-    int32_t             validity_time;
+    iowa_time_t         validity_time;
     size_t              buffer_len;
     uint8_t            *buffer;
 };
 
+// Replies sent to the confirmable messages, kept for duplicate detection.
+// The entries are stored in a ring in insertion order, which is also their expiry order,
+// and indexed by message ID in a chained hash table. Both are allocated with the first entry.
+typedef struct
+{
+    coap_ack_t  *ring;
+    coap_ack_t **bucketArray;
+    uint32_t     bucketCount;  // power of two
+    uint16_t     capacity;     // maximum number of entries
+    uint16_t     head;         // index of the oldest entry
+    uint16_t     count;
+    size_t       memorySize;   // bytes of the cached replies
+} coap_ack_cache_t;
+
 struct _coap_exchange_t
 {
-    struct _coap_exchange_t *next;
     uint8_t                  token[COAP_MSG_TOKEN_MAX_LEN];
     uint8_t                  tokenLength; // '0' means no token.
+    uint16_t                 mID;         // of the confirmable datagram carrying the request, COAP_RESERVED_MID otherwise.
     coap_message_callback_t  callback;
     void                    *userData;
 };
 
+// A request sent in several Block1 blocks.
+// The options and the payload of the request are copied after the structure.
 struct _block_transfer_t
 {
-    struct _block_transfer_t *next;
-    iowa_coap_peer_t    *peerP;
-    iowa_coap_message_t *messageP;
-    iowa_coap_option_t  *optionP;
-    bool            isMessageDuplicated;
-    uint8_t         szx;
-    size_t          payloadLength;
-    uint8_t        *payload;
+    iowa_coap_message_t      message;       // the block being sent
+    iowa_coap_option_t       blockOption;
+    iowa_coap_option_t       sizeOption;
+    uint8_t                 *payload;
+    size_t                   payloadLength;
+    size_t                   offset;        // of the block being sent
+    uint8_t                  szx;
+    size_t                   bertSize;      // payload of a block when szx is COAP_BLOCK_SZX_BERT
     coap_message_callback_t  resultCallback;
     void                    *userData;
-    size_t          index;
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    bool                     qBlock;        // blocks are sent in Q-Block1 by sets of non-confirmable messages
+    iowa_coap_option_t       tagOption;     // Request-Tag shared by the blocks
+    uint8_t                  tag[COAP_MSG_TOKEN_MAX_LEN];
+    uint32_t                 nextNumber;    // first block not sent yet, 0 while the first block is pending
+    uint32_t                 lastNumber;    // block carrying the token of the pending exchange
+    uint8_t                  lastToken[COAP_MSG_TOKEN_MAX_LEN];
+    uint8_t                  lastTokenLength;
+    uint8_t                  retryCount;    // retransmissions of the last block without response
+    uint8_t                  missingCount;  // 4.08 responses received for the current set
+    iowa_coap_peer_t        *peerP;
+    iowa_timer_t            *timerP;       // waiting for a response to the last block of a set
+#endif
 };
 
-struct _block_payload_t
+// Round-trip time estimator as defined in RFC 6298.
+typedef struct
 {
-    struct _block_payload_t *next;
-    iowa_linked_buffer_t    *bufferP;
-    iowa_coap_message_t     *messageP;
-    iowa_coap_option_t      *optionP;
-    coap_message_callback_t  resultCallback;
-    void                    *userData;
-};
+    int32_t srtt;    // in internal time unit, 0 until the first measure
+    int32_t rttvar;  // in internal time unit
+} coap_rtt_estimator_t;
 
 typedef struct
 {
-    coap_peer_base_t    base;
-    uint8_t             ackTimeout;
-    uint8_t             maxRetransmit;
-    uint16_t            transmitWait;
-    uint16_t            nextMID;
-    coap_transaction_t *transactionList;
-    coap_ack_t         *ackList;
+    coap_peer_base_t     base;
+    int32_t              ackTimeout;   // in internal time unit
+    uint8_t              maxRetransmit;
+    int32_t              transmitWait; // in internal time unit
+    uint16_t             nextMID;
+    coap_transaction_t  *transactionList;
+    coap_ack_cache_t     ackCache;
+    int32_t              rto;          // base retransmission timeout, in internal time unit
+    iowa_time_t          rtoTime;      // time of the last update of rto
+    coap_rtt_estimator_t strongRtt;    // measured on transactions acknowledged without retransmission
+    coap_rtt_estimator_t weakRtt;      // measured on transactions acknowledged after retransmissions
+    uint32_t             randomState;
+    coap_send_item_t    *sendQueue;    // ordered by class
+    uint8_t              sendTokens;   // datagrams that can be sent before pacing applies
+    iowa_time_t          sendTime;     // time of the last token refill
+    iowa_time_t          stepTime;     // time of the next step of the peer, when scheduled
+    size_t               stepIndex;    // position in the step heap of the CoAP context or COAP_STEP_INDEX_NONE
+#ifdef IOWA_LORAWAN_SUPPORT
+    bool                 schcIsDevice;           // the SCHC compression uses the uplink rules
+    uint8_t              schcFrameSize;          // largest LoRaWAN application payload at the current data rate
+    uint16_t            *schcObjectArray;        // sorted LwM2M Object IDs shared by both ends
+    uint16_t             schcObjectCount;
+    uint16_t            *schcPendingObjectArray; // Object IDs sent in a Register or an Update not acknowledged yet
+    uint16_t             schcPendingObjectCount;
+    uint16_t             schcShortMID;           // next Message ID sent on 4 bits, nextMID holds the next one sent on 8 bits
+    iowa_time_t          schcShortMIDTime[COAP_LORAWAN_SHORT_MID_MAX + 1]; // time when each short Message ID can be used again
+#endif
 } coap_peer_datagram_t;
 
+#define COAP_STEP_INDEX_NONE SIZE_MAX
+
 typedef struct
 {
     coap_peer_base_t     base;
     coap_stream_state_t  state;
+    uint8_t             *recvBuffer;     // allocated on the first reception, starts with the incomplete message if any
+    size_t               recvLength;     // bytes in recvBuffer
+    size_t               discardLength;  // bytes of a too large message still to skip
+    uint32_t             maxMessageSize; // as indicated in the CSM of the peer
+    uint32_t             pingInterval;   // seconds of inactivity before sending a Ping, 0 to disable
+    iowa_timer_t        *timerP;         // waiting for the CSM of the peer or for the next keepalive check
+    bool                 received;       // a message was received since the timer was armed
+    bool                 pingSent;       // a Ping is waiting for a response
+    bool                 bert;           // both CSMs indicated Block-Wise-Transfer, BERT blocks can be exchanged
+#ifdef IOWA_WEBSOCKET_SUPPORT
+    bool                 wsOpen;         // the WebSocket opening handshake is done
+    char                *wsHost;         // Host header field of the opening handshake, nil if the peer opened the connection
+    uint8_t              wsAccept[COAP_WS_ACCEPT_LENGTH]; // Sec-WebSocket-Accept expected from the peer
+#endif
 } coap_peer_stream_t;
 
+#ifdef IOWA_WEBSOCKET_SUPPORT
+typedef struct
+{
+    uint8_t  opcode;
+    bool     isFinal;
+    bool     isMasked;
+    uint8_t  maskKey[4];
+    uint64_t length;     // of the payload
+} coap_ws_frame_t;
+#endif
+
 // The CoAP stack internal context.
 struct _coap_context_t
 {
     iowa_coap_peer_t              *peerList;
+#if (defined(IOWA_UDP_SUPPORT) && defined(IOWA_CONNECTION_RECVV_SUPPORT)) || defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
+    iowa_coap_peer_t              *recvPeerP;            // peer whose received messages are being handled, reset if it is deleted
+#endif
+#ifdef IOWA_UDP_SUPPORT
+    uint8_t                       *recvBuffer;           // allocated on the first reception
+    size_t                         recvBufferLength;     // size of a datagram buffer in recvBuffer
+    size_t                         recvDatagramMaxSize;  // as set by iowa_receive_buffer_set_size()
+#endif
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+    // Binary min-heap of the datagram peers with a pending retransmission, reply expiry or queued message,
+    // ordered by step time. Idle peers are not stepped.
+    coap_peer_datagram_t         **stepHeap;
+    size_t                         stepCount;
+    size_t                         stepCapacity;
+    coap_peer_datagram_t          *stepPeerP;            // peer being stepped, reset if it is deleted
+#endif
 };
 
 typedef struct
@@ -280,6 +485,22 @@ void coapMessageCallback(iowa_coap_peer_t *fromPeer, uint8_t code, iowa_coap_mes
 void coapInternalMessageCallback(iowa_coap_peer_t *fromPeer, uint8_t code, iowa_coap_message_t *messageP, void *userData, iowa_context_t contextP);
 
 // Implemented in iowa_coap.c
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+// Ensure a datagram peer is stepped no later than a given time.
+// Returned value: none.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - stepTime: the time of the deadline.
+void coapPeerSchedule(iowa_context_t contextP, coap_peer_datagram_t *peerP, iowa_time_t stepTime);
+
+// Remove a datagram peer from the step heap.
+// Returned value: none.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+void coapPeerUnschedule(iowa_context_t contextP, coap_peer_datagram_t *peerP);
+#endif
 void messageLog(const char *function, unsigned int line, const char *info, iowa_connection_type_t type, iowa_coap_message_t *messageP);
 #if IOWA_LOG_LEVEL >= IOWA_LOG_LEVEL_INFO
 #define COAP_LOG_MESSAGE(I, T, M) messageLog(__func__, __LINE__, (I), (T), (M))
@@ -289,88 +510,107 @@ void messageLog(const char *function, unsigned int line, const char *info, iowa_
 
 // Implemented in iowa_peer.c
 uint8_t peerSend(iowa_context_t contextP, iowa_coap_peer_t *peerP, iowa_coap_message_t *messageP, coap_message_callback_t resultCallback, void *userData);
+void peerCancelExchange(iowa_coap_peer_t *peerP, uint8_t tokenLength, const uint8_t *token);
+#if defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)
+// Fail the pending exchanges of a peer, for instance when its connection is lost.
+// Returned value: false if an exchange callback deleted the peer, true otherwise.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the CoAP peer.
+// - code: the error code passed to the exchange callbacks.
+bool peerFailExchanges(iowa_context_t contextP, iowa_coap_peer_t *peerP, uint8_t code);
+#endif
 int peerSendBuffer(iowa_context_t contextP, iowa_coap_peer_t *peerP, uint8_t *buffer, size_t bufferLength);
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+int peerSendSegments(iowa_context_t contextP, iowa_coap_peer_t *peerP, iowa_connection_segment_t *segmentArray, size_t segmentCount);
+#endif
 int peerRecvBuffer(iowa_context_t contextP, iowa_coap_peer_t *peerP, uint8_t *buffer, size_t bufferLength);
+#ifdef IOWA_CONNECTION_RECVV_SUPPORT
+int peerRecvSegments(iowa_context_t contextP, iowa_coap_peer_t *peerP, iowa_connection_segment_t *segmentArray, size_t segmentCount);
+#endif
 void peerHandleMessage(iowa_context_t contextP, iowa_coap_peer_t *peerP, iowa_coap_message_t *messageP, bool truncated, size_t maxPayloadSize);
 
 // Implemented in iowa_transaction.c
 void transactionFree(coap_transaction_t *transacP);
-uint8_t transactionNew(iowa_context_t contextP, coap_peer_datagram_t *peerP, iowa_coap_message_t *messageP, uint8_t *buffer, size_t bufferLength, coap_message_callback_t resultCallback, void *userData);
-uint8_t transactionStep(iowa_context_t contextP, coap_peer_datagram_t *peerP, int32_t currentTime, int32_t *timeoutP);
+uint8_t transactionNew(iowa_context_t contextP, coap_peer_datagram_t *peerP, uint8_t type, uint16_t mID, uint8_t *buffer, size_t bufferLength, bool queued, coap_message_callback_t resultCallback, void *userData);
+bool transactionCanStart(coap_peer_datagram_t *peerP);
+void transactionResetRto(coap_peer_datagram_t *peerP);
+uint8_t transactionStep(iowa_context_t contextP, coap_peer_datagram_t *peerP, iowa_time_t currentTime, int32_t *timeoutP);
 void transactionHandleMessage(iowa_context_t contextP, coap_peer_datagram_t *peerP, iowa_coap_message_t *messageP, bool truncated, size_t maxPayloadSize);
-void acknowledgeFree(coap_ack_t *ackP);
+void acknowledgeCacheClear(coap_peer_datagram_t *peerP);
 
 // Implemented in iowa_message.c
 
 // Extract a received COAP message's information from its header.
 // Returned value: the COAP message's header length in case of success or 0 if an error occurred.
 // Parameters:
+// - contextP: returned by iowa_init().
 // - buffer: a buffer containing a received COAP message over an UDP socket.
 // - bufferLength: the COAP message length.
 // - messageP: OUT. a pointer to a coap message.
-size_t messageDatagramParseHeader(uint8_t *buffer, size_t bufferLength, iowa_coap_message_t **messageP);
-uint8_t messageDatagramParse(uint8_t *buffer, size_t bufferLength, iowa_coap_message_t **messageP);
+size_t messageDatagramParseHeader(iowa_context_t contextP, uint8_t *buffer, size_t bufferLength, iowa_coap_message_t **messageP);
+uint8_t messageDatagramParse(iowa_context_t contextP, uint8_t *buffer, size_t bufferLength, iowa_coap_message_t **messageP);
 iowa_coap_message_t *messageDuplicate(iowa_coap_message_t *messageP, bool withMemory);
 // Get the COAP message's header length from its first byte.
-// Returned value: the COAP message's header length in case of success or 0 if an error occurred.
+// Returned value: the length of the COAP message's header, without the token.
 // Parameters:
 // - lenField: the first byte of a received COAP message over a TCP socket.
 uint8_t messageStreamParseLengthField(uint8_t lenField);
 // Extract a received COAP message's information from its header.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
+// - contextP: returned by iowa_init().
 // - buffer: a buffer containing a received COAP message's header over a TCP socket.
-// - bufferLength: the header's length.
+// - bufferLength: the header's length, including the token.
 // - messageP: OUT. a pointer to a coap message.
-// - lengthP: OUT. the COAP message's body length.
-uint8_t messageStreamParseHeader(uint8_t *buffer, size_t bufferLength, iowa_coap_message_t **messageP, size_t *lengthP);
+// - lengthP: OUT. the COAP message's body length, from the Len field.
+uint8_t messageStreamParseHeader(iowa_context_t contextP, uint8_t *buffer, size_t bufferLength, iowa_coap_message_t **messageP, size_t *lengthP);
+// Extract the options and the payload of a received stream COAP message. The payload is not copied.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - buffer: the COAP message's body, following its token.
+// - bufferLength: the body length.
+// - messageP: the COAP message returned by messageStreamParseHeader().
+uint8_t messageStreamParseBody(iowa_context_t contextP, uint8_t *buffer, size_t bufferLength, iowa_coap_message_t *messageP);
 
 // implemented in iowa_block.c
 
-// Send a message by block.
+// Send a request by Block1 blocks. The result callback is called with the response to the last block.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
 // - contextP: IOWA context.
 // - peerP: pointer to the COAP peer.
-// - exchangeP: a strcut containing the request message infos and the result callback.
-// - maxPayloadSize: the maximum payload length that can be sent in a single block.
-uint8_t blockPush(iowa_context_t contextP, iowa_coap_peer_t *peerP, coap_exchange_t *exchangeP, size_t maxPayloadSize);
-// Handle received block messages.
-// Parameters:
-// - contextP: IOWA context.
-// - peerP: pointer to the COAP peer.
-// - exchangeP: a strcut containing the request message infos and the result callback.
-// - replyP: a COAP message.
-// - truncated: a bool to indicate if the response has been truncated or not.
-void blockHandleMessage(iowa_context_t contextP, iowa_coap_peer_t *peerP, coap_exchange_t *exchangeP, iowa_coap_message_t *replyP, bool truncated);
+// - messageP: the request. Its options and payload are copied.
+// - resultCallback: the callback to handle the response. This can be nil.
+// - userData: passed as parameter to resultCallback.
+uint8_t blockPush(iowa_context_t contextP, iowa_coap_peer_t *peerP, iowa_coap_message_t *messageP, coap_message_callback_t resultCallback, void *userData);
 // Send the code error 413, used in case of handling a too large payload.
+// The response indicates the preferred block size in a Block1 option.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
 // - contextP: IOWA context.
 // - peerP: pointer to the COAP peer.
-// - messageP: message to be sent with the request token.
-// - maxPayloadSize: the maximum payload length that can be sent in a single block.
-uint8_t blockSend413Reply(iowa_context_t contextP, iowa_coap_peer_t *peerP, iowa_coap_message_t *messageP, size_t maxPayloadSize);
-// Request a specific block.
-// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
-// Parameters:
-// - contextP: IOWA context.
-// - peerP: pointer to the COAP peer.
-// - messageP: a pointer to a COAP message.
-// - number: the number of the block to be requested.
-// - szx: the size of the block to be requested.
-// - resultCallback: the callback to handle the response.
-// - userData: user data.
-uint8_t blockRequestNumber(iowa_context_t contextP, iowa_coap_peer_t *peerP, iowa_coap_message_t *messageP, uint32_t number, uint8_t szx, coap_message_callback_t resultCallback, void *userData);
-// Resize the message payload.
+// - messageP: the request.
+uint8_t blockSend413Reply(iowa_context_t contextP, iowa_coap_peer_t *peerP, iowa_coap_message_t *messageP);
+
+// Implemented in iowa_coap_schc.c
+
+// Compress a CoAP message with the SCHC rules matching the direction of the peer.
+// Returned value: the length of the compressed buffer or 0 in case of error.
 // Parameters:
-// - messageP: a pointer to a COAP message.
-void blockResizePayload(iowa_coap_message_t *messageP);
-// Free the block.
+// - peerP: the LoRaWAN peer.
+// - messageP: the CoAP message to compress.
+// - bufferP: OUT. the compressed buffer, starting with the RuleID.
+size_t schcCompress(coap_peer_datagram_t *peerP, iowa_coap_message_t *messageP, uint8_t **bufferP);
+// Decompress a received SCHC packet.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
-// - a pointer to a block.
-void blockFree(block_transfer_t *blockP);
-iowa_status_t blockCreateOption(size_t maxPayloadSize, iowa_coap_option_t **optionPP);
+// - contextP: returned by iowa_init().
+// - peerP: the LoRaWAN peer the packet was received from.
+// - buffer, bufferLength: the received packet. It must remain valid until the message is freed.
+// - messageP: OUT. the decompressed CoAP message.
+uint8_t schcDecompress(iowa_context_t contextP, coap_peer_datagram_t *peerP, uint8_t *buffer, size_t bufferLength, iowa_coap_message_t **messageP);
 
 // Implemented in iowa_coap_lorawan.c
 uint8_t messageSendLoRaWAN(iowa_context_t contextP, iowa_coap_peer_t *peerBaseP, iowa_coap_message_t *messageP, coap_message_callback_t resultCallback, void *userData);
@@ -379,12 +619,92 @@ void lorawanSecurityEventCb(iowa_security_session_t securityS, iowa_security_eve
 // Implemented in iowa_coap_udp.c
 uint8_t messageSendUDP(iowa_context_t contextP, iowa_coap_peer_t *peerBaseP, iowa_coap_message_t *messageP, coap_message_callback_t resultCallback, void *userData);
 void udpSecurityEventCb(iowa_security_session_t securityS, iowa_security_event_t event, void *userData, iowa_context_t contextP);
+void udpSendQueueFlush(iowa_context_t contextP, coap_peer_datagram_t *peerP, iowa_time_t currentTime, int32_t *timeoutP);
+// Check if a reply to a received message is waiting in the outbound queue of a peer.
+// Returned value: true if an acknowledgement or a reset with this message ID is queued, false otherwise.
+// Parameters:
+// - peerP: the peer.
+// - mID: the message ID of the received message.
+bool udpSendQueueHasReply(coap_peer_datagram_t *peerP, uint16_t mID);
+void udpSendQueueClear(iowa_context_t contextP, coap_peer_datagram_t *peerP);
 
 // Implemented in iowa_coap_tcp.c
 uint8_t messageSendTCP(iowa_context_t contextP, iowa_coap_peer_t *peerBaseP, iowa_coap_message_t *messageP);
+// Send a buffer on the connection of a stream peer, looping on partial writes.
+// Returned value: IOWA_COAP_NO_ERROR if the whole buffer was sent or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - buffer, length: the bytes to send.
+uint8_t tcpSendBuffer(iowa_context_t contextP, coap_peer_stream_t *peerP, uint8_t *buffer, size_t length);
 uint8_t peerConnectTCP(iowa_context_t contextP, coap_peer_stream_t *peerP);
+void tcpPeerClear(iowa_context_t contextP, coap_peer_stream_t *peerP);
 void tcpSecurityEventCb(iowa_security_session_t securityS, iowa_security_event_t event, void *userData, iowa_context_t contextP);
 
+#ifdef IOWA_WEBSOCKET_SUPPORT
+// Implemented in iowa_coap_websocket.c
+
+// Prepare a new WebSocket peer opening its connection from an URI.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - peerP: the peer.
+// - uri: the URI of the peer, giving the Host header field of the opening handshake.
+uint8_t websocketPeerInit(coap_peer_stream_t *peerP, const char *uri);
+
+// Start the opening handshake once the connection is established.
+// The peer opening the connection sends its upgrade request, the other one waits for it.
+// The handshake nonce and the masking keys are drawn with iowa_system_random_vector_generator().
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+uint8_t websocketOpen(iowa_context_t contextP, coap_peer_stream_t *peerP);
+
+// Handle the received bytes of the opening handshake, and answer the upgrade request of the peer.
+// Returned value: IOWA_COAP_NO_ERROR if the handshake is complete and valid or incomplete, an error status otherwise.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - buffer, length: the received bytes.
+// - handshakeLengthP: OUT. the length of the handshake, 0 if it is incomplete.
+uint8_t websocketHandleHandshake(iowa_context_t contextP, coap_peer_stream_t *peerP, uint8_t *buffer, size_t length, size_t *handshakeLengthP);
+
+// Decode the header of a received frame.
+// Returned value: IOWA_COAP_NO_ERROR if the header is valid or incomplete, an error status otherwise.
+// Parameters:
+// - peerP: the peer the frame is received from.
+// - buffer, length: the received bytes.
+// - frameP: OUT. the decoded header.
+// - headerLengthP: OUT. the length of the header, 0 if it is incomplete.
+uint8_t websocketParseFrameHeader(coap_peer_stream_t *peerP, uint8_t *buffer, size_t length, coap_ws_frame_t *frameP, size_t *headerLengthP);
+
+// Unmask in place the start of the payload of a received frame.
+// Parameters:
+// - frameP: the frame header.
+// - payload, length: the first bytes of the payload.
+void websocketUnmask(coap_ws_frame_t *frameP, uint8_t *payload, size_t length);
+
+// Write the header of a frame in the bytes preceding its payload.
+// The frames sent by the peer which opened the connection are masked in place.
+// Returned value: the length of the header, at most COAP_WS_FRAME_MAX_HEADER_LENGTH, or 0 if no masking key can be drawn.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer the frame is sent to.
+// - opcode: the opcode of the frame.
+// - payload, length: the start of the payload. It is the whole payload if the frame is masked.
+// - frameLength: the length of the payload.
+size_t websocketFrame(iowa_context_t contextP, coap_peer_stream_t *peerP, uint8_t opcode, uint8_t *payload, size_t length, size_t frameLength);
+
+// Send a control frame.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - opcode: the opcode of the frame.
+// - payload, length: the payload of the frame, at most 125 bytes. payload can be nil if length is 0.
+uint8_t websocketSendControl(iowa_context_t contextP, coap_peer_stream_t *peerP, uint8_t opcode, const uint8_t *payload, size_t length);
+#endif
+
 // Implemented in iowa_coap_sms.c
 uint8_t messageSendSMS(iowa_context_t contextP, iowa_coap_peer_t *peerBaseP, iowa_coap_message_t *messageP, coap_message_callback_t resultCallback, void *userData);
 void smsSecurityEventCb(iowa_security_session_t securityS, iowa_security_event_t event, void *userData, iowa_context_t contextP);
@@ -21,9 +21,144 @@
 
 #include "iowa_prv_coap_internals.h"
 
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+
 #if defined(IOWA_UDP_SUPPORT) || defined(IOWA_SMS_SUPPORT)
-static void prv_acknowledgeCleanup(coap_peer_datagram_t *peerP)
+// Allocate the ring and the index of the reply cache of a peer.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - cacheP: the reply cache. Its capacity must not be zero.
+static uint8_t prv_acknowledgeCacheInit(coap_ack_cache_t *cacheP)
+{
+    // WARNING: This function is called in a critical section
+    size_t size;
+
+    cacheP->bucketCount = 1;
+    while (cacheP->bucketCount < cacheP->capacity)
+    {
+        cacheP->bucketCount <<= 1;
+    }
+
+    size = cacheP->capacity * sizeof(coap_ack_t) + cacheP->bucketCount * sizeof(coap_ack_t *);
+    cacheP->ring = (coap_ack_t *)iowa_system_malloc(size);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (cacheP->ring == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(size);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(cacheP->ring, 0, size);
+    cacheP->bucketArray = (coap_ack_t **)(cacheP->ring + cacheP->capacity);
+    cacheP->head = 0;
+    cacheP->count = 0;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Remove the oldest entry of the reply cache of a peer.
+// Returned value: none.
+// Parameters:
+// - cacheP: the reply cache. It must not be empty.
+static void prv_acknowledgeRemoveOldest(coap_ack_cache_t *cacheP)
+{
+    // WARNING: This function is called in a critical section
+    coap_ack_t *ackP;
+    coap_ack_t **bucketP;
+
+    ackP = cacheP->ring + cacheP->head;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Removing cached reply for message %u.", ackP->mID);
+
+    bucketP = cacheP->bucketArray + (ackP->mID & (cacheP->bucketCount - 1));
+    while (*bucketP != ackP)
+    {
+        bucketP = &((*bucketP)->next);
+    }
+    *bucketP = ackP->next;
+
+    cacheP->memorySize -= ackP->buffer_len;
+    iowa_system_free(ackP->buffer);
+    ackP->buffer = NULL;
+
+    cacheP->head = (uint16_t)((cacheP->head + 1) % cacheP->capacity);
+    cacheP->count--;
+}
+
+// Store a reply in the cache of a peer, evicting the oldest entries if the cache is full.
+// Returned value: IOWA_COAP_201_CREATED if the cache took ownership of the buffer, IOWA_COAP_NO_ERROR if the reply
+// is not cached, or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - mID: the message ID of the reply.
+// - buffer, bufferLength: the serialized reply.
+// - validityTime: the time until which the reply is kept.
+static uint8_t prv_acknowledgeAdd(iowa_context_t contextP,
+                                  coap_peer_datagram_t *peerP,
+                                  uint16_t mID,
+                                  uint8_t *buffer,
+                                  size_t bufferLength,
+                                  iowa_time_t validityTime)
 {
+    // WARNING: This function is called in a critical section
+    coap_ack_cache_t *cacheP;
+    coap_ack_t *ackP;
+    coap_ack_t **bucketP;
+
+    cacheP = &(peerP->ackCache);
+
+    if (cacheP->capacity == 0)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+#ifdef IOWA_COAP_ACK_MEMORY_LIMIT
+    if (bufferLength > IOWA_COAP_ACK_MEMORY_LIMIT)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Reply to message %u is too large to be cached (%u bytes).", mID, bufferLength);
+        return IOWA_COAP_NO_ERROR;
+    }
+#endif
+
+    if (cacheP->ring == NULL)
+    {
+        uint8_t result;
+
+        result = prv_acknowledgeCacheInit(cacheP);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            return result;
+        }
+    }
+
+    if (cacheP->count == cacheP->capacity)
+    {
+        prv_acknowledgeRemoveOldest(cacheP);
+    }
+#ifdef IOWA_COAP_ACK_MEMORY_LIMIT
+    while (cacheP->memorySize + bufferLength > IOWA_COAP_ACK_MEMORY_LIMIT)
+    {
+        prv_acknowledgeRemoveOldest(cacheP);
+    }
+#endif
+
+    ackP = cacheP->ring + ((cacheP->head + cacheP->count) % cacheP->capacity);
+    ackP->mID = mID;
+    ackP->validity_time = validityTime;
+    ackP->buffer_len = bufferLength;
+    ackP->buffer = buffer;
+
+    // Insert at the front of the bucket so that the latest reply to a message ID is found first
+    bucketP = cacheP->bucketArray + (mID & (cacheP->bucketCount - 1));
+    ackP->next = *bucketP;
+    *bucketP = ackP;
+
+    cacheP->count++;
+    cacheP->memorySize += bufferLength;
+
+    coapPeerSchedule(contextP, peerP, validityTime);
+
+    return IOWA_COAP_201_CREATED;
 }
 #endif // IOWA_UDP_SUPPORT || IOWA_SMS_SUPPORT
 
@@ -34,15 +169,18 @@ static coap_ack_t *prv_acknowledgeFind(coap_peer_datagram_t *peerP,
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "peerP: %p, message ID: %u.", peerP, messageP->id);
 
-    ackP = peerP->ackList;
-    while (ackP != NULL)
+    if (peerP->ackCache.count != 0)
     {
-        if (ackP->mID == messageP->id)
+        ackP = peerP->ackCache.bucketArray[messageP->id & (peerP->ackCache.bucketCount - 1)];
+        while (ackP != NULL)
         {
-            IOWA_LOG_TRACE(IOWA_PART_COAP, "Found acknowledge.");
-            return ackP;
+            if (ackP->mID == messageP->id)
+            {
+                IOWA_LOG_TRACE(IOWA_PART_COAP, "Found acknowledge.");
+                return ackP;
+            }
+            ackP = ackP->next;
         }
-        ackP = ackP->next;
     }
 
     IOWA_LOG_TRACE(IOWA_PART_COAP, "Acknowledge not found.");
@@ -63,7 +201,8 @@ static coap_transaction_t *prv_transactionFind(coap_peer_datagram_t *peerP,
 
         while (transacP != NULL)
         {
-            if (transacP->mID == messageP->id)
+            if (transacP->mID == messageP->id
+                && transacP->queued == false)
             {
                 IOWA_LOG_TRACE(IOWA_PART_COAP, "Transaction found.");
                 return transacP;
@@ -76,39 +215,345 @@ static coap_transaction_t *prv_transactionFind(coap_peer_datagram_t *peerP,
     return NULL;
 }
 
+// Draw a pseudo-random number to spread the retransmissions of the peers.
+// Returned value: the number.
+// Parameters:
+// - peerP: the peer.
+// - currentTime: the current time, used to seed the generator.
+static uint32_t prv_random(coap_peer_datagram_t *peerP,
+                           iowa_time_t currentTime)
+{
+    uint32_t state;
+
+    state = peerP->randomState;
+    if (state == 0)
+    {
+        state = (uint32_t)(uintptr_t)peerP ^ ((uint32_t)peerP->nextMID << 16) ^ (uint32_t)currentTime;
+        if (state == 0)
+        {
+            state = 1;
+        }
+    }
+
+    // xorshift32
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    peerP->randomState = state;
+
+    return state;
+}
+
+// Compute the first retransmission timeout of a transaction.
+// Returned value: the timeout in internal time unit.
+// Parameters:
+// - peerP: the peer.
+// - currentTime: the current time.
+static int32_t prv_initialTimeout(coap_peer_datagram_t *peerP,
+                                  iowa_time_t currentTime)
+{
+#ifdef IOWA_TIME_MS_SUPPORT
+    // Age the estimated RTO when not updated for a long time
+    if (peerP->rto < CORE_TIME_FROM_SECONDS(1)
+        && currentTime - peerP->rtoTime > 16 * (iowa_time_t)peerP->rto)
+    {
+        peerP->rto = 2 * peerP->rto;
+        peerP->rtoTime = currentTime;
+    }
+    else if (peerP->rto > CORE_TIME_FROM_SECONDS(3)
+             && currentTime - peerP->rtoTime > 4 * (iowa_time_t)peerP->rto)
+    {
+        peerP->rto = (peerP->rto + peerP->ackTimeout) / 2;
+        peerP->rtoTime = currentTime;
+    }
+#endif
+
+    // Random timeout between RTO and RTO * COAP_ACK_RANDOM_FACTOR
+    return peerP->rto + (int32_t)(prv_random(peerP, currentTime) % ((uint32_t)peerP->rto / 2 + 1));
+}
+
+// Compute the next retransmission timeout of a transaction.
+// Returned value: the timeout in internal time unit.
+// Parameters:
+// - peerP: the peer.
+// - timeout: the previous timeout of the transaction.
+static int32_t prv_backoffTimeout(coap_peer_datagram_t *peerP,
+                                  int32_t timeout)
+{
+#ifdef IOWA_TIME_MS_SUPPORT
+    // Variable backoff factor
+    if (peerP->rto < CORE_TIME_FROM_SECONDS(1))
+    {
+        return 3 * timeout;
+    }
+    if (peerP->rto > CORE_TIME_FROM_SECONDS(3))
+    {
+        return timeout + timeout / 2;
+    }
+#else
+    (void)peerP;
+#endif
+
+    return 2 * timeout;
+}
+
+#ifdef IOWA_TIME_MS_SUPPORT
+// Update a round-trip time estimator with a new measure.
+// Returned value: the RTO estimated from this estimator.
+// Parameters:
+// - estimatorP: the estimator.
+// - rtt: the measured round-trip time.
+// - k: the weight of the RTT variation.
+static int32_t prv_rttEstimate(coap_rtt_estimator_t *estimatorP,
+                               int32_t rtt,
+                               int32_t k)
+{
+    if (estimatorP->srtt == 0)
+    {
+        estimatorP->srtt = rtt;
+        estimatorP->rttvar = rtt / 2;
+    }
+    else
+    {
+        int32_t delta;
+
+        delta = estimatorP->srtt - rtt;
+        if (delta < 0)
+        {
+            delta = -delta;
+        }
+        estimatorP->rttvar = (3 * estimatorP->rttvar + delta) / 4;
+        estimatorP->srtt = (7 * estimatorP->srtt + rtt) / 8;
+    }
+
+    return estimatorP->srtt + k * estimatorP->rttvar;
+}
+#endif
+
+// Update the RTO of the peer from an acknowledged transaction.
+// Parameters:
+// - peerP: the peer.
+// - transacP: the acknowledged transaction.
+static void prv_updateRto(coap_peer_datagram_t *peerP,
+                          coap_transaction_t *transacP)
+{
+#ifdef IOWA_TIME_MS_SUPPORT
+    iowa_time_t curTime;
+    int32_t rtt;
+
+#ifdef IOWA_LORAWAN_SUPPORT
+    if (peerP->base.type == IOWA_CONN_LORAWAN)
+    {
+        // The acknowledgement delay depends on the class A receive windows, not on the round-trip time
+        return;
+    }
+#endif
+
+    if (transacP->retrans_counter > COAP_COCOA_WEAK_MAX_RETRANSMIT)
+    {
+        return;
+    }
+
+    curTime = coreTimeGet();
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (curTime < 0)
+    {
+        IOWA_LOG_ERROR_GETTIME(curTime);
+        return;
+    }
+#endif
+
+    rtt = coreTimeToDelay(curTime - transacP->first_time);
+
+    if (transacP->retrans_counter == 0)
+    {
+        peerP->rto = (prv_rttEstimate(&(peerP->strongRtt), rtt, COAP_COCOA_STRONG_K) + peerP->rto) / 2;
+    }
+    else
+    {
+        peerP->rto = (prv_rttEstimate(&(peerP->weakRtt), rtt, COAP_COCOA_WEAK_K) + 3 * peerP->rto) / 4;
+    }
+
+    if (peerP->rto < COAP_COCOA_RTO_MIN)
+    {
+        peerP->rto = COAP_COCOA_RTO_MIN;
+    }
+    else if (peerP->rto > COAP_COCOA_RTO_MAX)
+    {
+        peerP->rto = COAP_COCOA_RTO_MAX;
+    }
+    peerP->rtoTime = curTime;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Transaction %u RTT: %d, new RTO: %d.", transacP->mID, rtt, peerP->rto);
+#else
+    (void)peerP;
+    (void)transacP;
+#endif
+}
+
+// Arm the retransmission of a transaction sent for the first time.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - transacP: the transaction.
+// - currentTime: the current time.
+static void prv_transactionStart(iowa_context_t contextP,
+                                 coap_peer_datagram_t *peerP,
+                                 coap_transaction_t *transacP,
+                                 iowa_time_t currentTime)
+{
+    // WARNING: This function is called in a critical section
+    transacP->queued = false;
+    transacP->first_time = currentTime;
+    transacP->timeout = prv_initialTimeout(peerP, currentTime);
+    transacP->retrans_time = currentTime + transacP->timeout;
+
+    coapPeerSchedule(contextP, peerP, transacP->retrans_time);
+}
+
+// Send the oldest queued transactions while less than NSTART transactions are outstanding.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - currentTime: the current time.
+// - timeoutP: IN/OUT. the time before the next retransmission. This can be nil.
+static void prv_transactionStartQueued(iowa_context_t contextP,
+                                       coap_peer_datagram_t *peerP,
+                                       iowa_time_t currentTime,
+                                       int32_t *timeoutP)
+{
+    // WARNING: This function is called in a critical section
+    while (transactionCanStart(peerP) == true)
+    {
+        coap_transaction_t *transacP;
+        coap_transaction_t *oldestP;
+
+        // Transactions are added at the head of the list
+        oldestP = NULL;
+        for (transacP = peerP->transactionList; transacP != NULL; transacP = transacP->next)
+        {
+            if (transacP->queued == true)
+            {
+                oldestP = transacP;
+            }
+        }
+        if (oldestP == NULL)
+        {
+            break;
+        }
+
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Sending queued transaction %u.", oldestP->mID);
+
+        prv_transactionStart(contextP, peerP, oldestP, currentTime);
+        (void)peerSendBuffer(contextP, (iowa_coap_peer_t *)peerP, oldestP->buffer, oldestP->buffer_len);
+
+        if (timeoutP != NULL
+            && *timeoutP > oldestP->timeout)
+        {
+            *timeoutP = oldestP->timeout;
+        }
+    }
+}
+
+// Handle the completion of a transaction removed from the peer by an acknowledgement or a reset.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - transacP: the completed transaction.
+static void prv_transactionComplete(iowa_context_t contextP,
+                                    coap_peer_datagram_t *peerP,
+                                    coap_transaction_t *transacP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_time_t curTime;
+
+    prv_updateRto(peerP, transacP);
+
+    curTime = coreTimeGet();
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (curTime < 0)
+    {
+        IOWA_LOG_ERROR_GETTIME(curTime);
+        curTime = contextP->currentTime;
+    }
+#endif
+
+    prv_transactionStartQueued(contextP, peerP, curTime, NULL);
+}
+
 void transactionFree(coap_transaction_t *transacP)
 {
     IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Freeing transaction %p.", transacP);
 
     iowa_system_free(transacP->buffer);
-    iowa_system_free(transacP);
+    CORE_POOL_FREE(transacP);
 }
 
-void acknowledgeFree(coap_ack_t *ackP)
+void acknowledgeCacheClear(coap_peer_datagram_t *peerP)
 {
-    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Freeing acknowledge for message ID %u.", ackP->mID);
+    // WARNING: This function is called in a critical section
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Clearing the reply cache of peer %p.", peerP);
 
-    iowa_system_free(ackP->buffer);
-    iowa_system_free(ackP);
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+    while (peerP->ackCache.count != 0)
+    {
+        prv_acknowledgeRemoveOldest(&(peerP->ackCache));
+    }
+#endif
+    iowa_system_free(peerP->ackCache.ring);
+    peerP->ackCache.ring = NULL;
+    peerP->ackCache.bucketArray = NULL;
+    peerP->ackCache.head = 0;
+}
+
+bool transactionCanStart(coap_peer_datagram_t *peerP)
+{
+    coap_transaction_t *transacP;
+    uint8_t count;
+
+    count = 0;
+    for (transacP = peerP->transactionList; transacP != NULL; transacP = transacP->next)
+    {
+        if (transacP->queued == false)
+        {
+            count++;
+            if (count >= COAP_DEFAULT_NSTART)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void transactionResetRto(coap_peer_datagram_t *peerP)
+{
+    peerP->rto = peerP->ackTimeout;
+    peerP->rtoTime = 0;
+    memset(&(peerP->strongRtt), 0, sizeof(coap_rtt_estimator_t));
+    memset(&(peerP->weakRtt), 0, sizeof(coap_rtt_estimator_t));
 }
 
 uint8_t transactionNew(iowa_context_t contextP,
                        coap_peer_datagram_t *peerP,
-                       iowa_coap_message_t *messageP,
+                       uint8_t type,
+                       uint16_t mID,
                        uint8_t *buffer,
                        size_t bufferLength,
+                       bool queued,
                        coap_message_callback_t resultCallback,
                        void *userData)
 {
     // WARNING: This function is called in a critical section
-    switch (messageP->type)
+    switch (type)
     {
     case IOWA_COAP_TYPE_CONFIRMABLE:
     {
         coap_transaction_t *transacP;
-        int32_t curTime;
+        iowa_time_t curTime;
 
-        curTime = iowa_system_gettime();
+        curTime = coreTimeGet();
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (curTime < 0)
         {
@@ -117,7 +562,7 @@ uint8_t transactionNew(iowa_context_t contextP,
         }
 #endif
 
-        transacP = (coap_transaction_t *)iowa_system_malloc(sizeof(coap_transaction_t));
+        transacP = (coap_transaction_t *)CORE_POOL_ALLOC(contextP, CORE_POOL_TRANSACTION, sizeof(coap_transaction_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (transacP == NULL)
         {
@@ -127,9 +572,8 @@ uint8_t transactionNew(iowa_context_t contextP,
 #endif
         memset(transacP, 0, sizeof(coap_transaction_t));
 
-        transacP->mID = messageP->id;
+        transacP->mID = mID;
         transacP->retrans_counter = 0;
-        transacP->retrans_time = curTime + peerP->ackTimeout;
         transacP->buffer_len = bufferLength;
         transacP->buffer = buffer;
         transacP->callback = resultCallback;
@@ -137,10 +581,19 @@ uint8_t transactionNew(iowa_context_t contextP,
 
         peerP->transactionList = (coap_transaction_t *)IOWA_UTILS_LIST_ADD(peerP->transactionList, transacP);
 
-        if (peerP->ackTimeout > 0
-            && contextP->timeout > peerP->ackTimeout)
+        if (queued == true)
         {
-            contextP->timeout = peerP->ackTimeout;
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "NSTART reached, queuing transaction %u.", transacP->mID);
+            transacP->queued = true;
+            return IOWA_COAP_201_CREATED;
+        }
+
+        prv_transactionStart(contextP, peerP, transacP, curTime);
+
+        if (transacP->timeout > 0
+            && contextP->timeout > transacP->timeout)
+        {
+            contextP->timeout = transacP->timeout;
             CRIT_SECTION_LEAVE(contextP);
             INTERRUPT_SELECT(contextP);
             CRIT_SECTION_ENTER(contextP);
@@ -154,10 +607,9 @@ uint8_t transactionNew(iowa_context_t contextP,
     case IOWA_COAP_TYPE_RESET:
         if (peerP->ackTimeout != 0)
         {
-            coap_ack_t *ackP;
-            int32_t curTime;
+            iowa_time_t curTime;
 
-            curTime = iowa_system_gettime();
+            curTime = coreTimeGet();
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (curTime < 0)
             {
@@ -165,26 +617,7 @@ uint8_t transactionNew(iowa_context_t contextP,
                 break;
             }
 #endif
-            ackP = (coap_ack_t *)iowa_system_malloc(sizeof(coap_ack_t));
-#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-            if (ackP == NULL)
-            {
-                IOWA_LOG_ERROR_MALLOC(sizeof(coap_ack_t));
-                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
-            }
-#endif
-            memset(ackP, 0, sizeof(coap_ack_t));
-
-            ackP->buffer_len = bufferLength;
-            ackP->buffer = buffer;
-            ackP->mID = messageP->id;
-            ackP->validity_time = curTime + peerP->transmitWait;
-
-            peerP->ackList = (coap_ack_t *)IOWA_UTILS_LIST_ADD(peerP->ackList, ackP);
-
-            prv_acknowledgeCleanup(peerP);
-
-            return IOWA_COAP_201_CREATED;
+            return prv_acknowledgeAdd(contextP, peerP, mID, buffer, bufferLength, curTime + peerP->transmitWait);
         }
     break;
 #endif // IOWA_UDP_SUPPORT || IOWA_SMS_SUPPORT
@@ -198,51 +631,29 @@ uint8_t transactionNew(iowa_context_t contextP,
 
 uint8_t transactionStep(iowa_context_t contextP,
                         coap_peer_datagram_t *peerP,
-                        int32_t currentTime,
+                        iowa_time_t currentTime,
                         int32_t *timeoutP)
 {
     // WARNING: This function is called in a critical section
 
-    coap_ack_t *ackP;
-    coap_ack_t *parentAckP;
     coap_transaction_t *transacP;
 
-    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Entering peer %p, currentTime: %u, timeoutP: %u", peerP, currentTime, *timeoutP);
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Entering peer %p, currentTime: %lld, timeoutP: %d", peerP, (long long)currentTime, *timeoutP);
 
-    ackP = peerP->ackList;
-    parentAckP = NULL;
-    while (ackP != NULL)
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+    // The entries are ordered by validity time
+    while (peerP->ackCache.count != 0
+           && peerP->ackCache.ring[peerP->ackCache.head].validity_time <= currentTime)
     {
-        coap_ack_t *nextP;
-
-        nextP = ackP->next;
-
-        IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Ack ID %u: validity time: %u, buffer size: %u.",
-                           ackP->mID, ackP->validity_time, ackP->buffer_len);
-
-        if (ackP->validity_time <= currentTime)
-        {
-            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Removing cached reply for message %u.", ackP->mID);
-            if (parentAckP == NULL)
-            {
-                peerP->ackList = ackP->next;
-            }
-            else
-            {
-                parentAckP->next = ackP->next;
-            }
-
-            acknowledgeFree(ackP);
-            ackP = NULL;
-        }
-        else
-        {
-            parentAckP = ackP;
-        }
-        ackP = nextP;
+        prv_acknowledgeRemoveOldest(&(peerP->ackCache));
     }
+    if (peerP->ackCache.count != 0
+        && *timeoutP > peerP->ackCache.ring[peerP->ackCache.head].validity_time - currentTime)
+    {
+        *timeoutP = coreTimeToDelay(peerP->ackCache.ring[peerP->ackCache.head].validity_time - currentTime);
+    }
+#endif
 
-    // TODO: handle NSTART
     transacP = peerP->transactionList;
     while (transacP != NULL)
     {
@@ -250,32 +661,35 @@ uint8_t transactionStep(iowa_context_t contextP,
 
         nextP = transacP->next;
 
-        IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Transaction %u: retrans counter %u, retrans time %u.", transacP->mID, transacP->retrans_counter, transacP->retrans_time);
+        IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Transaction %u: retrans counter %u, retrans time %lld.", transacP->mID, transacP->retrans_counter, (long long)transacP->retrans_time);
 
-        if (transacP->retrans_time <= currentTime)
+        if (transacP->queued == true)
+        {
+            // Sent when an outstanding transaction completes
+        }
+        else if (transacP->retrans_time <= currentTime)
         {
             if (transacP->retrans_counter < peerP->maxRetransmit)
             {
-                int32_t timeout;
-
                 IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Resending transaction %u.", transacP->mID);
 
                 (void)peerSendBuffer(contextP, (iowa_coap_peer_t *)peerP, transacP->buffer, transacP->buffer_len);
 
                 transacP->retrans_counter++;
 
-                timeout = peerP->ackTimeout << transacP->retrans_counter;
+                transacP->timeout = prv_backoffTimeout(peerP, transacP->timeout);
 
-                transacP->retrans_time = currentTime + timeout;
-                if (*timeoutP > timeout)
+                transacP->retrans_time = currentTime + transacP->timeout;
+                if (*timeoutP > transacP->timeout)
                 {
-                    *timeoutP = timeout;
+                    *timeoutP = transacP->timeout;
                 }
             }
             else
             {
                 // Remove the transaction from the peer before to call the callback. Because the callback can delete the peer
                 peerP->transactionList = (coap_transaction_t *)IOWA_UTILS_LIST_REMOVE(peerP->transactionList, transacP);
+                prv_transactionStartQueued(contextP, peerP, currentTime, timeoutP);
                 if (transacP->callback != NULL)
                 {
                     transacP->callback((iowa_coap_peer_t *)peerP, IOWA_COAP_503_SERVICE_UNAVAILABLE, NULL, transacP->userData, contextP);
@@ -287,7 +701,7 @@ uint8_t transactionStep(iowa_context_t contextP,
         {
             if (*timeoutP > (transacP->retrans_time - currentTime))
             {
-                *timeoutP = transacP->retrans_time - currentTime;
+                *timeoutP = coreTimeToDelay(transacP->retrans_time - currentTime);
             }
         }
 
@@ -325,6 +739,13 @@ void transactionHandleMessage(iowa_context_t contextP,
             }
             // else the peer already started more transmissions than the NSTART so we ignore this lost message.
         }
+#ifdef IOWA_UDP_SUPPORT
+        else if (udpSendQueueHasReply(peerP, messageP->id) == true)
+        {
+            // The reply is sent, then cached, when the peer is connected again
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Reply to message %u is queued. Ignoring the retransmission.", messageP->id);
+        }
+#endif
         else
         {
             if (!COAP_IS_REQUEST(messageP->code))
@@ -347,6 +768,7 @@ void transactionHandleMessage(iowa_context_t contextP,
         {
             // Remove the transaction from the peer before to call the callback. Because the callback can delete the peer
             peerP->transactionList = (coap_transaction_t *)IOWA_UTILS_LIST_REMOVE(peerP->transactionList, transacP);
+            prv_transactionComplete(contextP, peerP, transacP);
             if (transacP->callback != NULL)
             {
                 uint8_t code;
@@ -372,6 +794,7 @@ void transactionHandleMessage(iowa_context_t contextP,
         {
             // Remove the transaction from the peer before to call the callback. Because the callback can delete the peer
             peerP->transactionList = (coap_transaction_t *)IOWA_UTILS_LIST_REMOVE(peerP->transactionList, transacP);
+            prv_transactionComplete(contextP, peerP, transacP);
             if (transacP->callback != NULL)
             {
                 transacP->callback((iowa_coap_peer_t *)peerP, messageP->code, messageP, transacP->userData, contextP);
@@ -388,3 +811,5 @@ void transactionHandleMessage(iowa_context_t contextP,
         break;
     }
 }
+
+#endif // defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
@@ -35,6 +35,9 @@ static comm_channel_t * prv_channelNew(iowa_context_t contextP,
     // WARNING: This function is called in a critical section
     comm_channel_t *channelP;
     comm_channel_t **newChannelArray;
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+    int result;
+#endif
 
     newChannelArray = (comm_channel_t **)iowa_system_malloc(sizeof(comm_channel_t *) * (contextP->commContextP->channelCount + 1));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
@@ -68,9 +71,70 @@ static comm_channel_t * prv_channelNew(iowa_context_t contextP,
     contextP->commContextP->channelArray = newChannelArray;
     contextP->commContextP->channelCount += 1;
 
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+    CRIT_SECTION_LEAVE(contextP);
+    result = iowa_system_connection_register(connP, channelP, contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+    if (result != 0)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_SYSTEM, "iowa_system_connection_register() returned %d.", result);
+
+        // The connection is not registered and is closed by the caller
+        channelP->connP = NULL;
+        commChannelDelete(contextP, channelP);
+        return NULL;
+    }
+#endif
+
     return channelP;
 }
 
+// Retrieve the current time after the connections monitoring.
+// Returned value: '0' in case of success or an error code in the form of a CoAP code.
+// Parameters:
+// - contextP: as returned by iowa_init().
+static uint8_t prv_updateTime(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_time_t currentTime;
+
+    // Retrieve the current time before calling the callbacks
+    CRIT_SECTION_LEAVE(contextP);
+    currentTime = coreTimeGet();
+    CRIT_SECTION_ENTER(contextP);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (currentTime < 0
+        || currentTime < contextP->currentTime)
+    {
+        IOWA_LOG_ERROR_GETTIME(currentTime);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    contextP->currentTime = currentTime;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+// Free the deleted channels.
+// Returned value: none.
+// Parameters:
+// - commContextP: the Comm context.
+static void prv_freeDeletedChannels(comm_context_t commContextP)
+{
+    // WARNING: This function is called in a critical section
+    while (commContextP->deletedList != NULL)
+    {
+        comm_channel_t *channelP;
+
+        channelP = commContextP->deletedList;
+        commContextP->deletedList = channelP->nextDeleted;
+        iowa_system_free(channelP);
+    }
+}
+#endif
+
 /*************************************************************************************
 ** Public functions
 *************************************************************************************/
@@ -110,12 +174,18 @@ void commClose(iowa_context_t contextP)
     for (i = 0; i < commContextP->channelCount; i++)
     {
         CRIT_SECTION_LEAVE(contextP);
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+        iowa_system_connection_unregister(commContextP->channelArray[i]->connP, contextP->userData);
+#endif
         iowa_system_connection_close(commContextP->channelArray[i]->connP, contextP->userData);
         CRIT_SECTION_ENTER(contextP);
 
         iowa_system_free(commContextP->channelArray[i]);
     }
 
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+    prv_freeDeletedChannels(commContextP);
+#endif
     iowa_system_free(commContextP->channelArray);
     iowa_system_free(commContextP);
 
@@ -154,6 +224,11 @@ uint8_t commChannelNew(iowa_context_t contextP,
         break;
 #endif
 
+#ifdef IOWA_LORAWAN_SUPPORT
+    case IOWA_CONN_LORAWAN:
+        break;
+#endif
+
     default:
         IOWA_LOG_ARG_ERROR(IOWA_PART_COMM, "Unsupported connection type (%d). Make sure IOWA is compiled with the right transport support.", type);
         return IOWA_COAP_501_NOT_IMPLEMENTED;
@@ -289,14 +364,29 @@ void commChannelDelete(iowa_context_t contextP,
 
     contextP->commContextP->channelCount -= 1;
 
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+    // Prevent the pending events of this channel to be dispatched
+    channelP->deleted = true;
+#endif
+
     if (channelP->connP != NULL)
     {
         CRIT_SECTION_LEAVE(contextP);
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+        iowa_system_connection_unregister(channelP->connP, contextP->userData);
+#endif
         iowa_system_connection_close(channelP->connP, contextP->userData);
         CRIT_SECTION_ENTER(contextP);
     }
 
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+    // Once unregistered, the channel can only be in the results of the current wait.
+    // It is freed after these results are dispatched.
+    channelP->nextDeleted = contextP->commContextP->deletedList;
+    contextP->commContextP->deletedList = channelP;
+#else
     iowa_system_free(channelP);
+#endif
 
     IOWA_LOG_TRACE(IOWA_PART_COMM, "Exiting.");
 }
@@ -343,6 +433,36 @@ int commSend(iowa_context_t contextP,
     return result;
 }
 
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+int commSendv(iowa_context_t contextP,
+              comm_channel_t *channelP,
+              iowa_connection_segment_t *segmentArray,
+              size_t segmentCount)
+{
+    // WARNING: This function is called in a critical section
+    int result;
+#if (IOWA_LOG_LEVEL >= IOWA_LOG_LEVEL_INFO)
+    size_t i;
+#endif
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "On channelP: %p, %u segments.", channelP, segmentCount);
+#if (IOWA_LOG_LEVEL >= IOWA_LOG_LEVEL_INFO)
+    for (i = 0; i < segmentCount; i++)
+    {
+        IOWA_LOG_BUFFER_INFO(IOWA_PART_COMM, "Sending", segmentArray[i].data, segmentArray[i].length);
+    }
+#endif
+
+    CRIT_SECTION_LEAVE(contextP);
+    result = iowa_system_connection_sendv(channelP->connP, segmentArray, segmentCount, contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COMM, "Exiting with result %d.", result);
+
+    return result;
+}
+#endif
+
 int commRecv(iowa_context_t contextP,
              comm_channel_t *channelP,
              uint8_t *buffer,
@@ -369,6 +489,108 @@ int commRecv(iowa_context_t contextP,
     return result;
 }
 
+#ifdef IOWA_CONNECTION_RECVV_SUPPORT
+int commRecvv(iowa_context_t contextP,
+              comm_channel_t *channelP,
+              iowa_connection_segment_t *segmentArray,
+              size_t segmentCount)
+{
+    // WARNING: This function is called in a critical section
+    int result;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Receiving up to %u datagrams on channelP: %p.", segmentCount, channelP);
+
+    CRIT_SECTION_LEAVE(contextP);
+    result = iowa_system_connection_recvv(channelP->connP, segmentArray, segmentCount, contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "iowa_system_connection_recvv() returned %d.", result);
+
+#if (IOWA_LOG_LEVEL >= IOWA_LOG_LEVEL_INFO)
+    {
+        int i;
+
+        for (i = 0; i < result; i++)
+        {
+            IOWA_LOG_BUFFER_INFO(IOWA_PART_COMM, "Received", segmentArray[i].data, segmentArray[i].length);
+        }
+    }
+#endif
+
+    return result;
+}
+#endif
+
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+uint8_t commSelect(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    int result;
+    int32_t currentTimeout;
+    size_t readyIndex;
+    void *waitArray[IOWA_CONNECTION_WAIT_MAX_EVENTS];
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COMM, "Channel count: %u.", contextP->commContextP->channelCount);
+
+    currentTimeout = contextP->timeout; // Store the timeout before to leave the critical section to prevent a possible data race condition
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Calling iowa_system_connection_wait() with a timeout of %d.", currentTimeout);
+
+    // The wait fills a local array as the channels may be deleted by another thread outside of the critical section
+    CRIT_SECTION_LEAVE(contextP);
+    result = iowa_system_connection_wait(waitArray, IOWA_CONNECTION_WAIT_MAX_EVENTS, currentTimeout, contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "iowa_system_connection_wait() returned %d.", result);
+
+    if (result < 0)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_SYSTEM, "iowa_system_connection_wait() returned %d. Exiting with error 5.03 (SERVICE UNAVAILABLE).", result);
+        prv_freeDeletedChannels(contextP->commContextP);
+
+        return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+    }
+
+    if (result > 0)
+    {
+        if (prv_updateTime(contextP) != IOWA_COAP_NO_ERROR)
+        {
+            prv_freeDeletedChannels(contextP->commContextP);
+
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+
+        if ((size_t)result > IOWA_CONNECTION_WAIT_MAX_EVENTS)
+        {
+            result = IOWA_CONNECTION_WAIT_MAX_EVENTS;
+        }
+
+        // The channels deleted during the wait or by the event callbacks are flagged and not freed yet
+        for (readyIndex = 0; readyIndex < (size_t)result; readyIndex++)
+        {
+            comm_channel_t *channelP;
+
+            channelP = (comm_channel_t *)waitArray[readyIndex];
+            if (channelP->deleted == false)
+            {
+                IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Channel %p has data.", channelP);
+
+                channelP->eventCallback(channelP, COMM_EVENT_DATA_AVAILABLE, channelP->userData, contextP);
+            }
+            else
+            {
+                IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Channel %p was deleted.", channelP);
+            }
+        }
+    }
+
+    prv_freeDeletedChannels(contextP->commContextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#else
+
 uint8_t commSelect(iowa_context_t contextP)
 {
     // WARNING: This function is called in a critical section
@@ -405,7 +627,7 @@ uint8_t commSelect(iowa_context_t contextP)
 
     currentTimeout = contextP->timeout; // Store the timeout before to leave the critical section to prevent a possible data race condition
 
-    IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Calling iowa_system_connection_select() for %u connections with a timeout of %ds.", connCount, currentTimeout);
+    IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Calling iowa_system_connection_select() for %u connections with a timeout of %d.", connCount, currentTimeout);
 
     CRIT_SECTION_LEAVE(contextP);
     result = iowa_system_connection_select(connArray, connCount, currentTimeout, contextP->userData);
@@ -424,26 +646,15 @@ uint8_t commSelect(iowa_context_t contextP)
              && connCount != 0
              && contextP->commContextP->channelCount > 0)
     {
-        int32_t currentTime;
         comm_channel_t *channelP;
         size_t connIndex;
 
-        // Retrieve the current time before calling the callbacks
-        CRIT_SECTION_LEAVE(contextP);
-        currentTime = iowa_system_gettime();
-        CRIT_SECTION_ENTER(contextP);
-#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-        if (currentTime < 0
-            || currentTime < contextP->currentTime)
+        if (prv_updateTime(contextP) != IOWA_COAP_NO_ERROR)
         {
-            IOWA_LOG_ERROR_GETTIME(currentTime);
             iowa_system_free(connArray);
 
             return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
-#endif
-
-        contextP->currentTime = currentTime;
 
         for (connIndex = 0; connIndex < connCount; connIndex++)
         {
@@ -469,3 +680,5 @@ uint8_t commSelect(iowa_context_t contextP)
 
     return IOWA_COAP_NO_ERROR;
 }
+
+#endif // IOWA_CONNECTION_WAIT_SUPPORT
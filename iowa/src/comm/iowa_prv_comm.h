@@ -42,6 +42,18 @@ extern "C" {
 #define IOWA_COMM_SERVER_MODE
 #endif
 
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+#ifndef IOWA_CONNECTION_WAIT_MAX_EVENTS
+#define IOWA_CONNECTION_WAIT_MAX_EVENTS 16
+#endif
+#endif
+
+#ifdef IOWA_CONNECTION_RECVV_SUPPORT
+#ifndef IOWA_CONNECTION_RECVV_COUNT
+#define IOWA_CONNECTION_RECVV_COUNT 8
+#endif
+#endif
+
 
 /************************************************
  * Datatypes
@@ -86,6 +98,10 @@ struct _comm_channel_t
     void                   *connP;
     comm_event_callback_t   eventCallback;
     void                   *userData;
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+    bool                    deleted;     // removed from the context, the wait results may still point to it
+    comm_channel_t         *nextDeleted;
+#endif
 };
 
 struct _comm_context_t
@@ -94,6 +110,9 @@ struct _comm_context_t
     comm_channel_t **channelArray;    // Dynamically-allocated array of created channels
     comm_new_channel_callback_t newChannelCallback;
     void *callbackUserData;
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+    comm_channel_t  *deletedList;     // Unregistered channels, freed once the current wait results are dispatched
+#endif
 };
 
 /************************************************
@@ -185,6 +204,32 @@ int commSend(iowa_context_t contextP,
              uint8_t * buffer,
              size_t length);
 
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+// Send several segments as a single datagram on a channel.
+// Returned value: the number of bytes sent or a negative number in case of error.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - channelP: a Comm channel.
+// - segmentArray, segmentCount: data to send.
+int commSendv(iowa_context_t contextP,
+              comm_channel_t *channelP,
+              iowa_connection_segment_t *segmentArray,
+              size_t segmentCount);
+#endif
+
+#ifdef IOWA_CONNECTION_RECVV_SUPPORT
+// Read several datagrams on a channel.
+// Returned value: the number of datagrams read or a negative number in case of error.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - channelP: a Comm channel.
+// - segmentArray, segmentCount: to store the datagrams.
+int commRecvv(iowa_context_t contextP,
+              comm_channel_t *channelP,
+              iowa_connection_segment_t *segmentArray,
+              size_t segmentCount);
+#endif
+
 // Read data on a channel.
 // Returned value: the number of bytes read or a negative number in case of error.
 // Parameters:
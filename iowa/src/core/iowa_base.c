@@ -23,6 +23,53 @@
 #include "iowa_prv_core_internals.h"
 #include "iowa_prv_lwm2m_internals.h"
 
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+#ifdef IOWA_THREAD_SUPPORT
+// Create the subsystem locks.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: the IOWA context.
+static iowa_status_t prv_locksInit(iowa_context_t contextP)
+{
+    size_t i;
+
+    for (i = 0; i < CORE_LOCK_COUNT; i++)
+    {
+        contextP->lockArray[i] = iowa_system_mutex_create(contextP->userData);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (contextP->lockArray[i] == NULL)
+        {
+            IOWA_LOG_ARG_ERROR(IOWA_PART_SYSTEM, "iowa_system_mutex_create() failed for lock %u.", i);
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Delete the subsystem locks.
+// Returned value: none.
+// Parameters:
+// - contextP: the IOWA context.
+static void prv_locksClose(iowa_context_t contextP)
+{
+    size_t i;
+
+    for (i = 0; i < CORE_LOCK_COUNT; i++)
+    {
+        if (contextP->lockArray[i] != NULL)
+        {
+            iowa_system_mutex_delete(contextP->lockArray[i], contextP->userData);
+            contextP->lockArray[i] = NULL;
+        }
+    }
+}
+#endif
+
 /*************************************************************************************
 ** Public functions
 *************************************************************************************/
@@ -54,6 +101,10 @@ iowa_context_t iowa_init(void *userData)
     IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_WEBSOCKET_SUPPORT");
 #endif
 
+#ifdef IOWA_LORAWAN_SUPPORT
+    IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_LORAWAN_SUPPORT");
+#endif
+
 #if IOWA_SECURITY_LAYER == IOWA_SECURITY_LAYER_NONE
     IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_SECURITY_LAYER: IOWA_SECURITY_LAYER_NONE");
 #endif
@@ -66,6 +117,36 @@ iowa_context_t iowa_init(void *userData)
     IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_CONFIG_SKIP_ARGS_CHECK");
 #endif
 
+#ifdef IOWA_TIME_MS_SUPPORT
+    IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_TIME_MS_SUPPORT");
+#endif
+
+#ifdef IOWA_THREAD_SUPPORT
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "IOWA_THREAD_SUPPORT: %d", IOWA_RESOURCE_CHANGE_QUEUE_SIZE);
+#endif
+
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "IOWA_CONNECTION_WAIT_SUPPORT: %d", IOWA_CONNECTION_WAIT_MAX_EVENTS);
+#endif
+
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+    IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_CONNECTION_SENDV_SUPPORT");
+#endif
+
+#ifdef IOWA_CONNECTION_RECVV_SUPPORT
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "IOWA_CONNECTION_RECVV_SUPPORT: %d", IOWA_CONNECTION_RECVV_COUNT);
+#endif
+
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+    IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_MEMORY_POOL_SUPPORT");
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "IOWA_MEMORY_POOL_MESSAGE_COUNT: %d", IOWA_MEMORY_POOL_MESSAGE_COUNT);
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "IOWA_MEMORY_POOL_OPTION_COUNT: %d", IOWA_MEMORY_POOL_OPTION_COUNT);
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "IOWA_MEMORY_POOL_TRANSACTION_COUNT: %d", IOWA_MEMORY_POOL_TRANSACTION_COUNT);
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "IOWA_MEMORY_POOL_EXCHANGE_COUNT: %d", IOWA_MEMORY_POOL_EXCHANGE_COUNT);
+#endif
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "IOWA_COAP_INLINE_OPTION_COUNT: %d", IOWA_COAP_INLINE_OPTION_COUNT);
+
 #ifdef IOWA_PEER_IDENTIFIER_SIZE
     IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "IOWA_PEER_IDENTIFIER_SIZE: %d", IOWA_PEER_IDENTIFIER_SIZE);
 #endif
@@ -175,6 +256,22 @@ iowa_context_t iowa_init(void *userData)
 
     contextP->userData = userData;
 
+#ifdef IOWA_THREAD_SUPPORT
+    if (IOWA_COAP_NO_ERROR != prv_locksInit(contextP))
+    {
+        IOWA_LOG_ERROR(IOWA_PART_BASE, "Subsystem locks initialization failed.");
+        goto error;
+    }
+#endif
+
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+    if (IOWA_COAP_NO_ERROR != corePoolInit(contextP))
+    {
+        IOWA_LOG_ERROR(IOWA_PART_BASE, "Memory pools initialization failed.");
+        goto error;
+    }
+#endif
+
     if (IOWA_COAP_NO_ERROR != commInit(contextP))
     {
         IOWA_LOG_ERROR(IOWA_PART_BASE, "Comm layer initialization failed.");
@@ -219,7 +316,13 @@ error:
     {
         coapClose(contextP);
     }
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+    corePoolClose(contextP);
+#endif
     CRIT_SECTION_LEAVE(contextP);
+#ifdef IOWA_THREAD_SUPPORT
+    prv_locksClose(contextP);
+#endif
     iowa_system_free(contextP);
 
     return NULL;
@@ -259,8 +362,16 @@ void iowa_close(iowa_context_t contextP)
 
     coreTimerClose(contextP);
 
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+    corePoolClose(contextP);
+#endif
+
     CRIT_SECTION_LEAVE(contextP);
 
+#ifdef IOWA_THREAD_SUPPORT
+    prv_locksClose(contextP);
+#endif
+
     iowa_system_free(contextP);
 
     IOWA_LOG_INFO(IOWA_PART_BASE, "IOWA closed");
@@ -270,14 +381,25 @@ iowa_status_t iowa_step(iowa_context_t contextP,
                         int32_t timeout)
 {
     iowa_status_t status;
-    int32_t startTime;
-    int32_t remainingTime;
+    iowa_time_t startTime;
+    iowa_time_t remainingTime;
+    int32_t stepTimeout;
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "timeout: %d.", timeout);
 
+    // Convert the timeout to the internal time unit
+    if (timeout > CORE_TIME_MAX_DELAY_SECONDS)
+    {
+        stepTimeout = INT32_MAX;
+    }
+    else
+    {
+        stepTimeout = (int32_t)CORE_TIME_FROM_SECONDS(timeout);
+    }
+
     if (timeout > 0)
     {
-        startTime = iowa_system_gettime();
+        startTime = coreTimeGet();
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (startTime < 0)
         {
@@ -293,17 +415,19 @@ iowa_status_t iowa_step(iowa_context_t contextP,
 
     do
     {
-        int32_t currentTime;
+        iowa_time_t currentTime;
 
         CRIT_SECTION_ENTER(contextP);
         if (timeout < 0)
         {
+#ifndef IOWA_THREAD_SUPPORT
             IOWA_LOG_WARNING(IOWA_PART_BASE, "WARNING: IOWA_THREAD_SUPPORT is not defined and an \"infinite\" timeout is set.");
+#endif
             contextP->timeout = INT32_MAX;
         }
         else
         {
-            contextP->timeout = timeout;
+            contextP->timeout = stepTimeout;
         }
 
         if ((contextP->action & ACTION_EXIT) == ACTION_EXIT)
@@ -332,7 +456,7 @@ iowa_status_t iowa_step(iowa_context_t contextP,
 
         CRIT_SECTION_LEAVE(contextP);
 
-        currentTime = iowa_system_gettime();
+        currentTime = coreTimeGet();
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (currentTime < 0 || currentTime < startTime)
         {
@@ -384,7 +508,7 @@ iowa_status_t iowa_step(iowa_context_t contextP,
 
         if (timeout > 0)
         {
-            currentTime = iowa_system_gettime();
+            currentTime = coreTimeGet();
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (currentTime < 0 || currentTime < startTime)
             {
@@ -392,7 +516,7 @@ iowa_status_t iowa_step(iowa_context_t contextP,
                 return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
             }
 #endif
-            remainingTime = timeout - (currentTime - startTime);
+            remainingTime = stepTimeout - (currentTime - startTime);
         }
         else if (timeout == 0)
         {
@@ -411,6 +535,17 @@ iowa_status_t iowa_step(iowa_context_t contextP,
     return status;
 }
 
+void iowa_stop(iowa_context_t contextP)
+{
+    IOWA_LOG_INFO(IOWA_PART_BASE, "Stopping IOWA.");
+
+    CRIT_SECTION_ENTER(contextP);
+    contextP->action |= ACTION_EXIT;
+    CRIT_SECTION_LEAVE(contextP);
+
+    INTERRUPT_SELECT(contextP);
+}
+
 void iowa_connection_closed(iowa_context_t contextP,
                             void *connP)
 {
@@ -142,6 +142,13 @@ static iowa_status_t prv_checkCoAPUri(const char *uri,
             break;
 #endif
 
+#ifdef IOWA_LORAWAN_SUPPORT
+        case IOWA_CONN_LORAWAN:
+            binding = IOWA_LWM2M_BINDING_NON_IP;
+            IOWA_LOG_TRACE(IOWA_PART_COAP, "LoRaWAN binding.");
+            break;
+#endif
+
         default:
             IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Incorrect URI schema: %s.", uri);
             return IOWA_COAP_406_NOT_ACCEPTABLE;
@@ -387,7 +394,7 @@ uint32_t clientGetMaxDelayOperation(iowa_context_t contextP)
 
     delay = UINT32_MAX;
 
-    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Current time is %ds.", contextP->currentTime);
+    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Current time is %llds.", (long long)CORE_TIME_TO_SECONDS(contextP->currentTime));
 
     for (serverP = contextP->lwm2mContextP->serverList; serverP != NULL; serverP = serverP->next)
     {
@@ -398,7 +405,7 @@ uint32_t clientGetMaxDelayOperation(iowa_context_t contextP)
 
             IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Server %u has a lifetime of %ds.", serverP->shortId, serverP->lifetime);
 
-            regDelay = serverP->runtime.lifetimeTimerP->executionTime - contextP->currentTime;
+            regDelay = (int32_t)CORE_TIME_TO_SECONDS(serverP->runtime.lifetimeTimerP->executionTime - contextP->currentTime);
             if (regDelay <= 0)
             {
                 return 0;
@@ -419,12 +426,12 @@ uint32_t clientGetMaxDelayOperation(iowa_context_t contextP)
 
                     IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Observation has a pmax of %ds.", obsP->timeAttrP->maxPeriod);
 
-                    if (obsP->lastTime + obsP->timeAttrP->maxPeriod <= contextP->currentTime)
+                    if (obsP->lastTime + CORE_TIME_FROM_SECONDS(obsP->timeAttrP->maxPeriod) <= contextP->currentTime)
                     {
                         return 0;
                     }
 
-                    obsDelay = (uint32_t)obsP->lastTime + obsP->timeAttrP->maxPeriod - contextP->currentTime;
+                    obsDelay = (uint32_t)CORE_TIME_TO_SECONDS(obsP->lastTime + CORE_TIME_FROM_SECONDS(obsP->timeAttrP->maxPeriod) - contextP->currentTime);
                     if (delay > obsDelay)
                     {
                         delay = obsDelay;
@@ -780,6 +787,32 @@ iowa_status_t iowa_client_remove_server(iowa_context_t contextP,
     return result;
 }
 
+iowa_coap_peer_t *iowa_client_get_server_coap_peer(iowa_context_t contextP,
+                                                   uint16_t shortId)
+{
+    lwm2m_server_t *targetP;
+    iowa_coap_peer_t *peerP;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Retrieving the CoAP peer of the server with ID %u.", shortId);
+
+    CRIT_SECTION_ENTER(contextP);
+
+    targetP = (lwm2m_server_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->serverList, utilsListFindCallbackServer, &shortId);
+    if (targetP == NULL)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Server with Short ID %u not found.", shortId);
+        peerP = NULL;
+    }
+    else
+    {
+        peerP = targetP->runtime.peerP;
+    }
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return peerP;
+}
+
 iowa_status_t iowa_client_set_notification_default_periods(iowa_context_t contextP,
                                                            uint16_t shortId,
                                                            uint32_t minPeriod,
@@ -1045,9 +1078,23 @@ iowa_status_t iowa_client_object_resource_changed(iowa_context_t contextP,
     }
 #endif
 
+#ifdef IOWA_THREAD_SUPPORT
+    {
+        iowa_lwm2m_uri_t uri;
+
+        // Do not wait for the step loop to release the context lock
+        uri.objectId = objectID;
+        uri.instanceId = instanceID;
+        uri.resourceId = resourceID;
+        uri.resInstanceId = IOWA_LWM2M_ID_ALL;
+
+        lwm2m_resource_value_changed_queue(contextP, &uri);
+    }
+#else
     CRIT_SECTION_ENTER(contextP);
     customObjectResourceChanged(contextP, objectID, instanceID, resourceID);
     CRIT_SECTION_LEAVE(contextP);
+#endif
 
     return IOWA_COAP_NO_ERROR;
 }
@@ -108,7 +108,7 @@
 
 #define CONTEXT_ADD_BUFFER_OPTION(messageP, optionP, key, data, dataLength)   \
 {                                                                             \
-    optionP = iowa_coap_option_new((key));                                    \
+    optionP = iowa_coap_option_new(contextP, (key));                          \
     if ((optionP) == NULL)                                                    \
     {                                                                         \
         result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;                         \
@@ -121,7 +121,7 @@
 
 #define CONTEXT_ADD_INTEGER_OPTION(messageP, optionP, key, data)              \
 {                                                                             \
-    optionP = iowa_coap_option_new((key));                                    \
+    optionP = iowa_coap_option_new(contextP, (key));                          \
     if ((optionP) == NULL)                                                    \
     {                                                                         \
         result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;                         \
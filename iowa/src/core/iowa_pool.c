@@ -0,0 +1,225 @@
+/**********************************************
+*
+*  _________ _________ ___________ _________
+* |         |         |   |   |   |         |
+* |_________|         |   |   |   |    _    |
+* |         |    |    |   |   |   |         |
+* |         |    |    |           |         |
+* |         |    |    |           |    |    |
+* |         |         |           |    |    |
+* |_________|_________|___________|____|____|
+*
+* Copyright (c) 2019-2020 IoTerop.
+* All rights reserved.
+*
+* This program and the accompanying materials
+* are made available under the terms of
+* IoTerop’s IOWA License (LICENSE.TXT) which
+* accompany this distribution.
+*
+*
+**********************************************/
+
+#include "iowa_prv_core_internals.h"
+#include "iowa_prv_coap_internals.h"
+
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Size of an object rounded up to keep the items of a slab aligned.
+#define PRV_ITEM_SIZE(S) (sizeof(core_pool_header_t) + (((S) + sizeof(core_pool_header_t) - 1) / sizeof(core_pool_header_t)) * sizeof(core_pool_header_t))
+
+// Allocate the slab of a pool and chain its items in the free list.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - poolP: the pool.
+// - objectSize: the size of the objects.
+// - capacity: the number of items of the slab.
+static iowa_status_t prv_poolInit(core_pool_t *poolP,
+                                  size_t objectSize,
+                                  uint16_t capacity)
+{
+    uint16_t i;
+
+    memset(poolP, 0, sizeof(core_pool_t));
+    poolP->itemSize = PRV_ITEM_SIZE(objectSize);
+
+    if (capacity == 0)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    poolP->slab = (uint8_t *)iowa_system_malloc(capacity * poolP->itemSize);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (poolP->slab == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(capacity * poolP->itemSize);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    poolP->capacity = capacity;
+
+    for (i = capacity; i > 0; i--)
+    {
+        core_pool_header_t *headerP;
+
+        headerP = (core_pool_header_t *)(poolP->slab + (i - 1) * poolP->itemSize);
+        headerP->nextP = poolP->freeList;
+        poolP->freeList = headerP;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+iowa_status_t corePoolInit(iowa_context_t contextP)
+{
+    iowa_status_t result;
+
+    IOWA_LOG_TRACE(IOWA_PART_BASE, "Allocating the memory pools.");
+
+    result = prv_poolInit(contextP->poolArray + CORE_POOL_MESSAGE, sizeof(iowa_coap_message_t), IOWA_MEMORY_POOL_MESSAGE_COUNT);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = prv_poolInit(contextP->poolArray + CORE_POOL_OPTION, sizeof(iowa_coap_option_t), IOWA_MEMORY_POOL_OPTION_COUNT);
+    }
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = prv_poolInit(contextP->poolArray + CORE_POOL_TRANSACTION, sizeof(coap_transaction_t), IOWA_MEMORY_POOL_TRANSACTION_COUNT);
+    }
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = prv_poolInit(contextP->poolArray + CORE_POOL_EXCHANGE, sizeof(coap_exchange_t), IOWA_MEMORY_POOL_EXCHANGE_COUNT);
+    }
+
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        corePoolClose(contextP);
+    }
+
+    return result;
+}
+
+void corePoolClose(iowa_context_t contextP)
+{
+    size_t i;
+
+    IOWA_LOG_TRACE(IOWA_PART_BASE, "Releasing the memory pools.");
+
+    for (i = 0; i < CORE_POOL_COUNT; i++)
+    {
+        if (contextP->poolArray[i].inUseCount != 0)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_BASE, "%u items of memory pool %u are still in use.", contextP->poolArray[i].inUseCount, i);
+        }
+        iowa_system_free(contextP->poolArray[i].slab);
+        memset(contextP->poolArray + i, 0, sizeof(core_pool_t));
+    }
+}
+
+void * corePoolAlloc(iowa_context_t contextP,
+                     core_pool_id_t id,
+                     size_t size)
+{
+    // WARNING: This function is called in a critical section
+    core_pool_t *poolP;
+    core_pool_header_t *headerP;
+
+    poolP = contextP->poolArray + id;
+
+    if (poolP->freeList != NULL
+        && PRV_ITEM_SIZE(size) <= poolP->itemSize)
+    {
+        headerP = poolP->freeList;
+        poolP->freeList = headerP->nextP;
+        poolP->inUseCount++;
+        poolP->poolAllocCount++;
+    }
+    else
+    {
+        headerP = (core_pool_header_t *)iowa_system_malloc(sizeof(core_pool_header_t) + size);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (headerP == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(sizeof(core_pool_header_t) + size);
+            return NULL;
+        }
+#endif
+        poolP->heapAllocCount++;
+    }
+
+    headerP->poolP = poolP;
+
+    return headerP + 1;
+}
+
+void corePoolFree(void *pointer)
+{
+    // WARNING: This function is called in a critical section
+    core_pool_header_t *headerP;
+    core_pool_t *poolP;
+
+    if (pointer == NULL)
+    {
+        return;
+    }
+
+    headerP = (core_pool_header_t *)pointer - 1;
+    poolP = headerP->poolP;
+
+    if ((uint8_t *)headerP >= poolP->slab
+        && (uint8_t *)headerP < poolP->slab + poolP->capacity * poolP->itemSize)
+    {
+        headerP->nextP = poolP->freeList;
+        poolP->freeList = headerP;
+        poolP->inUseCount--;
+    }
+    else
+    {
+        poolP->heapFreeCount++;
+        iowa_system_free(headerP);
+    }
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t iowa_memory_pool_get_stats(iowa_context_t contextP,
+                                         iowa_memory_pool_stats_t *statsP)
+{
+    size_t i;
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (statsP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_BASE, "Statistics pointer is nil.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    memset(statsP, 0, sizeof(iowa_memory_pool_stats_t));
+
+    CRIT_SECTION_ENTER(contextP);
+
+    for (i = 0; i < CORE_POOL_COUNT; i++)
+    {
+        statsP->capacity += contextP->poolArray[i].capacity;
+        statsP->inUseCount += contextP->poolArray[i].inUseCount;
+        statsP->poolAllocCount += contextP->poolArray[i].poolAllocCount;
+        statsP->heapAllocCount += contextP->poolArray[i].heapAllocCount;
+        statsP->heapFreeCount += contextP->poolArray[i].heapFreeCount;
+    }
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#endif // IOWA_MEMORY_POOL_SUPPORT
@@ -44,6 +44,7 @@ extern "C" {
 #include "iowa_prv_objects.h"
 #endif
 #include "iowa_prv_timer.h"
+#include "iowa_prv_pool.h"
 #include "iowa_prv_security.h"
 
 
@@ -51,9 +52,35 @@ extern "C" {
  * Macros
  */
 
+#ifdef IOWA_THREAD_SUPPORT
+
+// The context lock protects the whole IOWA stack. The subsystem locks allow
+// the application threads to update the Objects and report resource changes
+// without waiting for the step loop.
+// Lock ordering: context lock, then CORE_LOCK_OBJECTS, then CORE_LOCK_OBSERVATIONS.
+#define CRIT_SECTION_ENTER(C)       iowa_system_mutex_lock((C)->userData)
+#define CRIT_SECTION_LEAVE(C)       iowa_system_mutex_unlock((C)->userData)
+#define INTERRUPT_SELECT(C)         iowa_system_connection_interrupt_select((C)->userData)
+#define SUBSYSTEM_LOCK_ENTER(C, L)  iowa_system_mutex_acquire((C)->lockArray[(L)], (C)->userData)
+#define SUBSYSTEM_LOCK_LEAVE(C, L)  iowa_system_mutex_release((C)->lockArray[(L)], (C)->userData)
+
+#else
+
 #define CRIT_SECTION_ENTER(C)
 #define CRIT_SECTION_LEAVE(C)
 #define INTERRUPT_SELECT(C)
+#define SUBSYSTEM_LOCK_ENTER(C, L)
+#define SUBSYSTEM_LOCK_LEAVE(C, L)
+
+#endif
+
+// Subsystem locks
+// CORE_LOCK_OBJECTS: the Object list, the Object instances and the IPSO sensors values.
+//                    Modifying them requires both the context lock and this lock.
+// CORE_LOCK_OBSERVATIONS: the queue of the resource changes reported outside of the context lock.
+#define CORE_LOCK_OBJECTS       0
+#define CORE_LOCK_OBSERVATIONS  1
+#define CORE_LOCK_COUNT         2
 
 #define ACTION_REBOOT           (1<<0)
 #define ACTION_EXIT             (1<<1)
@@ -118,14 +145,20 @@ struct _iowa_context_t
     coap_context_t                 coapContextP;
     comm_context_t                 commContextP;
     iowa_security_context_t        securityContextP;
-    int32_t                        currentTime;
-    int32_t                        timeout;
-    iowa_timer_t                  *timerList;
+    iowa_time_t                    currentTime; // in internal time unit
+    int32_t                        timeout;     // in internal time unit
+    iowa_timer_heap_t              timerHeap;
 #ifdef LWM2M_CLIENT_MODE
     iowa_event_callback_t          eventCb;
 #endif
     volatile uint16_t             action;
     void                          *userData;
+#ifdef IOWA_THREAD_SUPPORT
+    void                          *lockArray[CORE_LOCK_COUNT];
+#endif
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+    core_pool_t                    poolArray[CORE_POOL_COUNT];
+#endif
 };
 
 /************************************************
@@ -65,11 +65,8 @@ extern "C" {
 #error "At least one LwM2M or CoAP role must be defined."
 #endif
 
-// Check Block-wise transfer is used only on datagram transports
-#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
-#if !defined(IOWA_UDP_SUPPORT) && !defined(IOWA_LORAWAN_SUPPORT) && !defined(IOWA_SMS_SUPPORT)
-#error "CoAP Block-Wise Transfer is usable only with datagram transports."
-#endif
+#if defined(IOWA_COAP_QBLOCK_SUPPORT) && !defined(IOWA_COAP_BLOCK_SUPPORT)
+#error "IOWA_COAP_QBLOCK_SUPPORT requires IOWA_COAP_BLOCK_SUPPORT."
 #endif
 
 /**********************************************
@@ -159,7 +156,7 @@ extern "C" {
 * Check Security configuration.
 **********************************************/
 
-#if defined(IOWA_TCP_SUPPORT) && (IOWA_SECURITY_LAYER == IOWA_SECURITY_LAYER_TINYDTLS)
+#if (defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT)) && (IOWA_SECURITY_LAYER == IOWA_SECURITY_LAYER_TINYDTLS)
 #error "tinyDTLS does not support TLS encryption."
 #endif
 
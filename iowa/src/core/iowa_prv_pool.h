@@ -0,0 +1,134 @@
+/**********************************************
+*
+*  _________ _________ ___________ _________
+* |         |         |   |   |   |         |
+* |_________|         |   |   |   |    _    |
+* |         |    |    |   |   |   |         |
+* |         |    |    |           |         |
+* |         |    |    |           |    |    |
+* |         |         |           |    |    |
+* |_________|_________|___________|____|____|
+*
+* Copyright (c) 2019 IoTerop.
+* All rights reserved.
+*
+* This program and the accompanying materials
+* are made available under the terms of
+* IoTerop’s IOWA License (LICENSE.TXT) which
+* accompany this distribution.
+*
+**********************************************/
+
+#ifndef _IOWA_PRV_POOL_INCLUDE_
+#define _IOWA_PRV_POOL_INCLUDE_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "iowa.h"
+
+/**************************************************************
+* Typedef Pool API
+**************************************************************/
+
+// The kinds of fixed-size objects allocated from the pools.
+typedef enum
+{
+    CORE_POOL_MESSAGE = 0,  // iowa_coap_message_t
+    CORE_POOL_OPTION,       // iowa_coap_option_t
+    CORE_POOL_TRANSACTION,  // coap_transaction_t
+    CORE_POOL_EXCHANGE,     // coap_exchange_t
+    CORE_POOL_COUNT
+} core_pool_id_t;
+
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+
+#ifndef IOWA_MEMORY_POOL_MESSAGE_COUNT
+#define IOWA_MEMORY_POOL_MESSAGE_COUNT 4
+#endif
+#ifndef IOWA_MEMORY_POOL_OPTION_COUNT
+#define IOWA_MEMORY_POOL_OPTION_COUNT 24
+#endif
+#ifndef IOWA_MEMORY_POOL_TRANSACTION_COUNT
+#define IOWA_MEMORY_POOL_TRANSACTION_COUNT 4
+#endif
+#ifndef IOWA_MEMORY_POOL_EXCHANGE_COUNT
+#define IOWA_MEMORY_POOL_EXCHANGE_COUNT 4
+#endif
+
+struct _core_pool_t;
+
+// Header preceding each object allocated by corePoolAlloc().
+// The union ensures the object following the header is suitably aligned.
+typedef union _core_pool_header_t
+{
+    struct _core_pool_t        *poolP;  // while the object is in use
+    union _core_pool_header_t  *nextP;  // while the item is in the free list
+    int64_t                     asInteger;
+    double                      asFloat;
+} core_pool_header_t;
+
+// A pool of fixed-size items carved from a single slab.
+// When the pool is exhausted, objects are allocated from the heap.
+typedef struct _core_pool_t
+{
+    uint8_t            *slab;
+    size_t              itemSize;        // size of an item including its header
+    uint16_t            capacity;        // number of items in the slab
+    uint16_t            inUseCount;      // number of items of the slab in use
+    core_pool_header_t *freeList;
+    uint32_t            poolAllocCount;
+    uint32_t            heapAllocCount;
+    uint32_t            heapFreeCount;
+} core_pool_t;
+
+#define CORE_POOL_ALLOC(C, I, S)  corePoolAlloc((C), (I), (S))
+#define CORE_POOL_FREE(P)         corePoolFree(P)
+
+#else
+
+#define CORE_POOL_ALLOC(C, I, S)  ((void)(C), iowa_system_malloc(S))
+#define CORE_POOL_FREE(P)         iowa_system_free(P)
+
+#endif // IOWA_MEMORY_POOL_SUPPORT
+
+/**************************************************************
+* Pool API
+**************************************************************/
+
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+
+// Allocate the slabs of the pools of an IOWA context.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+iowa_status_t corePoolInit(iowa_context_t contextP);
+
+// Release the slabs of the pools of an IOWA context.
+// Returned value: none.
+// Parameters:
+// - contextP: as returned by iowa_init().
+void corePoolClose(iowa_context_t contextP);
+
+// Allocate an object from a pool, or from the heap if the pool is exhausted.
+// Returned value: the object or NULL in case of memory allocation failure.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - id: the pool matching the kind of object.
+// - size: the size of the object.
+void * corePoolAlloc(iowa_context_t contextP, core_pool_id_t id, size_t size);
+
+// Release an object allocated by corePoolAlloc().
+// Returned value: none.
+// Parameters:
+// - pointer: the object. Can be nil.
+void corePoolFree(void *pointer);
+
+#endif // IOWA_MEMORY_POOL_SUPPORT
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _IOWA_PRV_POOL_INCLUDE_
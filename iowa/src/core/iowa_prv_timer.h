@@ -28,6 +28,28 @@ extern "C" {
 
 #include "iowa.h"
 
+/**************************************************************
+* Time
+**************************************************************/
+
+// Internal time representation.
+// When IOWA_TIME_MS_SUPPORT is defined, the time is retrieved with iowa_system_gettime_ms() and expressed in milliseconds.
+// Otherwise, the time is retrieved with iowa_system_gettime() and expressed in seconds.
+#ifdef IOWA_TIME_MS_SUPPORT
+typedef int64_t iowa_time_t;
+#define CORE_TIME_UNITS_PER_SECOND 1000
+#else
+typedef int32_t iowa_time_t;
+#define CORE_TIME_UNITS_PER_SECOND 1
+#endif
+
+#define CORE_TIME_FROM_SECONDS(S)    ((iowa_time_t)(S) * CORE_TIME_UNITS_PER_SECOND)
+#define CORE_TIME_TO_SECONDS(T)      ((T) / CORE_TIME_UNITS_PER_SECOND)
+#define CORE_TIME_TO_SECONDS_CEIL(T) (((T) + CORE_TIME_UNITS_PER_SECOND - 1) / CORE_TIME_UNITS_PER_SECOND)
+
+// Maximum delay in seconds which can be stored in an int32_t expressed in internal time unit.
+#define CORE_TIME_MAX_DELAY_SECONDS  (INT32_MAX / CORE_TIME_UNITS_PER_SECOND)
+
 /**************************************************************
 * Typedef Timer API
 **************************************************************/
@@ -39,12 +61,36 @@ typedef void (*timer_callback_t)(iowa_context_t contextP, void *userData);
 
 typedef struct _iowa_timer_t
 {
-    struct _iowa_timer_t *nextP;
-    int32_t               executionTime;
-    timer_callback_t      callback;
-    void                 *userData;
+    size_t           heapIndex; // position of the timer in the iowa_timer_heap_t
+    iowa_time_t      executionTime;
+    timer_callback_t callback;
+    void            *userData;
 } iowa_timer_t;
 
+// Binary min-heap of timers ordered by execution time.
+// The root (index 0) is always the next timer to expire.
+typedef struct
+{
+    iowa_timer_t **timerArray;
+    size_t         count;
+    size_t         capacity;
+} iowa_timer_heap_t;
+
+/**************************************************************
+* Time API
+**************************************************************/
+
+// Get the current time from the platform.
+// Returned value: the current time in internal time unit or a negative value in case of error.
+// Parameters: none.
+iowa_time_t coreTimeGet(void);
+
+// Convert a delay in internal time unit to an int32_t, saturating to INT32_MAX.
+// Returned value: the delay in internal time unit.
+// Parameters:
+// - delay: the delay to convert.
+int32_t coreTimeToDelay(iowa_time_t delay);
+
 /**************************************************************
 * Timer API
 **************************************************************/
@@ -53,7 +99,7 @@ typedef struct _iowa_timer_t
 // Returned value: the iowa_timer_t in case of success or NULL if dynamical allocation failed.
 // Parameters:
 // - contextP: as returned by iowa_init().
-// - delay: timer's delay.
+// - delay: timer's delay in seconds.
 // - callback: callback to called when delay has expired.
 // - userData: userData passed through the callback.
 iowa_timer_t *coreTimerNew(iowa_context_t contextP, int32_t delay, timer_callback_t callback, void *userData);
@@ -70,14 +116,21 @@ void coreTimerDelete(iowa_context_t contextP, iowa_timer_t *timerP);
 // Parameters:
 // - contextP: as returned by iowa_init().
 // - timerP: iowa_timer_t to reset.
-// - delay: new timer's delay.
+// - delay: new timer's delay in seconds.
 iowa_status_t coreTimerReset(iowa_context_t contextP, iowa_timer_t *timerP, int32_t delay);
 
-// State Machine of iowa timers. Check all timers in the iowa context and call the corresponding callback when timer's delay has expired.
+// State Machine of iowa timers. Call the callback of all the expired timers in the iowa context and update the context timeout
+// with the delay of the next timer to expire.
 // Parameters:
 // - contextP: as returned by iowa_init().
 void coreTimerStep(iowa_context_t contextP);
 
+// Get the delay before the next timer expires.
+// Returned value: the delay in internal time unit, 0 if a timer already expired, or INT32_MAX if there is no timer.
+// Parameters:
+// - contextP: as returned by iowa_init().
+int32_t coreTimerGetNextDelay(iowa_context_t contextP);
+
 // Delete all timers in the iowa context.
 // Returned value: none.
 // Parameters:
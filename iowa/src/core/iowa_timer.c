@@ -23,10 +23,151 @@
 #include "iowa_prv_core_internals.h"
 #include "iowa_prv_lwm2m_internals.h"
 
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+#define PRV_HEAP_INITIAL_CAPACITY 4
+
+#define PRV_HEAP_PARENT(I) (((I) - 1) / 2)
+#define PRV_HEAP_LEFT(I)   (2 * (I) + 1)
+
+static void prv_heapSet(iowa_timer_heap_t *heapP,
+                        size_t index,
+                        iowa_timer_t *timerP)
+{
+    heapP->timerArray[index] = timerP;
+    timerP->heapIndex = index;
+}
+
+// Move a timer toward the root of the heap until its parent expires before it.
+static void prv_heapSiftUp(iowa_timer_heap_t *heapP,
+                           size_t index)
+{
+    iowa_timer_t *timerP;
+
+    timerP = heapP->timerArray[index];
+    while (index > 0
+           && heapP->timerArray[PRV_HEAP_PARENT(index)]->executionTime > timerP->executionTime)
+    {
+        prv_heapSet(heapP, index, heapP->timerArray[PRV_HEAP_PARENT(index)]);
+        index = PRV_HEAP_PARENT(index);
+    }
+    prv_heapSet(heapP, index, timerP);
+}
+
+// Move a timer toward the leaves of the heap until its children expire after it.
+static void prv_heapSiftDown(iowa_timer_heap_t *heapP,
+                             size_t index)
+{
+    iowa_timer_t *timerP;
+
+    timerP = heapP->timerArray[index];
+    while (PRV_HEAP_LEFT(index) < heapP->count)
+    {
+        size_t childIndex;
+
+        childIndex = PRV_HEAP_LEFT(index);
+        if (childIndex + 1 < heapP->count
+            && heapP->timerArray[childIndex + 1]->executionTime < heapP->timerArray[childIndex]->executionTime)
+        {
+            childIndex++;
+        }
+        if (heapP->timerArray[childIndex]->executionTime >= timerP->executionTime)
+        {
+            break;
+        }
+        prv_heapSet(heapP, index, heapP->timerArray[childIndex]);
+        index = childIndex;
+    }
+    prv_heapSet(heapP, index, timerP);
+}
+
+// Restore the heap property after the execution time of the timer at index changed.
+static void prv_heapUpdate(iowa_timer_heap_t *heapP,
+                           size_t index)
+{
+    if (index > 0
+        && heapP->timerArray[PRV_HEAP_PARENT(index)]->executionTime > heapP->timerArray[index]->executionTime)
+    {
+        prv_heapSiftUp(heapP, index);
+    }
+    else
+    {
+        prv_heapSiftDown(heapP, index);
+    }
+}
+
+static bool prv_heapInsert(iowa_timer_heap_t *heapP,
+                           iowa_timer_t *timerP)
+{
+    if (heapP->count == heapP->capacity)
+    {
+        iowa_timer_t **newArray;
+        size_t newCapacity;
+
+        newCapacity = (heapP->capacity == 0) ? PRV_HEAP_INITIAL_CAPACITY : heapP->capacity * 2;
+        newArray = (iowa_timer_t **)iowa_system_malloc(newCapacity * sizeof(iowa_timer_t *));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (newArray == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(newCapacity * sizeof(iowa_timer_t *));
+            return false;
+        }
+#endif
+        if (heapP->count > 0)
+        {
+            memcpy(newArray, heapP->timerArray, heapP->count * sizeof(iowa_timer_t *));
+        }
+        iowa_system_free(heapP->timerArray);
+        heapP->timerArray = newArray;
+        heapP->capacity = newCapacity;
+    }
+
+    heapP->timerArray[heapP->count] = timerP;
+    heapP->count++;
+    prv_heapSiftUp(heapP, heapP->count - 1);
+
+    return true;
+}
+
+static void prv_heapRemove(iowa_timer_heap_t *heapP,
+                           iowa_timer_t *timerP)
+{
+    size_t index;
+
+    index = timerP->heapIndex;
+    heapP->count--;
+    if (index != heapP->count)
+    {
+        prv_heapSet(heapP, index, heapP->timerArray[heapP->count]);
+        prv_heapUpdate(heapP, index);
+    }
+}
+
 /*************************************************************************************
 ** Public functions
 *************************************************************************************/
 
+iowa_time_t coreTimeGet(void)
+{
+#ifdef IOWA_TIME_MS_SUPPORT
+    return iowa_system_gettime_ms();
+#else
+    return iowa_system_gettime();
+#endif
+}
+
+int32_t coreTimeToDelay(iowa_time_t delay)
+{
+    if (delay > INT32_MAX)
+    {
+        return INT32_MAX;
+    }
+
+    return (int32_t)delay;
+}
+
 iowa_timer_t *coreTimerNew(iowa_context_t contextP,
                            int32_t delay,
                            timer_callback_t callback,
@@ -35,7 +176,7 @@ iowa_timer_t *coreTimerNew(iowa_context_t contextP,
     // WARNING: This function is called in a critical section
     iowa_timer_t *timerP;
 
-    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Entering with delay: %ds, callback: %p, userData: %p, currentTime: %ds.", delay, callback, userData, contextP->currentTime);
+    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Entering with delay: %ds, callback: %p, userData: %p, currentTime: %lld.", delay, callback, userData, (long long)contextP->currentTime);
 
 #ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
     // Check arguments
@@ -63,7 +204,7 @@ iowa_timer_t *coreTimerNew(iowa_context_t contextP,
 
     timerP->callback = callback;
     timerP->userData = userData;
-    timerP->executionTime = contextP->currentTime + delay;
+    timerP->executionTime = contextP->currentTime + CORE_TIME_FROM_SECONDS(delay);
     if (timerP->executionTime < contextP->currentTime)
     {
         IOWA_LOG_WARNING(IOWA_PART_BASE, "Integer overflow.");
@@ -71,9 +212,13 @@ iowa_timer_t *coreTimerNew(iowa_context_t contextP,
         return NULL;
     }
 
-    contextP->timerList = (iowa_timer_t *)IOWA_UTILS_LIST_ADD(contextP->timerList, timerP);
+    if (prv_heapInsert(&(contextP->timerHeap), timerP) == false)
+    {
+        iowa_system_free(timerP);
+        return NULL;
+    }
 
-    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Exiting with iowa_timer_t: %p, execution time: %ds.", timerP, timerP->executionTime);
+    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Exiting with iowa_timer_t: %p, execution time: %lld.", timerP, (long long)timerP->executionTime);
 
     return timerP;
 }
@@ -85,7 +230,7 @@ void coreTimerDelete(iowa_context_t contextP,
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Entering with iowa_timer_t %p.", timerP);
 
-    contextP->timerList = (iowa_timer_t *)IOWA_UTILS_LIST_REMOVE(contextP->timerList, timerP);
+    prv_heapRemove(&(contextP->timerHeap), timerP);
 
     iowa_system_free(timerP);
 
@@ -97,9 +242,9 @@ iowa_status_t coreTimerReset(iowa_context_t contextP,
                              int32_t delay)
 {
     // WARNING: This function is called in a critical section
-    int32_t targetTime;
+    iowa_time_t targetTime;
 
-    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Entering with timerP: %p, delay: %ds, currentTime: %d.", timerP, delay, contextP->currentTime);
+    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Entering with timerP: %p, delay: %ds, currentTime: %lld.", timerP, delay, (long long)contextP->currentTime);
 
 #ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
     // Check arguments
@@ -110,7 +255,7 @@ iowa_status_t coreTimerReset(iowa_context_t contextP,
     }
 #endif
 
-    targetTime = contextP->currentTime + delay;
+    targetTime = contextP->currentTime + CORE_TIME_FROM_SECONDS(delay);
     if (targetTime < contextP->currentTime)
     {
         IOWA_LOG_WARNING(IOWA_PART_BASE, "Integer overflow.");
@@ -118,8 +263,9 @@ iowa_status_t coreTimerReset(iowa_context_t contextP,
     }
 
     timerP->executionTime = targetTime;
+    prv_heapUpdate(&(contextP->timerHeap), timerP->heapIndex);
 
-    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Exiting with execution time: %ds.", timerP->executionTime);
+    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Exiting with execution time: %lld.", (long long)timerP->executionTime);
 
     return IOWA_COAP_NO_ERROR;
 }
@@ -127,63 +273,69 @@ iowa_status_t coreTimerReset(iowa_context_t contextP,
 void coreTimerStep(iowa_context_t contextP)
 {
     // WARNING: This function is called in a critical section
-    iowa_timer_t *timerP;
-    iowa_timer_t *parentTimerP;
+    iowa_timer_heap_t *heapP;
+    int32_t delay;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Entering currentTime: %lld, timeoutP: %d.", (long long)contextP->currentTime, contextP->timeout);
 
-    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Entering currentTime: %ds, timeoutP: %ds.", contextP->currentTime, contextP->timeout);
+    heapP = &(contextP->timerHeap);
 
-    timerP = contextP->timerList;
-    parentTimerP = NULL;
-    while (timerP != NULL)
+    // Timers created or reset by a callback have an execution time in the future so this loop always ends.
+    while (heapP->count > 0
+           && heapP->timerArray[0]->executionTime <= contextP->currentTime)
     {
-        iowa_timer_t *nextTimerP;
+        iowa_timer_t *timerP;
 
-        nextTimerP = timerP->nextP;
+        timerP = heapP->timerArray[0];
+        prv_heapRemove(heapP, timerP);
 
-        IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Execution time: %ds.", timerP->executionTime);
+        IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Calling callback for iowa_timer_t %p.", timerP);
+        timerP->callback(contextP, timerP->userData);
+        IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Callback for iowa_timer_t %p returned.", timerP);
 
-        if (timerP->executionTime <= contextP->currentTime)
-        {
-            IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Calling callback for iowa_timer_t %p.", timerP);
-            timerP->callback(contextP, timerP->userData);
-            IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Callback for iowa_timer_t %p returned.", timerP);
-
-            if (parentTimerP == NULL)
-            {
-                contextP->timerList = timerP->nextP;
-            }
-            else
-            {
-                parentTimerP->nextP = timerP->nextP;
-            }
-
-            iowa_system_free(timerP);
-        }
-        else
-        {
-            int32_t delay;
+        iowa_system_free(timerP);
+    }
+
+    delay = coreTimerGetNextDelay(contextP);
+    if (delay < contextP->timeout)
+    {
+        IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Updating global timeout from %d to %d.", contextP->timeout, delay);
+        contextP->timeout = delay;
+    }
 
-            delay = timerP->executionTime - contextP->currentTime;
-            IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Execution delay for iowa_timer_t %p is %ds.", timerP, delay);
+    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Exiting with final timeoutP: %d.", contextP->timeout);
+}
 
-            if (delay < contextP->timeout)
-            {
-                IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Updating global timeout from %ds to %ds.", contextP->timeout, delay);
-                contextP->timeout = delay;
-            }
+int32_t coreTimerGetNextDelay(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_time_t executionTime;
 
-            parentTimerP = timerP;
-        }
-        timerP = nextTimerP;
+    if (contextP->timerHeap.count == 0)
+    {
+        return INT32_MAX;
     }
 
-    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Exiting with final timeoutP: %ds.", contextP->timeout);
+    executionTime = contextP->timerHeap.timerArray[0]->executionTime;
+    if (executionTime <= contextP->currentTime)
+    {
+        return 0;
+    }
+
+    return coreTimeToDelay(executionTime - contextP->currentTime);
 }
 
 void coreTimerClose(iowa_context_t contextP)
 {
     // WARNING: This function is called in a critical section
+    size_t index;
+
     IOWA_LOG_TRACE(IOWA_PART_BASE, "Entering.");
 
-    IOWA_UTILS_LIST_FREE(contextP->timerList, iowa_system_free);
+    for (index = 0; index < contextP->timerHeap.count; index++)
+    {
+        iowa_system_free(contextP->timerHeap.timerArray[index]);
+    }
+    iowa_system_free(contextP->timerHeap.timerArray);
+    memset(&(contextP->timerHeap), 0, sizeof(iowa_timer_heap_t));
 }
@@ -27,3 +27,885 @@
 #include "iowa_prv_data_internals.h"
 #include <float.h>
 
+#if defined(LWM2M_SUPPORT_CBOR) || defined(LWM2M_SUPPORT_SENML_CBOR) || defined(LWM2M_SUPPORT_LWM2M_CBOR)
+
+#define PRV_CBOR_MAX_NESTING_DEPTH 8
+
+#define PRV_CBOR_SIMPLE_FALSE      20
+#define PRV_CBOR_SIMPLE_TRUE       21
+#define PRV_CBOR_SIMPLE_NULL       22
+#define PRV_CBOR_SIMPLE_UNDEFINED  23
+
+#define PRV_CBOR_BREAK_BYTE        CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_VALUE_BREAK)
+
+#define PRV_OBJECT_LINK_MAX_LENGTH 12 // "65535:65535" plus one spare byte
+
+#define PRV_DECIMAL_FRAC_EXPONENT_MAX 400 // Beyond the range of a double
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Check if a floating point number can be encoded as an half float without loss.
+// Returned value: true if the number fits in an half float, false otherwise.
+// Parameters:
+// - number: the number to check.
+// - halfFloatP: OUT. the 16 bits of the half float.
+// Note: subnormal half floats are never produced.
+static bool prv_getHalfFloat(double number,
+                             uint16_t *halfFloatP)
+{
+    float value;
+    uint32_t bits;
+    int32_t exponent;
+    uint32_t mantissa;
+
+    value = (float)number;
+    if ((double)value != number)
+    {
+        return false;
+    }
+
+    memcpy(&bits, &value, sizeof(bits));
+    exponent = (int32_t)((bits >> 23) & 0xFF) - 127;
+    mantissa = bits & 0x007FFFFFU;
+
+    if (exponent == -127
+        && mantissa == 0)
+    {
+        // Signed zero
+        *halfFloatP = (uint16_t)((bits >> 16) & 0x8000U);
+        return true;
+    }
+
+    if (exponent < -14
+        || exponent > 15
+        || (mantissa & 0x1FFFU) != 0)
+    {
+        return false;
+    }
+
+    *halfFloatP = (uint16_t)(((bits >> 16) & 0x8000U) | ((uint32_t)(exponent + 15) << 10) | (mantissa >> 13));
+
+    return true;
+}
+
+// Skip a CBOR item including its nested items.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - bufferP: the buffer containing the item.
+// - bufferLength: maximal size of the buffer.
+// - bufferIndexP: current buffer index.
+// - depth: nesting depth of the item.
+static int8_t prv_skipItem(uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP,
+                           uint8_t depth)
+{
+    major_type_t majorType;
+    uint64_t number;
+    size_t stringLength;
+
+    if (depth > PRV_CBOR_MAX_NESTING_DEPTH)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "CBOR items are nested too deeply.");
+        return CBOR_ERROR;
+    }
+
+    majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+    switch (majorType)
+    {
+    case CBOR_MAJOR_TYPE_UNSIGNED_INTEGER:
+    case CBOR_MAJOR_TYPE_NEGATIVE_INTEGER:
+        return CBOR_NO_ERROR;
+
+    case CBOR_MAJOR_TYPE_BYTE_STRING:
+    case CBOR_MAJOR_TYPE_TEXT_STRING:
+        if (cborGetBufferToStringLength(majorType, number, &stringLength, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+        {
+            return CBOR_ERROR;
+        }
+        return cborCopyBufferToString(majorType, number, NULL, stringLength, bufferP, bufferLength, bufferIndexP);
+
+    case CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS:
+    case CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS:
+        if (number == CBOR_NUMBER_MAX)
+        {
+            while (*bufferIndexP < bufferLength
+                   && bufferP[*bufferIndexP] != PRV_CBOR_BREAK_BYTE)
+            {
+                if (prv_skipItem(bufferP, bufferLength, bufferIndexP, depth + 1) != CBOR_NO_ERROR)
+                {
+                    return CBOR_ERROR;
+                }
+            }
+            if (*bufferIndexP >= bufferLength)
+            {
+                return CBOR_ERROR;
+            }
+            *bufferIndexP += 1;
+        }
+        else
+        {
+            if (majorType == CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS)
+            {
+                if (number > (bufferLength - *bufferIndexP) / 2)
+                {
+                    return CBOR_ERROR;
+                }
+                number *= 2;
+            }
+            while (number > 0)
+            {
+                if (prv_skipItem(bufferP, bufferLength, bufferIndexP, depth + 1) != CBOR_NO_ERROR)
+                {
+                    return CBOR_ERROR;
+                }
+                number--;
+            }
+        }
+        return CBOR_NO_ERROR;
+
+    case CBOR_MAJOR_TYPE_OPTIONAL_SEMANTIC:
+        return prv_skipItem(bufferP, bufferLength, bufferIndexP, depth + 1);
+
+    case CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA:
+        switch (number)
+        {
+        case CBOR_ADD_INFO_1_BYTE:
+            stringLength = CBOR_BYTE_1_SIZE;
+            break;
+
+        case CBOR_ADD_INFO_2_BYTES:
+            stringLength = CBOR_BYTE_2_SIZE;
+            break;
+
+        case CBOR_ADD_INFO_4_BYTES:
+            stringLength = CBOR_BYTE_4_SIZE;
+            break;
+
+        case CBOR_ADD_INFO_8_BYTES:
+            stringLength = CBOR_BYTE_8_SIZE;
+            break;
+
+        default:
+            if (number > PRV_CBOR_SIMPLE_UNDEFINED)
+            {
+                return CBOR_ERROR;
+            }
+            stringLength = 0;
+        }
+        if (stringLength > bufferLength - *bufferIndexP)
+        {
+            return CBOR_ERROR;
+        }
+        *bufferIndexP += stringLength;
+        return CBOR_NO_ERROR;
+
+    default:
+        return CBOR_ERROR;
+    }
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+int8_t cborAddStringToBuffer(uint8_t *stringP,
+                             size_t stringSize,
+                             uint8_t *bufferP,
+                             size_t bufferLength,
+                             size_t *bufferIndexP,
+                             bool isByteString)
+{
+    assert((stringP != NULL && stringSize != 0) || stringSize == 0);
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    if (cborAddNumberToBuffer(isByteString ? CBOR_MAJOR_TYPE_BYTE_STRING : CBOR_MAJOR_TYPE_TEXT_STRING, stringSize, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+    {
+        return CBOR_ERROR;
+    }
+
+    if (stringSize > bufferLength - *bufferIndexP)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "No room for a string of %u bytes.", stringSize);
+        return CBOR_ERROR;
+    }
+
+    if (stringSize != 0)
+    {
+        memcpy(bufferP + *bufferIndexP, stringP, stringSize);
+        *bufferIndexP += stringSize;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+size_t cborGetNumberToBufferLength(uint64_t number)
+{
+    if (number < CBOR_ADD_INFO_1_BYTE)
+    {
+        return 1;
+    }
+    if (number <= UINT8_MAX)
+    {
+        return 1 + CBOR_BYTE_1_SIZE;
+    }
+    if (number <= UINT16_MAX)
+    {
+        return 1 + CBOR_BYTE_2_SIZE;
+    }
+    if (number <= UINT32_MAX)
+    {
+        return 1 + CBOR_BYTE_4_SIZE;
+    }
+    return 1 + CBOR_BYTE_8_SIZE;
+}
+
+int8_t cborAddNumberToBuffer(major_type_t majorType,
+                             uint64_t number,
+                             uint8_t *bufferP,
+                             size_t bufferLength,
+                             size_t *bufferIndexP)
+{
+    size_t length;
+    size_t i;
+
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    length = cborGetNumberToBufferLength(number);
+    if (*bufferIndexP > bufferLength
+        || length > bufferLength - *bufferIndexP)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "No room for a number of %u bytes.", length);
+        return CBOR_ERROR;
+    }
+
+    switch (length)
+    {
+    case 1:
+        bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(majorType, number);
+        break;
+
+    case 1 + CBOR_BYTE_1_SIZE:
+        bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(majorType, CBOR_ADD_INFO_1_BYTE);
+        break;
+
+    case 1 + CBOR_BYTE_2_SIZE:
+        bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(majorType, CBOR_ADD_INFO_2_BYTES);
+        break;
+
+    case 1 + CBOR_BYTE_4_SIZE:
+        bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(majorType, CBOR_ADD_INFO_4_BYTES);
+        break;
+
+    default:
+        bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(majorType, CBOR_ADD_INFO_8_BYTES);
+        break;
+    }
+
+    // Following bytes are in network byte order
+    for (i = length - 1; i > 0; i--)
+    {
+        bufferP[*bufferIndexP + i] = (uint8_t)(number & 0xFF);
+        number >>= 8;
+    }
+
+    *bufferIndexP += length;
+
+    return CBOR_NO_ERROR;
+}
+
+size_t cborGetFloatToBufferLength(double number)
+{
+    uint16_t halfFloat;
+
+    if (prv_getHalfFloat(number, &halfFloat) == true)
+    {
+        return 1 + CBOR_BYTE_2_SIZE;
+    }
+    if ((double)(float)number == number)
+    {
+        return 1 + CBOR_BYTE_4_SIZE;
+    }
+    return 1 + CBOR_BYTE_8_SIZE;
+}
+
+int8_t cborAddFloatToBuffer(double number,
+                            uint8_t *bufferP,
+                            size_t bufferLength,
+                            size_t *bufferIndexP)
+{
+    size_t length;
+    uint16_t halfFloat;
+
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    length = cborGetFloatToBufferLength(number);
+    if (*bufferIndexP > bufferLength
+        || length > bufferLength - *bufferIndexP)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "No room for a float of %u bytes.", length);
+        return CBOR_ERROR;
+    }
+
+    switch (length)
+    {
+    case 1 + CBOR_BYTE_2_SIZE:
+        (void)prv_getHalfFloat(number, &halfFloat);
+        bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_2_BYTES);
+        utilsCopyValue(bufferP + *bufferIndexP + 1, &halfFloat, CBOR_BYTE_2_SIZE);
+        break;
+
+    case 1 + CBOR_BYTE_4_SIZE:
+    {
+        float value;
+
+        value = (float)number;
+        bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_4_BYTES);
+        utilsCopyValue(bufferP + *bufferIndexP + 1, &value, CBOR_BYTE_4_SIZE);
+        break;
+    }
+
+    default:
+        bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_8_BYTES);
+        utilsCopyValue(bufferP + *bufferIndexP + 1, &number, CBOR_BYTE_8_SIZE);
+        break;
+    }
+
+    *bufferIndexP += length;
+
+    return CBOR_NO_ERROR;
+}
+
+size_t cborGetDataToBufferLength(iowa_lwm2m_data_t *dataP)
+{
+    size_t length;
+
+    assert(dataP != NULL);
+
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_STRING:
+    case IOWA_LWM2M_TYPE_CORE_LINK:
+    case IOWA_LWM2M_TYPE_OPAQUE:
+        length = cborGetNumberToBufferLength(dataP->value.asBuffer.length) + dataP->value.asBuffer.length;
+        break;
+
+    case IOWA_LWM2M_TYPE_INTEGER:
+    case IOWA_LWM2M_TYPE_TIME:
+        if (dataP->value.asInteger < 0)
+        {
+            length = cborGetNumberToBufferLength((uint64_t)(-1 - dataP->value.asInteger));
+        }
+        else
+        {
+            length = cborGetNumberToBufferLength((uint64_t)dataP->value.asInteger);
+        }
+        break;
+
+    case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
+        length = cborGetNumberToBufferLength((uint64_t)dataP->value.asInteger);
+        break;
+
+    case IOWA_LWM2M_TYPE_FLOAT:
+        length = cborGetFloatToBufferLength(dataP->value.asFloat);
+        break;
+
+    case IOWA_LWM2M_TYPE_BOOLEAN:
+    case IOWA_LWM2M_TYPE_NULL:
+        length = 1;
+        break;
+
+    case IOWA_LWM2M_TYPE_OBJECT_LINK:
+        length = dataUtilsObjectLinkToBufferLength(dataP);
+        length += cborGetNumberToBufferLength(length);
+        break;
+
+    default:
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Type %s can not be encoded in CBOR.", STR_LWM2M_TYPE(dataP->type));
+        length = 0;
+        break;
+    }
+
+    return length;
+}
+
+int8_t cborAddDataToBuffer(iowa_lwm2m_data_t *dataP,
+                           uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP)
+{
+    assert(dataP != NULL);
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_STRING:
+    case IOWA_LWM2M_TYPE_CORE_LINK:
+        return cborAddStringToBuffer(dataP->value.asBuffer.buffer, dataP->value.asBuffer.length, bufferP, bufferLength, bufferIndexP, false);
+
+    case IOWA_LWM2M_TYPE_OPAQUE:
+        return cborAddStringToBuffer(dataP->value.asBuffer.buffer, dataP->value.asBuffer.length, bufferP, bufferLength, bufferIndexP, true);
+
+    case IOWA_LWM2M_TYPE_INTEGER:
+    case IOWA_LWM2M_TYPE_TIME:
+        if (dataP->value.asInteger < 0)
+        {
+            // Negative integers are encoded as -1 - value, this does not overflow for INT64_MIN
+            return cborAddNumberToBuffer(CBOR_MAJOR_TYPE_NEGATIVE_INTEGER, (uint64_t)(-1 - dataP->value.asInteger), bufferP, bufferLength, bufferIndexP);
+        }
+        return cborAddNumberToBuffer(CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, (uint64_t)dataP->value.asInteger, bufferP, bufferLength, bufferIndexP);
+
+    case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
+        return cborAddNumberToBuffer(CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, (uint64_t)dataP->value.asInteger, bufferP, bufferLength, bufferIndexP);
+
+    case IOWA_LWM2M_TYPE_FLOAT:
+        return cborAddFloatToBuffer(dataP->value.asFloat, bufferP, bufferLength, bufferIndexP);
+
+    case IOWA_LWM2M_TYPE_BOOLEAN:
+        return cborAddNumberToBuffer(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, dataP->value.asBoolean ? PRV_CBOR_SIMPLE_TRUE : PRV_CBOR_SIMPLE_FALSE, bufferP, bufferLength, bufferIndexP);
+
+    case IOWA_LWM2M_TYPE_NULL:
+        return cborAddNumberToBuffer(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, PRV_CBOR_SIMPLE_NULL, bufferP, bufferLength, bufferIndexP);
+
+    case IOWA_LWM2M_TYPE_OBJECT_LINK:
+    {
+        uint8_t objectLink[PRV_OBJECT_LINK_MAX_LENGTH];
+        size_t objectLinkLength;
+
+        objectLinkLength = dataUtilsObjectLinkToBuffer(dataP, objectLink, PRV_OBJECT_LINK_MAX_LENGTH);
+        if (objectLinkLength == 0)
+        {
+            return CBOR_ERROR;
+        }
+        return cborAddStringToBuffer(objectLink, objectLinkLength, bufferP, bufferLength, bufferIndexP, false);
+    }
+
+    default:
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Type %s can not be encoded in CBOR.", STR_LWM2M_TYPE(dataP->type));
+        return CBOR_ERROR;
+    }
+}
+
+major_type_t cborPutBufferToNumber(uint64_t *numberP,
+                                   uint8_t *bufferNumberP,
+                                   size_t bufferLength,
+                                   size_t *bufferIndexP)
+{
+    major_type_t majorType;
+    uint8_t addInfo;
+    size_t length;
+
+    assert(numberP != NULL);
+    assert(bufferNumberP != NULL);
+    assert(bufferIndexP != NULL);
+
+    if (*bufferIndexP >= bufferLength)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Unexpected end of CBOR buffer.");
+        return CBOR_MAJOR_TYPE_NONE;
+    }
+
+    majorType = (major_type_t)((bufferNumberP[*bufferIndexP] & CBOR_MAJOR_TYPE_MASK) >> CBOR_MAJOR_TYPE_BIT_SHIFT);
+    addInfo = bufferNumberP[*bufferIndexP] & CBOR_ADD_INFO_MASK;
+    *bufferIndexP += 1;
+
+    if (majorType == CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA)
+    {
+        // Following bytes are read by cborGetValueFromFloatMajorType()
+        *numberP = addInfo;
+        return majorType;
+    }
+
+    switch (addInfo)
+    {
+    case CBOR_ADD_INFO_1_BYTE:
+        length = CBOR_BYTE_1_SIZE;
+        break;
+
+    case CBOR_ADD_INFO_2_BYTES:
+        length = CBOR_BYTE_2_SIZE;
+        break;
+
+    case CBOR_ADD_INFO_4_BYTES:
+        length = CBOR_BYTE_4_SIZE;
+        break;
+
+    case CBOR_ADD_INFO_8_BYTES:
+        length = CBOR_BYTE_8_SIZE;
+        break;
+
+    case CBOR_ADD_INFO_VALUE_BREAK:
+        // Indefinite length is only allowed for strings, arrays and maps
+        if (majorType < CBOR_MAJOR_TYPE_BYTE_STRING
+            || majorType > CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Indefinite length is not allowed for major type %d.", majorType);
+            return CBOR_MAJOR_TYPE_NONE;
+        }
+        *numberP = CBOR_NUMBER_MAX;
+        return majorType;
+
+    default:
+        if (addInfo > CBOR_ADD_INFO_1_BYTE)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Reserved additional information %u.", addInfo);
+            return CBOR_MAJOR_TYPE_NONE;
+        }
+        *numberP = addInfo;
+        return majorType;
+    }
+
+    if (length > bufferLength - *bufferIndexP)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Unexpected end of CBOR buffer.");
+        return CBOR_MAJOR_TYPE_NONE;
+    }
+
+    *numberP = 0;
+    while (length > 0)
+    {
+        *numberP = (*numberP << 8) | bufferNumberP[*bufferIndexP];
+        *bufferIndexP += 1;
+        length--;
+    }
+
+    if (*numberP == CBOR_NUMBER_MAX
+        && majorType >= CBOR_MAJOR_TYPE_BYTE_STRING
+        && majorType <= CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS)
+    {
+        // This value is reserved for indefinite length
+        return CBOR_MAJOR_TYPE_NONE;
+    }
+
+    return majorType;
+}
+
+int8_t cborGetBufferToStringLength(major_type_t majorType,
+                                   uint64_t convertResult,
+                                   size_t *stringLengthP,
+                                   uint8_t *bufferP,
+                                   size_t bufferLength,
+                                   size_t *bufferIndexP)
+{
+    size_t index;
+
+    assert(stringLengthP != NULL);
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    if (convertResult != CBOR_NUMBER_MAX)
+    {
+        if (convertResult > bufferLength - *bufferIndexP)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "String is longer than the CBOR buffer.");
+            return CBOR_ERROR;
+        }
+        *stringLengthP = (size_t)convertResult;
+
+        return CBOR_NO_ERROR;
+    }
+
+    // Indefinite length string: sum the length of the chunks up to the break
+    *stringLengthP = 0;
+    index = *bufferIndexP;
+    while (index < bufferLength
+           && bufferP[index] != PRV_CBOR_BREAK_BYTE)
+    {
+        uint64_t chunkLength;
+
+        chunkLength = 0;
+        if (cborPutBufferToNumber(&chunkLength, bufferP, bufferLength, &index) != majorType
+            || chunkLength == CBOR_NUMBER_MAX
+            || chunkLength > bufferLength - index)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid chunk in indefinite length string.");
+            return CBOR_ERROR;
+        }
+        index += (size_t)chunkLength;
+        *stringLengthP += (size_t)chunkLength;
+    }
+    if (index >= bufferLength)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Missing break in indefinite length string.");
+        return CBOR_ERROR;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+int8_t cborCopyBufferToString(major_type_t majorType,
+                              uint64_t convertResult,
+                              uint8_t *stringP,
+                              size_t stringLength,
+                              uint8_t *bufferP,
+                              size_t bufferLength,
+                              size_t *bufferIndexP)
+{
+    size_t copiedLength;
+
+    (void)majorType;
+
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    if (convertResult != CBOR_NUMBER_MAX)
+    {
+        if (stringP != NULL
+            && stringLength != 0)
+        {
+            memcpy(stringP, bufferP + *bufferIndexP, stringLength);
+        }
+        *bufferIndexP += stringLength;
+
+        return CBOR_NO_ERROR;
+    }
+
+    copiedLength = 0;
+    while (bufferP[*bufferIndexP] != PRV_CBOR_BREAK_BYTE)
+    {
+        uint64_t chunkLength;
+
+        chunkLength = 0;
+        (void)cborPutBufferToNumber(&chunkLength, bufferP, bufferLength, bufferIndexP);
+        if (stringP != NULL
+            && chunkLength != 0)
+        {
+            memcpy(stringP + copiedLength, bufferP + *bufferIndexP, (size_t)chunkLength);
+        }
+        copiedLength += (size_t)chunkLength;
+        *bufferIndexP += (size_t)chunkLength;
+    }
+
+    // Skip the break
+    *bufferIndexP += 1;
+
+    return CBOR_NO_ERROR;
+}
+
+int8_t cborPutBufferToString(major_type_t majorType,
+                             uint64_t convertResult,
+                             uint8_t **stringP,
+                             size_t *stringLengthP,
+                             uint8_t *bufferP,
+                             size_t bufferLength,
+                             size_t *bufferIndexP)
+{
+    assert(stringP != NULL);
+    assert(stringLengthP != NULL);
+
+    *stringP = NULL;
+
+    if (cborGetBufferToStringLength(majorType, convertResult, stringLengthP, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+    {
+        return CBOR_ERROR;
+    }
+
+    if (*stringLengthP != 0)
+    {
+        *stringP = (uint8_t *)iowa_system_malloc(*stringLengthP);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (*stringP == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(*stringLengthP);
+            return CBOR_ERROR;
+        }
+#endif
+    }
+
+    return cborCopyBufferToString(majorType, convertResult, *stringP, *stringLengthP, bufferP, bufferLength, bufferIndexP);
+}
+
+int8_t cborGetValueFromFloatMajorType(uint64_t convertResult,
+                                      iowa_lwm2m_data_t *dataP,
+                                      uint8_t *bufferP,
+                                      size_t bufferLength,
+                                      size_t *bufferIndexP)
+{
+    assert(dataP != NULL);
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    switch (convertResult)
+    {
+    case PRV_CBOR_SIMPLE_FALSE:
+    case PRV_CBOR_SIMPLE_TRUE:
+        dataP->type = IOWA_LWM2M_TYPE_BOOLEAN;
+        dataP->value.asBoolean = (convertResult == PRV_CBOR_SIMPLE_TRUE);
+        return CBOR_NO_ERROR;
+
+    case PRV_CBOR_SIMPLE_NULL:
+    case PRV_CBOR_SIMPLE_UNDEFINED:
+        dataP->type = IOWA_LWM2M_TYPE_NULL;
+        dataP->value.asBuffer.length = 0;
+        dataP->value.asBuffer.buffer = NULL;
+        return CBOR_NO_ERROR;
+
+    case CBOR_ADD_INFO_2_BYTES:
+    {
+        uint16_t halfFloat;
+
+        if (CBOR_BYTE_2_SIZE > bufferLength - *bufferIndexP)
+        {
+            return CBOR_ERROR;
+        }
+        utilsCopyValue(&halfFloat, bufferP + *bufferIndexP, CBOR_BYTE_2_SIZE);
+        *bufferIndexP += CBOR_BYTE_2_SIZE;
+
+        dataP->type = IOWA_LWM2M_TYPE_FLOAT;
+        dataP->value.asFloat = (double)dataUtilsConvertHalfFloatToFloat(halfFloat);
+        return CBOR_NO_ERROR;
+    }
+
+    case CBOR_ADD_INFO_4_BYTES:
+    {
+        float value;
+
+        if (CBOR_BYTE_4_SIZE > bufferLength - *bufferIndexP)
+        {
+            return CBOR_ERROR;
+        }
+        utilsCopyValue(&value, bufferP + *bufferIndexP, CBOR_BYTE_4_SIZE);
+        *bufferIndexP += CBOR_BYTE_4_SIZE;
+
+        dataP->type = IOWA_LWM2M_TYPE_FLOAT;
+        dataP->value.asFloat = (double)value;
+        return CBOR_NO_ERROR;
+    }
+
+    case CBOR_ADD_INFO_8_BYTES:
+        if (CBOR_BYTE_8_SIZE > bufferLength - *bufferIndexP)
+        {
+            return CBOR_ERROR;
+        }
+        utilsCopyValue(&(dataP->value.asFloat), bufferP + *bufferIndexP, CBOR_BYTE_8_SIZE);
+        *bufferIndexP += CBOR_BYTE_8_SIZE;
+
+        dataP->type = IOWA_LWM2M_TYPE_FLOAT;
+        return CBOR_NO_ERROR;
+
+    default:
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unsupported CBOR simple value %u.", (uint32_t)convertResult);
+        return CBOR_ERROR;
+    }
+}
+
+int8_t cborPutBufferToData(major_type_t majorType,
+                           uint64_t convertResult,
+                           iowa_lwm2m_data_t *dataP,
+                           uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP)
+{
+    assert(dataP != NULL);
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    switch (majorType)
+    {
+    case CBOR_MAJOR_TYPE_UNSIGNED_INTEGER:
+        if (convertResult > INT64_MAX)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "Integer value is too big.");
+            return CBOR_ERROR;
+        }
+        dataP->type = IOWA_LWM2M_TYPE_INTEGER;
+        dataP->value.asInteger = (int64_t)convertResult;
+        return CBOR_NO_ERROR;
+
+    case CBOR_MAJOR_TYPE_NEGATIVE_INTEGER:
+        if (convertResult > INT64_MAX)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "Integer value is too small.");
+            return CBOR_ERROR;
+        }
+        dataP->type = IOWA_LWM2M_TYPE_INTEGER;
+        dataP->value.asInteger = -1 - (int64_t)convertResult;
+        return CBOR_NO_ERROR;
+
+    case CBOR_MAJOR_TYPE_BYTE_STRING:
+    case CBOR_MAJOR_TYPE_TEXT_STRING:
+        if (cborPutBufferToString(majorType, convertResult, &(dataP->value.asBuffer.buffer), &(dataP->value.asBuffer.length), bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+        {
+            return CBOR_ERROR;
+        }
+        dataP->type = (majorType == CBOR_MAJOR_TYPE_BYTE_STRING) ? IOWA_LWM2M_TYPE_OPAQUE : IOWA_LWM2M_TYPE_STRING;
+        return CBOR_NO_ERROR;
+
+    case CBOR_MAJOR_TYPE_OPTIONAL_SEMANTIC:
+        if (convertResult != CBOR_ADD_INFO_DECIMAL_FRAC)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unsupported CBOR tag %u.", (uint32_t)convertResult);
+            return CBOR_ERROR;
+        }
+        return cborHandleDecimalFraction(dataP, bufferP, bufferLength, bufferIndexP);
+
+    case CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA:
+        return cborGetValueFromFloatMajorType(convertResult, dataP, bufferP, bufferLength, bufferIndexP);
+
+    default:
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unexpected CBOR major type %d.", majorType);
+        return CBOR_ERROR;
+    }
+}
+
+int8_t cborHandleDecimalFraction(iowa_lwm2m_data_t *dataP,
+                                 uint8_t *bufferP,
+                                 size_t bufferLength,
+                                 size_t *bufferIndexP)
+{
+    uint64_t number;
+    int64_t exponent;
+    int64_t mantissa;
+    major_type_t majorType;
+
+    assert(dataP != NULL);
+
+    // A decimal fraction is an array of two integers: [exponent, mantissa]
+    if (cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP) != CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS
+        || number != CBOR_DECIMAL_FRAC_ARRAY_LENGTH)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Decimal fraction is not an array of two items.");
+        return CBOR_ERROR;
+    }
+
+    majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+    if ((majorType != CBOR_MAJOR_TYPE_UNSIGNED_INTEGER && majorType != CBOR_MAJOR_TYPE_NEGATIVE_INTEGER)
+        || number > PRV_DECIMAL_FRAC_EXPONENT_MAX)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid decimal fraction exponent.");
+        return CBOR_ERROR;
+    }
+    exponent = (majorType == CBOR_MAJOR_TYPE_UNSIGNED_INTEGER) ? (int64_t)number : -1 - (int64_t)number;
+
+    majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+    if ((majorType != CBOR_MAJOR_TYPE_UNSIGNED_INTEGER && majorType != CBOR_MAJOR_TYPE_NEGATIVE_INTEGER)
+        || number > INT64_MAX)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid decimal fraction mantissa.");
+        return CBOR_ERROR;
+    }
+    mantissa = (majorType == CBOR_MAJOR_TYPE_UNSIGNED_INTEGER) ? (int64_t)number : -1 - (int64_t)number;
+
+    dataP->type = IOWA_LWM2M_TYPE_FLOAT;
+    dataP->value.asFloat = (double)mantissa * dataUtilsPower(10, exponent);
+
+    return CBOR_NO_ERROR;
+}
+
+int8_t cborSkipItem(uint8_t *bufferP,
+                    size_t bufferLength,
+                    size_t *bufferIndexP)
+{
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    return prv_skipItem(bufferP, bufferLength, bufferIndexP, 0);
+}
+
+#endif // LWM2M_SUPPORT_CBOR || LWM2M_SUPPORT_SENML_CBOR || LWM2M_SUPPORT_LWM2M_CBOR
@@ -144,6 +144,11 @@ iowa_status_t dataLwm2mSerialize(iowa_lwm2m_uri_t *baseUriP,
         break;
 #endif
 
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    case IOWA_CONTENT_FORMAT_SENML_CBOR:
+        break;
+#endif
+
     default:
         *contentFormatP = LWM2M_DEFAULT_CONTENT_FORMAT;
         IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "New content format: %s.", STR_MEDIA_TYPE(*contentFormatP));
@@ -168,6 +173,12 @@ iowa_status_t dataLwm2mSerialize(iowa_lwm2m_uri_t *baseUriP,
     {
         result = tlvSerialize(baseUriP, sortedDataP, sortedDataCount, bufferP, bufferLengthP);
     }
+#endif
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    else if (IOWA_CONTENT_FORMAT_SENML_CBOR == *contentFormatP)
+    {
+        result = senmlCborSerialize(sortedDataP, sortedDataCount, bufferP, bufferLengthP);
+    }
 #endif
     else
     {
@@ -222,6 +233,30 @@ iowa_status_t dataLwm2mDeserialize(iowa_lwm2m_uri_t *baseUriP,
         break;
 #endif
 
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    case IOWA_CONTENT_FORMAT_SENML_CBOR:
+        result = senmlCborDeserialize(bufferP, bufferLength, dataP, dataCountP);
+        if (IOWA_COAP_NO_ERROR == result
+            && baseUriP != NULL)
+        {
+            // SenML records carry their full URI which must be under the targeted one
+            lwm2m_uri_depth_t uriDepth;
+            size_t i;
+
+            uriDepth = dataUtilsGetUriDepth(baseUriP);
+            for (i = 0; i < *dataCountP; i++)
+            {
+                if (dataUtilsIsInBaseUri(*dataP + i, baseUriP, uriDepth) == false)
+                {
+                    IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Data /%u/%u/%u/%u is not under the targeted URI.", (*dataP)[i].objectID, (*dataP)[i].instanceID, (*dataP)[i].resourceID, (*dataP)[i].resInstanceID);
+                    result = IOWA_COAP_400_BAD_REQUEST;
+                    break;
+                }
+            }
+        }
+        break;
+#endif
+
     default:
         IOWA_LOG_ARG_ERROR(IOWA_PART_DATA, "Content format %s is not supported.", STR_MEDIA_TYPE(contentFormat));
         result = IOWA_COAP_415_UNSUPPORTED_CONTENT_FORMAT;
@@ -531,6 +566,8 @@ iowa_status_t dataLwm2mConsolidate(size_t dataCount,
 #ifdef LWM2M_SUPPORT_TLV
             else if (IOWA_LWM2M_TYPE_UNDEFINED == dataArray[i].type)
             {
+                tmpP = dataArray[i].value.asBuffer.buffer;
+
                 if (4 == dataArray[i].value.asBuffer.length)
                 {
                     float value;
@@ -550,6 +587,7 @@ iowa_status_t dataLwm2mConsolidate(size_t dataCount,
                 else
                 {
                     IOWA_LOG_INFO(IOWA_PART_DATA, "Failed to convert the floating point value.");
+                    tmpP = NULL;
                     goto exit_error;
                 }
             }
@@ -677,7 +715,9 @@ iowa_status_t dataLwm2mConsolidate(size_t dataCount,
         }
         else if (IOWA_LWM2M_TYPE_UNDEFINED == type)
         {
-            if (contentFormat != IOWA_CONTENT_FORMAT_OPAQUE)
+            // SenML CBOR values are already typed and may not be buffers
+            if (contentFormat != IOWA_CONTENT_FORMAT_OPAQUE
+                && contentFormat != IOWA_CONTENT_FORMAT_SENML_CBOR)
             {
                 dataArray[i].type = IOWA_LWM2M_TYPE_UNDEFINED;
             }
@@ -702,3 +742,61 @@ exit_error:
 
     return IOWA_COAP_406_NOT_ACCEPTABLE;
 }
+
+iowa_status_t iowa_data_get_block_info(iowa_lwm2m_data_t *dataP,
+                                       uint32_t *numberP,
+                                       bool *moreP,
+                                       uint16_t *sizeP)
+{
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (dataP == NULL
+        || numberP == NULL
+        || moreP == NULL
+        || sizeP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_DATA, "Invalid parameters.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    if (!DATA_IS_BLOCK(dataP->type))
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Data type %s is not a block.", STR_LWM2M_TYPE(dataP->type));
+        return IOWA_COAP_404_NOT_FOUND;
+    }
+
+    return coapDecodeBlockInfo(DATA_BLOCK_DETAIL_TO_OPTION(dataP->value.asBlock.details), numberP, moreP, sizeP);
+}
+
+iowa_status_t iowa_data_set_block_info(iowa_lwm2m_data_t *dataP,
+                                       uint32_t number,
+                                       bool more,
+                                       uint16_t size)
+{
+    iowa_status_t result;
+    uint32_t value;
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (dataP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_DATA, "Data is nil.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    if (number > DATA_BLOCK_NUMBER_MAX)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_DATA, "Block number %u is too big.", number);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    result = coapEncodeBlockInfo(number, more, size, &value);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    dataP->value.asBlock.details = value;
+
+    return IOWA_COAP_NO_ERROR;
+}
@@ -57,8 +57,13 @@ static int prv_parseUriNumber(const uint8_t *uriString,
     {
         if ('0' <= uriString[*headP] && uriString[*headP] <= '9')
         {
-            result += uriString[*headP] - '0';
             result *= 10;
+            result += uriString[*headP] - '0';
+            if (result > IOWA_LWM2M_ID_ALL)
+            {
+                // Stop before overflowing, the ID is invalid anyway
+                return -1;
+            }
         }
         else
         {
@@ -67,7 +72,6 @@ static int prv_parseUriNumber(const uint8_t *uriString,
         *headP += 1;
     }
 
-    result /= 10;
     return result;
 }
 
@@ -864,6 +868,13 @@ size_t dataUtilsBufferToObjectLink(uint8_t *buffer,
     return 1;
 }
 
+size_t dataUtilsObjectLinkToBufferLength(iowa_lwm2m_data_t *dataP)
+{
+    assert(dataP != NULL);
+
+    return prv_intToBufferLength(dataP->value.asObjLink.objectId) + 1 + prv_intToBufferLength(dataP->value.asObjLink.instanceId);
+}
+
 size_t dataUtilsObjectLinkToBuffer(iowa_lwm2m_data_t *dataP,
                                    uint8_t *buffer,
                                    size_t bufferLength)
@@ -1435,6 +1446,30 @@ bool dataUtilsGetBaseUri(iowa_lwm2m_data_t *dataP,
     return true;
 }
 
+#ifdef LWM2M_SUPPORT_TIMESTAMP
+iowa_status_t dataUtilsGetBaseTime(iowa_lwm2m_data_t *dataP,
+                                   size_t size,
+                                   int32_t *basetimeP)
+{
+    size_t index;
+
+    assert(dataP != NULL && size != 0);
+    assert(basetimeP != NULL);
+
+    // The earliest timestamp keeps the relative times of the other data positive
+    *basetimeP = dataP[0].timestamp;
+    for (index = 1; index < size; index++)
+    {
+        if (dataP[index].timestamp < *basetimeP)
+        {
+            *basetimeP = dataP[index].timestamp;
+        }
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+#endif
+
 bool dataUtilsIsInBaseUri(iowa_lwm2m_data_t *dataP,
                           iowa_lwm2m_uri_t *baseUriP,
                           lwm2m_uri_depth_t uriDepth)
@@ -1502,6 +1537,17 @@ void dataUtilsGetUri(iowa_lwm2m_data_t *dataP, iowa_lwm2m_uri_t *uriP)
     uriP->resInstanceId = dataP->resInstanceID;
 }
 
+void dataUtilsSetUri(iowa_lwm2m_data_t *dataP, iowa_lwm2m_uri_t *uriP)
+{
+    assert(dataP != NULL);
+    assert(uriP != NULL);
+
+    dataP->objectID = uriP->objectId;
+    dataP->instanceID = uriP->instanceId;
+    dataP->resourceID = uriP->resourceId;
+    dataP->resInstanceID = uriP->resInstanceId;
+}
+
 bool dataUtilsCompareFloatingPointNumbers(double num1,
                                           double num2)
 {
@@ -1519,3 +1565,41 @@ bool dataUtilsCompareFloatingPointNumbers(double num1,
 /**************************************************************
  * Half float conversion
  **************************************************************/
+
+float dataUtilsConvertHalfFloatToFloat(uint16_t halfFloat)
+{
+    uint32_t bits;
+    uint32_t exponent;
+    uint32_t mantissa;
+    float result;
+
+    exponent = (uint32_t)(halfFloat >> 10) & 0x1F;
+    mantissa = (uint32_t)halfFloat & 0x03FF;
+
+    if (exponent == 0)
+    {
+        // Zero or subnormal number: mantissa * 2^-24
+        result = (float)mantissa / 16777216.0f;
+        if ((halfFloat & 0x8000) != 0)
+        {
+            result = -result;
+        }
+
+        return result;
+    }
+
+    if (exponent == 0x1F)
+    {
+        // Infinity or NaN
+        bits = 0x7F800000U | (mantissa << 13);
+    }
+    else
+    {
+        bits = ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    bits |= ((uint32_t)halfFloat & 0x8000) << 16;
+
+    memcpy(&result, &bits, sizeof(result));
+
+    return result;
+}
@@ -38,6 +38,7 @@ extern "C" {
 
 #define DATA_IS_BLOCK(T) ((T) == IOWA_LWM2M_TYPE_STRING_BLOCK || (T) == IOWA_LWM2M_TYPE_OPAQUE_BLOCK || (T) == IOWA_LWM2M_TYPE_CORE_LINK_BLOCK)
 #define DATA_BLOCK_DETAIL_TO_OPTION(D) ((D) & 0x003FFFFF)
+#define DATA_BLOCK_NUMBER_MAX 0x0003FFFF // the details keep 18 bits for the block number
 
 #define LWM2M_URI_DEPTH_ROOT                0
 #define LWM2M_URI_DEPTH_OBJECT              1
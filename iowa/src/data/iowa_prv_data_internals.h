@@ -160,13 +160,16 @@ int8_t cborAddDataToBuffer(iowa_lwm2m_data_t *dataP, uint8_t *bufferP, size_t bu
 // - bufferNumberP: the buffer to get number.
 // - bufferLength: maximal size of the buffer.
 // - bufferIndexP: current buffer index.
+// Note:
+// - number is set to CBOR_NUMBER_MAX for indefinite length strings, arrays and maps.
+// - for CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, number is the additional information and the following bytes are not read.
 major_type_t cborPutBufferToNumber(uint64_t *numberP, uint8_t *bufferNumberP, size_t bufferLength, size_t *bufferIndexP);
 
 // Get size that the string could take on cbor buffer.
 // Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
 // Parameters:
 // - majorType: major type of the string (CBOR_MAJOR_TYPE_BYTE_STRING or CBOR_MAJOR_TYPE_TEXT_STRING).
-// - convertResult: initial byte of cbor item.
+// - convertResult: number returned by cborPutBufferToNumber().
 // - stringLengthP: the string length.
 // - bufferP: the buffer to get string.
 // - bufferLength: maximal size of the buffer.
@@ -177,17 +180,30 @@ int8_t cborGetBufferToStringLength(major_type_t majorType, uint64_t convertResul
 // Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
 // Parameters:
 // - majorType: major type of the string (CBOR_MAJOR_TYPE_BYTE_STRING or CBOR_MAJOR_TYPE_TEXT_STRING).
-// - convertResult: initial byte of cbor item.
+// - convertResult: number returned by cborPutBufferToNumber().
 // - stringP, stringLengthP: the string in which the buffer will be put.
 // - bufferP: the buffer to get string.
 // - bufferLength: maximal size of the buffer.
 // - bufferIndexP: current buffer index.
 int8_t cborPutBufferToString(major_type_t majorType, uint64_t convertResult, uint8_t **stringP, size_t *stringLengthP, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
 
+// Copy cbor buffer to a string provided by the caller.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - majorType: major type of the string (CBOR_MAJOR_TYPE_BYTE_STRING or CBOR_MAJOR_TYPE_TEXT_STRING).
+// - convertResult: number returned by cborPutBufferToNumber().
+// - stringP: the memory in which the buffer will be copied. This can be nil to skip the string.
+// - stringLength: the string length returned by cborGetBufferToStringLength().
+// - bufferP: the buffer to get string.
+// - bufferLength: maximal size of the buffer.
+// - bufferIndexP: current buffer index.
+// Note: the string must have been checked with cborGetBufferToStringLength() first.
+int8_t cborCopyBufferToString(major_type_t majorType, uint64_t convertResult, uint8_t *stringP, size_t stringLength, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
+
 // Get value number from float major type cbor buffer.
 // Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
 // Parameters:
-// - convertResult: initial byte of cbor item.
+// - convertResult: number returned by cborPutBufferToNumber().
 // - dataP: data in which the buffer will be put.
 // - bufferP: the buffer to get data.
 // - bufferLength: maximal size of the buffer.
@@ -198,7 +214,7 @@ int8_t cborGetValueFromFloatMajorType(uint64_t convertResult, iowa_lwm2m_data_t
 // Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
 // Parameters:
 // - majorType: major type of the value
-// - convertResult: initial byte of cbor item.
+// - convertResult: number returned by cborPutBufferToNumber().
 // - dataP: data in which the buffer will be put.
 // - bufferP: the buffer to get data.
 // - bufferLength: maximal size of the buffer.
@@ -215,6 +231,14 @@ int8_t cborPutBufferToData(major_type_t majorType, uint64_t convertResult, iowa_
 // Note: only if majorType is CBOR_MAJOR_TYPE_OPTIONAL_SEMANTIC with tag CBOR_ADD_INFO_DECIMAL_FRAC
 int8_t cborHandleDecimalFraction(iowa_lwm2m_data_t *dataP, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
 
+// Skip a cbor item and its nested items.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - bufferP: the buffer containing the item.
+// - bufferLength: maximal size of the buffer.
+// - bufferIndexP: current buffer index.
+int8_t cborSkipItem(uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
+
 /*************************************************************************************
 ** External functions
 *************************************************************************************/
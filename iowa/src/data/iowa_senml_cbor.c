@@ -27,3 +27,853 @@
 #include "iowa_prv_data_internals.h"
 #include <float.h>
 
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+
+// SenML labels from RFC 8428
+#define PRV_SENML_LABEL_BASE_NAME     -2
+#define PRV_SENML_LABEL_BASE_TIME     -3
+#define PRV_SENML_LABEL_NAME          0
+#define PRV_SENML_LABEL_VALUE         2
+#define PRV_SENML_LABEL_STRING_VALUE  3
+#define PRV_SENML_LABEL_BOOLEAN_VALUE 4
+#define PRV_SENML_LABEL_TIME          6
+#define PRV_SENML_LABEL_DATA_VALUE    8
+
+// LwM2M extension label for Object Link values, only available as a text string
+#define PRV_SENML_LABEL_OBJLNK_VALUE  0x7FFD
+#define PRV_SENML_LABEL_UNKNOWN       0x7FFE
+#define PRV_SENML_LABEL_ERROR         0x7FFF
+
+#define PRV_SENML_OBJLNK_LABEL        "vlo"
+#define PRV_SENML_OBJLNK_LABEL_LENGTH 3
+#define PRV_SENML_MUST_UNDERSTAND     '_'
+
+#define PRV_SENML_BREAK_BYTE          CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_VALUE_BREAK)
+
+#define PRV_NAME_BUFFER_LENGTH        (URI_MAX_STRING_LEN + 1)
+#define PRV_OBJECT_LINK_MAX_LENGTH    11 // 65535:65535
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+static size_t prv_getUriLength(iowa_lwm2m_data_t *dataP)
+{
+    iowa_lwm2m_uri_t uri;
+
+    dataUtilsGetUri(dataP, &uri);
+
+#ifdef LWM2M_ALTPATH_SUPPORT
+    return dataUtilsUriToBufferLength(&uri, NULL);
+#else
+    return dataUtilsUriToBufferLength(&uri);
+#endif
+}
+
+static size_t prv_uriToBuffer(iowa_lwm2m_uri_t *uriP,
+                              uint8_t *buffer,
+                              size_t bufferLength)
+{
+#ifdef LWM2M_ALTPATH_SUPPORT
+    return dataUtilsUriToBuffer(uriP, NULL, buffer, bufferLength);
+#else
+    return dataUtilsUriToBuffer(uriP, buffer, bufferLength);
+#endif
+}
+
+static size_t prv_getIntegerLength(int64_t number)
+{
+    if (number < 0)
+    {
+        return cborGetNumberToBufferLength((uint64_t)(-1 - number));
+    }
+    return cborGetNumberToBufferLength((uint64_t)number);
+}
+
+static int8_t prv_addInteger(int64_t number,
+                             uint8_t *bufferP,
+                             size_t bufferLength,
+                             size_t *bufferIndexP)
+{
+    if (number < 0)
+    {
+        return cborAddNumberToBuffer(CBOR_MAJOR_TYPE_NEGATIVE_INTEGER, (uint64_t)(-1 - number), bufferP, bufferLength, bufferIndexP);
+    }
+    return cborAddNumberToBuffer(CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, (uint64_t)number, bufferP, bufferLength, bufferIndexP);
+}
+
+// Get the length of the value of a record including its label.
+// Returned value: the length or 0 if the data type can not be serialized.
+// Parameters:
+// - dataP: the data to serialize.
+static size_t prv_getValueLength(iowa_lwm2m_data_t *dataP)
+{
+    size_t length;
+
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_STRING:
+    case IOWA_LWM2M_TYPE_CORE_LINK:
+    case IOWA_LWM2M_TYPE_OPAQUE:
+    case IOWA_LWM2M_TYPE_INTEGER:
+    case IOWA_LWM2M_TYPE_TIME:
+    case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
+    case IOWA_LWM2M_TYPE_FLOAT:
+    case IOWA_LWM2M_TYPE_BOOLEAN:
+        length = 1;
+        break;
+
+    case IOWA_LWM2M_TYPE_OBJECT_LINK:
+        length = cborGetNumberToBufferLength(PRV_SENML_OBJLNK_LABEL_LENGTH) + PRV_SENML_OBJLNK_LABEL_LENGTH;
+        break;
+
+    default:
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Type %s is not supported.", STR_LWM2M_TYPE(dataP->type));
+        return 0;
+    }
+
+    return length + cborGetDataToBufferLength(dataP);
+}
+
+// Get the length of a record without its map header.
+// Returned value: the length of the record.
+// Parameters:
+// - dataP: the data of the record.
+// - isFirst: true for the record carrying the base fields.
+// - baseNameLength: length of the base name.
+// - baseTime: the base time.
+// - pairCountP: OUT. the number of pairs in the record map.
+static size_t prv_getRecordLength(iowa_lwm2m_data_t *dataP,
+                                  bool isFirst,
+                                  size_t baseNameLength,
+                                  int32_t baseTime,
+                                  size_t *pairCountP)
+{
+    size_t length;
+    size_t nameLength;
+
+    length = 0;
+    *pairCountP = 0;
+
+    if (isFirst == true)
+    {
+        if (baseNameLength != 0)
+        {
+            *pairCountP += 1;
+            length += 1 + cborGetNumberToBufferLength(baseNameLength) + baseNameLength;
+        }
+        if (baseTime != 0)
+        {
+            *pairCountP += 1;
+            length += 1 + prv_getIntegerLength(baseTime);
+        }
+    }
+
+    nameLength = prv_getUriLength(dataP) - baseNameLength;
+    if (nameLength != 0)
+    {
+        *pairCountP += 1;
+        length += 1 + cborGetNumberToBufferLength(nameLength) + nameLength;
+    }
+
+#ifdef LWM2M_SUPPORT_TIMESTAMP
+    if (dataP->timestamp != baseTime)
+    {
+        *pairCountP += 1;
+        length += 1 + prv_getIntegerLength((int64_t)dataP->timestamp - baseTime);
+    }
+#endif
+
+    if (dataP->type != IOWA_LWM2M_TYPE_URI_ONLY)
+    {
+        *pairCountP += 1;
+        length += prv_getValueLength(dataP);
+    }
+
+    return length;
+}
+
+static int8_t prv_addValue(iowa_lwm2m_data_t *dataP,
+                           uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP)
+{
+    int8_t res;
+
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_STRING:
+    case IOWA_LWM2M_TYPE_CORE_LINK:
+        res = prv_addInteger(PRV_SENML_LABEL_STRING_VALUE, bufferP, bufferLength, bufferIndexP);
+        break;
+
+    case IOWA_LWM2M_TYPE_OPAQUE:
+        res = prv_addInteger(PRV_SENML_LABEL_DATA_VALUE, bufferP, bufferLength, bufferIndexP);
+        break;
+
+    case IOWA_LWM2M_TYPE_BOOLEAN:
+        res = prv_addInteger(PRV_SENML_LABEL_BOOLEAN_VALUE, bufferP, bufferLength, bufferIndexP);
+        break;
+
+    case IOWA_LWM2M_TYPE_OBJECT_LINK:
+        res = cborAddStringToBuffer((uint8_t *)PRV_SENML_OBJLNK_LABEL, PRV_SENML_OBJLNK_LABEL_LENGTH, bufferP, bufferLength, bufferIndexP, false);
+        break;
+
+    default:
+        res = prv_addInteger(PRV_SENML_LABEL_VALUE, bufferP, bufferLength, bufferIndexP);
+        break;
+    }
+    if (res != CBOR_NO_ERROR)
+    {
+        return res;
+    }
+
+    return cborAddDataToBuffer(dataP, bufferP, bufferLength, bufferIndexP);
+}
+
+// Read the label of a map pair.
+// Returned value: the label, PRV_SENML_LABEL_UNKNOWN for labels to ignore or PRV_SENML_LABEL_ERROR.
+// Parameters:
+// - bufferP: the SenML CBOR payload.
+// - bufferLength: length of the payload.
+// - bufferIndexP: current index in the payload.
+static int32_t prv_getLabel(uint8_t *bufferP,
+                            size_t bufferLength,
+                            size_t *bufferIndexP)
+{
+    major_type_t majorType;
+    uint64_t number;
+    size_t labelLength;
+
+    majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+    switch (majorType)
+    {
+    case CBOR_MAJOR_TYPE_UNSIGNED_INTEGER:
+        if (number > INT16_MAX)
+        {
+            return PRV_SENML_LABEL_UNKNOWN;
+        }
+        return (int32_t)number;
+
+    case CBOR_MAJOR_TYPE_NEGATIVE_INTEGER:
+        if (number > INT16_MAX)
+        {
+            return PRV_SENML_LABEL_UNKNOWN;
+        }
+        return -1 - (int32_t)number;
+
+    case CBOR_MAJOR_TYPE_TEXT_STRING:
+        if (cborGetBufferToStringLength(majorType, number, &labelLength, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+        {
+            return PRV_SENML_LABEL_ERROR;
+        }
+        if (number != CBOR_NUMBER_MAX)
+        {
+            if (labelLength == PRV_SENML_OBJLNK_LABEL_LENGTH
+                && memcmp(bufferP + *bufferIndexP, PRV_SENML_OBJLNK_LABEL, PRV_SENML_OBJLNK_LABEL_LENGTH) == 0)
+            {
+                *bufferIndexP += labelLength;
+                return PRV_SENML_LABEL_OBJLNK_VALUE;
+            }
+            if (labelLength != 0
+                && bufferP[*bufferIndexP + labelLength - 1] == PRV_SENML_MUST_UNDERSTAND)
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unsupported must-understand label \"%.*s\".", labelLength, bufferP + *bufferIndexP);
+                return PRV_SENML_LABEL_ERROR;
+            }
+        }
+        if (cborCopyBufferToString(majorType, number, NULL, labelLength, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+        {
+            return PRV_SENML_LABEL_ERROR;
+        }
+        return PRV_SENML_LABEL_UNKNOWN;
+
+    default:
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Invalid label major type %d.", majorType);
+        return PRV_SENML_LABEL_ERROR;
+    }
+}
+
+// Read a text string into a fixed size buffer.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - bufferP: the SenML CBOR payload.
+// - bufferLength: length of the payload.
+// - bufferIndexP: current index in the payload.
+// - stringP: OUT. the string.
+// - stringMaxLength: the size of stringP.
+// - stringLengthP: OUT. the string length.
+static int8_t prv_getTextString(uint8_t *bufferP,
+                                size_t bufferLength,
+                                size_t *bufferIndexP,
+                                uint8_t *stringP,
+                                size_t stringMaxLength,
+                                size_t *stringLengthP)
+{
+    major_type_t majorType;
+    uint64_t number;
+
+    majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+    if (majorType != CBOR_MAJOR_TYPE_TEXT_STRING
+        || cborGetBufferToStringLength(majorType, number, stringLengthP, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR
+        || *stringLengthP > stringMaxLength)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid text string.");
+        return CBOR_ERROR;
+    }
+
+    return cborCopyBufferToString(majorType, number, stringP, *stringLengthP, bufferP, bufferLength, bufferIndexP);
+}
+
+// Read a time in seconds. SenML allows both integers and floating point numbers.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - bufferP: the SenML CBOR payload.
+// - bufferLength: length of the payload.
+// - bufferIndexP: current index in the payload.
+// - timeP: OUT. the time.
+static int8_t prv_getTime(uint8_t *bufferP,
+                          size_t bufferLength,
+                          size_t *bufferIndexP,
+                          int64_t *timeP)
+{
+    major_type_t majorType;
+    uint64_t number;
+    iowa_lwm2m_data_t data;
+
+    memset(&data, 0, sizeof(iowa_lwm2m_data_t));
+
+    majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+    if (majorType == CBOR_MAJOR_TYPE_BYTE_STRING
+        || majorType == CBOR_MAJOR_TYPE_TEXT_STRING
+        || cborPutBufferToData(majorType, number, &data, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid time.");
+        return CBOR_ERROR;
+    }
+
+    switch (data.type)
+    {
+    case IOWA_LWM2M_TYPE_INTEGER:
+        if (data.value.asInteger < INT32_MIN
+            || data.value.asInteger > INT32_MAX)
+        {
+            break;
+        }
+        *timeP = data.value.asInteger;
+        return CBOR_NO_ERROR;
+
+    case IOWA_LWM2M_TYPE_FLOAT:
+        // This also rejects NaN
+        if (!(data.value.asFloat >= (double)INT32_MIN
+              && data.value.asFloat <= (double)INT32_MAX))
+        {
+            break;
+        }
+        *timeP = (int64_t)data.value.asFloat;
+        return CBOR_NO_ERROR;
+
+    default:
+        break;
+    }
+
+    IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid time.");
+
+    return CBOR_ERROR;
+}
+
+// Parse a SenML record.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - bufferP: the SenML CBOR payload.
+// - bufferLength: length of the payload.
+// - bufferIndexP: current index in the payload.
+// - baseNameP, baseNameLengthP: IN/OUT. the current base name.
+// - baseTimeP: IN/OUT. the current base time.
+// - dataP: OUT. the data of the record.
+static int8_t prv_parseRecord(uint8_t *bufferP,
+                              size_t bufferLength,
+                              size_t *bufferIndexP,
+                              uint8_t *baseNameP,
+                              size_t *baseNameLengthP,
+                              int64_t *baseTimeP,
+                              iowa_lwm2m_data_t *dataP)
+{
+    uint64_t pairCount;
+    bool isIndefinite;
+    uint8_t name[PRV_NAME_BUFFER_LENGTH];
+    size_t nameLength;
+    int64_t time;
+    bool hasValue;
+    iowa_lwm2m_uri_t uri;
+
+    if (cborPutBufferToNumber(&pairCount, bufferP, bufferLength, bufferIndexP) != CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "SenML record is not a map.");
+        return CBOR_ERROR;
+    }
+    isIndefinite = (pairCount == CBOR_NUMBER_MAX);
+
+    nameLength = 0;
+    time = 0;
+    hasValue = false;
+
+    while (true)
+    {
+        int32_t label;
+        major_type_t majorType;
+        uint64_t number;
+
+        if (isIndefinite == true)
+        {
+            if (*bufferIndexP >= bufferLength)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_DATA, "Missing break in SenML record.");
+                return CBOR_ERROR;
+            }
+            if (bufferP[*bufferIndexP] == PRV_SENML_BREAK_BYTE)
+            {
+                *bufferIndexP += 1;
+                break;
+            }
+        }
+        else
+        {
+            if (pairCount == 0)
+            {
+                break;
+            }
+            pairCount--;
+        }
+
+        label = prv_getLabel(bufferP, bufferLength, bufferIndexP);
+        switch (label)
+        {
+        case PRV_SENML_LABEL_BASE_NAME:
+            if (prv_getTextString(bufferP, bufferLength, bufferIndexP, baseNameP, URI_MAX_STRING_LEN, baseNameLengthP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+            break;
+
+        case PRV_SENML_LABEL_NAME:
+            if (prv_getTextString(bufferP, bufferLength, bufferIndexP, name, URI_MAX_STRING_LEN, &nameLength) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+            break;
+
+        case PRV_SENML_LABEL_BASE_TIME:
+            if (prv_getTime(bufferP, bufferLength, bufferIndexP, baseTimeP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+            break;
+
+        case PRV_SENML_LABEL_TIME:
+            if (prv_getTime(bufferP, bufferLength, bufferIndexP, &time) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+            break;
+
+        case PRV_SENML_LABEL_VALUE:
+        case PRV_SENML_LABEL_STRING_VALUE:
+        case PRV_SENML_LABEL_BOOLEAN_VALUE:
+        case PRV_SENML_LABEL_DATA_VALUE:
+            if (hasValue == true)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_DATA, "SenML record has several values.");
+                return CBOR_ERROR;
+            }
+            hasValue = true;
+
+            majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+            if (cborPutBufferToData(majorType, number, dataP, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+
+            // The value type must match its label
+            if (dataP->type != IOWA_LWM2M_TYPE_NULL
+                && !(label == PRV_SENML_LABEL_VALUE && (dataP->type == IOWA_LWM2M_TYPE_INTEGER || dataP->type == IOWA_LWM2M_TYPE_FLOAT))
+                && !(label == PRV_SENML_LABEL_STRING_VALUE && dataP->type == IOWA_LWM2M_TYPE_STRING)
+                && !(label == PRV_SENML_LABEL_BOOLEAN_VALUE && dataP->type == IOWA_LWM2M_TYPE_BOOLEAN)
+                && !(label == PRV_SENML_LABEL_DATA_VALUE && dataP->type == IOWA_LWM2M_TYPE_OPAQUE))
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Value of type %s does not match label %d.", STR_LWM2M_TYPE(dataP->type), label);
+                return CBOR_ERROR;
+            }
+            break;
+
+        case PRV_SENML_LABEL_OBJLNK_VALUE:
+        {
+            uint8_t objectLink[PRV_OBJECT_LINK_MAX_LENGTH];
+            size_t objectLinkLength;
+
+            if (hasValue == true)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_DATA, "SenML record has several values.");
+                return CBOR_ERROR;
+            }
+            hasValue = true;
+
+            if (prv_getTextString(bufferP, bufferLength, bufferIndexP, objectLink, PRV_OBJECT_LINK_MAX_LENGTH, &objectLinkLength) != CBOR_NO_ERROR
+                || dataUtilsBufferToObjectLink(objectLink, objectLinkLength, dataP) == 0)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid Object Link value.");
+                return CBOR_ERROR;
+            }
+            break;
+        }
+
+        case PRV_SENML_LABEL_ERROR:
+            return CBOR_ERROR;
+
+        default:
+            // Fields not used by LwM2M (units, sums, base value, ...) are ignored
+            if (cborSkipItem(bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+            break;
+        }
+    }
+
+    // The name of the record is the concatenation of the base name and the name
+    if (*baseNameLengthP + nameLength == 0
+        || *baseNameLengthP + nameLength > URI_MAX_STRING_LEN)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid SenML record name.");
+        return CBOR_ERROR;
+    }
+    memmove(name + *baseNameLengthP, name, nameLength);
+    memcpy(name, baseNameP, *baseNameLengthP);
+    nameLength += *baseNameLengthP;
+
+#ifdef LWM2M_ALTPATH_SUPPORT
+    if (dataUtilsBufferToUri((const char *)name, nameLength, &uri, NULL) != nameLength)
+#else
+    if (dataUtilsBufferToUri((const char *)name, nameLength, &uri) != nameLength)
+#endif
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Invalid SenML record name \"%.*s\".", nameLength, name);
+        return CBOR_ERROR;
+    }
+    dataUtilsSetUri(dataP, &uri);
+
+    if (hasValue == false)
+    {
+        dataP->type = IOWA_LWM2M_TYPE_URI_ONLY;
+    }
+
+    time += *baseTimeP;
+    if (time < INT32_MIN
+        || time > INT32_MAX)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "SenML record time is out of range.");
+        return CBOR_ERROR;
+    }
+    dataP->timestamp = (int32_t)time;
+
+    return CBOR_NO_ERROR;
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t senmlCborSerialize(iowa_lwm2m_data_t *dataP,
+                                 size_t size,
+                                 uint8_t **bufferP,
+                                 size_t *bufferLengthP)
+{
+    uint8_t baseName[PRV_NAME_BUFFER_LENGTH];
+    size_t baseNameLength;
+    int32_t baseTime;
+    size_t bufferIndex;
+    size_t pairCount;
+    size_t i;
+    int8_t res;
+
+    assert(dataP != NULL);
+    assert(size != 0);
+    assert(bufferP != NULL);
+    assert(bufferLengthP != NULL);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "size: %d", size);
+
+    *bufferP = NULL;
+    *bufferLengthP = 0;
+
+    // Factor out the URI shared by all the data in the base name
+    baseNameLength = 0;
+    if (size > 1)
+    {
+        iowa_lwm2m_uri_t baseUri;
+        lwm2m_uri_depth_t baseUriDepth;
+
+        (void)dataUtilsGetBaseUri(dataP, size, &baseUri, &baseUriDepth);
+        if (baseUriDepth != LWM2M_URI_DEPTH_ROOT)
+        {
+            baseNameLength = prv_uriToBuffer(&baseUri, baseName, PRV_NAME_BUFFER_LENGTH);
+            if (baseNameLength == 0)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_DATA, "Failed to serialize the base name.");
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+
+            // The separator goes in the base name, unless a data is at the base URI itself
+            for (i = 0; i < size; i++)
+            {
+                if (dataUtilsIsEqualUri(dataP + i, &baseUri) == true)
+                {
+                    break;
+                }
+            }
+            if (i == size)
+            {
+                baseName[baseNameLength] = '/';
+                baseNameLength++;
+            }
+        }
+    }
+
+    // Factor out the timestamps in the base time
+    baseTime = 0;
+#ifdef LWM2M_SUPPORT_TIMESTAMP
+    if (size > 1)
+    {
+        iowa_status_t result;
+
+        result = dataUtilsGetBaseTime(dataP, size, &baseTime);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            return result;
+        }
+    }
+#endif
+
+    // Compute the payload length to allocate it once
+    *bufferLengthP = cborGetNumberToBufferLength(size);
+    for (i = 0; i < size; i++)
+    {
+        size_t recordLength;
+
+        if (dataP[i].type != IOWA_LWM2M_TYPE_URI_ONLY
+            && prv_getValueLength(dataP + i) == 0)
+        {
+            *bufferLengthP = 0;
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+
+        recordLength = prv_getRecordLength(dataP + i, i == 0, baseNameLength, baseTime, &pairCount);
+        *bufferLengthP += cborGetNumberToBufferLength(pairCount) + recordLength;
+    }
+
+    *bufferP = (uint8_t *)iowa_system_malloc(*bufferLengthP);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(*bufferLengthP);
+        *bufferLengthP = 0;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    bufferIndex = 0;
+    res = cborAddNumberToBuffer(CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS, size, *bufferP, *bufferLengthP, &bufferIndex);
+    CBOR_SERIALIZATION_TEST_FUNCTION_RESULT(res);
+
+    for (i = 0; i < size; i++)
+    {
+        uint8_t uriString[PRV_NAME_BUFFER_LENGTH];
+        iowa_lwm2m_uri_t uri;
+        size_t uriLength;
+
+        (void)prv_getRecordLength(dataP + i, i == 0, baseNameLength, baseTime, &pairCount);
+        res = cborAddNumberToBuffer(CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS, pairCount, *bufferP, *bufferLengthP, &bufferIndex);
+        CBOR_SERIALIZATION_TEST_FUNCTION_RESULT(res);
+
+        if (i == 0)
+        {
+            if (baseNameLength != 0)
+            {
+                res = prv_addInteger(PRV_SENML_LABEL_BASE_NAME, *bufferP, *bufferLengthP, &bufferIndex);
+                CBOR_SERIALIZATION_TEST_FUNCTION_RESULT(res);
+                res = cborAddStringToBuffer(baseName, baseNameLength, *bufferP, *bufferLengthP, &bufferIndex, false);
+                CBOR_SERIALIZATION_TEST_FUNCTION_RESULT(res);
+            }
+            if (baseTime != 0)
+            {
+                res = prv_addInteger(PRV_SENML_LABEL_BASE_TIME, *bufferP, *bufferLengthP, &bufferIndex);
+                CBOR_SERIALIZATION_TEST_FUNCTION_RESULT(res);
+                res = prv_addInteger(baseTime, *bufferP, *bufferLengthP, &bufferIndex);
+                CBOR_SERIALIZATION_TEST_FUNCTION_RESULT(res);
+            }
+        }
+
+        dataUtilsGetUri(dataP + i, &uri);
+        uriLength = prv_uriToBuffer(&uri, uriString, PRV_NAME_BUFFER_LENGTH);
+        if (uriLength == 0)
+        {
+            goto exit_error;
+        }
+        if (uriLength > baseNameLength)
+        {
+            res = prv_addInteger(PRV_SENML_LABEL_NAME, *bufferP, *bufferLengthP, &bufferIndex);
+            CBOR_SERIALIZATION_TEST_FUNCTION_RESULT(res);
+            res = cborAddStringToBuffer(uriString + baseNameLength, uriLength - baseNameLength, *bufferP, *bufferLengthP, &bufferIndex, false);
+            CBOR_SERIALIZATION_TEST_FUNCTION_RESULT(res);
+        }
+
+#ifdef LWM2M_SUPPORT_TIMESTAMP
+        if (dataP[i].timestamp != baseTime)
+        {
+            res = prv_addInteger(PRV_SENML_LABEL_TIME, *bufferP, *bufferLengthP, &bufferIndex);
+            CBOR_SERIALIZATION_TEST_FUNCTION_RESULT(res);
+            res = prv_addInteger((int64_t)dataP[i].timestamp - baseTime, *bufferP, *bufferLengthP, &bufferIndex);
+            CBOR_SERIALIZATION_TEST_FUNCTION_RESULT(res);
+        }
+#endif
+
+        if (dataP[i].type != IOWA_LWM2M_TYPE_URI_ONLY)
+        {
+            res = prv_addValue(dataP + i, *bufferP, *bufferLengthP, &bufferIndex);
+            CBOR_SERIALIZATION_TEST_FUNCTION_RESULT(res);
+        }
+    }
+
+    if (bufferIndex != *bufferLengthP)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Serialized %u bytes instead of %u.", bufferIndex, *bufferLengthP);
+        goto exit_error;
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "Returning %u bytes", *bufferLengthP);
+
+    return IOWA_COAP_NO_ERROR;
+
+exit_error:
+    iowa_system_free(*bufferP);
+    *bufferP = NULL;
+    *bufferLengthP = 0;
+
+    return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+}
+
+iowa_status_t senmlCborDeserialize(uint8_t *buffer,
+                                   size_t bufferLength,
+                                   iowa_lwm2m_data_t **dataP,
+                                   size_t *dataCountP)
+{
+    uint64_t recordCount;
+    bool isIndefinite;
+    size_t bufferIndex;
+    size_t i;
+    uint8_t baseName[PRV_NAME_BUFFER_LENGTH];
+    size_t baseNameLength;
+    int64_t baseTime;
+
+    assert(dataP != NULL);
+    assert(dataCountP != NULL);
+
+    IOWA_LOG_BUFFER_TRACE(IOWA_PART_DATA, "Parsing SenML CBOR buffer", buffer, bufferLength);
+
+    *dataP = NULL;
+    *dataCountP = 0;
+
+    if (buffer == NULL
+        || bufferLength == 0)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Empty SenML CBOR payload.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    bufferIndex = 0;
+    if (cborPutBufferToNumber(&recordCount, buffer, bufferLength, &bufferIndex) != CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "SenML pack is not an array.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    isIndefinite = (recordCount == CBOR_NUMBER_MAX);
+    if (isIndefinite == true)
+    {
+        size_t index;
+
+        // Count the records to allocate the data once
+        recordCount = 0;
+        index = bufferIndex;
+        while (index < bufferLength
+               && buffer[index] != PRV_SENML_BREAK_BYTE)
+        {
+            if (cborSkipItem(buffer, bufferLength, &index) != CBOR_NO_ERROR)
+            {
+                return IOWA_COAP_400_BAD_REQUEST;
+            }
+            recordCount++;
+        }
+        if (index >= bufferLength)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "Missing break in SenML pack.");
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+    }
+    else if (recordCount > bufferLength - bufferIndex)
+    {
+        // Each record takes at least one byte
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "SenML pack is truncated.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    if (recordCount == 0)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "SenML pack is empty.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    *dataP = (iowa_lwm2m_data_t *)iowa_system_malloc((size_t)recordCount * sizeof(iowa_lwm2m_data_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*dataP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC((size_t)recordCount * sizeof(iowa_lwm2m_data_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(*dataP, 0, (size_t)recordCount * sizeof(iowa_lwm2m_data_t));
+    *dataCountP = (size_t)recordCount;
+
+    baseNameLength = 0;
+    baseTime = 0;
+    for (i = 0; i < *dataCountP; i++)
+    {
+        if (prv_parseRecord(buffer, bufferLength, &bufferIndex, baseName, &baseNameLength, &baseTime, *dataP + i) != CBOR_NO_ERROR)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Failed to parse SenML record #%u.", i);
+            goto exit_error;
+        }
+    }
+
+    if (isIndefinite == true)
+    {
+        // The break was found when counting the records
+        bufferIndex++;
+    }
+    if (bufferIndex != bufferLength)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Unexpected data after the SenML pack.");
+        goto exit_error;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+
+exit_error:
+    dataLwm2mFree(*dataCountP, *dataP);
+    *dataP = NULL;
+    *dataCountP = 0;
+
+    return IOWA_COAP_400_BAD_REQUEST;
+}
+
+#endif // LWM2M_SUPPORT_SENML_CBOR
@@ -30,6 +30,7 @@ set(BASE_DIR ${CMAKE_CURRENT_LIST_DIR}/core)
 set(BASE_HEADERS
     ${BASE_DIR}/iowa_prv_core.h
     ${BASE_DIR}/iowa_prv_timer.h
+    ${BASE_DIR}/iowa_prv_pool.h
     ${BASE_DIR}/iowa_prv_core_internals.h
     ${BASE_DIR}/iowa_prv_core_check_config.h
     ${BASE_DIR}/iowa_prv_core_backward_compatibility.h)
@@ -38,6 +39,7 @@ set(BASE_SOURCES
     ${BASE_DIR}/iowa_base.c
     ${BASE_DIR}/iowa_buffer.c
     ${BASE_DIR}/iowa_context.c
+    ${BASE_DIR}/iowa_pool.c
     ${BASE_DIR}/iowa_timer.c)
 
 set(BASE_CLIENT_SOURCES
@@ -72,10 +74,12 @@ set(COAP_SOURCES
     ${COAP_DIR}/iowa_block.c
     ${COAP_DIR}/iowa_coap.c
     ${COAP_DIR}/iowa_coap_lorawan.c
+    ${COAP_DIR}/iowa_coap_schc.c
     ${COAP_DIR}/iowa_coap_sms.c
     ${COAP_DIR}/iowa_coap_tcp.c
     ${COAP_DIR}/iowa_coap_udp.c
     ${COAP_DIR}/iowa_coap_utils.c
+    ${COAP_DIR}/iowa_coap_websocket.c
     ${COAP_DIR}/iowa_message.c
     ${COAP_DIR}/iowa_option.c
     ${COAP_DIR}/iowa_peer.c
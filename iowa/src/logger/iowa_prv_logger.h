@@ -93,7 +93,7 @@ extern "C" {
 #endif
 
 #define IOWA_LOG_ERROR_MALLOC(size)  IOWA_LOG_ARG_ERROR(IOWA_PART_SYSTEM, "Allocation of %u bytes failed.", (size))
-#define IOWA_LOG_ERROR_GETTIME(time) IOWA_LOG_ARG_ERROR(IOWA_PART_SYSTEM, "Bad returned time: %d.", (time))
+#define IOWA_LOG_ERROR_GETTIME(time) IOWA_LOG_ARG_ERROR(IOWA_PART_SYSTEM, "Bad returned time: %lld.", (long long)(time))
 
 #ifdef __cplusplus
 }
@@ -120,7 +120,11 @@ void lwm2m_close(iowa_context_t contextP)
 
         customObjectDelete(objectP);
     }
+    iowa_system_free(contextP->lwm2mContextP->objectArray);
+    contextP->lwm2mContextP->objectArray = NULL;
+    contextP->lwm2mContextP->objectCount = 0;
 
+    iowa_system_free(contextP->lwm2mContextP->observeIndexArray);
     iowa_system_free(contextP->lwm2mContextP->endpointName);
 #ifdef LWM2M_ALTPATH_SUPPORT
     iowa_system_free(contextP->lwm2mContextP->altPath);
@@ -220,7 +224,7 @@ void lwm2m_server_close(iowa_context_t contextP,
 
     utilsDisconnectServer(contextP, serverP);
     attributesRemoveFromServer(serverP);
-    observeRemoveFromServer(serverP);
+    observeRemoveFromServer(contextP, serverP);
 }
 #endif // LWM2M_CLIENT_MODE
 
@@ -236,6 +240,10 @@ iowa_status_t lwm2m_step(iowa_context_t contextP)
 #ifdef LWM2M_CLIENT_MODE
     IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Initial state: %s.", LWM2M_STR_STATE(contextP->lwm2mContextP->state));
 
+#ifdef IOWA_THREAD_SUPPORT
+    lwm2m_resource_value_changed_flush(contextP);
+#endif
+
     switch (contextP->lwm2mContextP->state)
     {
     case STATE_INITIAL:
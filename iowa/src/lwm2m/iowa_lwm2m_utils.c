@@ -129,6 +129,13 @@ size_t utils_bindingToString(iowa_lwm2m_binding_t binding,
         (*strBindingP)[index] = QUERY_BINDING_TCP;
         index++;
     }
+#endif
+#ifdef IOWA_LORAWAN_SUPPORT
+    if ((binding & IOWA_LWM2M_BINDING_NON_IP) != 0)
+    {
+        (*strBindingP)[index] = QUERY_BINDING_NON_IP;
+        index++;
+    }
 #endif
     if (queueMode == true)
     {
@@ -178,6 +185,9 @@ iowa_content_format_t utils_getMediaType(iowa_coap_message_t *messageP,
 #ifdef LWM2M_SUPPORT_TLV
     case IOWA_CONTENT_FORMAT_TLV_OLD:
     case IOWA_CONTENT_FORMAT_TLV:
+#endif
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    case IOWA_CONTENT_FORMAT_SENML_CBOR:
 #endif
         break;
 
@@ -73,6 +73,489 @@
 
 #ifdef LWM2M_CLIENT_MODE
 
+#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+// Get the content format of a Streamable resource.
+// Returned value: IOWA_CONTENT_FORMAT_TEXT for a String resource, IOWA_CONTENT_FORMAT_OPAQUE otherwise.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - uriP: the URI of the resource.
+static iowa_content_format_t prv_getStreamFormat(iowa_context_t contextP,
+                                                 iowa_lwm2m_uri_t *uriP)
+{
+    if (object_getResourceType(uriP->objectId, uriP->resourceId, contextP) == IOWA_LWM2M_TYPE_STRING)
+    {
+        return IOWA_CONTENT_FORMAT_TEXT;
+    }
+
+    return IOWA_CONTENT_FORMAT_OPAQUE;
+}
+
+// Read a block of a Streamable resource from the application.
+// Returned value: IOWA_COAP_205_CONTENT in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - uriP: the URI of the resource.
+// - serverP: the Server making the request.
+// - numberP: IN/OUT. the block number asked, the block number returned by the application.
+// - sizeP: IN/OUT. the block size asked, the block size returned by the application.
+// - bufferP: to store the block. Its length must be at least the block size asked.
+// - lengthP: OUT. the length of the block.
+// - moreP: OUT. true if there are more blocks.
+static iowa_status_t prv_readApplicationBlock(iowa_context_t contextP,
+                                              iowa_lwm2m_uri_t *uriP,
+                                              lwm2m_server_t *serverP,
+                                              uint32_t *numberP,
+                                              uint16_t *sizeP,
+                                              uint8_t *bufferP,
+                                              size_t *lengthP,
+                                              bool *moreP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    iowa_lwm2m_data_t *dataP;
+    size_t dataCount;
+    uint32_t blockInfo;
+    uint16_t bufferLength;
+
+    bufferLength = *sizeP;
+    *lengthP = 0;
+
+    result = coapEncodeBlockInfo(*numberP, false, *sizeP, &blockInfo);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    result = object_readBlock(contextP, uriP, serverP->shortId, blockInfo, &dataCount, &dataP);
+    if (result != IOWA_COAP_205_CONTENT)
+    {
+        return result;
+    }
+
+    // The application may only shorten the last block
+    if (iowa_data_get_block_info(dataP, numberP, moreP, sizeP) != IOWA_COAP_NO_ERROR
+        || dataP->value.asBlock.totalSize > *sizeP
+        || dataP->value.asBlock.totalSize > bufferLength
+        || (*moreP == true
+            && dataP->value.asBlock.totalSize != *sizeP))
+    {
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "The application returned an invalid block.");
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+    else
+    {
+        if (dataP->value.asBlock.totalSize != 0)
+        {
+            memcpy(bufferP, dataP->value.asBlock.buffer, dataP->value.asBlock.totalSize);
+        }
+        *lengthP = dataP->value.asBlock.totalSize;
+    }
+
+    object_free(contextP, dataCount, dataP);
+    iowa_system_free(dataP);
+
+    return result;
+}
+
+// Read a block of a Streamable resource into a response.
+// A BERT block is read as consecutive blocks of 1024 bytes.
+// A Q-Block2 request with the M bit set reads the blocks of the set in the response.
+// Returned value: IOWA_COAP_205_CONTENT in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - uriP: the URI of the resource.
+// - serverP: the Server making the request.
+// - messageP: the request.
+// - responseP: the response.
+// - formatP: IN/OUT. the format accepted by the Server, the format of the response.
+static iowa_status_t prv_readBlock(iowa_context_t contextP,
+                                   iowa_lwm2m_uri_t *uriP,
+                                   lwm2m_server_t *serverP,
+                                   iowa_coap_message_t *messageP,
+                                   iowa_coap_message_t *responseP,
+                                   iowa_content_format_t *formatP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    iowa_coap_option_t *optionP;
+    iowa_content_format_t format;
+    uint32_t number;
+    uint32_t count;
+    uint32_t i;
+    bool more;
+    bool bert;
+    uint16_t size;
+    uint16_t maxSize;
+    size_t bertSize;
+    uint8_t *bufferP;
+    size_t bufferLength;
+    size_t length;
+
+    format = prv_getStreamFormat(contextP, uriP);
+    if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_ACCEPT) != NULL
+        && *formatP != format)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Streamable resource can not be read as %s.", STR_MEDIA_TYPE(*formatP));
+        return IOWA_COAP_406_NOT_ACCEPTABLE;
+    }
+
+    maxSize = coapBlockGetSize(contextP, serverP->runtime.peerP);
+    bertSize = coapBlockGetBertSize(contextP, serverP->runtime.peerP);
+    number = 0;
+    size = maxSize;
+    bert = bertSize != 0;
+    count = 1;
+
+    optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_2);
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    if (optionP == NULL)
+    {
+        optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_Q_BLOCK_2);
+    }
+#endif
+    if (optionP != NULL)
+    {
+        result = coapBlockDecodePeerInfo(serverP->runtime.peerP, optionP->value.asInteger, &number, &more, &size, &bert);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            return result;
+        }
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+        if (optionP->number == IOWA_COAP_OPTION_Q_BLOCK_2)
+        {
+            // The M bit of the request asks for the rest of the set
+            bert = false;
+            if (more == true)
+            {
+                count = IOWA_COAP_QBLOCK_MAX_PAYLOADS;
+            }
+        }
+#endif
+        if (bertSize == 0)
+        {
+            // The BERT block would be a block of 1024 bytes
+            bert = false;
+        }
+        if (bert == false
+            && size > maxSize)
+        {
+            number = number * (size / maxSize);
+            size = maxSize;
+        }
+        if (number > DATA_BLOCK_NUMBER_MAX)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Block number %u is too big.", number);
+            return IOWA_COAP_402_BAD_OPTION;
+        }
+    }
+
+    if (bert == true)
+    {
+        size = IOWA_DATA_BLOCK_SIZE_1024;
+        count = (uint32_t)(bertSize / IOWA_DATA_BLOCK_SIZE_1024);
+    }
+
+    bufferLength = (size_t)count * size;
+    bufferP = (uint8_t *)iowa_system_malloc(bufferLength);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(bufferLength);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    bufferLength = 0;
+    more = true;
+    result = IOWA_COAP_205_CONTENT;
+    for (i = 0; i < count && more == true; i++)
+    {
+        uint32_t blockNumber;
+        uint16_t blockSize;
+
+        blockNumber = number + i;
+        blockSize = size;
+        result = prv_readApplicationBlock(contextP, uriP, serverP, &blockNumber, &blockSize, bufferP + bufferLength, &length, &more);
+        if (result != IOWA_COAP_205_CONTENT)
+        {
+            break;
+        }
+
+        if (i == 0)
+        {
+            if (blockSize != size)
+            {
+                // The application chose smaller blocks
+                bert = false;
+                count = 1;
+            }
+            number = blockNumber;
+            size = blockSize;
+        }
+        else if (blockNumber != number + i
+                 || blockSize != size)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_LWM2M, "The application returned an invalid block.");
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            break;
+        }
+        bufferLength += length;
+    }
+
+    if (result == IOWA_COAP_205_CONTENT)
+    {
+        if (bert == true)
+        {
+            result = coapBlockSetBertOption(contextP, responseP, IOWA_COAP_OPTION_BLOCK_2, number, more);
+        }
+        else
+        {
+            // A Q-Block2 option tells the CoAP layer the payload starts with this block
+            result = coapBlockSetOption(contextP, responseP, optionP != NULL ? optionP->number : IOWA_COAP_OPTION_BLOCK_2, number, more, size);
+        }
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+        else
+        {
+            result = IOWA_COAP_205_CONTENT;
+        }
+    }
+
+    if (result == IOWA_COAP_205_CONTENT
+        && bufferLength != 0)
+    {
+        coreBufferSet(&(responseP->payload), bufferP, bufferLength);
+    }
+    else
+    {
+        iowa_system_free(bufferP);
+    }
+
+    *formatP = format;
+
+    return result;
+}
+
+// Give the payload of a block to the application.
+// A BERT block is written as consecutive blocks of 1024 bytes.
+// Returned value: IOWA_COAP_204_CHANGED in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - uriP: the URI of the resource.
+// - serverP: the Server making the request.
+// - messageP: the request.
+// - number: the block number.
+// - more: true if there are more blocks coming.
+// - size: the block size.
+static iowa_status_t prv_writeApplicationBlock(iowa_context_t contextP,
+                                               iowa_lwm2m_uri_t *uriP,
+                                               lwm2m_server_t *serverP,
+                                               iowa_coap_message_t *messageP,
+                                               uint32_t number,
+                                               bool more,
+                                               uint16_t size)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    iowa_lwm2m_data_t data;
+    size_t offset;
+
+    memset(&data, 0, sizeof(iowa_lwm2m_data_t));
+    data.objectID = uriP->objectId;
+    data.instanceID = uriP->instanceId;
+    data.resourceID = uriP->resourceId;
+    data.resInstanceID = uriP->resInstanceId;
+    data.type = INTERNAL_LWM2M_TYPE_BLOCK + object_getResourceType(uriP->objectId, uriP->resourceId, contextP);
+
+    // The application receives blocks of at most 1024 bytes
+    offset = 0;
+    do
+    {
+        size_t length;
+        bool blockMore;
+
+        length = messageP->payload.length - offset;
+        blockMore = more;
+        if (length > size)
+        {
+            length = size;
+            blockMore = true;
+        }
+
+        data.value.asBlock.totalSize = length;
+        data.value.asBlock.buffer = messageP->payload.data + offset;
+        if (iowa_data_set_block_info(&data, number + (uint32_t)(offset / size), blockMore, size) != IOWA_COAP_NO_ERROR)
+        {
+            return IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+        }
+
+        result = object_checkWritePayload(contextP, 1, &data);
+        if (result == IOWA_COAP_NO_ERROR)
+        {
+            // A block never replaces the other Resource Instances
+            result = object_write(contextP, serverP->shortId, 1, &data, true);
+        }
+        if (result != IOWA_COAP_204_CHANGED)
+        {
+            return result;
+        }
+
+        offset += length;
+    } while (offset < messageP->payload.length);
+
+    return IOWA_COAP_204_CHANGED;
+}
+
+// Write a block of a Streamable resource.
+// A BERT block is written as consecutive blocks of 1024 bytes.
+// Returned value: IOWA_COAP_231_CONTINUE or IOWA_COAP_204_CHANGED in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - uriP: the URI of the resource.
+// - serverP: the Server making the request.
+// - messageP: the request.
+// - block1P: the Block1 option of the request.
+// - format: the content format of the request.
+// - responseP: the response.
+static iowa_status_t prv_writeBlock(iowa_context_t contextP,
+                                    iowa_lwm2m_uri_t *uriP,
+                                    lwm2m_server_t *serverP,
+                                    iowa_coap_message_t *messageP,
+                                    iowa_coap_option_t *block1P,
+                                    iowa_content_format_t format,
+                                    iowa_coap_message_t *responseP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    uint32_t number;
+    bool more;
+    bool bert;
+    uint16_t size;
+    uint16_t maxSize;
+
+    result = coapBlockDecodePeerInfo(serverP->runtime.peerP, block1P->value.asInteger, &number, &more, &size, &bert);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    if (format != prv_getStreamFormat(contextP, uriP))
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Streamable resource can not be written as %s.", STR_MEDIA_TYPE(format));
+        return IOWA_COAP_415_UNSUPPORTED_CONTENT_FORMAT;
+    }
+
+    if (more == true
+        && ((bert == false
+             && messageP->payload.length != size)
+            || (bert == true
+                && (messageP->payload.length == 0
+                    || messageP->payload.length % size != 0))))
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Received a block of %u bytes instead of %u.", messageP->payload.length, size);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    result = prv_writeApplicationBlock(contextP, uriP, serverP, messageP, number, more, size);
+    if (result != IOWA_COAP_204_CHANGED)
+    {
+        return result;
+    }
+
+    if (more == true)
+    {
+        if (bert == false)
+        {
+            // RFC 7959 Section 2.3: the preferred size of the next blocks is given in the response
+            maxSize = coapBlockGetSize(contextP, serverP->runtime.peerP);
+            if (size > maxSize)
+            {
+                size = maxSize;
+            }
+        }
+        result = IOWA_COAP_231_CONTINUE;
+    }
+
+    if (bert == true)
+    {
+        if (coapBlockSetBertOption(contextP, responseP, IOWA_COAP_OPTION_BLOCK_1, number, more) != IOWA_COAP_NO_ERROR)
+        {
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+    }
+    else if (coapBlockSetOption(contextP, responseP, IOWA_COAP_OPTION_BLOCK_1, number, more, size) != IOWA_COAP_NO_ERROR)
+    {
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return result;
+}
+
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+// Write a block of a Streamable resource received in Q-Block1 blocks.
+// The blocks are written in sequence. Only the last block of a set gets a response.
+// Returned value: the code of the response or IOWA_COAP_CODE_EMPTY if no response is expected.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - uriP: the URI of the resource.
+// - serverP: the Server making the request.
+// - messageP: the request.
+// - qBlock1P: the Q-Block1 option of the request.
+// - format: the content format of the request.
+// - responseP: the response.
+static iowa_status_t prv_writeQBlock(iowa_context_t contextP,
+                                     iowa_lwm2m_uri_t *uriP,
+                                     lwm2m_server_t *serverP,
+                                     iowa_coap_message_t *messageP,
+                                     iowa_coap_option_t *qBlock1P,
+                                     iowa_content_format_t format,
+                                     iowa_coap_message_t *responseP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    uint32_t number;
+    bool more;
+    bool next;
+    uint16_t size;
+
+    result = coapDecodeBlockInfo(qBlock1P->value.asInteger, &number, &more, &size);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    if (format != prv_getStreamFormat(contextP, uriP))
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Streamable resource can not be written as %s.", STR_MEDIA_TYPE(format));
+        return IOWA_COAP_415_UNSUPPORTED_CONTENT_FORMAT;
+    }
+
+    if (more == true
+        && messageP->payload.length != size)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Received a block of %u bytes instead of %u.", messageP->payload.length, size);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    result = coapQBlock1Receive(serverP->runtime.peerP, messageP, number, more, &next);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    result = IOWA_COAP_204_CHANGED;
+    if (next == true)
+    {
+        result = prv_writeApplicationBlock(contextP, uriP, serverP, messageP, number, more, size);
+    }
+
+    return coapQBlock1PrepareResponse(contextP, serverP->runtime.peerP, messageP, result, responseP);
+}
+#endif
+#endif // defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+
 void dm_handleRequest(iowa_context_t contextP,
                       iowa_lwm2m_uri_t *uriP,
                       lwm2m_server_t *serverP,
@@ -90,6 +573,9 @@ void dm_handleRequest(iowa_context_t contextP,
 #if defined(LWM2M_SUPPORT_TLV) || defined(LWM2M_SUPPORT_JSON)
     uint8_t uriBufferP[PRV_URI_BUFFER_SIZE];
 #endif
+#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+    iowa_coap_option_t *block1P;
+#endif
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Code: %u.%02u, server status: %s", messageP->code >> 5, messageP->code & 0x1F, LWM2M_SERVER_STR_STATUS(serverP->runtime.status));
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "URI: /%u/%u/%u/%u", uriP->objectId, uriP->instanceId, uriP->resourceId, uriP->resInstanceId);
@@ -112,7 +598,7 @@ void dm_handleRequest(iowa_context_t contextP,
         return;
     }
 
-    responseP = iowa_coap_message_prepare_response(messageP, IOWA_COAP_CODE_EMPTY);
+    responseP = iowa_coap_message_prepare_response(contextP, messageP, IOWA_COAP_CODE_EMPTY);
     if (responseP == NULL)
     {
         IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create response packet.");
@@ -137,6 +623,36 @@ void dm_handleRequest(iowa_context_t contextP,
         }
     }
 
+#ifndef IOWA_COAP_QBLOCK_SUPPORT
+    if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_Q_BLOCK_1) != NULL
+        || iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_Q_BLOCK_2) != NULL)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Q-Block options are not supported.");
+        result = IOWA_COAP_402_BAD_OPTION;
+        goto error;
+    }
+#endif
+
+#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+    block1P = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_1);
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    if (block1P == NULL)
+    {
+        block1P = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_Q_BLOCK_1);
+    }
+#endif
+    if (block1P != NULL
+        && (messageP->code != IOWA_COAP_CODE_PUT
+            || !LWM2M_URI_IS_SET_RESOURCE(uriP)
+            || iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_URI_QUERY) != NULL
+            || false == object_checkResourceFlag(contextP, uriP, IOWA_RESOURCE_FLAG_STREAMABLE)))
+    {
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Block-wise requests are only supported to write Streamable resources.");
+        result = IOWA_COAP_402_BAD_OPTION;
+        goto error;
+    }
+#endif
+
     // Get the request message format
     requestFormat = utils_getMediaType(messageP, IOWA_COAP_OPTION_CONTENT_FORMAT);
     switch (requestFormat)
@@ -156,6 +672,13 @@ void dm_handleRequest(iowa_context_t contextP,
         break;
 
     default:
+#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+        if (block1P != NULL)
+        {
+            // The blocks are given as is to the application
+            break;
+        }
+#endif
         {
             result = dataLwm2mDeserialize(uriP, messageP->payload.data, messageP->payload.length, requestFormat, &dataP, &dataCount, object_getResourceType, contextP);
             if (result != IOWA_COAP_NO_ERROR)
@@ -211,6 +734,14 @@ void dm_handleRequest(iowa_context_t contextP,
                 }
             }
         }
+#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+        else if (optionObserveP == NULL
+                 && LWM2M_URI_IS_SET_RESOURCE(uriP)
+                 && true == object_checkResourceFlag(contextP, uriP, IOWA_RESOURCE_FLAG_STREAMABLE))
+        {
+            result = prv_readBlock(contextP, uriP, serverP, messageP, responseP, &responseFormat);
+        }
+#endif
         else
         {
             {
@@ -257,7 +788,7 @@ void dm_handleRequest(iowa_context_t contextP,
         if (result == IOWA_COAP_205_CONTENT
             && responseP->payload.length != 0)
         {
-            optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
+            optionP = iowa_coap_option_new(contextP, IOWA_COAP_OPTION_CONTENT_FORMAT);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (optionP == NULL)
             {
@@ -312,9 +843,9 @@ void dm_handleRequest(iowa_context_t contextP,
                     uriP->instanceId = dataP[0].instanceID;
 
 #ifdef LWM2M_ALTPATH_SUPPORT
-                    responseP->optionList = uri_encode(IOWA_COAP_OPTION_LOCATION_PATH, contextP->lwm2mContextP->altPath, uriP, uriBufferP);
+                    responseP->optionList = uri_encode(contextP, IOWA_COAP_OPTION_LOCATION_PATH, contextP->lwm2mContextP->altPath, uriP, uriBufferP);
 #else
-                    responseP->optionList = uri_encode(IOWA_COAP_OPTION_LOCATION_PATH, uriP, uriBufferP);
+                    responseP->optionList = uri_encode(contextP, IOWA_COAP_OPTION_LOCATION_PATH, uriP, uriBufferP);
 #endif // LWM2M_ALTPATH_SUPPORT
                     if (responseP->optionList == NULL)
                     {
@@ -369,6 +900,21 @@ void dm_handleRequest(iowa_context_t contextP,
                 result = observe_setParameters(contextP, uriP, serverP);
             }
         }
+#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+        else if (block1P != NULL)
+        {
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+            if (block1P->number == IOWA_COAP_OPTION_Q_BLOCK_1)
+            {
+                result = prv_writeQBlock(contextP, uriP, serverP, messageP, block1P, requestFormat, responseP);
+            }
+            else
+#endif
+            {
+                result = prv_writeBlock(contextP, uriP, serverP, messageP, block1P, requestFormat, responseP);
+            }
+        }
+#endif
         else if (LWM2M_URI_IS_SET_INSTANCE(uriP))
         {
             result = object_checkWritePayload(contextP, dataCount, dataP);
@@ -442,9 +988,39 @@ error:
         if (result != IOWA_COAP_CODE_EMPTY
             || messageP->type == IOWA_COAP_TYPE_CONFIRMABLE)
         {
+            uint8_t sendResult;
+
             responseP->code = result;
 
-            if (IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE == coapSend(contextP, serverP->runtime.peerP, responseP, NULL, NULL))
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+            if (responseP->payload.length != 0
+                && iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_Q_BLOCK_2) != NULL)
+            {
+                // Send the block asked by the Server, followed by the rest of its set
+                sendResult = coapQBlock2SendResponse(contextP, serverP->runtime.peerP, messageP, responseP);
+            }
+            else
+#endif
+            {
+#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+                if (responseP->payload.length != 0)
+                {
+                    uint8_t blockResult;
+
+                    // Send only the block asked by the Server or the first one of a too large payload
+                    blockResult = coapBlockPrepareResponse(contextP, serverP->runtime.peerP, messageP, responseP);
+                    if (blockResult != IOWA_COAP_NO_ERROR)
+                    {
+                        coreBufferClear(&(responseP->payload));
+                        responseP->code = blockResult;
+                    }
+                }
+#endif
+
+                sendResult = coapSend(contextP, serverP->runtime.peerP, responseP, NULL, NULL);
+            }
+
+            if (IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE == sendResult)
             {
                 // an error message was sent back to the LwM2M Server
                 // if the request was an Observation, remove it.
@@ -459,7 +1035,7 @@ error:
                     // Memorize previous observe
                     observedP = serverP->runtime.observedList->next;
                     // Delete last observe
-                    observe_delete(serverP->runtime.observedList);
+                    observe_delete(contextP, serverP->runtime.observedList);
                     serverP->runtime.observedList = observedP;
                 }
             }
@@ -136,12 +136,284 @@ static iowa_status_t prv_getResourceDimension(iowa_context_t contextP,
     return result;
 }
 
+// Find the position of an Object in the Object array sorted by ID.
+// Returned value: the index of the Object if present, the index where to insert it otherwise.
+// Parameters:
+// - lwm2mContextP: the LwM2M context.
+// - objectID: the ID of the Object.
+static uint16_t prv_searchObject(lwm2m_context_t *lwm2mContextP,
+                                 uint16_t objectID)
+{
+    uint16_t low;
+    uint16_t high;
+
+    low = 0;
+    high = lwm2mContextP->objectCount;
+    while (low < high)
+    {
+        uint16_t middle;
+
+        middle = (uint16_t)(low + (high - low) / 2);
+        if (lwm2mContextP->objectArray[middle]->objID < objectID)
+        {
+            low = (uint16_t)(middle + 1);
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+// Find the position of an instance in the instance array sorted by ID.
+// Returned value: the index of the instance if present, the index where to insert it otherwise.
+// Parameters:
+// - objectP: the Object.
+// - id: the ID of the instance.
+static uint16_t prv_searchInstance(lwm2m_object_t *objectP,
+                                   uint16_t id)
+{
+    uint16_t low;
+    uint16_t high;
+
+    low = 0;
+    high = objectP->instanceCount;
+    while (low < high)
+    {
+        uint16_t middle;
+
+        middle = (uint16_t)(low + (high - low) / 2);
+        if (objectP->instanceArray[middle].id < id)
+        {
+            low = (uint16_t)(middle + 1);
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+// Find a resource in the resource array of an Object sorted by ID.
+// Returned value: the index of the resource or objectP->resourceCount if not found.
+// Parameters:
+// - objectP: the Object.
+// - id: the ID of the resource.
+static uint16_t prv_searchResource(lwm2m_object_t *objectP,
+                                   uint16_t id)
+{
+    uint16_t low;
+    uint16_t high;
+
+    low = 0;
+    high = objectP->resourceCount;
+    while (low < high)
+    {
+        uint16_t middle;
+
+        middle = (uint16_t)(low + (high - low) / 2);
+        if (objectP->resourceArray[middle].id < id)
+        {
+            low = (uint16_t)(middle + 1);
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    if (low < objectP->resourceCount
+        && objectP->resourceArray[low].id == id)
+    {
+        return low;
+    }
+
+    return objectP->resourceCount;
+}
+
+// Check if an ID is present in a sorted array of IDs.
+// Returned value: true if the ID is present.
+// Parameters:
+// - idArray, idCount: the sorted array of IDs.
+// - id: the ID to look for.
+static bool prv_hasId(uint16_t *idArray,
+                      uint16_t idCount,
+                      uint16_t id)
+{
+    uint16_t low;
+    uint16_t high;
+
+    low = 0;
+    high = idCount;
+    while (low < high)
+    {
+        uint16_t middle;
+
+        middle = (uint16_t)(low + (high - low) / 2);
+        if (idArray[middle] < id)
+        {
+            low = (uint16_t)(middle + 1);
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low < idCount && idArray[low] == id;
+}
+
+// Sort an array of IDs. The arrays are small and usually already sorted so an insertion sort is used.
+// Parameters:
+// - idArray, idCount: the array of IDs.
+static void prv_sortIds(uint16_t *idArray,
+                        uint16_t idCount)
+{
+    uint16_t i;
+
+    for (i = 1; i < idCount; i++)
+    {
+        uint16_t id;
+        uint16_t j;
+
+        id = idArray[i];
+        j = i;
+        while (j > 0
+               && idArray[j - 1] > id)
+        {
+            idArray[j] = idArray[j - 1];
+            j--;
+        }
+        idArray[j] = id;
+    }
+}
+
+// Sort the resource descriptors of an Object by ID.
+// Parameters:
+// - objectP: the Object.
+static void prv_sortResources(lwm2m_object_t *objectP)
+{
+    uint16_t i;
+
+    for (i = 1; i < objectP->resourceCount; i++)
+    {
+        iowa_lwm2m_resource_desc_t resource;
+        uint16_t j;
+
+        resource = objectP->resourceArray[i];
+        j = i;
+        while (j > 0
+               && objectP->resourceArray[j - 1].id > resource.id)
+        {
+            objectP->resourceArray[j] = objectP->resourceArray[j - 1];
+            j--;
+        }
+        objectP->resourceArray[j] = resource;
+    }
+}
+
+// Sort the instances of an Object by ID.
+// Parameters:
+// - objectP: the Object.
+static void prv_sortInstances(lwm2m_object_t *objectP)
+{
+    uint16_t i;
+
+    for (i = 1; i < objectP->instanceCount; i++)
+    {
+        lwm2m_instance_details_t instance;
+        uint16_t j;
+
+        instance = objectP->instanceArray[i];
+        j = i;
+        while (j > 0
+               && objectP->instanceArray[j - 1].id > instance.id)
+        {
+            objectP->instanceArray[j] = objectP->instanceArray[j - 1];
+            j--;
+        }
+        objectP->instanceArray[j] = instance;
+    }
+}
+
+// Insert an Object in the Object array sorted by ID.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - lwm2mContextP: the LwM2M context.
+// - objectP: the Object to insert.
+static iowa_status_t prv_objectArrayAdd(lwm2m_context_t *lwm2mContextP,
+                                        lwm2m_object_t *objectP)
+{
+    lwm2m_object_t **newArray;
+    uint16_t index;
+
+    index = prv_searchObject(lwm2mContextP, objectP->objID);
+
+    newArray = (lwm2m_object_t **)iowa_system_malloc((size_t)(lwm2mContextP->objectCount + 1) * sizeof(lwm2m_object_t *));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (newArray == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC((size_t)(lwm2mContextP->objectCount + 1) * sizeof(lwm2m_object_t *));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    if (index != 0)
+    {
+        memcpy(newArray, lwm2mContextP->objectArray, index * sizeof(lwm2m_object_t *));
+    }
+    newArray[index] = objectP;
+    if (index != lwm2mContextP->objectCount)
+    {
+        memcpy(newArray + index + 1, lwm2mContextP->objectArray + index, (size_t)(lwm2mContextP->objectCount - index) * sizeof(lwm2m_object_t *));
+    }
+
+    iowa_system_free(lwm2mContextP->objectArray);
+    lwm2mContextP->objectArray = newArray;
+    lwm2mContextP->objectCount++;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Remove an Object from the Object array sorted by ID.
+// Parameters:
+// - lwm2mContextP: the LwM2M context.
+// - objectID: the ID of the Object to remove.
+static void prv_objectArrayRemove(lwm2m_context_t *lwm2mContextP,
+                                  uint16_t objectID)
+{
+    uint16_t index;
+
+    index = prv_searchObject(lwm2mContextP, objectID);
+    if (index == lwm2mContextP->objectCount
+        || lwm2mContextP->objectArray[index]->objID != objectID)
+    {
+        return;
+    }
+
+    // The array is only shrunk when it becomes empty
+    lwm2mContextP->objectCount--;
+    if (lwm2mContextP->objectCount == 0)
+    {
+        iowa_system_free(lwm2mContextP->objectArray);
+        lwm2mContextP->objectArray = NULL;
+    }
+    else if (index != lwm2mContextP->objectCount)
+    {
+        memmove(lwm2mContextP->objectArray + index, lwm2mContextP->objectArray + index + 1, (size_t)(lwm2mContextP->objectCount - index) * sizeof(lwm2m_object_t *));
+    }
+}
+
 static iowa_status_t prv_addInstance(lwm2m_object_t *objectP,
                                      uint16_t id,
                                      uint16_t resourceCount,
                                      uint16_t *resourceArray)
 {
     lwm2m_instance_details_t *newArray;
+    uint16_t index;
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Adding instance %u with %u resources to Object %u.", id, resourceCount, objectP->objID);
 
@@ -158,28 +430,38 @@ static iowa_status_t prv_addInstance(lwm2m_object_t *objectP,
         return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
     }
 #endif
-    if (objectP->instanceCount != 0)
-    {
-        memcpy(newArray, objectP->instanceArray, objectP->instanceCount * sizeof(lwm2m_instance_details_t));
-    }
-    newArray[objectP->instanceCount].id = id;
-    newArray[objectP->instanceCount].resCount = resourceCount;
+
+    // Keep the instances sorted by ID
+    index = prv_searchInstance(objectP, id);
+
+    newArray[index].id = id;
+    newArray[index].resCount = resourceCount;
     if (resourceCount != 0)
     {
-        newArray[objectP->instanceCount].resArray = (uint16_t *)iowa_system_malloc(resourceCount * sizeof(uint16_t));
+        newArray[index].resArray = (uint16_t *)iowa_system_malloc(resourceCount * sizeof(uint16_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-        if (newArray[objectP->instanceCount].resArray == NULL)
+        if (newArray[index].resArray == NULL)
         {
             iowa_system_free(newArray);
             IOWA_LOG_ERROR_MALLOC(resourceCount * sizeof(uint16_t));
             return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
 #endif
-        memcpy(newArray[objectP->instanceCount].resArray, resourceArray, resourceCount * sizeof(uint16_t));
+        memcpy(newArray[index].resArray, resourceArray, resourceCount * sizeof(uint16_t));
+        prv_sortIds(newArray[index].resArray, resourceCount);
     }
     else
     {
-        newArray[objectP->instanceCount].resArray = NULL;
+        newArray[index].resArray = NULL;
+    }
+
+    if (index != 0)
+    {
+        memcpy(newArray, objectP->instanceArray, index * sizeof(lwm2m_instance_details_t));
+    }
+    if (index != objectP->instanceCount)
+    {
+        memcpy(newArray + index + 1, objectP->instanceArray + index, (size_t)(objectP->instanceCount - index) * sizeof(lwm2m_instance_details_t));
     }
 
     iowa_system_free(objectP->instanceArray);
@@ -192,20 +474,17 @@ static iowa_status_t prv_addInstance(lwm2m_object_t *objectP,
 static uint16_t prv_getNewInstanceId(lwm2m_object_t *objectP)
 {
     uint16_t instanceId;
-    size_t i;
+    uint16_t i;
 
+    // The instances are sorted by ID: look for the first gap
     instanceId = 0;
-    i = 0;
-    while (i < objectP->instanceCount)
+    for (i = 0; i < objectP->instanceCount; i++)
     {
-        for (i = 0; i < objectP->instanceCount; i++)
+        if (objectP->instanceArray[i].id != instanceId)
         {
-            if (objectP->instanceArray[i].id == instanceId)
-            {
-                instanceId++;
-                break;
-            }
+            break;
         }
+        instanceId++;
     }
 
     return instanceId;
@@ -280,42 +559,26 @@ static uint16_t prv_getResourceIndex(lwm2m_object_t *objectP,
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Looking for resource %u in Object %u, instance index: %u.", id, objectP->objID, instIndex);
 
-    for (index = 0; index < objectP->resourceCount; index++)
-    {
-        if (objectP->resourceArray[index].id == id)
-        {
-            IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Resource %u found at index %u in Object %u.", id, index, objectP->objID);
-            break;
-        }
-    }
+    index = prv_searchResource(objectP, id);
     if (index == objectP->resourceCount)
     {
         IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Resource %u does not exist in Object %u.", id, objectP->objID);
         return objectP->resourceCount;
     }
 
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Resource %u found at index %u in Object %u.", id, index, objectP->objID);
+
     if (instIndex < objectP->instanceCount
         && objectP->instanceArray[instIndex].resArray != NULL)
     {
-        uint16_t i;
-
         // check if resource exists in this instance
-        for (i = 0; i < objectP->instanceArray[instIndex].resCount; i++)
-        {
-            if (objectP->instanceArray[instIndex].resArray[i] == id)
-            {
-                break;
-            }
-        }
-        if (i == objectP->instanceArray[instIndex].resCount)
+        if (prv_hasId(objectP->instanceArray[instIndex].resArray, objectP->instanceArray[instIndex].resCount, id) == false)
         {
             IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Resource %u not found in Object %u, instance index: %u.", id, objectP->objID, instIndex);
             index = objectP->resourceCount;
         }
     }
 
-    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Resource %u not found in Object %u.", id, objectP->objID);
-
     return index;
 }
 
@@ -369,16 +632,7 @@ static iowa_status_t prv_addResourceToDataArray(iowa_context_t contextP,
 
     if (objectP->instanceArray[instIndex].resArray != NULL)
     {
-        uint16_t i;
-
-        for (i = 0; i < objectP->instanceArray[instIndex].resCount; i++)
-        {
-            if (objectP->instanceArray[instIndex].resArray[i] == objectP->resourceArray[resIndex].id)
-            {
-                break;
-            }
-        }
-        if (i == objectP->instanceArray[instIndex].resCount)
+        if (prv_hasId(objectP->instanceArray[instIndex].resArray, objectP->instanceArray[instIndex].resCount, objectP->resourceArray[resIndex].id) == false)
         {
             IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Resource %u not found in Object %u, instance %u.", objectP->resourceArray[resIndex].id, objectP->objID, objectP->instanceArray[instIndex].id);
             return IOWA_COAP_404_NOT_FOUND;
@@ -759,7 +1013,11 @@ static iowa_status_t prv_checkDataConsistency(iowa_lwm2m_data_t *dataP,
 
     type = dataP->type;
 
-    if (type != objectP->resourceArray[resourceIndex].type)
+    // Streamable resources are also written block by block
+    if (type != objectP->resourceArray[resourceIndex].type
+        && (!DATA_IS_BLOCK(type)
+            || !IS_RSC_STREAMABLE(objectP->resourceArray[resourceIndex])
+            || type != INTERNAL_LWM2M_TYPE_BLOCK + objectP->resourceArray[resourceIndex].type))
     {
         IOWA_LOG_INFO(IOWA_PART_LWM2M, "Data type mismatch.");
         return IOWA_COAP_406_NOT_ACCEPTABLE;
@@ -999,12 +1257,16 @@ static iowa_status_t prv_create(iowa_context_t contextP,
                     }
                 }
             }
+            SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBJECTS);
             result = prv_addInstance(objectP, dataP[0].instanceID, resCount, resArray);
+            SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
             iowa_system_free(resArray);
         }
         else
         {
+            SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBJECTS);
             result = prv_addInstance(objectP, dataP[0].instanceID, 0, NULL);
+            SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
         }
     }
 
@@ -1085,7 +1347,9 @@ static iowa_status_t prv_deleteObjectInstance(iowa_context_t contextP,
         return result;
     }
 
+    SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBJECTS);
     (void)prv_removeInstance(objectP, uriP->instanceId);
+    SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
     observe_clear(contextP, uriP);
 
     return IOWA_COAP_202_DELETED;
@@ -1161,13 +1425,15 @@ iowa_status_t object_getInstanceIndex(lwm2m_object_t *objectP,
     }
     else
     {
-        for (index = 0; index < objectP->instanceCount; index++)
+        index = prv_searchInstance(objectP, id);
+        if (index < objectP->instanceCount
+            && objectP->instanceArray[index].id == id)
         {
-            if (objectP->instanceArray[index].id == id)
-            {
-                IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Instance %u found at index %u in Object %u.", id, index, objectP->objID);
-                break;
-            }
+            IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Instance %u found at index %u in Object %u.", id, index, objectP->objID);
+        }
+        else
+        {
+            index = objectP->instanceCount;
         }
     }
 
@@ -1184,6 +1450,21 @@ iowa_status_t object_getInstanceIndex(lwm2m_object_t *objectP,
     return IOWA_COAP_NO_ERROR;
 }
 
+lwm2m_object_t * object_lookup(iowa_context_t contextP,
+                               uint16_t objectID)
+{
+    uint16_t index;
+
+    index = prv_searchObject(contextP->lwm2mContextP, objectID);
+    if (index == contextP->lwm2mContextP->objectCount
+        || contextP->lwm2mContextP->objectArray[index]->objID != objectID)
+    {
+        return NULL;
+    }
+
+    return contextP->lwm2mContextP->objectArray[index];
+}
+
 iowa_status_t object_find(iowa_context_t contextP,
                           uint16_t objectID,
                           uint16_t instanceID,
@@ -1198,7 +1479,7 @@ iowa_status_t object_find(iowa_context_t contextP,
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Looking for /%u/%u/%u.", objectID, instanceID, resourceID);
 
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectID);
+    objectP = object_lookup(contextP, objectID);
     if (NULL == objectP)
     {
         IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", objectID);
@@ -1306,7 +1587,7 @@ iowa_status_t object_getTargets(iowa_context_t contextP,
     }
     else
     {
-        *startPP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectId);
+        *startPP = object_lookup(contextP, objectId);
         if (*startPP == NULL)
         {
             IOWA_LOG_ARG_ERROR(IOWA_PART_LWM2M, "Object with ID %u not found.", objectId);
@@ -1451,6 +1732,82 @@ iowa_status_t object_read(iowa_context_t contextP,
     return result;
 }
 
+iowa_status_t object_readBlock(iowa_context_t contextP,
+                               iowa_lwm2m_uri_t *uriP,
+                               uint16_t serverShortId,
+                               uint32_t blockInfo,
+                               size_t *dataCountP,
+                               iowa_lwm2m_data_t **dataArrayP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    lwm2m_object_t *objectP;
+    uint16_t resIndex;
+
+    (void)serverShortId;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "URI: /%u/%u/%u/%u, block: 0x%06X", uriP->objectId, uriP->instanceId, uriP->resourceId, uriP->resInstanceId, blockInfo);
+
+    *dataCountP = 0;
+    *dataArrayP = NULL;
+
+    result = object_find(contextP, uriP->objectId, uriP->instanceId, uriP->resourceId, &objectP, NULL, &resIndex);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_INFO(IOWA_PART_LWM2M, "URI not found.");
+        return result;
+    }
+
+    if (!IS_RSC_READABLE(objectP->resourceArray[resIndex]))
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Resource %u is not readable.", uriP->resourceId);
+        return IOWA_COAP_405_METHOD_NOT_ALLOWED;
+    }
+
+    if (!IS_RSC_STREAMABLE(objectP->resourceArray[resIndex])
+        || (IS_RSC_MULTIPLE(objectP->resourceArray[resIndex])
+            && uriP->resInstanceId == IOWA_LWM2M_ID_ALL))
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Resource %u can not be read by blocks.", uriP->resourceId);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    *dataArrayP = (iowa_lwm2m_data_t *)iowa_system_malloc(sizeof(iowa_lwm2m_data_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*dataArrayP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(iowa_lwm2m_data_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(*dataArrayP, 0, sizeof(iowa_lwm2m_data_t));
+    *dataCountP = 1;
+
+    (*dataArrayP)->objectID = uriP->objectId;
+    (*dataArrayP)->instanceID = uriP->instanceId;
+    (*dataArrayP)->resourceID = uriP->resourceId;
+    (*dataArrayP)->resInstanceID = uriP->resInstanceId;
+    (*dataArrayP)->type = INTERNAL_LWM2M_TYPE_BLOCK + objectP->resourceArray[resIndex].type;
+    (*dataArrayP)->value.asBlock.details = blockInfo;
+
+    result = prv_callDataCb(contextP, IOWA_DM_READ, objectP, *dataCountP, *dataArrayP);
+
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = IOWA_COAP_205_CONTENT;
+    }
+    else
+    {
+        object_free(contextP, *dataCountP, *dataArrayP);
+        iowa_system_free(*dataArrayP);
+        *dataArrayP = NULL;
+        *dataCountP = 0;
+    }
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Exiting with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+    return result;
+}
+
 void object_free(iowa_context_t contextP,
                  size_t dataCount,
                  iowa_lwm2m_data_t *dataP)
@@ -1469,7 +1826,7 @@ void object_free(iowa_context_t contextP,
     }
 
     objectId = dataP[0].objectID;
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectId);
+    objectP = object_lookup(contextP, objectId);
     if (objectP == NULL)
     {
         IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", objectId);
@@ -1484,7 +1841,7 @@ void object_free(iowa_context_t contextP,
             startInd = ind;
 
             objectId = dataP[ind].objectID;
-            objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectId);
+            objectP = object_lookup(contextP, objectId);
             if (objectP == NULL)
             {
                 IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", objectId);
@@ -1522,7 +1879,7 @@ iowa_status_t object_checkWritePayload(iowa_context_t contextP,
         uint16_t resourceIndex;  // index of a Resource inside a lwm2m_object_t
         size_t instIndex;        // index of the first data_t matching the beginning of an Object Instance in dataArray
 
-        objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &dataArray[dataIndex].objectID);
+        objectP = object_lookup(contextP, dataArray[dataIndex].objectID);
         if (NULL == objectP)
         {
             IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", dataArray[dataIndex].objectID);
@@ -1627,7 +1984,7 @@ iowa_status_t object_write(iowa_context_t contextP,
         if (objectP == NULL
             || objectP->objID != dataP[i].objectID)
         {
-            objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &dataP[i].objectID);
+            objectP = object_lookup(contextP, dataP[i].objectID);
             if (NULL == objectP)
             {
                 IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", dataP[i].objectID);
@@ -1747,7 +2104,7 @@ iowa_status_t object_create(iowa_context_t contextP,
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object ID: %u.", dataP[0].objectID);
 
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &dataP[0].objectID);
+    objectP = object_lookup(contextP, dataP[0].objectID);
     if (NULL == objectP)
     {
         IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", dataP[0].objectID);
@@ -1786,7 +2143,7 @@ iowa_status_t object_delete(iowa_context_t contextP,
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "URI: /%u/%u/%u", uriP->objectId, uriP->instanceId, uriP->resourceId);
 
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &uriP->objectId);
+    objectP = object_lookup(contextP, uriP->objectId);
     if (NULL == objectP)
     {
         IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", uriP->objectId);
@@ -1972,7 +2329,7 @@ iowa_status_t object_getTree(iowa_context_t contextP,
 #endif
 
     // Count the number of link.
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &uriP->objectId);
+    objectP = object_lookup(contextP, uriP->objectId);
     if (objectP == NULL)
     {
         IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", uriP->objectId);
@@ -2242,7 +2599,7 @@ iowa_status_t customObjectAdd(iowa_context_t contextP,
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Adding new custom object with ID: %u, instanceCount: %u and resourceCount: %u", objectID, instanceCount, resourceCount);
 
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectID);
+    objectP = object_lookup(contextP, objectID);
     if (objectP != NULL)
     {
         IOWA_LOG_ARG_ERROR(IOWA_PART_LWM2M, "Object %u already exists.", objectID);
@@ -2323,6 +2680,7 @@ iowa_status_t customObjectAdd(iowa_context_t contextP,
                         }
 #endif
                         memcpy(objectP->instanceArray[i].resArray, ((lwm2m_instance_details_t *)instanceIDs)[i].resArray, objectP->instanceArray[i].resCount * sizeof(uint16_t));
+                        prv_sortIds(objectP->instanceArray[i].resArray, objectP->instanceArray[i].resCount);
                     }
                     else
                     {
@@ -2336,6 +2694,7 @@ iowa_status_t customObjectAdd(iowa_context_t contextP,
                 }
             }
             objectP->instanceCount = instanceCount;
+            prv_sortInstances(objectP);
         }
     }
 
@@ -2348,6 +2707,7 @@ iowa_status_t customObjectAdd(iowa_context_t contextP,
     objectP->userData = userData;
 
     memcpy(objectP->resourceArray, resourceArray, resourceCount * sizeof(iowa_lwm2m_resource_desc_t));
+    prv_sortResources(objectP);
 
     switch (objectID)
     {
@@ -2357,7 +2717,15 @@ iowa_status_t customObjectAdd(iowa_context_t contextP,
         objectP->version.minor = PRV_DEFAULT_MINOR_OBJECT_VERSION;
         break;
     }
+    SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBJECTS);
+    if (prv_objectArrayAdd(contextP->lwm2mContextP, objectP) != IOWA_COAP_NO_ERROR)
+    {
+        SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
+        customObjectDelete(objectP);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
     contextP->lwm2mContextP->objectList = (lwm2m_object_t *)IOWA_UTILS_LIST_ADD(contextP->lwm2mContextP->objectList, objectP);
+    SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
 
     if (contextP->lwm2mContextP->state == STATE_DEVICE_MANAGEMENT)
     {
@@ -2399,7 +2767,10 @@ iowa_status_t customObjectRemove(iowa_context_t contextP,
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Removing custom object with ID: %u", objectID);
 
+    SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBJECTS);
     contextP->lwm2mContextP->objectList = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND_AND_REMOVE(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectID, &objectP);
+    prv_objectArrayRemove(contextP->lwm2mContextP, objectID);
+    SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
     if (objectP == NULL)
     {
         IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Object ID %u not found.", objectID);
@@ -2457,7 +2828,7 @@ iowa_status_t objectAddInstance(iowa_context_t contextP,
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Adding instance %u to Object %u. ", instanceID, objectID);
 
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectID);
+    objectP = object_lookup(contextP, objectID);
     if (NULL == objectP)
     {
         IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", objectID);
@@ -2471,14 +2842,18 @@ iowa_status_t objectAddInstance(iowa_context_t contextP,
         break;
 
     case OBJECT_MULTIPLE:
+        SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBJECTS);
         result = prv_addInstance(objectP, instanceID, 0, NULL);
+        SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
         break;
 
     case OBJECT_MULTIPLE_ADVANCED:
         if (resourceCount != 0
             && resourceArray != NULL)
         {
+            SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBJECTS);
             result = prv_addInstance(objectP, instanceID, resourceCount, resourceArray);
+            SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
         }
         else
         {
@@ -2514,14 +2889,16 @@ iowa_status_t objectRemoveInstance(iowa_context_t contextP,
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Removing instance %u of Object %u. ", instanceID, objectID);
 
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectID);
+    objectP = object_lookup(contextP, objectID);
     if (NULL == objectP)
     {
         IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Object %u not found.", objectID);
         return IOWA_COAP_404_NOT_FOUND;
     }
 
+    SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBJECTS);
     result = prv_removeInstance(objectP, instanceID);
+    SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
 
     if (result == IOWA_COAP_NO_ERROR
         && contextP->lwm2mContextP->state == STATE_DEVICE_MANAGEMENT)
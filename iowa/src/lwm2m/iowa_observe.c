@@ -84,6 +84,9 @@
 // Note: used it only as condition (if, while ...)
 #define PRV_OBSERVE_MATCH_TOKEN(OBS,MSG) ((MSG->tokenLength == OBS->tokenLen) && (memcmp(MSG->token, OBS->token, OBS->tokenLen) == 0))
 
+// Number of free entries added when the observation index grows
+#define LWM2M_OBSERVE_INDEX_GROWTH 8
+
 static void prv_notificationCallback(iowa_coap_peer_t *fromPeer,
                                      uint8_t status,
                                      iowa_coap_message_t * requestP,
@@ -126,6 +129,378 @@ static bool prv_notificationMatch(lwm2m_observed_t * observedP,
     return false;
 }
 
+// Compare an entry of the observation index with a key on its first IDs.
+// Returned value: a negative value if the entry is lower than the key, 0 if equal, a positive value if greater.
+// Parameters:
+// - entryP: the index entry.
+// - objectId, instanceId, resourceId: the key.
+// - depth: the number of IDs to compare, from 1 (Object ID only) to 3.
+static int prv_indexCompare(const lwm2m_observe_index_entry_t *entryP,
+                            uint16_t objectId,
+                            uint16_t instanceId,
+                            uint16_t resourceId,
+                            uint8_t depth)
+{
+    if (entryP->objectId != objectId)
+    {
+        return (entryP->objectId < objectId) ? -1 : 1;
+    }
+    if (depth > 1
+        && entryP->instanceId != instanceId)
+    {
+        return (entryP->instanceId < instanceId) ? -1 : 1;
+    }
+    if (depth > 2
+        && entryP->resourceId != resourceId)
+    {
+        return (entryP->resourceId < resourceId) ? -1 : 1;
+    }
+
+    return 0;
+}
+
+// Find the entries of the observation index matching a key.
+// Parameters:
+// - lwm2mContextP: the LwM2M context.
+// - objectId, instanceId, resourceId, depth: the key. See prv_indexCompare().
+// - startP: OUT. the index of the first matching entry.
+// - endP: OUT. the index following the last matching entry.
+static void prv_indexFindRange(lwm2m_context_t *lwm2mContextP,
+                               uint16_t objectId,
+                               uint16_t instanceId,
+                               uint16_t resourceId,
+                               uint8_t depth,
+                               size_t *startP,
+                               size_t *endP)
+{
+    size_t low;
+    size_t high;
+
+    low = 0;
+    high = lwm2mContextP->observeIndexCount;
+    while (low < high)
+    {
+        size_t middle;
+
+        middle = low + (high - low) / 2;
+        if (prv_indexCompare(lwm2mContextP->observeIndexArray + middle, objectId, instanceId, resourceId, depth) < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    *startP = low;
+
+    high = lwm2mContextP->observeIndexCount;
+    while (low < high)
+    {
+        size_t middle;
+
+        middle = low + (high - low) / 2;
+        if (prv_indexCompare(lwm2mContextP->observeIndexArray + middle, objectId, instanceId, resourceId, depth) <= 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    *endP = low;
+}
+
+// Add the URIs of an observation to the observation index.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - observedP: the observation.
+static iowa_status_t prv_indexAdd(iowa_context_t contextP,
+                                  lwm2m_observed_t *observedP)
+{
+    lwm2m_context_t *lwm2mContextP;
+    size_t ind;
+
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    if (lwm2mContextP->observeIndexCount + observedP->uriCount > lwm2mContextP->observeIndexSize)
+    {
+        lwm2m_observe_index_entry_t *newArray;
+        size_t newSize;
+
+        newSize = lwm2mContextP->observeIndexCount + observedP->uriCount + LWM2M_OBSERVE_INDEX_GROWTH;
+
+        newArray = (lwm2m_observe_index_entry_t *)iowa_system_malloc(newSize * sizeof(lwm2m_observe_index_entry_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (newArray == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(newSize * sizeof(lwm2m_observe_index_entry_t));
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+        if (lwm2mContextP->observeIndexCount != 0)
+        {
+            memcpy(newArray, lwm2mContextP->observeIndexArray, lwm2mContextP->observeIndexCount * sizeof(lwm2m_observe_index_entry_t));
+        }
+        iowa_system_free(lwm2mContextP->observeIndexArray);
+        lwm2mContextP->observeIndexArray = newArray;
+        lwm2mContextP->observeIndexSize = newSize;
+    }
+
+    for (ind = 0; ind < observedP->uriCount; ind++)
+    {
+        iowa_lwm2m_uri_t *uriP;
+        size_t start;
+        size_t end;
+
+        uriP = &(observedP->uriInfoP[ind].uri);
+
+        // Insert after the entries with the same key
+        prv_indexFindRange(lwm2mContextP, uriP->objectId, uriP->instanceId, uriP->resourceId, 3, &start, &end);
+
+        memmove(lwm2mContextP->observeIndexArray + end + 1,
+                lwm2mContextP->observeIndexArray + end,
+                (lwm2mContextP->observeIndexCount - end) * sizeof(lwm2m_observe_index_entry_t));
+
+        lwm2mContextP->observeIndexArray[end].objectId = uriP->objectId;
+        lwm2mContextP->observeIndexArray[end].instanceId = uriP->instanceId;
+        lwm2mContextP->observeIndexArray[end].resourceId = uriP->resourceId;
+        lwm2mContextP->observeIndexArray[end].observedP = observedP;
+        lwm2mContextP->observeIndexArray[end].uriIndex = ind;
+        lwm2mContextP->observeIndexCount++;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Remove the URIs of an observation from the observation index.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - observedP: the observation.
+static void prv_indexRemove(iowa_context_t contextP,
+                            lwm2m_observed_t *observedP)
+{
+    lwm2m_context_t *lwm2mContextP;
+    size_t readIndex;
+    size_t writeIndex;
+
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    writeIndex = 0;
+    for (readIndex = 0; readIndex < lwm2mContextP->observeIndexCount; readIndex++)
+    {
+        if (lwm2mContextP->observeIndexArray[readIndex].observedP != observedP)
+        {
+            if (writeIndex != readIndex)
+            {
+                lwm2mContextP->observeIndexArray[writeIndex] = lwm2mContextP->observeIndexArray[readIndex];
+            }
+            writeIndex++;
+        }
+    }
+    lwm2mContextP->observeIndexCount = writeIndex;
+
+    if (lwm2mContextP->observeIndexCount == 0)
+    {
+        iowa_system_free(lwm2mContextP->observeIndexArray);
+        lwm2mContextP->observeIndexArray = NULL;
+        lwm2mContextP->observeIndexSize = 0;
+    }
+}
+
+// Add an observation to the due list if not already present.
+// Parameters:
+// - lwm2mContextP: the LwM2M context.
+// - observedP: the observation.
+static void prv_dueAdd(lwm2m_context_t *lwm2mContextP,
+                       lwm2m_observed_t *observedP)
+{
+    if ((observedP->flags & LWM2M_OBSERVE_FLAG_DUE) == 0)
+    {
+        observedP->flags |= LWM2M_OBSERVE_FLAG_DUE;
+        observedP->dueNext = lwm2mContextP->observeDueList;
+        lwm2mContextP->observeDueList = observedP;
+    }
+}
+
+// Remove an observation from a due list.
+// Returned value: the new head of the list.
+// Parameters:
+// - listP: the due list.
+// - observedP: the observation.
+static lwm2m_observed_t *prv_dueListRemove(lwm2m_observed_t *listP,
+                                           lwm2m_observed_t *observedP)
+{
+    lwm2m_observed_t *parentP;
+
+    if (listP == observedP)
+    {
+        return observedP->dueNext;
+    }
+
+    for (parentP = listP; parentP != NULL; parentP = parentP->dueNext)
+    {
+        if (parentP->dueNext == observedP)
+        {
+            parentP->dueNext = observedP->dueNext;
+            break;
+        }
+    }
+
+    return listP;
+}
+
+// Check if the maximum period of an observation applies.
+// Returned value: true if a notification must be sent when the maximum period elapses.
+// Parameters:
+// - observedP: the observation.
+static bool prv_hasMaxPeriod(lwm2m_observed_t *observedP)
+{
+    if (observedP->timeAttrP == NULL
+        || (observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MAX_PERIOD) == 0)
+    {
+        return false;
+    }
+
+    // Ignore pmax if lesser than pmin
+    return (observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) == 0
+           || observedP->timeAttrP->maxPeriod >= observedP->timeAttrP->minPeriod;
+}
+
+static void prv_pmaxTimerCallback(iowa_context_t contextP,
+                                  void *userData)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_observed_t *observedP;
+
+    observedP = (lwm2m_observed_t *)userData;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Maximum period elapsed for observation %p.", observedP);
+
+    observedP->pmaxTimerP = NULL;
+    prv_dueAdd(contextP->lwm2mContextP, observedP);
+
+    // Process the observation on the next step
+    contextP->timeout = 0;
+}
+
+// Arm the maximum period timer of an observation according to its last notification time.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - observedP: the observation.
+static void prv_schedulePmax(iowa_context_t contextP,
+                             lwm2m_observed_t *observedP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_time_t interval;
+    int32_t delay;
+
+    if (prv_hasMaxPeriod(observedP) == false)
+    {
+        if (observedP->pmaxTimerP != NULL)
+        {
+            coreTimerDelete(contextP, observedP->pmaxTimerP);
+            observedP->pmaxTimerP = NULL;
+        }
+        return;
+    }
+
+    interval = observedP->lastTime + CORE_TIME_FROM_SECONDS(observedP->timeAttrP->maxPeriod) - contextP->currentTime;
+    if (interval <= 0)
+    {
+        if (observedP->pmaxTimerP != NULL)
+        {
+            coreTimerDelete(contextP, observedP->pmaxTimerP);
+            observedP->pmaxTimerP = NULL;
+        }
+        prv_dueAdd(contextP->lwm2mContextP, observedP);
+        contextP->timeout = 0;
+        return;
+    }
+
+    if (interval > CORE_TIME_FROM_SECONDS(CORE_TIME_MAX_DELAY_SECONDS))
+    {
+        delay = CORE_TIME_MAX_DELAY_SECONDS;
+    }
+    else
+    {
+        delay = (int32_t)CORE_TIME_TO_SECONDS_CEIL(interval);
+    }
+
+    if (observedP->pmaxTimerP == NULL)
+    {
+        observedP->pmaxTimerP = coreTimerNew(contextP, delay, prv_pmaxTimerCallback, observedP);
+        if (observedP->pmaxTimerP == NULL)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Failed to create the maximum period timer.");
+        }
+    }
+    else if (coreTimerReset(contextP, observedP->pmaxTimerP, delay) != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Failed to reset the maximum period timer.");
+    }
+}
+
+// Tag the observations of a range of the observation index.
+// Parameters:
+// - lwm2mContextP: the LwM2M context.
+// - start, end: the range of entries.
+// - resourceId: the changed Resource ID or IOWA_LWM2M_ID_ALL.
+static void prv_indexTagRange(lwm2m_context_t *lwm2mContextP,
+                              size_t start,
+                              size_t end,
+                              uint16_t resourceId)
+{
+    size_t ind;
+
+    for (ind = start; ind < end; ind++)
+    {
+        lwm2m_observe_index_entry_t *entryP;
+
+        entryP = lwm2mContextP->observeIndexArray + ind;
+
+        if (resourceId == IOWA_LWM2M_ID_ALL
+            || entryP->resourceId == IOWA_LWM2M_ID_ALL
+            || entryP->resourceId == resourceId)
+        {
+            entryP->observedP->uriInfoP[entryP->uriIndex].flags |= LWM2M_OBSERVE_FLAG_UPDATE;
+            IOWA_LOG_INFO(IOWA_PART_LWM2M, "Tagging the observation.");
+            entryP->observedP->flags |= LWM2M_OBSERVE_FLAG_UPDATE;
+            prv_dueAdd(lwm2mContextP, entryP->observedP);
+        }
+    }
+}
+
+// Tag the observations targeting an Object Instance, or the whole Object if instanceId is IOWA_LWM2M_ID_ALL.
+// Parameters:
+// - lwm2mContextP: the LwM2M context.
+// - objectId, instanceId: the observed Object Instance.
+// - resourceId: the changed Resource ID or IOWA_LWM2M_ID_ALL.
+static void prv_indexTagInstance(lwm2m_context_t *lwm2mContextP,
+                                 uint16_t objectId,
+                                 uint16_t instanceId,
+                                 uint16_t resourceId)
+{
+    size_t start;
+    size_t end;
+
+    if (resourceId == IOWA_LWM2M_ID_ALL)
+    {
+        prv_indexFindRange(lwm2mContextP, objectId, instanceId, resourceId, 2, &start, &end);
+        prv_indexTagRange(lwm2mContextP, start, end, resourceId);
+    }
+    else
+    {
+        prv_indexFindRange(lwm2mContextP, objectId, instanceId, resourceId, 3, &start, &end);
+        prv_indexTagRange(lwm2mContextP, start, end, resourceId);
+
+        prv_indexFindRange(lwm2mContextP, objectId, instanceId, IOWA_LWM2M_ID_ALL, 3, &start, &end);
+        prv_indexTagRange(lwm2mContextP, start, end, resourceId);
+    }
+}
+
 static void prv_callObservationEventCallback(iowa_context_t contextP,
                                              lwm2m_observed_t *targetP,
                                              iowa_event_type_t eventType,
@@ -253,12 +628,25 @@ static void prv_callObservationEventCallback(iowa_context_t contextP,
     }
 }
 
-void observe_delete(lwm2m_observed_t *observedP)
+void observe_delete(iowa_context_t contextP,
+                    lwm2m_observed_t *observedP)
 {
     size_t ind;
 
     IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Delete observe.");
 
+    prv_indexRemove(contextP, observedP);
+
+    if ((observedP->flags & LWM2M_OBSERVE_FLAG_DUE) != 0)
+    {
+        contextP->lwm2mContextP->observeDueList = prv_dueListRemove(contextP->lwm2mContextP->observeDueList, observedP);
+        contextP->lwm2mContextP->observeStepList = prv_dueListRemove(contextP->lwm2mContextP->observeStepList, observedP);
+    }
+    if (observedP->pmaxTimerP != NULL)
+    {
+        coreTimerDelete(contextP, observedP->pmaxTimerP);
+    }
+
     for (ind = 0; ind < observedP->uriCount; ind++)
     {
         iowa_system_free(observedP->uriInfoP[ind].uriAttrP);
@@ -268,7 +656,8 @@ void observe_delete(lwm2m_observed_t *observedP)
     iowa_system_free(observedP);
 }
 
-void observeRemoveFromServer(lwm2m_server_t *serverP)
+void observeRemoveFromServer(iowa_context_t contextP,
+                             lwm2m_server_t *serverP)
 {
     IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Clearing observe list.");
 
@@ -277,7 +666,7 @@ void observeRemoveFromServer(lwm2m_server_t *serverP)
         lwm2m_observed_t *observedP;
 
         observedP = serverP->runtime.observedList->next;
-        observe_delete(serverP->runtime.observedList);
+        observe_delete(contextP, serverP->runtime.observedList);
         serverP->runtime.observedList = observedP;
     }
 }
@@ -434,7 +823,7 @@ static void prv_observeRemove(iowa_context_t contextP,
 
     prv_callObservationEventCallback(contextP, observedP, IOWA_EVENT_OBSERVATION_CANCELED, NULL);
 
-    observe_delete(observedP);
+    observe_delete(contextP, observedP);
 }
 
 iowa_status_t observe_handleRequest(iowa_context_t contextP,
@@ -517,6 +906,9 @@ iowa_status_t observe_handleRequest(iowa_context_t contextP,
         {
             newObserved = false;
 
+            // The URIs are indexed again below
+            prv_indexRemove(contextP, observedP);
+
             // Check if the targets are the same
             if (observedP->uriCount == uriCount)
             {
@@ -618,7 +1010,7 @@ iowa_status_t observe_handleRequest(iowa_context_t contextP,
         {
             if (newObserved == true)
             {
-                observe_delete(observedP);
+                observe_delete(contextP, observedP);
             }
             else
             {
@@ -628,13 +1020,27 @@ iowa_status_t observe_handleRequest(iowa_context_t contextP,
             return result;
         }
 
-        optionP = iowa_coap_option_new(IOWA_COAP_OPTION_OBSERVE);
+        result = prv_indexAdd(contextP, observedP);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            if (newObserved == true)
+            {
+                observe_delete(contextP, observedP);
+            }
+            else
+            {
+                prv_observeRemove(contextP, serverP, observedP);
+            }
+            return result;
+        }
+
+        optionP = iowa_coap_option_new(contextP, IOWA_COAP_OPTION_OBSERVE);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (optionP == NULL)
         {
             if (newObserved == true)
             {
-                observe_delete(observedP);
+                observe_delete(contextP, observedP);
             }
             else
             {
@@ -652,10 +1058,13 @@ iowa_status_t observe_handleRequest(iowa_context_t contextP,
         if (newObserved == true)
         {
             // Add the new observation to the list
+            observedP->serverP = serverP;
             observedP->next = serverP->runtime.observedList;
             serverP->runtime.observedList = observedP;
         }
 
+        prv_schedulePmax(contextP, observedP);
+
         if (eventRequired == true)
         {
             prv_callObservationEventCallback(contextP, observedP, IOWA_EVENT_OBSERVATION_STARTED, NULL);
@@ -725,7 +1134,7 @@ void observe_clear(iowa_context_t contextP,
                 nextP = observedP->next;
 
                 IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Delete observation: %p.", observedP);
-                observe_delete(observedP);
+                observe_delete(contextP, observedP);
                 if (parentP == NULL)
                 {
                     serverP->runtime.observedList = nextP;
@@ -796,6 +1205,7 @@ iowa_status_t observe_setParameters(iowa_context_t contextP,
                 IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to update the observe attributes.");
                 return result;
             }
+            prv_schedulePmax(contextP, observedP);
             prv_callObservationEventCallback(contextP, observedP, IOWA_EVENT_OBSERVATION_STARTED, NULL);
         }
         observedP = observedP->next;
@@ -875,41 +1285,125 @@ static void prv_notificationCallback(iowa_coap_peer_t *fromPeer,
 void lwm2m_resource_value_changed(iowa_context_t contextP,
                                   iowa_lwm2m_uri_t *uriP)
 {
-    lwm2m_server_t *serverP;
+    lwm2m_context_t *lwm2mContextP;
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "URI: /%u/%u/%u", uriP->objectId, uriP->instanceId, uriP->resourceId);
 
-    for (serverP = contextP->lwm2mContextP->serverList; serverP != NULL; serverP = serverP->next)
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    if (uriP->instanceId == IOWA_LWM2M_ID_ALL)
     {
-        lwm2m_observed_t *observedP;
+        size_t start;
+        size_t end;
 
-        for (observedP = serverP->runtime.observedList; observedP != NULL; observedP = observedP->next)
+        // All the observations on the Object are concerned
+        prv_indexFindRange(lwm2mContextP, uriP->objectId, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_ID_ALL, 1, &start, &end);
+        prv_indexTagRange(lwm2mContextP, start, end, uriP->resourceId);
+    }
+    else
+    {
+        // Observations on the Object Instance then on the whole Object
+        prv_indexTagInstance(lwm2mContextP, uriP->objectId, uriP->instanceId, uriP->resourceId);
+        prv_indexTagInstance(lwm2mContextP, uriP->objectId, IOWA_LWM2M_ID_ALL, uriP->resourceId);
+    }
+}
+
+#ifdef IOWA_THREAD_SUPPORT
+void lwm2m_resource_value_changed_queue(iowa_context_t contextP,
+                                        iowa_lwm2m_uri_t *uriP)
+{
+    // WARNING: This function is called outside of the critical section
+    lwm2m_context_t *lwm2mContextP;
+    size_t i;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "URI: /%u/%u/%u", uriP->objectId, uriP->instanceId, uriP->resourceId);
+
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBSERVATIONS);
+    for (i = 0; i < lwm2mContextP->changeCount; i++)
+    {
+        if (LWM2M_URI_ARE_EQUAL(&(lwm2mContextP->changeArray[i]), uriP))
         {
-            size_t ind;
+            break;
+        }
+    }
+    if (i == lwm2mContextP->changeCount)
+    {
+        if (lwm2mContextP->changeCount < IOWA_RESOURCE_CHANGE_QUEUE_SIZE)
+        {
+            lwm2mContextP->changeArray[lwm2mContextP->changeCount] = *uriP;
+            lwm2mContextP->changeCount++;
+        }
+        else
+        {
+            // All the observations will be tagged on the next step
+            lwm2mContextP->changeOverflow = true;
+        }
+    }
+    SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBSERVATIONS);
 
-            for (ind = 0; ind < observedP->uriCount; ind++)
+    INTERRUPT_SELECT(contextP);
+}
+
+void lwm2m_resource_value_changed_flush(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_context_t *lwm2mContextP;
+    iowa_lwm2m_uri_t changeArray[IOWA_RESOURCE_CHANGE_QUEUE_SIZE];
+    size_t changeCount;
+    bool changeOverflow;
+    size_t i;
+
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    // The Objects lock is taken first so that the changes of an ongoing IPSO sensor update are flushed together
+    SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBJECTS);
+    SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBSERVATIONS);
+    changeCount = lwm2mContextP->changeCount;
+    if (changeCount != 0)
+    {
+        memcpy(changeArray, lwm2mContextP->changeArray, changeCount * sizeof(iowa_lwm2m_uri_t));
+    }
+    changeOverflow = lwm2mContextP->changeOverflow;
+    lwm2mContextP->changeCount = 0;
+    lwm2mContextP->changeOverflow = false;
+    SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBSERVATIONS);
+    SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
+
+    if (changeOverflow == true)
+    {
+        lwm2m_server_t *serverP;
+
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Resource change queue overflowed. Tagging all the observations.");
+
+        for (serverP = lwm2mContextP->serverList; serverP != NULL; serverP = serverP->next)
+        {
+            lwm2m_observed_t *observedP;
+
+            for (observedP = serverP->runtime.observedList; observedP != NULL; observedP = observedP->next)
             {
-                if (observedP->uriInfoP[ind].uri.objectId == uriP->objectId)
+                for (i = 0; i < observedP->uriCount; i++)
                 {
-                    if (uriP->instanceId == IOWA_LWM2M_ID_ALL
-                        || observedP->uriInfoP[ind].uri.instanceId == IOWA_LWM2M_ID_ALL
-                        || uriP->instanceId == observedP->uriInfoP[ind].uri.instanceId)
-                    {
-                        if (uriP->resourceId == IOWA_LWM2M_ID_ALL
-                            || observedP->uriInfoP[ind].uri.resourceId == IOWA_LWM2M_ID_ALL
-                            || uriP->resourceId == observedP->uriInfoP[ind].uri.resourceId)
-                        {
-                            observedP->uriInfoP[ind].flags |= LWM2M_OBSERVE_FLAG_UPDATE;
-                            IOWA_LOG_INFO(IOWA_PART_LWM2M, "Tagging the observation.");
-                            observedP->flags |= LWM2M_OBSERVE_FLAG_UPDATE;
-                        }
-                    }
+                    observedP->uriInfoP[i].flags |= LWM2M_OBSERVE_FLAG_UPDATE;
                 }
+                observedP->flags |= LWM2M_OBSERVE_FLAG_UPDATE;
+                prv_dueAdd(lwm2mContextP, observedP);
             }
         }
 
+        return;
+    }
+
+    for (i = 0; i < changeCount; i++)
+    {
+        if (object_checkReadable(contextP, IOWA_LWM2M_ID_ALL, changeArray + i) == IOWA_COAP_205_CONTENT)
+        {
+            lwm2m_resource_value_changed(contextP, changeArray + i);
+        }
     }
 }
+#endif // IOWA_THREAD_SUPPORT
 
 // Update observe according with its attributes.
 // Parameters:
@@ -1021,7 +1515,7 @@ static void prv_checkAndSendNotification(iowa_context_t contextP,
                 callbackP = NULL;
             }
 
-            messageP = iowa_coap_message_new(messageType, IOWA_COAP_205_CONTENT, observedP->tokenLen, observedP->token);
+            messageP = iowa_coap_message_new(contextP, messageType, IOWA_COAP_205_CONTENT, observedP->tokenLen, observedP->token);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (messageP == NULL)
             {
@@ -1031,7 +1525,7 @@ static void prv_checkAndSendNotification(iowa_context_t contextP,
             }
 #endif
 
-            optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
+            optionP = iowa_coap_option_new(contextP, IOWA_COAP_OPTION_CONTENT_FORMAT);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (optionP == NULL)
             {
@@ -1044,7 +1538,7 @@ static void prv_checkAndSendNotification(iowa_context_t contextP,
             optionP->value.asInteger = observedP->format;
             iowa_coap_message_add_option(messageP, optionP);
 
-            optionP = iowa_coap_option_new(IOWA_COAP_OPTION_OBSERVE);
+            optionP = iowa_coap_option_new(contextP, IOWA_COAP_OPTION_OBSERVE);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (optionP == NULL)
             {
@@ -1059,8 +1553,20 @@ static void prv_checkAndSendNotification(iowa_context_t contextP,
 
             coreBufferSet(&(messageP->payload),bufferP, bufferLength);
 
+#if defined(IOWA_COAP_BLOCK_SUPPORT) || defined(IOWA_COAP_BLOCK_MINIMAL_SUPPORT)
+            // Only the first block of a large notification is sent, the Server retrieves the following ones with GET requests
+            if (coapBlockPrepareResponse(contextP, serverP->runtime.peerP, NULL, messageP) != IOWA_COAP_NO_ERROR)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Failed to cut the notification in blocks.");
+            }
+#endif
+
             IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Send notification number %d.", observedP->counter);
-            (void)coapSend(contextP, serverP->runtime.peerP, messageP, callbackP, valueP);
+            if (coapSend(contextP, serverP->runtime.peerP, messageP, callbackP, valueP) != IOWA_COAP_NO_ERROR)
+            {
+                // The result callback will not be called
+                iowa_system_free(valueP);
+            }
 
             prv_addMID(observedP, messageP->id);
 
@@ -1076,211 +1582,210 @@ static void prv_checkAndSendNotification(iowa_context_t contextP,
 void observe_step(iowa_context_t contextP)
 {
     // WARNING: This function is called in a critical section
-    lwm2m_server_t *serverP;
+    lwm2m_context_t *lwm2mContextP;
 
     IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Entering.");
 
-    for (serverP = contextP->lwm2mContextP->serverList; serverP != NULL; serverP = serverP->next)
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    // Only the observations tagged as updated or whose maximum period elapsed are in the due list.
+    // Observations becoming due while this list is processed are handled on the next step.
+    lwm2mContextP->observeStepList = lwm2mContextP->observeDueList;
+    lwm2mContextP->observeDueList = NULL;
+
+    while (lwm2mContextP->observeStepList != NULL)
     {
         lwm2m_observed_t *observedP;
+        lwm2m_server_t *serverP;
+        iowa_status_t result;
+        iowa_lwm2m_data_t *dataP;
+        size_t dataCount;
+        size_t ind;
+        bool sendNotif;
 
-        for (observedP = serverP->runtime.observedList; observedP != NULL; observedP = observedP->next)
+        observedP = lwm2mContextP->observeStepList;
+        lwm2mContextP->observeStepList = observedP->dueNext;
+        observedP->dueNext = NULL;
+        observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_DUE);
+
+        serverP = observedP->serverP;
+        dataP = NULL;
+        dataCount = 0;
+        sendNotif = false;
+        result = IOWA_COAP_205_CONTENT;
+
+        // if tag true
+        if ((observedP->flags & LWM2M_OBSERVE_FLAG_UPDATE) != 0)
         {
-            iowa_status_t result;
-            iowa_lwm2m_data_t *dataP;
-            size_t dataCount;
-            size_t ind;
-            bool sendNotif;
-            bool nextObs;
-            dataP = NULL;
-            dataCount = 0;
-            sendNotif = false;
-            nextObs = false;
-
-            // if tag true
-            if ((observedP->flags & LWM2M_OBSERVE_FLAG_UPDATE) != 0
-                && (contextP->lwm2mContextP->internalFlag & CONTEXT_FLAG_INSIDE_CALLBACK) == 0)
+            if ((lwm2mContextP->internalFlag & CONTEXT_FLAG_INSIDE_CALLBACK) != 0)
             {
-                //Check if there is timeAttribute
-                if (observedP->timeAttrP != NULL)
+                // Keep the observation for a later step
+                prv_dueAdd(lwm2mContextP, observedP);
+                continue;
+            }
+
+            //Check if there is timeAttribute
+            if (observedP->timeAttrP != NULL
+                && (observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0)
+            {
+                IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Checking minimum period (%d s).", observedP->timeAttrP->minPeriod);
+                if (observedP->lastTime + CORE_TIME_FROM_SECONDS(observedP->timeAttrP->minPeriod) > contextP->currentTime)
                 {
-                    if ((observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0)
-                    {
-                        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Checking minimum period (%d s).", observedP->timeAttrP->minPeriod);
-                        if (observedP->lastTime + observedP->timeAttrP->minPeriod > contextP->currentTime)
-                        {
-                            // pmin is set and did not elapsed. Ignore this notification.
-                            observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_UPDATE);
-                            nextObs = true;
-                        }
-                    }
+                    // pmin is set and did not elapsed. Ignore this notification.
+                    observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_UPDATE);
+                    prv_schedulePmax(contextP, observedP);
+                    continue;
+                }
+            }
+
+            for (ind = 0; ind < observedP->uriCount; ind++)
+            {
+                //Get value to send
+                result = object_read(contextP, &observedP->uriInfoP[ind].uri, serverP->shortId, &dataCount, &dataP);
+                if (result != IOWA_COAP_205_CONTENT)
+                {
+                    IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Getting value to send failed with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+                    break;
                 }
-                if (nextObs == false)
+                //Check if it's a resource with no multiple instance && a numeric resource && if there is a ST, LT, GT set
+                if (LWM2M_URI_IS_SET_RESOURCE(&observedP->uriInfoP[ind].uri)
+                    && !LWM2M_URI_IS_SET_RESOURCE_INSTANCE(&observedP->uriInfoP[ind].uri)
+                    && observedP->uriInfoP[ind].uriAttrP != NULL
+                    && (observedP->uriInfoP[ind].uriAttrP->flags & ATTR_FLAG_NUMERIC) != 0
+                    && LWM2M_OBSERVE_IS_NUMERIC(&observedP->uriInfoP[ind]))
                 {
-                    for (ind = 0; ind < observedP->uriCount; ind++)
+                    if ((observedP->uriInfoP[ind].flags & LWM2M_OBSERVE_FLAG_INTEGER) != 0)
                     {
-                        //Get value to send
-                        result = object_read(contextP, &observedP->uriInfoP[ind].uri, serverP->shortId, &dataCount, &dataP);
+                        int64_t integerValue;
+                        integerValue = dataP->value.asInteger;
+
+                        if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_LESS_THAN) != 0
+                            && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->lessThan, integerValue, observedP->uriInfoP[ind].lastValue.asInteger))
                         {
-                            if (result != IOWA_COAP_205_CONTENT)
-                            {
-                                IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Getting value to send failed with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
-                                return;
-                            }
+                            IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower threshold crossing.");
+                            sendNotif = true;
                         }
-                        //Check if it's a resource with no multiple instance && a numeric resource && if there is a ST, LT, GT set
-                        if (LWM2M_URI_IS_SET_RESOURCE(&observedP->uriInfoP[ind].uri)
-                            && !LWM2M_URI_IS_SET_RESOURCE_INSTANCE(&observedP->uriInfoP[ind].uri)
-                            && observedP->uriInfoP[ind].uriAttrP != NULL
-                            && (observedP->uriInfoP[ind].uriAttrP->flags & ATTR_FLAG_NUMERIC) != 0
-                            && LWM2M_OBSERVE_IS_NUMERIC(&observedP->uriInfoP[ind]))
+
+                        if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_GREATER_THAN) != 0
+                            && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->greaterThan, integerValue, observedP->uriInfoP[ind].lastValue.asInteger))
                         {
-                            if ((observedP->uriInfoP[ind].flags & LWM2M_OBSERVE_FLAG_INTEGER) != 0)
+                            IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower upper crossing.");
+                            sendNotif = true;
+                        }
+
+                        if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_STEP) != 0)
+                        {
+                            int64_t diff;
+
+                            diff = integerValue - observedP->uriInfoP[ind].lastValue.asInteger;
+                            if (diff < 0 )
                             {
-                                int64_t integerValue;
-                                integerValue = dataP->value.asInteger;
-
-                                if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_LESS_THAN) != 0
-                                    && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->lessThan, integerValue, observedP->uriInfoP[ind].lastValue.asInteger))
-                                {
-                                    IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower threshold crossing.");
-                                    sendNotif = true;
-                                }
-
-                                if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_GREATER_THAN) != 0
-                                    && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->greaterThan, integerValue, observedP->uriInfoP[ind].lastValue.asInteger))
-                                {
-                                    IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower upper crossing.");
-                                    sendNotif = true;
-                                }
-
-                                if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_STEP) != 0)
-                                {
-                                    int64_t diff;
-
-                                    diff = integerValue - observedP->uriInfoP[ind].lastValue.asInteger;
-                                    if (diff < 0 )
-                                    {
-                                        diff = 0 - diff;
-                                    }
-                                    if (diff >= observedP->uriInfoP[ind].uriAttrP->step)
-                                    {
-                                        IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on step condition.");
-                                        sendNotif = true;
-                                    }
-                                }
+                                diff = 0 - diff;
                             }
-                            else
+                            if (diff >= observedP->uriInfoP[ind].uriAttrP->step)
                             {
-                                double floatValue;
-                                floatValue = dataP->value.asFloat;
-
-                                if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_LESS_THAN) != 0
-                                    && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->lessThan, floatValue, observedP->uriInfoP[ind].lastValue.asFloat))
-                                {
-                                    IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower threshold crossing.");
-                                    sendNotif = true;
-                                }
-                                if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_GREATER_THAN) != 0
-                                    && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->greaterThan, floatValue, observedP->uriInfoP[ind].lastValue.asFloat))
-                                {
-                                    IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower upper crossing.");
-                                    sendNotif = true;
-                                }
-                                if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_STEP) != 0)
-                                {
-                                    double diff;
-
-                                    diff = floatValue - observedP->uriInfoP[ind].lastValue.asFloat;
-                                    if (diff < 0 )
-                                    {
-                                        diff = 0 - diff;
-                                    }
-                                    if (diff >= observedP->uriInfoP[ind].uriAttrP->step) //Todo : check FLT_EPSILON
-                                    {
-                                        IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on step condition.");
-                                        sendNotif = true;
-                                    }
-                                }
+                                IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on step condition.");
+                                sendNotif = true;
                             }
                         }
-                        else
+                    }
+                    else
+                    {
+                        double floatValue;
+                        floatValue = dataP->value.asFloat;
+
+                        if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_LESS_THAN) != 0
+                            && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->lessThan, floatValue, observedP->uriInfoP[ind].lastValue.asFloat))
+                        {
+                            IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower threshold crossing.");
+                            sendNotif = true;
+                        }
+                        if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_GREATER_THAN) != 0
+                            && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->greaterThan, floatValue, observedP->uriInfoP[ind].lastValue.asFloat))
                         {
-                            if ((observedP->uriInfoP[ind].flags & LWM2M_OBSERVE_FLAG_UPDATE) != 0)
+                            IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower upper crossing.");
+                            sendNotif = true;
+                        }
+                        if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_STEP) != 0)
+                        {
+                            double diff;
+
+                            diff = floatValue - observedP->uriInfoP[ind].lastValue.asFloat;
+                            if (diff < 0 )
                             {
+                                diff = 0 - diff;
+                            }
+                            if (diff >= observedP->uriInfoP[ind].uriAttrP->step) //Todo : check FLT_EPSILON
+                            {
+                                IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on step condition.");
                                 sendNotif = true;
                             }
                         }
                     }
-                    if (sendNotif == true)
-                    {
-                        prv_checkAndSendNotification(contextP, serverP, observedP, dataP, dataCount);
-                    }
+                }
+                else
+                {
+                    if ((observedP->uriInfoP[ind].flags & LWM2M_OBSERVE_FLAG_UPDATE) != 0)
                     {
-                        object_free(contextP, dataCount, dataP);
-                        iowa_system_free(dataP);
+                        sendNotif = true;
                     }
-                    observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_UPDATE);
                 }
             }
-            else // Check pmax
+            if (result != IOWA_COAP_205_CONTENT)
             {
-                //Check if there is timeAttribute
-                if (observedP->timeAttrP != NULL)
+                // Try again on the next step
+                if (dataP != NULL)
                 {
-                    if ((observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MAX_PERIOD) != 0)
-                    {
-                        // Ignore pmax if lesser than pmin
-                        if (((observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0
-                            && observedP->timeAttrP->maxPeriod >= observedP->timeAttrP->minPeriod)
-                            || ((observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) == 0))
-                        {
-                            IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Checking maximum period (%d s).", observedP->timeAttrP->maxPeriod);
-                            if (observedP->lastTime + observedP->timeAttrP->maxPeriod <= contextP->currentTime)
-                            {
-                                IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Notify on elapsed maximal period (%d s).", observedP->timeAttrP->maxPeriod);
-
-                                for (ind = 0; ind < observedP->uriCount; ind++)
-                                {
-                                    //Get value to send
-                                    result = object_read(contextP, &observedP->uriInfoP[ind].uri, serverP->shortId, &dataCount, &dataP);
-                                    {
-                                        if (result != IOWA_COAP_205_CONTENT)
-                                        {
-                                            IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Getting value to send failed with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
-                                            return;
-                                        }
-                                    }
-                                }
-                                prv_checkAndSendNotification(contextP, serverP, observedP, dataP, dataCount);
-                                object_free(contextP, dataCount, dataP);
-                                iowa_system_free(dataP);
-                            }
-                        }
-                    }
+                    object_free(contextP, dataCount, dataP);
+                    iowa_system_free(dataP);
                 }
+                prv_dueAdd(lwm2mContextP, observedP);
+                continue;
             }
-            if (observedP->timeAttrP != NULL
-                && (observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MAX_PERIOD) != 0)
+            if (sendNotif == true)
             {
-                // Ignore pmax if lesser than pmin
-                if (((observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0
-                    && observedP->timeAttrP->maxPeriod >= observedP->timeAttrP->minPeriod)
-                    || ((observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) == 0))
-                {
-                    int32_t interval;
+                prv_checkAndSendNotification(contextP, serverP, observedP, dataP, dataCount);
+            }
+            object_free(contextP, dataCount, dataP);
+            iowa_system_free(dataP);
+            observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_UPDATE);
+        }
+        else if (prv_hasMaxPeriod(observedP) == true
+                 && observedP->lastTime + CORE_TIME_FROM_SECONDS(observedP->timeAttrP->maxPeriod) <= contextP->currentTime)
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Notify on elapsed maximal period (%d s).", observedP->timeAttrP->maxPeriod);
 
-                    interval = observedP->lastTime + observedP->timeAttrP->maxPeriod - contextP->currentTime;
-                    if (contextP->timeout > interval)
-                    {
-                        contextP->timeout = interval;
-                    }
+            for (ind = 0; ind < observedP->uriCount; ind++)
+            {
+                //Get value to send
+                result = object_read(contextP, &observedP->uriInfoP[ind].uri, serverP->shortId, &dataCount, &dataP);
+                if (result != IOWA_COAP_205_CONTENT)
+                {
+                    IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Getting value to send failed with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+                    break;
                 }
             }
+            if (result != IOWA_COAP_205_CONTENT)
+            {
+                // Try again on the next step
+                if (dataP != NULL)
+                {
+                    object_free(contextP, dataCount, dataP);
+                    iowa_system_free(dataP);
+                }
+                prv_dueAdd(lwm2mContextP, observedP);
+                continue;
+            }
+            prv_checkAndSendNotification(contextP, serverP, observedP, dataP, dataCount);
+            object_free(contextP, dataCount, dataP);
+            iowa_system_free(dataP);
         }
 
+        // The last notification time may have changed
+        prv_schedulePmax(contextP, observedP);
     }
-    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Exiting with timeoutP: %ds.", contextP->timeout);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Exiting with timeoutP: %d.", contextP->timeout);
 }
 #endif // LWM2M_CLIENT_MODE
 
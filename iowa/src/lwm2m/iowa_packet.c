@@ -147,7 +147,7 @@ void lwm2m_client_handle_request(iowa_coap_peer_t *fromPeer,
     }
 
 #ifdef LWM2M_ALTPATH_SUPPORT
-    type = uri_decode(contextP->lwm2mContextP->altPath, requestP, IOWA_COAP_OPTION_URI_PATH, &uri);
+    type = uri_decode(contextP, contextP->lwm2mContextP->altPath, requestP, IOWA_COAP_OPTION_URI_PATH, &uri);
 #else
     type = uri_decode(requestP, IOWA_COAP_OPTION_URI_PATH, &uri);
 #endif
@@ -327,18 +327,32 @@ typedef struct _lwm2m_observed_
 {
     struct _lwm2m_observed_ *next;
 
-    uint8_t                     flags; // possibilities: LWM2M_OBSERVE_FLAG_UPDATE
+    uint8_t                     flags; // possibilities: LWM2M_OBSERVE_FLAG_UPDATE; LWM2M_OBSERVE_FLAG_DUE
     size_t                      uriCount;
     lwm2m_observed_uri_info_t  *uriInfoP;
     lwm2m_time_attributes_t    *timeAttrP;
     iowa_content_format_t       format;
     uint8_t                     token[COAP_MSG_TOKEN_MAX_LEN];
     uint8_t                     tokenLen;
-    int32_t                     lastTime;
+    iowa_time_t                 lastTime;
     uint32_t                    counter;
     uint16_t                    lastMid[LWM2M_OBSERVATION_MID_ARRAY_SIZE];
+    struct _lwm2m_server_      *serverP;     // the Server owning this observation
+    iowa_timer_t               *pmaxTimerP;  // expires when the maximum period elapses
+    struct _lwm2m_observed_    *dueNext;     // next observation in the due list
 } lwm2m_observed_t;
 
+// Entry of the index of the observed URIs.
+// The entries are sorted by Object ID, Object Instance ID and Resource ID, IOWA_LWM2M_ID_ALL being the highest value.
+typedef struct
+{
+    uint16_t          objectId;
+    uint16_t          instanceId;
+    uint16_t          resourceId;
+    lwm2m_observed_t *observedP;
+    size_t            uriIndex;   // index in observedP->uriInfoP
+} lwm2m_observe_index_entry_t;
+
 typedef struct _lwm2m_async_operation_
 {
     struct _lwm2m_async_operation_ *next;
@@ -508,6 +522,12 @@ typedef struct _lwm2m_object_t
     lwm2m_instance_details_t   *instanceArray;
 } lwm2m_object_t;
 
+#if defined(LWM2M_CLIENT_MODE) && defined(IOWA_THREAD_SUPPORT)
+#ifndef IOWA_RESOURCE_CHANGE_QUEUE_SIZE
+#define IOWA_RESOURCE_CHANGE_QUEUE_SIZE 16
+#endif
+#endif
+
 typedef struct _lwm2m_context_t lwm2m_context_t;
 
 struct _lwm2m_context_t
@@ -520,7 +540,20 @@ struct _lwm2m_context_t
 #endif
     lwm2m_server_t       *serverList;
     lwm2m_object_t       *objectList;
+    lwm2m_object_t      **objectArray;  // the Objects of objectList sorted by ID
+    uint16_t              objectCount;
     uint8_t               internalFlag;
+    lwm2m_observe_index_entry_t *observeIndexArray;
+    size_t                       observeIndexCount;
+    size_t                       observeIndexSize;
+    lwm2m_observed_t            *observeDueList;   // observations to process on the next step
+    lwm2m_observed_t            *observeStepList;  // observations being processed by observe_step()
+#ifdef IOWA_THREAD_SUPPORT
+    // Protected by CORE_LOCK_OBSERVATIONS
+    iowa_lwm2m_uri_t      changeArray[IOWA_RESOURCE_CHANGE_QUEUE_SIZE];
+    size_t                changeCount;
+    bool                  changeOverflow;
+#endif
 #endif // LWM2M_CLIENT_MODE
     void                 *userData;
 };
@@ -577,6 +610,21 @@ void lwm2mUpdateRegistration(iowa_context_t contextP, lwm2m_server_t *serverP, u
 // - uriP : a pointer to an Uri.
 void lwm2m_resource_value_changed(iowa_context_t contextP, iowa_lwm2m_uri_t *uriP);
 
+#if defined(LWM2M_CLIENT_MODE) && defined(IOWA_THREAD_SUPPORT)
+// Queue a resource change reported outside of the context lock.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - uriP : the URI of the changed resource.
+// Note:
+// - CORE_LOCK_OBSERVATIONS must not be held by the caller.
+void lwm2m_resource_value_changed_queue(iowa_context_t contextP, iowa_lwm2m_uri_t *uriP);
+
+// Update the observe flag of the matched uris for the queued resource changes.
+// Parameters:
+// - contextP: as returned by iowa_init().
+void lwm2m_resource_value_changed_flush(iowa_context_t contextP);
+#endif
+
 // Device Management APIs
 int lwm2m_dm_discover(iowa_context_t contextP, uint32_t clientID, iowa_lwm2m_uri_t * uriP, lwm2m_result_callback_t callback, void * userData);
 int lwm2m_dm_execute(iowa_context_t contextP, uint32_t clientID, iowa_lwm2m_uri_t * uriP, iowa_content_format_t format, uint8_t * buffer, int length, lwm2m_result_callback_t callback, void * userData);
@@ -239,6 +239,7 @@ typedef enum
 #define LWM2M_OBSERVE_FLAG_INTEGER    (uint8_t)0x02 // indicates if observe's value is an integer, used in lwm2m_observed_uri_info_t
 #define LWM2M_OBSERVE_FLAG_FLOAT      (uint8_t)0x04 // indicates if observe's value is a float, used in lwm2m_observed_uri_info_t
 #define LWM2M_OBSERVE_FLAG_URI_UNSET  (uint8_t)0x08 // indicates if observe's uri is unset due to instance deletion, used in lwm2m_observed_uri_info_t
+#define LWM2M_OBSERVE_FLAG_DUE        (uint8_t)0x10 // indicates if observe is in the due list, used in lwm2m_observed_t
 
 // Macro to check if observe's value is numeric
 // Returned value: true if observe's value is numeric, else false.
@@ -358,12 +359,13 @@ void lwm2m_bootstrap_server_handle_request(iowa_coap_peer_t *fromPeer, uint8_t c
 // Get URI from CoAP message
 // Returned value: lwm2m_uri_type_t. If any error, return LWM2M_URI_TYPE_UNKNOWN
 // Parameters:
+// - contextP: returned by iowa_init(). Only if LWM2M_ALTPATH_SUPPORT is defined.
 // - altPath: alternate path of the uri. Only if LWM2M_ALTPATH_SUPPORT is defined. This can be nil.
 // - messageP: Message CoAP contaning the URI wanted. Can not be nil.
 // - number: CoAP option number where the URI wanted is set.
 // - uriP: OUT. LwM2M URI, useful if result is LWM2M_URI_TYPE_DM.
 #ifdef LWM2M_ALTPATH_SUPPORT
-lwm2m_uri_type_t uri_decode(char *altPath, iowa_coap_message_t *messageP, uint16_t number, iowa_lwm2m_uri_t *uriP);
+lwm2m_uri_type_t uri_decode(iowa_context_t contextP, char *altPath, iowa_coap_message_t *messageP, uint16_t number, iowa_lwm2m_uri_t *uriP);
 #else
 lwm2m_uri_type_t uri_decode(iowa_coap_message_t *messageP, uint16_t number, iowa_lwm2m_uri_t *uriP);
 #endif
@@ -371,20 +373,28 @@ lwm2m_uri_type_t uri_decode(iowa_coap_message_t *messageP, uint16_t number, iowa
 // Get CoAP option from URI
 // Returned value: CoAP option allocated and filled. If any error, return NULL.
 // Parameters:
+// - contextP: returned by iowa_init().
 // - number: CoAP option number wanted.
 // - altPath: alternate path of the uri. Only if LWM2M_ALTPATH_SUPPORT is defined. This can be nil.
 // - uriP: LwM2M URI. This can be nil.
 // - buffer: OUT. buffer to store the CoAP option values.
 #ifdef LWM2M_ALTPATH_SUPPORT
-iowa_coap_option_t * uri_encode(uint16_t number, char *altPath, iowa_lwm2m_uri_t *uriP, uint8_t buffer[PRV_URI_BUFFER_SIZE]);
+iowa_coap_option_t * uri_encode(iowa_context_t contextP, uint16_t number, char *altPath, iowa_lwm2m_uri_t *uriP, uint8_t buffer[PRV_URI_BUFFER_SIZE]);
 #else
-iowa_coap_option_t * uri_encode(uint16_t number, iowa_lwm2m_uri_t *uriP, uint8_t buffer[PRV_URI_BUFFER_SIZE]);
+iowa_coap_option_t * uri_encode(iowa_context_t contextP, uint16_t number, iowa_lwm2m_uri_t *uriP, uint8_t buffer[PRV_URI_BUFFER_SIZE]);
 #endif
 
 // defined in objects.c
 
 iowa_status_t object_getTargets(iowa_context_t contextP, uint16_t objectId, lwm2m_object_t **startPP, lwm2m_object_t **endPP);
 
+// Find an Object.
+// Returned value: the Object or NULL if not found.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - objectID: the ID of the Object.
+lwm2m_object_t * object_lookup(iowa_context_t contextP, uint16_t objectID);
+
 // Read only readable ressources on a URI.
 // Returned value: IOWA_COAP_205_CONTENT in case of success or an error status.
 // Parameters:
@@ -402,7 +412,7 @@ iowa_status_t object_read(iowa_context_t contextP, iowa_lwm2m_uri_t *uriP, uint1
 // - serverShortId: the short ID of the Server making the operation.
 // - blockInfo: the value of the CoAP block2 option.
 // - dataCountP, dataArrayP: OUT. value of LwM2M data.
-iowa_status_t object_readBlock(iowa_context_t contextP, iowa_lwm2m_uri_t *uriP, uint32_t blockInfo, size_t *dataCountP, iowa_lwm2m_data_t **dataArrayP);
+iowa_status_t object_readBlock(iowa_context_t contextP, iowa_lwm2m_uri_t *uriP, uint16_t serverShortId, uint32_t blockInfo, size_t *dataCountP, iowa_lwm2m_data_t **dataArrayP);
 
 // Read ressources on a URI.
 // Returned value: IOWA_COAP_205_CONTENT in case of success or an error status.
@@ -555,8 +565,8 @@ iowa_status_t observe_handleRequest(iowa_context_t contextP, size_t uriCount, io
 
 void observe_cancel(iowa_context_t contextP, lwm2m_server_t *serverP, iowa_coap_message_t *messageP);
 iowa_status_t observe_setParameters(iowa_context_t contextP, iowa_lwm2m_uri_t *uriP, lwm2m_server_t *serverP);
-void observe_delete(lwm2m_observed_t *observedP);
-void observeRemoveFromServer(lwm2m_server_t *serverP);
+void observe_delete(iowa_context_t contextP, lwm2m_observed_t *observedP);
+void observeRemoveFromServer(iowa_context_t contextP, lwm2m_server_t *serverP);
 void observe_remove(lwm2m_observation_t * observationP);
 void observe_step(iowa_context_t contextP);
 void observe_clear(iowa_context_t contextP, iowa_lwm2m_uri_t * uriP);
@@ -89,7 +89,6 @@
 #define PRV_RESULT_NO_ERROR_LIFETIME     1
 #define PRV_RESULT_NO_ERROR_NO_LIFETIME  0
 #define PRV_RESULT_ERROR                 -1
-#define PRV_REG_INITAL_TOKEN             {0, 0, 1}
 
 #define PRV_DEFAULT_MAX_REGISTRATION_DELAY 93
 
@@ -100,6 +99,9 @@
 #ifdef LWM2M_CLIENT_MODE
 static iowa_status_t prv_getRegistrationQuery(iowa_context_t contextP, lwm2m_server_t *serverP, size_t *lengthP, char **bufferP);
 static iowa_status_t prv_getRegistrationPayload(iowa_context_t contextP, uint8_t **payloadP, size_t *payloadLengthP);
+#ifdef IOWA_LORAWAN_SUPPORT
+static iowa_status_t prv_prepareCompressionContext(iowa_context_t contextP, lwm2m_server_t *serverP);
+#endif
 static int32_t prv_getUpdateDelay(lwm2m_server_t *serverP);
 static void prv_serverRegistrationFailing(iowa_context_t contextP, lwm2m_server_t *serverP, bool isInternal, uint8_t code);
 static void prv_handleRegistrationUpdateReply(iowa_coap_peer_t *fromPeerP, uint8_t status, iowa_coap_message_t * responseP, void * userData, iowa_context_t contextP);
@@ -125,7 +127,7 @@ iowa_status_t prv_getRegistrationQuery(iowa_context_t contextP,
 {
     size_t length;
     size_t res;
-#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT) || defined(IOWA_SMS_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT)
     uint8_t *strBinding;
     size_t strBindingLen;
 
@@ -139,7 +141,7 @@ iowa_status_t prv_getRegistrationQuery(iowa_context_t contextP,
 
     default:
     {
-#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT) || defined(IOWA_SMS_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT)
         iowa_lwm2m_binding_t binding;
 
         length = QUERY_LIFETIME_LEN + dataUtilsIntToBufferLength(serverP->lifetime, false) + 1 + QUERY_DELIMITER_LEN + QUERY_VERSION_LEN + LWM2M_VERSION_LEN;
@@ -178,7 +180,7 @@ iowa_status_t prv_getRegistrationQuery(iowa_context_t contextP,
             strBindingLen = 0;
         }
 
-#endif // IOWA_UDP_SUPPORT || IOWA_TCP_SUPPORT  || IOWA_WEBSOCKET_SUPPORT || IOWA_SMS_SUPPORT
+#endif // IOWA_UDP_SUPPORT || IOWA_TCP_SUPPORT  || IOWA_WEBSOCKET_SUPPORT || IOWA_SMS_SUPPORT || IOWA_LORAWAN_SUPPORT
     }
     }
 
@@ -206,7 +208,7 @@ iowa_status_t prv_getRegistrationQuery(iowa_context_t contextP,
     {
 
     default:
-#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_TCP_SUPPORT) || defined(IOWA_WEBSOCKET_SUPPORT) || defined(IOWA_SMS_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT)
         *lengthP += utilsStringCopy(*bufferP + *lengthP, length - *lengthP, QUERY_DELIMITER QUERY_VERSION);
 
         switch (serverP->lwm2mVersion)
@@ -239,7 +241,7 @@ iowa_status_t prv_getRegistrationQuery(iowa_context_t contextP,
             iowa_system_free(strBinding);
         }
 
-#endif // IOWA_UDP_SUPPORT || IOWA_TCP_SUPPORT  || IOWA_WEBSOCKET_SUPPORT || IOWA_SMS_SUPPORT
+#endif // IOWA_UDP_SUPPORT || IOWA_TCP_SUPPORT  || IOWA_WEBSOCKET_SUPPORT || IOWA_SMS_SUPPORT || IOWA_LORAWAN_SUPPORT
         break;
     }
 
@@ -317,6 +319,48 @@ iowa_status_t prv_getRegistrationPayload(iowa_context_t contextP,
     return result;
 }
 
+#ifdef IOWA_LORAWAN_SUPPORT
+iowa_status_t prv_prepareCompressionContext(iowa_context_t contextP,
+                                            lwm2m_server_t *serverP)
+{
+    // WARNING: This function is called in a critical section
+    uint16_t *idArray;
+    uint16_t count;
+    uint16_t index;
+
+    if (coapPeerGetConnectionType(serverP->runtime.peerP) != IOWA_CONN_LORAWAN)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    // Same Objects as in the registration payload, in the same order
+    idArray = (uint16_t *)iowa_system_malloc(contextP->lwm2mContextP->objectCount * sizeof(uint16_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (idArray == NULL
+        && contextP->lwm2mContextP->objectCount != 0)
+    {
+        IOWA_LOG_ERROR_MALLOC(contextP->lwm2mContextP->objectCount * sizeof(uint16_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    count = 0;
+    for (index = 0; index < contextP->lwm2mContextP->objectCount; index++)
+    {
+        if (contextP->lwm2mContextP->objectArray[index]->objID != IOWA_LWM2M_SECURITY_OBJECT_ID)
+        {
+            idArray[count] = contextP->lwm2mContextP->objectArray[index]->objID;
+            count++;
+        }
+    }
+
+    // The list is used once the Server acknowledges the message carrying it
+    coapPeerPrepareObjectList(serverP->runtime.peerP, idArray, count);
+
+    return IOWA_COAP_NO_ERROR;
+}
+#endif
+
 int32_t prv_getUpdateDelay(lwm2m_server_t *serverP)
 {
     int32_t coapMaxTransmitWait;
@@ -408,6 +452,14 @@ void prv_handleRegistrationUpdateReply(iowa_coap_peer_t *fromPeerP,
             switch (responseP->code)
             {
             case IOWA_COAP_204_CHANGED:
+#ifdef IOWA_LORAWAN_SUPPORT
+                if (updateFlagsP != NULL
+                    && (*updateFlagsP & LWM2M_UPDATE_FLAG_OBJECTS) != 0)
+                {
+                    // The Server now knows the Object list sent in this Update
+                    coapPeerApplyObjectList(fromPeerP);
+                }
+#endif
                 if (serverP->runtime.lifetimeTimerP == NULL)
                 {
                     serverP->runtime.lifetimeTimerP = coreTimerNew(contextP, serverP->lifetime, prv_handleClientLifetimeTimer, serverP);
@@ -509,7 +561,7 @@ void prv_updateRegistration(iowa_context_t contextP,
         return;
     }
 
-    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_POST, tokenLength, token);
+    messageP = iowa_coap_message_new(contextP, IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_POST, tokenLength, token);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     if (messageP == NULL)
     {
@@ -518,7 +570,7 @@ void prv_updateRegistration(iowa_context_t contextP,
     }
 #endif
 
-    optionP = iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, serverP->runtime.location, REG_PATH_DELIMITER);
+    optionP = iowa_coap_path_to_option(contextP, IOWA_COAP_OPTION_URI_PATH, serverP->runtime.location, REG_PATH_DELIMITER);
     if (optionP == NULL)
     {
         iowa_coap_message_free(messageP);
@@ -615,7 +667,7 @@ void prv_updateRegistration(iowa_context_t contextP,
         }
         bufferP[index] = '\0';
 
-        optionP = iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_QUERY, bufferP, QUERY_SEPARATOR);
+        optionP = iowa_coap_path_to_option(contextP, IOWA_COAP_OPTION_URI_QUERY, bufferP, QUERY_SEPARATOR);
         if (optionP == NULL)
         {
             iowa_system_free(bufferP);
@@ -641,8 +693,17 @@ void prv_updateRegistration(iowa_context_t contextP,
             iowa_coap_message_free(messageP);
             return;
         }
+#ifdef IOWA_LORAWAN_SUPPORT
+        result = prv_prepareCompressionContext(contextP, serverP);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            iowa_system_free(payload);
+            iowa_coap_message_free(messageP);
+            return;
+        }
+#endif
 
-        optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
+        optionP = iowa_coap_option_new(contextP, IOWA_COAP_OPTION_CONTENT_FORMAT);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (optionP == NULL)
         {
@@ -833,6 +894,11 @@ void prv_handleRegistrationReply(iowa_coap_peer_t *fromPeer,
                     goto exit;
                 }
 
+#ifdef IOWA_LORAWAN_SUPPORT
+                // The Server now knows the Object list sent in the Register
+                coapPeerApplyObjectList(fromPeer);
+
+#endif
                 startP = optionP;
                 length = 0;
                 while (optionP != NULL
@@ -907,7 +973,7 @@ iowa_status_t prv_register(iowa_context_t contextP,
     iowa_coap_message_t *messageP;
     iowa_coap_option_t *optionP;
     iowa_status_t result;
-    uint8_t token[3] = PRV_REG_INITAL_TOKEN;
+    uint8_t token[COAP_MSG_TOKEN_MAX_LEN];
     uint8_t tokenLength;
     int32_t delay;
 
@@ -939,7 +1005,7 @@ iowa_status_t prv_register(iowa_context_t contextP,
         goto premature_exit;
     }
 
-    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_POST, 3, token);
+    messageP = iowa_coap_message_new(contextP, IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_POST, tokenLength, token);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     if (messageP == NULL)
     {
@@ -951,7 +1017,7 @@ iowa_status_t prv_register(iowa_context_t contextP,
 
     if (uriPath != NULL)
     {
-        optionP = iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, uriPath, REG_PATH_DELIMITER);
+        optionP = iowa_coap_path_to_option(contextP, IOWA_COAP_OPTION_URI_PATH, uriPath, REG_PATH_DELIMITER);
         if (optionP == NULL)
         {
             result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
@@ -960,7 +1026,7 @@ iowa_status_t prv_register(iowa_context_t contextP,
         iowa_coap_message_add_option(messageP, optionP);
     }
 
-    optionP = iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, URI_REGISTRATION_SEGMENT, REG_PATH_DELIMITER);
+    optionP = iowa_coap_path_to_option(contextP, IOWA_COAP_OPTION_URI_PATH, URI_REGISTRATION_SEGMENT, REG_PATH_DELIMITER);
     if (optionP == NULL)
     {
         result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
@@ -970,7 +1036,7 @@ iowa_status_t prv_register(iowa_context_t contextP,
 
     if (uriQuery != NULL)
     {
-        optionP = iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_QUERY, uriQuery, QUERY_SEPARATOR);
+        optionP = iowa_coap_path_to_option(contextP, IOWA_COAP_OPTION_URI_QUERY, uriQuery, QUERY_SEPARATOR);
         if (optionP == NULL)
         {
             result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
@@ -981,7 +1047,7 @@ iowa_status_t prv_register(iowa_context_t contextP,
 
     if (query != NULL)
     {
-        optionP = iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_QUERY, query, QUERY_SEPARATOR);
+        optionP = iowa_coap_path_to_option(contextP, IOWA_COAP_OPTION_URI_QUERY, query, QUERY_SEPARATOR);
         if (optionP == NULL)
         {
             result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
@@ -1001,8 +1067,15 @@ iowa_status_t prv_register(iowa_context_t contextP,
         {
             goto premature_exit;
         }
+#ifdef IOWA_LORAWAN_SUPPORT
+        result = prv_prepareCompressionContext(contextP, serverP);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            goto premature_exit;
+        }
+#endif
 
-        optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
+        optionP = iowa_coap_option_new(contextP, IOWA_COAP_OPTION_CONTENT_FORMAT);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (optionP == NULL)
         {
@@ -1236,18 +1309,18 @@ void registration_deregister(iowa_context_t contextP,
         {
             iowa_coap_message_t *messageP;
             iowa_coap_option_t *optionP;
-            uint8_t token;
+            uint8_t token[COAP_MSG_TOKEN_MAX_LEN];
             uint8_t tokenLength;
             iowa_status_t result;
 
-            result = coapPeerGenerateToken(serverP->runtime.peerP, &tokenLength, &token);
+            result = coapPeerGenerateToken(serverP->runtime.peerP, &tokenLength, token);
             if (result != IOWA_COAP_NO_ERROR)
             {
                 IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failure to generate a new token.");
                 return;
             }
 
-            messageP = iowa_coap_message_new(IOWA_COAP_TYPE_NON_CONFIRMABLE, IOWA_COAP_CODE_DELETE, tokenLength, &token);
+            messageP = iowa_coap_message_new(contextP, IOWA_COAP_TYPE_NON_CONFIRMABLE, IOWA_COAP_CODE_DELETE, tokenLength, token);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (messageP == NULL)
             {
@@ -1256,7 +1329,7 @@ void registration_deregister(iowa_context_t contextP,
             }
 #endif
 
-            optionP = iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, serverP->runtime.location, REG_PATH_DELIMITER);
+            optionP = iowa_coap_path_to_option(contextP, IOWA_COAP_OPTION_URI_PATH, serverP->runtime.location, REG_PATH_DELIMITER);
             if (optionP != NULL)
             {
                 iowa_coap_message_add_option(messageP, optionP);
@@ -1293,7 +1366,7 @@ iowa_status_t registration_step(iowa_context_t contextP)
     iowa_status_t result;
     lwm2m_server_t *serverP;
 
-    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Entering with timeout %ds and current time: %ds.", contextP->timeout, contextP->currentTime);
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Entering with timeout %d and current time: %lld.", contextP->timeout, (long long)contextP->currentTime);
 
     result = IOWA_COAP_503_SERVICE_UNAVAILABLE;
 
@@ -73,7 +73,8 @@
 #include "iowa_prv_lwm2m_internals.h"
 
 #ifdef LWM2M_ALTPATH_SUPPORT
-lwm2m_uri_type_t uri_decode(char *altPath,
+lwm2m_uri_type_t uri_decode(iowa_context_t contextP,
+                            char *altPath,
                             iowa_coap_message_t *messageP,
                             uint16_t number,
                             iowa_lwm2m_uri_t *uriP)
@@ -121,7 +122,7 @@ lwm2m_uri_type_t uri_decode(iowa_coap_message_t *messageP,
         iowa_coap_option_t * segmentOptionP;
 
         // check alternate path
-        pathOptionP = iowa_coap_path_to_option(number, altPath, REG_PATH_DELIMITER);
+        pathOptionP = iowa_coap_path_to_option(contextP, number, altPath, REG_PATH_DELIMITER);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (NULL == pathOptionP)
         {
@@ -219,12 +220,14 @@ lwm2m_uri_type_t uri_decode(iowa_coap_message_t *messageP,
 }
 
 #ifdef LWM2M_ALTPATH_SUPPORT
-iowa_coap_option_t * uri_encode(uint16_t number,
+iowa_coap_option_t * uri_encode(iowa_context_t contextP,
+                                uint16_t number,
                                 char *altPath,
                                 iowa_lwm2m_uri_t *uriP,
                                 uint8_t buffer[PRV_URI_BUFFER_SIZE])
 #else
-iowa_coap_option_t * uri_encode(uint16_t number,
+iowa_coap_option_t * uri_encode(iowa_context_t contextP,
+                                uint16_t number,
                                 iowa_lwm2m_uri_t *uriP,
                                 uint8_t buffer[PRV_URI_BUFFER_SIZE])
 #endif
@@ -233,7 +236,7 @@ iowa_coap_option_t * uri_encode(uint16_t number,
     iowa_coap_option_t *optionP;
     uint16_t index;
 
-    resultP = iowa_coap_option_new(number);
+    resultP = iowa_coap_option_new(contextP, number);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     if (resultP == NULL)
     {
@@ -256,7 +259,7 @@ iowa_coap_option_t * uri_encode(uint16_t number,
         optionP->length = (uint16_t)strlen(altPath);
         optionP->value.asBuffer = (uint8_t *)altPath;
 
-        optionP->next = iowa_coap_option_new(number);
+        optionP->next = iowa_coap_option_new(contextP, number);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (optionP->next == NULL)
         {
@@ -290,7 +293,7 @@ iowa_coap_option_t * uri_encode(uint16_t number,
 
     if (LWM2M_URI_IS_SET_INSTANCE(uriP))
     {
-        optionP->next = iowa_coap_option_new(number);
+        optionP->next = iowa_coap_option_new(contextP, number);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (optionP->next == NULL)
         {
@@ -313,7 +316,7 @@ iowa_coap_option_t * uri_encode(uint16_t number,
 
         if (LWM2M_URI_IS_SET_RESOURCE(uriP))
         {
-            optionP->next = iowa_coap_option_new(number);
+            optionP->next = iowa_coap_option_new(contextP, number);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (optionP->next == NULL)
             {
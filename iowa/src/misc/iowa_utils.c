@@ -21,7 +21,7 @@
 
 #include "iowa_prv_misc.h"
 
-static char b64ClassicAlphabet[64] =
+static const char b64ClassicAlphabet[64] =
 {
     'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
     'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
@@ -29,7 +29,7 @@ static char b64ClassicAlphabet[64] =
     'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'
 };
 
-static char b64UriSafeAlphabet[64] =
+static const char b64UriSafeAlphabet[64] =
 {
     'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
     'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
@@ -478,7 +478,7 @@ void utils_b64Encode(uint8_t *rawBuffer,
 {
     size_t dataIndex;
     size_t resultIndex;
-    char *alphabet;
+    const char *alphabet;
 
     switch (mode)
     {
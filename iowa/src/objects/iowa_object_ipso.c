@@ -447,6 +447,31 @@ static uint16_t prv_getResourceList(iowa_IPSO_ID_t type,
     return resCount;
 }
 
+// Report the change of an IPSO sensor resource.
+// Returned value: none.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - objectID, instanceID, resourceID: the changed resource.
+static void prv_resourceChanged(iowa_context_t contextP,
+                                uint16_t objectID,
+                                uint16_t instanceID,
+                                uint16_t resourceID)
+{
+#ifdef IOWA_THREAD_SUPPORT
+    // The sensors are only protected by CORE_LOCK_OBJECTS: the change is queued until the next step
+    iowa_lwm2m_uri_t uri;
+
+    uri.objectId = objectID;
+    uri.instanceId = instanceID;
+    uri.resourceId = resourceID;
+    uri.resInstanceId = IOWA_LWM2M_ID_ALL;
+
+    lwm2m_resource_value_changed_queue(contextP, &uri);
+#else
+    customObjectResourceChanged(contextP, objectID, instanceID, resourceID);
+#endif
+}
+
 static iowa_status_t prv_ipsoObjectCallback(iowa_dm_operation_t operation,
                                             iowa_lwm2m_data_t *dataP,
                                             size_t numData,
@@ -458,7 +483,7 @@ static iowa_status_t prv_ipsoObjectCallback(iowa_dm_operation_t operation,
     size_t i;
     iowa_status_t result;
 
-    CRIT_SECTION_ENTER(contextP);
+    SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBJECTS);
     objDataP = (ipso_object_t *)userData;
 
     result = IOWA_COAP_NO_ERROR;
@@ -595,18 +620,18 @@ static iowa_status_t prv_ipsoObjectCallback(iowa_dm_operation_t operation,
             case IPSO_RSC_ID_RESET_MIN_AND_MAX_MEASURED_VALUES:
                 instanceP->min = instanceP->value;
                 instanceP->max = instanceP->value;
-                customObjectResourceChanged(contextP, dataP[i].objectID, dataP[i].instanceID, IPSO_RSC_ID_MIN_MEASURED_VALUE);
-                customObjectResourceChanged(contextP, dataP[i].objectID, dataP[i].instanceID, IPSO_RSC_ID_MAX_MEASURED_VALUE);
+                prv_resourceChanged(contextP, dataP[i].objectID, dataP[i].instanceID, IPSO_RSC_ID_MIN_MEASURED_VALUE);
+                prv_resourceChanged(contextP, dataP[i].objectID, dataP[i].instanceID, IPSO_RSC_ID_MAX_MEASURED_VALUE);
                 break;
 
             case IPSO_RSC_ID_RESET_CUMULATIVE_ENERGY:
                 instanceP->value = 0.0f;
-                customObjectResourceChanged(contextP, dataP[i].objectID, dataP[i].instanceID, IPSO_RSC_ID_CUMULATIVE_ACTIVE_POWER);
+                prv_resourceChanged(contextP, dataP[i].objectID, dataP[i].instanceID, IPSO_RSC_ID_CUMULATIVE_ACTIVE_POWER);
                 break;
 
             case IPSO_RSC_ID_DIGITAL_INPUT_COUNTER_RESET:
                 instanceP->max = 0.0f;
-                customObjectResourceChanged(contextP, dataP[i].objectID, dataP[i].instanceID, IPSO_RSC_ID_DIGITAL_INPUT_COUNTER);
+                prv_resourceChanged(contextP, dataP[i].objectID, dataP[i].instanceID, IPSO_RSC_ID_DIGITAL_INPUT_COUNTER);
                 break;
 
             default:
@@ -641,7 +666,7 @@ static iowa_status_t prv_ipsoObjectCallback(iowa_dm_operation_t operation,
         }
     }
 
-    CRIT_SECTION_LEAVE(contextP);
+    SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
 
     return result;
 }
@@ -706,13 +731,13 @@ static void prv_updateResourceValues(iowa_context_t contextP,
             if ((prevValue > valueArray[index].value && prevValue - valueArray[index].value > FLT_EPSILON)
                 || (valueArray[index].value > prevValue && valueArray[index].value - prevValue > FLT_EPSILON))
             {
-                customObjectResourceChanged(contextP, objectP->objID, objectP->instanceArray[instIndex].id, IPSO_RSC_ID_DIGITAL_INPUT_STATE);
+                prv_resourceChanged(contextP, objectP->objID, objectP->instanceArray[instIndex].id, IPSO_RSC_ID_DIGITAL_INPUT_STATE);
 
                 if (hasCounter == true
                     && (valueArray[index].value > prevValue && valueArray[index].value - prevValue > FLT_EPSILON))
                 {
                     instanceP->max += 1.f;
-                    customObjectResourceChanged(contextP, objectP->objID, objectP->instanceArray[instIndex].id, IPSO_RSC_ID_DIGITAL_INPUT_COUNTER);
+                    prv_resourceChanged(contextP, objectP->objID, objectP->instanceArray[instIndex].id, IPSO_RSC_ID_DIGITAL_INPUT_COUNTER);
                 }
             }
             prevValue = valueArray[index].value;
@@ -748,19 +773,19 @@ static void prv_updateResourceValues(iowa_context_t contextP,
         {
             if (dataUtilsCompareFloatingPointNumbers(valueArray[index].value, prevValue) == false)
             {
-                customObjectResourceChanged(contextP, objectP->objID, objectP->instanceArray[instIndex].id, valueId);
+                prv_resourceChanged(contextP, objectP->objID, objectP->instanceArray[instIndex].id, valueId);
 
                 if (hasMin == true
                     && valueArray[index].value < instanceP->min)
                 {
                     instanceP->min = valueArray[index].value;
-                    customObjectResourceChanged(contextP, objectP->objID, objectP->instanceArray[instIndex].id, IPSO_RSC_ID_MIN_MEASURED_VALUE);
+                    prv_resourceChanged(contextP, objectP->objID, objectP->instanceArray[instIndex].id, IPSO_RSC_ID_MIN_MEASURED_VALUE);
                 }
                 else if (hasMax == true
                          && valueArray[index].value > instanceP->max)
                 {
                     instanceP->max = valueArray[index].value;
-                    customObjectResourceChanged(contextP, objectP->objID, objectP->instanceArray[instIndex].id, IPSO_RSC_ID_MAX_MEASURED_VALUE);
+                    prv_resourceChanged(contextP, objectP->objID, objectP->instanceArray[instIndex].id, IPSO_RSC_ID_MAX_MEASURED_VALUE);
                 }
             }
             prevValue = valueArray[index].value;
@@ -920,7 +945,9 @@ iowa_status_t iowa_client_IPSO_add_sensor(iowa_context_t contextP,
         return result;
     }
 
+    SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBJECTS);
     objDataP->instanceList = (ipso_instance_t *)IOWA_UTILS_LIST_ADD(objDataP->instanceList, instanceP);
+    SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
 
     CRIT_SECTION_LEAVE(contextP);
 
@@ -991,7 +1018,9 @@ iowa_status_t iowa_client_IPSO_remove_sensor(iowa_context_t contextP,
     }
 
     instanceId = GET_INSTANCE_ID_FROM_SENSOR(id);
+    SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBJECTS);
     objDataP->instanceList = (ipso_instance_t *)IOWA_UTILS_LIST_FIND_AND_REMOVE(objDataP->instanceList, listFindCallbackBy16bitsId, &instanceId, &instanceP);
+    SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
     if (instanceP == NULL)
     {
         CRIT_SECTION_LEAVE(contextP);
@@ -1045,12 +1074,12 @@ iowa_status_t iowa_client_IPSO_update_value(iowa_context_t contextP,
     }
 #endif
 
-    CRIT_SECTION_ENTER(contextP);
+    SUBSYSTEM_LOCK_ENTER(contextP, CORE_LOCK_OBJECTS);
 
     if (object_find(contextP, objectId, GET_INSTANCE_ID_FROM_SENSOR(id), IOWA_LWM2M_ID_ALL, &objectP, &instIndex, NULL) != IOWA_COAP_NO_ERROR)
     {
         IOWA_LOG_ERROR(IOWA_PART_OBJECT, "The structure 'lwm2m_object_t' associated with the IPSO sensor has not been found.");
-        CRIT_SECTION_LEAVE(contextP);
+        SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
         return IOWA_COAP_404_NOT_FOUND;
     }
 
@@ -1058,11 +1087,13 @@ iowa_status_t iowa_client_IPSO_update_value(iowa_context_t contextP,
     if (instanceP == NULL)
     {
         IOWA_LOG_ARG_ERROR(IOWA_PART_OBJECT, "IPSO sensor with Object ID %d and Object Instance ID %d has not been found.", &objectId, GET_INSTANCE_ID_FROM_SENSOR(id));
-        CRIT_SECTION_LEAVE(contextP);
+        SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
         return IOWA_COAP_404_NOT_FOUND;
     }
 
+#ifndef IOWA_THREAD_SUPPORT
     clientNotificationLock(contextP, true);
+#endif
 
     // Update the resources value
     valueToUpdate.value = value;
@@ -1071,9 +1102,11 @@ iowa_status_t iowa_client_IPSO_update_value(iowa_context_t contextP,
 
     instanceP->value = value;
 
+#ifndef IOWA_THREAD_SUPPORT
     clientNotificationLock(contextP, false);
+#endif
 
-    CRIT_SECTION_LEAVE(contextP);
+    SUBSYSTEM_LOCK_LEAVE(contextP, CORE_LOCK_OBJECTS);
 
     return IOWA_COAP_NO_ERROR;
 }
@@ -121,6 +121,7 @@ static int prv_mbedtlsRecvFunc(void *userData,
     {
     case SECURITY_STATE_HANDSHAKING:
         if (securityS->channelP->type != IOWA_CONN_STREAM
+            && securityS->channelP->type != IOWA_CONN_WEBSOCKET
             && securityS->dataAvailable == false)
         {
             return MBEDTLS_ERR_SSL_TIMEOUT;
@@ -217,25 +218,27 @@ static int prv_mbedtlsCookieRNG(void *userData,
                                 size_t size)
 {
     // WARNING: This function is called in a critical section
-    static size_t gSize = 0;
-    // Should be COOKIE_MD_OUTLEN but it is not exposed by mbedtls. We use 48 which is the maximum possible value.
-    static uint8_t gKey[48] = {0};
+    iowa_security_context_t securityContextP;
     int result;
 
     IOWA_LOG_TRACE(IOWA_PART_SECURITY, "Entering");
 
-    if (gSize != size)
+    // The cookie key is shared by the sessions of a context
+    securityContextP = ((iowa_security_session_t)userData)->contextP->securityContextP;
+
+    if (securityContextP->cookieKeySize != size)
     {
         result = prv_mbedtlsRandomVectorGenerator(userData, randomBuffer, size);
-        if (result == 0)
+        if (result == 0
+            && size <= sizeof(securityContextP->cookieKey))
         {
-            memcpy(gKey, randomBuffer, size);
-            gSize = size;
+            memcpy(securityContextP->cookieKey, randomBuffer, size);
+            securityContextP->cookieKeySize = size;
         }
     }
     else
     {
-        memcpy(randomBuffer, gKey, size);
+        memcpy(randomBuffer, securityContextP->cookieKey, size);
         result = 0;
     }
 
@@ -261,7 +264,7 @@ static void prv_mbedtlsSetDelay(void *userData,
     }
 
     // Set the timer values
-    securityS->timeout = finMs / 1000;
+    securityS->timeout = (uint32_t)(((uint64_t)finMs * CORE_TIME_UNITS_PER_SECOND) / 1000);
 
     // Get the time when the timer begins
     securityS->startTime = securityS->contextP->currentTime;
@@ -567,6 +570,7 @@ iowa_status_t mbedtlsCreateClientSession(iowa_security_session_t securityS)
     switch (securityS->type)
     {
     case IOWA_CONN_STREAM:
+    case IOWA_CONN_WEBSOCKET:
         transport = MBEDTLS_SSL_TRANSPORT_STREAM;
         break;
 
@@ -760,6 +764,7 @@ iowa_status_t mbedtlsCreateServerSession(iowa_security_session_t securityS)
     switch (securityS->channelP->type)
     {
     case IOWA_CONN_STREAM:
+    case IOWA_CONN_WEBSOCKET:
         transport = MBEDTLS_SSL_TRANSPORT_STREAM;
         break;
 
@@ -474,7 +474,7 @@ iowa_status_t tinydtlsStep(iowa_security_session_t securityS)
 
                 // Calculate the delay before the next retransmission
                 currentTime = iowa_system_gettime();
-                delay = nextTime - currentTime;
+                delay = coreTimeToDelay(CORE_TIME_FROM_SECONDS(nextTime - currentTime));
 
                 if (delay < securityS->contextP->timeout)
                 {
@@ -179,6 +179,34 @@ int securitySend(iowa_context_t contextP,
                  uint8_t *buffer,
                  size_t length);
 
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+// Send several segments as a single datagram on a connection.
+// Segments sent on a secure connection are first gathered in a single buffer.
+// Returned value: the number of bytes sent or a negative number in case of error.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - securityS: the session to use, returned by securityConnect().
+// - segmentArray, segmentCount: data to send.
+int securitySendv(iowa_context_t contextP,
+                  iowa_security_session_t securityS,
+                  iowa_connection_segment_t *segmentArray,
+                  size_t segmentCount);
+#endif
+
+#ifdef IOWA_CONNECTION_RECVV_SUPPORT
+// Receive several datagrams on a connection.
+// Only one datagram is read at a time on a secure connection.
+// Returned value: the number of datagrams received or a negative number in case of error.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - securityS: the session to use, returned by securityConnect().
+// - segmentArray, segmentCount: to store the datagrams.
+int securityRecvv(iowa_context_t contextP,
+                  iowa_security_session_t securityS,
+                  iowa_connection_segment_t *segmentArray,
+                  size_t segmentCount);
+#endif
+
 // Receive data on a secure connection.
 // Returned value: the number of bytes received or a negative number in case of error.
 // Parameters:
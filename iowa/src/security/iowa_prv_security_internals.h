@@ -103,6 +103,11 @@ extern "C" {
 struct _iowa_security_context_t
 {
     iowa_security_session_t sessionList;
+#if ((IOWA_SECURITY_LAYER == IOWA_SECURITY_LAYER_MBEDTLS) || (IOWA_SECURITY_LAYER == IOWA_SECURITY_LAYER_MBEDTLS_PSK_ONLY)) && defined(IOWA_SECURITY_SERVER_MODE)
+    // Should be COOKIE_MD_OUTLEN but it is not exposed by mbedtls. We use 48 which is the maximum possible value.
+    uint8_t                 cookieKey[48];
+    size_t                  cookieKeySize;
+#endif
 };
 
 struct _iowa_security_session_t
@@ -125,8 +130,8 @@ struct _iowa_security_session_t
     mbedtls_ssl_context      sslContext;
     mbedtls_ssl_config       conf;
     int                     *ciphersuites;
-    int32_t                  startTime;
-    uint32_t                 timeout;
+    iowa_time_t              startTime;
+    uint32_t                 timeout;   // in internal time unit
     bool                     dataAvailable;
 #ifdef IOWA_SECURITY_CERTIFICATE_SUPPORT
     // Certificate
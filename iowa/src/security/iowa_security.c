@@ -119,7 +119,7 @@ iowa_status_t securityStep(iowa_context_t contextP)
     iowa_status_t result;
     iowa_security_session_t securityS;
 
-    IOWA_LOG_ARG_INFO(IOWA_PART_SECURITY, "Entering currentTime: %u, timeoutP: %u.", contextP->currentTime, contextP->timeout);
+    IOWA_LOG_ARG_INFO(IOWA_PART_SECURITY, "Entering currentTime: %lld, timeoutP: %d.", (long long)contextP->currentTime, contextP->timeout);
 
     result = IOWA_COAP_NO_ERROR;
     securityS = contextP->securityContextP->sessionList;
@@ -444,6 +444,55 @@ int securitySend(iowa_context_t contextP,
     return bufferSend;
 }
 
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+int securitySendv(iowa_context_t contextP,
+                  iowa_security_session_t securityS,
+                  iowa_connection_segment_t *segmentArray,
+                  size_t segmentCount)
+{
+    // WARNING: This function is called in a critical section
+    int bufferSend;
+    uint8_t *buffer;
+    size_t length;
+    size_t i;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_SECURITY, "Sending %u segments on session %p.", segmentCount, securityS);
+
+    if (securityS->isSecure == false)
+    {
+        return commSendv(contextP, securityS->channelP, segmentArray, segmentCount);
+    }
+
+    length = 0;
+    for (i = 0; i < segmentCount; i++)
+    {
+        length += segmentArray[i].length;
+    }
+
+    buffer = (uint8_t *)iowa_system_malloc(length);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (buffer == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(length);
+        return -1;
+    }
+#endif
+
+    length = 0;
+    for (i = 0; i < segmentCount; i++)
+    {
+        memcpy(buffer + length, segmentArray[i].data, segmentArray[i].length);
+        length += segmentArray[i].length;
+    }
+
+    bufferSend = securitySend(contextP, securityS, buffer, length);
+
+    iowa_system_free(buffer);
+
+    return bufferSend;
+}
+#endif
+
 int securityRecv(iowa_context_t contextP,
                  iowa_security_session_t securityS,
                  uint8_t *buffer,
@@ -473,6 +522,34 @@ int securityRecv(iowa_context_t contextP,
     return bufferReceived;
 }
 
+#ifdef IOWA_CONNECTION_RECVV_SUPPORT
+int securityRecvv(iowa_context_t contextP,
+                  iowa_security_session_t securityS,
+                  iowa_connection_segment_t *segmentArray,
+                  size_t segmentCount)
+{
+    // WARNING: This function is called in a critical section
+    int bufferReceived;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_SECURITY, "Receiving up to %u datagrams on session %p.", segmentCount, securityS);
+
+    if (securityS->isSecure == false)
+    {
+        return commRecvv(contextP, securityS->channelP, segmentArray, segmentCount);
+    }
+
+    // Records are decrypted one by one
+    bufferReceived = securityRecv(contextP, securityS, segmentArray[0].data, segmentArray[0].length);
+    if (bufferReceived <= 0)
+    {
+        return bufferReceived;
+    }
+    segmentArray[0].length = (size_t)bufferReceived;
+
+    return 1;
+}
+#endif
+
 #ifdef IOWA_SECURITY_SERVER_MODE
 iowa_security_session_t securityServerNewSession(iowa_context_t contextP,
                                                  iowa_connection_type_t type,
@@ -113,10 +113,18 @@ const char *iowa_security_session_get_uri(iowa_security_session_t securityS)
 void iowa_security_session_set_step_delay(iowa_security_session_t securityS,
                                           int32_t delay)
 {
-    if (delay >= 0
-        && delay < securityS->contextP->timeout)
+    int32_t timeout;
+
+    if (delay < 0)
+    {
+        return;
+    }
+
+    // The delay is in seconds while the context timeout is in internal time unit
+    timeout = coreTimeToDelay(CORE_TIME_FROM_SECONDS(delay));
+    if (timeout < securityS->contextP->timeout)
     {
-        securityS->contextP->timeout = delay;
+        securityS->contextP->timeout = timeout;
     }
 }
 
@@ -0,0 +1,108 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * Definitions shared by the fleet simulator files.
+ *
+ **************************************************/
+
+#ifndef _FLEET_INCLUDE_
+#define _FLEET_INCLUDE_
+
+// IOWA headers
+#include "iowa_config.h"
+#include "iowa_client.h"
+#include "iowa_ipso.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A virtual device
+typedef struct
+{
+    uint32_t       index;
+    iowa_context_t iowaH;
+    iowa_sensor_t  sensorId;
+    int            sock;             // The socket opened by IOWA, -1 if none
+    uint16_t       port;             // The local port of the socket
+    int64_t        nextStepTime;     // in microseconds
+    bool           stepRequested;
+    int64_t        nextValueTime;    // in microseconds
+    int64_t        nextHeartbeatTime;
+    int64_t        nextReadTime;
+    int64_t        changeTime;       // when the last value was set, 0 if already notified
+    uint32_t       valueCounter;
+    // Server side state
+    bool           registered;
+    int64_t        readTime;         // when the pending Read was sent, 0 if none
+} fleet_client_t;
+
+// A growable array of latency samples
+typedef struct
+{
+    int64_t *sampleArray;
+    size_t   count;
+    size_t   capacity;
+} fleet_samples_t;
+
+// The counters measured by the stand-in server
+typedef struct
+{
+    uint32_t        registrationCount;
+    int64_t         lastRegistrationTime;
+    uint32_t        updateCount;
+    uint32_t        notificationCount;
+    uint32_t        readCount;
+    fleet_samples_t notificationLatency;
+    fleet_samples_t readLatency;
+} fleet_stats_t;
+
+// fleet_connection.c
+
+// Return the monotonic time in microseconds.
+int64_t fleet_now(void);
+
+// Map a local UDP port to the client owning the socket.
+// Returned value: the client or NULL.
+fleet_client_t * fleet_client_from_port(uint16_t port);
+
+// Release the port map.
+void fleet_connection_close(void);
+
+// fleet_server.c
+
+// Open the stand-in LwM2M Server on a loopback UDP port.
+// Returned value: the socket or -1 in case of error.
+// Parameters:
+// - portP: OUT. the local port of the server.
+int fleet_server_open(uint16_t *portP);
+
+// Read and answer all the pending datagrams.
+// Parameters:
+// - sock: as returned by fleet_server_open().
+// - statsP: the counters to update.
+void fleet_server_process(int sock, fleet_stats_t *statsP);
+
+// Send a Read request for the sensor value to a client.
+// Parameters:
+// - sock: as returned by fleet_server_open().
+// - clientP: the target client.
+void fleet_server_read(int sock, fleet_client_t *clientP);
+
+// Release the server resources.
+void fleet_server_close(int sock);
+
+// Add a latency sample.
+void fleet_samples_add(fleet_samples_t *samplesP, int64_t value);
+
+#endif
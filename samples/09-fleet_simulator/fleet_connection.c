@@ -0,0 +1,283 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This file implements the IOWA connection
+ * abstraction functions for the fleet simulator.
+ *
+ * The iowa_init() user data is the fleet_client_t
+ * of the virtual device. Instead of blocking,
+ * iowa_system_connection_select() records when
+ * the device needs to be stepped again and stops
+ * iowa_step() so that one thread can drive all
+ * the devices.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_config.h"
+#include "iowa_platform.h"
+#include "fleet.h"
+
+// Platform specific headers
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+
+// Local UDP port to client map
+static fleet_client_t **g_portMap = NULL;
+
+int64_t fleet_now(void)
+{
+    struct timespec tp;
+
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+
+    return (int64_t)tp.tv_sec * 1000000 + tp.tv_nsec / 1000;
+}
+
+fleet_client_t * fleet_client_from_port(uint16_t port)
+{
+    if (g_portMap == NULL)
+    {
+        return NULL;
+    }
+
+    return g_portMap[port];
+}
+
+void fleet_connection_close(void)
+{
+    free(g_portMap);
+    g_portMap = NULL;
+}
+
+// Only UDP connections are supported.
+void * iowa_system_connection_open(iowa_connection_type_t type,
+                                   char *hostname,
+                                   char *port,
+                                   void *userData)
+{
+    fleet_client_t *clientP;
+    struct addrinfo hints;
+    struct addrinfo *servinfo;
+    struct sockaddr_in localAddr;
+    socklen_t addrLen;
+    int s;
+
+    clientP = (fleet_client_t *)userData;
+
+    if (type != IOWA_CONN_DATAGRAM)
+    {
+        return NULL;
+    }
+
+    if (g_portMap == NULL)
+    {
+        g_portMap = (fleet_client_t **)calloc(UINT16_MAX + 1, sizeof(fleet_client_t *));
+        if (g_portMap == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    servinfo = NULL;
+    if (getaddrinfo(hostname, port, &hints, &servinfo) != 0
+        || servinfo == NULL)
+    {
+        return NULL;
+    }
+
+    s = socket(servinfo->ai_family, servinfo->ai_socktype, servinfo->ai_protocol);
+    if (s == -1)
+    {
+        freeaddrinfo(servinfo);
+        return NULL;
+    }
+
+    if (connect(s, servinfo->ai_addr, servinfo->ai_addrlen) == -1)
+    {
+        close(s);
+        freeaddrinfo(servinfo);
+        return NULL;
+    }
+    freeaddrinfo(servinfo);
+
+    addrLen = sizeof(localAddr);
+    if (getsockname(s, (struct sockaddr *)&localAddr, &addrLen) == -1)
+    {
+        close(s);
+        return NULL;
+    }
+
+    (void)fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK);
+
+    clientP->sock = s;
+    clientP->port = ntohs(localAddr.sin_port);
+    g_portMap[clientP->port] = clientP;
+
+    // The connection is the client itself
+    return clientP;
+}
+
+int iowa_system_connection_send(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    fleet_client_t *clientP;
+
+    (void)userData;
+
+    clientP = (fleet_client_t *)connP;
+
+    return (int)send(clientP->sock, buffer, length, 0);
+}
+
+int iowa_system_connection_sendv(void *connP,
+                                 iowa_connection_segment_t *segmentArray,
+                                 size_t segmentCount,
+                                 void *userData)
+{
+    fleet_client_t *clientP;
+    struct iovec iov[4];
+    struct msghdr message;
+    size_t i;
+
+    (void)userData;
+
+    if (segmentCount > sizeof(iov) / sizeof(struct iovec))
+    {
+        return -1;
+    }
+
+    clientP = (fleet_client_t *)connP;
+
+    for (i = 0; i < segmentCount; i++)
+    {
+        iov[i].iov_base = segmentArray[i].data;
+        iov[i].iov_len = segmentArray[i].length;
+    }
+
+    memset(&message, 0, sizeof(struct msghdr));
+    message.msg_iov = iov;
+    message.msg_iovlen = segmentCount;
+
+    return (int)sendmsg(clientP->sock, &message, 0);
+}
+
+int iowa_system_connection_recv(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    fleet_client_t *clientP;
+    ssize_t result;
+
+    (void)userData;
+
+    clientP = (fleet_client_t *)connP;
+
+    result = recv(clientP->sock, buffer, length, 0);
+    if (result < 0)
+    {
+        // Nothing to read on a non-blocking socket
+        return 0;
+    }
+
+    return (int)result;
+}
+
+void iowa_system_connection_close(void *connP,
+                                  void *userData)
+{
+    fleet_client_t *clientP;
+
+    (void)userData;
+
+    clientP = (fleet_client_t *)connP;
+
+    if (g_portMap != NULL)
+    {
+        g_portMap[clientP->port] = NULL;
+    }
+    close(clientP->sock);
+    clientP->sock = -1;
+    clientP->port = 0;
+}
+
+// The sockets are polled without waiting. The timeout is the delay until
+// the next IOWA operation: the device is stepped again at this time, or
+// earlier if data is received.
+int iowa_system_connection_select(void **connArray,
+                                  size_t connCount,
+                                  int32_t timeout,
+                                  void *userData)
+{
+    fleet_client_t *clientP;
+    struct pollfd fds[4];
+    size_t i;
+    int result;
+
+    clientP = (fleet_client_t *)userData;
+
+#ifdef IOWA_TIME_MS_SUPPORT
+    clientP->nextStepTime = fleet_now() + (int64_t)timeout * 1000;
+#else
+    clientP->nextStepTime = fleet_now() + (int64_t)timeout * 1000000;
+#endif
+
+    // Make iowa_step() return after this iteration
+    iowa_stop(clientP->iowaH);
+
+    if (connCount == 0)
+    {
+        return 0;
+    }
+    if (connCount > sizeof(fds) / sizeof(fds[0]))
+    {
+        connCount = sizeof(fds) / sizeof(fds[0]);
+    }
+
+    for (i = 0; i < connCount; i++)
+    {
+        fds[i].fd = ((fleet_client_t *)connArray[i])->sock;
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+    }
+
+    result = poll(fds, connCount, 0);
+    if (result > 0)
+    {
+        for (i = 0; i < connCount; i++)
+        {
+            if ((fds[i].revents & POLLIN) == 0)
+            {
+                connArray[i] = NULL;
+            }
+        }
+    }
+
+    return result;
+}
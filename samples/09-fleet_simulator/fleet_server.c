@@ -0,0 +1,454 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This file implements a minimal stand-in LwM2M
+ * Server. It accepts the registrations and the
+ * registration updates, observes the IPSO sensor
+ * value of each client and measures the latency
+ * of the notifications and of the Read requests.
+ *
+ **************************************************/
+
+#include "fleet.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define PRV_COAP_TYPE_CON    0
+#define PRV_COAP_TYPE_NON    1
+#define PRV_COAP_TYPE_ACK    2
+#define PRV_COAP_TYPE_RST    3
+
+#define PRV_COAP_CODE_EMPTY   0x00
+#define PRV_COAP_CODE_GET     0x01
+#define PRV_COAP_CODE_POST    0x02
+#define PRV_COAP_CODE_DELETE  0x04
+#define PRV_COAP_CODE_201     0x41
+#define PRV_COAP_CODE_202     0x42
+#define PRV_COAP_CODE_204     0x44
+#define PRV_COAP_CODE_404     0x84
+
+#define PRV_COAP_OPTION_OBSERVE   6
+#define PRV_COAP_OPTION_URI_PATH  11
+
+#define PRV_TOKEN_LENGTH   2
+#define PRV_TOKEN_OBSERVE  "ob"
+#define PRV_TOKEN_READ     "rd"
+
+#define PRV_DATAGRAM_SIZE  1500
+
+typedef struct
+{
+    uint8_t        type;
+    uint8_t        code;
+    uint16_t       mid;
+    uint8_t        tokenLength;
+    const uint8_t *token;
+    uint8_t        pathCount;
+} prv_message_t;
+
+static uint16_t g_nextMid = 1;
+
+// Parse the header and the options of a CoAP message.
+// Returned value: true if the message is valid.
+static bool prv_parse(const uint8_t *buffer,
+                      size_t length,
+                      prv_message_t *messageP)
+{
+    size_t pos;
+    uint16_t number;
+
+    if (length < 4
+        || (buffer[0] >> 6) != 1)
+    {
+        return false;
+    }
+
+    messageP->type = (buffer[0] >> 4) & 0x03;
+    messageP->tokenLength = buffer[0] & 0x0F;
+    messageP->code = buffer[1];
+    messageP->mid = (uint16_t)((buffer[2] << 8) | buffer[3]);
+    messageP->token = buffer + 4;
+    messageP->pathCount = 0;
+
+    if (messageP->tokenLength > 8
+        || 4 + (size_t)messageP->tokenLength > length)
+    {
+        return false;
+    }
+
+    pos = 4 + (size_t)messageP->tokenLength;
+    number = 0;
+    while (pos < length
+           && buffer[pos] != 0xFF)
+    {
+        size_t delta;
+        size_t optionLength;
+
+        delta = buffer[pos] >> 4;
+        optionLength = buffer[pos] & 0x0F;
+        pos++;
+
+        if (delta == 13)
+        {
+            if (pos >= length) return false;
+            delta = 13 + (size_t)buffer[pos];
+            pos++;
+        }
+        else if (delta == 14)
+        {
+            if (pos + 1 >= length) return false;
+            delta = 269 + (((size_t)buffer[pos] << 8) | buffer[pos + 1]);
+            pos += 2;
+        }
+        if (optionLength == 13)
+        {
+            if (pos >= length) return false;
+            optionLength = 13 + (size_t)buffer[pos];
+            pos++;
+        }
+        else if (optionLength == 14)
+        {
+            if (pos + 1 >= length) return false;
+            optionLength = 269 + (((size_t)buffer[pos] << 8) | buffer[pos + 1]);
+            pos += 2;
+        }
+
+        number = (uint16_t)(number + delta);
+        if (number == PRV_COAP_OPTION_URI_PATH)
+        {
+            messageP->pathCount++;
+        }
+
+        pos += optionLength;
+    }
+
+    return pos <= length;
+}
+
+static void prv_sendTo(int sock,
+                       uint16_t port,
+                       const uint8_t *buffer,
+                       size_t length)
+{
+    struct sockaddr_in addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    (void)sendto(sock, buffer, length, 0, (struct sockaddr *)&addr, sizeof(addr));
+}
+
+// Answer a request from a client, piggybacked if the request is confirmable.
+static void prv_sendResponse(int sock,
+                             uint16_t port,
+                             const prv_message_t *requestP,
+                             uint8_t code,
+                             const uint8_t *options,
+                             size_t optionsLength)
+{
+    uint8_t buffer[64];
+    size_t length;
+    uint16_t mid;
+
+    if (requestP->type == PRV_COAP_TYPE_CON)
+    {
+        buffer[0] = (uint8_t)(0x40 | (PRV_COAP_TYPE_ACK << 4) | requestP->tokenLength);
+        mid = requestP->mid;
+    }
+    else
+    {
+        buffer[0] = (uint8_t)(0x40 | (PRV_COAP_TYPE_NON << 4) | requestP->tokenLength);
+        mid = g_nextMid++;
+    }
+    buffer[1] = code;
+    buffer[2] = (uint8_t)(mid >> 8);
+    buffer[3] = (uint8_t)(mid & 0xFF);
+    memcpy(buffer + 4, requestP->token, requestP->tokenLength);
+    length = 4 + (size_t)requestP->tokenLength;
+    memcpy(buffer + length, options, optionsLength);
+    length += optionsLength;
+
+    prv_sendTo(sock, port, buffer, length);
+}
+
+static void prv_sendEmptyAck(int sock,
+                             uint16_t port,
+                             uint16_t mid)
+{
+    uint8_t buffer[4];
+
+    buffer[0] = (uint8_t)(0x40 | (PRV_COAP_TYPE_ACK << 4));
+    buffer[1] = PRV_COAP_CODE_EMPTY;
+    buffer[2] = (uint8_t)(mid >> 8);
+    buffer[3] = (uint8_t)(mid & 0xFF);
+
+    prv_sendTo(sock, port, buffer, sizeof(buffer));
+}
+
+// Send a confirmable GET on /3303/0/5700 with an optional Observe option.
+static void prv_sendGet(int sock,
+                        uint16_t port,
+                        const char *token,
+                        bool observe)
+{
+    uint8_t buffer[32];
+    size_t length;
+    uint16_t mid;
+
+    mid = g_nextMid++;
+
+    buffer[0] = (uint8_t)(0x40 | (PRV_COAP_TYPE_CON << 4) | PRV_TOKEN_LENGTH);
+    buffer[1] = PRV_COAP_CODE_GET;
+    buffer[2] = (uint8_t)(mid >> 8);
+    buffer[3] = (uint8_t)(mid & 0xFF);
+    memcpy(buffer + 4, token, PRV_TOKEN_LENGTH);
+    length = 4 + PRV_TOKEN_LENGTH;
+
+    if (observe == true)
+    {
+        // Observe: 0 (empty value), then Uri-Path with a delta of 5
+        buffer[length++] = (uint8_t)(PRV_COAP_OPTION_OBSERVE << 4);
+        buffer[length++] = (uint8_t)(((PRV_COAP_OPTION_URI_PATH - PRV_COAP_OPTION_OBSERVE) << 4) | 4);
+    }
+    else
+    {
+        buffer[length++] = (uint8_t)((PRV_COAP_OPTION_URI_PATH << 4) | 4);
+    }
+    memcpy(buffer + length, "3303", 4);
+    length += 4;
+    buffer[length++] = 0x01;
+    buffer[length++] = '0';
+    buffer[length++] = 0x04;
+    memcpy(buffer + length, "5700", 4);
+    length += 4;
+
+    prv_sendTo(sock, port, buffer, length);
+}
+
+static void prv_handleRequest(int sock,
+                              fleet_client_t *clientP,
+                              const prv_message_t *messageP,
+                              fleet_stats_t *statsP)
+{
+    switch (messageP->code)
+    {
+    case PRV_COAP_CODE_POST:
+        if (messageP->pathCount == 1)
+        {
+            // Registration: the location is /rd/<client index>
+            uint8_t options[16];
+            size_t optionsLength;
+            int indexLength;
+
+            options[0] = 0x82;
+            options[1] = 'r';
+            options[2] = 'd';
+            indexLength = snprintf((char *)options + 4, sizeof(options) - 4, "%u", clientP->index);
+            options[3] = (uint8_t)indexLength;
+            optionsLength = 4 + (size_t)indexLength;
+
+            prv_sendResponse(sock, clientP->port, messageP, PRV_COAP_CODE_201, options, optionsLength);
+
+            if (clientP->registered == false)
+            {
+                clientP->registered = true;
+                statsP->registrationCount++;
+                statsP->lastRegistrationTime = fleet_now();
+
+                prv_sendGet(sock, clientP->port, PRV_TOKEN_OBSERVE, true);
+            }
+        }
+        else
+        {
+            // Registration Update
+            prv_sendResponse(sock, clientP->port, messageP, PRV_COAP_CODE_204, NULL, 0);
+            statsP->updateCount++;
+        }
+        break;
+
+    case PRV_COAP_CODE_DELETE:
+        prv_sendResponse(sock, clientP->port, messageP, PRV_COAP_CODE_202, NULL, 0);
+        clientP->registered = false;
+        break;
+
+    default:
+        prv_sendResponse(sock, clientP->port, messageP, PRV_COAP_CODE_404, NULL, 0);
+        break;
+    }
+}
+
+static void prv_handleResponse(int sock,
+                               fleet_client_t *clientP,
+                               const prv_message_t *messageP,
+                               fleet_stats_t *statsP)
+{
+    int64_t now;
+
+    now = fleet_now();
+
+    if (messageP->tokenLength == PRV_TOKEN_LENGTH
+        && memcmp(messageP->token, PRV_TOKEN_READ, PRV_TOKEN_LENGTH) == 0)
+    {
+        if (clientP->readTime != 0)
+        {
+            fleet_samples_add(&statsP->readLatency, now - clientP->readTime);
+            statsP->readCount++;
+            clientP->readTime = 0;
+        }
+    }
+    else if (messageP->tokenLength == PRV_TOKEN_LENGTH
+             && memcmp(messageP->token, PRV_TOKEN_OBSERVE, PRV_TOKEN_LENGTH) == 0)
+    {
+        // The piggybacked response to the Observe request is not a notification
+        if (messageP->type != PRV_COAP_TYPE_ACK)
+        {
+            statsP->notificationCount++;
+            if (clientP->changeTime != 0)
+            {
+                fleet_samples_add(&statsP->notificationLatency, now - clientP->changeTime);
+                clientP->changeTime = 0;
+            }
+        }
+    }
+
+    if (messageP->type == PRV_COAP_TYPE_CON)
+    {
+        prv_sendEmptyAck(sock, clientP->port, messageP->mid);
+    }
+}
+
+int fleet_server_open(uint16_t *portP)
+{
+    struct sockaddr_in addr;
+    socklen_t addrLen;
+    int bufferSize;
+    int sock;
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock == -1)
+    {
+        return -1;
+    }
+
+    // Absorb the registration burst
+    bufferSize = 8 * 1024 * 1024;
+    (void)setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    addrLen = sizeof(addr);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1
+        || getsockname(sock, (struct sockaddr *)&addr, &addrLen) == -1)
+    {
+        close(sock);
+        return -1;
+    }
+
+    (void)fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+
+    *portP = ntohs(addr.sin_port);
+
+    return sock;
+}
+
+void fleet_server_process(int sock,
+                          fleet_stats_t *statsP)
+{
+    uint8_t buffer[PRV_DATAGRAM_SIZE];
+
+    while (true)
+    {
+        struct sockaddr_in addr;
+        socklen_t addrLen;
+        ssize_t length;
+        fleet_client_t *clientP;
+        prv_message_t message;
+
+        addrLen = sizeof(addr);
+        length = recvfrom(sock, buffer, sizeof(buffer), 0, (struct sockaddr *)&addr, &addrLen);
+        if (length <= 0)
+        {
+            break;
+        }
+
+        clientP = fleet_client_from_port(ntohs(addr.sin_port));
+        if (clientP == NULL
+            || prv_parse(buffer, (size_t)length, &message) == false)
+        {
+            continue;
+        }
+
+        if (message.code == PRV_COAP_CODE_EMPTY)
+        {
+            // ACK of a notification or a reset
+            continue;
+        }
+
+        if ((message.code >> 5) == 0)
+        {
+            prv_handleRequest(sock, clientP, &message, statsP);
+        }
+        else
+        {
+            prv_handleResponse(sock, clientP, &message, statsP);
+        }
+    }
+}
+
+void fleet_server_read(int sock,
+                       fleet_client_t *clientP)
+{
+    clientP->readTime = fleet_now();
+    prv_sendGet(sock, clientP->port, PRV_TOKEN_READ, false);
+}
+
+void fleet_server_close(int sock)
+{
+    close(sock);
+}
+
+void fleet_samples_add(fleet_samples_t *samplesP,
+                       int64_t value)
+{
+    if (samplesP->count == samplesP->capacity)
+    {
+        int64_t *newArray;
+        size_t newCapacity;
+
+        newCapacity = samplesP->capacity == 0 ? 1024 : samplesP->capacity * 2;
+        newArray = (int64_t *)realloc(samplesP->sampleArray, newCapacity * sizeof(int64_t));
+        if (newArray == NULL)
+        {
+            return;
+        }
+        samplesP->sampleArray = newArray;
+        samplesP->capacity = newCapacity;
+    }
+
+    samplesP->sampleArray[samplesP->count] = value;
+    samplesP->count++;
+}
@@ -0,0 +1,481 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This is a fleet-scale benchmark running many
+ * LwM2M Clients featuring an IPSO Temperature
+ * sensor in a single process against a stand-in
+ * LwM2M Server over loopback UDP.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "fleet.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/resource.h>
+
+#define SERVER_SHORT_ID 1234
+#define SERVER_LIFETIME 300
+
+#define DEFAULT_CLIENT_COUNT 100
+#define DEFAULT_DURATION     30
+
+// Workload periods in microseconds
+#define VALUE_PERIOD     2000000
+#define READ_PERIOD      5000000
+#define HEARTBEAT_PERIOD 10000000
+
+// Maximum time spent waiting for the sockets in milliseconds
+#define MAX_WAIT_MS 100
+
+static int prv_compareSamples(const void *a,
+                              const void *b)
+{
+    int64_t va;
+    int64_t vb;
+
+    va = *(const int64_t *)a;
+    vb = *(const int64_t *)b;
+
+    return (va > vb) - (va < vb);
+}
+
+// Return a percentile of the samples in microseconds, sorting them.
+static int64_t prv_percentile(fleet_samples_t *samplesP,
+                              unsigned int percent)
+{
+    size_t index;
+
+    if (samplesP->count == 0)
+    {
+        return 0;
+    }
+
+    qsort(samplesP->sampleArray, samplesP->count, sizeof(int64_t), prv_compareSamples);
+
+    index = (samplesP->count * percent) / 100;
+    if (index >= samplesP->count)
+    {
+        index = samplesP->count - 1;
+    }
+
+    return samplesP->sampleArray[index];
+}
+
+// Return the resident set size of the process in KiB.
+static long prv_getRss(void)
+{
+    FILE *fileP;
+    long size;
+    long resident;
+
+    fileP = fopen("/proc/self/statm", "r");
+    if (fileP == NULL)
+    {
+        return 0;
+    }
+    if (fscanf(fileP, "%ld %ld", &size, &resident) != 2)
+    {
+        resident = 0;
+    }
+    fclose(fileP);
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static int64_t prv_getCpuTime(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return (int64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+           + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+// Raise the limit of open file descriptors to fit one socket per client.
+static void prv_raiseFileLimit(uint32_t clientCount)
+{
+    struct rlimit limit;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0
+        && limit.rlim_cur < (rlim_t)clientCount + 16)
+    {
+        limit.rlim_cur = (rlim_t)clientCount + 16;
+        if (limit.rlim_cur > limit.rlim_max)
+        {
+            limit.rlim_cur = limit.rlim_max;
+        }
+        (void)setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+// Sum the memory pool counters of all the clients.
+static void prv_getPoolStats(fleet_client_t *clientArray,
+                             uint32_t clientCount,
+                             iowa_memory_pool_stats_t *totalP)
+{
+    uint32_t i;
+
+    memset(totalP, 0, sizeof(iowa_memory_pool_stats_t));
+
+    for (i = 0; i < clientCount; i++)
+    {
+        iowa_memory_pool_stats_t poolStats;
+
+        if (clientArray[i].iowaH != NULL
+            && iowa_memory_pool_get_stats(clientArray[i].iowaH, &poolStats) == IOWA_COAP_NO_ERROR)
+        {
+            totalP->capacity += poolStats.capacity;
+            totalP->inUseCount += poolStats.inUseCount;
+            totalP->poolAllocCount += poolStats.poolAllocCount;
+            totalP->heapAllocCount += poolStats.heapAllocCount;
+            totalP->heapFreeCount += poolStats.heapFreeCount;
+        }
+    }
+}
+#endif
+
+static bool prv_startClient(fleet_client_t *clientP,
+                            uint16_t serverPort)
+{
+    iowa_status_t result;
+    iowa_device_info_t devInfo;
+    char endpointName[32];
+    char serverUri[64];
+
+    clientP->sock = -1;
+
+    clientP->iowaH = iowa_init(clientP);
+    if (clientP->iowaH == NULL)
+    {
+        fprintf(stderr, "IOWA context initialization failed.\r\n");
+        return false;
+    }
+
+    snprintf(endpointName, sizeof(endpointName), "fleet_%u", clientP->index);
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    devInfo.modelNumber = "fleet_simulator";
+
+    result = iowa_client_configure(clientP->iowaH, endpointName, &devInfo, NULL);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "IOWA Client configuration failed (%u.%02u).\r\n", (result & 0xFF) >> 5, (result & 0x1F));
+        return false;
+    }
+
+    result = iowa_client_IPSO_add_sensor(clientP->iowaH, IOWA_IPSO_TEMPERATURE, 20, "Cel", "Test Temperature", -20.0, 50.0, &clientP->sensorId);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "Adding the temperature sensor failed (%u.%02u).\r\n", (result & 0xFF) >> 5, (result & 0x1F));
+        return false;
+    }
+
+    snprintf(serverUri, sizeof(serverUri), "coap://127.0.0.1:%u", serverPort);
+    result = iowa_client_add_server(clientP->iowaH, SERVER_SHORT_ID, serverUri, SERVER_LIFETIME, 0, IOWA_SEC_NONE);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "Adding a server failed (%u.%02u).\r\n", (result & 0xFF) >> 5, (result & 0x1F));
+        return false;
+    }
+
+    return true;
+}
+
+static void prv_stopClient(fleet_client_t *clientP)
+{
+    if (clientP->iowaH != NULL)
+    {
+        iowa_client_IPSO_remove_sensor(clientP->iowaH, clientP->sensorId);
+        iowa_client_remove_server(clientP->iowaH, SERVER_SHORT_ID);
+        iowa_close(clientP->iowaH);
+        clientP->iowaH = NULL;
+    }
+}
+
+// Trigger the periodic operations of a client.
+static void prv_runWorkload(int serverSock,
+                            fleet_client_t *clientP,
+                            int64_t now)
+{
+    if (clientP->registered == false)
+    {
+        return;
+    }
+
+    if (now >= clientP->nextValueTime)
+    {
+        clientP->valueCounter++;
+        if (iowa_client_IPSO_update_value(clientP->iowaH, clientP->sensorId, (float)(20 + clientP->valueCounter % 10)) == IOWA_COAP_NO_ERROR
+            && clientP->changeTime == 0)
+        {
+            clientP->changeTime = now;
+        }
+        clientP->stepRequested = true;
+        clientP->nextValueTime += VALUE_PERIOD;
+    }
+
+    if (now >= clientP->nextHeartbeatTime)
+    {
+        (void)iowa_client_send_heartbeat(clientP->iowaH, SERVER_SHORT_ID);
+        clientP->stepRequested = true;
+        clientP->nextHeartbeatTime += HEARTBEAT_PERIOD;
+    }
+
+    if (now >= clientP->nextReadTime)
+    {
+        fleet_server_read(serverSock, clientP);
+        clientP->nextReadTime += READ_PERIOD;
+    }
+}
+
+int main(int argc,
+         char *argv[])
+{
+    uint32_t clientCount;
+    int64_t duration;
+    fleet_client_t *clientArray;
+    struct pollfd *fdArray;
+    fleet_stats_t stats;
+    int serverSock;
+    uint16_t serverPort;
+    long startRss;
+    long endRss;
+    int64_t startCpu;
+    int64_t cpuTime;
+    int64_t startTime;
+    int64_t endTime;
+    int64_t now;
+    uint32_t i;
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+    iowa_memory_pool_stats_t poolStats;
+    iowa_memory_pool_stats_t steadyPoolStats; // when all the clients are registered
+    bool steadyState;
+#endif
+
+    clientCount = DEFAULT_CLIENT_COUNT;
+    duration = DEFAULT_DURATION;
+    if (argc > 1)
+    {
+        clientCount = (uint32_t)strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2)
+    {
+        duration = (int64_t)strtoul(argv[2], NULL, 10);
+    }
+    if (clientCount == 0
+        || clientCount > UINT16_MAX / 2)
+    {
+        fprintf(stderr, "Usage: %s [client count] [duration in seconds]\r\n", argv[0]);
+        return 1;
+    }
+
+    printf("Simulating %u LwM2M Clients for %lld seconds.\r\n\n", clientCount, (long long)duration);
+
+    prv_raiseFileLimit(clientCount);
+
+    memset(&stats, 0, sizeof(fleet_stats_t));
+    clientArray = NULL;
+    fdArray = NULL;
+
+    serverSock = fleet_server_open(&serverPort);
+    if (serverSock == -1)
+    {
+        fprintf(stderr, "Opening the server socket failed.\r\n");
+        return 1;
+    }
+
+    startRss = prv_getRss();
+    startCpu = prv_getCpuTime();
+    startTime = fleet_now();
+
+    clientArray = (fleet_client_t *)calloc(clientCount, sizeof(fleet_client_t));
+    fdArray = (struct pollfd *)calloc(clientCount + 1, sizeof(struct pollfd));
+    if (clientArray == NULL
+        || fdArray == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed.\r\n");
+        goto cleanup;
+    }
+
+    for (i = 0; i < clientCount; i++)
+    {
+        fleet_client_t *clientP;
+        int64_t offset;
+
+        clientP = clientArray + i;
+        clientP->index = i;
+
+        // Spread the periodic operations of the clients over their periods
+        offset = ((int64_t)i * 1000000) / clientCount;
+        clientP->nextValueTime = startTime + VALUE_PERIOD + offset * (VALUE_PERIOD / 1000000);
+        clientP->nextReadTime = startTime + READ_PERIOD + offset * (READ_PERIOD / 1000000);
+        clientP->nextHeartbeatTime = startTime + HEARTBEAT_PERIOD + offset * (HEARTBEAT_PERIOD / 1000000);
+        clientP->stepRequested = true;
+
+        if (prv_startClient(clientP, serverPort) == false)
+        {
+            goto cleanup;
+        }
+    }
+
+    endTime = startTime + duration * 1000000;
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+    steadyState = false;
+    memset(&steadyPoolStats, 0, sizeof(iowa_memory_pool_stats_t));
+#endif
+    now = fleet_now();
+    while (now < endTime)
+    {
+        int64_t nextTime;
+        int timeout;
+
+        nextTime = now + MAX_WAIT_MS * 1000;
+
+        for (i = 0; i < clientCount; i++)
+        {
+            fleet_client_t *clientP;
+
+            clientP = clientArray + i;
+
+            prv_runWorkload(serverSock, clientP, now);
+
+            if (clientP->stepRequested == true)
+            {
+                nextTime = now;
+            }
+            if (clientP->nextStepTime < nextTime)
+            {
+                nextTime = clientP->nextStepTime;
+            }
+            if (clientP->registered == true)
+            {
+                if (clientP->nextValueTime < nextTime)
+                {
+                    nextTime = clientP->nextValueTime;
+                }
+                if (clientP->nextReadTime < nextTime)
+                {
+                    nextTime = clientP->nextReadTime;
+                }
+                if (clientP->nextHeartbeatTime < nextTime)
+                {
+                    nextTime = clientP->nextHeartbeatTime;
+                }
+            }
+
+            fdArray[i + 1].fd = clientP->sock;
+            fdArray[i + 1].events = POLLIN;
+            fdArray[i + 1].revents = 0;
+        }
+        fdArray[0].fd = serverSock;
+        fdArray[0].events = POLLIN;
+        fdArray[0].revents = 0;
+
+        timeout = nextTime > now ? (int)((nextTime - now + 999) / 1000) : 0;
+        (void)poll(fdArray, clientCount + 1, timeout);
+
+        if ((fdArray[0].revents & POLLIN) != 0)
+        {
+            fleet_server_process(serverSock, &stats);
+        }
+
+        now = fleet_now();
+        for (i = 0; i < clientCount; i++)
+        {
+            fleet_client_t *clientP;
+
+            clientP = clientArray + i;
+
+            if ((fdArray[i + 1].revents & POLLIN) != 0
+                || clientP->stepRequested == true
+                || now >= clientP->nextStepTime)
+            {
+                clientP->stepRequested = false;
+                // The connection abstraction stops iowa_step() after one iteration.
+                (void)iowa_step(clientP->iowaH, 3600);
+            }
+        }
+
+        // Answer the messages sent during this round without waiting
+        fleet_server_process(serverSock, &stats);
+
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+        if (steadyState == false
+            && stats.registrationCount == clientCount)
+        {
+            prv_getPoolStats(clientArray, clientCount, &steadyPoolStats);
+            steadyState = true;
+        }
+#endif
+
+        now = fleet_now();
+    }
+
+    cpuTime = prv_getCpuTime() - startCpu;
+    endRss = prv_getRss();
+
+    printf("Clients:             %u\r\n", clientCount);
+    printf("Duration:            %lld s\r\n", (long long)duration);
+    printf("Registrations:       %u", stats.registrationCount);
+    if (stats.registrationCount > 0
+        && stats.lastRegistrationTime > startTime)
+    {
+        printf(" (%.1f /s)", (double)stats.registrationCount * 1000000.0 / (double)(stats.lastRegistrationTime - startTime));
+    }
+    printf("\r\n");
+    printf("Updates:             %u\r\n", stats.updateCount);
+    printf("Notifications:       %u (p50: %.3f ms, p99: %.3f ms)\r\n",
+           stats.notificationCount,
+           (double)prv_percentile(&stats.notificationLatency, 50) / 1000.0,
+           (double)prv_percentile(&stats.notificationLatency, 99) / 1000.0);
+    printf("Reads:               %u (p50: %.3f ms, p99: %.3f ms)\r\n",
+           stats.readCount,
+           (double)prv_percentile(&stats.readLatency, 50) / 1000.0,
+           (double)prv_percentile(&stats.readLatency, 99) / 1000.0);
+    printf("CPU per client:      %.3f ms (%.4f %% of a core)\r\n",
+           (double)cpuTime / 1000.0 / clientCount,
+           (double)cpuTime * 100.0 / (double)(duration * 1000000) / clientCount);
+    printf("RSS per client:      %.1f KiB\r\n", (double)(endRss - startRss) / clientCount);
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+    prv_getPoolStats(clientArray, clientCount, &poolStats);
+    printf("Pool allocations:    %u (heap fallbacks: %u, %u after all the clients registered)\r\n",
+           poolStats.poolAllocCount,
+           poolStats.heapAllocCount,
+           steadyState == true ? poolStats.heapAllocCount - steadyPoolStats.heapAllocCount : 0);
+#endif
+
+cleanup:
+    if (clientArray != NULL)
+    {
+        for (i = 0; i < clientCount; i++)
+        {
+            prv_stopClient(clientArray + i);
+        }
+    }
+    free(clientArray);
+    free(fdArray);
+    free(stats.notificationLatency.sampleArray);
+    free(stats.readLatency.sampleArray);
+    fleet_server_close(serverSock);
+    fleet_connection_close();
+
+    return 0;
+}
@@ -19,7 +19,14 @@
 
 // IOWA header
 #include "iowa_config.h"
+
+#if defined(IOWA_CONNECTION_RECVV_SUPPORT) && !defined(_GNU_SOURCE)
+// For recvmmsg()
+#define _GNU_SOURCE
+#endif
+
 #include "iowa_platform.h"
+#include "sample_abstraction.h"
 
 // Platform specific headers
 #include <stdio.h>
@@ -34,6 +41,16 @@
 #include <unistd.h>
 #include <netdb.h>
 #include <errno.h>
+#if defined(IOWA_CONNECTION_SENDV_SUPPORT) || defined(IOWA_CONNECTION_RECVV_SUPPORT)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+#include <sys/epoll.h>
+#ifdef IOWA_THREAD_SUPPORT
+#include <sys/eventfd.h>
+#endif
+#endif
 #endif
 
 // For POSIX platforms, we use BSD sockets.
@@ -80,6 +97,8 @@ void * iowa_system_connection_open(iowa_connection_type_t type,
         break;
 
     case IOWA_CONN_STREAM:
+    case IOWA_CONN_WEBSOCKET:
+        // WebSockets run over a TCP connection
         hints.ai_socktype = SOCK_STREAM;
         break;
 
@@ -160,6 +179,49 @@ int iowa_system_connection_send(void *connP,
     return nbSent;
 }
 
+#ifdef IOWA_CONNECTION_SENDV_SUPPORT
+
+#ifdef _WIN32
+#error "This sample implements IOWA_CONNECTION_SENDV_SUPPORT only with POSIX sendmsg()."
+#endif
+
+// Maximum number of segments sent in one datagram
+#define SAMPLE_SEGMENT_MAX_COUNT 4
+
+// The segments are gathered by the kernel.
+int iowa_system_connection_sendv(void *connP,
+                                 iowa_connection_segment_t *segmentArray,
+                                 size_t segmentCount,
+                                 void *userData)
+{
+    sample_connection_t *connectionP;
+    struct iovec iov[SAMPLE_SEGMENT_MAX_COUNT];
+    struct msghdr message;
+    size_t i;
+
+    (void)userData;
+
+    if (segmentCount > SAMPLE_SEGMENT_MAX_COUNT)
+    {
+        return -1;
+    }
+
+    connectionP = (sample_connection_t *)connP;
+
+    for (i = 0; i < segmentCount; i++)
+    {
+        iov[i].iov_base = segmentArray[i].data;
+        iov[i].iov_len = segmentArray[i].length;
+    }
+
+    memset(&message, 0, sizeof(struct msghdr));
+    message.msg_iov = iov;
+    message.msg_iovlen = segmentCount;
+
+    return (int)sendmsg(connectionP->sock, &message, 0);
+}
+#endif
+
 // Since the socket is binded, it receives datagrams only from the binded address.
 int iowa_system_connection_recv(void *connP,
                                 uint8_t *buffer,
@@ -185,6 +247,55 @@ int iowa_system_connection_recv(void *connP,
     return numBytes;
 }
 
+#ifdef IOWA_CONNECTION_RECVV_SUPPORT
+
+#ifdef _WIN32
+#error "This sample implements IOWA_CONNECTION_RECVV_SUPPORT only with Linux recvmmsg()."
+#endif
+
+// Maximum number of datagrams read in one call
+#define SAMPLE_DATAGRAM_MAX_COUNT 16
+
+// The datagrams already queued on the socket are read with a single system call.
+int iowa_system_connection_recvv(void *connP,
+                                 iowa_connection_segment_t *segmentArray,
+                                 size_t segmentCount,
+                                 void *userData)
+{
+    sample_connection_t *connectionP;
+    struct iovec iov[SAMPLE_DATAGRAM_MAX_COUNT];
+    struct mmsghdr messageArray[SAMPLE_DATAGRAM_MAX_COUNT];
+    int result;
+    int i;
+
+    (void)userData;
+
+    if (segmentCount > SAMPLE_DATAGRAM_MAX_COUNT)
+    {
+        segmentCount = SAMPLE_DATAGRAM_MAX_COUNT;
+    }
+
+    connectionP = (sample_connection_t *)connP;
+
+    memset(messageArray, 0, segmentCount * sizeof(struct mmsghdr));
+    for (i = 0; i < (int)segmentCount; i++)
+    {
+        iov[i].iov_base = segmentArray[i].data;
+        iov[i].iov_len = segmentArray[i].length;
+        messageArray[i].msg_hdr.msg_iov = iov + i;
+        messageArray[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    result = recvmmsg(connectionP->sock, messageArray, (unsigned int)segmentCount, MSG_DONTWAIT, NULL);
+    for (i = 0; i < result; i++)
+    {
+        segmentArray[i].length = messageArray[i].msg_len;
+    }
+
+    return result;
+}
+#endif
+
 void iowa_system_connection_close(void *connP,
                                   void *userData)
 {
@@ -203,7 +314,165 @@ void iowa_system_connection_close(void *connP,
     free(connectionP);
 }
 
-#ifndef IOWA_THREAD_SUPPORT
+#if defined(IOWA_CONNECTION_WAIT_SUPPORT)
+
+#ifdef _WIN32
+#error "This sample implements IOWA_CONNECTION_WAIT_SUPPORT only with Linux epoll."
+#endif
+
+int sample_wait_context_init(sample_wait_context_t *waitP)
+{
+    waitP->interruptFd = -1;
+
+    waitP->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (waitP->epollFd == -1)
+    {
+        return -1;
+    }
+
+#ifdef IOWA_THREAD_SUPPORT
+    {
+        struct epoll_event event;
+
+        waitP->interruptFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (waitP->interruptFd == -1)
+        {
+            sample_wait_context_close(waitP);
+            return -1;
+        }
+
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = NULL;
+        if (epoll_ctl(waitP->epollFd, EPOLL_CTL_ADD, waitP->interruptFd, &event) == -1)
+        {
+            sample_wait_context_close(waitP);
+            return -1;
+        }
+    }
+#endif
+
+    return 0;
+}
+
+void sample_wait_context_close(sample_wait_context_t *waitP)
+{
+    if (waitP->interruptFd != -1)
+    {
+        close(waitP->interruptFd);
+        waitP->interruptFd = -1;
+    }
+    if (waitP->epollFd != -1)
+    {
+        close(waitP->epollFd);
+        waitP->epollFd = -1;
+    }
+}
+
+// The socket is added to the epoll instance of the IOWA context with IOWA's handle as user data.
+int iowa_system_connection_register(void *connP,
+                                    void *handle,
+                                    void *userData)
+{
+    sample_wait_context_t *waitP;
+    sample_connection_t *connectionP;
+    struct epoll_event event;
+
+    waitP = &((sample_user_data_t *)userData)->wait;
+    connectionP = (sample_connection_t *)connP;
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = handle;
+
+    return epoll_ctl(waitP->epollFd, EPOLL_CTL_ADD, connectionP->sock, &event);
+}
+
+void iowa_system_connection_unregister(void *connP,
+                                       void *userData)
+{
+    sample_wait_context_t *waitP;
+    sample_connection_t *connectionP;
+
+    waitP = &((sample_user_data_t *)userData)->wait;
+    connectionP = (sample_connection_t *)connP;
+
+    (void)epoll_ctl(waitP->epollFd, EPOLL_CTL_DEL, connectionP->sock, NULL);
+}
+
+// In this function, only the ready sockets of the IOWA context are reported by the kernel.
+int iowa_system_connection_wait(void **handleArray,
+                                size_t handleCount,
+                                int32_t timeout,
+                                void *userData)
+{
+    sample_wait_context_t *waitP;
+    struct epoll_event eventArray[16];
+    int maxEvents;
+    int result;
+    int i;
+    int count;
+
+    waitP = &((sample_user_data_t *)userData)->wait;
+
+    maxEvents = handleCount < 16 ? (int)handleCount : 16;
+
+#ifndef IOWA_TIME_MS_SUPPORT
+    // The timeout is expressed in seconds
+    if (timeout > INT32_MAX / 1000)
+    {
+        timeout = INT32_MAX / 1000;
+    }
+    timeout *= 1000;
+#endif
+
+    result = epoll_wait(waitP->epollFd, eventArray, maxEvents, timeout);
+    if (result < 0)
+    {
+        if (errno == EINTR)
+        {
+            return 0;
+        }
+        return result;
+    }
+
+    count = 0;
+    for (i = 0; i < result; i++)
+    {
+        if (eventArray[i].data.ptr == NULL)
+        {
+#ifdef IOWA_THREAD_SUPPORT
+            uint64_t value;
+
+            // Drain the interruption event
+            (void)read(waitP->interruptFd, &value, sizeof(value));
+#endif
+            continue;
+        }
+
+        handleArray[count] = eventArray[i].data.ptr;
+        count++;
+    }
+
+    return count;
+}
+
+#ifdef IOWA_THREAD_SUPPORT
+// To make the call to epoll_wait() in iowa_system_connection_wait() stops,
+// we signal the eventfd of the IOWA context.
+void iowa_system_connection_interrupt_select(void *userData)
+{
+    sample_wait_context_t *waitP;
+    uint64_t value;
+
+    waitP = &((sample_user_data_t *)userData)->wait;
+
+    value = 1;
+    (void)write(waitP->interruptFd, &value, sizeof(value));
+}
+#endif
+
+#elif !defined(IOWA_THREAD_SUPPORT)
 
 // In this function, we use select on the sockets provided by IOWA.
 
@@ -224,14 +493,24 @@ int iowa_system_connection_select(void **connArray,
     // We do a sleep instead.
     if (0 == connCount)
     {
+#ifdef IOWA_TIME_MS_SUPPORT
+        (void)Sleep(timeout);
+#else
         (void)Sleep(timeout * 1000);
+#endif
 
         return 0;
     }
 #endif
 
+#ifdef IOWA_TIME_MS_SUPPORT
+    // The timeout is expressed in milliseconds
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+#else
     tv.tv_sec = timeout;
     tv.tv_usec = 0;
+#endif
 
     FD_ZERO(&readfds);
     maxFd = 0;
@@ -289,8 +568,14 @@ int iowa_system_connection_select(void **connArray,
     int maxFd;
     int fd;
 
+#ifdef IOWA_TIME_MS_SUPPORT
+    // The timeout is expressed in milliseconds
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+#else
     tv.tv_sec = timeout;
     tv.tv_usec = 0;
+#endif
 
     FD_ZERO(&readfds);
     maxFd = 0;
@@ -18,6 +18,7 @@
  **********************************************/
 
 // IOWA header
+#include "iowa_config.h"
 #include "iowa_platform.h"
 
 // Platform specific headers
@@ -51,6 +52,25 @@ int32_t iowa_system_gettime(void)
 #endif
 }
 
+#ifdef IOWA_TIME_MS_SUPPORT
+// We return the number of milliseconds from a monotonic clock.
+int64_t iowa_system_gettime_ms(void)
+{
+#ifdef _WIN32
+    return (int64_t)GetTickCount64();
+#else
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+    {
+        return -1;
+    }
+
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+#endif
+
 // We fake a reboot by exiting the application.
 void iowa_system_reboot(void *userData)
 {
@@ -19,6 +19,7 @@
 
 // IOWA header
 #include "iowa_platform.h"
+#include "sample_abstraction.h"
 
 // Platform specific headers
 #include <stdlib.h>
@@ -29,35 +30,105 @@
 #endif
 
 void iowa_system_mutex_lock(void *userData)
+{
+    sample_user_data_t *dataP;
+
+    dataP = (sample_user_data_t *)userData;
+
+#ifdef _WIN32
+    WaitForSingleObject(dataP->mutex, INFINITE);
+#else
+    pthread_mutex_lock(&(dataP->mutex));
+#endif
+}
+
+void iowa_system_mutex_unlock(void *userData)
+{
+    sample_user_data_t *dataP;
+
+    dataP = (sample_user_data_t *)userData;
+
+#ifdef _WIN32
+    ReleaseMutex(dataP->mutex);
+#else
+    pthread_mutex_unlock(&(dataP->mutex));
+#endif
+}
+
+void * iowa_system_mutex_create(void *userData)
 {
 #ifdef _WIN32
     HANDLE *mutexP;
 
-    mutexP = (HANDLE *)userData;
+    (void)userData;
+
+    mutexP = (HANDLE *)malloc(sizeof(HANDLE));
+    if (mutexP == NULL)
+    {
+        return NULL;
+    }
 
-    WaitForSingleObject(*mutexP, INFINITE);
+    *mutexP = CreateMutex(NULL, FALSE, NULL);
+    if (*mutexP == NULL)
+    {
+        free(mutexP);
+        return NULL;
+    }
 #else
     pthread_mutex_t *mutexP;
 
-    mutexP = (pthread_mutex_t *)userData;
+    (void)userData;
 
-    pthread_mutex_lock(mutexP);
+    mutexP = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t));
+    if (mutexP == NULL)
+    {
+        return NULL;
+    }
+
+    if (pthread_mutex_init(mutexP, NULL) != 0)
+    {
+        free(mutexP);
+        return NULL;
+    }
 #endif
+
+    return mutexP;
 }
 
-void iowa_system_mutex_unlock(void *userData)
+void iowa_system_mutex_delete(void *mutexP,
+                              void *userData)
 {
+    (void)userData;
+
 #ifdef _WIN32
-    HANDLE *mutexP;
+    CloseHandle(*((HANDLE *)mutexP));
+#else
+    pthread_mutex_destroy((pthread_mutex_t *)mutexP);
+#endif
 
-    mutexP = (HANDLE *)userData;
+    free(mutexP);
+}
 
-    ReleaseMutex(*mutexP);
+void iowa_system_mutex_acquire(void *mutexP,
+                               void *userData)
+{
+    (void)userData;
+
+#ifdef _WIN32
+    WaitForSingleObject(*((HANDLE *)mutexP), INFINITE);
 #else
-    pthread_mutex_t *mutexP;
+    pthread_mutex_lock((pthread_mutex_t *)mutexP);
+#endif
+}
 
-    mutexP = (pthread_mutex_t *)userData;
+void iowa_system_mutex_release(void *mutexP,
+                               void *userData)
+{
+    (void)userData;
 
-    pthread_mutex_unlock(mutexP);
+#ifdef _WIN32
+    ReleaseMutex(*((HANDLE *)mutexP));
+#else
+    pthread_mutex_unlock((pthread_mutex_t *)mutexP);
 #endif
 }
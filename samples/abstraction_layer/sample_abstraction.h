@@ -0,0 +1,82 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**********************************************
+ *
+ * Definitions of the sample system abstraction
+ * shared with the applications.
+ *
+ **********************************************/
+
+#ifndef _SAMPLE_ABSTRACTION_INCLUDE_
+#define _SAMPLE_ABSTRACTION_INCLUDE_
+
+// IOWA header
+#include "iowa_config.h"
+
+// Platform specific headers
+#ifdef IOWA_THREAD_SUPPORT
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+#endif
+
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+
+// The state of iowa_system_connection_wait() for one IOWA context.
+typedef struct
+{
+    int epollFd;     // The epoll instance monitoring the sockets registered by the IOWA context
+    int interruptFd; // An eventfd used only to interrupt the epoll_wait(), -1 if IOWA_THREAD_SUPPORT is not defined
+} sample_wait_context_t;
+
+// Create the epoll instance of an IOWA context.
+// Returned value: 0 in case of success or a negative number in case of error.
+// Parameters:
+// - waitP: the state to initialize, before calling iowa_init().
+int sample_wait_context_init(sample_wait_context_t *waitP);
+
+// Release the epoll instance of an IOWA context.
+// Returned value: none.
+// Parameters:
+// - waitP: the state initialized by sample_wait_context_init(), after calling iowa_close().
+void sample_wait_context_close(sample_wait_context_t *waitP);
+
+#endif
+
+#if defined(IOWA_THREAD_SUPPORT) || defined(IOWA_CONNECTION_WAIT_SUPPORT)
+
+// The state of the sample abstraction for one IOWA context.
+// When IOWA_THREAD_SUPPORT or IOWA_CONNECTION_WAIT_SUPPORT is defined, the userData parameter
+// of iowa_init() must point to a structure starting with a sample_user_data_t.
+typedef struct
+{
+#ifdef IOWA_THREAD_SUPPORT
+#ifdef _WIN32
+    HANDLE                mutex; // The lock of the IOWA context, created by the application
+#else
+    pthread_mutex_t       mutex; // The lock of the IOWA context, initialized by the application
+#endif
+#endif
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+    sample_wait_context_t wait;  // Initialized by sample_wait_context_init()
+#endif
+} sample_user_data_t;
+
+#endif
+
+#endif
@@ -0,0 +1,1084 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark measures block-wise transfers
+ * over loopback TCP, with blocks of 1024 bytes
+ * and with BERT blocks (RFC 8323 Section 6). A
+ * stand-in LwM2M Server reads then writes a
+ * Streamable Resource of the Client. It
+ * advertises the Block-Wise-Transfer option in
+ * its CSM only for the BERT run.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+
+#include "bench_server.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define SERVER_SHORT_ID 1234
+#define SERVER_LIFETIME 300
+
+#define OBJECT_ID       10240
+
+#define DEFAULT_SIZE    (8 * 1024 * 1024)
+#define MAX_SIZE        (64 * 1024 * 1024)
+
+// Time in seconds after which a run is abandoned
+#define MAX_RUN_TIME    120
+
+#define PRV_COAP_CODE_GET     0x01
+#define PRV_COAP_CODE_POST    0x02
+#define PRV_COAP_CODE_PUT     0x03
+#define PRV_COAP_CODE_DELETE  0x04
+#define PRV_COAP_CODE_201     0x41
+#define PRV_COAP_CODE_202     0x42
+#define PRV_COAP_CODE_204     0x44
+#define PRV_COAP_CODE_205     0x45
+#define PRV_COAP_CODE_231     0x5F
+#define PRV_COAP_CODE_404     0x84
+#define PRV_COAP_CODE_CSM     0xE1
+
+#define PRV_COAP_OPTION_MAX_MESSAGE_SIZE     2
+#define PRV_COAP_OPTION_BLOCK_WISE_TRANSFER  4
+#define PRV_COAP_OPTION_LOCATION_PATH        8
+#define PRV_COAP_OPTION_URI_PATH             11
+#define PRV_COAP_OPTION_CONTENT_FORMAT       12
+#define PRV_COAP_OPTION_BLOCK_2              23
+#define PRV_COAP_OPTION_BLOCK_1              27
+
+#define PRV_CONTENT_FORMAT_OPAQUE  42
+
+#define PRV_BLOCK_SIZE  1024
+#define PRV_SZX_1024    6
+#define PRV_SZX_BERT    7
+
+// The Max-Message-Size advertised by the Server, as IOWA_COAP_STREAM_MAX_MESSAGE_SIZE of the Client
+#define PRV_MAX_MESSAGE_SIZE  66560
+
+// Room for the header, the token and the options of a message
+#define PRV_MESSAGE_OVERHEAD  64
+
+#define PRV_TOKEN_LENGTH   2
+#define PRV_MAX_OPTIONS    16
+
+// Time in milliseconds between two checks of the stop flag
+#define PRV_POLL_TIMEOUT   10
+
+typedef struct
+{
+    uint16_t       number;
+    const uint8_t *value;
+    size_t         length;
+} prv_option_t;
+
+typedef struct
+{
+    uint8_t        code;
+    uint8_t        tokenLength;
+    const uint8_t *token;
+    size_t         optionCount;
+    prv_option_t   optionArray[PRV_MAX_OPTIONS];
+    const uint8_t *payload;
+    size_t         payloadLength;
+} prv_message_t;
+
+typedef struct
+{
+    // Configuration
+    bool      bert;                // Advertise the Block-Wise-Transfer option in the CSM
+    size_t    size;                // of the read and written content
+
+    // Internal state
+    int       listenSock;
+    int       sock;
+    uint16_t  port;
+    uint16_t  nextToken;
+    int       stop;
+    pthread_t thread;
+    uint8_t  *receiveBuffer;
+    size_t    receiveLength;       // bytes in receiveBuffer
+    size_t    frameLength;         // of the frame at the start of receiveBuffer, 0 if none
+    uint8_t  *sendBuffer;
+
+    // Results
+    int       done;                // 1 when the transfers succeeded, -1 when they failed
+    uint32_t  clientMaxMessageSize;
+    uint8_t   readSzx;
+    uint32_t  readCount;
+    double    readDuration;        // in seconds
+    uint32_t  writeCount;
+    double    writeDuration;       // in seconds
+} prv_server_t;
+
+static uint8_t *g_contentBuffer;
+static size_t g_writtenLength;
+static size_t g_contentSize;
+
+static uint8_t prv_pattern(size_t offset)
+{
+    return (uint8_t)(offset * 7 + (offset >> 12));
+}
+
+/*************************************************************************************
+** Stand-in LwM2M Server
+*************************************************************************************/
+
+static bool prv_parseOptions(const uint8_t *buffer,
+                             size_t length,
+                             prv_message_t *messageP)
+{
+    size_t pos;
+    uint16_t number;
+
+    messageP->optionCount = 0;
+    messageP->payload = NULL;
+    messageP->payloadLength = 0;
+
+    pos = 0;
+    number = 0;
+    while (pos < length
+           && buffer[pos] != 0xFF)
+    {
+        size_t delta;
+        size_t optionLength;
+
+        delta = buffer[pos] >> 4;
+        optionLength = buffer[pos] & 0x0F;
+        pos++;
+
+        if (delta == 13)
+        {
+            if (pos >= length) return false;
+            delta = 13 + (size_t)buffer[pos];
+            pos++;
+        }
+        else if (delta == 14)
+        {
+            if (pos + 1 >= length) return false;
+            delta = 269 + (((size_t)buffer[pos] << 8) | buffer[pos + 1]);
+            pos += 2;
+        }
+        if (optionLength == 13)
+        {
+            if (pos >= length) return false;
+            optionLength = 13 + (size_t)buffer[pos];
+            pos++;
+        }
+        else if (optionLength == 14)
+        {
+            if (pos + 1 >= length) return false;
+            optionLength = 269 + (((size_t)buffer[pos] << 8) | buffer[pos + 1]);
+            pos += 2;
+        }
+        if (pos + optionLength > length
+            || messageP->optionCount == PRV_MAX_OPTIONS)
+        {
+            return false;
+        }
+
+        number = (uint16_t)(number + delta);
+        messageP->optionArray[messageP->optionCount].number = number;
+        messageP->optionArray[messageP->optionCount].value = buffer + pos;
+        messageP->optionArray[messageP->optionCount].length = optionLength;
+        messageP->optionCount++;
+
+        pos += optionLength;
+    }
+
+    if (pos < length)
+    {
+        // Skip the payload marker
+        messageP->payload = buffer + pos + 1;
+        messageP->payloadLength = length - pos - 1;
+    }
+
+    return true;
+}
+
+static const prv_option_t *prv_findOption(const prv_message_t *messageP,
+                                          uint16_t number)
+{
+    size_t i;
+
+    for (i = 0; i < messageP->optionCount; i++)
+    {
+        if (messageP->optionArray[i].number == number)
+        {
+            return messageP->optionArray + i;
+        }
+    }
+
+    return NULL;
+}
+
+static uint32_t prv_optionUint(const prv_option_t *optionP)
+{
+    uint32_t value;
+    size_t i;
+
+    value = 0;
+    for (i = 0; i < optionP->length && i < 4; i++)
+    {
+        value = (value << 8) | optionP->value[i];
+    }
+
+    return value;
+}
+
+// Options must be written by increasing numbers. Values are shorter than 13 bytes.
+static size_t prv_writeOption(uint8_t *buffer,
+                              uint16_t *lastNumberP,
+                              uint16_t number,
+                              const uint8_t *value,
+                              size_t length)
+{
+    size_t pos;
+    uint16_t delta;
+
+    pos = 1;
+    delta = (uint16_t)(number - *lastNumberP);
+    if (delta < 13)
+    {
+        buffer[0] = (uint8_t)(delta << 4);
+    }
+    else
+    {
+        buffer[0] = 13 << 4;
+        buffer[pos++] = (uint8_t)(delta - 13);
+    }
+    buffer[0] |= (uint8_t)length;
+    if (length > 0)
+    {
+        memcpy(buffer + pos, value, length);
+    }
+    *lastNumberP = number;
+
+    return pos + length;
+}
+
+static size_t prv_writeUintOption(uint8_t *buffer,
+                                  uint16_t *lastNumberP,
+                                  uint16_t number,
+                                  uint32_t value)
+{
+    uint8_t valueBuffer[4];
+    size_t length;
+    size_t i;
+
+    length = 0;
+    while (length < 4
+           && (value >> (8 * length)) != 0)
+    {
+        length++;
+    }
+    for (i = 0; i < length; i++)
+    {
+        valueBuffer[i] = (uint8_t)(value >> (8 * (length - 1 - i)));
+    }
+
+    return prv_writeOption(buffer, lastNumberP, number, valueBuffer, length);
+}
+
+static size_t prv_writePath(uint8_t *buffer,
+                            uint16_t *lastNumberP)
+{
+    static const uint8_t path[] = { 0xB5, '1', '0', '2', '4', '0', 0x01, '0', 0x01, '0' };
+
+    memcpy(buffer, path, sizeof(path));
+    *lastNumberP = PRV_COAP_OPTION_URI_PATH;
+
+    return sizeof(path);
+}
+
+// Send a message framed as in RFC 8323 Section 3.2. The options are already in sendBuffer, after
+// PRV_MESSAGE_OVERHEAD bytes left for the header.
+static int prv_sendFrame(prv_server_t *serverP,
+                         uint8_t code,
+                         const uint8_t *token,
+                         uint8_t tokenLength,
+                         size_t optionsLength,
+                         const uint8_t *payload,
+                         size_t payloadLength)
+{
+    uint8_t header[16];
+    size_t headerLength;
+    size_t length;
+    uint8_t *start;
+    size_t total;
+    ssize_t sent;
+
+    length = optionsLength;
+    if (payloadLength > 0)
+    {
+        serverP->sendBuffer[PRV_MESSAGE_OVERHEAD + length] = 0xFF;
+        memcpy(serverP->sendBuffer + PRV_MESSAGE_OVERHEAD + length + 1, payload, payloadLength);
+        length += 1 + payloadLength;
+    }
+
+    if (length < 13)
+    {
+        header[0] = (uint8_t)((length << 4) | tokenLength);
+        headerLength = 1;
+    }
+    else if (length < 269)
+    {
+        header[0] = (uint8_t)((13 << 4) | tokenLength);
+        header[1] = (uint8_t)(length - 13);
+        headerLength = 2;
+    }
+    else if (length < 65805)
+    {
+        header[0] = (uint8_t)((14 << 4) | tokenLength);
+        header[1] = (uint8_t)((length - 269) >> 8);
+        header[2] = (uint8_t)(length - 269);
+        headerLength = 3;
+    }
+    else
+    {
+        header[0] = (uint8_t)((15 << 4) | tokenLength);
+        header[1] = (uint8_t)((length - 65805) >> 24);
+        header[2] = (uint8_t)((length - 65805) >> 16);
+        header[3] = (uint8_t)((length - 65805) >> 8);
+        header[4] = (uint8_t)(length - 65805);
+        headerLength = 5;
+    }
+    header[headerLength++] = code;
+    if (tokenLength > 0)
+    {
+        memcpy(header + headerLength, token, tokenLength);
+        headerLength += tokenLength;
+    }
+
+    start = serverP->sendBuffer + PRV_MESSAGE_OVERHEAD - headerLength;
+    memcpy(start, header, headerLength);
+    total = headerLength + length;
+
+    while (total > 0)
+    {
+        sent = send(serverP->sock, start, total, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            return -1;
+        }
+        start += sent;
+        total -= (size_t)sent;
+    }
+
+    return 0;
+}
+
+// Wait for a complete frame at the start of receiveBuffer.
+// Returned value: 0 when a frame is parsed, -1 when the connection is closed or the server is stopped.
+static int prv_receiveFrame(prv_server_t *serverP,
+                            prv_message_t *messageP)
+{
+    struct pollfd pfd;
+    ssize_t length;
+
+    if (serverP->frameLength > 0)
+    {
+        // Discard the previous frame
+        memmove(serverP->receiveBuffer, serverP->receiveBuffer + serverP->frameLength, serverP->receiveLength - serverP->frameLength);
+        serverP->receiveLength -= serverP->frameLength;
+        serverP->frameLength = 0;
+    }
+
+    while (true)
+    {
+        if (serverP->receiveLength >= 2)
+        {
+            const uint8_t *buffer;
+            size_t extendedLength;
+            size_t bodyLength;
+            size_t headerLength;
+            size_t i;
+
+            buffer = serverP->receiveBuffer;
+            bodyLength = buffer[0] >> 4;
+            switch (bodyLength)
+            {
+            case 13:
+                extendedLength = 1;
+                break;
+            case 14:
+                extendedLength = 2;
+                break;
+            case 15:
+                extendedLength = 4;
+                break;
+            default:
+                extendedLength = 0;
+                break;
+            }
+            headerLength = 1 + extendedLength + 1 + (buffer[0] & 0x0F);
+            if (serverP->receiveLength >= headerLength)
+            {
+                if (extendedLength > 0)
+                {
+                    size_t value;
+
+                    value = 0;
+                    for (i = 0; i < extendedLength; i++)
+                    {
+                        value = (value << 8) | buffer[1 + i];
+                    }
+                    bodyLength = value + (extendedLength == 1 ? 13 : (extendedLength == 2 ? 269 : 65805));
+                }
+                if (headerLength + bodyLength > PRV_MAX_MESSAGE_SIZE + PRV_MESSAGE_OVERHEAD)
+                {
+                    fprintf(stderr, "Received a message of %zu bytes.\r\n", bodyLength);
+                    return -1;
+                }
+                if (serverP->receiveLength >= headerLength + bodyLength)
+                {
+                    messageP->code = buffer[1 + extendedLength];
+                    messageP->tokenLength = buffer[0] & 0x0F;
+                    messageP->token = buffer + 2 + extendedLength;
+                    serverP->frameLength = headerLength + bodyLength;
+
+                    return prv_parseOptions(buffer + headerLength, bodyLength, messageP) == true ? 0 : -1;
+                }
+            }
+        }
+
+        do
+        {
+            if (__atomic_load_n(&serverP->stop, __ATOMIC_ACQUIRE) != 0)
+            {
+                return -1;
+            }
+            pfd.fd = serverP->sock;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+        } while (poll(&pfd, 1, PRV_POLL_TIMEOUT) <= 0);
+
+        length = recv(serverP->sock, serverP->receiveBuffer + serverP->receiveLength, PRV_MAX_MESSAGE_SIZE + PRV_MESSAGE_OVERHEAD - serverP->receiveLength, 0);
+        if (length <= 0)
+        {
+            return -1;
+        }
+        serverP->receiveLength += (size_t)length;
+    }
+}
+
+// Send a request on /10240/0/0 and wait for its response, answering the Client requests meanwhile.
+static int prv_request(prv_server_t *serverP,
+                       uint8_t code,
+                       size_t optionsLength,
+                       const uint8_t *payload,
+                       size_t payloadLength,
+                       prv_message_t *responseP);
+
+static int prv_handleClientRequest(prv_server_t *serverP,
+                                   const prv_message_t *messageP)
+{
+    const prv_option_t *optionP;
+    uint16_t lastNumber;
+    size_t length;
+    uint8_t code;
+
+    length = 0;
+    lastNumber = 0;
+    switch (messageP->code)
+    {
+    case PRV_COAP_CODE_POST:
+        optionP = prv_findOption(messageP, PRV_COAP_OPTION_BLOCK_1);
+        if (optionP != NULL
+            && (prv_optionUint(optionP) & 0x08) != 0)
+        {
+            // A registration sent in blocks
+            code = PRV_COAP_CODE_231;
+        }
+        else
+        {
+            code = PRV_COAP_CODE_201;
+            length += prv_writeOption(serverP->sendBuffer + PRV_MESSAGE_OVERHEAD + length, &lastNumber, PRV_COAP_OPTION_LOCATION_PATH, (const uint8_t *)"rd", 2);
+            length += prv_writeOption(serverP->sendBuffer + PRV_MESSAGE_OVERHEAD + length, &lastNumber, PRV_COAP_OPTION_LOCATION_PATH, (const uint8_t *)"0", 1);
+        }
+        if (optionP != NULL)
+        {
+            length += prv_writeUintOption(serverP->sendBuffer + PRV_MESSAGE_OVERHEAD + length, &lastNumber, PRV_COAP_OPTION_BLOCK_1, prv_optionUint(optionP));
+        }
+        break;
+
+    case PRV_COAP_CODE_DELETE:
+        code = PRV_COAP_CODE_202;
+        break;
+
+    default:
+        code = PRV_COAP_CODE_404;
+        break;
+    }
+
+    return prv_sendFrame(serverP, code, messageP->token, messageP->tokenLength, length, NULL, 0);
+}
+
+static int prv_request(prv_server_t *serverP,
+                       uint8_t code,
+                       size_t optionsLength,
+                       const uint8_t *payload,
+                       size_t payloadLength,
+                       prv_message_t *responseP)
+{
+    uint8_t token[PRV_TOKEN_LENGTH];
+
+    token[0] = (uint8_t)(serverP->nextToken >> 8);
+    token[1] = (uint8_t)serverP->nextToken;
+    serverP->nextToken++;
+
+    if (prv_sendFrame(serverP, code, token, PRV_TOKEN_LENGTH, optionsLength, payload, payloadLength) != 0)
+    {
+        return -1;
+    }
+
+    while (prv_receiveFrame(serverP, responseP) == 0)
+    {
+        if ((responseP->code >> 5) == 0)
+        {
+            if (responseP->code != 0
+                && prv_handleClientRequest(serverP, responseP) != 0)
+            {
+                return -1;
+            }
+        }
+        else if (responseP->tokenLength == PRV_TOKEN_LENGTH
+                 && memcmp(responseP->token, token, PRV_TOKEN_LENGTH) == 0)
+        {
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static int prv_exchangeCsm(prv_server_t *serverP)
+{
+    prv_message_t message;
+    const prv_option_t *optionP;
+    uint16_t lastNumber;
+    size_t length;
+
+    if (prv_receiveFrame(serverP, &message) != 0
+        || message.code != PRV_COAP_CODE_CSM)
+    {
+        fprintf(stderr, "No CSM received from the Client.\r\n");
+        return -1;
+    }
+
+    optionP = prv_findOption(&message, PRV_COAP_OPTION_MAX_MESSAGE_SIZE);
+    serverP->clientMaxMessageSize = optionP != NULL ? prv_optionUint(optionP) : 1152;
+    if (serverP->bert == true
+        && prv_findOption(&message, PRV_COAP_OPTION_BLOCK_WISE_TRANSFER) == NULL)
+    {
+        fprintf(stderr, "The Client CSM has no Block-Wise-Transfer option.\r\n");
+        return -1;
+    }
+
+    length = 0;
+    lastNumber = 0;
+    length += prv_writeUintOption(serverP->sendBuffer + PRV_MESSAGE_OVERHEAD + length, &lastNumber, PRV_COAP_OPTION_MAX_MESSAGE_SIZE, PRV_MAX_MESSAGE_SIZE);
+    if (serverP->bert == true)
+    {
+        length += prv_writeOption(serverP->sendBuffer + PRV_MESSAGE_OVERHEAD + length, &lastNumber, PRV_COAP_OPTION_BLOCK_WISE_TRANSFER, NULL, 0);
+    }
+
+    return prv_sendFrame(serverP, PRV_COAP_CODE_CSM, NULL, 0, length, NULL, 0);
+}
+
+static int prv_read(prv_server_t *serverP)
+{
+    prv_message_t response;
+    const prv_option_t *optionP;
+    uint16_t lastNumber;
+    size_t length;
+    size_t offset;
+    uint32_t number;
+    uint32_t value;
+    int64_t startTime;
+    size_t i;
+
+    startTime = bench_now();
+    offset = 0;
+    number = 0;
+    do
+    {
+        length = prv_writePath(serverP->sendBuffer + PRV_MESSAGE_OVERHEAD, &lastNumber);
+        length += prv_writeUintOption(serverP->sendBuffer + PRV_MESSAGE_OVERHEAD + length, &lastNumber, PRV_COAP_OPTION_BLOCK_2, (number << 4) | (serverP->bert == true ? PRV_SZX_BERT : PRV_SZX_1024));
+        if (prv_request(serverP, PRV_COAP_CODE_GET, length, NULL, 0, &response) != 0)
+        {
+            return -1;
+        }
+        serverP->readCount++;
+
+        optionP = prv_findOption(&response, PRV_COAP_OPTION_BLOCK_2);
+        if (response.code != PRV_COAP_CODE_205
+            || optionP == NULL)
+        {
+            fprintf(stderr, "Read failed (%u.%02u).\r\n", response.code >> 5, response.code & 0x1F);
+            return -1;
+        }
+        value = prv_optionUint(optionP);
+        if ((value >> 4) != number
+            || offset + response.payloadLength > serverP->size)
+        {
+            fprintf(stderr, "Unexpected Read block.\r\n");
+            return -1;
+        }
+        for (i = 0; i < response.payloadLength; i++)
+        {
+            if (response.payload[i] != prv_pattern(offset + i))
+            {
+                fprintf(stderr, "Read content mismatch.\r\n");
+                return -1;
+            }
+        }
+        serverP->readSzx = (uint8_t)(value & 0x07);
+
+        // BERT block numbers count units of 1024 bytes
+        offset += response.payloadLength;
+        number = (uint32_t)(offset / PRV_BLOCK_SIZE);
+    } while ((value & 0x08) != 0);
+
+    serverP->readDuration = (double)(bench_now() - startTime) / 1000000.0;
+
+    if (offset != serverP->size)
+    {
+        fprintf(stderr, "Read content truncated.\r\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int prv_write(prv_server_t *serverP)
+{
+    prv_message_t response;
+    uint16_t lastNumber;
+    uint8_t *payload;
+    size_t step;
+    size_t length;
+    size_t offset;
+    size_t payloadLength;
+    bool more;
+    int64_t startTime;
+    size_t i;
+
+    // A BERT payload is the largest multiple of 1024 bytes fitting the Client Max-Message-Size
+    if (serverP->bert == true)
+    {
+        step = ((serverP->clientMaxMessageSize - PRV_MESSAGE_OVERHEAD) / PRV_BLOCK_SIZE) * PRV_BLOCK_SIZE;
+    }
+    else
+    {
+        step = PRV_BLOCK_SIZE;
+    }
+
+    payload = (uint8_t *)malloc(step);
+    if (payload == NULL)
+    {
+        return -1;
+    }
+
+    startTime = bench_now();
+    offset = 0;
+    do
+    {
+        payloadLength = serverP->size - offset;
+        more = payloadLength > step;
+        if (more == true)
+        {
+            payloadLength = step;
+        }
+        for (i = 0; i < payloadLength; i++)
+        {
+            payload[i] = prv_pattern(offset + i);
+        }
+
+        length = prv_writePath(serverP->sendBuffer + PRV_MESSAGE_OVERHEAD, &lastNumber);
+        length += prv_writeUintOption(serverP->sendBuffer + PRV_MESSAGE_OVERHEAD + length, &lastNumber, PRV_COAP_OPTION_CONTENT_FORMAT, PRV_CONTENT_FORMAT_OPAQUE);
+        length += prv_writeUintOption(serverP->sendBuffer + PRV_MESSAGE_OVERHEAD + length, &lastNumber, PRV_COAP_OPTION_BLOCK_1, (uint32_t)((offset / PRV_BLOCK_SIZE) << 4) | (more == true ? 0x08 : 0x00) | (serverP->bert == true ? PRV_SZX_BERT : PRV_SZX_1024));
+        if (prv_request(serverP, PRV_COAP_CODE_PUT, length, payload, payloadLength, &response) != 0)
+        {
+            free(payload);
+            return -1;
+        }
+        serverP->writeCount++;
+
+        if (response.code != (more == true ? PRV_COAP_CODE_231 : PRV_COAP_CODE_204))
+        {
+            fprintf(stderr, "Write failed (%u.%02u).\r\n", response.code >> 5, response.code & 0x1F);
+            free(payload);
+            return -1;
+        }
+
+        offset += payloadLength;
+    } while (more == true);
+
+    serverP->writeDuration = (double)(bench_now() - startTime) / 1000000.0;
+
+    free(payload);
+
+    return 0;
+}
+
+static void *prv_serverThread(void *arg)
+{
+    prv_server_t *serverP;
+    prv_message_t message;
+    struct pollfd pfd;
+    int flag;
+    int result;
+
+    serverP = (prv_server_t *)arg;
+
+    do
+    {
+        if (__atomic_load_n(&serverP->stop, __ATOMIC_ACQUIRE) != 0)
+        {
+            return NULL;
+        }
+        pfd.fd = serverP->listenSock;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+    } while (poll(&pfd, 1, PRV_POLL_TIMEOUT) <= 0);
+
+    serverP->sock = accept(serverP->listenSock, NULL, NULL);
+    if (serverP->sock == -1)
+    {
+        __atomic_store_n(&serverP->done, -1, __ATOMIC_RELEASE);
+        return NULL;
+    }
+    flag = 1;
+    (void)setsockopt(serverP->sock, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+    result = prv_exchangeCsm(serverP);
+
+    // Wait for the registration
+    while (result == 0)
+    {
+        result = prv_receiveFrame(serverP, &message);
+        if (result == 0
+            && (message.code >> 5) == 0
+            && message.code != 0)
+        {
+            result = prv_handleClientRequest(serverP, &message);
+            if (message.code == PRV_COAP_CODE_POST
+                && prv_findOption(&message, PRV_COAP_OPTION_BLOCK_1) == NULL)
+            {
+                break;
+            }
+        }
+    }
+
+    if (result == 0)
+    {
+        result = prv_read(serverP);
+    }
+    if (result == 0)
+    {
+        result = prv_write(serverP);
+    }
+    __atomic_store_n(&serverP->done, result == 0 ? 1 : -1, __ATOMIC_RELEASE);
+
+    // Answer the deregistration
+    while (prv_receiveFrame(serverP, &message) == 0)
+    {
+        if ((message.code >> 5) == 0
+            && message.code != 0)
+        {
+            (void)prv_handleClientRequest(serverP, &message);
+        }
+    }
+
+    close(serverP->sock);
+
+    return NULL;
+}
+
+static int prv_serverOpen(prv_server_t *serverP)
+{
+    struct sockaddr_in addr;
+    socklen_t addrLen;
+    int flag;
+
+    serverP->receiveBuffer = (uint8_t *)malloc(PRV_MAX_MESSAGE_SIZE + PRV_MESSAGE_OVERHEAD);
+    serverP->sendBuffer = (uint8_t *)malloc(PRV_MAX_MESSAGE_SIZE + 2 * PRV_MESSAGE_OVERHEAD);
+    if (serverP->receiveBuffer == NULL
+        || serverP->sendBuffer == NULL)
+    {
+        free(serverP->receiveBuffer);
+        free(serverP->sendBuffer);
+        return -1;
+    }
+
+    serverP->listenSock = socket(AF_INET, SOCK_STREAM, 0);
+    if (serverP->listenSock == -1)
+    {
+        free(serverP->receiveBuffer);
+        free(serverP->sendBuffer);
+        return -1;
+    }
+    flag = 1;
+    (void)setsockopt(serverP->listenSock, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    addrLen = sizeof(addr);
+    if (bind(serverP->listenSock, (struct sockaddr *)&addr, sizeof(addr)) == -1
+        || listen(serverP->listenSock, 1) == -1
+        || getsockname(serverP->listenSock, (struct sockaddr *)&addr, &addrLen) == -1
+        || pthread_create(&serverP->thread, NULL, prv_serverThread, serverP) != 0)
+    {
+        close(serverP->listenSock);
+        free(serverP->receiveBuffer);
+        free(serverP->sendBuffer);
+        return -1;
+    }
+
+    serverP->port = ntohs(addr.sin_port);
+    serverP->nextToken = 1;
+
+    return 0;
+}
+
+static void prv_serverClose(prv_server_t *serverP)
+{
+    __atomic_store_n(&serverP->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(serverP->thread, NULL);
+
+    close(serverP->listenSock);
+    free(serverP->receiveBuffer);
+    free(serverP->sendBuffer);
+}
+
+/*************************************************************************************
+** LwM2M Client
+*************************************************************************************/
+
+// The Streamable Resource /10240/0/0 is read from the expected content and written into the
+// first half of g_contentBuffer.
+static iowa_status_t prv_objectCallback(iowa_dm_operation_t operation,
+                                        iowa_lwm2m_data_t *dataP,
+                                        size_t numData,
+                                        void *userData,
+                                        iowa_context_t contextP)
+{
+    size_t i;
+    uint32_t number;
+    bool more;
+    uint16_t size;
+    size_t offset;
+
+    (void)userData;
+    (void)contextP;
+
+    for (i = 0; i < numData; i++)
+    {
+        if (dataP[i].type != IOWA_LWM2M_TYPE_OPAQUE_BLOCK
+            || iowa_data_get_block_info(dataP + i, &number, &more, &size) != IOWA_COAP_NO_ERROR)
+        {
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+        offset = (size_t)number * size;
+
+        switch (operation)
+        {
+        case IOWA_DM_READ:
+            if (offset >= g_contentSize)
+            {
+                return IOWA_COAP_402_BAD_OPTION;
+            }
+            more = offset + size < g_contentSize;
+            dataP[i].value.asBlock.buffer = g_contentBuffer + g_contentSize + offset;
+            dataP[i].value.asBlock.totalSize = more == true ? size : g_contentSize - offset;
+            iowa_data_set_block_info(dataP + i, number, more, size);
+            break;
+
+        case IOWA_DM_WRITE:
+            if (offset + dataP[i].value.asBlock.totalSize > g_contentSize)
+            {
+                return IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+            }
+            memcpy(g_contentBuffer + offset, dataP[i].value.asBlock.buffer, dataP[i].value.asBlock.totalSize);
+            g_writtenLength = offset + dataP[i].value.asBlock.totalSize;
+            break;
+
+        default:
+            return IOWA_COAP_405_METHOD_NOT_ALLOWED;
+        }
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+static int prv_run(prv_server_t *serverP)
+{
+    iowa_context_t iowaH;
+    iowa_device_info_t devInfo;
+    iowa_lwm2m_resource_desc_t resource;
+    uint16_t instanceId;
+    char serverUri[64];
+    int64_t startTime;
+    iowa_status_t result;
+
+    if (prv_serverOpen(serverP) != 0)
+    {
+        fprintf(stderr, "Stand-in server creation failed.\r\n");
+        return -1;
+    }
+    snprintf(serverUri, sizeof(serverUri), "coap+tcp://127.0.0.1:%u", serverP->port);
+
+    instanceId = 0;
+    resource.id = 0;
+    resource.type = IOWA_LWM2M_TYPE_OPAQUE;
+    resource.operations = IOWA_OPERATION_READ | IOWA_OPERATION_WRITE;
+    resource.flags = IOWA_RESOURCE_FLAG_MANDATORY | IOWA_RESOURCE_FLAG_STREAMABLE;
+
+    memset(g_contentBuffer, 0, g_contentSize);
+    g_writtenLength = 0;
+
+    iowaH = iowa_init(NULL);
+    if (iowaH == NULL)
+    {
+        fprintf(stderr, "IOWA context initialization failed.\r\n");
+        prv_serverClose(serverP);
+        return -1;
+    }
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    result = iowa_client_configure(iowaH, "bert_tcp", &devInfo, NULL);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = iowa_client_add_custom_object(iowaH, OBJECT_ID, 1, &instanceId, 1, &resource, prv_objectCallback, NULL, NULL, NULL);
+    }
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = iowa_client_add_server(iowaH, SERVER_SHORT_ID, serverUri, SERVER_LIFETIME, 0, IOWA_SEC_NONE);
+    }
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "IOWA Client configuration failed (%u.%02u).\r\n", (result & 0xFF) >> 5, (result & 0x1F));
+        iowa_close(iowaH);
+        prv_serverClose(serverP);
+        return -1;
+    }
+
+    startTime = bench_now();
+    while (__atomic_load_n(&serverP->done, __ATOMIC_ACQUIRE) == 0
+           && bench_now() - startTime < (int64_t)MAX_RUN_TIME * 1000000)
+    {
+        (void)iowa_step(iowaH, 1);
+    }
+
+    iowa_client_remove_server(iowaH, SERVER_SHORT_ID);
+    (void)iowa_step(iowaH, 0);
+    iowa_close(iowaH);
+
+    prv_serverClose(serverP);
+
+    if (serverP->done != 1)
+    {
+        return -1;
+    }
+    if (g_writtenLength != g_contentSize
+        || memcmp(g_contentBuffer, g_contentBuffer + g_contentSize, g_contentSize) != 0)
+    {
+        fprintf(stderr, "Written content mismatch.\r\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    prv_server_t server;
+    long size;
+    int result;
+    int i;
+
+    size = DEFAULT_SIZE;
+    if (argc > 1)
+    {
+        size = atol(argv[1]);
+    }
+    if (size <= 0
+        || size > MAX_SIZE)
+    {
+        fprintf(stderr, "Usage: %s [size in bytes (1-%d)]\r\n", argv[0], MAX_SIZE);
+        return 1;
+    }
+
+    // The written content, followed by the expected one
+    g_contentSize = (size_t)size;
+    g_contentBuffer = (uint8_t *)malloc(2 * g_contentSize);
+    if (g_contentBuffer == NULL)
+    {
+        return 1;
+    }
+    for (i = 0; i < size; i++)
+    {
+        g_contentBuffer[size + i] = prv_pattern((size_t)i);
+    }
+
+    printf("Content:        %ld bytes over loopback TCP\r\n", size);
+    printf("Blocks       Read requests   Read (s)   Read (MB/s)   Write requests   Write (s)   Write (MB/s)\r\n");
+
+    result = 0;
+    for (i = 0; i < 2; i++)
+    {
+        memset(&server, 0, sizeof(server));
+        server.bert = i == 1;
+        server.size = (size_t)size;
+
+        if (prv_run(&server) != 0)
+        {
+            printf("%-12s failed\r\n", server.bert == true ? "BERT" : "1024 bytes");
+            result = 1;
+            continue;
+        }
+        if (server.bert == true
+            && server.readSzx != PRV_SZX_BERT)
+        {
+            fprintf(stderr, "The Client did not use BERT blocks.\r\n");
+            result = 1;
+        }
+
+        printf("%-12s %13u   %8.3f   %11.1f   %14u   %9.3f   %12.1f\r\n",
+               server.bert == true ? "BERT" : "1024 bytes",
+               server.readCount, server.readDuration, (double)size / server.readDuration / 1000000.0,
+               server.writeCount, server.writeDuration, (double)size / server.writeDuration / 1000000.0);
+    }
+
+    free(g_contentBuffer);
+
+    return result;
+}
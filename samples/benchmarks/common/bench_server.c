@@ -0,0 +1,489 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This file implements the stand-in LwM2M Server
+ * of the benchmarks. It acknowledges the
+ * registrations and the registration updates,
+ * observes or reads the IPSO sensor value of the
+ * Client, and counts the responses.
+ *
+ **************************************************/
+
+#include "bench_server.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define PRV_COAP_TYPE_CON    0
+#define PRV_COAP_TYPE_NON    1
+#define PRV_COAP_TYPE_ACK    2
+#define PRV_COAP_TYPE_RST    3
+
+#define PRV_COAP_CODE_EMPTY   0x00
+#define PRV_COAP_CODE_GET     0x01
+#define PRV_COAP_CODE_POST    0x02
+#define PRV_COAP_CODE_DELETE  0x04
+#define PRV_COAP_CODE_201     0x41
+#define PRV_COAP_CODE_202     0x42
+#define PRV_COAP_CODE_204     0x44
+#define PRV_COAP_CODE_404     0x84
+
+#define PRV_COAP_OPTION_OBSERVE   6
+#define PRV_COAP_OPTION_URI_PATH  11
+
+#define PRV_TOKEN_LENGTH   2
+#define PRV_TOKEN_OBSERVE  "ob"
+#define PRV_TOKEN_READ     "rd"
+
+#define PRV_DATAGRAM_SIZE  1500
+
+// Time in milliseconds between two checks of the stop flag
+#define PRV_POLL_TIMEOUT   10
+
+// Time in microseconds after which the Read requests in flight are considered lost
+#define PRV_READ_TIMEOUT   200000
+
+typedef struct
+{
+    uint8_t        type;
+    uint8_t        code;
+    uint16_t       mid;
+    uint8_t        tokenLength;
+    const uint8_t *token;
+    uint8_t        pathCount;
+} prv_message_t;
+
+// Parse the header and the options of a CoAP message.
+// Returned value: true if the message is valid.
+static bool prv_parse(const uint8_t *buffer,
+                      size_t length,
+                      prv_message_t *messageP)
+{
+    size_t pos;
+    uint16_t number;
+
+    if (length < 4
+        || (buffer[0] >> 6) != 1)
+    {
+        return false;
+    }
+
+    messageP->type = (buffer[0] >> 4) & 0x03;
+    messageP->tokenLength = buffer[0] & 0x0F;
+    messageP->code = buffer[1];
+    messageP->mid = (uint16_t)((buffer[2] << 8) | buffer[3]);
+    messageP->token = buffer + 4;
+    messageP->pathCount = 0;
+
+    if (messageP->tokenLength > 8
+        || 4 + (size_t)messageP->tokenLength > length)
+    {
+        return false;
+    }
+
+    pos = 4 + (size_t)messageP->tokenLength;
+    number = 0;
+    while (pos < length
+           && buffer[pos] != 0xFF)
+    {
+        size_t delta;
+        size_t optionLength;
+
+        delta = buffer[pos] >> 4;
+        optionLength = buffer[pos] & 0x0F;
+        pos++;
+
+        if (delta == 13)
+        {
+            if (pos >= length) return false;
+            delta = 13 + (size_t)buffer[pos];
+            pos++;
+        }
+        else if (delta == 14)
+        {
+            if (pos + 1 >= length) return false;
+            delta = 269 + (((size_t)buffer[pos] << 8) | buffer[pos + 1]);
+            pos += 2;
+        }
+        if (optionLength == 13)
+        {
+            if (pos >= length) return false;
+            optionLength = 13 + (size_t)buffer[pos];
+            pos++;
+        }
+        else if (optionLength == 14)
+        {
+            if (pos + 1 >= length) return false;
+            optionLength = 269 + (((size_t)buffer[pos] << 8) | buffer[pos + 1]);
+            pos += 2;
+        }
+
+        number = (uint16_t)(number + delta);
+        if (number == PRV_COAP_OPTION_URI_PATH)
+        {
+            messageP->pathCount++;
+        }
+
+        pos += optionLength;
+    }
+
+    return pos <= length;
+}
+
+static void prv_send(bench_server_t *serverP,
+                     const uint8_t *buffer,
+                     size_t length)
+{
+    struct sockaddr_in addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(serverP->clientPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    (void)sendto(serverP->sock, buffer, length, 0, (struct sockaddr *)&addr, sizeof(addr));
+}
+
+// Answer a request from the client, piggybacked if the request is confirmable.
+static void prv_sendResponse(bench_server_t *serverP,
+                             const prv_message_t *requestP,
+                             uint8_t code,
+                             const uint8_t *options,
+                             size_t optionsLength)
+{
+    uint8_t buffer[64];
+    size_t length;
+    uint16_t mid;
+
+    if (requestP->type == PRV_COAP_TYPE_CON)
+    {
+        buffer[0] = (uint8_t)(0x40 | (PRV_COAP_TYPE_ACK << 4) | requestP->tokenLength);
+        mid = requestP->mid;
+    }
+    else
+    {
+        buffer[0] = (uint8_t)(0x40 | (PRV_COAP_TYPE_NON << 4) | requestP->tokenLength);
+        mid = serverP->nextMid++;
+    }
+    buffer[1] = code;
+    buffer[2] = (uint8_t)(mid >> 8);
+    buffer[3] = (uint8_t)(mid & 0xFF);
+    memcpy(buffer + 4, requestP->token, requestP->tokenLength);
+    length = 4 + (size_t)requestP->tokenLength;
+    if (optionsLength > 0)
+    {
+        memcpy(buffer + length, options, optionsLength);
+        length += optionsLength;
+    }
+
+    prv_send(serverP, buffer, length);
+}
+
+static void prv_sendEmptyAck(bench_server_t *serverP,
+                             uint16_t mid)
+{
+    uint8_t buffer[4];
+
+    buffer[0] = (uint8_t)(0x40 | (PRV_COAP_TYPE_ACK << 4));
+    buffer[1] = PRV_COAP_CODE_EMPTY;
+    buffer[2] = (uint8_t)(mid >> 8);
+    buffer[3] = (uint8_t)(mid & 0xFF);
+
+    prv_send(serverP, buffer, sizeof(buffer));
+}
+
+// Send a confirmable GET on /3303/0/5700 with an optional Observe option.
+static void prv_sendGet(bench_server_t *serverP,
+                        const char *token,
+                        bool observe)
+{
+    uint8_t buffer[32];
+    size_t length;
+    uint16_t mid;
+
+    mid = serverP->nextMid++;
+
+    buffer[0] = (uint8_t)(0x40 | (PRV_COAP_TYPE_CON << 4) | PRV_TOKEN_LENGTH);
+    buffer[1] = PRV_COAP_CODE_GET;
+    buffer[2] = (uint8_t)(mid >> 8);
+    buffer[3] = (uint8_t)(mid & 0xFF);
+    memcpy(buffer + 4, token, PRV_TOKEN_LENGTH);
+    length = 4 + PRV_TOKEN_LENGTH;
+
+    if (observe == true)
+    {
+        // Observe: 0 (empty value), then Uri-Path with a delta of 5
+        buffer[length++] = (uint8_t)(PRV_COAP_OPTION_OBSERVE << 4);
+        buffer[length++] = (uint8_t)(((PRV_COAP_OPTION_URI_PATH - PRV_COAP_OPTION_OBSERVE) << 4) | 4);
+    }
+    else
+    {
+        buffer[length++] = (uint8_t)((PRV_COAP_OPTION_URI_PATH << 4) | 4);
+    }
+    memcpy(buffer + length, "3303", 4);
+    length += 4;
+    buffer[length++] = 0x01;
+    buffer[length++] = '0';
+    buffer[length++] = 0x04;
+    memcpy(buffer + length, "5700", 4);
+    length += 4;
+
+    prv_send(serverP, buffer, length);
+}
+
+static void prv_handleRequest(bench_server_t *serverP,
+                              const prv_message_t *messageP)
+{
+    switch (messageP->code)
+    {
+    case PRV_COAP_CODE_POST:
+        if (messageP->pathCount == 1)
+        {
+            // Registration: the location is /rd/0
+            static const uint8_t options[] = { 0x82, 'r', 'd', 0x01, '0' };
+
+            prv_sendResponse(serverP, messageP, PRV_COAP_CODE_201, options, sizeof(options));
+            serverP->registrationCount++;
+            if (serverP->registrationCount == 1
+                && serverP->observe == true)
+            {
+                prv_sendGet(serverP, PRV_TOKEN_OBSERVE, true);
+            }
+        }
+        else
+        {
+            // Registration Update
+            prv_sendResponse(serverP, messageP, PRV_COAP_CODE_204, NULL, 0);
+            serverP->updateCount++;
+        }
+        break;
+
+    case PRV_COAP_CODE_DELETE:
+        prv_sendResponse(serverP, messageP, PRV_COAP_CODE_202, NULL, 0);
+        break;
+
+    default:
+        prv_sendResponse(serverP, messageP, PRV_COAP_CODE_404, NULL, 0);
+        break;
+    }
+}
+
+static void prv_handleResponse(bench_server_t *serverP,
+                               const prv_message_t *messageP)
+{
+    if (messageP->tokenLength == PRV_TOKEN_LENGTH
+        && memcmp(messageP->token, PRV_TOKEN_READ, PRV_TOKEN_LENGTH) == 0)
+    {
+        // Read by the benchmarks while the server is running
+        __atomic_add_fetch(&serverP->readCount, 1, __ATOMIC_RELEASE);
+        if (serverP->readInFlight > 0)
+        {
+            serverP->readInFlight--;
+        }
+        serverP->lastReadTime = bench_now();
+    }
+    else if (messageP->tokenLength == PRV_TOKEN_LENGTH
+             && memcmp(messageP->token, PRV_TOKEN_OBSERVE, PRV_TOKEN_LENGTH) == 0)
+    {
+        // The piggybacked response to the Observe request is not a notification
+        if (messageP->type != PRV_COAP_TYPE_ACK)
+        {
+            serverP->notificationCount++;
+        }
+    }
+
+    if (messageP->type == PRV_COAP_TYPE_CON)
+    {
+        prv_sendEmptyAck(serverP, messageP->mid);
+    }
+}
+
+static void prv_process(bench_server_t *serverP)
+{
+    uint8_t buffer[PRV_DATAGRAM_SIZE];
+
+    while (true)
+    {
+        struct sockaddr_in addr;
+        socklen_t addrLen;
+        ssize_t length;
+        prv_message_t message;
+
+        addrLen = sizeof(addr);
+        length = recvfrom(serverP->sock, buffer, sizeof(buffer), 0, (struct sockaddr *)&addr, &addrLen);
+        if (length <= 0)
+        {
+            break;
+        }
+
+        if (prv_parse(buffer, (size_t)length, &message) == false)
+        {
+            continue;
+        }
+        serverP->clientPort = ntohs(addr.sin_port);
+
+        if (message.code == PRV_COAP_CODE_EMPTY)
+        {
+            // ACK of a notification or a reset
+            continue;
+        }
+
+        if ((message.code >> 5) == 0)
+        {
+            prv_handleRequest(serverP, &message);
+        }
+        else
+        {
+            prv_handleResponse(serverP, &message);
+        }
+    }
+}
+
+static void prv_sendReads(bench_server_t *serverP)
+{
+    int64_t now;
+
+    if (serverP->registrationCount == 0)
+    {
+        return;
+    }
+
+    now = bench_now();
+    if (serverP->readInFlight > 0
+        && now - serverP->lastReadTime > PRV_READ_TIMEOUT)
+    {
+        // Some requests or responses were dropped by the socket buffers
+        serverP->readInFlight = 0;
+    }
+
+    while (serverP->readInFlight < serverP->readWindow)
+    {
+        if (serverP->readInFlight == 0)
+        {
+            serverP->lastReadTime = now;
+        }
+        prv_sendGet(serverP, PRV_TOKEN_READ, false);
+        serverP->readInFlight++;
+    }
+}
+
+static void *prv_serverThread(void *arg)
+{
+    bench_server_t *serverP;
+
+    serverP = (bench_server_t *)arg;
+
+    while (__atomic_load_n(&serverP->stop, __ATOMIC_ACQUIRE) == 0)
+    {
+        struct pollfd pfd;
+
+        pfd.fd = serverP->sock;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        if (poll(&pfd, 1, PRV_POLL_TIMEOUT) > 0)
+        {
+            prv_process(serverP);
+        }
+
+        if (serverP->readWindow > 0)
+        {
+            prv_sendReads(serverP);
+        }
+    }
+
+    return NULL;
+}
+
+int64_t bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int bench_server_open(bench_server_t *serverP)
+{
+    struct sockaddr_in addr;
+    socklen_t addrLen;
+    int bufferSize;
+
+    serverP->clientPort = 0;
+    serverP->nextMid = 1;
+    serverP->readInFlight = 0;
+    serverP->lastReadTime = 0;
+    serverP->stop = 0;
+    serverP->registrationCount = 0;
+    serverP->updateCount = 0;
+    serverP->notificationCount = 0;
+    serverP->readCount = 0;
+
+    serverP->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (serverP->sock == -1)
+    {
+        return -1;
+    }
+
+    bufferSize = 4 * 1024 * 1024;
+    (void)setsockopt(serverP->sock, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    addrLen = sizeof(addr);
+    if (bind(serverP->sock, (struct sockaddr *)&addr, sizeof(addr)) == -1
+        || getsockname(serverP->sock, (struct sockaddr *)&addr, &addrLen) == -1)
+    {
+        close(serverP->sock);
+        return -1;
+    }
+
+    (void)fcntl(serverP->sock, F_SETFL, fcntl(serverP->sock, F_GETFL) | O_NONBLOCK);
+
+    serverP->port = ntohs(addr.sin_port);
+
+    return 0;
+}
+
+int bench_server_start(bench_server_t *serverP)
+{
+    if (pthread_create(&serverP->thread, NULL, prv_serverThread, serverP) != 0)
+    {
+        close(serverP->sock);
+        return -1;
+    }
+
+    return 0;
+}
+
+void bench_server_stop(bench_server_t *serverP)
+{
+    __atomic_store_n(&serverP->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(serverP->thread, NULL);
+
+    close(serverP->sock);
+}
@@ -0,0 +1,72 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * A minimal stand-in LwM2M Server over loopback
+ * UDP, shared by the benchmarks. It serves a
+ * single LwM2M Client from its own thread.
+ *
+ **************************************************/
+
+#ifndef _BENCH_SERVER_INCLUDE_
+#define _BENCH_SERVER_INCLUDE_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+typedef struct
+{
+    // Configuration, set before bench_server_start()
+    bool      observe;           // Observe the "Sensor Value" Resource (/3303/0/5700) once the Client is registered
+    uint32_t  readWindow;        // Number of Read requests on /3303/0/5700 kept in flight once the Client is registered
+
+    // Internal state
+    int       sock;
+    uint16_t  port;              // The local port of the server, to build the LwM2M Server URI
+    uint16_t  clientPort;        // The port of the registered Client, 0 if none
+    uint16_t  nextMid;
+    uint32_t  readInFlight;
+    int64_t   lastReadTime;      // in microseconds
+    int       stop;
+    pthread_t thread;
+
+    // Results, to read after bench_server_stop()
+    uint32_t  registrationCount;
+    uint32_t  updateCount;
+    uint32_t  notificationCount;
+    uint32_t  readCount;         // Responses to the Read requests, can be read atomically while running
+} bench_server_t;
+
+// Get a monotonic time.
+// Returned value: the current time in microseconds.
+int64_t bench_now(void);
+
+// Open the server socket on an ephemeral loopback port.
+// Returned value: 0 in case of success, -1 otherwise.
+// Parameters:
+// - serverP: the server to open. Its configuration fields must be set.
+int bench_server_open(bench_server_t *serverP);
+
+// Start the thread serving the Client.
+// Returned value: 0 in case of success, -1 otherwise.
+// Parameters:
+// - serverP: an opened server.
+int bench_server_start(bench_server_t *serverP);
+
+// Stop the thread serving the Client and close the socket.
+// Parameters:
+// - serverP: a started server.
+void bench_server_stop(bench_server_t *serverP);
+
+#endif
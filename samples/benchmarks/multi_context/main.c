@@ -0,0 +1,211 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark runs one independent IOWA
+ * context per thread, by default one per core.
+ * Each context is registered to its own stand-in
+ * LwM2M Server which keeps Read requests in
+ * flight. Built with -fsanitize=thread, it checks
+ * that the contexts share no mutable state.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_ipso.h"
+
+#include "bench_server.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define SERVER_SHORT_ID 1234
+#define SERVER_LIFETIME 300
+
+#define DEFAULT_DURATION 5
+
+#define MAX_CONTEXT_COUNT 64
+
+#define READ_WINDOW 16
+
+typedef struct
+{
+    unsigned int   index;
+    int            duration;
+    bench_server_t server;
+    int            result;
+    uint32_t       readCount;
+    double         elapsed;       // in seconds
+} worker_t;
+
+static void *prv_workerThread(void *arg)
+{
+    worker_t *workerP;
+    iowa_context_t iowaH;
+    iowa_device_info_t devInfo;
+    iowa_sensor_t sensorId;
+    char serverUri[64];
+    uint32_t startCount;
+    int64_t startTime;
+    iowa_status_t result;
+
+    workerP = (worker_t *)arg;
+
+    snprintf(serverUri, sizeof(serverUri), "coap://127.0.0.1:%u", workerP->server.port);
+
+    iowaH = iowa_init(NULL);
+    if (iowaH == NULL)
+    {
+        fprintf(stderr, "IOWA context initialization failed.\r\n");
+        workerP->result = -1;
+        return NULL;
+    }
+
+    // Each context uses a receive buffer of its own size
+    result = iowa_receive_buffer_set_size(iowaH, 256 + 128 * (workerP->index % 8));
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = iowa_client_configure(iowaH, "multi_context", &devInfo, NULL);
+    }
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = iowa_client_IPSO_add_sensor(iowaH, IOWA_IPSO_TEMPERATURE, 20.0f, "Cel", NULL, -20.0f, 50.0f, &sensorId);
+    }
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = iowa_client_add_server(iowaH, SERVER_SHORT_ID, serverUri, SERVER_LIFETIME, 0, IOWA_SEC_NONE);
+    }
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "IOWA Client configuration failed (%u.%02u).\r\n", (result & 0xFF) >> 5, (result & 0x1F));
+        iowa_close(iowaH);
+        workerP->result = -1;
+        return NULL;
+    }
+
+    // Register and let the server fill its window of Read requests
+    (void)iowa_step(iowaH, 1);
+
+    startCount = __atomic_load_n(&workerP->server.readCount, __ATOMIC_ACQUIRE);
+    startTime = bench_now();
+    (void)iowa_step(iowaH, workerP->duration);
+    workerP->elapsed = (double)(bench_now() - startTime) / 1000000.0;
+    workerP->readCount = __atomic_load_n(&workerP->server.readCount, __ATOMIC_ACQUIRE) - startCount;
+
+    iowa_client_remove_server(iowaH, SERVER_SHORT_ID);
+    iowa_client_IPSO_remove_sensor(iowaH, sensorId);
+    iowa_close(iowaH);
+
+    workerP->result = 0;
+
+    return NULL;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    worker_t *workerArray;
+    pthread_t threadArray[MAX_CONTEXT_COUNT];
+    int contextCount;
+    int duration;
+    int i;
+    uint32_t totalCount;
+    double totalRate;
+    int result;
+
+    // One context per core by default
+    contextCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (contextCount > MAX_CONTEXT_COUNT)
+    {
+        contextCount = MAX_CONTEXT_COUNT;
+    }
+    duration = DEFAULT_DURATION;
+    if (argc > 1)
+    {
+        contextCount = atoi(argv[1]);
+    }
+    if (argc > 2)
+    {
+        duration = atoi(argv[2]);
+    }
+    if (contextCount <= 0
+        || contextCount > MAX_CONTEXT_COUNT
+        || duration <= 0)
+    {
+        fprintf(stderr, "Usage: %s [context count (1-%d)] [duration in seconds]\r\n", argv[0], MAX_CONTEXT_COUNT);
+        return 1;
+    }
+
+    workerArray = (worker_t *)calloc((size_t)contextCount, sizeof(worker_t));
+    if (workerArray == NULL)
+    {
+        return 1;
+    }
+
+    for (i = 0; i < contextCount; i++)
+    {
+        workerArray[i].index = (unsigned int)i;
+        workerArray[i].duration = duration;
+        workerArray[i].server.readWindow = READ_WINDOW;
+        if (bench_server_open(&(workerArray[i].server)) != 0
+            || bench_server_start(&(workerArray[i].server)) != 0)
+        {
+            fprintf(stderr, "Stand-in server creation failed.\r\n");
+            return 1;
+        }
+    }
+
+    for (i = 0; i < contextCount; i++)
+    {
+        pthread_create(threadArray + i, NULL, prv_workerThread, workerArray + i);
+    }
+
+    result = 0;
+    totalCount = 0;
+    totalRate = 0.0;
+    for (i = 0; i < contextCount; i++)
+    {
+        pthread_join(threadArray[i], NULL);
+        bench_server_stop(&(workerArray[i].server));
+
+        if (workerArray[i].result != 0
+            || workerArray[i].server.registrationCount == 0
+            || workerArray[i].readCount == 0)
+        {
+            result = 1;
+        }
+        else
+        {
+            totalCount += workerArray[i].readCount;
+            totalRate += (double)workerArray[i].readCount / workerArray[i].elapsed;
+        }
+    }
+
+    printf("Contexts:       %d\r\n", contextCount);
+    for (i = 0; i < contextCount; i++)
+    {
+        printf("Context %-3d     %u Reads (%.0f /s)\r\n", i, workerArray[i].readCount, workerArray[i].elapsed > 0.0 ? (double)workerArray[i].readCount / workerArray[i].elapsed : 0.0);
+    }
+    printf("Total:          %u Reads (%.0f /s)\r\n", totalCount, totalRate);
+
+    free(workerArray);
+
+    return result;
+}
@@ -0,0 +1,297 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark measures the lookup of Objects,
+ * instances and resources done by every Read,
+ * Write and notification, on large custom
+ * Objects.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_prv_lwm2m_internals.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Other Objects registered in the context, with IDs around the measured one
+#define FILLER_OBJECT_COUNT 50
+#define FILLER_OBJECT_ID    20000
+
+#define OBJECT_ID 10000
+
+#define DEFAULT_OPERATION_COUNT 200000
+
+typedef struct
+{
+    uint16_t instanceCount;
+    uint16_t resourceCount;
+} configuration_t;
+
+static const configuration_t g_configurationArray[] =
+{
+    { 10, 10 },
+    { 1000, 120 },
+    { 10000, 120 },
+    { 1000, 250 },
+};
+
+static uint32_t g_randomState = 0x12345678;
+
+static uint32_t prv_random(void)
+{
+    // xorshift32, enough to spread the accesses
+    g_randomState ^= g_randomState << 13;
+    g_randomState ^= g_randomState >> 17;
+    g_randomState ^= g_randomState << 5;
+
+    return g_randomState;
+}
+
+static int64_t prv_getTimeNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static iowa_status_t prv_dataCallback(iowa_dm_operation_t operation,
+                                      iowa_lwm2m_data_t *dataP,
+                                      size_t numData,
+                                      void *userData,
+                                      iowa_context_t iowaH)
+{
+    size_t i;
+
+    (void)userData;
+    (void)iowaH;
+
+    if (operation == IOWA_DM_READ)
+    {
+        for (i = 0; i < numData; i++)
+        {
+            dataP[i].value.asInteger = (int64_t)dataP[i].instanceID * 1000 + dataP[i].resourceID;
+        }
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Resource IDs are spread and declared in decreasing order.
+static uint16_t prv_resourceId(uint16_t resourceCount,
+                               uint16_t index)
+{
+    return (uint16_t)(1 + 3 * (resourceCount - 1 - index));
+}
+
+// Instance IDs are spread too.
+static uint16_t prv_instanceId(uint16_t index)
+{
+    return (uint16_t)(2 * index);
+}
+
+static iowa_status_t prv_addObject(iowa_context_t iowaH,
+                                   uint16_t objectId,
+                                   uint16_t instanceCount,
+                                   uint16_t resourceCount)
+{
+    iowa_lwm2m_resource_desc_t *resourceArray;
+    uint16_t *instanceIdArray;
+    uint16_t i;
+    iowa_status_t result;
+
+    resourceArray = (iowa_lwm2m_resource_desc_t *)malloc(resourceCount * sizeof(iowa_lwm2m_resource_desc_t));
+    instanceIdArray = (uint16_t *)malloc(instanceCount * sizeof(uint16_t));
+    if (resourceArray == NULL
+        || instanceIdArray == NULL)
+    {
+        free(resourceArray);
+        free(instanceIdArray);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    for (i = 0; i < resourceCount; i++)
+    {
+        resourceArray[i].id = prv_resourceId(resourceCount, i);
+        resourceArray[i].type = IOWA_LWM2M_TYPE_INTEGER;
+        resourceArray[i].operations = IOWA_OPERATION_READ;
+        resourceArray[i].flags = IOWA_RESOURCE_FLAG_NONE;
+    }
+    for (i = 0; i < instanceCount; i++)
+    {
+        instanceIdArray[i] = prv_instanceId(i);
+    }
+
+    result = iowa_client_add_custom_object(iowaH, objectId, instanceCount, instanceIdArray, resourceCount, resourceArray, prv_dataCallback, NULL, NULL, NULL);
+
+    // IOWA keeps its own copies of the arrays
+    free(resourceArray);
+    free(instanceIdArray);
+
+    return result;
+}
+
+static void prv_runBenchmark(iowa_context_t iowaH,
+                             const configuration_t *configurationP,
+                             unsigned long operationCount)
+{
+    iowa_lwm2m_uri_t uri;
+    unsigned long op;
+    int64_t start;
+    double findNs;
+    double readResourceNs;
+    double readInstanceNs;
+    unsigned long instanceReadCount;
+
+    if (prv_addObject(iowaH, OBJECT_ID, configurationP->instanceCount, configurationP->resourceCount) != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "Adding the Object failed.\r\n");
+        exit(1);
+    }
+
+    // Lookup of a resource
+    start = prv_getTimeNs();
+    for (op = 0; op < operationCount; op++)
+    {
+        lwm2m_object_t *objectP;
+        uint16_t instanceIndex;
+        uint16_t resourceIndex;
+
+        if (object_find(iowaH, OBJECT_ID,
+                        prv_instanceId((uint16_t)(prv_random() % configurationP->instanceCount)),
+                        prv_resourceId(configurationP->resourceCount, (uint16_t)(prv_random() % configurationP->resourceCount)),
+                        &objectP, &instanceIndex, &resourceIndex) != IOWA_COAP_NO_ERROR)
+        {
+            fprintf(stderr, "Resource not found.\r\n");
+            exit(1);
+        }
+    }
+    findNs = (double)(prv_getTimeNs() - start) / operationCount;
+
+    // Read of a single resource, as for a Read request or a notification
+    start = prv_getTimeNs();
+    for (op = 0; op < operationCount; op++)
+    {
+        size_t dataCount;
+        iowa_lwm2m_data_t *dataArray;
+
+        uri.objectId = OBJECT_ID;
+        uri.instanceId = prv_instanceId((uint16_t)(prv_random() % configurationP->instanceCount));
+        uri.resourceId = prv_resourceId(configurationP->resourceCount, (uint16_t)(prv_random() % configurationP->resourceCount));
+        uri.resInstanceId = IOWA_LWM2M_ID_ALL;
+
+        if (object_read(iowaH, &uri, 0, &dataCount, &dataArray) != IOWA_COAP_205_CONTENT)
+        {
+            fprintf(stderr, "Read failed.\r\n");
+            exit(1);
+        }
+        object_free(iowaH, dataCount, dataArray);
+        iowa_system_free(dataArray);
+    }
+    readResourceNs = (double)(prv_getTimeNs() - start) / operationCount;
+
+    // Read of a whole instance, fewer of them as they return all the resources
+    instanceReadCount = operationCount / 10 + 1;
+    start = prv_getTimeNs();
+    for (op = 0; op < instanceReadCount; op++)
+    {
+        size_t dataCount;
+        iowa_lwm2m_data_t *dataArray;
+
+        uri.objectId = OBJECT_ID;
+        uri.instanceId = prv_instanceId((uint16_t)(prv_random() % configurationP->instanceCount));
+        uri.resourceId = IOWA_LWM2M_ID_ALL;
+        uri.resInstanceId = IOWA_LWM2M_ID_ALL;
+
+        if (object_read(iowaH, &uri, 0, &dataCount, &dataArray) != IOWA_COAP_205_CONTENT
+            || dataCount != configurationP->resourceCount)
+        {
+            fprintf(stderr, "Read failed.\r\n");
+            exit(1);
+        }
+        object_free(iowaH, dataCount, dataArray);
+        iowa_system_free(dataArray);
+    }
+    readInstanceNs = (double)(prv_getTimeNs() - start) / instanceReadCount;
+
+    printf("%10u %10u %12.1f %14.1f %14.1f\r\n", configurationP->instanceCount, configurationP->resourceCount, findNs, readResourceNs, readInstanceNs);
+
+    iowa_client_remove_custom_object(iowaH, OBJECT_ID);
+}
+
+int main(int argc,
+         char *argv[])
+{
+    iowa_context_t iowaH;
+    iowa_device_info_t devInfo;
+    unsigned long operationCount;
+    uint16_t i;
+
+    operationCount = DEFAULT_OPERATION_COUNT;
+    if (argc > 1)
+    {
+        operationCount = strtoul(argv[1], NULL, 10);
+        if (operationCount == 0)
+        {
+            fprintf(stderr, "Usage: %s [operation count]\r\n", argv[0]);
+            return 1;
+        }
+    }
+
+    iowaH = iowa_init(NULL);
+    if (iowaH == NULL)
+    {
+        fprintf(stderr, "IOWA context initialization failed.\r\n");
+        return 1;
+    }
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    if (iowa_client_configure(iowaH, "object_lookup", &devInfo, NULL) != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "IOWA Client configuration failed.\r\n");
+        iowa_close(iowaH);
+        return 1;
+    }
+
+    for (i = 0; i < FILLER_OBJECT_COUNT; i++)
+    {
+        if (prv_addObject(iowaH, (uint16_t)(FILLER_OBJECT_ID + i), 1, 1) != IOWA_COAP_NO_ERROR)
+        {
+            fprintf(stderr, "Adding the Objects failed.\r\n");
+            iowa_close(iowaH);
+            return 1;
+        }
+    }
+
+    printf("Nanoseconds per operation, with %d other Objects:\r\n", FILLER_OBJECT_COUNT);
+    printf("%10s %10s %12s %14s %14s\r\n", "instances", "resources", "find", "read resource", "read instance");
+    for (i = 0; i < sizeof(g_configurationArray) / sizeof(configuration_t); i++)
+    {
+        prv_runBenchmark(iowaH, g_configurationArray + i, operationCount);
+    }
+
+    for (i = 0; i < FILLER_OBJECT_COUNT; i++)
+    {
+        iowa_client_remove_custom_object(iowaH, (uint16_t)(FILLER_OBJECT_ID + i));
+    }
+    iowa_close(iowaH);
+
+    return 0;
+}
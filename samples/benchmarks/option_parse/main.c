@@ -0,0 +1,158 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark measures the parsing of typical
+ * received LwM2M datagrams, including the
+ * decoding of their CoAP options, and the release
+ * of the parsed messages.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_prv_coap_internals.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_OPERATION_COUNT 2000000
+
+typedef struct
+{
+    const char    *name;
+    const uint8_t *datagram;
+    size_t         length;
+} datagram_t;
+
+// CON GET /3303/0/5700 with Observe: 0 and Accept: 112 (SenML CBOR)
+static const uint8_t g_observeRequest[] =
+{
+    0x44, 0x01, 0x12, 0x34, 0xCA, 0xFE, 0xBA, 0xBE,
+    0x60,
+    0x54, '3', '3', '0', '3',
+    0x01, '0',
+    0x04, '5', '7', '0', '0',
+    0x61, 0x70
+};
+
+// CON PUT /1/0/1 with Content-Format: 11542 (TLV), writing the lifetime
+static const uint8_t g_writeRequest[] =
+{
+    0x42, 0x03, 0x12, 0x35, 0x01, 0x02,
+    0xB1, '1',
+    0x01, '0',
+    0x01, '1',
+    0x12, 0x2D, 0x16,
+    0xFF, 0xC2, 0x01, 0x0E, 0x10
+};
+
+// ACK 2.01 to a Register request with Location-Path: rd/5a3f
+static const uint8_t g_registrationReply[] =
+{
+    0x64, 0x41, 0x00, 0x01, 0x11, 0x22, 0x33, 0x44,
+    0x82, 'r', 'd',
+    0x04, '5', 'a', '3', 'f'
+};
+
+// CON GET /3/0 with Uri-Queries, Accept and Block2, more options than decoded inline by default
+static const uint8_t g_blockRequest[] =
+{
+    0x44, 0x01, 0x12, 0x36, 0x0B, 0x0C, 0x0D, 0x0E,
+    0xB1, '3',
+    0x01, '0',
+    0x44, 'a', '=', '1', '0',
+    0x04, 'b', '=', '2', '0',
+    0x04, 'c', '=', '3', '0',
+    0x04, 'd', '=', '4', '0',
+    0x04, 'e', '=', '5', '0',
+    0x22, 0x2D, 0x16,
+    0x61, 0x16
+};
+
+static const datagram_t g_datagramArray[] =
+{
+    { "Observe request", g_observeRequest, sizeof(g_observeRequest) },
+    { "Write request", g_writeRequest, sizeof(g_writeRequest) },
+    { "Registration reply", g_registrationReply, sizeof(g_registrationReply) },
+    { "Request with 9 options", g_blockRequest, sizeof(g_blockRequest) },
+};
+
+static int64_t prv_getTimeNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    iowa_context_t iowaH;
+    unsigned long operationCount;
+    size_t i;
+
+    operationCount = DEFAULT_OPERATION_COUNT;
+    if (argc > 1)
+    {
+        operationCount = strtoul(argv[1], NULL, 10);
+        if (operationCount == 0)
+        {
+            fprintf(stderr, "Usage: %s [operation count]\r\n", argv[0]);
+            return 1;
+        }
+    }
+
+    iowaH = iowa_init(NULL);
+    if (iowaH == NULL)
+    {
+        fprintf(stderr, "IOWA context initialization failed.\r\n");
+        return 1;
+    }
+
+    printf("Nanoseconds per parsed and freed message, with %d options decoded inline:\r\n", IOWA_COAP_INLINE_OPTION_COUNT);
+    for (i = 0; i < sizeof(g_datagramArray) / sizeof(datagram_t); i++)
+    {
+        uint8_t buffer[64];
+        unsigned long op;
+        int64_t start;
+
+        // The options point to the received buffer which is not constant
+        memcpy(buffer, g_datagramArray[i].datagram, g_datagramArray[i].length);
+
+        start = prv_getTimeNs();
+        for (op = 0; op < operationCount; op++)
+        {
+            iowa_coap_message_t *messageP;
+
+            if (messageDatagramParse(iowaH, buffer, g_datagramArray[i].length, &messageP) != IOWA_COAP_NO_ERROR)
+            {
+                fprintf(stderr, "Parsing of the %s failed.\r\n", g_datagramArray[i].name);
+                iowa_close(iowaH);
+                return 1;
+            }
+            iowa_coap_message_free(messageP);
+        }
+
+        printf("%-24s %8.1f\r\n", g_datagramArray[i].name, (double)(prv_getTimeNs() - start) / operationCount);
+    }
+
+    iowa_close(iowaH);
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/*********************************************
+*
+* In this file, you can define the compilation
+* flags instead of specifying them on the
+* compiler command-line.
+*
+**********************************************/
+
+#ifndef _IOWA_CONFIG_INCLUDE_
+#define _IOWA_CONFIG_INCLUDE_
+
+/**********************************************
+*
+* Platform configuration.
+*
+**********************************************/
+
+/**********************************************
+* To specify the endianness of your platform.
+* One and only one must be defined.
+*/
+// #define LWM2M_BIG_ENDIAN
+#define LWM2M_LITTLE_ENDIAN
+
+/************************************************
+* To use a millisecond monotonic clock as IOWA
+* time source.
+*/
+#define IOWA_TIME_MS_SUPPORT
+
+/************************************************
+* To specify the size of the static buffer used
+* to received datagram packets.
+*/
+#define IOWA_BUFFER_SIZE 512
+
+/**********************************************
+*
+* IOWA configuration.
+*
+**********************************************/
+
+/**********************************************
+* Support of transports.
+*/
+#define IOWA_UDP_SUPPORT
+
+/**********************************************
+* Support of block-wise transfers. Q-Block
+* support is set by the build.
+*/
+#define IOWA_COAP_BLOCK_SUPPORT
+
+/**********************************************
+* The send pacing is relaxed so that the
+* transfers are limited by the round-trip time,
+* not by the default rate of 20 datagrams per
+* second.
+*/
+#define IOWA_COAP_SEND_BURST 16
+#define IOWA_COAP_SEND_RATE 1000
+
+/***********************************************
+* To enable logs
+*/
+#define IOWA_LOG_LEVEL IOWA_LOG_LEVEL_NONE
+
+/**********************************************
+* To enable LWM2M features.
+**********************************************/
+
+/**********************************************
+* To specify the LWM2M role of your device.
+*/
+#define LWM2M_CLIENT_MODE
+
+#endif
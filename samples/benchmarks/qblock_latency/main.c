@@ -0,0 +1,1516 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark measures the duration of
+ * block-wise transfers against the round-trip
+ * time, with Block1 and Block2 (RFC 7959) or with
+ * Q-Block1 and Q-Block2 (RFC 9177). A stand-in
+ * LwM2M Server delays the datagrams it receives
+ * by the round-trip time and can drop some of the
+ * datagrams in both directions. It times:
+ * - the registration, sent by the Client in
+ *   blocks,
+ * - a Write on a Streamable Resource, sent by
+ *   the Server in blocks,
+ * - a Read on this Resource, returned by the
+ *   Client in blocks.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+
+#include "bench_server.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define SERVER_SHORT_ID 1234
+#define SERVER_LIFETIME 300
+
+#define OBJECT_ID       10240
+
+#define DEFAULT_SIZE    8192
+#define DEFAULT_LOSS    0
+
+// Time in seconds after which a run is abandoned
+#define MAX_RUN_TIME    600
+
+#define MAX_RTT_COUNT   16
+
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+#define TRANSFER_MODE "Q-Block1 and Q-Block2 (RFC 9177)"
+#else
+#define TRANSFER_MODE "Block1 and Block2 (RFC 7959)"
+#endif
+
+#define PRV_COAP_TYPE_CON    0
+#define PRV_COAP_TYPE_NON    1
+#define PRV_COAP_TYPE_ACK    2
+#define PRV_COAP_TYPE_RST    3
+
+#define PRV_COAP_CODE_EMPTY   0x00
+#define PRV_COAP_CODE_GET     0x01
+#define PRV_COAP_CODE_POST    0x02
+#define PRV_COAP_CODE_PUT     0x03
+#define PRV_COAP_CODE_DELETE  0x04
+#define PRV_COAP_CODE_201     0x41
+#define PRV_COAP_CODE_202     0x42
+#define PRV_COAP_CODE_204     0x44
+#define PRV_COAP_CODE_205     0x45
+#define PRV_COAP_CODE_231     0x5F
+#define PRV_COAP_CODE_404     0x84
+#define PRV_COAP_CODE_408     0x88
+
+#define PRV_COAP_OPTION_LOCATION_PATH   8
+#define PRV_COAP_OPTION_URI_PATH        11
+#define PRV_COAP_OPTION_CONTENT_FORMAT  12
+#define PRV_COAP_OPTION_Q_BLOCK_1       19
+#define PRV_COAP_OPTION_BLOCK_2         23
+#define PRV_COAP_OPTION_BLOCK_1         27
+#define PRV_COAP_OPTION_Q_BLOCK_2       31
+#define PRV_COAP_OPTION_REQUEST_TAG     292
+
+#define PRV_CONTENT_FORMAT_OPAQUE           42
+#define PRV_CONTENT_FORMAT_MISSING_BLOCKS   272
+
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+#define PRV_OPTION_WRITE PRV_COAP_OPTION_Q_BLOCK_1
+#define PRV_OPTION_READ  PRV_COAP_OPTION_Q_BLOCK_2
+#else
+#define PRV_OPTION_WRITE PRV_COAP_OPTION_BLOCK_1
+#define PRV_OPTION_READ  PRV_COAP_OPTION_BLOCK_2
+#endif
+
+// Blocks of 256 bytes, the size used by the Client with a receive buffer of 512 bytes
+#define PRV_BLOCK_SZX       4
+#define PRV_BLOCK_SIZE      256
+#define PRV_MAX_BLOCKS      1024
+
+// Blocks of a Q-Block set, as IOWA_COAP_QBLOCK_MAX_PAYLOADS
+#define PRV_MAX_PAYLOADS    10
+
+// Time in microseconds before a request is sent again, as ACK_TIMEOUT and NON_TIMEOUT
+#define PRV_TIMEOUT         2000000
+#define PRV_MAX_RETRANSMIT  4
+#define PRV_MAX_NON_RETRANSMIT  16
+
+#define PRV_TOKEN_LENGTH    4
+#define PRV_DATAGRAM_SIZE   1500
+#define PRV_QUEUE_SIZE      512
+#define PRV_MAX_OPTIONS     16
+
+// Time in milliseconds between two checks of the stop flag
+#define PRV_POLL_TIMEOUT    10
+
+typedef enum
+{
+    PHASE_REGISTRATION = 0,
+    PHASE_WRITE,
+    PHASE_READ,
+    PHASE_DONE,
+    PHASE_FAILED
+} prv_phase_t;
+
+typedef struct
+{
+    uint16_t       number;
+    const uint8_t *value;
+    size_t         length;
+} prv_option_t;
+
+typedef struct
+{
+    uint8_t        type;
+    uint8_t        code;
+    uint16_t       mid;
+    uint8_t        tokenLength;
+    const uint8_t *token;
+    size_t         optionCount;
+    prv_option_t   optionArray[PRV_MAX_OPTIONS];
+    const uint8_t *payload;
+    size_t         payloadLength;
+} prv_message_t;
+
+typedef struct
+{
+    int64_t dueTime;     // in microseconds
+    int64_t arrivalTime; // in microseconds
+    size_t  length;
+    uint8_t buffer[PRV_DATAGRAM_SIZE];
+} prv_datagram_t;
+
+typedef struct
+{
+    // Configuration
+    int64_t        rtt;              // in microseconds
+    uint32_t       loss;             // in percent
+    size_t         size;             // of the written and read content
+
+    // Internal state
+    int            sock;
+    uint16_t       port;
+    uint16_t       clientPort;
+    uint16_t       nextMid;
+    uint32_t       nextToken;
+    uint32_t       random;
+    int            stop;
+    pthread_t      thread;
+    prv_datagram_t *queueArray;      // datagrams delayed by the round-trip time
+    size_t         queueStart;
+    size_t         queueCount;
+
+    // Current transfer
+    prv_phase_t    phase;
+    int64_t        startTime;
+    uint8_t        receivedArray[PRV_MAX_BLOCKS];
+    uint32_t       blockCount;       // 0 until the last block is known
+    uint32_t       highNumber;       // one more than the highest block number received
+    uint32_t       setStart;
+    uint32_t       nextNumber;       // first block not sent yet
+    size_t         receivedLength;
+
+    // Request waiting for a response
+    uint8_t        pendingBuffer[PRV_DATAGRAM_SIZE];
+    size_t         pendingLength;
+    uint8_t        pendingToken[PRV_TOKEN_LENGTH];
+    int64_t        pendingTime;      // in microseconds
+    uint8_t        retransmitCount;
+
+    // Results
+    double         durationArray[3]; // in seconds, for each phase
+    size_t         registrationLength;
+    uint32_t       retransmissionCount;
+} prv_server_t;
+
+static uint8_t *g_writtenBuffer;
+static size_t g_writtenLength;
+static size_t g_contentSize;
+
+static uint8_t prv_pattern(size_t offset)
+{
+    return (uint8_t)(offset * 7 + 3);
+}
+
+/*************************************************************************************
+** Stand-in LwM2M Server
+*************************************************************************************/
+
+static bool prv_drop(prv_server_t *serverP)
+{
+    // xorshift32, seeded to give the same losses from one run to the other
+    serverP->random ^= serverP->random << 13;
+    serverP->random ^= serverP->random >> 17;
+    serverP->random ^= serverP->random << 5;
+
+    return (serverP->random % 100) < serverP->loss;
+}
+
+static bool prv_parse(const uint8_t *buffer,
+                      size_t length,
+                      prv_message_t *messageP)
+{
+    size_t pos;
+    uint16_t number;
+
+    if (length < 4
+        || (buffer[0] >> 6) != 1)
+    {
+        return false;
+    }
+
+    messageP->type = (buffer[0] >> 4) & 0x03;
+    messageP->tokenLength = buffer[0] & 0x0F;
+    messageP->code = buffer[1];
+    messageP->mid = (uint16_t)((buffer[2] << 8) | buffer[3]);
+    messageP->token = buffer + 4;
+    messageP->optionCount = 0;
+    messageP->payload = NULL;
+    messageP->payloadLength = 0;
+
+    if (messageP->tokenLength > 8
+        || 4 + (size_t)messageP->tokenLength > length)
+    {
+        return false;
+    }
+
+    pos = 4 + (size_t)messageP->tokenLength;
+    number = 0;
+    while (pos < length
+           && buffer[pos] != 0xFF)
+    {
+        size_t delta;
+        size_t optionLength;
+
+        delta = buffer[pos] >> 4;
+        optionLength = buffer[pos] & 0x0F;
+        pos++;
+
+        if (delta == 13)
+        {
+            if (pos >= length) return false;
+            delta = 13 + (size_t)buffer[pos];
+            pos++;
+        }
+        else if (delta == 14)
+        {
+            if (pos + 1 >= length) return false;
+            delta = 269 + (((size_t)buffer[pos] << 8) | buffer[pos + 1]);
+            pos += 2;
+        }
+        if (optionLength == 13)
+        {
+            if (pos >= length) return false;
+            optionLength = 13 + (size_t)buffer[pos];
+            pos++;
+        }
+        else if (optionLength == 14)
+        {
+            if (pos + 1 >= length) return false;
+            optionLength = 269 + (((size_t)buffer[pos] << 8) | buffer[pos + 1]);
+            pos += 2;
+        }
+        if (pos + optionLength > length
+            || messageP->optionCount == PRV_MAX_OPTIONS)
+        {
+            return false;
+        }
+
+        number = (uint16_t)(number + delta);
+        messageP->optionArray[messageP->optionCount].number = number;
+        messageP->optionArray[messageP->optionCount].value = buffer + pos;
+        messageP->optionArray[messageP->optionCount].length = optionLength;
+        messageP->optionCount++;
+
+        pos += optionLength;
+    }
+
+    if (pos < length)
+    {
+        // Skip the payload marker
+        messageP->payload = buffer + pos + 1;
+        messageP->payloadLength = length - pos - 1;
+    }
+
+    return true;
+}
+
+static const prv_option_t *prv_findOption(const prv_message_t *messageP,
+                                          uint16_t number)
+{
+    size_t i;
+
+    for (i = 0; i < messageP->optionCount; i++)
+    {
+        if (messageP->optionArray[i].number == number)
+        {
+            return messageP->optionArray + i;
+        }
+    }
+
+    return NULL;
+}
+
+static uint32_t prv_optionUint(const prv_option_t *optionP)
+{
+    uint32_t value;
+    size_t i;
+
+    value = 0;
+    for (i = 0; i < optionP->length && i < 4; i++)
+    {
+        value = (value << 8) | optionP->value[i];
+    }
+
+    return value;
+}
+
+static size_t prv_writeHeader(uint8_t *buffer,
+                              uint8_t type,
+                              uint8_t code,
+                              uint16_t mid,
+                              const uint8_t *token,
+                              uint8_t tokenLength)
+{
+    buffer[0] = (uint8_t)(0x40 | (type << 4) | tokenLength);
+    buffer[1] = code;
+    buffer[2] = (uint8_t)(mid >> 8);
+    buffer[3] = (uint8_t)(mid & 0xFF);
+    memcpy(buffer + 4, token, tokenLength);
+
+    return 4 + (size_t)tokenLength;
+}
+
+// Options must be written by increasing numbers.
+static size_t prv_writeOption(uint8_t *buffer,
+                              uint16_t *lastNumberP,
+                              uint16_t number,
+                              const uint8_t *value,
+                              size_t length)
+{
+    size_t pos;
+    uint16_t delta;
+
+    pos = 1;
+    delta = (uint16_t)(number - *lastNumberP);
+    if (delta < 13)
+    {
+        buffer[0] = (uint8_t)(delta << 4);
+    }
+    else if (delta < 269)
+    {
+        buffer[0] = 13 << 4;
+        buffer[pos++] = (uint8_t)(delta - 13);
+    }
+    else
+    {
+        buffer[0] = 14 << 4;
+        buffer[pos++] = (uint8_t)((delta - 269) >> 8);
+        buffer[pos++] = (uint8_t)((delta - 269) & 0xFF);
+    }
+    // Values are shorter than 13 bytes here
+    buffer[0] |= (uint8_t)length;
+    memcpy(buffer + pos, value, length);
+    *lastNumberP = number;
+
+    return pos + length;
+}
+
+static size_t prv_writeUintOption(uint8_t *buffer,
+                                  uint16_t *lastNumberP,
+                                  uint16_t number,
+                                  uint32_t value)
+{
+    uint8_t valueBuffer[4];
+    size_t length;
+
+    length = 0;
+    while ((value >> (8 * length)) != 0
+           && length < 4)
+    {
+        length++;
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+        valueBuffer[i] = (uint8_t)(value >> (8 * (length - 1 - i)));
+    }
+
+    return prv_writeOption(buffer, lastNumberP, number, valueBuffer, length);
+}
+
+static uint32_t prv_blockValue(uint32_t number,
+                               bool more)
+{
+    return (number << 4) | (more == true ? 0x08 : 0x00) | PRV_BLOCK_SZX;
+}
+
+static void prv_send(prv_server_t *serverP,
+                     const uint8_t *buffer,
+                     size_t length)
+{
+    struct sockaddr_in addr;
+
+    if (prv_drop(serverP) == true)
+    {
+        return;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(serverP->clientPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    (void)sendto(serverP->sock, buffer, length, 0, (struct sockaddr *)&addr, sizeof(addr));
+}
+
+// Answer a request from the Client, piggybacked if the request is confirmable.
+static void prv_sendResponse(prv_server_t *serverP,
+                             const prv_message_t *requestP,
+                             uint8_t code,
+                             const uint8_t *options,
+                             size_t optionsLength,
+                             const uint8_t *payload,
+                             size_t payloadLength)
+{
+    uint8_t buffer[PRV_DATAGRAM_SIZE];
+    size_t length;
+
+    if (requestP->type == PRV_COAP_TYPE_CON)
+    {
+        length = prv_writeHeader(buffer, PRV_COAP_TYPE_ACK, code, requestP->mid, requestP->token, requestP->tokenLength);
+    }
+    else
+    {
+        length = prv_writeHeader(buffer, PRV_COAP_TYPE_NON, code, serverP->nextMid++, requestP->token, requestP->tokenLength);
+    }
+    memcpy(buffer + length, options, optionsLength);
+    length += optionsLength;
+    if (payloadLength > 0)
+    {
+        buffer[length++] = 0xFF;
+        memcpy(buffer + length, payload, payloadLength);
+        length += payloadLength;
+    }
+
+    prv_send(serverP, buffer, length);
+}
+
+// Build a request on /10240/0/0 with a new token and a new Message ID.
+static size_t prv_writeRequest(prv_server_t *serverP,
+                               uint8_t *buffer,
+                               uint8_t type,
+                               uint8_t code,
+                               uint8_t *tokenP,
+                               uint16_t *lastNumberP)
+{
+    size_t length;
+    uint32_t token;
+    static const uint8_t path[] = { 0xB5, '1', '0', '2', '4', '0', 0x01, '0', 0x01, '0' };
+
+    token = serverP->nextToken++;
+    tokenP[0] = (uint8_t)(token >> 24);
+    tokenP[1] = (uint8_t)(token >> 16);
+    tokenP[2] = (uint8_t)(token >> 8);
+    tokenP[3] = (uint8_t)token;
+
+    length = prv_writeHeader(buffer, type, code, serverP->nextMid++, tokenP, PRV_TOKEN_LENGTH);
+    memcpy(buffer + length, path, sizeof(path));
+    *lastNumberP = PRV_COAP_OPTION_URI_PATH;
+
+    return length + sizeof(path);
+}
+
+// Keep a request until its response, to send it again after a timeout.
+static void prv_setPending(prv_server_t *serverP,
+                           const uint8_t *buffer,
+                           size_t length)
+{
+    memcpy(serverP->pendingBuffer, buffer, length);
+    serverP->pendingLength = length;
+    memcpy(serverP->pendingToken, buffer + 4, PRV_TOKEN_LENGTH);
+    serverP->pendingTime = bench_now();
+    serverP->retransmitCount = 0;
+}
+
+static void prv_endPhase(prv_server_t *serverP)
+{
+    serverP->durationArray[serverP->phase] = (double)(bench_now() - serverP->startTime) / 1000000.0;
+    serverP->phase++;
+    serverP->pendingLength = 0;
+
+    memset(serverP->receivedArray, 0, sizeof(serverP->receivedArray));
+    serverP->blockCount = 0;
+    serverP->highNumber = 0;
+    serverP->setStart = 0;
+    serverP->nextNumber = 0;
+    serverP->receivedLength = 0;
+    serverP->startTime = bench_now();
+}
+
+static void prv_fail(prv_server_t *serverP,
+                     const char *reason)
+{
+    fprintf(stderr, "Phase %d failed: %s\r\n", serverP->phase, reason);
+    serverP->phase = PHASE_FAILED;
+    serverP->pendingLength = 0;
+}
+
+/********************************
+* Registration
+*/
+
+static void prv_handleRegistration(prv_server_t *serverP,
+                                   const prv_message_t *messageP,
+                                   int64_t arrivalTime)
+{
+    const prv_option_t *optionP;
+    uint8_t options[64];
+    size_t length;
+    uint16_t lastNumber;
+    uint32_t value;
+    uint32_t number;
+    bool more;
+    bool repeated;
+    uint32_t i;
+
+    optionP = prv_findOption(messageP, PRV_COAP_OPTION_Q_BLOCK_1);
+    if (optionP == NULL)
+    {
+        optionP = prv_findOption(messageP, PRV_COAP_OPTION_BLOCK_1);
+    }
+
+    if (serverP->phase != PHASE_REGISTRATION)
+    {
+        // A late retransmission of the last block
+        length = 0;
+        lastNumber = 0;
+        length += prv_writeOption(options + length, &lastNumber, PRV_COAP_OPTION_LOCATION_PATH, (const uint8_t *)"rd", 2);
+        length += prv_writeOption(options + length, &lastNumber, PRV_COAP_OPTION_LOCATION_PATH, (const uint8_t *)"0", 1);
+        prv_sendResponse(serverP, messageP, PRV_COAP_CODE_201, options, length, NULL, 0);
+        return;
+    }
+
+    if (serverP->startTime == 0)
+    {
+        serverP->startTime = arrivalTime;
+    }
+
+    if (optionP == NULL)
+    {
+        number = 0;
+        more = false;
+    }
+    else
+    {
+        value = prv_optionUint(optionP);
+        number = value >> 4;
+        more = (value & 0x08) != 0;
+        if ((value & 0x07) != PRV_BLOCK_SZX
+            || number >= PRV_MAX_BLOCKS)
+        {
+            prv_fail(serverP, "unexpected registration block");
+            return;
+        }
+    }
+
+    repeated = serverP->receivedArray[number] != 0;
+    if (repeated == false)
+    {
+        serverP->receivedArray[number] = 1;
+        serverP->receivedLength += messageP->payloadLength;
+    }
+    if (number >= serverP->highNumber)
+    {
+        serverP->highNumber = number + 1;
+    }
+    if (more == false)
+    {
+        serverP->blockCount = number + 1;
+    }
+
+    if (optionP != NULL
+        && optionP->number == PRV_COAP_OPTION_Q_BLOCK_1
+        && messageP->type != PRV_COAP_TYPE_CON
+        && repeated == false
+        && more == true)
+    {
+        if (number >= serverP->setStart)
+        {
+            // Only the last block of a set is answered
+            if (number < serverP->setStart + PRV_MAX_PAYLOADS - 1)
+            {
+                return;
+            }
+        }
+        else
+        {
+            // Only the last of the blocks reported missing is answered
+            for (i = number + 1; i < serverP->highNumber; i++)
+            {
+                if (serverP->receivedArray[i] == 0)
+                {
+                    return;
+                }
+            }
+        }
+    }
+    if (number >= serverP->setStart)
+    {
+        serverP->setStart = number + 1;
+    }
+
+    length = 0;
+    lastNumber = 0;
+    for (i = 0; i < serverP->highNumber; i++)
+    {
+        if (serverP->receivedArray[i] == 0)
+        {
+            break;
+        }
+    }
+    if (i < serverP->highNumber)
+    {
+        uint8_t payload[64];
+        size_t payloadLength;
+
+        // Report the missing blocks as a CBOR sequence
+        payloadLength = 0;
+        for (; i < serverP->highNumber && payloadLength + 3 <= sizeof(payload); i++)
+        {
+            if (serverP->receivedArray[i] == 0)
+            {
+                if (i < 24)
+                {
+                    payload[payloadLength++] = (uint8_t)i;
+                }
+                else if (i < 256)
+                {
+                    payload[payloadLength++] = 0x18;
+                    payload[payloadLength++] = (uint8_t)i;
+                }
+                else
+                {
+                    payload[payloadLength++] = 0x19;
+                    payload[payloadLength++] = (uint8_t)(i >> 8);
+                    payload[payloadLength++] = (uint8_t)i;
+                }
+            }
+        }
+        length += prv_writeUintOption(options + length, &lastNumber, PRV_COAP_OPTION_CONTENT_FORMAT, PRV_CONTENT_FORMAT_MISSING_BLOCKS);
+        prv_sendResponse(serverP, messageP, PRV_COAP_CODE_408, options, length, payload, payloadLength);
+    }
+    else if (serverP->blockCount == 0)
+    {
+        length += prv_writeUintOption(options + length, &lastNumber, optionP->number, prv_blockValue(number, true));
+        prv_sendResponse(serverP, messageP, PRV_COAP_CODE_231, options, length, NULL, 0);
+    }
+    else
+    {
+        length += prv_writeOption(options + length, &lastNumber, PRV_COAP_OPTION_LOCATION_PATH, (const uint8_t *)"rd", 2);
+        length += prv_writeOption(options + length, &lastNumber, PRV_COAP_OPTION_LOCATION_PATH, (const uint8_t *)"0", 1);
+        if (optionP != NULL)
+        {
+            length += prv_writeUintOption(options + length, &lastNumber, optionP->number, prv_blockValue(number, false));
+        }
+        prv_sendResponse(serverP, messageP, PRV_COAP_CODE_201, options, length, NULL, 0);
+
+        serverP->registrationLength = serverP->receivedLength;
+        prv_endPhase(serverP);
+        serverP->blockCount = (uint32_t)((serverP->size + PRV_BLOCK_SIZE - 1) / PRV_BLOCK_SIZE);
+    }
+}
+
+/********************************
+* Write
+*/
+
+static void prv_sendWriteBlock(prv_server_t *serverP,
+                               uint32_t number,
+                               bool wait)
+{
+    uint8_t buffer[PRV_DATAGRAM_SIZE];
+    uint8_t token[PRV_TOKEN_LENGTH];
+    uint16_t lastNumber;
+    size_t length;
+    size_t offset;
+    size_t payloadLength;
+    uint8_t type;
+    size_t i;
+
+    // With Q-Block1, the first block probes the Client support and is confirmable
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    type = number == 0 ? PRV_COAP_TYPE_CON : PRV_COAP_TYPE_NON;
+#else
+    type = PRV_COAP_TYPE_CON;
+#endif
+
+    offset = (size_t)number * PRV_BLOCK_SIZE;
+    payloadLength = serverP->size - offset;
+    if (payloadLength > PRV_BLOCK_SIZE)
+    {
+        payloadLength = PRV_BLOCK_SIZE;
+    }
+
+    length = prv_writeRequest(serverP, buffer, type, PRV_COAP_CODE_PUT, token, &lastNumber);
+    length += prv_writeUintOption(buffer + length, &lastNumber, PRV_COAP_OPTION_CONTENT_FORMAT, PRV_CONTENT_FORMAT_OPAQUE);
+    length += prv_writeUintOption(buffer + length, &lastNumber, PRV_OPTION_WRITE, prv_blockValue(number, number + 1 < serverP->blockCount));
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    length += prv_writeOption(buffer + length, &lastNumber, PRV_COAP_OPTION_REQUEST_TAG, (const uint8_t *)"wr", 2);
+#endif
+    buffer[length++] = 0xFF;
+    for (i = 0; i < payloadLength; i++)
+    {
+        buffer[length + i] = prv_pattern(offset + i);
+    }
+    length += payloadLength;
+
+    prv_send(serverP, buffer, length);
+    if (wait == true)
+    {
+        prv_setPending(serverP, buffer, length);
+    }
+}
+
+static void prv_sendWriteSet(prv_server_t *serverP)
+{
+    uint32_t last;
+
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    last = serverP->nextNumber + PRV_MAX_PAYLOADS - 1;
+    if (serverP->nextNumber == 0)
+    {
+        last = 0;
+    }
+#else
+    last = serverP->nextNumber;
+#endif
+    if (last >= serverP->blockCount)
+    {
+        last = serverP->blockCount - 1;
+    }
+
+    while (serverP->nextNumber <= last)
+    {
+        prv_sendWriteBlock(serverP, serverP->nextNumber, serverP->nextNumber == last);
+        serverP->nextNumber++;
+    }
+}
+
+static void prv_handleWriteResponse(prv_server_t *serverP,
+                                    const prv_message_t *messageP)
+{
+    switch (messageP->code)
+    {
+    case PRV_COAP_CODE_231:
+        if (serverP->nextNumber < serverP->blockCount)
+        {
+            prv_sendWriteSet(serverP);
+        }
+        break;
+
+    case PRV_COAP_CODE_408:
+    {
+        size_t pos;
+        uint32_t number;
+        uint32_t missingArray[PRV_MAX_BLOCKS];
+        size_t missingCount;
+        size_t i;
+
+        // The missing blocks are a CBOR sequence of unsigned integers
+        missingCount = 0;
+        pos = 0;
+        while (pos < messageP->payloadLength
+               && missingCount < PRV_MAX_BLOCKS)
+        {
+            uint8_t additional;
+
+            additional = messageP->payload[pos] & 0x1F;
+            if ((messageP->payload[pos] >> 5) != 0
+                || additional > 0x1A)
+            {
+                prv_fail(serverP, "invalid missing blocks");
+                return;
+            }
+            pos++;
+            if (additional < 24)
+            {
+                number = additional;
+            }
+            else
+            {
+                size_t count;
+
+                count = (size_t)1 << (additional - 24);
+                if (pos + count > messageP->payloadLength)
+                {
+                    prv_fail(serverP, "invalid missing blocks");
+                    return;
+                }
+                number = 0;
+                for (i = 0; i < count; i++)
+                {
+                    number = (number << 8) | messageP->payload[pos + i];
+                }
+                pos += count;
+            }
+            if (number >= serverP->nextNumber)
+            {
+                prv_fail(serverP, "block reported missing before being sent");
+                return;
+            }
+            missingArray[missingCount++] = number;
+        }
+        if (missingCount == 0)
+        {
+            prv_fail(serverP, "no missing blocks");
+            return;
+        }
+        for (i = 0; i < missingCount; i++)
+        {
+            prv_sendWriteBlock(serverP, missingArray[i], i + 1 == missingCount);
+        }
+        break;
+    }
+
+    case PRV_COAP_CODE_204:
+        if (serverP->nextNumber >= serverP->blockCount)
+        {
+            prv_endPhase(serverP);
+        }
+        break;
+
+    default:
+        prv_fail(serverP, "Write rejected");
+        break;
+    }
+}
+
+/********************************
+* Read
+*/
+
+static void prv_sendReadRequest(prv_server_t *serverP,
+                                uint32_t number)
+{
+    uint8_t buffer[64];
+    uint8_t token[PRV_TOKEN_LENGTH];
+    uint16_t lastNumber;
+    size_t length;
+
+    length = prv_writeRequest(serverP, buffer, PRV_COAP_TYPE_CON, PRV_COAP_CODE_GET, token, &lastNumber);
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    // Ask for the whole set
+    length += prv_writeUintOption(buffer + length, &lastNumber, PRV_OPTION_READ, prv_blockValue(number, true));
+#else
+    length += prv_writeUintOption(buffer + length, &lastNumber, PRV_OPTION_READ, prv_blockValue(number, false));
+#endif
+    serverP->setStart = number;
+
+    prv_send(serverP, buffer, length);
+    prv_setPending(serverP, buffer, length);
+}
+
+static uint32_t prv_firstMissingBlock(prv_server_t *serverP)
+{
+    uint32_t number;
+
+    number = 0;
+    while (number < PRV_MAX_BLOCKS
+           && serverP->receivedArray[number] != 0)
+    {
+        number++;
+    }
+
+    return number;
+}
+
+static void prv_handleReadResponse(prv_server_t *serverP,
+                                   const prv_message_t *messageP)
+{
+    const prv_option_t *optionP;
+    uint32_t value;
+    uint32_t number;
+    uint32_t missing;
+    size_t offset;
+    size_t i;
+
+    optionP = prv_findOption(messageP, PRV_OPTION_READ);
+    if (messageP->code != PRV_COAP_CODE_205
+        || optionP == NULL)
+    {
+        prv_fail(serverP, "Read rejected");
+        return;
+    }
+
+    value = prv_optionUint(optionP);
+    number = value >> 4;
+    offset = (size_t)number * PRV_BLOCK_SIZE;
+    if ((value & 0x07) != PRV_BLOCK_SZX
+        || number >= PRV_MAX_BLOCKS
+        || offset + messageP->payloadLength > serverP->size
+        || (messageP->payloadLength != PRV_BLOCK_SIZE && (value & 0x08) != 0))
+    {
+        prv_fail(serverP, "unexpected Read block");
+        return;
+    }
+    for (i = 0; i < messageP->payloadLength; i++)
+    {
+        if (messageP->payload[i] != prv_pattern(offset + i))
+        {
+            prv_fail(serverP, "Read content mismatch");
+            return;
+        }
+    }
+
+    if (serverP->receivedArray[number] == 0)
+    {
+        // Wait again for the rest of the set
+        serverP->receivedArray[number] = 1;
+        serverP->pendingTime = bench_now();
+        serverP->retransmitCount = 0;
+    }
+    if ((value & 0x08) == 0)
+    {
+        serverP->blockCount = number + 1;
+    }
+
+    missing = prv_firstMissingBlock(serverP);
+    if (serverP->blockCount != 0
+        && missing >= serverP->blockCount)
+    {
+        if (offset + messageP->payloadLength != serverP->size
+            && (value & 0x08) == 0)
+        {
+            prv_fail(serverP, "Read content truncated");
+            return;
+        }
+        prv_endPhase(serverP);
+        return;
+    }
+
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    if (missing >= serverP->setStart + PRV_MAX_PAYLOADS)
+    {
+        // The whole set was received
+        prv_sendReadRequest(serverP, missing);
+    }
+#else
+    if (memcmp(messageP->token, serverP->pendingToken, PRV_TOKEN_LENGTH) == 0)
+    {
+        prv_sendReadRequest(serverP, missing);
+    }
+#endif
+}
+
+/********************************
+* Main loop
+*/
+
+static void prv_handleMessage(prv_server_t *serverP,
+                              const prv_message_t *messageP,
+                              int64_t arrivalTime)
+{
+    if (messageP->code == PRV_COAP_CODE_EMPTY)
+    {
+        return;
+    }
+
+    if ((messageP->code >> 5) == 0)
+    {
+        switch (messageP->code)
+        {
+        case PRV_COAP_CODE_POST:
+            prv_handleRegistration(serverP, messageP, arrivalTime);
+            break;
+
+        case PRV_COAP_CODE_DELETE:
+            prv_sendResponse(serverP, messageP, PRV_COAP_CODE_202, NULL, 0, NULL, 0);
+            break;
+
+        default:
+            prv_sendResponse(serverP, messageP, PRV_COAP_CODE_404, NULL, 0, NULL, 0);
+            break;
+        }
+        return;
+    }
+
+    switch (serverP->phase)
+    {
+    case PHASE_WRITE:
+        if (messageP->tokenLength == PRV_TOKEN_LENGTH
+            && serverP->pendingLength != 0
+            && memcmp(messageP->token, serverP->pendingToken, PRV_TOKEN_LENGTH) == 0)
+        {
+            prv_handleWriteResponse(serverP, messageP);
+        }
+        break;
+
+    case PHASE_READ:
+        prv_handleReadResponse(serverP, messageP);
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void prv_receive(prv_server_t *serverP)
+{
+    struct sockaddr_in addr;
+    socklen_t addrLen;
+    prv_datagram_t *datagramP;
+    uint8_t buffer[PRV_DATAGRAM_SIZE];
+    ssize_t length;
+    int64_t now;
+
+    while (true)
+    {
+        addrLen = sizeof(addr);
+        length = recvfrom(serverP->sock, buffer, sizeof(buffer), 0, (struct sockaddr *)&addr, &addrLen);
+        if (length <= 0)
+        {
+            return;
+        }
+        serverP->clientPort = ntohs(addr.sin_port);
+
+        if (prv_drop(serverP) == true
+            || serverP->queueCount == PRV_QUEUE_SIZE)
+        {
+            continue;
+        }
+
+        now = bench_now();
+        datagramP = serverP->queueArray + (serverP->queueStart + serverP->queueCount) % PRV_QUEUE_SIZE;
+        datagramP->arrivalTime = now;
+        datagramP->dueTime = now + serverP->rtt;
+        datagramP->length = (size_t)length;
+        memcpy(datagramP->buffer, buffer, (size_t)length);
+        serverP->queueCount++;
+    }
+}
+
+static void prv_processDueDatagrams(prv_server_t *serverP)
+{
+    prv_datagram_t *datagramP;
+    prv_message_t message;
+
+    while (serverP->queueCount > 0)
+    {
+        datagramP = serverP->queueArray + serverP->queueStart;
+        if (datagramP->dueTime > bench_now())
+        {
+            return;
+        }
+
+        if (prv_parse(datagramP->buffer, datagramP->length, &message) == true)
+        {
+            prv_handleMessage(serverP, &message, datagramP->arrivalTime);
+        }
+
+        serverP->queueStart = (serverP->queueStart + 1) % PRV_QUEUE_SIZE;
+        serverP->queueCount--;
+    }
+}
+
+static void prv_checkTimeout(prv_server_t *serverP)
+{
+    uint16_t mid;
+    bool resend;
+    int64_t timeout;
+    uint8_t maxRetransmit;
+
+    if (serverP->pendingLength == 0)
+    {
+        return;
+    }
+
+    // Confirmable messages are retransmitted with an exponential back-off. A non-confirmable
+    // block, or a Q-Block2 request asking again for the missing blocks, is a new message.
+    resend = ((serverP->pendingBuffer[0] >> 4) & 0x03) == PRV_COAP_TYPE_CON;
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    if (serverP->phase == PHASE_READ)
+    {
+        resend = false;
+    }
+#endif
+    if (resend == true)
+    {
+        timeout = (int64_t)PRV_TIMEOUT << serverP->retransmitCount;
+        maxRetransmit = PRV_MAX_RETRANSMIT;
+    }
+    else
+    {
+        timeout = PRV_TIMEOUT;
+        maxRetransmit = PRV_MAX_NON_RETRANSMIT;
+    }
+
+    if (bench_now() - serverP->pendingTime < timeout)
+    {
+        return;
+    }
+
+    if (serverP->retransmitCount == maxRetransmit)
+    {
+        prv_fail(serverP, "no response");
+        return;
+    }
+
+#ifdef IOWA_COAP_QBLOCK_SUPPORT
+    if (serverP->phase == PHASE_READ)
+    {
+        uint8_t retransmitCount;
+
+        // Ask again for the set from the first missing block
+        retransmitCount = serverP->retransmitCount;
+        prv_sendReadRequest(serverP, prv_firstMissingBlock(serverP));
+        serverP->retransmitCount = retransmitCount + 1;
+        serverP->retransmissionCount++;
+        return;
+    }
+#endif
+
+    if (resend == false)
+    {
+        mid = serverP->nextMid++;
+        serverP->pendingBuffer[2] = (uint8_t)(mid >> 8);
+        serverP->pendingBuffer[3] = (uint8_t)(mid & 0xFF);
+    }
+    serverP->pendingTime = bench_now();
+    serverP->retransmitCount++;
+    serverP->retransmissionCount++;
+    prv_send(serverP, serverP->pendingBuffer, serverP->pendingLength);
+}
+
+static void *prv_serverThread(void *arg)
+{
+    prv_server_t *serverP;
+    struct pollfd pfd;
+    int timeout;
+
+    serverP = (prv_server_t *)arg;
+
+    while (__atomic_load_n(&serverP->stop, __ATOMIC_ACQUIRE) == 0)
+    {
+        timeout = PRV_POLL_TIMEOUT;
+        if (serverP->queueCount > 0)
+        {
+            int64_t delay;
+
+            delay = (serverP->queueArray[serverP->queueStart].dueTime - bench_now()) / 1000;
+            if (delay < timeout)
+            {
+                timeout = delay > 0 ? (int)delay : 0;
+            }
+        }
+
+        pfd.fd = serverP->sock;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, timeout) > 0)
+        {
+            prv_receive(serverP);
+        }
+
+        prv_processDueDatagrams(serverP);
+
+        if (__atomic_load_n(&serverP->phase, __ATOMIC_ACQUIRE) == PHASE_WRITE
+            && serverP->nextNumber == 0)
+        {
+            prv_sendWriteSet(serverP);
+        }
+        else if (serverP->phase == PHASE_READ
+                 && serverP->pendingLength == 0)
+        {
+            prv_sendReadRequest(serverP, 0);
+        }
+
+        prv_checkTimeout(serverP);
+    }
+
+    return NULL;
+}
+
+static int prv_serverOpen(prv_server_t *serverP)
+{
+    struct sockaddr_in addr;
+    socklen_t addrLen;
+
+    serverP->queueArray = (prv_datagram_t *)malloc(PRV_QUEUE_SIZE * sizeof(prv_datagram_t));
+    if (serverP->queueArray == NULL)
+    {
+        return -1;
+    }
+
+    serverP->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (serverP->sock == -1)
+    {
+        free(serverP->queueArray);
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    addrLen = sizeof(addr);
+    if (bind(serverP->sock, (struct sockaddr *)&addr, sizeof(addr)) == -1
+        || getsockname(serverP->sock, (struct sockaddr *)&addr, &addrLen) == -1)
+    {
+        close(serverP->sock);
+        free(serverP->queueArray);
+        return -1;
+    }
+
+    (void)fcntl(serverP->sock, F_SETFL, fcntl(serverP->sock, F_GETFL) | O_NONBLOCK);
+
+    serverP->port = ntohs(addr.sin_port);
+    serverP->nextMid = 1;
+    serverP->nextToken = 1;
+    serverP->random = 0x12345678;
+    serverP->phase = PHASE_REGISTRATION;
+
+    if (pthread_create(&serverP->thread, NULL, prv_serverThread, serverP) != 0)
+    {
+        close(serverP->sock);
+        free(serverP->queueArray);
+        return -1;
+    }
+
+    return 0;
+}
+
+static void prv_serverClose(prv_server_t *serverP)
+{
+    __atomic_store_n(&serverP->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(serverP->thread, NULL);
+
+    close(serverP->sock);
+    free(serverP->queueArray);
+}
+
+/*************************************************************************************
+** LwM2M Client
+*************************************************************************************/
+
+// The Streamable Resource /10240/0/0 is read from the expected content and written into g_writtenBuffer.
+static iowa_status_t prv_objectCallback(iowa_dm_operation_t operation,
+                                        iowa_lwm2m_data_t *dataP,
+                                        size_t numData,
+                                        void *userData,
+                                        iowa_context_t contextP)
+{
+    size_t i;
+    uint32_t number;
+    bool more;
+    uint16_t size;
+    size_t offset;
+
+    (void)userData;
+    (void)contextP;
+
+    for (i = 0; i < numData; i++)
+    {
+        if (dataP[i].type != IOWA_LWM2M_TYPE_OPAQUE_BLOCK
+            || iowa_data_get_block_info(dataP + i, &number, &more, &size) != IOWA_COAP_NO_ERROR)
+        {
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+        offset = (size_t)number * size;
+
+        switch (operation)
+        {
+        case IOWA_DM_READ:
+            if (offset >= g_contentSize)
+            {
+                return IOWA_COAP_402_BAD_OPTION;
+            }
+            more = offset + size < g_contentSize;
+            dataP[i].value.asBlock.buffer = g_writtenBuffer + g_contentSize + offset;
+            dataP[i].value.asBlock.totalSize = more == true ? size : g_contentSize - offset;
+            iowa_data_set_block_info(dataP + i, number, more, size);
+            break;
+
+        case IOWA_DM_WRITE:
+            if (offset + dataP[i].value.asBlock.totalSize > g_contentSize)
+            {
+                return IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+            }
+            memcpy(g_writtenBuffer + offset, dataP[i].value.asBlock.buffer, dataP[i].value.asBlock.totalSize);
+            g_writtenLength = offset + dataP[i].value.asBlock.totalSize;
+            break;
+
+        default:
+            return IOWA_COAP_405_METHOD_NOT_ALLOWED;
+        }
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+static int prv_run(prv_server_t *serverP)
+{
+    iowa_context_t iowaH;
+    iowa_device_info_t devInfo;
+    iowa_lwm2m_resource_desc_t resource;
+    uint16_t *instanceIdArray;
+    uint16_t instanceCount;
+    char serverUri[64];
+    int64_t startTime;
+    iowa_status_t result;
+    uint16_t i;
+
+    if (prv_serverOpen(serverP) != 0)
+    {
+        fprintf(stderr, "Stand-in server creation failed.\r\n");
+        return -1;
+    }
+    snprintf(serverUri, sizeof(serverUri), "coap://127.0.0.1:%u", serverP->port);
+
+    // Each instance adds about 13 bytes to the registration payload
+    instanceCount = (uint16_t)(serverP->size / 13);
+    instanceIdArray = (uint16_t *)malloc(instanceCount * sizeof(uint16_t));
+    if (instanceIdArray == NULL)
+    {
+        prv_serverClose(serverP);
+        return -1;
+    }
+    for (i = 0; i < instanceCount; i++)
+    {
+        instanceIdArray[i] = i;
+    }
+
+    resource.id = 0;
+    resource.type = IOWA_LWM2M_TYPE_OPAQUE;
+    resource.operations = IOWA_OPERATION_READ | IOWA_OPERATION_WRITE;
+    resource.flags = IOWA_RESOURCE_FLAG_MANDATORY | IOWA_RESOURCE_FLAG_STREAMABLE;
+
+    memset(g_writtenBuffer, 0, g_contentSize);
+    g_writtenLength = 0;
+
+    iowaH = iowa_init(NULL);
+    if (iowaH == NULL)
+    {
+        fprintf(stderr, "IOWA context initialization failed.\r\n");
+        free(instanceIdArray);
+        prv_serverClose(serverP);
+        return -1;
+    }
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    result = iowa_client_configure(iowaH, "qblock_latency", &devInfo, NULL);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = iowa_client_add_custom_object(iowaH, OBJECT_ID, instanceCount, instanceIdArray, 1, &resource, prv_objectCallback, NULL, NULL, NULL);
+    }
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = iowa_client_add_server(iowaH, SERVER_SHORT_ID, serverUri, SERVER_LIFETIME, 0, IOWA_SEC_NONE);
+    }
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "IOWA Client configuration failed (%u.%02u).\r\n", (result & 0xFF) >> 5, (result & 0x1F));
+        iowa_close(iowaH);
+        free(instanceIdArray);
+        prv_serverClose(serverP);
+        return -1;
+    }
+
+    startTime = bench_now();
+    while (__atomic_load_n(&serverP->phase, __ATOMIC_ACQUIRE) < PHASE_DONE
+           && bench_now() - startTime < (int64_t)MAX_RUN_TIME * 1000000)
+    {
+        (void)iowa_step(iowaH, 1);
+    }
+
+    iowa_client_remove_server(iowaH, SERVER_SHORT_ID);
+    iowa_close(iowaH);
+    free(instanceIdArray);
+
+    prv_serverClose(serverP);
+
+    if (serverP->phase != PHASE_DONE)
+    {
+        return -1;
+    }
+    if (g_writtenLength != g_contentSize
+        || memcmp(g_writtenBuffer, g_writtenBuffer + g_contentSize, g_contentSize) != 0)
+    {
+        fprintf(stderr, "Written content mismatch.\r\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    int size;
+    int loss;
+    int rttArray[MAX_RTT_COUNT];
+    int rttCount;
+    prv_server_t server;
+    int result;
+    int i;
+
+    size = DEFAULT_SIZE;
+    loss = DEFAULT_LOSS;
+    rttCount = 0;
+    if (argc > 1)
+    {
+        size = atoi(argv[1]);
+    }
+    if (argc > 2)
+    {
+        loss = atoi(argv[2]);
+    }
+    for (i = 3; i < argc && rttCount < MAX_RTT_COUNT; i++)
+    {
+        rttArray[rttCount++] = atoi(argv[i]);
+    }
+    if (rttCount == 0)
+    {
+        rttArray[0] = 20;
+        rttArray[1] = 100;
+        rttArray[2] = 200;
+        rttCount = 3;
+    }
+    result = 0;
+    for (i = 0; i < rttCount; i++)
+    {
+        if (rttArray[i] < 0)
+        {
+            result = 1;
+        }
+    }
+    if (size <= 0
+        || size > PRV_MAX_BLOCKS * PRV_BLOCK_SIZE
+        || loss < 0
+        || loss >= 100
+        || result != 0)
+    {
+        fprintf(stderr, "Usage: %s [size in bytes (1-%d)] [loss in percent] [RTT in milliseconds]...\r\n", argv[0], PRV_MAX_BLOCKS * PRV_BLOCK_SIZE);
+        return 1;
+    }
+
+    // The written content, followed by the expected one
+    g_contentSize = (size_t)size;
+    g_writtenBuffer = (uint8_t *)malloc(2 * g_contentSize);
+    if (g_writtenBuffer == NULL)
+    {
+        return 1;
+    }
+    for (i = 0; i < size; i++)
+    {
+        g_writtenBuffer[size + i] = prv_pattern((size_t)i);
+    }
+
+    printf("Transfers:      %s\r\n", TRANSFER_MODE);
+    printf("Content:        %d bytes in blocks of %d bytes\r\n", size, PRV_BLOCK_SIZE);
+    printf("Loss:           %d %%\r\n", loss);
+    printf("  RTT (ms)   Registration (s)   Write (s)   Read (s)   Retransmissions\r\n");
+
+    for (i = 0; i < rttCount; i++)
+    {
+        memset(&server, 0, sizeof(server));
+        server.rtt = (int64_t)rttArray[i] * 1000;
+        server.loss = (uint32_t)loss;
+        server.size = (size_t)size;
+
+        if (prv_run(&server) != 0)
+        {
+            printf("%10d   failed\r\n", rttArray[i]);
+            result = 1;
+            continue;
+        }
+
+        printf("%10d   %16.2f   %9.2f   %8.2f   %15u\r\n", rttArray[i], server.durationArray[PHASE_REGISTRATION], server.durationArray[PHASE_WRITE], server.durationArray[PHASE_READ], server.retransmissionCount);
+    }
+
+    printf("Registration:   %zu bytes\r\n", server.registrationLength);
+
+    free(g_writtenBuffer);
+
+    return result;
+}
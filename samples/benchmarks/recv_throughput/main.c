@@ -0,0 +1,133 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark measures the number of requests
+ * an LwM2M Client handles per second over
+ * loopback UDP. A stand-in LwM2M Server keeps a
+ * window of Read requests in flight.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_ipso.h"
+
+#include "bench_server.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SERVER_SHORT_ID 1234
+#define SERVER_LIFETIME 300
+
+#define DEFAULT_READ_WINDOW 64
+#define DEFAULT_DURATION    5
+
+#ifdef IOWA_CONNECTION_RECVV_SUPPORT
+#define RECEIVE_MODE "iowa_system_connection_recvv()"
+#else
+#define RECEIVE_MODE "iowa_system_connection_recv()"
+#endif
+
+int main(int argc,
+         char *argv[])
+{
+    iowa_context_t iowaH;
+    iowa_device_info_t devInfo;
+    iowa_sensor_t sensorId;
+    bench_server_t server;
+    int readWindow;
+    int duration;
+    char serverUri[64];
+    uint32_t startCount;
+    uint32_t readCount;
+    int64_t startTime;
+    double elapsed;
+    iowa_status_t result;
+
+    readWindow = DEFAULT_READ_WINDOW;
+    duration = DEFAULT_DURATION;
+    if (argc > 1)
+    {
+        readWindow = atoi(argv[1]);
+    }
+    if (argc > 2)
+    {
+        duration = atoi(argv[2]);
+    }
+    if (readWindow <= 0
+        || duration <= 0)
+    {
+        fprintf(stderr, "Usage: %s [Read requests in flight] [duration in seconds]\r\n", argv[0]);
+        return 1;
+    }
+
+    memset(&server, 0, sizeof(server));
+    server.readWindow = (uint32_t)readWindow;
+    if (bench_server_open(&server) != 0
+        || bench_server_start(&server) != 0)
+    {
+        fprintf(stderr, "Stand-in server creation failed.\r\n");
+        return 1;
+    }
+    snprintf(serverUri, sizeof(serverUri), "coap://127.0.0.1:%u", server.port);
+
+    iowaH = iowa_init(NULL);
+    if (iowaH == NULL)
+    {
+        fprintf(stderr, "IOWA context initialization failed.\r\n");
+        return 1;
+    }
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    result = iowa_client_configure(iowaH, "recv_throughput", &devInfo, NULL);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = iowa_client_IPSO_add_sensor(iowaH, IOWA_IPSO_TEMPERATURE, 20.0f, "Cel", NULL, -20.0f, 50.0f, &sensorId);
+    }
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = iowa_client_add_server(iowaH, SERVER_SHORT_ID, serverUri, SERVER_LIFETIME, 0, IOWA_SEC_NONE);
+    }
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "IOWA Client configuration failed (%u.%02u).\r\n", (result & 0xFF) >> 5, (result & 0x1F));
+        iowa_close(iowaH);
+        return 1;
+    }
+
+    // Register and let the server fill its window of Read requests
+    (void)iowa_step(iowaH, 1);
+
+    startCount = __atomic_load_n(&server.readCount, __ATOMIC_ACQUIRE);
+    startTime = bench_now();
+    (void)iowa_step(iowaH, duration);
+    elapsed = (double)(bench_now() - startTime) / 1000000.0;
+    readCount = __atomic_load_n(&server.readCount, __ATOMIC_ACQUIRE) - startCount;
+
+    iowa_client_remove_server(iowaH, SERVER_SHORT_ID);
+    iowa_client_IPSO_remove_sensor(iowaH, sensorId);
+    iowa_close(iowaH);
+
+    bench_server_stop(&server);
+
+    printf("Receive:        %s\r\n", RECEIVE_MODE);
+    printf("Read window:    %d\r\n", readWindow);
+    printf("Duration:       %.1f s\r\n", elapsed);
+    printf("Reads:          %u (%.0f /s)\r\n", readCount, (double)readCount / elapsed);
+
+    return readCount > 0 ? 0 : 1;
+}
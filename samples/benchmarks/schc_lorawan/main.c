@@ -0,0 +1,853 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark measures the size of the frames
+ * of an LwM2M Client on a LoRaWAN link, with and
+ * without the SCHC compression. The connection
+ * functions stand in for the radio and for the
+ * network end of the SCHC context, which uses the
+ * same static rules as the Client.
+ * It checks that the notifications fit in the
+ * 11-byte frames of the slowest data rate, that
+ * the blocks follow the data rate, and that the
+ * Object list sent in an Update is only used once
+ * the Update is acknowledged.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_ipso.h"
+#include "iowa_prv_coap_internals.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SERVER_SHORT_ID 1234
+#define SERVER_LIFETIME 86400
+#define SERVER_URI      "lorawan://2"
+
+#define DEFAULT_NOTIFICATION_COUNT 100
+
+// Largest application payloads of LoRaWAN regional parameters
+#define FRAME_SIZE_SLOWEST 11  // DR0 of US915
+#define FRAME_SIZE_SLOW    51  // DR0 of EU868
+#define FRAME_SIZE_FASTEST 242 // DR5 of EU868
+
+#define DOWNLINK_QUEUE_SIZE 8
+#define MAX_OBJECT_COUNT    16
+#define MAX_STEP_COUNT      64
+
+#define TEMPERATURE_PATH "3303/0/5700"
+#define GENERIC_PATH     "3300/0/5700"
+#define DEVICE_PATH      "3/0"
+
+#define GENERIC_VALUE 1234.0f
+
+#define ACCEPT_NONE 0xFFFF
+
+typedef enum
+{
+    KIND_REGISTER = 0,
+    KIND_UPDATE,
+    KIND_DEREGISTER,
+    KIND_OBSERVE_RESPONSE,
+    KIND_NOTIFICATION,
+    KIND_READ_RESPONSE,
+    KIND_BLOCK_RESPONSE,
+    KIND_OTHER_UPLINK,
+    KIND_REGISTER_ACK,
+    KIND_UPDATE_ACK,
+    KIND_OBSERVE_REQUEST,
+    KIND_READ_REQUEST,
+    KIND_BLOCK_REQUEST,
+    KIND_COUNT
+} message_kind_t;
+
+static const char *g_kindName[KIND_COUNT] =
+{
+    "Register",
+    "Update",
+    "Deregister",
+    "Observe response",
+    "Notification",
+    "Read response",
+    "Read response block",
+    "Other",
+    "Register ACK",
+    "Update ACK",
+    "Observe request",
+    "Read request",
+    "Read block request"
+};
+
+typedef struct
+{
+    uint32_t count;
+    size_t   coapSize; // largest, uncompressed
+    size_t   schcSize; // largest, compressed
+} kind_stat_t;
+
+typedef struct
+{
+    iowa_context_t       iowaH;
+    uint8_t              frameSize;     // at the current data rate
+    uint32_t             oversizedCount;
+    coap_peer_datagram_t gateway;       // network end of the SCHC context
+    uint16_t             objectArray[MAX_OBJECT_COUNT];
+    uint16_t             pendingArray[MAX_OBJECT_COUNT];
+    uint16_t             pendingCount;
+    uint8_t              downlinkArray[DOWNLINK_QUEUE_SIZE][COAP_LORAWAN_MAX_FRAME_SIZE + 1];
+    size_t               downlinkLength[DOWNLINK_QUEUE_SIZE];
+    size_t               downlinkHead;
+    size_t               downlinkCount;
+    uint16_t             nextMID;
+    uint8_t              nextToken;
+    bool                 holdUpdate;    // the acknowledgement of the next Update is delayed
+    iowa_coap_message_t *heldUpdateP;
+    uint8_t             *heldUpdateBuffer;
+    bool                 registered;
+    uint32_t             responseCount;
+    uint8_t              lastCode;
+    char                 lastPayload[64];
+    uint32_t             notificationCount;
+    uint32_t             shortMIDCount; // notifications with a Message ID sent on 4 bits
+    size_t               notificationSize;
+    const char          *readPath;      // path of the block-wise Read in progress
+    uint32_t             blockCount;
+    uint16_t             blockSize;
+    size_t               readFrameSize; // largest frame of the Read in progress
+    bool                 readDone;
+    kind_stat_t          stat[KIND_COUNT];
+} network_t;
+
+static network_t g_network;
+
+static void prv_recordStat(message_kind_t kind,
+                           size_t coapSize,
+                           size_t schcSize)
+{
+    g_network.stat[kind].count++;
+    if (coapSize > g_network.stat[kind].coapSize)
+    {
+        g_network.stat[kind].coapSize = coapSize;
+    }
+    if (schcSize > g_network.stat[kind].schcSize)
+    {
+        g_network.stat[kind].schcSize = schcSize;
+    }
+}
+
+static size_t prv_coapSize(iowa_coap_message_t *messageP)
+{
+    uint8_t *buffer;
+    size_t length;
+
+    length = coapMessageSerializeDatagram(messageP, &buffer);
+    if (length != 0)
+    {
+        iowa_system_free(buffer);
+    }
+
+    return length;
+}
+
+// The Server learns the Object list from the link-format payload of the Register and of the Update.
+static uint16_t prv_parseObjectList(iowa_coap_message_t *messageP,
+                                    uint16_t *idArray)
+{
+    uint16_t count;
+    size_t i;
+
+    count = 0;
+    i = 0;
+    while (i + 2 < messageP->payload.length)
+    {
+        if (messageP->payload.data[i] == '<'
+            && messageP->payload.data[i + 1] == '/')
+        {
+            uint32_t id;
+            uint16_t j;
+
+            i += 2;
+            id = 0;
+            while (i < messageP->payload.length
+                   && messageP->payload.data[i] >= '0'
+                   && messageP->payload.data[i] <= '9')
+            {
+                id = id * 10 + (uint32_t)(messageP->payload.data[i] - '0');
+                i++;
+            }
+
+            // Sorted insertion without duplicates, like the Object list of the Client
+            for (j = 0; j < count && idArray[j] < id; j++);
+            if ((j == count || idArray[j] != id)
+                && count < MAX_OBJECT_COUNT)
+            {
+                memmove(idArray + j + 1, idArray + j, (count - j) * sizeof(uint16_t));
+                idArray[j] = (uint16_t)id;
+                count++;
+            }
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return count;
+}
+
+static void prv_downlink(iowa_coap_message_t *messageP,
+                         message_kind_t kind)
+{
+    uint8_t *buffer;
+    size_t length;
+    size_t index;
+
+    length = schcCompress(&g_network.gateway, messageP, &buffer);
+    if (length == 0)
+    {
+        fprintf(stderr, "Downlink compression failed.\r\n");
+        iowa_coap_message_free(messageP);
+        return;
+    }
+
+    prv_recordStat(kind, prv_coapSize(messageP), length);
+
+    if (g_network.downlinkCount < DOWNLINK_QUEUE_SIZE
+        && length <= COAP_LORAWAN_MAX_FRAME_SIZE)
+    {
+        index = (g_network.downlinkHead + g_network.downlinkCount) % DOWNLINK_QUEUE_SIZE;
+        memcpy(g_network.downlinkArray[index], buffer, length);
+        g_network.downlinkLength[index] = length;
+        g_network.downlinkCount++;
+    }
+    else
+    {
+        fprintf(stderr, "Downlink dropped.\r\n");
+    }
+
+    iowa_system_free(buffer);
+    iowa_coap_message_free(messageP);
+}
+
+static void prv_sendRequest(const char *path,
+                            bool observe,
+                            uint16_t accept,
+                            uint32_t block2,
+                            message_kind_t kind)
+{
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+    uint8_t token;
+
+    // Short tokens and Message IDs, sent on 4 bits
+    token = g_network.nextToken & COAP_LORAWAN_TOKEN_MASK;
+    g_network.nextToken++;
+
+    messageP = iowa_coap_message_new(g_network.iowaH, IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_GET, 1, &token);
+    if (messageP == NULL)
+    {
+        return;
+    }
+    messageP->id = (uint16_t)(COAP_FIRST_MID + g_network.nextMID % COAP_LORAWAN_SHORT_MID_MAX);
+    g_network.nextMID++;
+
+    if (observe == true)
+    {
+        optionP = iowa_coap_option_new(g_network.iowaH, IOWA_COAP_OPTION_OBSERVE);
+        if (optionP != NULL)
+        {
+            optionP->value.asInteger = IOWA_COAP_OBSERVE_REQUEST_NEW;
+            iowa_coap_message_add_option(messageP, optionP);
+        }
+    }
+    optionP = iowa_coap_path_to_option(g_network.iowaH, IOWA_COAP_OPTION_URI_PATH, path, '/');
+    if (optionP != NULL)
+    {
+        iowa_coap_message_add_option(messageP, optionP);
+    }
+    if (accept != ACCEPT_NONE)
+    {
+        optionP = iowa_coap_option_new(g_network.iowaH, IOWA_COAP_OPTION_ACCEPT);
+        if (optionP != NULL)
+        {
+            optionP->value.asInteger = accept;
+            iowa_coap_message_add_option(messageP, optionP);
+        }
+    }
+    if (block2 != 0)
+    {
+        optionP = iowa_coap_option_new(g_network.iowaH, IOWA_COAP_OPTION_BLOCK_2);
+        if (optionP != NULL)
+        {
+            optionP->value.asInteger = block2;
+            iowa_coap_message_add_option(messageP, optionP);
+        }
+    }
+
+    prv_downlink(messageP, kind);
+}
+
+static void prv_acknowledge(iowa_coap_message_t *requestP,
+                            uint8_t code,
+                            message_kind_t kind)
+{
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+
+    messageP = iowa_coap_message_prepare_response(g_network.iowaH, requestP, code);
+    if (messageP == NULL)
+    {
+        return;
+    }
+    if (code == IOWA_COAP_201_CREATED)
+    {
+        optionP = iowa_coap_path_to_option(g_network.iowaH, IOWA_COAP_OPTION_LOCATION_PATH, "rd/a1", '/');
+        if (optionP != NULL)
+        {
+            iowa_coap_message_add_option(messageP, optionP);
+        }
+    }
+
+    prv_downlink(messageP, kind);
+}
+
+static void prv_acknowledgeHeldUpdate(void)
+{
+    prv_acknowledge(g_network.heldUpdateP, IOWA_COAP_204_CHANGED, KIND_UPDATE_ACK);
+    iowa_coap_message_free(g_network.heldUpdateP);
+    free(g_network.heldUpdateBuffer);
+    g_network.heldUpdateP = NULL;
+    g_network.heldUpdateBuffer = NULL;
+
+    // Both ends now use the Object list of the Update
+    memcpy(g_network.objectArray, g_network.pendingArray, g_network.pendingCount * sizeof(uint16_t));
+    g_network.gateway.schcObjectCount = g_network.pendingCount;
+}
+
+static void prv_handleResponse(iowa_coap_message_t *messageP,
+                               size_t coapSize,
+                               size_t schcSize)
+{
+    iowa_coap_option_t *optionP;
+    size_t length;
+
+    optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_2);
+    if (optionP != NULL)
+    {
+        uint32_t block2;
+
+        block2 = optionP->value.asInteger;
+        prv_recordStat(KIND_BLOCK_RESPONSE, coapSize, schcSize);
+        g_network.blockCount++;
+        g_network.blockSize = (uint16_t)(16 << (block2 & 0x07));
+        if (schcSize > g_network.readFrameSize)
+        {
+            g_network.readFrameSize = schcSize;
+        }
+        if ((block2 & 0x08) != 0)
+        {
+            // Ask for the next block with the same size
+            prv_sendRequest(g_network.readPath, false, ACCEPT_NONE, (((block2 >> 4) + 1) << 4) | (block2 & 0x07), KIND_BLOCK_REQUEST);
+            return;
+        }
+        g_network.readDone = true;
+    }
+    else if (messageP->type != IOWA_COAP_TYPE_ACKNOWLEDGEMENT
+             && iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_OBSERVE) != NULL)
+    {
+        prv_recordStat(KIND_NOTIFICATION, coapSize, schcSize);
+        g_network.notificationCount++;
+        if (messageP->id <= COAP_LORAWAN_SHORT_MID_MAX)
+        {
+            g_network.shortMIDCount++;
+        }
+        if (schcSize > g_network.notificationSize)
+        {
+            g_network.notificationSize = schcSize;
+        }
+    }
+    else if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_OBSERVE) != NULL)
+    {
+        prv_recordStat(KIND_OBSERVE_RESPONSE, coapSize, schcSize);
+    }
+    else if (messageP->code == IOWA_COAP_205_CONTENT)
+    {
+        prv_recordStat(KIND_READ_RESPONSE, coapSize, schcSize);
+        if (schcSize > g_network.readFrameSize)
+        {
+            g_network.readFrameSize = schcSize;
+        }
+        g_network.readDone = true;
+    }
+    else
+    {
+        prv_recordStat(KIND_OTHER_UPLINK, coapSize, schcSize);
+    }
+
+    g_network.responseCount++;
+    g_network.lastCode = messageP->code;
+    length = messageP->payload.length;
+    if (length >= sizeof(g_network.lastPayload))
+    {
+        length = sizeof(g_network.lastPayload) - 1;
+    }
+    if (length > 0)
+    {
+        memcpy(g_network.lastPayload, messageP->payload.data, length);
+    }
+    g_network.lastPayload[length] = 0;
+}
+
+// The stand-in Server handles the uplinks.
+static void prv_uplink(uint8_t *frame,
+                       size_t length)
+{
+    iowa_coap_message_t *messageP;
+    uint8_t *buffer;
+    size_t coapSize;
+
+    // The decompressed message points to the frame
+    buffer = (uint8_t *)malloc(length);
+    if (buffer == NULL)
+    {
+        return;
+    }
+    memcpy(buffer, frame, length);
+
+    if (schcDecompress(g_network.iowaH, &g_network.gateway, buffer, length, &messageP) != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "Uplink decompression failed.\r\n");
+        free(buffer);
+        return;
+    }
+    coapSize = prv_coapSize(messageP);
+
+    if (messageP->code == IOWA_COAP_CODE_POST)
+    {
+        if (g_network.registered == false)
+        {
+            prv_recordStat(KIND_REGISTER, coapSize, length);
+            g_network.gateway.schcObjectCount = prv_parseObjectList(messageP, g_network.objectArray);
+            prv_acknowledge(messageP, IOWA_COAP_201_CREATED, KIND_REGISTER_ACK);
+            g_network.registered = true;
+        }
+        else
+        {
+            prv_recordStat(KIND_UPDATE, coapSize, length);
+            g_network.pendingCount = g_network.gateway.schcObjectCount;
+            if (messageP->payload.length > 0)
+            {
+                g_network.pendingCount = prv_parseObjectList(messageP, g_network.pendingArray);
+            }
+            else
+            {
+                memcpy(g_network.pendingArray, g_network.objectArray, g_network.pendingCount * sizeof(uint16_t));
+            }
+            if (g_network.holdUpdate == true)
+            {
+                // Acknowledged later, the message and its frame are kept until then
+                g_network.holdUpdate = false;
+                g_network.heldUpdateP = messageP;
+                g_network.heldUpdateBuffer = buffer;
+                return;
+            }
+            g_network.heldUpdateP = messageP;
+            g_network.heldUpdateBuffer = buffer;
+            prv_acknowledgeHeldUpdate();
+            return;
+        }
+    }
+    else if (messageP->code == IOWA_COAP_CODE_DELETE)
+    {
+        prv_recordStat(KIND_DEREGISTER, coapSize, length);
+    }
+    else
+    {
+        prv_handleResponse(messageP, coapSize, length);
+    }
+
+    iowa_coap_message_free(messageP);
+    free(buffer);
+}
+
+/*************************************************
+ * The LoRaWAN radio, with the connection functions
+ */
+
+void *iowa_system_connection_open(iowa_connection_type_t type,
+                                  char *hostname,
+                                  char *port,
+                                  void *userData)
+{
+    (void)hostname;
+    (void)port;
+    (void)userData;
+
+    if (type != IOWA_CONN_LORAWAN)
+    {
+        return NULL;
+    }
+
+    return &g_network;
+}
+
+int iowa_system_connection_send(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    (void)connP;
+    (void)userData;
+
+    if (length > g_network.frameSize)
+    {
+        // The LoRaWAN stack rejects the frames larger than the data rate allows
+        g_network.oversizedCount++;
+        return -1;
+    }
+
+    prv_uplink(buffer, length);
+
+    return (int)length;
+}
+
+int iowa_system_connection_recv(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    size_t frameLength;
+
+    (void)connP;
+    (void)userData;
+
+    if (g_network.downlinkCount == 0)
+    {
+        return 0;
+    }
+
+    frameLength = g_network.downlinkLength[g_network.downlinkHead];
+    if (frameLength > length)
+    {
+        frameLength = length;
+    }
+    memcpy(buffer, g_network.downlinkArray[g_network.downlinkHead], frameLength);
+    g_network.downlinkHead = (g_network.downlinkHead + 1) % DOWNLINK_QUEUE_SIZE;
+    g_network.downlinkCount--;
+
+    return (int)frameLength;
+}
+
+int iowa_system_connection_select(void **connArray,
+                                  size_t connCount,
+                                  int32_t timeout,
+                                  void *userData)
+{
+    size_t i;
+
+    (void)timeout;
+    (void)userData;
+
+    // The downlinks are queued by the stand-in Server in the same thread
+    for (i = 0; i < connCount; i++)
+    {
+        if (g_network.downlinkCount == 0)
+        {
+            connArray[i] = NULL;
+        }
+    }
+
+    return g_network.downlinkCount > 0 ? 1 : 0;
+}
+
+void iowa_system_connection_close(void *connP,
+                                  void *userData)
+{
+    (void)connP;
+    (void)userData;
+}
+
+size_t iowa_system_connection_get_peer_identifier(void *connP,
+                                                  uint8_t *addrP,
+                                                  size_t length,
+                                                  void *userData)
+{
+    (void)connP;
+    (void)addrP;
+    (void)length;
+    (void)userData;
+
+    return 0;
+}
+
+void iowa_system_connection_interrupt_select(void *userData)
+{
+    (void)userData;
+}
+
+/*************************************************
+ * The benchmark
+ */
+
+// The application reports the data rate chosen by the LoRaWAN stack.
+static iowa_status_t prv_setDataRate(uint8_t frameSize)
+{
+    g_network.frameSize = frameSize;
+
+    return iowa_coap_peer_configuration_set(g_network.iowaH,
+                                            iowa_client_get_server_coap_peer(g_network.iowaH, SERVER_SHORT_ID),
+                                            IOWA_COAP_SETTING_FRAME_SIZE,
+                                            &frameSize);
+}
+
+static bool prv_stepUntil(bool *doneP)
+{
+    int i;
+
+    for (i = 0; i < MAX_STEP_COUNT && *doneP == false; i++)
+    {
+        (void)iowa_step(g_network.iowaH, 0);
+    }
+
+    return *doneP;
+}
+
+static bool prv_stepUntilResponse(uint32_t count)
+{
+    int i;
+
+    for (i = 0; i < MAX_STEP_COUNT && g_network.responseCount < count; i++)
+    {
+        (void)iowa_step(g_network.iowaH, 0);
+    }
+
+    return g_network.responseCount >= count;
+}
+
+static bool prv_readDevice(uint8_t frameSize,
+                           uint32_t *blockCountP,
+                           uint16_t *blockSizeP,
+                           size_t *frameSizeP)
+{
+    if (prv_setDataRate(frameSize) != IOWA_COAP_NO_ERROR)
+    {
+        return false;
+    }
+
+    g_network.readPath = DEVICE_PATH;
+    g_network.readDone = false;
+    g_network.blockCount = 0;
+    g_network.blockSize = 0;
+    g_network.readFrameSize = 0;
+    prv_sendRequest(DEVICE_PATH, false, ACCEPT_NONE, 0, KIND_READ_REQUEST);
+    if (prv_stepUntil(&g_network.readDone) == false)
+    {
+        return false;
+    }
+
+    *blockCountP = g_network.blockCount;
+    *blockSizeP = g_network.blockSize;
+    *frameSizeP = g_network.readFrameSize;
+
+    return g_network.lastCode == IOWA_COAP_205_CONTENT;
+}
+
+static void prv_printRead(uint8_t frameSize,
+                          uint32_t blockCount,
+                          uint16_t blockSize,
+                          size_t largestSize)
+{
+    if (blockCount == 0)
+    {
+        printf("Read /%s:       one response in frames of %u bytes, %u bytes\r\n", DEVICE_PATH, frameSize, (unsigned int)largestSize);
+    }
+    else
+    {
+        printf("Read /%s:       %u blocks of %u bytes in frames of %u bytes, largest %u bytes\r\n", DEVICE_PATH, blockCount, blockSize, frameSize, (unsigned int)largestSize);
+    }
+}
+
+int main(int argc,
+         char *argv[])
+{
+    iowa_device_info_t devInfo;
+    iowa_sensor_t temperatureId;
+    iowa_sensor_t genericId;
+    int notificationTarget;
+    int i;
+    uint32_t slowBlockCount;
+    uint16_t slowBlockSize;
+    size_t slowFrameSize;
+    uint32_t fastBlockCount;
+    uint16_t fastBlockSize;
+    size_t fastFrameSize;
+    bool deviceRead;
+    bool previousListRead;
+    bool newListRead;
+    iowa_status_t result;
+
+    notificationTarget = DEFAULT_NOTIFICATION_COUNT;
+    if (argc > 1)
+    {
+        notificationTarget = atoi(argv[1]);
+    }
+    if (notificationTarget <= 0)
+    {
+        fprintf(stderr, "Usage: %s [notification count]\r\n", argv[0]);
+        return 1;
+    }
+
+    memset(&g_network, 0, sizeof(g_network));
+    g_network.frameSize = FRAME_SIZE_FASTEST;
+    g_network.gateway.base.type = IOWA_CONN_LORAWAN;
+    g_network.gateway.schcIsDevice = false;
+    g_network.gateway.schcObjectArray = g_network.objectArray;
+
+    g_network.iowaH = iowa_init(NULL);
+    if (g_network.iowaH == NULL)
+    {
+        fprintf(stderr, "IOWA context initialization failed.\r\n");
+        return 1;
+    }
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    devInfo.manufacturer = "IOTEROP";
+    devInfo.deviceType = "Temperature sensor";
+    devInfo.modelNumber = "SCHC-1";
+    devInfo.serialNumber = "0123456789";
+    devInfo.hardwareVersion = "1.0";
+    devInfo.firmwareVersion = "1.0";
+    devInfo.softwareVersion = "1.0";
+    result = iowa_client_configure(g_network.iowaH, "schc_lorawan", &devInfo, NULL);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = iowa_client_IPSO_add_sensor(g_network.iowaH, IOWA_IPSO_TEMPERATURE, 20.0f, "Cel", NULL, -20.0f, 50.0f, &temperatureId);
+    }
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = iowa_client_add_server(g_network.iowaH, SERVER_SHORT_ID, SERVER_URI, SERVER_LIFETIME, 0, IOWA_SEC_NONE);
+    }
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "IOWA Client configuration failed (%u.%02u).\r\n", (result & 0xFF) >> 5, (result & 0x1F));
+        iowa_close(g_network.iowaH);
+        return 1;
+    }
+
+    // Registration at the fastest data rate, the only one where the Register fits
+    if (prv_stepUntil(&g_network.registered) == false)
+    {
+        fprintf(stderr, "Registration failed.\r\n");
+        iowa_close(g_network.iowaH);
+        return 1;
+    }
+
+    // Notifications at the slowest data rate
+    result = prv_setDataRate(FRAME_SIZE_SLOWEST);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        prv_sendRequest(TEMPERATURE_PATH, true, IOWA_CONTENT_FORMAT_TEXT, 0, KIND_OBSERVE_REQUEST);
+        if (prv_stepUntilResponse(g_network.responseCount + 1) == false
+            || g_network.lastCode != IOWA_COAP_205_CONTENT)
+        {
+            result = IOWA_COAP_404_NOT_FOUND;
+        }
+    }
+    for (i = 0; i < notificationTarget && result == IOWA_COAP_NO_ERROR; i++)
+    {
+        uint32_t count;
+        int j;
+
+        count = g_network.notificationCount;
+        result = iowa_client_IPSO_update_value(g_network.iowaH, temperatureId, 20.0f + (float)(i % 20) / 2.0f);
+        for (j = 0; j < MAX_STEP_COUNT && g_network.notificationCount == count && result == IOWA_COAP_NO_ERROR; j++)
+        {
+            (void)iowa_step(g_network.iowaH, 0);
+        }
+    }
+
+    // Block-wise Read at two data rates
+    deviceRead = prv_readDevice(FRAME_SIZE_SLOW, &slowBlockCount, &slowBlockSize, &slowFrameSize)
+                 && prv_readDevice(FRAME_SIZE_FASTEST, &fastBlockCount, &fastBlockSize, &fastFrameSize);
+
+    // A new Object changes the indexes of the Object IDs. Until the Server acknowledges the Update, both ends keep the previous list.
+    previousListRead = false;
+    newListRead = false;
+    g_network.holdUpdate = true;
+    if (iowa_client_IPSO_update_value(g_network.iowaH, temperatureId, 21.5f) == IOWA_COAP_NO_ERROR
+        && iowa_client_IPSO_add_sensor(g_network.iowaH, IOWA_IPSO_GENERIC, GENERIC_VALUE, NULL, NULL, 0.0f, 0.0f, &genericId) == IOWA_COAP_NO_ERROR)
+    {
+        for (i = 0; i < MAX_STEP_COUNT && g_network.heldUpdateP == NULL; i++)
+        {
+            (void)iowa_step(g_network.iowaH, 0);
+        }
+        if (g_network.heldUpdateP != NULL)
+        {
+            prv_sendRequest(TEMPERATURE_PATH, false, IOWA_CONTENT_FORMAT_TEXT, 0, KIND_READ_REQUEST);
+            previousListRead = prv_stepUntilResponse(g_network.responseCount + 1)
+                               && g_network.lastCode == IOWA_COAP_205_CONTENT
+                               && strtof(g_network.lastPayload, NULL) == 21.5f;
+
+            prv_acknowledgeHeldUpdate();
+            prv_sendRequest(GENERIC_PATH, false, IOWA_CONTENT_FORMAT_TEXT, 0, KIND_READ_REQUEST);
+            newListRead = prv_stepUntilResponse(g_network.responseCount + 1)
+                          && g_network.lastCode == IOWA_COAP_205_CONTENT
+                          && strtof(g_network.lastPayload, NULL) == GENERIC_VALUE;
+        }
+        iowa_client_IPSO_remove_sensor(g_network.iowaH, genericId);
+    }
+
+    iowa_client_remove_server(g_network.iowaH, SERVER_SHORT_ID);
+    iowa_client_IPSO_remove_sensor(g_network.iowaH, temperatureId);
+    iowa_close(g_network.iowaH);
+    if (g_network.heldUpdateP != NULL)
+    {
+        iowa_coap_message_free(g_network.heldUpdateP);
+        free(g_network.heldUpdateBuffer);
+    }
+
+    printf("Message                 Count   CoAP (bytes)   SCHC (bytes)\r\n");
+    for (i = 0; i < KIND_COUNT; i++)
+    {
+        if (g_network.stat[i].count != 0)
+        {
+            printf("%-4s %-20s %5u   %12u   %12u\r\n", i < KIND_REGISTER_ACK ? "Up" : "Down", g_kindName[i], g_network.stat[i].count, (unsigned int)g_network.stat[i].coapSize, (unsigned int)g_network.stat[i].schcSize);
+        }
+    }
+    printf("Notifications:  %u of %d in frames of %u bytes, largest %u bytes\r\n", g_network.notificationCount, notificationTarget, FRAME_SIZE_SLOWEST, (unsigned int)g_network.notificationSize);
+    printf("Message IDs:    %u notifications with a 4-bit one, %u with an 8-bit one\r\n", g_network.shortMIDCount, g_network.notificationCount - g_network.shortMIDCount);
+    if (deviceRead == true)
+    {
+        prv_printRead(FRAME_SIZE_SLOW, slowBlockCount, slowBlockSize, slowFrameSize);
+        prv_printRead(FRAME_SIZE_FASTEST, fastBlockCount, fastBlockSize, fastFrameSize);
+    }
+    else
+    {
+        printf("Read /%s:       failed\r\n", DEVICE_PATH);
+    }
+    printf("Object list:    %s before the Update acknowledgement, %s after\r\n", previousListRead == true ? "previous" : "wrong", newListRead == true ? "new" : "wrong");
+    printf("Oversized:      %u frames\r\n", g_network.oversizedCount);
+
+    return (g_network.notificationCount == (uint32_t)notificationTarget
+            && g_network.notificationSize <= FRAME_SIZE_SLOWEST
+            && deviceRead == true
+            && previousListRead == true
+            && newListRead == true
+            && g_network.oversizedCount == 0) ? 0 : 1;
+}
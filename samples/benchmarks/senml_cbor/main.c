@@ -0,0 +1,453 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark compares the SenML CBOR and the
+ * TLV content formats on typical IPSO payloads:
+ * the size of the serialized payloads, with and
+ * without the base name and base time factoring
+ * for SenML CBOR, and the time to serialize and
+ * to deserialize them. Each payload is checked to
+ * deserialize to the serialized records.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_prv_data.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_OPERATION_COUNT 100000
+
+#define ID_ALL IOWA_LWM2M_ID_ALL
+
+// First timestamp of the time series
+#define BASE_TIME 1760000000
+
+typedef struct
+{
+    uint16_t               objectId;
+    uint16_t               instanceId;
+    uint16_t               resourceId;
+    uint16_t               resInstanceId;
+    iowa_lwm2m_data_type_t type;
+    double                 floatValue;
+    int64_t                integerValue; // also the boolean value
+    const char            *stringValue;
+    int32_t                timestamp;
+} record_t;
+
+typedef struct
+{
+    const char     *name;
+    iowa_lwm2m_uri_t uri;           // the target of the Read
+    const record_t *recordArray;
+    size_t          recordCount;
+    bool            hasTimestamp;   // TLV cannot carry the timestamps
+} payload_t;
+
+#define FLOAT(O, I, R, V)        { (O), (I), (R), ID_ALL, IOWA_LWM2M_TYPE_FLOAT, (V), 0, NULL, 0 }
+#define FLOAT_AT(O, I, R, V, T)  { (O), (I), (R), ID_ALL, IOWA_LWM2M_TYPE_FLOAT, (V), 0, NULL, (T) }
+#define INTEGER(O, I, R, V)      { (O), (I), (R), ID_ALL, IOWA_LWM2M_TYPE_INTEGER, 0.0, (V), NULL, 0 }
+#define BOOLEAN(O, I, R, V)      { (O), (I), (R), ID_ALL, IOWA_LWM2M_TYPE_BOOLEAN, 0.0, (V), NULL, 0 }
+#define STRING(O, I, R, V)       { (O), (I), (R), ID_ALL, IOWA_LWM2M_TYPE_STRING, 0.0, 0, (V), 0 }
+#define UNSIGNED(O, I, R, RI, V) { (O), (I), (R), (RI), IOWA_LWM2M_TYPE_UNSIGNED_INTEGER, 0.0, (V), NULL, 0 }
+
+static const record_t g_temperatureValue[] =
+{
+    FLOAT(3303, 0, 5700, 21.5)
+};
+
+static const record_t g_temperatureInstance[] =
+{
+    FLOAT(3303, 0, 5601, 18.25),
+    FLOAT(3303, 0, 5602, 24.75),
+    FLOAT(3303, 0, 5603, -40.0),
+    FLOAT(3303, 0, 5604, 85.0),
+    FLOAT(3303, 0, 5700, 21.37),
+    STRING(3303, 0, 5701, "Cel"),
+    STRING(3303, 0, 5750, "Living room")
+};
+
+static const record_t g_accelerometerInstance[] =
+{
+    STRING(3313, 0, 5701, "m/s2"),
+    FLOAT(3313, 0, 5702, 0.125),
+    FLOAT(3313, 0, 5703, -0.5),
+    FLOAT(3313, 0, 5704, 9.81)
+};
+
+static const record_t g_lightControlInstance[] =
+{
+    STRING(3311, 0, 5706, "#FFD080"),
+    STRING(3311, 0, 5750, "Kitchen"),
+    BOOLEAN(3311, 0, 5850, true),
+    INTEGER(3311, 0, 5851, 80),
+    INTEGER(3311, 0, 5852, 3600)
+};
+
+static const record_t g_temperatureObject[] =
+{
+    FLOAT(3303, 0, 5601, 18.5),
+    FLOAT(3303, 0, 5602, 24.0),
+    FLOAT(3303, 0, 5700, 21.25),
+    STRING(3303, 0, 5701, "Cel"),
+    FLOAT(3303, 1, 5601, 19.5),
+    FLOAT(3303, 1, 5602, 25.0),
+    FLOAT(3303, 1, 5700, 22.25),
+    STRING(3303, 1, 5701, "Cel"),
+    FLOAT(3303, 2, 5601, 20.5),
+    FLOAT(3303, 2, 5602, 26.0),
+    FLOAT(3303, 2, 5700, 23.25),
+    STRING(3303, 2, 5701, "Cel")
+};
+
+static const record_t g_powerSourceVoltage[] =
+{
+    UNSIGNED(3, 0, 7, 0, 3800),
+    UNSIGNED(3, 0, 7, 1, 4200),
+    UNSIGNED(3, 0, 7, 2, 4600)
+};
+
+// One sample per minute, as stored for a notification or sent with the Send operation
+static const record_t g_temperatureSeries[] =
+{
+    FLOAT_AT(3303, 0, 5700, 20.5, BASE_TIME),
+    FLOAT_AT(3303, 0, 5700, 20.75, BASE_TIME + 60),
+    FLOAT_AT(3303, 0, 5700, 21.0, BASE_TIME + 120),
+    FLOAT_AT(3303, 0, 5700, 21.25, BASE_TIME + 180),
+    FLOAT_AT(3303, 0, 5700, 21.5, BASE_TIME + 240),
+    FLOAT_AT(3303, 0, 5700, 21.75, BASE_TIME + 300),
+    FLOAT_AT(3303, 0, 5700, 22.0, BASE_TIME + 360),
+    FLOAT_AT(3303, 0, 5700, 22.25, BASE_TIME + 420),
+    FLOAT_AT(3303, 0, 5700, 22.5, BASE_TIME + 480),
+    FLOAT_AT(3303, 0, 5700, 22.75, BASE_TIME + 540)
+};
+
+static const record_t g_twoSensorSeries[] =
+{
+    FLOAT_AT(3303, 0, 5700, 21.5, BASE_TIME),
+    FLOAT_AT(3303, 1, 5700, 19.0, BASE_TIME),
+    FLOAT_AT(3303, 0, 5700, 21.75, BASE_TIME + 300),
+    FLOAT_AT(3303, 1, 5700, 19.25, BASE_TIME + 300)
+};
+
+#define PAYLOAD(N, O, I, R, A, T) { (N), { (O), (I), (R), ID_ALL }, (A), sizeof(A) / sizeof(record_t), (T) }
+
+static const payload_t g_payloadArray[] =
+{
+    PAYLOAD("Temperature value", 3303, 0, 5700, g_temperatureValue, false),
+    PAYLOAD("Temperature instance", 3303, 0, ID_ALL, g_temperatureInstance, false),
+    PAYLOAD("Accelerometer instance", 3313, 0, ID_ALL, g_accelerometerInstance, false),
+    PAYLOAD("Light control instance", 3311, 0, ID_ALL, g_lightControlInstance, false),
+    PAYLOAD("Temperature Object", 3303, ID_ALL, ID_ALL, g_temperatureObject, false),
+    PAYLOAD("Power source voltages", 3, 0, 7, g_powerSourceVoltage, false),
+    PAYLOAD("Temperature series", 3303, 0, 5700, g_temperatureSeries, true),
+    PAYLOAD("Two sensor series", 3303, ID_ALL, ID_ALL, g_twoSensorSeries, true)
+};
+
+#define PAYLOAD_COUNT (sizeof(g_payloadArray) / sizeof(payload_t))
+
+static int64_t prv_getTimeNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static iowa_lwm2m_data_type_t prv_getResourceType(uint16_t objectID,
+                                                  uint16_t resourceID,
+                                                  void *userData)
+{
+    size_t i;
+    size_t j;
+
+    (void)userData;
+
+    for (i = 0; i < PAYLOAD_COUNT; i++)
+    {
+        for (j = 0; j < g_payloadArray[i].recordCount; j++)
+        {
+            if (g_payloadArray[i].recordArray[j].objectId == objectID
+                && g_payloadArray[i].recordArray[j].resourceId == resourceID)
+            {
+                return g_payloadArray[i].recordArray[j].type;
+            }
+        }
+    }
+
+    return IOWA_LWM2M_TYPE_UNDEFINED;
+}
+
+static void prv_recordToData(const record_t *recordP,
+                             iowa_lwm2m_data_t *dataP)
+{
+    memset(dataP, 0, sizeof(iowa_lwm2m_data_t));
+    dataP->objectID = recordP->objectId;
+    dataP->instanceID = recordP->instanceId;
+    dataP->resourceID = recordP->resourceId;
+    dataP->resInstanceID = recordP->resInstanceId;
+    dataP->type = recordP->type;
+    dataP->timestamp = recordP->timestamp;
+    switch (recordP->type)
+    {
+    case IOWA_LWM2M_TYPE_FLOAT:
+        dataP->value.asFloat = recordP->floatValue;
+        break;
+
+    case IOWA_LWM2M_TYPE_BOOLEAN:
+        dataP->value.asBoolean = (recordP->integerValue != 0);
+        break;
+
+    case IOWA_LWM2M_TYPE_STRING:
+        dataP->value.asBuffer.buffer = (uint8_t *)recordP->stringValue;
+        dataP->value.asBuffer.length = strlen(recordP->stringValue);
+        break;
+
+    default:
+        dataP->value.asInteger = recordP->integerValue;
+        break;
+    }
+}
+
+// TLV carries the floats which fit in single precision on four bytes, and no timestamps.
+static bool prv_isSameData(const iowa_lwm2m_data_t *dataP,
+                           const iowa_lwm2m_data_t *otherP,
+                           iowa_content_format_t format)
+{
+    if (dataP->objectID != otherP->objectID
+        || dataP->instanceID != otherP->instanceID
+        || dataP->resourceID != otherP->resourceID
+        || dataP->resInstanceID != otherP->resInstanceID
+        || dataP->type != otherP->type
+        || (format == IOWA_CONTENT_FORMAT_SENML_CBOR && dataP->timestamp != otherP->timestamp))
+    {
+        return false;
+    }
+
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_FLOAT:
+        if (format == IOWA_CONTENT_FORMAT_TLV)
+        {
+            return (float)dataP->value.asFloat == (float)otherP->value.asFloat;
+        }
+        return dataP->value.asFloat == otherP->value.asFloat;
+
+    case IOWA_LWM2M_TYPE_BOOLEAN:
+        return dataP->value.asBoolean == otherP->value.asBoolean;
+
+    case IOWA_LWM2M_TYPE_STRING:
+        return dataP->value.asBuffer.length == otherP->value.asBuffer.length
+               && memcmp(dataP->value.asBuffer.buffer, otherP->value.asBuffer.buffer, dataP->value.asBuffer.length) == 0;
+
+    default:
+        return dataP->value.asInteger == otherP->value.asInteger;
+    }
+}
+
+// Check that a payload deserializes to the serialized records, in any order.
+static bool prv_checkPayload(const payload_t *payloadP,
+                             iowa_lwm2m_data_t *dataArray,
+                             iowa_content_format_t format,
+                             uint8_t *buffer,
+                             size_t length)
+{
+    iowa_lwm2m_uri_t uri;
+    iowa_lwm2m_data_t *resultArray;
+    size_t resultCount;
+    size_t i;
+    size_t j;
+    bool result;
+
+    uri = payloadP->uri;
+    if (dataLwm2mDeserialize(&uri, buffer, length, format, &resultArray, &resultCount, prv_getResourceType, NULL) != IOWA_COAP_NO_ERROR)
+    {
+        return false;
+    }
+
+    result = (resultCount == payloadP->recordCount);
+    for (i = 0; i < resultCount && result == true; i++)
+    {
+        result = false;
+        for (j = 0; j < payloadP->recordCount && result == false; j++)
+        {
+            result = prv_isSameData(resultArray + i, dataArray + j, format);
+        }
+    }
+    dataLwm2mFree(resultCount, resultArray);
+
+    return result;
+}
+
+// Serialize a payload, and return the time per serialization and per deserialization in nanoseconds.
+static bool prv_measureFormat(const payload_t *payloadP,
+                              iowa_lwm2m_data_t *dataArray,
+                              iowa_content_format_t format,
+                              unsigned long operationCount,
+                              size_t *lengthP,
+                              double *serializeTimeP,
+                              double *deserializeTimeP)
+{
+    iowa_lwm2m_uri_t uri;
+    iowa_content_format_t usedFormat;
+    uint8_t *buffer;
+    size_t length;
+    unsigned long op;
+    int64_t start;
+
+    uri = payloadP->uri;
+    usedFormat = format;
+    if (dataLwm2mSerialize(&uri, dataArray, payloadP->recordCount, &usedFormat, &buffer, &length) != IOWA_COAP_NO_ERROR
+        || usedFormat != format)
+    {
+        return false;
+    }
+    if (prv_checkPayload(payloadP, dataArray, format, buffer, length) == false)
+    {
+        iowa_system_free(buffer);
+        return false;
+    }
+    *lengthP = length;
+
+    start = prv_getTimeNs();
+    for (op = 0; op < operationCount; op++)
+    {
+        uint8_t *opBuffer;
+        size_t opLength;
+
+        usedFormat = format;
+        (void)dataLwm2mSerialize(&uri, dataArray, payloadP->recordCount, &usedFormat, &opBuffer, &opLength);
+        iowa_system_free(opBuffer);
+    }
+    *serializeTimeP = (double)(prv_getTimeNs() - start) / operationCount;
+
+    start = prv_getTimeNs();
+    for (op = 0; op < operationCount; op++)
+    {
+        iowa_lwm2m_data_t *resultArray;
+        size_t resultCount;
+
+        (void)dataLwm2mDeserialize(&uri, buffer, length, format, &resultArray, &resultCount, prv_getResourceType, NULL);
+        dataLwm2mFree(resultCount, resultArray);
+    }
+    *deserializeTimeP = (double)(prv_getTimeNs() - start) / operationCount;
+
+    iowa_system_free(buffer);
+
+    return true;
+}
+
+// Size of the SenML CBOR payload when each record carries its full name and time.
+static size_t prv_getUnfactoredSize(const payload_t *payloadP,
+                                    iowa_lwm2m_data_t *dataArray)
+{
+    size_t total;
+    size_t i;
+
+    // The array header of less than 24 records takes one byte
+    total = 1;
+    for (i = 0; i < payloadP->recordCount; i++)
+    {
+        iowa_content_format_t format;
+        uint8_t *buffer;
+        size_t length;
+
+        format = IOWA_CONTENT_FORMAT_SENML_CBOR;
+        if (dataLwm2mSerialize(NULL, dataArray + i, 1, &format, &buffer, &length) != IOWA_COAP_NO_ERROR)
+        {
+            return 0;
+        }
+        total += length - 1;
+        iowa_system_free(buffer);
+    }
+
+    return total;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    iowa_lwm2m_data_t dataArray[16];
+    unsigned long operationCount;
+    size_t i;
+    size_t j;
+    int result;
+
+    operationCount = DEFAULT_OPERATION_COUNT;
+    if (argc > 1)
+    {
+        operationCount = strtoul(argv[1], NULL, 10);
+        if (operationCount == 0)
+        {
+            fprintf(stderr, "Usage: %s [operation count]\r\n", argv[0]);
+            return 1;
+        }
+    }
+
+    result = 0;
+    printf("                                    Size (bytes)              Nanoseconds per payload\r\n");
+    printf("                                 SenML  SenML CBOR            SenML CBOR      TLV\r\n");
+    printf("Payload                 Records   CBOR  no bn/bt   TLV     enc     dec     enc     dec\r\n");
+    for (i = 0; i < PAYLOAD_COUNT; i++)
+    {
+        const payload_t *payloadP;
+        size_t senmlLength;
+        double senmlSerializeTime;
+        double senmlDeserializeTime;
+
+        payloadP = g_payloadArray + i;
+        for (j = 0; j < payloadP->recordCount; j++)
+        {
+            prv_recordToData(payloadP->recordArray + j, dataArray + j);
+        }
+
+        if (prv_measureFormat(payloadP, dataArray, IOWA_CONTENT_FORMAT_SENML_CBOR, operationCount, &senmlLength, &senmlSerializeTime, &senmlDeserializeTime) == false)
+        {
+            fprintf(stderr, "SenML CBOR round trip of the %s failed.\r\n", payloadP->name);
+            result = 1;
+            continue;
+        }
+
+        printf("%-24s %6u %6u %9u", payloadP->name, (unsigned int)payloadP->recordCount, (unsigned int)senmlLength, (unsigned int)prv_getUnfactoredSize(payloadP, dataArray));
+
+        if (payloadP->hasTimestamp == false)
+        {
+            size_t tlvLength;
+            double tlvSerializeTime;
+            double tlvDeserializeTime;
+
+            if (prv_measureFormat(payloadP, dataArray, IOWA_CONTENT_FORMAT_TLV, operationCount, &tlvLength, &tlvSerializeTime, &tlvDeserializeTime) == false)
+            {
+                printf("\r\n");
+                fprintf(stderr, "TLV round trip of the %s failed.\r\n", payloadP->name);
+                result = 1;
+                continue;
+            }
+            printf(" %5u %7.0f %7.0f %7.0f %7.0f\r\n", (unsigned int)tlvLength, senmlSerializeTime, senmlDeserializeTime, tlvSerializeTime, tlvDeserializeTime);
+        }
+        else
+        {
+            printf("     - %7.0f %7.0f       -       -\r\n", senmlSerializeTime, senmlDeserializeTime);
+        }
+    }
+
+    return result;
+}
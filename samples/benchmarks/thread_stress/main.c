@@ -0,0 +1,234 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark stresses IOWA_THREAD_SUPPORT:
+ * producer threads update an observed IPSO
+ * sensor while the main thread runs iowa_step()
+ * and notifies a stand-in LwM2M Server.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_ipso.h"
+
+#include "bench_server.h"
+#include "sample_abstraction.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define SERVER_SHORT_ID 1234
+#define SERVER_LIFETIME 300
+
+#define DEFAULT_PRODUCER_COUNT 4
+#define DEFAULT_DURATION       5
+
+#define MAX_PRODUCER_COUNT 32
+
+typedef struct
+{
+    iowa_context_t iowaH;
+    iowa_sensor_t  sensorId;
+    unsigned int   index;
+    unsigned long  updateCount;
+} producer_t;
+
+static int g_stop = 0;
+
+static bool prv_isStopped(void)
+{
+    return __atomic_load_n(&g_stop, __ATOMIC_ACQUIRE) != 0;
+}
+
+// The even producers update the sensor value, the odd ones report a change of the value.
+static void *prv_producerThread(void *arg)
+{
+    producer_t *producerP;
+    unsigned int seed;
+
+    producerP = (producer_t *)arg;
+    seed = producerP->index;
+
+    while (prv_isStopped() == false)
+    {
+        if (producerP->index % 2 == 0)
+        {
+            (void)iowa_client_IPSO_update_value(producerP->iowaH, producerP->sensorId, (float)(rand_r(&seed) % 60) - 10.0f);
+        }
+        else
+        {
+            (void)iowa_client_object_resource_changed(producerP->iowaH, IOWA_IPSO_TEMPERATURE, 0, IPSO_RSC_ID_SENSOR_VALUE);
+        }
+        producerP->updateCount++;
+    }
+
+    return NULL;
+}
+
+// Add and remove another sensor to exercise the Objects lock against the producers.
+static void *prv_churnThread(void *arg)
+{
+    iowa_context_t iowaH;
+
+    iowaH = (iowa_context_t)arg;
+
+    while (prv_isStopped() == false)
+    {
+        iowa_sensor_t sensorId;
+
+        if (iowa_client_IPSO_add_sensor(iowaH, IOWA_IPSO_HUMIDITY, 50.0f, "%", NULL, 0.0f, 100.0f, &sensorId) == IOWA_COAP_NO_ERROR)
+        {
+            usleep(1000);
+            (void)iowa_client_IPSO_remove_sensor(iowaH, sensorId);
+        }
+        usleep(1000);
+    }
+
+    return NULL;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    sample_user_data_t userData;
+    iowa_context_t iowaH;
+    iowa_device_info_t devInfo;
+    iowa_sensor_t sensorId;
+    bench_server_t server;
+    producer_t producerArray[MAX_PRODUCER_COUNT];
+    pthread_t producerThreadArray[MAX_PRODUCER_COUNT];
+    pthread_t churnThread;
+    unsigned int producerCount;
+    int duration;
+    unsigned long totalCount;
+    unsigned int i;
+    char serverUri[64];
+    int64_t startTime;
+    double elapsed;
+    iowa_status_t result;
+
+    producerCount = DEFAULT_PRODUCER_COUNT;
+    duration = DEFAULT_DURATION;
+    if (argc > 1)
+    {
+        producerCount = (unsigned int)atoi(argv[1]);
+    }
+    if (argc > 2)
+    {
+        duration = atoi(argv[2]);
+    }
+    if (producerCount == 0
+        || producerCount > MAX_PRODUCER_COUNT
+        || duration <= 0)
+    {
+        fprintf(stderr, "Usage: %s [producer count (1-%d)] [duration in seconds]\r\n", argv[0], MAX_PRODUCER_COUNT);
+        return 1;
+    }
+
+    memset(&server, 0, sizeof(server));
+    server.observe = true;
+    if (bench_server_open(&server) != 0
+        || bench_server_start(&server) != 0)
+    {
+        fprintf(stderr, "Stand-in server creation failed.\r\n");
+        return 1;
+    }
+    snprintf(serverUri, sizeof(serverUri), "coap://127.0.0.1:%u", server.port);
+
+    // With IOWA_THREAD_SUPPORT, the sample mutex abstraction uses the mutex of the iowa_init() user data as context lock
+    pthread_mutex_init(&(userData.mutex), NULL);
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+    if (sample_wait_context_init(&(userData.wait)) != 0)
+    {
+        fprintf(stderr, "epoll instance creation failed.\r\n");
+        return 1;
+    }
+#endif
+    iowaH = iowa_init(&userData);
+    if (iowaH == NULL)
+    {
+        fprintf(stderr, "IOWA context initialization failed.\r\n");
+        return 1;
+    }
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    result = iowa_client_configure(iowaH, "thread_stress", &devInfo, NULL);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = iowa_client_IPSO_add_sensor(iowaH, IOWA_IPSO_TEMPERATURE, 20.0f, "Cel", NULL, -20.0f, 50.0f, &sensorId);
+    }
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = iowa_client_add_server(iowaH, SERVER_SHORT_ID, serverUri, SERVER_LIFETIME, 0, IOWA_SEC_NONE);
+    }
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "IOWA Client configuration failed (%u.%02u).\r\n", (result & 0xFF) >> 5, (result & 0x1F));
+        iowa_close(iowaH);
+        return 1;
+    }
+
+    // Register and let the server observe the sensor value before starting the producers
+    (void)iowa_step(iowaH, 1);
+
+    for (i = 0; i < producerCount; i++)
+    {
+        producerArray[i].iowaH = iowaH;
+        producerArray[i].sensorId = sensorId;
+        producerArray[i].index = i;
+        producerArray[i].updateCount = 0;
+        pthread_create(producerThreadArray + i, NULL, prv_producerThread, producerArray + i);
+    }
+    pthread_create(&churnThread, NULL, prv_churnThread, iowaH);
+
+    startTime = bench_now();
+    (void)iowa_step(iowaH, duration);
+    elapsed = (double)(bench_now() - startTime) / 1000000.0;
+
+    __atomic_store_n(&g_stop, 1, __ATOMIC_RELEASE);
+
+    totalCount = 0;
+    for (i = 0; i < producerCount; i++)
+    {
+        pthread_join(producerThreadArray[i], NULL);
+        totalCount += producerArray[i].updateCount;
+    }
+    pthread_join(churnThread, NULL);
+
+    // Let the last notifications reach the server
+    (void)iowa_step(iowaH, 1);
+
+    iowa_client_remove_server(iowaH, SERVER_SHORT_ID);
+    iowa_client_IPSO_remove_sensor(iowaH, sensorId);
+    iowa_close(iowaH);
+#ifdef IOWA_CONNECTION_WAIT_SUPPORT
+    sample_wait_context_close(&(userData.wait));
+#endif
+    pthread_mutex_destroy(&(userData.mutex));
+
+    bench_server_stop(&server);
+
+    printf("Producers:      %u\r\n", producerCount);
+    printf("Duration:       %.1f s\r\n", elapsed);
+    printf("Registrations:  %u\r\n", server.registrationCount);
+    printf("Updates:        %lu (%.0f /s)\r\n", totalCount, (double)totalCount / elapsed);
+    printf("Notifications:  %u (%.0f /s)\r\n", server.notificationCount, (double)server.notificationCount / elapsed);
+
+    return server.registrationCount > 0 && server.notificationCount > 0 ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark measures the cost of the IOWA
+ * core timer operations against the number of
+ * armed timers in the context.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_prv_core_internals.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Delays of the timers are drawn between 1 second and one hour
+#define MAX_DELAY 3600
+
+#define DEFAULT_OPERATION_COUNT 1000000
+
+static uint32_t g_randomState = 0x12345678;
+static unsigned long g_fireCount = 0;
+
+static uint32_t prv_random(void)
+{
+    // xorshift32, enough to spread the timers
+    g_randomState ^= g_randomState << 13;
+    g_randomState ^= g_randomState >> 17;
+    g_randomState ^= g_randomState << 5;
+
+    return g_randomState;
+}
+
+static int32_t prv_randomDelay(void)
+{
+    return (int32_t)(1 + prv_random() % MAX_DELAY);
+}
+
+static int64_t prv_getTimeNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Timer callback re-arming a timer so the number of armed timers stays constant.
+static void prv_timerCallback(iowa_context_t contextP,
+                              void *userData)
+{
+    iowa_timer_t **slotP;
+
+    slotP = (iowa_timer_t **)userData;
+    g_fireCount++;
+    *slotP = coreTimerNew(contextP, prv_randomDelay(), prv_timerCallback, slotP);
+}
+
+static void prv_runBenchmark(iowa_context_t contextP,
+                             size_t timerCount,
+                             unsigned long operationCount)
+{
+    iowa_timer_t **timerArray;
+    size_t i;
+    unsigned long op;
+    int64_t start;
+    double resetNs;
+    double addDeleteNs;
+    double nextDelayNs;
+    double fireNs;
+    volatile int32_t delaySink;
+
+    timerArray = (iowa_timer_t **)malloc(timerCount * sizeof(iowa_timer_t *));
+    if (timerArray == NULL)
+    {
+        fprintf(stderr, "Memory allocation failure.\r\n");
+        exit(1);
+    }
+
+    contextP->currentTime = 0;
+    for (i = 0; i < timerCount; i++)
+    {
+        timerArray[i] = coreTimerNew(contextP, prv_randomDelay(), prv_timerCallback, timerArray + i);
+        if (timerArray[i] == NULL)
+        {
+            fprintf(stderr, "Timer creation failure.\r\n");
+            exit(1);
+        }
+    }
+
+    // Rescheduling of an armed timer, like a registration update or an exchange timeout
+    start = prv_getTimeNs();
+    for (op = 0; op < operationCount; op++)
+    {
+        coreTimerReset(contextP, timerArray[prv_random() % timerCount], prv_randomDelay());
+    }
+    resetNs = (double)(prv_getTimeNs() - start) / operationCount;
+
+    // Short-lived timer added then cancelled before it expires
+    start = prv_getTimeNs();
+    for (op = 0; op < operationCount; op++)
+    {
+        coreTimerDelete(contextP, coreTimerNew(contextP, prv_randomDelay(), prv_timerCallback, NULL));
+    }
+    addDeleteNs = (double)(prv_getTimeNs() - start) / operationCount;
+
+    // Delay before the next timer, computed at every iowa_step() iteration
+    start = prv_getTimeNs();
+    for (op = 0; op < operationCount; op++)
+    {
+        delaySink = coreTimerGetNextDelay(contextP);
+    }
+    nextDelayNs = (double)(prv_getTimeNs() - start) / operationCount;
+    (void)delaySink;
+
+    // Expiration: the time jumps to the next deadline and each fired timer is re-armed
+    g_fireCount = 0;
+    start = prv_getTimeNs();
+    while (g_fireCount < operationCount)
+    {
+        contextP->currentTime += coreTimerGetNextDelay(contextP);
+        contextP->timeout = INT32_MAX;
+        coreTimerStep(contextP);
+    }
+    fireNs = (double)(prv_getTimeNs() - start) / g_fireCount;
+
+    printf("%10lu %12.1f %12.1f %12.1f %12.1f\r\n", (unsigned long)timerCount, resetNs, addDeleteNs, nextDelayNs, fireNs);
+
+    for (i = 0; i < timerCount; i++)
+    {
+        coreTimerDelete(contextP, timerArray[i]);
+    }
+    free(timerArray);
+}
+
+int main(int argc,
+         char *argv[])
+{
+    iowa_context_t iowaH;
+    unsigned long operationCount;
+    size_t timerCount;
+
+    operationCount = DEFAULT_OPERATION_COUNT;
+    if (argc > 1)
+    {
+        operationCount = strtoul(argv[1], NULL, 10);
+        if (operationCount == 0)
+        {
+            fprintf(stderr, "Usage: %s [operation count]\r\n", argv[0]);
+            return 1;
+        }
+    }
+
+    iowaH = iowa_init(NULL);
+    if (iowaH == NULL)
+    {
+        fprintf(stderr, "IOWA context initialization failed.\r\n");
+        return 1;
+    }
+
+    printf("Nanoseconds per operation:\r\n");
+    printf("%10s %12s %12s %12s %12s\r\n", "timers", "reset", "add+delete", "next delay", "fire");
+    for (timerCount = 10; timerCount <= 100000; timerCount *= 10)
+    {
+        prv_runBenchmark(iowaH, timerCount, operationCount);
+    }
+
+    iowa_close(iowaH);
+
+    return 0;
+}
@@ -0,0 +1,963 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2023 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark runs an LwM2M Client over
+ * "coap+ws://" (RFC 8323 Section 4) against a
+ * stand-in LwM2M Server on loopback TCP. The
+ * Server first answers the opening handshake
+ * with a wrong Sec-WebSocket-Accept, then with
+ * the right one. It checks that each frame of
+ * the Client is masked, sends its CSM in a frame
+ * split across several writes, reads a Resource
+ * of the Client and closes the connection.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+
+#include "bench_server.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define SERVER_SHORT_ID 1234
+#define SERVER_LIFETIME 300
+
+#define MANUFACTURER    "IOWA WebSocket benchmark"
+
+#define DEFAULT_READ_COUNT 10000
+
+// Time in seconds after which a run is abandoned
+#define MAX_RUN_TIME    60
+
+#define PRV_COAP_CODE_GET     0x01
+#define PRV_COAP_CODE_POST    0x02
+#define PRV_COAP_CODE_DELETE  0x04
+#define PRV_COAP_CODE_201     0x41
+#define PRV_COAP_CODE_202     0x42
+#define PRV_COAP_CODE_205     0x45
+#define PRV_COAP_CODE_404     0x84
+#define PRV_COAP_CODE_CSM     0xE1
+
+// Frame header (RFC 6455 Section 5.2)
+#define PRV_WS_FIN            0x80
+#define PRV_WS_MASK           0x80
+#define PRV_WS_LENGTH_16      126
+#define PRV_WS_LENGTH_64      127
+#define PRV_WS_OPCODE_BINARY  0x02
+#define PRV_WS_OPCODE_CLOSE   0x08
+#define PRV_WS_CLOSE_NORMAL   1000
+
+#define PRV_WS_GUID           "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define PRV_WS_KEY_LENGTH     24
+#define PRV_WS_ACCEPT_LENGTH  28
+
+#define PRV_BUFFER_SIZE       2048
+#define PRV_TOKEN_LENGTH      2
+
+// Number of writes carrying the CSM of the Server, and the delay in microseconds between them
+#define PRV_SPLIT_COUNT       3
+#define PRV_SPLIT_DELAY       10000
+
+// Time in milliseconds between two checks of the stop flag
+#define PRV_POLL_TIMEOUT      10
+
+typedef struct
+{
+    uint8_t        code;
+    uint8_t        tokenLength;
+    const uint8_t *token;
+    const uint8_t *payload;
+    size_t         payloadLength;
+} prv_message_t;
+
+typedef struct
+{
+    // Configuration
+    bool      badAccept;           // Answer the opening handshake with a wrong Sec-WebSocket-Accept
+    uint32_t  readTarget;          // Number of Read requests on /3/0/0
+
+    // Internal state
+    int       listenSock;
+    int       sock;
+    uint16_t  port;
+    uint16_t  nextToken;
+    int       stop;
+    pthread_t thread;
+    uint8_t   receiveBuffer[PRV_BUFFER_SIZE];
+    size_t    receiveLength;       // bytes in receiveBuffer
+    size_t    frameLength;         // of the frame at the start of receiveBuffer, 0 if none
+    uint8_t   sendBuffer[PRV_BUFFER_SIZE];
+
+    // Results
+    int       done;                // 1 when the exchanges succeeded, -1 when they failed
+    uint32_t  frameCount;          // frames received from the Client, all masked
+    uint32_t  readCount;
+    double    readDuration;        // in seconds
+    uint16_t  closeStatus;         // status code of the Close frame of the Client
+} prv_server_t;
+
+/*************************************************************************************
+** SHA-1 and Base64, to compute the Sec-WebSocket-Accept value (RFC 6455 Section 4.2.2)
+*************************************************************************************/
+
+static uint32_t prv_rotateLeft(uint32_t value,
+                               int count)
+{
+    return (value << count) | (value >> (32 - count));
+}
+
+static void prv_sha1Block(uint32_t state[5],
+                          const uint8_t *block)
+{
+    uint32_t w[80];
+    uint32_t a, b, c, d, e;
+    int i;
+
+    for (i = 0; i < 16; i++)
+    {
+        w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16) | ((uint32_t)block[4 * i + 2] << 8) | (uint32_t)block[4 * i + 3];
+    }
+    for (i = 16; i < 80; i++)
+    {
+        w[i] = prv_rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    for (i = 0; i < 80; i++)
+    {
+        uint32_t f;
+        uint32_t temp;
+
+        if (i < 20)
+        {
+            f = ((b & c) | (~b & d)) + 0x5A827999;
+        }
+        else if (i < 40)
+        {
+            f = (b ^ c ^ d) + 0x6ED9EBA1;
+        }
+        else if (i < 60)
+        {
+            f = ((b & c) | (b & d) | (c & d)) + 0x8F1BBCDC;
+        }
+        else
+        {
+            f = (b ^ c ^ d) + 0xCA62C1D6;
+        }
+        temp = prv_rotateLeft(a, 5) + f + e + w[i];
+        e = d;
+        d = c;
+        c = prv_rotateLeft(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+// The data is at most two blocks long.
+static void prv_sha1(const uint8_t *data,
+                     size_t length,
+                     uint8_t digest[20])
+{
+    uint32_t state[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    uint8_t buffer[128];
+    size_t paddedLength;
+    size_t i;
+
+    paddedLength = ((length + 8) / 64 + 1) * 64;
+    memset(buffer, 0, sizeof(buffer));
+    memcpy(buffer, data, length);
+    buffer[length] = 0x80;
+    for (i = 0; i < 8; i++)
+    {
+        buffer[paddedLength - 1 - i] = (uint8_t)(((uint64_t)length * 8) >> (8 * i));
+    }
+    for (i = 0; i < paddedLength; i += 64)
+    {
+        prv_sha1Block(state, buffer + i);
+    }
+
+    for (i = 0; i < 20; i++)
+    {
+        digest[i] = (uint8_t)(state[i / 4] >> (24 - 8 * (i % 4)));
+    }
+}
+
+static void prv_computeAccept(const uint8_t *key,
+                              char accept[PRV_WS_ACCEPT_LENGTH])
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    uint8_t buffer[PRV_WS_KEY_LENGTH + sizeof(PRV_WS_GUID) - 1];
+    uint8_t digest[21];
+    size_t i;
+
+    memcpy(buffer, key, PRV_WS_KEY_LENGTH);
+    memcpy(buffer + PRV_WS_KEY_LENGTH, PRV_WS_GUID, sizeof(PRV_WS_GUID) - 1);
+    prv_sha1(buffer, sizeof(buffer), digest);
+
+    // 20 bytes give 27 Base64 characters and one padding character
+    digest[20] = 0;
+    for (i = 0; i < 7; i++)
+    {
+        uint32_t value;
+
+        value = ((uint32_t)digest[3 * i] << 16) | ((uint32_t)digest[3 * i + 1] << 8) | (uint32_t)digest[3 * i + 2];
+        accept[4 * i] = alphabet[(value >> 18) & 0x3F];
+        accept[4 * i + 1] = alphabet[(value >> 12) & 0x3F];
+        accept[4 * i + 2] = alphabet[(value >> 6) & 0x3F];
+        accept[4 * i + 3] = alphabet[value & 0x3F];
+    }
+    accept[PRV_WS_ACCEPT_LENGTH - 1] = '=';
+}
+
+/*************************************************************************************
+** Stand-in LwM2M Server
+*************************************************************************************/
+
+// Find a string in a buffer.
+// Returned value: the position of the string, or -1 if it is not found.
+static long prv_find(const uint8_t *buffer,
+                     size_t length,
+                     const char *str)
+{
+    size_t strLength;
+    size_t i;
+
+    strLength = strlen(str);
+    for (i = 0; i + strLength <= length; i++)
+    {
+        if (memcmp(buffer + i, str, strLength) == 0)
+        {
+            return (long)i;
+        }
+    }
+
+    return -1;
+}
+
+// Wait for bytes from the Client and append them to receiveBuffer.
+// Returned value: the number of received bytes, 0 when the Client closed the connection, -1 when the server is stopped.
+static ssize_t prv_receive(prv_server_t *serverP)
+{
+    struct pollfd pfd;
+    ssize_t length;
+
+    do
+    {
+        if (__atomic_load_n(&serverP->stop, __ATOMIC_ACQUIRE) != 0)
+        {
+            return -1;
+        }
+        pfd.fd = serverP->sock;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+    } while (poll(&pfd, 1, PRV_POLL_TIMEOUT) <= 0);
+
+    if (serverP->receiveLength == PRV_BUFFER_SIZE)
+    {
+        fprintf(stderr, "Receive buffer full.\r\n");
+        return -1;
+    }
+    length = recv(serverP->sock, serverP->receiveBuffer + serverP->receiveLength, PRV_BUFFER_SIZE - serverP->receiveLength, 0);
+    if (length > 0)
+    {
+        serverP->receiveLength += (size_t)length;
+    }
+
+    return length;
+}
+
+static int prv_sendAll(prv_server_t *serverP,
+                       const uint8_t *buffer,
+                       size_t length)
+{
+    ssize_t sent;
+
+    while (length > 0)
+    {
+        sent = send(serverP->sock, buffer, length, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            return -1;
+        }
+        buffer += sent;
+        length -= (size_t)sent;
+    }
+
+    return 0;
+}
+
+// Check the upgrade request of the Client and answer it.
+static int prv_handshake(prv_server_t *serverP)
+{
+    char response[256];
+    char accept[PRV_WS_ACCEPT_LENGTH];
+    long end;
+    long key;
+    int length;
+
+    end = -1;
+    while (end < 0)
+    {
+        if (prv_receive(serverP) <= 0)
+        {
+            fprintf(stderr, "No upgrade request received from the Client.\r\n");
+            return -1;
+        }
+        end = prv_find(serverP->receiveBuffer, serverP->receiveLength, "\r\n\r\n");
+    }
+    end += 4;
+
+    key = prv_find(serverP->receiveBuffer, (size_t)end, "\r\nSec-WebSocket-Key: ");
+    if (memcmp(serverP->receiveBuffer, "GET /.well-known/coap HTTP/1.1\r\n", 32) != 0
+        || prv_find(serverP->receiveBuffer, (size_t)end, "\r\nUpgrade: websocket\r\n") < 0
+        || prv_find(serverP->receiveBuffer, (size_t)end, "\r\nSec-WebSocket-Version: 13\r\n") < 0
+        || prv_find(serverP->receiveBuffer, (size_t)end, "\r\nSec-WebSocket-Protocol: coap\r\n") < 0
+        || key < 0
+        || serverP->receiveBuffer[key + 21 + PRV_WS_KEY_LENGTH] != '\r')
+    {
+        fprintf(stderr, "Invalid upgrade request.\r\n");
+        return -1;
+    }
+
+    prv_computeAccept(serverP->receiveBuffer + key + 21, accept);
+    if (serverP->badAccept == true)
+    {
+        accept[0] = accept[0] == 'A' ? 'B' : 'A';
+    }
+    length = snprintf(response, sizeof(response),
+                      "HTTP/1.1 101 Switching Protocols\r\n"
+                      "Upgrade: websocket\r\n"
+                      "Connection: Upgrade\r\n"
+                      "Sec-WebSocket-Protocol: coap\r\n"
+                      "Sec-WebSocket-Accept: %.*s\r\n"
+                      "\r\n",
+                      PRV_WS_ACCEPT_LENGTH, accept);
+
+    // The next frame starts after the request
+    serverP->frameLength = (size_t)end;
+
+    return prv_sendAll(serverP, (const uint8_t *)response, (size_t)length);
+}
+
+// Send an unmasked frame in pieceCount writes.
+static int prv_sendFrame(prv_server_t *serverP,
+                         uint8_t opcode,
+                         size_t payloadLength,
+                         int pieceCount)
+{
+    uint8_t *start;
+    size_t headerLength;
+    size_t total;
+    size_t pieceLength;
+    int i;
+
+    // The payload is already in sendBuffer, after 4 bytes left for the header
+    if (payloadLength < PRV_WS_LENGTH_16)
+    {
+        headerLength = 2;
+        serverP->sendBuffer[3] = (uint8_t)payloadLength;
+    }
+    else
+    {
+        headerLength = 4;
+        serverP->sendBuffer[1] = PRV_WS_LENGTH_16;
+        serverP->sendBuffer[2] = (uint8_t)(payloadLength >> 8);
+        serverP->sendBuffer[3] = (uint8_t)payloadLength;
+    }
+    start = serverP->sendBuffer + 4 - headerLength;
+    start[0] = (uint8_t)(PRV_WS_FIN | opcode);
+    total = headerLength + payloadLength;
+
+    pieceLength = total / (size_t)pieceCount;
+    for (i = 0; i < pieceCount - 1; i++)
+    {
+        if (prv_sendAll(serverP, start, pieceLength) != 0)
+        {
+            return -1;
+        }
+        start += pieceLength;
+        total -= pieceLength;
+        usleep(PRV_SPLIT_DELAY);
+    }
+
+    return prv_sendAll(serverP, start, total);
+}
+
+// Send a CoAP message framed as in RFC 8323 Section 4.2. The options are already in sendBuffer,
+// after the room left for the frame header, the message header and the token.
+static int prv_sendMessage(prv_server_t *serverP,
+                           uint8_t code,
+                           const uint8_t *token,
+                           uint8_t tokenLength,
+                           const uint8_t *options,
+                           size_t optionsLength,
+                           int pieceCount)
+{
+    uint8_t *messageP;
+
+    messageP = serverP->sendBuffer + 4;
+    messageP[0] = tokenLength;
+    messageP[1] = code;
+    if (tokenLength > 0)
+    {
+        memcpy(messageP + 2, token, tokenLength);
+    }
+    if (optionsLength > 0)
+    {
+        memcpy(messageP + 2 + tokenLength, options, optionsLength);
+    }
+
+    return prv_sendFrame(serverP, PRV_WS_OPCODE_BINARY, 2 + tokenLength + optionsLength, pieceCount);
+}
+
+// Wait for a complete frame at the start of receiveBuffer and unmask its payload.
+// Returned value: 0 when a frame is received, -1 when the connection is closed, the frame is invalid or the server is stopped.
+static int prv_receiveFrame(prv_server_t *serverP,
+                            uint8_t *opcodeP,
+                            uint8_t **payloadP,
+                            size_t *lengthP)
+{
+    if (serverP->frameLength > 0)
+    {
+        // Discard the previous frame
+        memmove(serverP->receiveBuffer, serverP->receiveBuffer + serverP->frameLength, serverP->receiveLength - serverP->frameLength);
+        serverP->receiveLength -= serverP->frameLength;
+        serverP->frameLength = 0;
+    }
+
+    while (true)
+    {
+        if (serverP->receiveLength >= 2)
+        {
+            uint8_t *buffer;
+            size_t headerLength;
+            size_t length;
+            size_t i;
+
+            buffer = serverP->receiveBuffer;
+            if ((buffer[1] & PRV_WS_MASK) == 0)
+            {
+                fprintf(stderr, "Received an unmasked frame.\r\n");
+                return -1;
+            }
+            length = buffer[1] & 0x7F;
+            headerLength = 2;
+            if (length == PRV_WS_LENGTH_64)
+            {
+                fprintf(stderr, "Received a too large frame.\r\n");
+                return -1;
+            }
+            if (length == PRV_WS_LENGTH_16)
+            {
+                headerLength += 2;
+            }
+            headerLength += 4;
+
+            if (serverP->receiveLength >= headerLength)
+            {
+                if (headerLength == 8)
+                {
+                    length = ((size_t)buffer[2] << 8) | buffer[3];
+                }
+                if (headerLength + length > PRV_BUFFER_SIZE)
+                {
+                    fprintf(stderr, "Received a too large frame.\r\n");
+                    return -1;
+                }
+                if (serverP->receiveLength >= headerLength + length)
+                {
+                    for (i = 0; i < length; i++)
+                    {
+                        buffer[headerLength + i] ^= buffer[headerLength - 4 + (i & 0x03)];
+                    }
+                    serverP->frameCount++;
+                    serverP->frameLength = headerLength + length;
+
+                    *opcodeP = buffer[0] & 0x0F;
+                    *payloadP = buffer + headerLength;
+                    *lengthP = length;
+
+                    return 0;
+                }
+            }
+        }
+
+        if (prv_receive(serverP) <= 0)
+        {
+            return -1;
+        }
+    }
+}
+
+// Wait for a CoAP message from the Client.
+static int prv_receiveMessage(prv_server_t *serverP,
+                              prv_message_t *messageP)
+{
+    uint8_t opcode;
+    uint8_t *payload;
+    size_t length;
+    size_t pos;
+
+    if (prv_receiveFrame(serverP, &opcode, &payload, &length) != 0)
+    {
+        return -1;
+    }
+    if (opcode != PRV_WS_OPCODE_BINARY
+        || length < 2
+        || (payload[0] >> 4) != 0
+        || 2 + (size_t)(payload[0] & 0x0F) > length)
+    {
+        fprintf(stderr, "Unexpected frame from the Client.\r\n");
+        return -1;
+    }
+
+    messageP->tokenLength = payload[0] & 0x0F;
+    messageP->code = payload[1];
+    messageP->token = payload + 2;
+    messageP->payload = NULL;
+    messageP->payloadLength = 0;
+
+    // Skip the options, their lengths are below 269 bytes
+    pos = 2 + messageP->tokenLength;
+    while (pos < length
+           && payload[pos] != 0xFF)
+    {
+        size_t optionLength;
+        size_t headerLength;
+
+        headerLength = 1;
+        if ((payload[pos] >> 4) >= 13)
+        {
+            headerLength += (payload[pos] >> 4) - 12;
+        }
+        optionLength = payload[pos] & 0x0F;
+        if (optionLength == 13)
+        {
+            optionLength = 13 + (size_t)payload[pos + headerLength];
+            headerLength++;
+        }
+        pos += headerLength + optionLength;
+    }
+    if (pos < length)
+    {
+        messageP->payload = payload + pos + 1;
+        messageP->payloadLength = length - pos - 1;
+    }
+
+    return 0;
+}
+
+static int prv_handleClientRequest(prv_server_t *serverP,
+                                   const prv_message_t *messageP)
+{
+    // Location-Path: "rd", "0"
+    static const uint8_t location[] = { 0x82, 'r', 'd', 0x01, '0' };
+
+    switch (messageP->code)
+    {
+    case PRV_COAP_CODE_POST:
+        return prv_sendMessage(serverP, PRV_COAP_CODE_201, messageP->token, messageP->tokenLength, location, sizeof(location), 1);
+
+    case PRV_COAP_CODE_DELETE:
+        return prv_sendMessage(serverP, PRV_COAP_CODE_202, messageP->token, messageP->tokenLength, NULL, 0, 1);
+
+    default:
+        return prv_sendMessage(serverP, PRV_COAP_CODE_404, messageP->token, messageP->tokenLength, NULL, 0, 1);
+    }
+}
+
+static int prv_exchangeCsm(prv_server_t *serverP)
+{
+    // Max-Message-Size: 1152
+    static const uint8_t options[] = { 0x22, 0x04, 0x80 };
+    prv_message_t message;
+
+    if (prv_receiveMessage(serverP, &message) != 0
+        || message.code != PRV_COAP_CODE_CSM)
+    {
+        fprintf(stderr, "No CSM received from the Client.\r\n");
+        return -1;
+    }
+
+    // The writes cut the frame header and the message, the Client reassembles them from several reads
+    return prv_sendMessage(serverP, PRV_COAP_CODE_CSM, NULL, 0, options, sizeof(options), PRV_SPLIT_COUNT);
+}
+
+static int prv_read(prv_server_t *serverP)
+{
+    // Uri-Path: "3", "0", "0", Accept: text/plain
+    static const uint8_t options[] = { 0xB1, '3', 0x01, '0', 0x01, '0', 0x60 };
+    prv_message_t message;
+    uint8_t token[PRV_TOKEN_LENGTH];
+    int64_t startTime;
+    uint32_t i;
+
+    startTime = bench_now();
+    for (i = 0; i < serverP->readTarget; i++)
+    {
+        token[0] = (uint8_t)(serverP->nextToken >> 8);
+        token[1] = (uint8_t)serverP->nextToken;
+        serverP->nextToken++;
+
+        if (prv_sendMessage(serverP, PRV_COAP_CODE_GET, token, PRV_TOKEN_LENGTH, options, sizeof(options), 1) != 0)
+        {
+            return -1;
+        }
+
+        do
+        {
+            if (prv_receiveMessage(serverP, &message) != 0)
+            {
+                return -1;
+            }
+            if ((message.code >> 5) == 0
+                && message.code != 0
+                && prv_handleClientRequest(serverP, &message) != 0)
+            {
+                return -1;
+            }
+        } while (message.tokenLength != PRV_TOKEN_LENGTH
+                 || memcmp(message.token, token, PRV_TOKEN_LENGTH) != 0);
+
+        if (message.code != PRV_COAP_CODE_205
+            || message.payloadLength != strlen(MANUFACTURER)
+            || memcmp(message.payload, MANUFACTURER, message.payloadLength) != 0)
+        {
+            fprintf(stderr, "Read failed (%u.%02u).\r\n", message.code >> 5, message.code & 0x1F);
+            return -1;
+        }
+        serverP->readCount++;
+    }
+    serverP->readDuration = (double)(bench_now() - startTime) / 1000000.0;
+
+    return 0;
+}
+
+// Send a Close frame and wait for the Client to echo it and to close the connection.
+static int prv_close(prv_server_t *serverP)
+{
+    uint8_t opcode;
+    uint8_t *payload;
+    size_t length;
+
+    serverP->sendBuffer[4] = (uint8_t)(PRV_WS_CLOSE_NORMAL >> 8);
+    serverP->sendBuffer[5] = (uint8_t)(PRV_WS_CLOSE_NORMAL & 0xFF);
+    if (prv_sendFrame(serverP, PRV_WS_OPCODE_CLOSE, 2, 1) != 0)
+    {
+        return -1;
+    }
+
+    do
+    {
+        if (prv_receiveFrame(serverP, &opcode, &payload, &length) != 0)
+        {
+            fprintf(stderr, "No Close frame received from the Client.\r\n");
+            return -1;
+        }
+    } while (opcode != PRV_WS_OPCODE_CLOSE);
+    if (length >= 2)
+    {
+        serverP->closeStatus = (uint16_t)((payload[0] << 8) | payload[1]);
+    }
+
+    // The Client closes the TCP connection once the Close frames are exchanged
+    serverP->receiveLength = 0;
+    serverP->frameLength = 0;
+    if (prv_receive(serverP) != 0)
+    {
+        fprintf(stderr, "The Client did not close the connection.\r\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static void *prv_serverThread(void *arg)
+{
+    prv_server_t *serverP;
+    prv_message_t message;
+    struct pollfd pfd;
+    int flag;
+    int result;
+
+    serverP = (prv_server_t *)arg;
+
+    do
+    {
+        if (__atomic_load_n(&serverP->stop, __ATOMIC_ACQUIRE) != 0)
+        {
+            return NULL;
+        }
+        pfd.fd = serverP->listenSock;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+    } while (poll(&pfd, 1, PRV_POLL_TIMEOUT) <= 0);
+
+    serverP->sock = accept(serverP->listenSock, NULL, NULL);
+    if (serverP->sock == -1)
+    {
+        __atomic_store_n(&serverP->done, -1, __ATOMIC_RELEASE);
+        return NULL;
+    }
+    flag = 1;
+    (void)setsockopt(serverP->sock, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+    result = prv_handshake(serverP);
+
+    if (serverP->badAccept == true)
+    {
+        // The Client must close the connection without sending any frame
+        if (result == 0)
+        {
+            serverP->receiveLength = 0;
+            serverP->frameLength = 0;
+            if (prv_receive(serverP) != 0)
+            {
+                fprintf(stderr, "The Client accepted a wrong Sec-WebSocket-Accept.\r\n");
+                result = -1;
+            }
+        }
+        __atomic_store_n(&serverP->done, result == 0 ? 1 : -1, __ATOMIC_RELEASE);
+        close(serverP->sock);
+        return NULL;
+    }
+
+    if (result == 0)
+    {
+        result = prv_exchangeCsm(serverP);
+    }
+
+    // Wait for the registration
+    while (result == 0)
+    {
+        result = prv_receiveMessage(serverP, &message);
+        if (result == 0
+            && (message.code >> 5) == 0
+            && message.code != 0)
+        {
+            result = prv_handleClientRequest(serverP, &message);
+            if (message.code == PRV_COAP_CODE_POST)
+            {
+                break;
+            }
+        }
+    }
+
+    if (result == 0)
+    {
+        result = prv_read(serverP);
+    }
+    if (result == 0)
+    {
+        result = prv_close(serverP);
+    }
+    __atomic_store_n(&serverP->done, result == 0 ? 1 : -1, __ATOMIC_RELEASE);
+
+    close(serverP->sock);
+
+    return NULL;
+}
+
+static int prv_serverOpen(prv_server_t *serverP)
+{
+    struct sockaddr_in addr;
+    socklen_t addrLen;
+    int flag;
+
+    serverP->listenSock = socket(AF_INET, SOCK_STREAM, 0);
+    if (serverP->listenSock == -1)
+    {
+        return -1;
+    }
+    flag = 1;
+    (void)setsockopt(serverP->listenSock, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    addrLen = sizeof(addr);
+    if (bind(serverP->listenSock, (struct sockaddr *)&addr, sizeof(addr)) == -1
+        || listen(serverP->listenSock, 1) == -1
+        || getsockname(serverP->listenSock, (struct sockaddr *)&addr, &addrLen) == -1
+        || pthread_create(&serverP->thread, NULL, prv_serverThread, serverP) != 0)
+    {
+        close(serverP->listenSock);
+        return -1;
+    }
+
+    serverP->port = ntohs(addr.sin_port);
+    serverP->nextToken = 1;
+
+    return 0;
+}
+
+static void prv_serverClose(prv_server_t *serverP)
+{
+    __atomic_store_n(&serverP->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(serverP->thread, NULL);
+
+    close(serverP->listenSock);
+}
+
+/*************************************************************************************
+** LwM2M Client
+*************************************************************************************/
+
+// This function returns a random vector of the specified size.
+// It draws the opening handshake nonce and the masking keys.
+int iowa_system_random_vector_generator(uint8_t *randomBuffer,
+                                        size_t size,
+                                        void *userData)
+{
+    size_t i;
+
+    (void)userData;
+
+    // Not a proper random source, the stand-in Server only checks that the frames are masked
+    for (i = 0; i < size; i++)
+    {
+        randomBuffer[i] = (uint8_t)(rand() % 256);
+    }
+
+    return 0;
+}
+
+static int prv_run(prv_server_t *serverP)
+{
+    iowa_context_t iowaH;
+    iowa_device_info_t devInfo;
+    char serverUri[64];
+    int64_t startTime;
+    iowa_status_t result;
+
+    if (prv_serverOpen(serverP) != 0)
+    {
+        fprintf(stderr, "Stand-in server creation failed.\r\n");
+        return -1;
+    }
+    snprintf(serverUri, sizeof(serverUri), "coap+ws://127.0.0.1:%u", serverP->port);
+
+    iowaH = iowa_init(NULL);
+    if (iowaH == NULL)
+    {
+        fprintf(stderr, "IOWA context initialization failed.\r\n");
+        prv_serverClose(serverP);
+        return -1;
+    }
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    devInfo.manufacturer = MANUFACTURER;
+    result = iowa_client_configure(iowaH, "websocket", &devInfo, NULL);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = iowa_client_add_server(iowaH, SERVER_SHORT_ID, serverUri, SERVER_LIFETIME, 0, IOWA_SEC_NONE);
+    }
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "IOWA Client configuration failed (%u.%02u).\r\n", (result & 0xFF) >> 5, (result & 0x1F));
+        iowa_close(iowaH);
+        prv_serverClose(serverP);
+        return -1;
+    }
+
+    startTime = bench_now();
+    while (__atomic_load_n(&serverP->done, __ATOMIC_ACQUIRE) == 0
+           && bench_now() - startTime < (int64_t)MAX_RUN_TIME * 1000000)
+    {
+        (void)iowa_step(iowaH, 1);
+    }
+
+    iowa_close(iowaH);
+
+    prv_serverClose(serverP);
+
+    return serverP->done == 1 ? 0 : -1;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    prv_server_t server;
+    long readCount;
+    int result;
+
+    readCount = DEFAULT_READ_COUNT;
+    if (argc > 1)
+    {
+        readCount = atol(argv[1]);
+    }
+    if (readCount <= 0)
+    {
+        fprintf(stderr, "Usage: %s [read count]\r\n", argv[0]);
+        return 1;
+    }
+
+    result = 0;
+
+    memset(&server, 0, sizeof(server));
+    server.badAccept = true;
+    if (prv_run(&server) != 0)
+    {
+        printf("Wrong Accept:   failed\r\n");
+        result = 1;
+    }
+    else
+    {
+        printf("Wrong Accept:   connection closed by the Client\r\n");
+    }
+
+    memset(&server, 0, sizeof(server));
+    server.readTarget = (uint32_t)readCount;
+    if (prv_run(&server) != 0)
+    {
+        printf("Right Accept:   failed after %u Client frames\r\n", server.frameCount);
+        result = 1;
+    }
+    else
+    {
+        printf("Right Accept:   CSM of the Server in %d writes\r\n", PRV_SPLIT_COUNT);
+        printf("Client frames:  %u, all masked\r\n", server.frameCount);
+        printf("Reads:          %u in %.3f s (%.0f /s)\r\n", server.readCount, server.readDuration, (double)server.readCount / server.readDuration);
+        printf("Close:          echoed with status %u\r\n", server.closeStatus);
+        if (server.closeStatus != PRV_WS_CLOSE_NORMAL)
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}